@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2020, Arm Limited and affiliates
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include <algorithm>
+#include <vector>
+#include "nsapi_types.h"
+
+/* Stream socket that delivers queued data in fragments of a fixed size.
+ * Every fragment arrives latency_ms after the recv on clock_ms, a recv that cannot get
+ * data within the socket timeout waits for it before returning NSAPI_ERROR_WOULD_BLOCK.
+ */
+class Socket_mock {
+public:
+    Socket_mock(int fragment = 1, int latency = 0) :
+        fragment_size(fragment), latency_ms(latency), timeout(-1),
+        recv_calls(0), set_timeout_calls(0), closed(false)
+    {
+        clock_ms = 0;
+    }
+
+    void queue(const unsigned char *data, int len)
+    {
+        pending.insert(pending.end(), data, data + len);
+    }
+
+    void set_timeout(int timeout_ms)
+    {
+        timeout = timeout_ms;
+        set_timeout_calls++;
+    }
+
+    nsapi_size_or_error_t recv(void *data, nsapi_size_t size)
+    {
+        recv_calls++;
+        if (pending.empty()) {
+            if (closed) {
+                return 0;
+            }
+            clock_ms += timeout < 0 ? 0 : timeout;
+            return NSAPI_ERROR_WOULD_BLOCK;
+        }
+        if (timeout >= 0 && timeout < latency_ms) {
+            clock_ms += timeout;
+            return NSAPI_ERROR_WOULD_BLOCK;
+        }
+        clock_ms += latency_ms;
+        int len = std::min((int)size, std::min(fragment_size, (int)pending.size()));
+        memcpy(data, &pending[0], len);
+        pending.erase(pending.begin(), pending.begin() + len);
+        return len;
+    }
+
+    nsapi_size_or_error_t send(const void *data, nsapi_size_t size)
+    {
+        return size;
+    }
+
+    static unsigned long clock_ms;
+
+    std::vector<unsigned char> pending;
+    int fragment_size;
+    int latency_ms;
+    int timeout;
+    int recv_calls;
+    int set_timeout_calls;
+    bool closed;
+};
+
+unsigned long Socket_mock::clock_ms;
+
+/* Countdown running on the simulated clock of Socket_mock */
+class Countdown_mock {
+public:
+    Countdown_mock() : interval_end_ms(0)
+    {
+    }
+
+    Countdown_mock(int ms)
+    {
+        countdown_ms(ms);
+    }
+
+    bool expired()
+    {
+        return left_ms() <= 0;
+    }
+
+    void countdown_ms(int ms)
+    {
+        interval_end_ms = Socket_mock::clock_ms + ms;
+    }
+
+    void countdown(int seconds)
+    {
+        countdown_ms(seconds * 1000);
+    }
+
+    int left_ms()
+    {
+        return (int)(interval_end_ms - Socket_mock::clock_ms);
+    }
+
+private:
+    unsigned long interval_end_ms;
+};
@@ -0,0 +1,270 @@
+/*
+ * Copyright (c) 2020, Arm Limited and affiliates
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <vector>
+#include "../../mocks/Socket_mock.h"
+#include "gtest/gtest.h"
+#include "MQTTClient.h"
+
+static const int PACKET_SIZE = 200;
+static const int BOOT_FILTERS = 40;
+static const int ROUND_TRIP_MS = 300;
+
+/* Network that answers subscribe and unsubscribe packets like a broker behind a slow link.
+ * A read with nothing to receive waits out its timeout on the mock clock.
+ */
+class BrokerNetwork {
+public:
+    BrokerNetwork() : round_trips(0), elapsed_ms(0)
+    {
+    }
+
+    int read(unsigned char *buffer, int len, int timeout_ms)
+    {
+        if ((int)incoming.size() < len) {
+            Socket_mock::clock_ms += timeout_ms;
+            return 0;
+        }
+        memcpy(buffer, &incoming[0], len);
+        incoming.erase(incoming.begin(), incoming.begin() + len);
+        return len;
+    }
+
+    int write(unsigned char *buffer, int len, int timeout)
+    {
+        MQTTHeader header = {0};
+        header.byte = buffer[0];
+        if (header.bits.type == SUBSCRIBE) {
+            answer_subscribe(buffer, len);
+        } else if (header.bits.type == UNSUBSCRIBE) {
+            answer_unsubscribe(buffer, len);
+        }
+        return len;
+    }
+
+    int disconnect()
+    {
+        return 0;
+    }
+
+    void queue(const unsigned char *data, int len)
+    {
+        incoming.insert(incoming.end(), data, data + len);
+    }
+
+    int round_trips;
+    int elapsed_ms;
+    std::vector<std::string> subscribed;
+    std::vector<unsigned char> incoming;
+
+private:
+    void answer_subscribe(unsigned char *buffer, int len)
+    {
+        unsigned char dup;
+        unsigned short packetid;
+        int count = 0;
+        MQTTString filters[MQTTCLIENT_MAX_FILTERS_PER_PACKET];
+        int qos[MQTTCLIENT_MAX_FILTERS_PER_PACKET];
+        unsigned char suback[PACKET_SIZE];
+
+        ASSERT_EQ(1, MQTTDeserialize_subscribe(&dup, &packetid, MQTTCLIENT_MAX_FILTERS_PER_PACKET, &count, filters, qos, buffer, len));
+        for (int i = 0; i < count; ++i) {
+            std::string filter(filters[i].lenstring.data, filters[i].lenstring.len);
+            if (filter.find("denied") != std::string::npos) {
+                qos[i] = 0x80;
+            } else {
+                subscribed.push_back(filter);
+            }
+        }
+        queue(suback, MQTTSerialize_suback(suback, sizeof(suback), packetid, count, qos));
+        round_trip();
+    }
+
+    void answer_unsubscribe(unsigned char *buffer, int len)
+    {
+        unsigned char dup;
+        unsigned short packetid;
+        int count = 0;
+        MQTTString filters[MQTTCLIENT_MAX_FILTERS_PER_PACKET];
+
+        ASSERT_EQ(1, MQTTDeserialize_unsubscribe(&dup, &packetid, MQTTCLIENT_MAX_FILTERS_PER_PACKET, &count, filters, buffer, len));
+        const unsigned char unsuback[] = {0xB0, 0x02, (unsigned char)(packetid >> 8), (unsigned char)packetid};
+        queue(unsuback, sizeof(unsuback));
+        round_trip();
+    }
+
+    void round_trip()
+    {
+        round_trips++;
+        elapsed_ms += ROUND_TRIP_MS;
+    }
+};
+
+typedef MQTT::Client<BrokerNetwork, Countdown_mock, PACKET_SIZE, BOOT_FILTERS> BatchClient;
+
+static const unsigned char connack[] = {0x20, 0x02, 0x00, 0x00};
+static int received;
+
+static void on_message(MQTT::MessageData &md)
+{
+    received++;
+}
+
+class TestMQTTClientBatchSubscribe : public testing::Test {
+protected:
+    BrokerNetwork net;
+    BatchClient *client;
+    char names[BOOT_FILTERS][32];
+    const char *filters[BOOT_FILTERS];
+    enum MQTT::QoS qos[BOOT_FILTERS];
+    BatchClient::messageHandler handlers[BOOT_FILTERS];
+    int granted[BOOT_FILTERS];
+
+    virtual void SetUp()
+    {
+        received = 0;
+        client = new BatchClient(net);
+        for (int i = 0; i < BOOT_FILTERS; ++i) {
+            snprintf(names[i], sizeof(names[i]), "devices/0001/config/%02d", i);
+            filters[i] = names[i];
+            qos[i] = MQTT::QOS1;
+            handlers[i] = on_message;
+            granted[i] = -1;
+        }
+        net.queue(connack, sizeof(connack));
+        ASSERT_EQ(0, client->connect());
+    }
+
+    virtual void TearDown()
+    {
+        delete client;
+    }
+
+    void deliver(const char *topic)
+    {
+        unsigned char publish[PACKET_SIZE];
+        int topiclen = strlen(topic);
+        publish[0] = 0x30;
+        publish[1] = 2 + topiclen;
+        publish[2] = 0;
+        publish[3] = topiclen;
+        memcpy(&publish[4], topic, topiclen);
+        net.queue(publish, 4 + topiclen);
+        client->yield(1);
+    }
+};
+
+TEST_F(TestMQTTClientBatchSubscribe, boot_subscribe_latency)
+{
+    BrokerNetwork single_net;
+    BatchClient single(single_net);
+    single_net.queue(connack, sizeof(connack));
+    ASSERT_EQ(0, single.connect());
+    for (int i = 0; i < BOOT_FILTERS; ++i) {
+        ASSERT_EQ(MQTT::SUCCESS, single.subscribe(filters[i], qos[i], handlers[i]));
+    }
+
+    EXPECT_EQ(MQTT::SUCCESS, client->subscribe(BOOT_FILTERS, filters, qos, handlers, granted));
+
+    printf("boot subscribe of %d filters at %d ms round trip: one by one %d ms, batched %d ms in %d packets\n",
+           BOOT_FILTERS, ROUND_TRIP_MS, single_net.elapsed_ms, net.elapsed_ms, net.round_trips);
+    EXPECT_EQ(BOOT_FILTERS, single_net.round_trips);
+    // 25 bytes per filter, 7 of them fit in a 200 byte packet
+    EXPECT_EQ(6, net.round_trips);
+    EXPECT_EQ(single_net.subscribed, net.subscribed);
+    for (int i = 0; i < BOOT_FILTERS; ++i) {
+        EXPECT_EQ(MQTT::QOS1, granted[i]);
+    }
+}
+
+TEST_F(TestMQTTClientBatchSubscribe, granted_qos_per_filter)
+{
+    filters[3] = "devices/0001/denied";
+
+    EXPECT_EQ(MQTT::SUCCESS, client->subscribe(8, filters, qos, handlers, granted));
+    EXPECT_EQ(0x80, granted[3]);
+    EXPECT_EQ(MQTT::QOS1, granted[4]);
+    EXPECT_EQ(-1, granted[8]);
+
+    deliver(names[4]);
+    EXPECT_EQ(1, received);
+    deliver("devices/0001/denied");
+    EXPECT_EQ(1, received);
+}
+
+TEST_F(TestMQTTClientBatchSubscribe, not_enough_handlers)
+{
+    const char *more[] = {"other/topic"};
+    enum MQTT::QoS more_qos[] = {MQTT::QOS0};
+    BatchClient::messageHandler more_handlers[] = {on_message};
+    int more_granted[1];
+
+    ASSERT_EQ(MQTT::SUCCESS, client->subscribe(BOOT_FILTERS, filters, qos, handlers, granted));
+    int round_trips = net.round_trips;
+
+    EXPECT_EQ(MQTT::BUFFER_OVERFLOW, client->subscribe(1, more, more_qos, more_handlers, more_granted));
+    EXPECT_EQ(round_trips, net.round_trips);
+    EXPECT_TRUE(client->isConnected());
+
+    // resubscribing to registered topic filters needs no new handlers
+    EXPECT_EQ(MQTT::SUCCESS, client->subscribe(2, filters, qos, handlers, granted));
+}
+
+TEST_F(TestMQTTClientBatchSubscribe, resubscribe_with_one_free_handler)
+{
+    ASSERT_EQ(MQTT::SUCCESS, client->subscribe(BOOT_FILTERS - 1, filters, qos, handlers, granted));
+
+    // all registered filters again, plus the last one twice: only one new handler is needed
+    const char *again[BOOT_FILTERS + 1];
+    enum MQTT::QoS again_qos[BOOT_FILTERS + 1];
+    BatchClient::messageHandler again_handlers[BOOT_FILTERS + 1];
+    int again_granted[BOOT_FILTERS + 1];
+    for (int i = 0; i < BOOT_FILTERS; ++i) {
+        again[i] = filters[i];
+        again_qos[i] = qos[i];
+        again_handlers[i] = handlers[i];
+    }
+    again[BOOT_FILTERS] = filters[BOOT_FILTERS - 1];
+    again_qos[BOOT_FILTERS] = MQTT::QOS1;
+    again_handlers[BOOT_FILTERS] = on_message;
+
+    EXPECT_EQ(MQTT::SUCCESS, client->subscribe(BOOT_FILTERS + 1, again, again_qos, again_handlers, again_granted));
+    deliver(names[BOOT_FILTERS - 1]);
+    EXPECT_EQ(1, received);
+}
+
+TEST_F(TestMQTTClientBatchSubscribe, filter_larger_than_packet)
+{
+    std::string topic(PACKET_SIZE, 'a');
+    filters[1] = topic.c_str();
+
+    EXPECT_EQ(MQTT::FAILURE, client->subscribe(2, filters, qos, handlers, granted));
+    EXPECT_FALSE(client->isConnected());
+}
+
+TEST_F(TestMQTTClientBatchSubscribe, batched_unsubscribe)
+{
+    ASSERT_EQ(MQTT::SUCCESS, client->subscribe(BOOT_FILTERS, filters, qos, handlers, granted));
+    int round_trips = net.round_trips;
+
+    EXPECT_EQ(MQTT::SUCCESS, client->unsubscribe(BOOT_FILTERS, filters));
+    EXPECT_LT(net.round_trips - round_trips, round_trips);
+
+    deliver(names[0]);
+    EXPECT_EQ(0, received);
+}
@@ -0,0 +1,25 @@
+
+####################
+# UNIT TESTS
+####################
+
+set(unittest-includes ${unittest-includes}
+  target_h
+)
+
+set(unittest-sources
+  ../paho_mqtt_embedded_c/MQTTClient/src/MQTTClient.h
+  ../paho_mqtt_embedded_c/MQTTPacket/src/MQTTDeserializePublish.c
+  ../paho_mqtt_embedded_c/MQTTPacket/src/MQTTPacket.c
+  ../paho_mqtt_embedded_c/MQTTPacket/src/MQTTSubscribeClient.c
+  ../paho_mqtt_embedded_c/MQTTPacket/src/MQTTSubscribeServer.c
+  ../paho_mqtt_embedded_c/MQTTPacket/src/MQTTUnsubscribeClient.c
+  ../paho_mqtt_embedded_c/MQTTPacket/src/MQTTUnsubscribeServer.c
+)
+
+set(unittest-test-sources
+  paho_mqtt_embedded_c/MQTTClientBatchSubscribe/test_MQTTClientBatchSubscribe.cpp
+  mocks/Socket_mock.h
+  stubs/MQTTConnectClient_stub.cpp
+  stubs/MQTTSerializePublish_stub.cpp
+)
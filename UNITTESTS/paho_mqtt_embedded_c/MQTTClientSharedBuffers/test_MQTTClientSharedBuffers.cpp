@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2020, Arm Limited and affiliates
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <vector>
+
+static std::vector<size_t> allocations;
+static int outstanding_allocations;
+
+static void *test_malloc(size_t size)
+{
+    allocations.push_back(size);
+    outstanding_allocations++;
+    return malloc(size);
+}
+
+static void test_free(void *ptr)
+{
+    if (ptr != NULL) {
+        outstanding_allocations--;
+    }
+    free(ptr);
+}
+
+#define MQTTCLIENT_SHARED_BUFFERS 1
+#define MQTTCLIENT_MALLOC test_malloc
+#define MQTTCLIENT_FREE test_free
+
+#include "../stubs/Countdown_stub.h"
+#include "gtest/gtest.h"
+#include "MQTTClient.h"
+
+static const int PACKET_SIZE = 512;
+
+/* Network that replays queued incoming bytes and records every write */
+class ScriptedNetwork {
+public:
+    int connect(const char *hostname, int port)
+    {
+        return 0;
+    }
+
+    int read(unsigned char *buffer, int len, int timeout_ms)
+    {
+        if ((int)incoming.size() < len) {
+            incoming.clear();
+            return -1;
+        }
+        memcpy(buffer, &incoming[0], len);
+        incoming.erase(incoming.begin(), incoming.begin() + len);
+        return len;
+    }
+
+    int write(unsigned char *buffer, int len, int timeout)
+    {
+        writes.push_back(std::vector<unsigned char>(buffer, buffer + len));
+        return len;
+    }
+
+    int disconnect()
+    {
+        return 0;
+    }
+
+    void queue(const unsigned char *data, int len)
+    {
+        incoming.insert(incoming.end(), data, data + len);
+    }
+
+    std::vector<unsigned char> incoming;
+    std::vector<std::vector<unsigned char> > writes;
+};
+
+typedef MQTT::Client<ScriptedNetwork, Countdown_stub, PACKET_SIZE> SharedClient;
+
+static const unsigned char connack[] = {0x20, 0x02, 0x00, 0x00};
+static const unsigned char puback[] = {0x40, 0x02, 0x00, 0x01};
+
+class TestMQTTClientSharedBuffers : public testing::Test {
+protected:
+    unsigned char sendbuf[PACKET_SIZE];
+    unsigned char readbuf[PACKET_SIZE];
+
+    virtual void SetUp()
+    {
+        allocations.clear();
+        outstanding_allocations = 0;
+    }
+
+    int connect(SharedClient &client, ScriptedNetwork &net)
+    {
+        MQTTPacket_connectData options = MQTTPacket_connectData_initializer;
+        options.cleansession = 0;
+        net.queue(connack, sizeof(connack));
+        return client.connect(options);
+    }
+};
+
+TEST_F(TestMQTTClientSharedBuffers, buffers_not_embedded)
+{
+    EXPECT_LT(sizeof(SharedClient), (size_t)PACKET_SIZE);
+}
+
+TEST_F(TestMQTTClientSharedBuffers, resend_copy_sized_to_packet)
+{
+    ScriptedNetwork net1, net2;
+    SharedClient client1(net1, sendbuf, readbuf);
+    SharedClient client2(net2, sendbuf, readbuf);
+    unsigned char payload[10] = {0};
+
+    ASSERT_EQ(0, connect(client1, net1));
+    memset(sendbuf, 0xAA, sizeof(sendbuf));
+
+    // The connection breaks before the PUBACK arrives, the publish stays inflight
+    net1.queue(puback, 2);
+    EXPECT_EQ(MQTT::FAILURE, client1.publish("a/b", payload, sizeof(payload), MQTT::QOS1));
+    ASSERT_EQ(1u, allocations.size());
+    EXPECT_EQ(sizeof(payload), allocations[0]);
+    EXPECT_EQ(1, outstanding_allocations);
+
+    // The other client overwrites the shared buffers in the meantime
+    ASSERT_EQ(0, connect(client2, net2));
+    memset(sendbuf, 0x55, sizeof(sendbuf));
+    EXPECT_EQ(MQTT::SUCCESS, client2.publish("c/d", payload, sizeof(payload), MQTT::QOS0));
+
+    // Reconnecting resends exactly the stored packet and frees it on PUBACK
+    net1.writes.clear();
+    net1.queue(connack, sizeof(connack));
+    net1.queue(puback, sizeof(puback));
+    MQTTPacket_connectData options = MQTTPacket_connectData_initializer;
+    options.cleansession = 0;
+    EXPECT_EQ(0, client1.connect(options));
+    ASSERT_EQ(2u, net1.writes.size());
+    EXPECT_EQ(std::vector<unsigned char>(sizeof(payload), 0xAA), net1.writes[1]);
+    EXPECT_EQ(0, outstanding_allocations);
+}
+
+TEST_F(TestMQTTClientSharedBuffers, clean_session_keeps_no_copy)
+{
+    ScriptedNetwork net;
+    SharedClient client(net, sendbuf, readbuf);
+    MQTTPacket_connectData options = MQTTPacket_connectData_initializer;
+    unsigned char payload[10] = {0};
+
+    net.queue(connack, sizeof(connack));
+    ASSERT_EQ(0, client.connect(options));
+    net.queue(puback, sizeof(puback));
+    EXPECT_EQ(MQTT::SUCCESS, client.publish("a/b", payload, sizeof(payload), MQTT::QOS1));
+    EXPECT_TRUE(allocations.empty());
+}
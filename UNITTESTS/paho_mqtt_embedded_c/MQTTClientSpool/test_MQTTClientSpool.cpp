@@ -0,0 +1,320 @@
+/*
+ * Copyright (c) 2026, agent
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <set>
+#include <vector>
+#include "../../mocks/Socket_mock.h"
+#include "gtest/gtest.h"
+
+#define MQTTCLIENT_SPOOL 1
+#define MQTTCLIENT_QOS2 1
+#include "MQTTClient.h"
+
+static const int PACKET_SIZE = 100;
+static const char *TOPIC = "spool/test";
+
+/* Network to a broker which acknowledges QoS 1 and QoS 2 publishes and records their payloads,
+ * a QoS 2 one only once per packet id until it is released.  The link can go down, failing writes,
+ * or lose the acknowledgement of the next publish or PUBREL.
+ */
+class LinkNetwork {
+public:
+    LinkNetwork() : up(false), connecting(false), lose_ack(false), lose_pubcomp(false), writes(0)
+    {
+    }
+
+    int read(unsigned char *buffer, int len, int timeout_ms)
+    {
+        if ((int)incoming.size() < len) {
+            Socket_mock::clock_ms += timeout_ms;
+            return 0;
+        }
+        memcpy(buffer, &incoming[0], len);
+        incoming.erase(incoming.begin(), incoming.begin() + len);
+        return len;
+    }
+
+    int write(unsigned char *buffer, int len, int timeout)
+    {
+        if (!up) {
+            return -1;
+        }
+        writes++;
+        if (connecting) { // the connect stub does not serialize a packet
+            connecting = false;
+            const unsigned char connack[] = {0x20, 0x02, 0x00, 0x00};
+            incoming.insert(incoming.end(), connack, connack + sizeof(connack));
+            return len;
+        }
+        if (len == 4 && buffer[0] == 0x62) { // PUBREL
+            unsigned short id = (buffer[2] << 8) + buffer[3];
+            received_qos2.erase(id);
+            if (lose_pubcomp) {
+                lose_pubcomp = false;
+                up = false;
+            } else {
+                const unsigned char pubcomp[] = {0x70, 0x02, buffer[2], buffer[3]};
+                incoming.insert(incoming.end(), pubcomp, pubcomp + sizeof(pubcomp));
+            }
+            return len;
+        }
+        unsigned char dup, retained;
+        unsigned short id;
+        int qos, payloadlen;
+        MQTTString topic;
+        unsigned char *payload;
+        if (MQTTDeserialize_publish(&dup, &qos, &retained, &id, &topic, &payload, &payloadlen, buffer, len) == 1) {
+            if (qos != 2 || received_qos2.insert(id).second) {
+                delivered.push_back(atoi(std::string((char *)payload, payloadlen).c_str()));
+            }
+            if (lose_ack) {
+                lose_ack = false;
+                up = false;
+            } else if (qos != 0) {
+                const unsigned char ack[] = {(unsigned char)(qos == 1 ? 0x40 : 0x50), 0x02,
+                                             (unsigned char)(id >> 8), (unsigned char)id
+                                            };
+                incoming.insert(incoming.end(), ack, ack + sizeof(ack));
+            }
+        }
+        return len;
+    }
+
+    int disconnect()
+    {
+        return 0;
+    }
+
+    void reconnect()
+    {
+        up = connecting = true;
+        incoming.clear();
+    }
+
+    bool up;
+    bool connecting;
+    bool lose_ack;
+    bool lose_pubcomp;
+    int writes;
+    std::set<unsigned short> received_qos2;
+    std::vector<int> delivered;
+    std::vector<unsigned char> incoming;
+};
+
+typedef MQTT::Client<LinkNetwork, Countdown_mock, PACKET_SIZE, 1> SpoolClient;
+
+class TestMQTTClientSpool : public testing::Test {
+protected:
+    LinkNetwork net;
+
+    int publish(SpoolClient &client, int sequence, enum MQTT::QoS qos = MQTT::QOS1)
+    {
+        char payload[8];
+        int len = snprintf(payload, sizeof(payload), "%05d", sequence);
+        return client.publish(TOPIC, payload, len, qos);
+    }
+
+    int connect(SpoolClient &client)
+    {
+        MQTTPacket_connectData options = MQTTPacket_connectData_initializer;
+        net.reconnect();
+        return client.connect(options);
+    }
+
+    // the delivered sequence, ignoring consecutive duplicates of messages whose acknowledgement was lost
+    void expect_in_order(int count)
+    {
+        std::vector<int> unique;
+        for (size_t i = 0; i < net.delivered.size(); ++i) {
+            if (unique.empty() || unique.back() != net.delivered[i]) {
+                unique.push_back(net.delivered[i]);
+            }
+        }
+        ASSERT_EQ(count, (int)unique.size());
+        for (int i = 0; i < count; ++i) {
+            ASSERT_EQ(i, unique[i]);
+        }
+    }
+};
+
+TEST_F(TestMQTTClientSpool, disconnects_during_high_rate_publishing)
+{
+    MQTT::SpoolRAMStorage<512> ram;
+    MQTT::SpoolRAMStorage<2048> flash;
+    MQTT::Spool spool(ram, &flash);
+    SpoolClient client(net);
+    client.setSpool(&spool);
+    ASSERT_EQ(MQTT::SUCCESS, connect(client));
+
+    const int MESSAGES = 2000;
+    int reconnects = 0;
+    for (int i = 0; i < MESSAGES; ++i) {
+        if (i % 100 == 30) {
+            net.lose_ack = true; // the broker gets the message, the client does not know
+        } else if (i % 100 == 60) {
+            net.up = false;
+        }
+        if (!client.isConnected() && (i % 100 == 45 || i % 100 == 99)) {
+            ASSERT_EQ(MQTT::SUCCESS, connect(client)) << "message " << i;
+            reconnects++;
+        }
+        int rc = publish(client, i, (i % 7 == 0) ? MQTT::QOS0 : MQTT::QOS1);
+        ASSERT_TRUE(rc == MQTT::SUCCESS || rc == MQTT::SPOOLED) << "message " << i << " rc " << rc;
+    }
+    if (!client.isConnected()) {
+        ASSERT_EQ(MQTT::SUCCESS, connect(client));
+    }
+    while (!spool.empty()) {
+        ASSERT_EQ(MQTT::SUCCESS, client.yield(1));
+    }
+
+    expect_in_order(MESSAGES);
+    EXPECT_GT((int)net.delivered.size(), MESSAGES);  // lost acknowledgements mean at least once
+    EXPECT_EQ(2 * MESSAGES / 100, reconnects);
+}
+
+TEST_F(TestMQTTClientSpool, full_spool_is_bounded)
+{
+    MQTT::SpoolRAMStorage<256> ram;
+    MQTT::SpoolRAMStorage<512> flash;
+    MQTT::Spool spool(ram, &flash);
+    SpoolClient client(net);
+    client.setSpool(&spool);
+
+    int accepted = 0;
+    while (publish(client, accepted) == MQTT::SPOOLED) {
+        accepted++;
+        ASSERT_LE(spool.ramUsed(), 256u);
+    }
+    // 23 byte records: 11 fit in RAM and 21 after the 16 byte header of the backing storage
+    EXPECT_EQ(32, accepted);
+    EXPECT_EQ(MQTT::BUFFER_OVERFLOW, publish(client, accepted));
+    EXPECT_EQ(0, net.writes);
+
+    ASSERT_EQ(MQTT::SUCCESS, connect(client));
+    while (!spool.empty()) {
+        ASSERT_EQ(MQTT::SUCCESS, client.yield(1));
+    }
+    expect_in_order(accepted);
+
+    EXPECT_EQ(MQTT::SUCCESS, publish(client, accepted));
+    expect_in_order(accepted + 1);
+}
+
+TEST_F(TestMQTTClientSpool, replay_is_bounded_by_burst)
+{
+    MQTT::SpoolRAMStorage<2048> ram;
+    MQTT::Spool spool(ram);
+    SpoolClient client(net);
+    client.setSpool(&spool);
+
+    for (int i = 0; i < MQTTCLIENT_SPOOL_BURST * 2 + 1; ++i) {
+        ASSERT_EQ(MQTT::SPOOLED, publish(client, i));
+    }
+    ASSERT_EQ(MQTT::SUCCESS, connect(client));
+    EXPECT_EQ(MQTTCLIENT_SPOOL_BURST, (int)net.delivered.size());
+    EXPECT_EQ(MQTT::SPOOLED, client.replaySpool());
+    EXPECT_EQ(MQTT::SUCCESS, client.replaySpool());
+    expect_in_order(MQTTCLIENT_SPOOL_BURST * 2 + 1);
+}
+
+TEST_F(TestMQTTClientSpool, backing_storage_survives_restart)
+{
+    MQTT::SpoolRAMStorage<512> flash;
+    {
+        MQTT::SpoolRAMStorage<256> ram;
+        MQTT::Spool spool(ram, &flash);
+        SpoolClient client(net);
+        client.setSpool(&spool);
+        for (int i = 0; i < 30; ++i) {
+            ASSERT_EQ(MQTT::SPOOLED, publish(client, i));
+        }
+        // the 11 newest are in RAM, lost with it
+    }
+
+    MQTT::SpoolRAMStorage<256> ram;
+    MQTT::Spool spool(ram, &flash);
+    EXPECT_EQ(19u, spool.count());
+    SpoolClient client(net);
+    client.setSpool(&spool);
+    ASSERT_EQ(MQTT::SUCCESS, connect(client));
+    EXPECT_EQ(MQTT::SUCCESS, client.replaySpool());
+    expect_in_order(19);
+}
+
+TEST_F(TestMQTTClientSpool, ring_wraps_around)
+{
+    MQTT::SpoolRAMStorage<100> ram;
+    MQTT::Spool spool(ram);
+    unsigned char record[60], out[60];
+    int pushed = 0, popped = 0;
+
+    for (int round = 0; round < 200; ++round) {
+        int len = 1 + (round * 13) % 40;
+        memset(record, pushed & 0xFF, len);
+        if (spool.push(record, len)) {
+            pushed++;
+        } else {
+            ASSERT_FALSE(spool.empty());
+        }
+        if (round % 3 != 0 || spool.count() > 2) {
+            int got = spool.peek(out, sizeof(out));
+            if (got > 0) {
+                for (int i = 0; i < got; ++i) {
+                    ASSERT_EQ(popped & 0xFF, out[i]);
+                }
+                spool.pop();
+                popped++;
+            }
+        }
+    }
+    EXPECT_GT(popped, 100);
+    EXPECT_EQ((unsigned)(pushed - popped), spool.count());
+}
+
+TEST_F(TestMQTTClientSpool, qos2_replay_delivers_once)
+{
+    MQTT::SpoolRAMStorage<256> ram;
+    MQTT::SpoolRAMStorage<512> flash;
+    MQTT::Spool spool(ram, &flash);
+    SpoolClient client(net);
+    client.setSpool(&spool);
+    ASSERT_EQ(MQTT::SUCCESS, connect(client));
+
+    const int MESSAGES = 200;
+    for (int i = 0; i < MESSAGES; ++i) {
+        if (i % 20 == 5) {
+            net.lose_ack = true;      // resent with the same packet id, the broker has it already
+        } else if (i % 20 == 15) {
+            net.lose_pubcomp = true;  // released already, only the PUBREL is resent
+        }
+        int rc = publish(client, i, MQTT::QOS2);
+        ASSERT_TRUE(rc == MQTT::SUCCESS || rc == MQTT::SPOOLED) << "message " << i << " rc " << rc;
+        if (!client.isConnected()) {
+            ASSERT_EQ(MQTT::SUCCESS, connect(client)) << "message " << i;
+        }
+    }
+    while (!spool.empty()) {
+        ASSERT_EQ(MQTT::SUCCESS, client.yield(1));
+    }
+
+    ASSERT_EQ(MESSAGES, (int)net.delivered.size());
+    expect_in_order(MESSAGES);
+    EXPECT_TRUE(net.received_qos2.empty());
+}
@@ -0,0 +1,21 @@
+####################
+# UNIT TESTS
+####################
+
+set(unittest-includes ${unittest-includes}
+  target_h
+)
+
+set(unittest-sources
+  ../paho_mqtt_embedded_c/MQTTClient/src/MQTTClient.h
+  ../paho_mqtt_embedded_c/MQTTClient/src/MQTTSpool.h
+  ../paho_mqtt_embedded_c/MQTTPacket/src/MQTTDeserializePublish.c
+  ../paho_mqtt_embedded_c/MQTTPacket/src/MQTTSerializePublish.c
+  ../paho_mqtt_embedded_c/MQTTPacket/src/MQTTPacket.c
+)
+
+set(unittest-test-sources
+  paho_mqtt_embedded_c/MQTTClientSpool/test_MQTTClientSpool.cpp
+  mocks/Socket_mock.h
+  stubs/MQTTConnectClient_stub.cpp
+)
@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2020, Arm Limited and affiliates
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../../mocks/Socket_mock.h"
+#include "gtest/gtest.h"
+#include "MQTTNetworkUtil.h"
+
+static const unsigned char publish_packet[] = {
+    0x30, // Packet type (PUBLISH) + flags
+    0x07, // Remaining length byte
+    0x00, 0x03, 'a', '/', 'b', // Topic
+    'h', 'i' // Payload
+};
+
+class TestMQTTNetworkUtil : public testing::Test {
+protected:
+    MQTTReadBuffer<16> rx;
+
+    /* Reads a packet the way MQTT::Client::readPacket does: header byte, remaining length, body */
+    template<typename SocketType>
+    int read_packet(SocketType socket, unsigned char *packet, int timeout)
+    {
+        int rc = buffered_mqtt_read<Countdown_mock>(socket, rx, packet, 1, timeout);
+        if (rc != 1) {
+            return rc;
+        }
+        rc = buffered_mqtt_read<Countdown_mock>(socket, rx, packet + 1, 1, timeout);
+        if (rc != 1) {
+            return rc;
+        }
+        rc = buffered_mqtt_read<Countdown_mock>(socket, rx, packet + 2, packet[1], timeout);
+        return rc == packet[1] ? packet[1] + 2 : rc;
+    }
+};
+
+TEST_F(TestMQTTNetworkUtil, single_byte_fragments)
+{
+    Socket_mock socket(1);
+    unsigned char packet[sizeof(publish_packet)];
+    socket.queue(publish_packet, sizeof(publish_packet));
+
+    EXPECT_EQ((int)sizeof(publish_packet), read_packet(&socket, packet, 1000));
+    EXPECT_EQ(0, memcmp(packet, publish_packet, sizeof(publish_packet)));
+    EXPECT_EQ((int)sizeof(publish_packet), socket.recv_calls);
+    EXPECT_GE(socket.set_timeout_calls, 1);
+    EXPECT_LE(socket.set_timeout_calls, socket.recv_calls);
+}
+
+TEST_F(TestMQTTNetworkUtil, whole_packet_in_one_recv)
+{
+    Socket_mock socket(sizeof(publish_packet));
+    unsigned char packet[sizeof(publish_packet)];
+    socket.queue(publish_packet, sizeof(publish_packet));
+
+    EXPECT_EQ((int)sizeof(publish_packet), read_packet(&socket, packet, 1000));
+    EXPECT_EQ(0, memcmp(packet, publish_packet, sizeof(publish_packet)));
+    EXPECT_EQ(1, socket.recv_calls);
+    EXPECT_EQ(1, socket.set_timeout_calls);
+}
+
+TEST_F(TestMQTTNetworkUtil, back_to_back_packets_read_ahead)
+{
+    Socket_mock socket(64);
+    unsigned char packet[sizeof(publish_packet)];
+    socket.queue(publish_packet, sizeof(publish_packet));
+    socket.queue(publish_packet, sizeof(publish_packet));
+
+    EXPECT_EQ((int)sizeof(publish_packet), read_packet(&socket, packet, 1000));
+    EXPECT_EQ((int)sizeof(publish_packet), read_packet(&socket, packet, 1000));
+    EXPECT_EQ(0, memcmp(packet, publish_packet, sizeof(publish_packet)));
+    EXPECT_EQ(2, socket.recv_calls);
+}
+
+TEST_F(TestMQTTNetworkUtil, timeout_applies_to_whole_operation)
+{
+    Socket_mock socket(1, 10);
+    unsigned char packet[sizeof(publish_packet)];
+    socket.queue(publish_packet, 2);
+    socket.queue(publish_packet + 2, 4);
+
+    // The body needs 7 bytes at 10 ms each but only 4 ever arrive
+    EXPECT_EQ(1, buffered_mqtt_read<Countdown_mock>(&socket, rx, packet, 1, 35));
+    EXPECT_EQ(1, buffered_mqtt_read<Countdown_mock>(&socket, rx, packet + 1, 1, 35));
+    unsigned long start = Socket_mock::clock_ms;
+    EXPECT_EQ(0, buffered_mqtt_read<Countdown_mock>(&socket, rx, packet + 2, 7, 35));
+    EXPECT_LE(Socket_mock::clock_ms - start, 35u + socket.latency_ms);
+}
+
+TEST_F(TestMQTTNetworkUtil, data_survives_timeout)
+{
+    Socket_mock socket(1, 10);
+    unsigned char body[7];
+    socket.queue(publish_packet + 2, 3);
+
+    EXPECT_EQ(0, buffered_mqtt_read<Countdown_mock>(&socket, rx, body, sizeof(body), 50));
+
+    // Bytes received before the timeout are not lost when the read is retried
+    socket.queue(publish_packet + 5, 4);
+    EXPECT_EQ((int)sizeof(body), buffered_mqtt_read<Countdown_mock>(&socket, rx, body, sizeof(body), 1000));
+    EXPECT_EQ(0, memcmp(body, publish_packet + 2, sizeof(body)));
+}
+
+TEST_F(TestMQTTNetworkUtil, request_larger_than_buffer)
+{
+    Socket_mock socket(5);
+    unsigned char data[40];
+    unsigned char out[40];
+    for (int i = 0; i < (int)sizeof(data); ++i) {
+        data[i] = i;
+    }
+    socket.queue(data, sizeof(data));
+
+    EXPECT_EQ(1, buffered_mqtt_read<Countdown_mock>(&socket, rx, out, 1, 1000));
+    EXPECT_EQ(39, buffered_mqtt_read<Countdown_mock>(&socket, rx, out + 1, 39, 1000));
+    EXPECT_EQ(0, memcmp(data, out, sizeof(data)));
+}
+
+TEST_F(TestMQTTNetworkUtil, request_larger_than_buffer_times_out_mid_packet)
+{
+    Socket_mock socket(5, 10);
+    unsigned char data[40];
+    unsigned char out[40];
+    for (int i = 0; i < (int)sizeof(data); ++i) {
+        data[i] = i;
+    }
+    socket.queue(data, 1 + 12);
+
+    EXPECT_EQ(1, buffered_mqtt_read<Countdown_mock>(&socket, rx, out, 1, 1000));
+    // The buffered byte and the bytes received before the timeout are returned, not dropped
+    EXPECT_EQ(12, buffered_mqtt_read<Countdown_mock>(&socket, rx, out + 1, 39, 35));
+    EXPECT_EQ(0, memcmp(data, out, 13));
+
+    // The stream continues where it stopped
+    socket.queue(data + 13, sizeof(data) - 13);
+    EXPECT_EQ(27, buffered_mqtt_read<Countdown_mock>(&socket, rx, out + 13, 27, 1000));
+    EXPECT_EQ(0, memcmp(data, out, sizeof(data)));
+}
+
+TEST_F(TestMQTTNetworkUtil, closed_socket)
+{
+    Socket_mock socket(1);
+    unsigned char packet[sizeof(publish_packet)];
+    socket.queue(publish_packet, 3);
+    socket.closed = true;
+
+    EXPECT_EQ(-1, read_packet(&socket, packet, 1000));
+}
+
+TEST_F(TestMQTTNetworkUtil, accumulate_single_byte_fragments)
+{
+    Socket_mock socket(1);
+    unsigned char packet[sizeof(publish_packet)];
+    socket.queue(publish_packet, sizeof(publish_packet));
+
+    EXPECT_EQ((int)sizeof(publish_packet), accumulate_mqtt_read<Countdown_mock>(&socket, packet, sizeof(packet), 1000));
+    EXPECT_EQ(0, memcmp(packet, publish_packet, sizeof(publish_packet)));
+}
+
+TEST_F(TestMQTTNetworkUtil, accumulate_deadline)
+{
+    Socket_mock socket(1, 10);
+    unsigned char packet[sizeof(publish_packet)];
+    socket.queue(publish_packet, sizeof(publish_packet));
+
+    unsigned long start = Socket_mock::clock_ms;
+    EXPECT_EQ(0, accumulate_mqtt_read<Countdown_mock>(&socket, packet, sizeof(packet), 35));
+    EXPECT_LE(Socket_mock::clock_ms - start, 35u + socket.latency_ms);
+}
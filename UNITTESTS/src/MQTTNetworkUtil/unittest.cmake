@@ -0,0 +1,18 @@
+
+####################
+# UNIT TESTS
+####################
+
+set(unittest-includes ${unittest-includes}
+  ../src
+  target_h
+)
+
+set(unittest-sources
+  ../src/MQTTNetworkUtil.h
+)
+
+set(unittest-test-sources
+  src/MQTTNetworkUtil/test_MQTTNetworkUtil.cpp
+  mocks/Socket_mock.h
+)
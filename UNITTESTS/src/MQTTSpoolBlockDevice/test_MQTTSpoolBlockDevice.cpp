@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2026, agent
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "gtest/gtest.h"
+#include "../../stubs/FlashSimBlockDevice_stub.h"
+#include "MQTTSpoolBlockDevice.h"
+
+static const bd_size_t ERASE_SIZE = 256;
+static const bd_size_t REGION = 4 * ERASE_SIZE;
+
+class TestMQTTSpoolBlockDevice : public testing::Test {
+protected:
+    TestMQTTSpoolBlockDevice() : flash(REGION + 2 * ERASE_SIZE, 1, 16, ERASE_SIZE)
+    {
+    }
+
+    // a record of len bytes, all of them the low byte of its sequence number
+    int make(int sequence, unsigned char *record)
+    {
+        int len = 1 + (sequence * 37) % 120;
+        memset(record, sequence & 0xFF, len);
+        return len;
+    }
+
+    FlashSimBlockDevice flash;
+};
+
+TEST_F(TestMQTTSpoolBlockDevice, spool_wraps_on_flash)
+{
+    // the spool region sits between two erase units that must not change
+    MQTTSpoolBlockDeviceStorage storage(&flash, ERASE_SIZE, REGION);
+    MQTT::SpoolRAMStorage<64> ram;
+    MQTT::Spool spool(ram, &storage);
+    unsigned char record[128], out[128];
+    int pushed = 0, popped = 0;
+
+    for (int round = 0; round < 300; ++round) {
+        int len = make(pushed, record);
+        ASSERT_TRUE(spool.push(record, len)) << "record " << pushed;
+        pushed++;
+        if (round % 4 == 3) {
+            while (spool.count() > (unsigned)(round % 3)) {
+                int got = spool.peek(out, sizeof(out));
+                ASSERT_EQ(make(popped, record), got) << "record " << popped;
+                ASSERT_EQ(0, memcmp(record, out, got)) << "record " << popped;
+                spool.pop();
+                popped++;
+            }
+        }
+    }
+    // about 18KB went through the 1KB region
+    EXPECT_GT(flash.erases, 20);
+    for (bd_size_t i = 0; i < ERASE_SIZE; ++i) {
+        ASSERT_EQ(0xFF, flash.data[i]);
+        ASSERT_EQ(0xFF, flash.data[ERASE_SIZE + REGION + i]);
+    }
+
+    // the oldest records, those in the flash, are found again after a restart
+    MQTTSpoolBlockDeviceStorage restarted(&flash, ERASE_SIZE, REGION);
+    MQTT::SpoolRAMStorage<64> ram_after;
+    MQTT::Spool after(ram_after, &restarted);
+    EXPECT_GT(after.count(), 0u);
+    while (!after.empty()) {
+        int got = after.peek(out, sizeof(out));
+        ASSERT_EQ(make(popped, record), got) << "record " << popped;
+        ASSERT_EQ(0, memcmp(record, out, got)) << "record " << popped;
+        after.pop();
+        popped++;
+    }
+    EXPECT_LT(popped, pushed);
+}
+
+TEST_F(TestMQTTSpoolBlockDevice, unaligned_reads_and_writes)
+{
+    MQTTSpoolBlockDeviceStorage storage(&flash, 0, REGION);
+    unsigned char in[300], out[300];
+
+    for (int i = 0; i < (int)sizeof(in); ++i) {
+        in[i] = (unsigned char)i;
+    }
+    ASSERT_EQ(0, storage.write(250, in, sizeof(in)));  // across two erase unit boundaries
+    ASSERT_EQ(0, storage.write(3, in, 5));
+    ASSERT_EQ(0, storage.write(5, in + 100, 7));       // into a program unit written already
+    ASSERT_EQ(0, storage.read(250, out, sizeof(out)));
+    EXPECT_EQ(0, memcmp(in, out, sizeof(in)));
+    ASSERT_EQ(0, storage.read(3, out, 9));
+    EXPECT_EQ(0, memcmp(in, out, 2));
+    EXPECT_EQ(0, memcmp(in + 100, out + 2, 7));
+    EXPECT_EQ(1, flash.erases);
+}
@@ -0,0 +1,19 @@
+####################
+# UNIT TESTS
+####################
+
+set(unittest-includes ${unittest-includes}
+  ../src
+  ../paho_mqtt_embedded_c/MQTTClient/src
+  target_h
+)
+
+set(unittest-sources
+  ../src/MQTTSpoolBlockDevice.h
+  ../paho_mqtt_embedded_c/MQTTClient/src/MQTTSpool.h
+)
+
+set(unittest-test-sources
+  src/MQTTSpoolBlockDevice/test_MQTTSpoolBlockDevice.cpp
+  stubs/FlashSimBlockDevice_stub.h
+)
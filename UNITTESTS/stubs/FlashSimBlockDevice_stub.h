@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2026, agent
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FLASHSIMBLOCKDEVICE_STUB_H
+#define FLASHSIMBLOCKDEVICE_STUB_H
+
+#include <string.h>
+#include <vector>
+#include "BlockDevice.h"
+
+/* Flash in RAM, stricter than mbed's FlashSimBlockDevice: accesses must be aligned, and a program
+ * unit can only be programmed once between erases, which fails as a device error.
+ */
+class FlashSimBlockDevice : public BlockDevice {
+public:
+    FlashSimBlockDevice(bd_size_t size, bd_size_t read_size, bd_size_t program_size, bd_size_t erase_size,
+                        uint8_t erase_value = 0xFF)
+        : data(size, erase_value), programmed(size / program_size, false), read_size(read_size),
+          program_size(program_size), erase_size(erase_size), erase_value(erase_value), programs(0), erases(0)
+    {
+    }
+
+    int init()
+    {
+        return BD_ERROR_OK;
+    }
+
+    int deinit()
+    {
+        return BD_ERROR_OK;
+    }
+
+    int read(void *buffer, bd_addr_t addr, bd_size_t size)
+    {
+        if (addr % read_size || size % read_size || addr + size > data.size()) {
+            return BD_ERROR_DEVICE_ERROR;
+        }
+        memcpy(buffer, &data[addr], size);
+        return BD_ERROR_OK;
+    }
+
+    int program(const void *buffer, bd_addr_t addr, bd_size_t size)
+    {
+        if (addr % program_size || size % program_size || addr + size > data.size()) {
+            return BD_ERROR_DEVICE_ERROR;
+        }
+        for (bd_addr_t unit = addr / program_size; unit < (addr + size) / program_size; ++unit) {
+            if (programmed[unit]) {
+                return BD_ERROR_DEVICE_ERROR;
+            }
+            programmed[unit] = true;
+        }
+        memcpy(&data[addr], buffer, size);
+        programs++;
+        return BD_ERROR_OK;
+    }
+
+    int erase(bd_addr_t addr, bd_size_t size)
+    {
+        if (addr % erase_size || size % erase_size || addr + size > data.size()) {
+            return BD_ERROR_DEVICE_ERROR;
+        }
+        memset(&data[addr], erase_value, size);
+        for (bd_addr_t unit = addr / program_size; unit < (addr + size) / program_size; ++unit) {
+            programmed[unit] = false;
+        }
+        erases++;
+        return BD_ERROR_OK;
+    }
+
+    bd_size_t get_read_size() const
+    {
+        return read_size;
+    }
+
+    bd_size_t get_program_size() const
+    {
+        return program_size;
+    }
+
+    bd_size_t get_erase_size() const
+    {
+        return erase_size;
+    }
+
+    int get_erase_value() const
+    {
+        return erase_value;
+    }
+
+    bd_size_t size() const
+    {
+        return data.size();
+    }
+
+    std::vector<uint8_t> data;
+    std::vector<bool> programmed;
+    bd_size_t read_size, program_size, erase_size;
+    uint8_t erase_value;
+    int programs;
+    int erases;
+};
+
+#endif
@@ -39,6 +39,18 @@
 #if !defined(MQTTSNCLIENT_QOS2)
     #define MQTTSNCLIENT_QOS2 0
 #endif
+#if !defined(MQTTCLIENT_SHARED_BUFFERS)
+    #define MQTTCLIENT_SHARED_BUFFERS 0
+#endif
+#if MQTTCLIENT_SHARED_BUFFERS
+    #include <stdlib.h>
+    #if !defined(MQTTCLIENT_MALLOC)
+        #define MQTTCLIENT_MALLOC malloc
+    #endif
+    #if !defined(MQTTCLIENT_FREE)
+        #define MQTTCLIENT_FREE free
+    #endif
+#endif
 
 namespace MQTTSN
 {
@@ -96,6 +108,10 @@ private:
  *
  * This version of the API blocks on all method calls, until they are complete.  This means that only one
  * MQTT request can be in process at any one time.
+ *
+ * With MQTTCLIENT_SHARED_BUFFERS the send and read buffers are supplied by the caller, so clients which
+ * are never used concurrently can share them, and the copy of an inflight publish kept for resending
+ * on reconnect is allocated with MQTTCLIENT_MALLOC to the length of the packet.
  * @param Network a network class which supports send, receive
  * @param Timer a timer class with the methods:
  */
@@ -112,7 +128,19 @@ public:
      *      before calling MQTT connect
      *  @param limits an instance of the Limit class - to alter limits as required
      */
+#if MQTTCLIENT_SHARED_BUFFERS
+    /** Construct the client on caller supplied buffers
+     *  @param network - pointer to an instance of the Network class - must be connected to the endpoint
+     *      before calling MQTT connect
+     *  @param sendbuf - MAX_PACKET_SIZE bytes, can be shared with clients which are not used concurrently
+     *  @param readbuf - MAX_PACKET_SIZE bytes, can be shared with clients which are not used concurrently
+     */
+    Client(Network& network, unsigned char* sendbuf, unsigned char* readbuf, unsigned int command_timeout_ms = 30000);
+
+    ~Client();
+#else
     Client(Network& network, unsigned int command_timeout_ms = 30000);
+#endif
 
     /** Set the default message handling callback - used for any message which does not match a subscription message handler
      *  @param mh - pointer to the callback function
@@ -219,8 +247,13 @@ private:
     Network& ipstack;
     unsigned long command_timeout_ms;
 
+#if MQTTCLIENT_SHARED_BUFFERS
+    unsigned char* sendbuf;
+    unsigned char* readbuf;
+#else
     unsigned char sendbuf[MAX_PACKET_SIZE];
     unsigned char readbuf[MAX_PACKET_SIZE];
+#endif
 
     Timer last_sent, last_received;
     unsigned short duration;
@@ -246,7 +279,13 @@ private:
     } registrations[MAX_REGISTRATIONS];
 
 #if MQTTCLIENT_QOS1 || MQTTCLIENT_QOS2
+    bool storeInflight(int len);
+    void clearInflight();
+#if MQTTCLIENT_SHARED_BUFFERS
+    unsigned char* pubbuf;  // store the last publish for sending on reconnect, inflightLen bytes
+#else
     unsigned char pubbuf[MAX_PACKET_SIZE];  // store the last publish for sending on reconnect
+#endif
     int inflightLen;
     unsigned short inflightMsgid;
     enum QoS inflightQoS;
@@ -264,8 +303,14 @@ private:
 }
 
 
+#if MQTTCLIENT_SHARED_BUFFERS
+template<class Network, class Timer, int a, int MAX_MESSAGE_HANDLERS>
+MQTTSN::Client<Network, Timer, a, MAX_MESSAGE_HANDLERS>::Client(Network& network, unsigned char* sendbuf, unsigned char* readbuf,
+     unsigned int command_timeout_ms)  : ipstack(network), sendbuf(sendbuf), readbuf(readbuf), packetid()
+#else
 template<class Network, class Timer, int a, int MAX_MESSAGE_HANDLERS>
 MQTTSN::Client<Network, Timer, a, MAX_MESSAGE_HANDLERS>::Client(Network& network, unsigned int command_timeout_ms)  : ipstack(network), packetid()
+#endif
 {
     ping_outstanding = false;
     for (int i = 0; i < MAX_MESSAGE_HANDLERS; ++i)
@@ -274,6 +319,9 @@ MQTTSN::Client<Network, Timer, a, MAX_MESSAGE_HANDLERS>::Client(Network& network
     isconnected = false;
     
 #if MQTTCLIENT_QOS1 || MQTTCLIENT_QOS2
+#if MQTTCLIENT_SHARED_BUFFERS
+    pubbuf = 0;
+#endif
     inflightMsgid = 0;
     inflightQoS = QOS0;
 #endif
@@ -286,6 +334,44 @@ MQTTSN::Client<Network, Timer, a, MAX_MESSAGE_HANDLERS>::Client(Network& network
 #endif
 }
 
+#if MQTTCLIENT_SHARED_BUFFERS
+template<class Network, class Timer, int a, int MAX_MESSAGE_HANDLERS>
+MQTTSN::Client<Network, Timer, a, MAX_MESSAGE_HANDLERS>::~Client()
+{
+#if MQTTCLIENT_QOS1 || MQTTCLIENT_QOS2
+    clearInflight();
+#endif
+}
+#endif
+
+
+#if MQTTCLIENT_QOS1 || MQTTCLIENT_QOS2
+template<class Network, class Timer, int a, int b>
+bool MQTTSN::Client<Network, Timer, a, b>::storeInflight(int len)
+{
+#if MQTTCLIENT_SHARED_BUFFERS
+    clearInflight();
+    if ((pubbuf = (unsigned char*)MQTTCLIENT_MALLOC(len)) == 0)
+        return false;
+#endif
+    memcpy(pubbuf, sendbuf, len);
+    inflightLen = len;
+    return true;
+}
+
+
+template<class Network, class Timer, int a, int b>
+void MQTTSN::Client<Network, Timer, a, b>::clearInflight()
+{
+    inflightMsgid = 0;
+#if MQTTCLIENT_SHARED_BUFFERS
+    MQTTCLIENT_FREE(pubbuf);
+    pubbuf = 0;
+#endif
+}
+#endif
+
+
 #if MQTTCLIENT_QOS2
 template<class Network, class Timer, int a, int b>
 bool MQTTSN::Client<Network, Timer, a, b>::isQoS2msgidFree(unsigned short id)
@@ -685,7 +771,7 @@ int MQTTSN::Client<Network, Timer, MAX_PACKET_SIZE, b>::connect(MQTTSNPacket_con
 #if MQTTCLIENT_QOS1 || MQTTCLIENT_QOS2
     if (inflightMsgid > 0)
     {
-        memcpy(sendbuf, pubbuf, MAX_PACKET_SIZE);
+        memcpy(sendbuf, pubbuf, inflightLen);
         rc = publish(inflightLen, connect_timer, inflightQoS);
     }
 #endif
@@ -820,7 +906,7 @@ int MQTTSN::Client<Network, Timer, MAX_PACKET_SIZE, b>::publish(int len, Timer&
             if (MQTTSNDeserialize_ack(&type, &mypacketid, readbuf, MAX_PACKET_SIZE) != 1)
                 rc = FAILURE;
             else if (inflightMsgid == mypacketid)
-                inflightMsgid = 0;
+                clearInflight();
         }
         else
             rc = FAILURE;
@@ -835,7 +921,7 @@ int MQTTSN::Client<Network, Timer, MAX_PACKET_SIZE, b>::publish(int len, Timer&
             if (MQTTDeserialize_ack(&type, &mypacketid, readbuf, MAX_PACKET_SIZE) != 1)
                 rc = FAILURE;
             else if (inflightMsgid == mypacketid)
-                inflightMsgid = 0;
+                clearInflight();
         }
         else
             rc = FAILURE;
@@ -871,11 +957,11 @@ int MQTTSN::Client<Network, Timer, MAX_PACKET_SIZE, b>::publish(MQTTSN_topicid&
         goto exit;
         
 #if MQTTCLIENT_QOS1 || MQTTCLIENT_QOS2
-    if (!cleansession)
+    if (!cleansession && qos != QOS0)
     {
-        memcpy(pubbuf, sendbuf, len);
+        if (!storeInflight(len))
+            goto exit;
         inflightMsgid = id;
-        inflightLen = len;
         inflightQoS = qos;
 #if MQTTCLIENT_QOS2
         pubrel = false;
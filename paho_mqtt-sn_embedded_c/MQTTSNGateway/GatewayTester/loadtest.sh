@@ -0,0 +1,74 @@
+#!/bin/sh
+#**************************************************************************
+# Copyright (c) 2026, agent
+#
+# All rights reserved. This program and the accompanying materials
+# are made available under the terms of the Eclipse Public License v1.0
+# and Eclipse Distribution License v1.0 which accompany this distribution.
+#
+# The Eclipse Public License is available at
+#    http://www.eclipse.org/legal/epl-v10.html
+# and the Eclipse Distribution License is available at
+#   http://www.eclipse.org/org/documents/edl-v10.php.
+#***************************************************************************
+#
+# Offline load test of the gateway:  ./loadtest.sh [path/to/MQTT-SNGateway]
+#
+# Starts the broker stand-in and the gateway on the loopback interface,
+# runs the scenarios below with the load generator and prints the results.
+# Build the programs first with  make loadtest  here and  make  in ../
+# The numbers of a reference run are in loadtest-baseline.txt
+#
+
+GATEWAY=${1:-../Build/MQTT-SNGateway}
+LOADGEN=./Build/MQTT-SNLoadGenerator
+BROKER=./Build/MQTT-SNBrokerStandIn
+BROKER_PORT=${BROKER_PORT:-18830}
+GATEWAY_PORT=${GATEWAY_PORT:-10000}
+WORKDIR=$(mktemp -d /tmp/mqttsn-loadtest.XXXXXX)
+
+cat > $WORKDIR/gateway.conf <<CONF
+BrokerName=127.0.0.1
+BrokerPortNo=$BROKER_PORT
+BrokerSecurePortNo=8883
+ClientAuthentication=NO
+AggregatingGateway=NO
+QoS-1=NO
+Forwarder=NO
+PredefinedTopic=NO
+MaxClients=2000
+GatewayID=1
+GatewayName=PahoGateway-LoadTest
+KeepAlive=900
+GatewayPortNo=$GATEWAY_PORT
+MulticastIP=225.1.1.1
+MulticastPortNo=$((GATEWAY_PORT + 1))
+ShearedMemory=NO
+CONF
+
+$BROKER -p $BROKER_PORT > $WORKDIR/broker.log 2>&1 &
+BROKER_PID=$!
+$GATEWAY -f $WORKDIR/gateway.conf > $WORKDIR/gateway.log 2>&1 &
+GATEWAY_PID=$!
+sleep 2
+
+scenario()
+{
+    echo "=== $1"
+    shift
+    $LOADGEN -g 127.0.0.1:$GATEWAY_PORT "$@"
+    echo
+}
+
+# -T stays within MAX_TOPIC_PAR_CLIENT (50), the topics a client can register at the gateway
+scenario "QoS 0, 100 clients x 10/sec"                  -n 100 -t 2 -c 200 -r 10 -q 100,0,0 -T 50 -d 10
+scenario "QoS 1, 100 clients x 10/sec"                  -n 100 -t 2 -c 200 -r 10 -q 0,100,0 -T 50 -d 10
+scenario "QoS 2, 100 clients x 10/sec"                  -n 100 -t 2 -c 200 -r 10 -q 0,0,100 -T 50 -d 10
+scenario "QoS 1, 1000 clients x 1/sec"                  -n 1000 -t 4 -c 500 -r 1 -q 0,100,0 -T 50 -z -d 10
+scenario "mixed QoS, sleeping clients and subscribers"  -n 200 -t 2 -c 200 -r 5 -q 40,40,20 -s 3:2 -T 50 -z -S 10 -d 10
+
+kill $GATEWAY_PID
+kill $BROKER_PID
+wait $BROKER_PID 2>/dev/null
+cat $WORKDIR/broker.log
+rm -rf $WORKDIR
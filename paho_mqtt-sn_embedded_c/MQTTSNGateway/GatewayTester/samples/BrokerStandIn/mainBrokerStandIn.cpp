@@ -0,0 +1,75 @@
+/****************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ *---------------------------------------------------------------------------
+ *
+ *   MQTT BROKER STAND-IN for the load tests of the gateway
+ *
+ *   MQTT-SNBrokerStandIn [-p portNo]
+ *
+ *   Runs until SIGINT or SIGTERM and prints what it received.
+ *
+ * Contributors:
+ *    agent - broker stand-in for load tests
+ ***************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include "LBrokerStandIn.h"
+
+using namespace std;
+using namespace linuxAsyncClient;
+
+static volatile bool theStop = false;
+
+static void onSignal(int sig)
+{
+    theStop = true;
+}
+
+int main(int argc, char** argv)
+{
+    uint16_t portNo = 1883;
+    int opt;
+
+    while ( (opt = getopt(argc, argv, "p:h")) != -1 )
+    {
+        if ( opt == 'p' )
+        {
+            portNo = atoi(optarg);
+        }
+        else
+        {
+            fprintf(stderr, "Usage: MQTT-SNBrokerStandIn [-p portNo]\n");
+            return 1;
+        }
+    }
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+    signal(SIGPIPE, SIG_IGN);
+
+    LBrokerStandIn* broker = new LBrokerStandIn();
+    if ( !broker->open(portNo) )
+    {
+        fprintf(stderr, "Can't listen on port %u\n", portNo);
+        delete broker;
+        return 1;
+    }
+    broker->run(&theStop);
+    broker->report();
+    delete broker;
+    return 0;
+}
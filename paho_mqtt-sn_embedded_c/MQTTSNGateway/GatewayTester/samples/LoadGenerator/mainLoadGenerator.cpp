@@ -0,0 +1,145 @@
+/****************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ *---------------------------------------------------------------------------
+ *
+ *   MQTT-SN GATEWAY LOAD GENERATOR
+ *
+ *   Runs N virtual clients against a gateway without a screen and reports
+ *   the throughput and the latency percentiles.
+ *
+ *   MQTT-SNLoadGenerator [-g host:port] [-n clients] [-t threads] [-c connects/sec]
+ *                        [-r publishes/sec/client] [-q qos0,qos1,qos2] [-s awake:sleep]
+ *                        [-T topics] [-z] [-S subscribers] [-l payload] [-d secs]
+ *                        [-k keepAlive] [-i clientIdPrefix]
+ *
+ * Contributors:
+ *    agent - load generator
+ ***************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "LLoadGenerator.h"
+
+using namespace std;
+using namespace linuxAsyncClient;
+
+static void usage(void)
+{
+    fprintf(stderr, "Usage: MQTT-SNLoadGenerator [-g host:port] [-n clients] [-t threads] [-c connects/sec]\n"
+            "         [-r publishes/sec/client] [-q qos0,qos1,qos2 percent] [-s awakeSecs:sleepSecs]\n"
+            "         [-T topics] [-z (zipf topics)] [-S subscribers] [-l payload] [-d secs]\n"
+            "         [-k keepAlive] [-i clientIdPrefix]\n");
+}
+
+int main(int argc, char** argv)
+{
+    static char gwAddress[64] = "127.0.0.1";
+    LLoadConfig config;
+    int opt;
+
+    memset(&config, 0, sizeof(config));
+    config.gwAddress = gwAddress;
+    config.gwPortNo = 10000;
+    config.clientIdPrefix = "LoadGen";
+    config.clients = 10;
+    config.threads = 2;
+    config.connectRate = 100;
+    config.publishRate = 1;
+    config.qos[0] = 100;
+    config.topics = 10;
+    config.payloadSize = 32;
+    config.duration = 10;
+    config.keepAlive = 60;
+
+    while ( (opt = getopt(argc, argv, "g:n:t:c:r:q:s:T:zS:l:d:k:i:h")) != -1 )
+    {
+        switch ( opt )
+        {
+        case 'g':
+        {
+            char* colon = strrchr(optarg, ':');
+            if ( colon )
+            {
+                config.gwPortNo = atoi(colon + 1);
+                *colon = 0;
+            }
+            strncpy(gwAddress, optarg, sizeof(gwAddress) - 1);
+            break;
+        }
+        case 'n':
+            config.clients = atoi(optarg);
+            break;
+        case 't':
+            config.threads = atoi(optarg);
+            break;
+        case 'c':
+            config.connectRate = atoi(optarg);
+            break;
+        case 'r':
+            config.publishRate = atof(optarg);
+            break;
+        case 'q':
+            if ( sscanf(optarg, "%d,%d,%d", &config.qos[0], &config.qos[1], &config.qos[2]) != 3 )
+            {
+                usage();
+                return 1;
+            }
+            break;
+        case 's':
+            if ( sscanf(optarg, "%d:%d", &config.awakeSecs, &config.sleepSecs) != 2 )
+            {
+                usage();
+                return 1;
+            }
+            break;
+        case 'T':
+            config.topics = atoi(optarg);
+            break;
+        case 'z':
+            config.zipf = true;
+            break;
+        case 'S':
+            config.subscribers = atoi(optarg);
+            break;
+        case 'l':
+            config.payloadSize = atoi(optarg);
+            break;
+        case 'd':
+            config.duration = atoi(optarg);
+            break;
+        case 'k':
+            config.keepAlive = atoi(optarg);
+            break;
+        case 'i':
+            config.clientIdPrefix = optarg;
+            break;
+        default:
+            usage();
+            return 1;
+        }
+    }
+
+    LLoadGenerator* generator = new LLoadGenerator();
+    if ( !generator->initialize(&config) )
+    {
+        delete generator;
+        return 1;
+    }
+    generator->run();
+    generator->report();
+    delete generator;
+    return 0;
+}
@@ -0,0 +1,413 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - broker stand-in for load tests
+ **************************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#include "LBrokerStandIn.h"
+
+using namespace std;
+using namespace linuxAsyncClient;
+
+extern void setUint16(uint8_t* pos, uint16_t val);
+extern uint16_t getUint16(const uint8_t* pos);
+
+#define BROKER_CONNECT      1
+#define BROKER_CONNACK      2
+#define BROKER_PUBLISH      3
+#define BROKER_PUBACK       4
+#define BROKER_PUBREC       5
+#define BROKER_PUBREL       6
+#define BROKER_PUBCOMP      7
+#define BROKER_SUBSCRIBE    8
+#define BROKER_SUBACK       9
+#define BROKER_UNSUBSCRIBE 10
+#define BROKER_UNSUBACK    11
+#define BROKER_PINGREQ     12
+#define BROKER_PINGRESP    13
+#define BROKER_DISCONNECT  14
+
+#define BROKER_READ_SIZE   65536
+
+/*=====================================
+ Class LBrokerStandIn
+ ======================================*/
+LBrokerStandIn::LBrokerStandIn()
+{
+    _listener = -1;
+    _connects = 0;
+    _published = 0;
+    _forwarded = 0;
+    _pings = 0;
+}
+
+LBrokerStandIn::~LBrokerStandIn()
+{
+    for ( size_t i = 0; i < _conns.size(); i++ )
+    {
+        close(_conns[i]->fd);
+        delete _conns[i];
+    }
+    if ( _listener >= 0 )
+    {
+        close(_listener);
+    }
+}
+
+bool LBrokerStandIn::open(uint16_t portNo)
+{
+    const int reuse = 1;
+    struct sockaddr_in addr;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(portNo);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+
+    _listener = socket(AF_INET, SOCK_STREAM, 0);
+    if ( _listener < 0 )
+    {
+        return false;
+    }
+    setsockopt(_listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    if ( bind(_listener, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(_listener, SOMAXCONN) < 0 )
+    {
+        return false;
+    }
+    return fcntl(_listener, F_SETFL, O_NONBLOCK) == 0;
+}
+
+void LBrokerStandIn::run(volatile bool* stop)
+{
+    vector<struct pollfd> fds;
+
+    while ( !*stop )
+    {
+        fds.resize(_conns.size() + 1);
+        fds[0].fd = _listener;
+        fds[0].events = POLLIN;
+        for ( size_t i = 0; i < _conns.size(); i++ )
+        {
+            fds[i + 1].fd = _conns[i]->fd;
+            fds[i + 1].events = POLLIN | (_conns[i]->out.empty() ? 0 : POLLOUT);
+        }
+        if ( poll(&fds[0], fds.size(), 100) <= 0 )
+        {
+            continue;
+        }
+
+        /* connections closed in this round are removed from the end */
+        size_t cnt = _conns.size();
+        for ( size_t i = cnt; i > 0; i-- )
+        {
+            LBrokerConnection* conn = _conns[i - 1];
+            short ev = fds[i].revents;
+            bool alive = true;
+
+            if ( ev & (POLLIN | POLLHUP | POLLERR) )
+            {
+                alive = read(conn);
+            }
+            if ( alive && (ev & POLLOUT) )
+            {
+                alive = flush(conn);
+            }
+            if ( !alive )
+            {
+                close(conn->fd);
+                delete conn;
+                _conns.erase(_conns.begin() + i - 1);
+            }
+        }
+        if ( fds[0].revents & POLLIN )
+        {
+            accept();
+        }
+    }
+}
+
+void LBrokerStandIn::accept(void)
+{
+    const int nodelay = 1;
+    int fd;
+
+    while ( (fd = ::accept(_listener, 0, 0)) >= 0 )
+    {
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+        LBrokerConnection* conn = new LBrokerConnection();
+        conn->fd = fd;
+        _conns.push_back(conn);
+    }
+}
+
+/* Returns false when the connection is closed */
+bool LBrokerStandIn::read(LBrokerConnection* conn)
+{
+    uint8_t buf[BROKER_READ_SIZE];
+    int len;
+
+    while ( (len = ::recv(conn->fd, buf, sizeof(buf), MSG_DONTWAIT)) > 0 )
+    {
+        conn->in.insert(conn->in.end(), buf, buf + len);
+    }
+    if ( len == 0 || (len < 0 && errno != EAGAIN && errno != EWOULDBLOCK) )
+    {
+        return false;
+    }
+
+    /* fixed header, remaining length, variable header and payload */
+    size_t pos = 0;
+    while ( conn->in.size() - pos >= 2 )
+    {
+        uint32_t remain = 0;
+        uint32_t mul = 1;
+        size_t p = pos + 1;
+        bool complete = false;
+        while ( p < conn->in.size() && p - pos <= 4 )
+        {
+            uint8_t b = conn->in[p++];
+            remain += (b & 0x7f) * mul;
+            mul <<= 7;
+            if ( (b & 0x80) == 0 )
+            {
+                complete = true;
+                break;
+            }
+        }
+        if ( !complete || conn->in.size() - p < remain )
+        {
+            break;
+        }
+        uint8_t header = conn->in[pos];
+        if ( (header >> 4) == BROKER_DISCONNECT )
+        {
+            return false;
+        }
+        handle(conn, header, &conn->in[0] + p, remain);
+        pos = p + remain;
+    }
+    conn->in.erase(conn->in.begin(), conn->in.begin() + pos);
+    return flush(conn);
+}
+
+bool LBrokerStandIn::flush(LBrokerConnection* conn)
+{
+    if ( conn->out.empty() )
+    {
+        return true;
+    }
+    int len = ::send(conn->fd, &conn->out[0], conn->out.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+    if ( len < 0 )
+    {
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+    conn->out.erase(conn->out.begin(), conn->out.begin() + len);
+    return true;
+}
+
+void LBrokerStandIn::write(LBrokerConnection* conn, const uint8_t* data, uint32_t len)
+{
+    conn->out.insert(conn->out.end(), data, data + len);
+}
+
+void LBrokerStandIn::writeAck(LBrokerConnection* conn, uint8_t header, const uint8_t* packetId)
+{
+    uint8_t ack[4] = { header, 2, packetId[0], packetId[1] };
+    write(conn, ack, 4);
+}
+
+void LBrokerStandIn::handle(LBrokerConnection* conn, uint8_t header, uint8_t* data, uint32_t len)
+{
+    switch ( header >> 4 )
+    {
+    case BROKER_CONNECT:
+    {
+        uint8_t connack[4] = { BROKER_CONNACK << 4, 2, 0, 0 };
+        write(conn, connack, 4);
+        _connects++;
+        break;
+    }
+
+    case BROKER_PUBLISH:
+    {
+        int qos = (header >> 1) & 3;
+        if ( len < 2 )
+        {
+            break;
+        }
+        uint16_t topicLen = getUint16(data);
+        uint32_t varLen = 2 + topicLen + (qos ? 2 : 0);
+        if ( varLen > len )
+        {
+            break;
+        }
+        _published++;
+        if ( qos == 1 )
+        {
+            writeAck(conn, BROKER_PUBACK << 4, data + 2 + topicLen);
+        }
+        else if ( qos == 2 )
+        {
+            writeAck(conn, BROKER_PUBREC << 4, data + 2 + topicLen);
+        }
+        forward(data + 2, topicLen, data + varLen, len - varLen);
+        break;
+    }
+
+    case BROKER_PUBREL:
+        if ( len >= 2 )
+        {
+            writeAck(conn, BROKER_PUBCOMP << 4, data);
+        }
+        break;
+
+    case BROKER_SUBSCRIBE:
+    case BROKER_UNSUBSCRIBE:
+    {
+        bool sub = (header >> 4) == BROKER_SUBSCRIBE;
+        vector<uint8_t> ack;
+        uint32_t pos = 2;
+        if ( len < 2 )
+        {
+            break;
+        }
+        while ( pos + 2 <= len )
+        {
+            uint16_t l = getUint16(data + pos);
+            if ( pos + 2 + l + (sub ? 1 : 0) > len )
+            {
+                break;
+            }
+            string filter((char*)data + pos + 2, l);
+            pos += 2 + l;
+            if ( sub )
+            {
+                conn->filters.push_back(filter);
+                ack.push_back(0);    // granted QoS 0
+                pos++;
+            }
+            else
+            {
+                for ( size_t i = 0; i < conn->filters.size(); i++ )
+                {
+                    if ( conn->filters[i] == filter )
+                    {
+                        conn->filters.erase(conn->filters.begin() + i);
+                        break;
+                    }
+                }
+            }
+        }
+        uint8_t hdr[4] = { (uint8_t)((sub ? BROKER_SUBACK : BROKER_UNSUBACK) << 4), (uint8_t)(2 + ack.size()), data[0], data[1] };
+        write(conn, hdr, 4);
+        if ( !ack.empty() )
+        {
+            write(conn, &ack[0], ack.size());
+        }
+        break;
+    }
+
+    case BROKER_PINGREQ:
+    {
+        uint8_t pingresp[2] = { BROKER_PINGRESP << 4, 0 };
+        write(conn, pingresp, 2);
+        _pings++;
+        break;
+    }
+
+    default:
+        break;
+    }
+}
+
+void LBrokerStandIn::forward(const uint8_t* topic, uint16_t topicLen, const uint8_t* payload, uint32_t payloadLen)
+{
+    for ( size_t i = 0; i < _conns.size(); i++ )
+    {
+        LBrokerConnection* conn = _conns[i];
+        for ( size_t j = 0; j < conn->filters.size(); j++ )
+        {
+            if ( !isMatch(conn->filters[j], (const char*)topic, topicLen) )
+            {
+                continue;
+            }
+            uint8_t hdr[8];
+            uint32_t remain = 2 + topicLen + payloadLen;
+            int l = 1;
+            hdr[0] = BROKER_PUBLISH << 4;
+            do
+            {
+                uint8_t b = remain % 128;
+                remain /= 128;
+                hdr[l++] = remain ? b | 0x80 : b;
+            } while ( remain );
+            setUint16(hdr + l, topicLen);
+            write(conn, hdr, l + 2);
+            write(conn, topic, topicLen);
+            write(conn, payload, payloadLen);
+            _forwarded++;
+            break;
+        }
+    }
+}
+
+/* Topic filters with + and # */
+bool LBrokerStandIn::isMatch(const string& filter, const char* topic, int len)
+{
+    size_t f = 0;
+    int t = 0;
+
+    while ( f < filter.size() )
+    {
+        if ( filter[f] == '#' )
+        {
+            return true;
+        }
+        if ( filter[f] == '+' )
+        {
+            while ( t < len && topic[t] != '/' )
+            {
+                t++;
+            }
+            f++;
+        }
+        else
+        {
+            if ( t >= len || filter[f] != topic[t] )
+            {
+                return false;
+            }
+            f++;
+            t++;
+        }
+    }
+    return t == len;
+}
+
+void LBrokerStandIn::report(void)
+{
+    printf("broker stand-in: %llu CONNECTs, %llu PUBLISHes received, %llu forwarded, %llu PINGREQs\n",
+            (unsigned long long)_connects, (unsigned long long)_published,
+            (unsigned long long)_forwarded, (unsigned long long)_pings);
+}
@@ -0,0 +1,72 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - broker stand-in for load tests
+ **************************************************************************************/
+
+#ifndef LBROKERSTANDIN_H_
+#define LBROKERSTANDIN_H_
+
+#include <vector>
+#include <string>
+
+#include "LMqttsnClientApp.h"
+
+using namespace std;
+
+namespace linuxAsyncClient {
+
+/*========================================
+       Class LBrokerStandIn
+
+ The least of an MQTT 3.1.1 broker the gateway needs for a load test.
+ Every packet is acknowledged at once, PUBLISHes are forwarded to the
+ matching subscriptions with QoS 0, and nothing is retained or stored.
+ One thread polls all connections.
+ =======================================*/
+class LBrokerStandIn{
+public:
+    LBrokerStandIn();
+    ~LBrokerStandIn();
+
+    bool open(uint16_t portNo);
+    void run(volatile bool* stop);
+    void report(void);
+
+private:
+    struct LBrokerConnection{
+        int fd;
+        vector<uint8_t> in;
+        vector<uint8_t> out;
+        vector<string> filters;
+    };
+
+    void accept(void);
+    bool read(LBrokerConnection* conn);
+    bool flush(LBrokerConnection* conn);
+    void handle(LBrokerConnection* conn, uint8_t header, uint8_t* data, uint32_t len);
+    void forward(const uint8_t* topic, uint16_t topicLen, const uint8_t* payload, uint32_t payloadLen);
+    void write(LBrokerConnection* conn, const uint8_t* data, uint32_t len);
+    void writeAck(LBrokerConnection* conn, uint8_t header, const uint8_t* packetId);
+    static bool isMatch(const string& filter, const char* topic, int len);
+
+    int _listener;
+    vector<LBrokerConnection*> _conns;
+    uint64_t _connects;
+    uint64_t _published;
+    uint64_t _forwarded;
+    uint64_t _pings;
+};
+
+}    /* end of namespace */
+#endif /* LBROKERSTANDIN_H_ */
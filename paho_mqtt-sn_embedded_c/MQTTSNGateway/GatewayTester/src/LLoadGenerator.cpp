@@ -0,0 +1,743 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - load generator
+ **************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <algorithm>
+
+#include "LLoadGenerator.h"
+
+using namespace std;
+using namespace linuxAsyncClient;
+
+extern void setUint16(uint8_t* pos, uint16_t val);
+extern uint16_t getUint16(const uint8_t* pos);
+
+#define LOADGEN_IDLE          0
+#define LOADGEN_CONNECTING    1
+#define LOADGEN_SUBSCRIBING   2
+#define LOADGEN_ACTIVE        3
+#define LOADGEN_SLEEPING      4
+#define LOADGEN_WAKING        5
+#define LOADGEN_DONE          6
+
+#define LOADGEN_DRAIN_USECS   2000000   // wait for the last acknowledgements
+
+namespace linuxAsyncClient {
+
+struct LInflight{
+    uint16_t msgId;
+    uint8_t  qos;
+    int      topic;
+    uint64_t sentAt;
+};
+
+struct LVirtualClient{
+    int       fd;
+    char      clientId[24];
+    uint8_t   status;
+    bool      subscriber;
+    bool      connected;        // connected once, the next CONNECTs keep the session
+    unsigned int seed;
+    uint16_t  nextMsgId;
+    uint64_t  timer;            // next CONNECT, PUBLISH or wake up
+    uint64_t  sentAt;           // the request that waits for a response
+    uint64_t  awakeUntil;
+    uint64_t  lastSend;
+    uint16_t* topicIds;
+    int       pendingTopic;     // picked for the next PUBLISH, -1: not picked yet
+    int       regTopic;         // waiting for REGACK, -1: none
+    uint16_t  regMsgId;
+    int       inflightCnt;
+    LInflight inflight[LOADGEN_MAX_INFLIGHT];
+};
+
+uint64_t getUsecs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+}
+
+static uint32_t percentile(vector<uint32_t>& v, double p)
+{
+    if ( v.empty() )
+    {
+        return 0;
+    }
+    size_t i = (size_t)(p * v.size());
+    return v[i < v.size() ? i : v.size() - 1];
+}
+
+static void printLatency(const char* name, vector<uint32_t>& v)
+{
+    sort(v.begin(), v.end());
+    printf("%s usecs: p50 %u  p90 %u  p99 %u  p99.9 %u  max %u\n", name,
+            percentile(v, 0.5), percentile(v, 0.9), percentile(v, 0.99), percentile(v, 0.999),
+            v.empty() ? 0 : v.back());
+}
+
+/*=====================================
+ Class LLoadGenerator
+ ======================================*/
+LLoadGenerator::LLoadGenerator()
+{
+    memset(&_config, 0, sizeof(_config));
+    _clients = 0;
+    _start = 0;
+    _publishStart = 0;
+    _publishEnd = 0;
+}
+
+LLoadGenerator::~LLoadGenerator()
+{
+    if ( _clients )
+    {
+        for ( int i = 0; i < _config.clients; i++ )
+        {
+            if ( _clients[i].fd >= 0 )
+            {
+                close(_clients[i].fd);
+            }
+            delete[] _clients[i].topicIds;
+        }
+        delete[] _clients;
+    }
+}
+
+bool LLoadGenerator::initialize(LLoadConfig* config)
+{
+    _config = *config;
+    if ( _config.clients <= 0 || _config.clients > LOADGEN_MAX_CLIENTS || _config.threads <= 0
+            || _config.threads > LOADGEN_MAX_THREADS || _config.topics <= 0 || _config.topics > LOADGEN_MAX_TOPICS
+            || _config.connectRate <= 0 || _config.publishRate <= 0
+            || _config.payloadSize < LOADGEN_TIMESTAMP_SIZE || _config.payloadSize > MQTTSN_MAX_PACKET_SIZE - 16
+            || _config.qos[0] + _config.qos[1] + _config.qos[2] != 100 )
+    {
+        fprintf(stderr, "Invalid load parameters.\n");
+        return false;
+    }
+    if ( _config.threads > _config.clients )
+    {
+        _config.threads = _config.clients;
+    }
+
+    double sum = 0;
+    for ( int i = 0; i < _config.topics; i++ )
+    {
+        sum += _config.zipf ? 1.0 / (i + 1) : 1.0;
+        _zipf[i] = sum;
+    }
+    for ( int i = 0; i < _config.topics; i++ )
+    {
+        _zipf[i] /= sum;
+    }
+
+    /* one socket for each client */
+    struct rlimit rl;
+    if ( getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < (rlim_t)_config.clients + 64 )
+    {
+        rl.rlim_cur = rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+
+    struct addrinfo hints;
+    struct addrinfo* gw = 0;
+    char port[8];
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    sprintf(port, "%u", _config.gwPortNo);
+    if ( getaddrinfo(_config.gwAddress, port, &hints, &gw) != 0 )
+    {
+        fprintf(stderr, "Unknown gateway %s\n", _config.gwAddress);
+        return false;
+    }
+
+    _clients = new LVirtualClient[_config.clients];
+    for ( int i = 0; i < _config.clients; i++ )
+    {
+        LVirtualClient* client = &_clients[i];
+        memset(client, 0, sizeof(LVirtualClient));
+        snprintf(client->clientId, sizeof(client->clientId), "%s%05d", _config.clientIdPrefix, i);
+        client->subscriber = i < _config.subscribers;
+        client->seed = i + 1;
+        client->pendingTopic = -1;
+        client->regTopic = -1;
+        client->topicIds = new uint16_t[_config.topics]();
+        client->fd = socket(AF_INET, SOCK_DGRAM, 0);
+        if ( client->fd < 0 || ::connect(client->fd, gw->ai_addr, gw->ai_addrlen) < 0
+                || fcntl(client->fd, F_SETFL, O_NONBLOCK) < 0 )
+        {
+            fprintf(stderr, "Can't open a socket for client %d, errno %d\n", i, errno);
+            freeaddrinfo(gw);
+            return false;
+        }
+    }
+    freeaddrinfo(gw);
+    return true;
+}
+
+bool LLoadGenerator::isPublishing(uint64_t now)
+{
+    return now < _publishEnd;
+}
+
+void LLoadGenerator::run(void)
+{
+    _start = getUsecs();
+    _publishStart = _start;
+    _publishEnd = _start + (uint64_t)_config.clients * 1000000 / _config.connectRate
+            + (uint64_t)_config.duration * 1000000;
+
+    for ( int i = 0; i < _config.clients; i++ )
+    {
+        _clients[i].timer = _start + (uint64_t)i * 1000000 / _config.connectRate;
+    }
+
+    for ( int i = 0; i < _config.threads; i++ )
+    {
+        _stats[i] = LLoadStats();
+        _workers[i].generator = this;
+        _workers[i].index = i;
+        pthread_create(&_threads[i], 0, LLoadGenerator::runWorker, &_workers[i]);
+    }
+    for ( int i = 0; i < _config.threads; i++ )
+    {
+        pthread_join(_threads[i], 0);
+    }
+}
+
+void* LLoadGenerator::runWorker(void* arg)
+{
+    LWorker* worker = (LWorker*)arg;
+    worker->generator->work(worker->index);
+    return 0;
+}
+
+/*
+ *  A worker owns every _config.threads-th client, polls their sockets and runs their timers.
+ */
+void LLoadGenerator::work(int worker)
+{
+    LLoadStats* stats = &_stats[worker];
+    vector<struct pollfd> fds;
+    vector<LVirtualClient*> clients;
+    uint8_t buf[MQTTSN_MAX_PACKET_SIZE + 1];
+
+    for ( int i = worker; i < _config.clients; i += _config.threads )
+    {
+        struct pollfd pfd;
+        pfd.fd = _clients[i].fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        fds.push_back(pfd);
+        clients.push_back(&_clients[i]);
+    }
+
+    uint64_t now = getUsecs();
+    while ( now < _publishEnd + LOADGEN_DRAIN_USECS )
+    {
+        poll(&fds[0], fds.size(), 1);
+        now = getUsecs();
+        for ( size_t i = 0; i < fds.size(); i++ )
+        {
+            if ( fds[i].revents & POLLIN )
+            {
+                int len;
+                while ( (len = ::recv(fds[i].fd, buf, sizeof(buf), MSG_DONTWAIT)) > 0 )
+                {
+                    receive(clients[i], buf, len, now, stats);
+                }
+            }
+        }
+
+        bool done = !isPublishing(now);
+        for ( size_t i = 0; i < clients.size(); i++ )
+        {
+            tick(clients[i], now, stats);
+            done = done && (clients[i]->status == LOADGEN_DONE || clients[i]->subscriber);
+        }
+        if ( done && now > _publishEnd + LOADGEN_DRAIN_USECS / 4 )
+        {
+            break;
+        }
+    }
+
+    /* the sessions end with the run */
+    for ( size_t i = 0; i < clients.size(); i++ )
+    {
+        if ( clients[i]->status != LOADGEN_DONE && clients[i]->status != LOADGEN_IDLE )
+        {
+            uint8_t msg[2] = { 2, MQTTSN_TYPE_DISCONNECT };
+            send(clients[i], msg, 2);
+        }
+    }
+}
+
+void LLoadGenerator::send(LVirtualClient* client, uint8_t* msg, int len)
+{
+    ::send(client->fd, msg, len, 0);
+    client->lastSend = getUsecs();
+}
+
+void LLoadGenerator::connect(LVirtualClient* client, bool cleanSession, uint64_t now)
+{
+    uint8_t msg[40];
+    int idLen = strlen(client->clientId);
+
+    msg[0] = 6 + idLen;
+    msg[1] = MQTTSN_TYPE_CONNECT;
+    msg[2] = cleanSession ? MQTTSN_FLAG_CLEAN : 0;
+    msg[3] = MQTTSN_PROTOCOL_ID;
+    setUint16(msg + 4, _config.keepAlive);
+    memcpy(msg + 6, client->clientId, idLen);
+    send(client, msg, msg[0]);
+    client->status = LOADGEN_CONNECTING;
+    client->sentAt = now;
+}
+
+int LLoadGenerator::pickTopic(LVirtualClient* client)
+{
+    double r = (double)rand_r(&client->seed) / ((double)RAND_MAX + 1);
+    return lower_bound(_zipf, _zipf + _config.topics, r) - _zipf;
+}
+
+int LLoadGenerator::pickQoS(LVirtualClient* client)
+{
+    int r = rand_r(&client->seed) % 100;
+    return r < _config.qos[0] ? 0 : r < _config.qos[0] + _config.qos[1] ? 1 : 2;
+}
+
+/*
+ *  Send the next PUBLISH, or the REGISTER of its topic first.
+ */
+void LLoadGenerator::publish(LVirtualClient* client, uint64_t now, LLoadStats* stats)
+{
+    uint8_t msg[MQTTSN_MAX_PACKET_SIZE];
+
+    if ( client->pendingTopic < 0 )
+    {
+        client->pendingTopic = pickTopic(client);
+    }
+    int topic = client->pendingTopic;
+
+    if ( client->topicIds[topic] == 0 )
+    {
+        if ( client->regTopic < 0 )
+        {
+            int len = sprintf((char*)msg + 6, LOADGEN_TOPIC_PREFIX "%d", topic) + 6;
+            msg[0] = len;
+            msg[1] = MQTTSN_TYPE_REGISTER;
+            setUint16(msg + 2, 0);
+            client->regMsgId = ++client->nextMsgId ? client->nextMsgId : ++client->nextMsgId;
+            setUint16(msg + 4, client->regMsgId);
+            send(client, msg, len);
+            client->regTopic = topic;
+            client->sentAt = now;
+            stats->registers++;
+        }
+        return;
+    }
+
+    int qos = pickQoS(client);
+    if ( qos > 0 && client->inflightCnt == LOADGEN_MAX_INFLIGHT )
+    {
+        return;
+    }
+
+    int len = 7 + _config.payloadSize;
+    int hdr = len < 256 ? 0 : 2;
+    uint8_t* p = msg + hdr;
+    if ( hdr )
+    {
+        msg[0] = 0x01;
+        setUint16(msg + 1, len + hdr);
+    }
+    else
+    {
+        msg[0] = len;
+    }
+    p[1] = MQTTSN_TYPE_PUBLISH;
+    p[2] = qos == 0 ? MQTTSN_FLAG_QOS_0 : qos == 1 ? MQTTSN_FLAG_QOS_1 : MQTTSN_FLAG_QOS_2;
+    setUint16(p + 3, client->topicIds[topic]);
+    uint16_t msgId = 0;
+    if ( qos > 0 )
+    {
+        msgId = ++client->nextMsgId ? client->nextMsgId : ++client->nextMsgId;
+    }
+    setUint16(p + 5, msgId);
+    memcpy(p + 7, &now, LOADGEN_TIMESTAMP_SIZE);
+    memset(p + 7 + LOADGEN_TIMESTAMP_SIZE, 'a' + topic % 26, _config.payloadSize - LOADGEN_TIMESTAMP_SIZE);
+    send(client, msg, len + hdr);
+    stats->sent[qos]++;
+
+    if ( qos > 0 )
+    {
+        LInflight* inf = &client->inflight[client->inflightCnt++];
+        inf->msgId = msgId;
+        inf->qos = qos;
+        inf->topic = topic;
+        inf->sentAt = now;
+    }
+    client->pendingTopic = -1;
+
+    /* keep the rate, but do not catch up after a stall */
+    client->timer += (uint64_t)(1000000 / _config.publishRate);
+    if ( client->timer + 1000000 < now )
+    {
+        client->timer = now;
+    }
+}
+
+void LLoadGenerator::tick(LVirtualClient* client, uint64_t now, LLoadStats* stats)
+{
+    switch ( client->status )
+    {
+    case LOADGEN_IDLE:
+        if ( now >= client->timer && isPublishing(now) )
+        {
+            connect(client, true, now);
+        }
+        break;
+
+    case LOADGEN_CONNECTING:
+    case LOADGEN_SUBSCRIBING:
+        if ( now - client->sentAt > LOADGEN_TIMEOUT_MSECS * 1000 )
+        {
+            stats->connectTimeouts++;
+            client->status = LOADGEN_IDLE;
+        }
+        break;
+
+    case LOADGEN_ACTIVE:
+        for ( int i = 0; i < client->inflightCnt; )
+        {
+            if ( now - client->inflight[i].sentAt > LOADGEN_TIMEOUT_MSECS * 1000 )
+            {
+                stats->timeouts++;
+                client->inflight[i] = client->inflight[--client->inflightCnt];
+            }
+            else
+            {
+                i++;
+            }
+        }
+        if ( client->regTopic >= 0 && now - client->sentAt > LOADGEN_TIMEOUT_MSECS * 1000 )
+        {
+            stats->timeouts++;
+            client->regTopic = -1;
+        }
+
+        if ( client->subscriber )
+        {
+            /* subscribers stay until the end */
+        }
+        else if ( !isPublishing(now) )
+        {
+            if ( client->inflightCnt == 0 )
+            {
+                uint8_t msg[2] = { 2, MQTTSN_TYPE_DISCONNECT };
+                send(client, msg, 2);
+                client->status = LOADGEN_DONE;
+            }
+            break;
+        }
+        else if ( _config.awakeSecs && now >= client->awakeUntil && client->inflightCnt == 0 && client->regTopic < 0 )
+        {
+            uint8_t msg[4] = { 4, MQTTSN_TYPE_DISCONNECT };
+            setUint16(msg + 2, _config.sleepSecs);
+            send(client, msg, 4);
+            client->status = LOADGEN_SLEEPING;
+            client->timer = now + (uint64_t)_config.sleepSecs * 1000000;
+            stats->sleeps++;
+            break;
+        }
+        else if ( now >= client->timer )
+        {
+            publish(client, now, stats);
+        }
+
+        if ( now > client->lastSend + (uint64_t)_config.keepAlive * 500000 )
+        {
+            uint8_t msg[2] = { 2, MQTTSN_TYPE_PINGREQ };
+            send(client, msg, 2);
+        }
+        break;
+
+    case LOADGEN_SLEEPING:
+    case LOADGEN_WAKING:
+        if ( client->status == LOADGEN_SLEEPING ? now >= client->timer : now - client->sentAt > LOADGEN_TIMEOUT_MSECS * 1000 )
+        {
+            if ( !isPublishing(now) )
+            {
+                client->status = LOADGEN_DONE;
+                break;
+            }
+            /* wake up to receive the stored messages, then go active again */
+            uint8_t msg[32];
+            int idLen = strlen(client->clientId);
+            msg[0] = 2 + idLen;
+            msg[1] = MQTTSN_TYPE_PINGREQ;
+            memcpy(msg + 2, client->clientId, idLen);
+            send(client, msg, msg[0]);
+            client->status = LOADGEN_WAKING;
+            client->sentAt = now;
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+void LLoadGenerator::receive(LVirtualClient* client, uint8_t* msg, int len, uint64_t now, LLoadStats* stats)
+{
+    uint8_t* p = msg[0] == 0x01 ? msg + 2 : msg;
+    int plen = msg[0] == 0x01 ? getUint16(msg + 1) - 2 : msg[0];
+    uint8_t reply[8];
+
+    if ( len < 2 || plen < 2 || plen > len )
+    {
+        return;
+    }
+
+    switch ( p[1] )
+    {
+    case MQTTSN_TYPE_CONNACK:
+        if ( client->status != LOADGEN_CONNECTING )
+        {
+            break;
+        }
+        if ( p[2] != MQTTSN_RC_ACCEPTED )
+        {
+            stats->connectTimeouts++;
+            client->status = LOADGEN_IDLE;
+            client->timer = now + 1000000;
+            break;
+        }
+        stats->connects++;
+        if ( !client->connected )
+        {
+            client->timer = now + rand_r(&client->seed) % (uint64_t)(1000000 / _config.publishRate + 1);
+            client->connected = true;
+        }
+        client->awakeUntil = now + (uint64_t)_config.awakeSecs * 1000000;
+        client->status = LOADGEN_ACTIVE;
+        if ( client->subscriber )
+        {
+            uint8_t sub[32];
+            int l = sprintf((char*)sub + 5, LOADGEN_TOPIC_PREFIX "#") + 5;
+            sub[0] = l;
+            sub[1] = MQTTSN_TYPE_SUBSCRIBE;
+            sub[2] = MQTTSN_FLAG_QOS_0 | MQTTSN_TOPIC_TYPE_NORMAL;
+            setUint16(sub + 3, ++client->nextMsgId);
+            send(client, sub, l);
+            client->status = LOADGEN_SUBSCRIBING;
+            client->sentAt = now;
+        }
+        break;
+
+    case MQTTSN_TYPE_SUBACK:
+        if ( client->status == LOADGEN_SUBSCRIBING )
+        {
+            client->status = LOADGEN_ACTIVE;
+        }
+        break;
+
+    case MQTTSN_TYPE_REGACK:
+        if ( plen >= 7 && client->regTopic >= 0 && getUint16(p + 4) == client->regMsgId )
+        {
+            if ( p[6] == MQTTSN_RC_ACCEPTED )
+            {
+                client->topicIds[client->regTopic] = getUint16(p + 2);
+            }
+            else
+            {
+                stats->rejected++;
+            }
+            client->regTopic = -1;
+        }
+        break;
+
+    case MQTTSN_TYPE_PUBACK:
+    case MQTTSN_TYPE_PUBREC:
+    case MQTTSN_TYPE_PUBCOMP:
+    {
+        if ( plen < (p[1] == MQTTSN_TYPE_PUBACK ? 6 : 4) )
+    {
+        break;
+    }
+    uint16_t msgId = getUint16(p + (p[1] == MQTTSN_TYPE_PUBACK ? 4 : 2));
+        for ( int i = 0; i < client->inflightCnt; i++ )
+        {
+            LInflight* inf = &client->inflight[i];
+            if ( inf->msgId != msgId )
+            {
+                continue;
+            }
+            if ( p[1] == MQTTSN_TYPE_PUBREC )
+            {
+                reply[0] = 4;
+                reply[1] = MQTTSN_TYPE_PUBREL;
+                setUint16(reply + 2, msgId);
+                send(client, reply, 4);
+                break;
+            }
+            if ( p[1] == MQTTSN_TYPE_PUBACK && (plen < 7 || p[6] != MQTTSN_RC_ACCEPTED) )
+            {
+                /* REJECTED_CONGESTED or an unknown topic, which is registered again */
+                stats->rejected++;
+                if ( p[6] == MQTTSN_RC_REJECTED_INVALID_TOPIC_ID )
+                {
+                    client->topicIds[inf->topic] = 0;
+                }
+            }
+            else
+            {
+                stats->acked++;
+                stats->ackLatency.push_back((uint32_t)(now - inf->sentAt));
+            }
+            *inf = client->inflight[--client->inflightCnt];
+            break;
+        }
+        break;
+    }
+
+    case MQTTSN_TYPE_REGISTER:
+        reply[0] = 7;
+        reply[1] = MQTTSN_TYPE_REGACK;
+        memcpy(reply + 2, p + 2, 4);   // TopicId and MsgId
+        reply[6] = MQTTSN_RC_ACCEPTED;
+        send(client, reply, 7);
+        break;
+
+    case MQTTSN_TYPE_PUBLISH:
+    {
+        int qos = (p[2] & MQTTSN_FLAG_QOS_M1) >> 5;
+        stats->received++;
+        if ( plen >= 7 + LOADGEN_TIMESTAMP_SIZE )
+        {
+            uint64_t sentAt;
+            memcpy(&sentAt, p + 7, LOADGEN_TIMESTAMP_SIZE);
+            if ( sentAt <= now )
+            {
+                stats->e2eLatency.push_back((uint32_t)(now - sentAt));
+            }
+        }
+        if ( qos == 1 )
+        {
+            reply[0] = 7;
+            reply[1] = MQTTSN_TYPE_PUBACK;
+            memcpy(reply + 2, p + 3, 4);
+            reply[6] = MQTTSN_RC_ACCEPTED;
+            send(client, reply, 7);
+        }
+        else if ( qos == 2 )
+        {
+            reply[0] = 4;
+            reply[1] = MQTTSN_TYPE_PUBREC;
+            memcpy(reply + 2, p + 5, 2);
+            send(client, reply, 4);
+        }
+        break;
+    }
+
+    case MQTTSN_TYPE_PUBREL:
+        reply[0] = 4;
+        reply[1] = MQTTSN_TYPE_PUBCOMP;
+        memcpy(reply + 2, p + 2, 2);
+        send(client, reply, 4);
+        break;
+
+    case MQTTSN_TYPE_PINGRESP:
+        if ( client->status == LOADGEN_WAKING )
+        {
+            connect(client, false, now);
+        }
+        break;
+
+    case MQTTSN_TYPE_DISCONNECT:
+        if ( client->status == LOADGEN_ACTIVE || client->status == LOADGEN_SUBSCRIBING )
+        {
+            /* the gateway lost the session, start it again */
+            client->status = LOADGEN_IDLE;
+            client->timer = now;
+            client->inflightCnt = 0;
+            client->regTopic = -1;
+            memset(client->topicIds, 0, sizeof(uint16_t) * _config.topics);
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+void LLoadGenerator::report(void)
+{
+    LLoadStats total = LLoadStats();
+    double secs = (_publishEnd - _publishStart) / 1e6;
+
+    for ( int i = 0; i < _config.threads; i++ )
+    {
+        LLoadStats* s = &_stats[i];
+        total.connects += s->connects;
+        total.connectTimeouts += s->connectTimeouts;
+        for ( int q = 0; q < 3; q++ )
+        {
+            total.sent[q] += s->sent[q];
+        }
+        total.acked += s->acked;
+        total.rejected += s->rejected;
+        total.timeouts += s->timeouts;
+        total.registers += s->registers;
+        total.received += s->received;
+        total.sleeps += s->sleeps;
+        total.ackLatency.insert(total.ackLatency.end(), s->ackLatency.begin(), s->ackLatency.end());
+        total.e2eLatency.insert(total.e2eLatency.end(), s->e2eLatency.begin(), s->e2eLatency.end());
+    }
+    uint32_t sent = total.sent[0] + total.sent[1] + total.sent[2];
+
+    printf("clients %d (%d subscribers), threads %d, %.1f secs, %d topics %s, payload %d bytes\n",
+            _config.clients, _config.subscribers, _config.threads, secs, _config.topics,
+            _config.zipf ? "zipf" : "uniform", _config.payloadSize);
+    printf("CONNACK %u, connect failures %u, REGISTER %u, sleeps %u\n",
+            total.connects, total.connectTimeouts, total.registers, total.sleeps);
+    printf("PUBLISH sent %u (QoS0 %u, QoS1 %u, QoS2 %u) %.1f/sec\n",
+            sent, total.sent[0], total.sent[1], total.sent[2], sent / secs);
+    printf("acknowledged %u %.1f/sec, rejected %u, timeouts %u\n",
+            total.acked, total.acked / secs, total.rejected, total.timeouts);
+    printLatency("ack latency", total.ackLatency);
+    if ( _config.subscribers )
+    {
+        printf("received by subscribers %u %.1f/sec\n", total.received, total.received / secs);
+        printLatency("end-to-end latency", total.e2eLatency);
+    }
+}
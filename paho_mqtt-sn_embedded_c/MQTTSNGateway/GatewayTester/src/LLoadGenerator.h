@@ -0,0 +1,125 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - load generator
+ **************************************************************************************/
+
+#ifndef LLOADGENERATOR_H_
+#define LLOADGENERATOR_H_
+
+#include <pthread.h>
+#include <stdint.h>
+#include <vector>
+
+#include "LMqttsnClientApp.h"
+
+#define LOADGEN_MAX_CLIENTS       100000
+#define LOADGEN_MAX_THREADS           64
+#define LOADGEN_MAX_TOPICS          1000
+#define LOADGEN_MAX_INFLIGHT     MAX_INFLIGHT_MSG
+#define LOADGEN_TIMEOUT_MSECS   (MQTTSN_TIME_RETRY * 1000)
+#define LOADGEN_TOPIC_PREFIX     "loadgen/topic/"
+#define LOADGEN_TIMESTAMP_SIZE        8   // send time in usecs at the top of every payload
+
+using namespace std;
+
+namespace linuxAsyncClient {
+
+/*========================================
+       Load parameters
+ =======================================*/
+struct LLoadConfig{
+    const char* gwAddress;
+    uint16_t gwPortNo;
+    const char* clientIdPrefix;
+    int      clients;
+    int      threads;
+    int      connectRate;     // CONNECTs per second
+    double   publishRate;     // PUBLISHes per second of each client
+    int      qos[3];          // percentage of PUBLISHes with QoS 0, 1 and 2
+    int      awakeSecs;       // sleep cycle, 0: never sleep
+    int      sleepSecs;
+    int      topics;
+    bool     zipf;            // topics are picked with a Zipf distribution, uniformly otherwise
+    int      subscribers;     // clients that subscribe to all topics
+    int      payloadSize;
+    int      duration;        // seconds of publishing
+    uint16_t keepAlive;
+};
+
+/*========================================
+       Results of a worker
+ =======================================*/
+struct LLoadStats{
+    uint32_t connects;
+    uint32_t connectTimeouts;
+    uint32_t sent[3];
+    uint32_t acked;
+    uint32_t rejected;
+    uint32_t timeouts;
+    uint32_t registers;
+    uint32_t received;
+    uint32_t sleeps;
+    vector<uint32_t> ackLatency;     // PUBLISH to PUBACK or PUBCOMP, usecs
+    vector<uint32_t> e2eLatency;     // PUBLISH to the PUBLISH received by a subscriber, usecs
+};
+
+struct LVirtualClient;
+
+/*========================================
+       Class LLoadGenerator
+
+ Virtual MQTT-SN clients of a gateway, shared by a few threads.
+ Each client has its own UDP socket, so the gateway sees it as a node of its own.
+ =======================================*/
+class LLoadGenerator{
+public:
+    LLoadGenerator();
+    ~LLoadGenerator();
+
+    bool initialize(LLoadConfig* config);
+    void run(void);
+    void report(void);
+
+private:
+    static void* runWorker(void* arg);
+    void work(int worker);
+    void tick(LVirtualClient* client, uint64_t now, LLoadStats* stats);
+    void receive(LVirtualClient* client, uint8_t* msg, int len, uint64_t now, LLoadStats* stats);
+    void publish(LVirtualClient* client, uint64_t now, LLoadStats* stats);
+    void connect(LVirtualClient* client, bool cleanSession, uint64_t now);
+    void send(LVirtualClient* client, uint8_t* msg, int len);
+    int  pickTopic(LVirtualClient* client);
+    int  pickQoS(LVirtualClient* client);
+    bool isPublishing(uint64_t now);
+
+    struct LWorker{
+        LLoadGenerator* generator;
+        int index;
+    };
+
+    LLoadConfig _config;
+    LVirtualClient* _clients;
+    LLoadStats _stats[LOADGEN_MAX_THREADS];
+    pthread_t _threads[LOADGEN_MAX_THREADS];
+    LWorker _workers[LOADGEN_MAX_THREADS];
+    double _zipf[LOADGEN_MAX_TOPICS];     // cumulative probabilities of the topics
+    uint64_t _start;
+    uint64_t _publishStart;
+    uint64_t _publishEnd;
+};
+
+uint64_t getUsecs(void);
+
+}    /* end of namespace */
+#endif /* LLOADGENERATOR_H_ */
@@ -94,6 +94,8 @@ void MQTTGWConnectionHandler::handleDisconnect(Client* client, MQTTGWPacket* pac
 		snPacket->setDISCONNECT(0);
 		client->disconnected();
 		client->getNetwork()->close();
+		_gateway->getLocalRouter()->disconnected(client);
+		_gateway->getDuplicateFilter()->erase(client);
 		Event* ev1 = new Event();
 		ev1->setClientSendEvent(client, snPacket);
 }
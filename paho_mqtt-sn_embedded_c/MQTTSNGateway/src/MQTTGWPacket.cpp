@@ -240,6 +240,17 @@ int MQTTGWPacket::send(Network* network)
 
 }
 
+/*
+ *  Queue the packet on the network to be written with the following ones, see Network::queue().
+ *  It goes through the session, that writes it in the form of the broker connection.
+ */
+int MQTTGWPacket::queue(Network* network, MQTTGWv5Session* session, uint32_t latency)
+{
+	unsigned char buf[MQTTSNGW_MAX_PACKET_SIZE];
+	int len = getPacketData(buf);
+	return session->queue(network, buf, len, latency);
+}
+
 int MQTTGWPacket::getAck(Ack* ack)
 {
 	if (PUBACK != _header.bits.type && PUBREC != _header.bits.type && PUBREL != _header.bits.type
@@ -253,6 +264,19 @@ int MQTTGWPacket::getAck(Ack* ack)
 	return 1;
 }
 
+/*
+ *  @return the reason code of an ack received from an MQTT v5 broker, 0 if it has none.
+ */
+int MQTTGWPacket::getReasonCode(void)
+{
+	if (PUBACK != _header.bits.type && PUBREC != _header.bits.type && PUBREL != _header.bits.type
+			&& PUBCOMP != _header.bits.type)
+	{
+		return 0;
+	}
+	return _remainingLength > 2 ? _data[2] : 0;
+}
+
 int MQTTGWPacket::getCONNACK(Connack* resp)
 {
 	if (_header.bits.type != CONNACK)
@@ -308,10 +332,21 @@ int MQTTGWPacket::setCONNECT(Connect* connect, unsigned char* username, unsigned
 	clearData();
 	_header = connect->header;
 
+	/* MQTT v5, a Session Expiry Interval that keeps the session as a clean session 0 does in 3.1.1 */
+	int propLen = (connect->version == 5 && !connect->flags.bits.cleanstart) ? 5 : 0;
+
 	_remainingLength = ((connect->version == 3) ? 12 : 10) + (int)strlen(connect->clientID) + 2;
+	if (connect->version == 5)
+	{
+		_remainingLength += 1 + propLen;
+	}
 	if (connect->flags.bits.will)
 	{
 		_remainingLength += (int)strlen(connect->willTopic) + 2 + (int)strlen(connect->willMsg) + 2;
+		if (connect->version == 5)
+		{
+			_remainingLength += 1;
+		}
 	}
 	if ( connect->flags.bits.username )
 	{
@@ -335,6 +370,11 @@ int MQTTGWPacket::setCONNECT(Connect* connect, unsigned char* username, unsigned
 		writeUTF(&ptr, "MQTT");
 		writeChar(&ptr, (char) 4);
 	}
+	else if (connect->version == 5)
+	{
+		writeUTF(&ptr, "MQTT");
+		writeChar(&ptr, (char) 5);
+	}
 	else
 	{
 		return 0;
@@ -342,9 +382,23 @@ int MQTTGWPacket::setCONNECT(Connect* connect, unsigned char* username, unsigned
 
 	writeChar(&ptr, connect->flags.all);
 	writeInt(&ptr, connect->keepAliveTimer);
+	if (connect->version == 5)
+	{
+		writeChar(&ptr, (char) propLen);
+		if (propLen)
+		{
+			writeChar(&ptr, (char) MQTTV5_PROPERTY_SESSION_EXPIRY_INTERVAL);
+			writeInt(&ptr, 0xFFFF);
+			writeInt(&ptr, 0xFFFF);
+		}
+	}
 	writeUTF(&ptr, connect->clientID);
 	if (connect->flags.bits.will)
 	{
+		if (connect->version == 5)
+		{
+			writeChar(&ptr, (char) 0);    // will properties
+		}
 		writeUTF(&ptr, connect->willTopic);
 		writeUTF(&ptr, connect->willMsg);
 	}
@@ -21,6 +21,7 @@
 #define MQTTGWPACKET_H_
 
 #include "Network.h"
+#include "MQTTGWv5Session.h"
 
 namespace MQTTSNGW
 {
@@ -76,6 +77,23 @@ enum MQTT_connackCodes{
 	MQTT_NOT_AUTHORIZED
 };
 
+/**
+ * MQTT v5 reason codes the gateway acts on.
+ */
+enum MQTTv5_reasonCodes{
+	MQTTV5_RC_UNSUPPORTED_PROTOCOL_VERSION = 0x84,
+	MQTTV5_RC_CLIENT_IDENTIFIER_NOT_VALID = 0x85,
+	MQTTV5_RC_BAD_USER_NAME_OR_PASSWORD = 0x86,
+	MQTTV5_RC_NOT_AUTHORIZED = 0x87,
+	MQTTV5_RC_SERVER_UNAVAILABLE = 0x88,
+	MQTTV5_RC_SERVER_BUSY = 0x89,
+	MQTTV5_RC_TOPIC_FILTER_INVALID = 0x8F,
+	MQTTV5_RC_TOPIC_NAME_INVALID = 0x90,
+	MQTTV5_RC_RECEIVE_MAXIMUM_EXCEEDED = 0x93,
+	MQTTV5_RC_TOPIC_ALIAS_INVALID = 0x94,
+	MQTTV5_RC_QUOTA_EXCEEDED = 0x97
+};
+
 typedef struct
 {
 	Header header;	/**< MQTT header byte */
@@ -199,17 +217,20 @@ typedef struct
  */
 class MQTTGWPacket
 {
+	friend class MQTTGWv5Session;
 public:
 	MQTTGWPacket();
 	~MQTTGWPacket();
 	int recv(Network* network);
 	int send(Network* network);
+	int queue(Network* network, MQTTGWv5Session* session, uint32_t latency);
 	int getType(void);
 	int getPacketData(unsigned char* buf);
 	int getPacketLength(void);
 	const char* getName(void);
 
 	int getAck(Ack* ack);
+	int getReasonCode(void);
 	int getCONNACK(Connack* resp);
 	int getSUBACK(unsigned short* msgId, unsigned char* rc);
 	int getPUBLISH(Publish* pub);
@@ -25,6 +25,25 @@ using namespace MQTTSNGW;
 
 char* currentDateTime(void);
 
+/*
+ *  MQTT-SN return code of a PUBLISH rejected by an MQTT v5 broker.
+ */
+static uint8_t rejectedReturnCode(int reasonCode)
+{
+	switch (reasonCode)
+	{
+	case MQTTV5_RC_QUOTA_EXCEEDED:
+	case MQTTV5_RC_SERVER_BUSY:
+	case MQTTV5_RC_RECEIVE_MAXIMUM_EXCEEDED:
+		return MQTTSN_RC_REJECTED_CONGESTED;
+	case MQTTV5_RC_TOPIC_NAME_INVALID:
+	case MQTTV5_RC_NOT_AUTHORIZED:
+		return MQTTSN_RC_REJECTED_INVALID_TOPIC_ID;
+	default:
+		return MQTTSN_RC_NOT_SUPPORTED;
+	}
+}
+
 MQTTGWPublishHandler::MQTTGWPublishHandler(Gateway* gateway)
 {
 	_gateway = gateway;
@@ -43,12 +62,23 @@ void MQTTGWPublishHandler::handlePublish(Client* client, MQTTGWPacket* packet)
 		return;
 	}
 
+	Publish pub;
+	packet->getPUBLISH(&pub);
+
+	/* keep the retained message cache in step, the copy of a message the client was served by the gateway is dropped */
+	if ( _gateway->getRetainedCache()->update(client, pub.topic, pub.topiclen, (uint8_t*)pub.payload, pub.payloadlen, pub.header.bits.retain)
+			&& pub.header.bits.qos < 2 )
+	{
+		if (pub.header.bits.qos == 1)
+		{
+			replyACK(client, &pub, PUBACK);
+		}
+		return;
+	}
+
 	/* client is sleeping. save PUBLISH */
 	if ( client->isSleep() )
 	{
-		Publish pub;
-		packet->getPUBLISH(&pub);
-
 		WRITELOG(FORMAT_Y_G_G, currentDateTime(), packet->getName(),
 		RIGHTARROW, client->getClientId(), "is sleeping. a message was saved.");
 
@@ -73,9 +103,6 @@ void MQTTGWPublishHandler::handlePublish(Client* client, MQTTGWPacket* packet)
 		return;
 	}
 
-	Publish pub;
-	packet->getPUBLISH(&pub);
-
 	MQTTSNPacket* snPacket = new MQTTSNPacket();
 
 	/* create MQTTSN_topicid */
@@ -124,7 +151,7 @@ void MQTTGWPublishHandler::handlePublish(Client* client, MQTTGWPacket* packet)
 
 			/* add the Topic and get a TopicId */
 			topic = client->getTopics()->add(&topicId);
-			id = topic->getTopicId();
+			id = topic ? topic->getTopicId() : 0;   // nullptr when the client has MAX_TOPIC_PAR_CLIENT topics already
 
 			if (id > 0)
 			{
@@ -181,11 +208,21 @@ void MQTTGWPublishHandler::handlePuback(Client* client, MQTTGWPacket* packet)
 {
 	Ack ack;
 	packet->getAck(&ack);
+	_gateway->getAdapterManager()->getCarrier(client)->getNetwork()->addInflight(-1);
 	TopicIdMapElement* topicId = client->getWaitedPubTopicId((uint16_t)ack.msgId);
 	if (topicId)
 	{
+		/* an MQTT v5 broker tells why it rejects the PUBLISH, the client gets it at once */
+		int reasonCode = packet->getReasonCode();
+		uint8_t rc = MQTTSN_RC_ACCEPTED;
+		if (reasonCode >= 0x80)
+		{
+			rc = rejectedReturnCode(reasonCode);
+			WRITELOG("%s PUBLISH of %s is rejected by the broker, reason code 0x%02X.%s\n", ERRMSG_HEADER, client->getClientId(), reasonCode, ERRMSG_FOOTER);
+		}
 		MQTTSNPacket* mqttsnPacket = new MQTTSNPacket();
-		mqttsnPacket->setPUBACK(topicId->getTopicId(), (uint16_t)ack.msgId, 0);
+		mqttsnPacket->setPUBACK(topicId->getTopicId(), (uint16_t)ack.msgId, rc);
+		_gateway->getDuplicateFilter()->acked(client, (uint16_t)ack.msgId, rc);
 
 		client->eraseWaitedPubTopicId((uint16_t)ack.msgId);
 		Event* ev1 = new Event();
@@ -200,6 +237,16 @@ void MQTTGWPublishHandler::handleAck(Client* client, MQTTGWPacket* packet, int t
 {
 	Ack ack;
 	packet->getAck(&ack);
+	if (type == PUBREC && packet->getReasonCode() >= 0x80)
+	{
+		/* the QoS 2 flow ends here, answered like a rejected QoS 1 PUBLISH */
+		handlePuback(client, packet);
+		return;
+	}
+	if (type == PUBCOMP)
+	{
+		_gateway->getAdapterManager()->getCarrier(client)->getNetwork()->addInflight(-1);
+	}
 
 	if ( client->isActive() || client->isAwake() )
 	{
@@ -288,7 +335,7 @@ void MQTTGWPublishHandler::handleAggregatePublish(Client* client, MQTTGWPacket*
 
 	string* topicName = new string(pub.topic, pub.topiclen);
 	Topic topic = Topic(topicName, MQTTSN_TOPIC_TYPE_NORMAL);
-	AggregateTopicElement* list = _gateway->getAdapterManager()->createClientList(&topic);
+	AggregateTopicElement* list = _gateway->getAdapterManager()->createClientList(&topic, client);
 	if ( list != nullptr )
 	{
 		ClientTopicElement* p = list->getFirstElement();
@@ -38,13 +38,36 @@ void MQTTGWSubscribeHandler::handleSuback(Client* client, MQTTGWPacket* packet)
 	int qos = 0;
 
 	packet->getSUBACK(&msgId, &rc);
+	_gateway->getLocalRouter()->confirm(client, msgId, rc < 0x80);
+
 	TopicIdMapElement* topicId = client->getWaitedSubTopicId(msgId);
 
-	if (topicId)
+	if (topicId && topicId->isAcked())
+	{
+		client->eraseWaitedSubTopicId(msgId);
+		if (rc >= 0x80)
+		{
+			/* the client was told ACCEPTED and served the retained message, the subscription is gone */
+			WRITELOG("%s The broker rejected the SUBSCRIBE of %s answered from the retained cache.%s\n", ERRMSG_HEADER, client->getClientId(), ERRMSG_FOOTER);
+			_gateway->getRetainedCache()->forget(client);
+			disconnect(client);
+		}
+	}
+	else if (topicId)
 	{
 		MQTTSNPacket* snPacket = new MQTTSNPacket();
 
-		if (rc == 0x80)
+		if (rc == MQTTV5_RC_QUOTA_EXCEEDED)
+		{
+			/* MQTT v5 reason codes, 0x80 in 3.1.1 */
+			returnCode = MQTTSN_RC_REJECTED_CONGESTED;
+		}
+		else if (rc == 0x9E || rc == 0xA1 || rc == 0xA2)
+		{
+			/* shared, subscription identifiers or wildcard subscriptions not supported */
+			returnCode = MQTTSN_RC_NOT_SUPPORTED;
+		}
+		else if (rc >= 0x80)
 		{
 			returnCode = MQTTSN_RC_REJECTED_INVALID_TOPIC_ID;
 		}
@@ -61,6 +84,24 @@ void MQTTGWSubscribeHandler::handleSuback(Client* client, MQTTGWPacket* packet)
 	}
 }
 
+/*
+ *  End the sessions of the client with the broker and the gateway, it subscribes again once reconnected.
+ */
+void MQTTGWSubscribeHandler::disconnect(Client* client)
+{
+	MQTTGWPacket* mqMsg = new MQTTGWPacket();
+	mqMsg->setHeader(DISCONNECT);
+	Event* ev = new Event();
+	ev->setBrokerSendEvent(client, mqMsg);
+	_gateway->getBrokerSendQue()->post(ev);
+
+	MQTTSNPacket* snMsg = new MQTTSNPacket();
+	snMsg->setDISCONNECT(0);
+	Event* evt = new Event();
+	evt->setClientSendEvent(client, snMsg);
+	_gateway->getClientSendQue()->post(evt);
+}
+
 void MQTTGWSubscribeHandler::handleUnsuback(Client* client, MQTTGWPacket* packet)
 {
 	Ack ack;
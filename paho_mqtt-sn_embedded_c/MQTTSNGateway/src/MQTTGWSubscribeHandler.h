@@ -35,6 +35,7 @@ public:
 	void handleAggregateUnsuback(Client* client, MQTTGWPacket* packet);
 
 private:
+	void disconnect(Client* client);
 	Gateway* _gateway;
 };
 
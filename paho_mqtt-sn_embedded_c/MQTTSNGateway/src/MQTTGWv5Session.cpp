@@ -0,0 +1,480 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - MQTT v5 connection to the broker
+ **************************************************************************************/
+
+#include "MQTTGWv5Session.h"
+#include "MQTTGWPacket.h"
+#include "MQTTSNGateway.h"
+#include "Network.h"
+#include <stdlib.h>
+#include <string.h>
+
+using namespace MQTTSNGW;
+
+int MQTTPacket_encode(char* buf, int length);
+
+/*
+ *  Decode a Variable Byte Integer.
+ *  @return the number of bytes it takes, -1 if it runs past end.
+ */
+static int decodeVarint(const uint8_t* ptr, const uint8_t* end, int* value)
+{
+    int multiplier = 1;
+    int len = 0;
+    *value = 0;
+    do
+    {
+        if ( ptr + len >= end || len == 4 )
+        {
+            return -1;
+        }
+        *value += (ptr[len] & 127) * multiplier;
+        multiplier *= 128;
+    } while ( (ptr[len++] & 128) != 0 );
+    return len;
+}
+
+/*
+ *  @return the length of the value of a property, -1 if the property is unknown or runs past end.
+ */
+static int propertyValueLength(uint8_t id, const uint8_t* ptr, const uint8_t* end)
+{
+    int len = -1;
+    int value;
+
+    switch ( id )
+    {
+    case 0x01: case 0x17: case 0x19: case 0x24: case 0x25: case 0x28: case 0x29: case 0x2A:
+        len = 1;
+        break;
+    case 0x13: case 0x21: case 0x22: case 0x23:
+        len = 2;
+        break;
+    case 0x02: case 0x11: case 0x18: case 0x27:
+        len = 4;
+        break;
+    case 0x0B:
+        len = decodeVarint(ptr, end, &value);
+        break;
+    case 0x03: case 0x08: case 0x09: case 0x12: case 0x15: case 0x16: case 0x1A: case 0x1C: case 0x1F:
+        len = ptr + 2 <= end ? 2 + ((ptr[0] << 8) | ptr[1]) : -1;
+        break;
+    case 0x26:   // user property, a pair of strings
+        len = ptr + 2 <= end ? 2 + ((ptr[0] << 8) | ptr[1]) : -1;
+        if ( len > 0 && ptr + len + 2 <= end )
+        {
+            len += 2 + ((ptr[len] << 8) | ptr[len + 1]);
+        }
+        else
+        {
+            len = -1;
+        }
+        break;
+    default:
+        break;
+    }
+    return ( len >= 0 && ptr + len <= end ) ? len : -1;
+}
+
+/*=====================================
+ Class MQTTGWv5Session
+ =====================================*/
+MQTTGWv5Session::MQTTGWv5Session()
+{
+
+}
+
+MQTTGWv5Session::~MQTTGWv5Session()
+{
+    reset(false);
+}
+
+/*
+ *  Forget the aliases of the previous connection.
+ */
+void MQTTGWv5Session::reset(bool v5)
+{
+    for ( uint32_t i = 0; i < _table.getSize(); i++ )
+    {
+        MQTTGWv5Alias* p = _table.getBucket(i);
+        while ( p )
+        {
+            MQTTGWv5Alias* next = p->_next;
+            free(p->_topic);
+            delete p;
+            p = next;
+        }
+    }
+    _table.clear();
+    _v5 = v5;
+    _receiveMaximum = 0;
+    _topicAliasMaximum = 0;
+}
+
+/*
+ *  Queue a packet in the MQTT 3.1.1 form on the network, see Network::queue().
+ *  It is converted to the v5 form while the connection speaks v5.
+ *  The session stays locked until the packet is queued, so that the aliases
+ *  reach the broker in the order they are assigned.
+ *  With nowait, a packet that does not fit is refused before it is given an alias.
+ */
+int MQTTGWv5Session::queue(Network* network, const uint8_t* frame, int length, uint32_t latency, bool* first, bool nowait)
+{
+    int rc;
+    _mutex.lock();
+    if ( !_v5 && (frame[0] >> 4) != CONNECT )
+    {
+        rc = network->queue(frame, length, latency, first, nowait);
+    }
+    else if ( nowait && !network->hasRoom(length + 8) )
+    {
+        rc = 0;
+    }
+    else
+    {
+        uint8_t buf[MQTTSNGW_MAX_PACKET_SIZE + 8];
+        int len = encode(frame, length, buf, sizeof(buf));
+        rc = len < 0 ? -2 : network->queue(buf, len, latency, first, nowait);
+    }
+    _mutex.unlock();
+    return rc;
+}
+
+/*
+ *  Convert a packet in the MQTT 3.1.1 form into the form of the connection.
+ *  PUBLISHes get an alias property, and lose their topic name when the broker
+ *  has the alias already. SUBSCRIBE and UNSUBSCRIBE get empty properties.
+ *  The acks, PINGREQ and DISCONNECT are the same in both versions.
+ *  @return the length written to buf, -1 if the packet is malformed or does not fit.
+ */
+int MQTTGWv5Session::encode(const uint8_t* frame, int length, uint8_t* buf, int bufLen)
+{
+    int remainingLength;
+    int hdrLen = decodeVarint(frame + 1, frame + length, &remainingLength);
+    if ( hdrLen < 0 || 1 + hdrLen + remainingLength != length )
+    {
+        return -1;
+    }
+    hdrLen++;
+    const uint8_t* body = frame + hdrLen;
+    uint8_t type = frame[0] >> 4;
+
+    if ( type == CONNECT && remainingLength > 2 && 3 + ((body[0] << 8) | body[1]) <= remainingLength )
+    {
+        reset(body[2 + ((body[0] << 8) | body[1])] == 5);
+    }
+
+    if ( !_v5 || (type != PUBLISH && type != SUBSCRIBE && type != UNSUBSCRIBE) )
+    {
+        if ( length > bufLen )
+        {
+            return -1;
+        }
+        memcpy(buf, frame, length);
+        return length;
+    }
+
+    char lenBuf[4];
+    uint8_t* ptr = buf;
+
+    if ( type == PUBLISH )
+    {
+        if ( remainingLength < 2 )
+        {
+            return -1;
+        }
+        uint16_t topicLen = (body[0] << 8) | body[1];
+        int idLen = ((frame[0] >> 1) & 0x03) ? 2 : 0;
+        int payloadLen = remainingLength - 2 - topicLen - idLen;
+        if ( payloadLen < 0 )
+        {
+            return -1;
+        }
+
+        bool sendTopic = true;
+        uint16_t alias = 0;
+        if ( _topicAliasMaximum )
+        {
+            alias = getAlias((const char*)body + 2, topicLen, &sendTopic);
+        }
+
+        int propLen = alias ? 3 : 0;
+        int newLength = 2 + (sendTopic ? topicLen : 0) + idLen + 1 + propLen + payloadLen;
+        int lenLen = MQTTPacket_encode(lenBuf, newLength);
+        if ( 1 + lenLen + newLength > bufLen )
+        {
+            return -1;
+        }
+
+        *ptr++ = frame[0];
+        memcpy(ptr, lenBuf, lenLen);
+        ptr += lenLen;
+        if ( sendTopic )
+        {
+            memcpy(ptr, body, 2 + topicLen);
+            ptr += 2 + topicLen;
+        }
+        else
+        {
+            *ptr++ = 0;
+            *ptr++ = 0;
+        }
+        memcpy(ptr, body + 2 + topicLen, idLen);
+        ptr += idLen;
+        *ptr++ = (uint8_t)propLen;
+        if ( alias )
+        {
+            *ptr++ = MQTTV5_PROPERTY_TOPIC_ALIAS;
+            *ptr++ = (uint8_t)(alias >> 8);
+            *ptr++ = (uint8_t)alias;
+        }
+        memcpy(ptr, body + 2 + topicLen + idLen, payloadLen);
+        return 1 + lenLen + newLength;
+    }
+
+    /* SUBSCRIBE and UNSUBSCRIBE, properties after the packet identifier */
+    if ( remainingLength < 2 )
+    {
+        return -1;
+    }
+    int lenLen = MQTTPacket_encode(lenBuf, remainingLength + 1);
+    if ( 1 + lenLen + remainingLength + 1 > bufLen )
+    {
+        return -1;
+    }
+    *ptr++ = frame[0];
+    memcpy(ptr, lenBuf, lenLen);
+    ptr += lenLen;
+    *ptr++ = body[0];
+    *ptr++ = body[1];
+    *ptr++ = 0;
+    memcpy(ptr, body + 2, remainingLength - 2);
+    return 1 + lenLen + remainingLength + 1;
+}
+
+/*
+ *  Convert a packet received from a v5 broker into the MQTT 3.1.1 form, in place.
+ *  The reason codes of PUBACK, PUBREC, PUBREL, PUBCOMP and SUBACK are kept,
+ *  see MQTTGWPacket::getReasonCode(), a CONNACK's one becomes the 3.1.1 return code.
+ *  @return false if the packet is malformed.
+ */
+bool MQTTGWv5Session::translate(MQTTGWPacket* packet)
+{
+    if ( !_v5 )
+    {
+        return true;
+    }
+
+    uint8_t* data = packet->_data;
+    uint8_t* end = data + packet->_remainingLength;
+    int propLen;
+
+    switch ( packet->getType() )
+    {
+    case CONNACK:
+        if ( packet->_remainingLength < 2 )
+        {
+            return false;
+        }
+        _mutex.lock();
+        _receiveMaximum = 65535;
+        _topicAliasMaximum = 0;
+        propLen = packet->_remainingLength > 2 ? readProperties(data + 2, end, true) : 0;
+        _mutex.unlock();
+        if ( propLen < 0 )
+        {
+            return false;
+        }
+        switch ( data[1] )
+        {
+        case 0:
+            break;
+        case MQTTV5_RC_UNSUPPORTED_PROTOCOL_VERSION:
+            data[1] = MQTT_UNACCEPTABLE_PROTOCOL_VERSION;
+            break;
+        case MQTTV5_RC_CLIENT_IDENTIFIER_NOT_VALID:
+            data[1] = MQTT_IDENTIFIER_REJECTED;
+            break;
+        case MQTTV5_RC_BAD_USER_NAME_OR_PASSWORD:
+            data[1] = MQTT_BAD_USERNAME_OR_PASSWORD;
+            break;
+        case MQTTV5_RC_NOT_AUTHORIZED:
+            data[1] = MQTT_NOT_AUTHORIZED;
+            break;
+        default:
+            WRITELOG("%s CONNACK from the broker, reason code 0x%02X.%s\n", ERRMSG_HEADER, data[1], ERRMSG_FOOTER);
+            data[1] = MQTT_SERVER_UNAVAILABLE;
+            break;
+        }
+        packet->_remainingLength = 2;
+        return true;
+
+    case PUBLISH:
+    {
+        int offset = 2 + (packet->_remainingLength >= 2 ? ((data[0] << 8) | data[1]) : 0) + (packet->_header.bits.qos ? 2 : 0);
+        if ( data + offset > end || (propLen = readProperties(data + offset, end, false)) < 0 )
+        {
+            return false;
+        }
+        memmove(data + offset, data + offset + propLen, end - data - offset - propLen);
+        packet->_remainingLength -= propLen;
+        return true;
+    }
+
+    case PUBACK:
+    case PUBREC:
+    case PUBREL:
+    case PUBCOMP:
+        /* packet identifier and reason code, the properties are dropped */
+        if ( packet->_remainingLength < 2 )
+        {
+            return false;
+        }
+        if ( packet->_remainingLength > 3 )
+        {
+            packet->_remainingLength = 3;
+        }
+        return true;
+
+    case SUBACK:
+    case UNSUBACK:
+        if ( packet->_remainingLength < 2 || (propLen = readProperties(data + 2, end, false)) < 0 )
+        {
+            return false;
+        }
+        memmove(data + 2, data + 2 + propLen, end - data - 2 - propLen);
+        packet->_remainingLength -= propLen;
+        if ( packet->getType() == UNSUBACK )
+        {
+            packet->_remainingLength = 2;
+        }
+        return true;
+
+    case DISCONNECT:
+        if ( packet->_remainingLength > 0 && data[0] != 0 )
+        {
+            WRITELOG("%s DISCONNECT from the broker, reason code 0x%02X.%s\n", ERRMSG_HEADER, data[0], ERRMSG_FOOTER);
+        }
+        packet->_remainingLength = 0;
+        return true;
+
+    case PINGRESP:
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+/*
+ *  Read the properties of a received packet, the limits of the connection from a CONNACK's.
+ *  @return the length of the properties with their length, -1 if they are malformed.
+ */
+int MQTTGWv5Session::readProperties(uint8_t* ptr, uint8_t* end, bool connack)
+{
+    int length;
+    int len = decodeVarint(ptr, end, &length);
+    if ( len < 0 || ptr + len + length > end )
+    {
+        return -1;
+    }
+
+    uint8_t* p = ptr + len;
+    uint8_t* propEnd = p + length;
+    while ( p < propEnd )
+    {
+        uint8_t id = *p++;
+        int valueLen = propertyValueLength(id, p, propEnd);
+        if ( valueLen < 0 )
+        {
+            return -1;
+        }
+        if ( connack && id == MQTTV5_PROPERTY_RECEIVE_MAXIMUM )
+        {
+            _receiveMaximum = (p[0] << 8) | p[1];
+        }
+        else if ( connack && id == MQTTV5_PROPERTY_TOPIC_ALIAS_MAXIMUM )
+        {
+            _topicAliasMaximum = (p[0] << 8) | p[1];
+        }
+        p += valueLen;
+    }
+    return len + length;
+}
+
+bool MQTTGWv5Session::isV5(void)
+{
+    return _v5;
+}
+
+/*
+ *  @return the smaller of maxInflight and the broker's Receive Maximum, 0: no limit.
+ */
+uint16_t MQTTGWv5Session::getInflightLimit(uint16_t maxInflight)
+{
+    uint16_t receiveMaximum = _receiveMaximum;
+    if ( _v5 && receiveMaximum && (maxInflight == 0 || receiveMaximum < maxInflight) )
+    {
+        return receiveMaximum;
+    }
+    return maxInflight;
+}
+
+uint16_t MQTTGWv5Session::getTopicAliasMaximum(void)
+{
+    return _topicAliasMaximum;
+}
+
+uint16_t MQTTGWv5Session::getAliasCount(void)
+{
+    return _table.getCount();
+}
+
+uint32_t MQTTGWv5Session::hashOf(MQTTGWv5Alias* alias)
+{
+    return hashBytes(alias->_topic, alias->_length);
+}
+
+/*
+ *  Aliases are kept in a hash table by topic name. Once the broker's Topic Alias Maximum
+ *  is reached, the other topics are sent by name.
+ *  @param isNew  set when the alias is assigned now and the topic name has to be sent with it.
+ *  @return the alias, 0 if there is none.
+ */
+uint16_t MQTTGWv5Session::getAlias(const char* topic, uint16_t length, bool* isNew)
+{
+    *isNew = true;
+    for ( MQTTGWv5Alias* p = _table.first(hashBytes(topic, length)); p; p = p->_next )
+    {
+        if ( p->_length == length && memcmp(p->_topic, topic, length) == 0 )
+        {
+            *isNew = false;
+            return p->_alias;
+        }
+    }
+
+    if ( _table.getCount() >= _topicAliasMaximum )
+    {
+        return 0;
+    }
+
+    MQTTGWv5Alias* alias = new MQTTGWv5Alias();
+    alias->_alias = _table.getCount() + 1;
+    alias->_length = length;
+    alias->_topic = (char*)malloc(length);
+    memcpy(alias->_topic, topic, length);
+    _table.add(alias);
+    return alias->_alias;
+}
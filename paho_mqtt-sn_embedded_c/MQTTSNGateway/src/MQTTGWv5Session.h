@@ -0,0 +1,86 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - MQTT v5 connection to the broker
+ **************************************************************************************/
+#ifndef MQTTGWV5SESSION_H_
+#define MQTTGWV5SESSION_H_
+
+#include "MQTTSNGWDefines.h"
+#include "Threading.h"
+#include "MQTTSNGWProcess.h"
+
+#define MQTTV5_ALIAS_INITIAL_TABLE_SIZE  64   // Buckets of the topic alias table, doubled when it fills up
+
+/* MQTT v5 properties the gateway reads or writes */
+#define MQTTV5_PROPERTY_SESSION_EXPIRY_INTERVAL  0x11
+#define MQTTV5_PROPERTY_RECEIVE_MAXIMUM          0x21
+#define MQTTV5_PROPERTY_TOPIC_ALIAS_MAXIMUM      0x22
+#define MQTTV5_PROPERTY_TOPIC_ALIAS              0x23
+
+class Network;
+
+namespace MQTTSNGW
+{
+class MQTTGWPacket;
+
+class MQTTGWv5Alias
+{
+    friend class MQTTGWv5Session;
+private:
+    uint16_t _alias {0};
+    uint16_t _length {0};
+    char* _topic {nullptr};
+    MQTTGWv5Alias* _next {nullptr};
+};
+
+/*=====================================
+ Class MQTTGWv5Session
+
+ State of a client's connection to the broker when it speaks MQTT v5, MQTTVersion=5.
+ The gateway keeps building and reading MQTT 3.1.1 packets, they are converted here:
+ queue() writes them in the v5 form, replacing the topic names of PUBLISHes with
+ topic aliases once the broker has learned them, and translate() turns the packets
+ received into the 3.1.1 form, keeping the reason codes of the acks.
+ The session starts over with every CONNECT queued, an MQTT 3.1.1 CONNECT turns it off.
+ =====================================*/
+class MQTTGWv5Session
+{
+public:
+    MQTTGWv5Session();
+    ~MQTTGWv5Session();
+
+    int queue(Network* network, const uint8_t* frame, int length, uint32_t latency, bool* first = nullptr, bool nowait = false);
+    int encode(const uint8_t* frame, int length, uint8_t* buf, int bufLen);
+    bool translate(MQTTGWPacket* packet);
+
+    bool isV5(void);
+    uint16_t getInflightLimit(uint16_t maxInflight);
+    uint16_t getTopicAliasMaximum(void);
+    uint16_t getAliasCount(void);
+
+private:
+    void reset(bool v5);
+    uint16_t getAlias(const char* topic, uint16_t length, bool* isNew);
+    static uint32_t hashOf(MQTTGWv5Alias* alias);
+    int readProperties(uint8_t* ptr, uint8_t* end, bool connack);
+
+    Mutex _mutex;
+    bool _v5 {false};
+    uint16_t _receiveMaximum {0};        // 0 until the broker's CONNACK tells it
+    uint16_t _topicAliasMaximum {0};
+    HashTable<MQTTGWv5Alias, &MQTTGWv5Alias::_next, &MQTTGWv5Session::hashOf> _table {MQTTV5_ALIAS_INITIAL_TABLE_SIZE};   // aliases by topic name
+};
+
+}
+#endif /* MQTTGWV5SESSION_H_ */
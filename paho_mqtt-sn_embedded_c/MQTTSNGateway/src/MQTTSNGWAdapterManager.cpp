@@ -23,6 +23,7 @@
 #include "MQTTSNGWClient.h"
 #include "MQTTSNGWAggregater.h"
 #include "MQTTSNGWQoSm1Proxy.h"
+#include "MQTTSNGWPacketBurst.h"
 #include <string.h>
 using namespace MQTTSNGW;
 
@@ -110,6 +111,24 @@ Client* AdapterManager::getClient(Client& client)
 	return newClient;
 }
 
+/*
+ *  @return the client whose broker connection carries the packets of client,
+ *          the QoS-1 proxy's or the aggregater's for their clients
+ */
+Client* AdapterManager::getCarrier(Client* client)
+{
+	Client* carrier = nullptr;
+	if ( client->isQoSm1() && _qosm1Proxy->isActive() )
+	{
+		carrier = _qosm1Proxy->getAdapterClient(client);
+	}
+	else if ( client->isAggregated() && _aggregater->isActive() )
+	{
+		carrier = _aggregater->getAdapterClient(client);
+	}
+	return carrier ? carrier : client;
+}
+
 int AdapterManager::unicastToClient(Client* client, MQTTSNPacket* packet, ClientSendTask* task)
 {
 	char pbuf[SIZE_OF_LOG_PACKET * 3];
@@ -144,6 +163,30 @@ int AdapterManager::unicastToClient(Client* client, MQTTSNPacket* packet, Client
 	return rc;
 }
 
+/*
+ *  A client reached directly gets the burst in as few SensorNetwork calls as possible,
+ *  others get it packet by packet.
+ */
+int AdapterManager::unicastToClient(Client* client, MQTTSNPacketBurst* burst, ClientSendTask* task)
+{
+	int rc = 0;
+
+	if ( client->getForwarder() || client->isQoSm1Proxy() || client->isAggregater() )
+	{
+		for (int i = 0; i < burst->getCount() && rc >= 0; i++)
+		{
+			rc = unicastToClient(client, burst->getPacket(i), task);
+		}
+		return rc;
+	}
+
+	for (int i = 0; i < burst->getCount(); i++)
+	{
+		task->log(client, burst->getPacket(i));
+	}
+	return burst->unicast(_gateway->getSensorNetwork(), client->getSensorNetAddress());
+}
+
 void AdapterManager::checkConnection(void)
 {
 	if ( _aggregater->isActive())
@@ -167,14 +210,14 @@ bool AdapterManager::isAggregaterActive(void)
 	return _aggregater->isActive();
 }
 
-AggregateTopicElement* AdapterManager::createClientList(Topic* topic)
+AggregateTopicElement* AdapterManager::createClientList(Topic* topic, Client* client)
 {
-	return _aggregater->createClientList(topic);
+	return _aggregater->createClientList(topic, client);
 }
 
-int AdapterManager::addAggregateTopic(Topic* topic, Client* client)
+int AdapterManager::addAggregateTopic(Topic* topic, Client* client, uint8_t qos, uint16_t clientMsgId)
 {
-	return _aggregater->addAggregateTopic(topic, client);
+	return _aggregater->addAggregateTopic(topic, client, qos, clientMsgId);
 }
 
 void AdapterManager::removeAggregateTopic(Topic* topic, Client* client)
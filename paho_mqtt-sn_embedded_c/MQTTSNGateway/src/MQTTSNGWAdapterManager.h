@@ -28,6 +28,7 @@ class Aggregater;
 class ForwarderList;
 class Forwarder;
 class MQTTSNPacket;
+class MQTTSNPacketBurst;
 class MQTTSNGWPacket;
 class ClientRecvTask;
 class ClientSendTask;
@@ -48,11 +49,13 @@ public:
 
     bool isAggregatedClient(Client* client);
     Client* getClient(Client& client);
+    Client* getCarrier(Client* client);
     Client* convertClient(uint16_t msgId, uint16_t* clientMsgId);
     int unicastToClient(Client* client, MQTTSNPacket* packet, ClientSendTask* task);
+    int unicastToClient(Client* client, MQTTSNPacketBurst* burst, ClientSendTask* task);
     bool isAggregaterActive(void);
-    AggregateTopicElement* createClientList(Topic* topic);
-    int addAggregateTopic(Topic* topic, Client* client);
+    AggregateTopicElement* createClientList(Topic* topic, Client* client);
+    int addAggregateTopic(Topic* topic, Client* client, uint8_t qos, uint16_t clientMsgId);
     void removeAggregateTopic(Topic* topic, Client* client);
     void removeAggregateTopicList(Topics* topics, Client* client);
 
@@ -15,6 +15,9 @@
  **************************************************************************************/
 #include "MQTTSNGWAggregateTopicTable.h"
 #include "MQTTSNGWClient.h"
+#include <string.h>
+
+using namespace MQTTSNGW;
 
 /*=====================================
  Class ClientTopicElement
@@ -34,6 +37,11 @@ Client* ClientTopicElement::getClient(void)
 	return _client;
 }
 
+uint8_t ClientTopicElement::getQos(void)
+{
+	return _qos;
+}
+
 /*=====================================
  Class AggregateTopicElement
  =====================================*/
@@ -42,64 +50,73 @@ AggregateTopicElement::AggregateTopicElement(void)
 
 }
 
-AggregateTopicElement::AggregateTopicElement(Topic* topic, Client* client)
+AggregateTopicElement::AggregateTopicElement(const char* filter, uint8_t qos)
+	: _filter {filter}
+	, _qos {qos}
 {
-	ClientTopicElement* elm = new ClientTopicElement(client);
-	if ( elm != nullptr )
-	{
-		_head = elm;
-		_tail = elm;
-	}
+
 }
 
 AggregateTopicElement::~AggregateTopicElement(void)
 {
-	_mutex.lock();
-	if ( _head != nullptr )
+	ClientTopicElement* p = _head;
+	while ( p )
 	{
-		ClientTopicElement* p = _tail;
-		while ( p )
-		{
-			ClientTopicElement* pPrev = p;
-			delete p;
-			p = pPrev->_prev;
-		}
-		_head = _tail = nullptr;
+		ClientTopicElement* next = p->_next;
+		delete p;
+		p = next;
 	}
-	_mutex.unlock();
+	_head = _tail = nullptr;
 }
 
 ClientTopicElement* AggregateTopicElement::add(Client* client)
 {
-	ClientTopicElement* elm = new ClientTopicElement(client);
-	if ( elm == nullptr )
+	if ( find(client) != nullptr )
 	{
 		return nullptr;
 	}
-	_mutex.lock();
-	if ( _head == nullptr )
+	ClientTopicElement* elm = new ClientTopicElement(client);
+	append(elm);
+	return elm;
+}
+
+void AggregateTopicElement::append(ClientTopicElement* elm)
+{
+	elm->_owner = this;
+	elm->_prev = _tail;
+	elm->_next = nullptr;
+	if ( _tail )
+	{
+		_tail->_next = elm;
+	}
+	else
 	{
 		_head = elm;
-		_tail = elm;
+	}
+	_tail = elm;
+	_cnt++;
+}
+
+void AggregateTopicElement::erase(ClientTopicElement* elm)
+{
+	if ( elm->_prev )
+	{
+		elm->_prev->_next = elm->_next;
 	}
 	else
 	{
-		ClientTopicElement* p = find(client);
-		if ( p == nullptr )
-		{
-			 p = _tail;
-			_tail = elm;
-			elm->_prev = p;
-			p->_next = elm;
-		}
-		else
-		{
-			delete elm;
-			elm = nullptr;
-		}
+		_head = elm->_next;
 	}
-	_mutex.unlock();
-	return elm;
+	if ( elm->_next )
+	{
+		elm->_next->_prev = elm->_prev;
+	}
+	else
+	{
+		_tail = elm->_prev;
+	}
+	_cnt--;
+	delete elm;
 }
 
 ClientTopicElement* AggregateTopicElement::find(Client* client)
@@ -126,6 +143,20 @@ ClientTopicElement* AggregateTopicElement::getNextElement(ClientTopicElement* el
 	return elm->_next;
 }
 
+const string* AggregateTopicElement::getFilter(void)
+{
+	return &_filter;
+}
+
+int AggregateTopicElement::getCount(void)
+{
+	return _cnt;
+}
+
+bool AggregateTopicElement::isSubscribed(void)
+{
+	return _broker;
+}
 
 /*=====================================
  Class AggregateTopicTable
@@ -138,24 +169,456 @@ AggregateTopicTable::AggregateTopicTable()
 
 AggregateTopicTable::~AggregateTopicTable()
 {
+	clear();
+}
+
+/*
+ *  true if every topic the filter matches is matched by filter 'covering' too,
+ *  or if 'covering' matches the topic name given instead of a filter.
+ */
+bool AggregateTopicTable::covers(const char* covering, const char* filter)
+{
+	if ( filter[0] == '$' && (covering[0] == '+' || covering[0] == '#') )
+	{
+		return false;
+	}
+
+	while ( true )
+	{
+		if ( covering[0] == '#' )
+		{
+			return true;
+		}
+
+		const char* c = covering;
+		const char* f = filter;
+		while ( *c && *c != '/' )
+		{
+			c++;
+		}
+		while ( *f && *f != '/' )
+		{
+			f++;
+		}
+
+		if ( c - covering == 1 && covering[0] == '+' )
+		{
+			if ( f - filter == 1 && filter[0] == '#' )
+			{
+				return false;
+			}
+		}
+		else if ( c - covering != f - filter || strncmp(covering, filter, c - covering) != 0 )
+		{
+			return false;
+		}
+
+		if ( *c == 0 || *f == 0 )
+		{
+			/* a/# covers a as well */
+			return *f == 0 && (*c == 0 || strcmp(c, "/#") == 0);
+		}
+		covering = c + 1;
+		filter = f + 1;
+	}
+}
+
+uint32_t AggregateTopicTable::hash(AggregateTopicElement* elm, Client* client)
+{
+	return hashMix(hashPointer(elm) ^ (uint32_t)((uintptr_t)client >> 4));
+}
+
+uint32_t AggregateTopicTable::hashFilter(AggregateTopicElement* elm)
+{
+	return elm->_hash;
+}
+
+uint32_t AggregateTopicTable::hashMember(ClientTopicElement* member)
+{
+	return hash(member->_owner, member->_client);
+}
+
+AggregateTopicElement* AggregateTopicTable::find(const char* filter)
+{
+	uint32_t h = hashBytes(filter, strlen(filter));
+	AggregateTopicElement* p = _filters.first(h);
+	while ( p && (p->_hash != h || p->_filter.compare(filter) != 0) )
+	{
+		p = p->_hashNext;
+	}
+	return p;
+}
+
+ClientTopicElement* AggregateTopicTable::findMember(AggregateTopicElement* elm, Client* client)
+{
+	ClientTopicElement* p = _members.first(hash(elm, client));
+	while ( p && (p->_owner != elm || p->_client != client) )
+	{
+		p = p->_hashNext;
+	}
+	return p;
+}
+
+/* the filter subscribed at the broker that covers elm */
+AggregateTopicElement* AggregateTopicTable::findCovering(AggregateTopicElement* elm)
+{
+	for ( AggregateTopicElement* p = _head; p; p = p->_next )
+	{
+		if ( p != elm && p->_broker && covers(p->_filter.c_str(), elm->_filter.c_str()) )
+		{
+			return p;
+		}
+	}
+	return nullptr;
+}
+
+/* the highest QoS asked for the filters elm covers, elm included */
+uint8_t AggregateTopicTable::coveredQos(AggregateTopicElement* elm)
+{
+	uint8_t qos = elm->_qos;
+	for ( AggregateTopicElement* p = _head; p; p = p->_next )
+	{
+		if ( p->_qos > qos && covers(elm->_filter.c_str(), p->_filter.c_str()) )
+		{
+			qos = p->_qos;
+		}
+	}
+	return qos;
+}
+
+void AggregateTopicTable::setDirty(AggregateTopicElement* elm)
+{
+	if ( !elm->_dirty )
+	{
+		elm->_dirty = true;
+		elm->_dirtyNext = _dirty;
+		_dirty = elm;
+	}
+}
+
+void AggregateTopicTable::subscribe(AggregateTopicElement* elm, uint8_t qos)
+{
+	if ( !elm->_broker )
+	{
+		elm->_broker = true;
+		_brokerCnt++;
+	}
+	if ( qos > elm->_brokerQos )
+	{
+		elm->_brokerQos = qos;
+	}
+	setDirty(elm);
+}
+
+void AggregateTopicTable::unsubscribe(AggregateTopicElement* elm)
+{
+	if ( elm->_broker )
+	{
+		elm->_broker = false;
+		elm->_brokerQos = 0;
+		_brokerCnt--;
+	}
+	setDirty(elm);
+}
+
+/*
+ *  Adds the client to the filter. A new filter is to be subscribed at the broker
+ *  unless a broker-side filter covers it, and it replaces the broker-side filters it covers.
+ */
+AggregateTopicElement* AggregateTopicTable::add(const char* filter, uint8_t qos, Client* client)
+{
+	_mutex.lock();
+	AggregateTopicElement* elm = find(filter);
+
+	if ( elm == nullptr )
+	{
+		elm = new AggregateTopicElement(filter, qos);
+		elm->_hash = hashBytes(filter, strlen(filter));
+		_filters.add(elm);
+		elm->_prev = _tail;
+		if ( _tail )
+		{
+			_tail->_next = elm;
+		}
+		else
+		{
+			_head = elm;
+		}
+		_tail = elm;
+		_cnt++;
+
+		AggregateTopicElement* covering = findCovering(elm);
+		if ( covering )
+		{
+			if ( covering->_brokerQos < qos )
+			{
+				subscribe(covering, qos);
+			}
+		}
+		else
+		{
+			for ( AggregateTopicElement* p = _head; p; p = p->_next )
+			{
+				if ( p != elm && p->_broker && covers(filter, p->_filter.c_str()) )
+				{
+					unsubscribe(p);
+				}
+			}
+			subscribe(elm, coveredQos(elm));
+		}
+	}
+	else if ( qos > elm->_qos )
+	{
+		elm->_qos = qos;
+		AggregateTopicElement* covering = elm->_broker ? elm : findCovering(elm);
+		if ( covering && covering->_brokerQos < qos )
+		{
+			subscribe(covering, qos);
+		}
+	}
+
+	ClientTopicElement* member = findMember(elm, client);
+	if ( member == nullptr )
+	{
+		member = new ClientTopicElement(client);
+		elm->append(member);
+		_members.add(member);
+	}
+	member->_qos = qos;
+	_mutex.unlock();
+	return elm;
+}
+
+void AggregateTopicTable::remove(const char* filter, Client* client)
+{
+	_mutex.lock();
+	AggregateTopicElement* elm = find(filter);
+	if ( elm )
+	{
+		ClientTopicElement* member = findMember(elm, client);
+		if ( member )
+		{
+			removeMember(member);
+		}
+	}
+	_mutex.unlock();
+}
+
+/* removes the client from all of its filters */
+void AggregateTopicTable::remove(Client* client)
+{
+	_mutex.lock();
+	AggregateTopicElement* p = _head;
+	while ( p )
+	{
+		AggregateTopicElement* next = p->_next;
+		ClientTopicElement* member = findMember(p, client);
+		if ( member )
+		{
+			removeMember(member);
+		}
+		p = next;
+	}
+	_mutex.unlock();
+}
+
+/*
+ *  Removes a client from its filter. The filter is removed with its last client,
+ *  and the filters it covered that no other broker-side filter covers take its place.
+ */
+void AggregateTopicTable::removeMember(ClientTopicElement* member)
+{
+	AggregateTopicElement* elm = member->_owner;
+
+	_members.remove(member);
+	elm->erase(member);
+
+	if ( elm->_cnt > 0 )
+	{
+		return;
+	}
+
+	_filters.remove(elm);
+	if ( elm->_prev )
+	{
+		elm->_prev->_next = elm->_next;
+	}
+	else
+	{
+		_head = elm->_next;
+	}
+	if ( elm->_next )
+	{
+		elm->_next->_prev = elm->_prev;
+	}
+	else
+	{
+		_tail = elm->_prev;
+	}
+	_cnt--;
+	elm->_removed = true;
+
+	if ( !elm->_broker )
+	{
+		if ( !elm->_dirty )
+		{
+			delete elm;
+		}
+		return;
+	}
+	unsubscribe(elm);
 
+	/* subscribe the filters that are not covered any more, the widest ones first */
+	for ( AggregateTopicElement* p = _head; p; p = p->_next )
+	{
+		if ( p->_broker || findCovering(p) )
+		{
+			continue;
+		}
+		for ( AggregateTopicElement* q = _head; q; q = q->_next )
+		{
+			if ( q != p && q->_broker && covers(p->_filter.c_str(), q->_filter.c_str()) )
+			{
+				unsubscribe(q);
+			}
+		}
+		subscribe(p, coveredQos(p));
+	}
 }
 
-AggregateTopicElement* AggregateTopicTable::add(Topic* topic, Client* client)
+/*
+ *  Returns the next SUBSCRIBE or UNSUBSCRIBE to send to the broker, false when there is none.
+ *  All SUBSCRIBEs are returned before the UNSUBSCRIBEs.
+ */
+bool AggregateTopicTable::getUpdate(string* filter, uint8_t* qos, bool* subscribe)
 {
-	//ToDo: AggregateGW
-	return 0;
+	_mutex.lock();
+	for ( AggregateTopicElement** pp = &_dirty; *pp; pp = &(*pp)->_dirtyNext )
+	{
+		AggregateTopicElement* p = *pp;
+		if ( p->_broker && (!p->_sent || p->_sentQos < p->_brokerQos) )
+		{
+			*pp = p->_dirtyNext;
+			p->_dirty = false;
+			p->_sent = true;
+			p->_sentQos = p->_brokerQos;
+			*filter = p->_filter;
+			*qos = p->_brokerQos;
+			*subscribe = true;
+			_mutex.unlock();
+			return true;
+		}
+	}
+
+	while ( _dirty )
+	{
+		AggregateTopicElement* p = _dirty;
+		_dirty = p->_dirtyNext;
+		p->_dirty = false;
+		bool unsubscribe = !p->_broker && p->_sent;
+		if ( unsubscribe )
+		{
+			p->_sent = false;
+			*filter = p->_filter;
+			*qos = 0;
+			*subscribe = false;
+		}
+		if ( p->_removed )
+		{
+			delete p;
+		}
+		if ( unsubscribe )
+		{
+			_mutex.unlock();
+			return true;
+		}
+	}
+	_mutex.unlock();
+	return false;
 }
 
-void AggregateTopicTable::remove(Topic* topic, Client* client)
+/*
+ *  Returns a new list of the clients a PUBLISH of the topic is delivered to,
+ *  once each even if several of their filters match it, or nullptr. The caller deletes it.
+ */
+AggregateTopicElement* AggregateTopicTable::getClientList(const char* topicName)
 {
-	//ToDo: AggregateGW
+	AggregateTopicElement* list = nullptr;
+	AggregateTopicElement* matched = nullptr;
+
+	_mutex.lock();
+	for ( AggregateTopicElement* p = _head; p; p = p->_next )
+	{
+		if ( !covers(p->_filter.c_str(), topicName) )
+		{
+			continue;
+		}
+		if ( list == nullptr )
+		{
+			list = new AggregateTopicElement();
+		}
+		for ( ClientTopicElement* m = p->_head; m; m = m->_next )
+		{
+			AggregateTopicElement* q = matched;
+			while ( q && findMember(q, m->_client) == nullptr )
+			{
+				q = q->_matchNext;
+			}
+			if ( q == nullptr )
+			{
+				ClientTopicElement* e = new ClientTopicElement(m->_client);
+				e->_qos = m->_qos;
+				list->append(e);
+			}
+			else
+			{
+				ClientTopicElement* e = list->find(m->_client);
+				if ( e->_qos < m->_qos )
+				{
+					e->_qos = m->_qos;
+				}
+			}
+		}
+		p->_matchNext = matched;
+		matched = p;
+	}
+	_mutex.unlock();
+	return list;
 }
 
-AggregateTopicElement* AggregateTopicTable::getClientList(Topic* client)
+int AggregateTopicTable::getCount(void)
 {
-	// ToDo: AggregateGW
-	return 0;
+	return _cnt;
 }
 
+/* number of filters subscribed at the broker */
+int AggregateTopicTable::getBrokerCount(void)
+{
+	return _brokerCnt;
+}
 
+void AggregateTopicTable::clear(void)
+{
+	_mutex.lock();
+	while ( _dirty )
+	{
+		AggregateTopicElement* p = _dirty;
+		_dirty = p->_dirtyNext;
+		p->_dirty = false;
+		if ( p->_removed )
+		{
+			delete p;
+		}
+	}
+	while ( _head )
+	{
+		AggregateTopicElement* p = _head;
+		_head = p->_next;
+		delete p;
+	}
+	_tail = nullptr;
+	_filters.clear();
+	_members.clear();
+	_cnt = _brokerCnt = 0;
+	_mutex.unlock();
+}
@@ -20,6 +20,10 @@
 #include "MQTTSNGWDefines.h"
 #include "MQTTSNGWProcess.h"
 #include <stdint.h>
+#include <string>
+
+#define AGGREGATETOPIC_INITIAL_TABLE_SIZE  64   // Buckets of the filter and subscriber tables, doubled when they fill up
+
 namespace MQTTSNGW
 {
 
@@ -29,35 +33,17 @@ class AggregateTopicElement;
 class ClientTopicElement;
 class Mutex;
 
-/*=====================================
- Class AggregateTopicTable
- ======================================*/
-class AggregateTopicTable
-{
-public:
-	AggregateTopicTable();
-	~AggregateTopicTable();
-
-	AggregateTopicElement* add(Topic* topic, Client* client);
-	AggregateTopicElement* getClientList(Topic* client);
-	void remove(Topic* topic, Client* client);
-	void clear(void);
-private:
-	AggregateTopicElement* _head {nullptr};
-	AggregateTopicElement* _tail {nullptr};
-	int _cnt {0};
-	int _maxSize {MAX_MESSAGEID_TABLE_SIZE};
-};
-
 /*=====================================
  Class AggregateTopicElement
+
+ A topic filter and its clients, or the clients a PUBLISH is delivered to.
  =====================================*/
 class AggregateTopicElement
 {
     friend class AggregateTopicTable;
 public:
     AggregateTopicElement(void);
-    AggregateTopicElement(Topic* topic, Client* client);
+    AggregateTopicElement(const char* filter, uint8_t qos);
     ~AggregateTopicElement(void);
 
     ClientTopicElement* add(Client* client);
@@ -65,12 +51,30 @@ public:
     ClientTopicElement* getNextElement(ClientTopicElement* elm);
     void erase(ClientTopicElement* elm);
     ClientTopicElement* find(Client* client);
+    const string* getFilter(void);
+    int getCount(void);
+    bool isSubscribed(void);
 
 private:
-    Mutex _mutex;
-    Topic* _topic {nullptr};
+    void append(ClientTopicElement* elm);
+
+    string _filter;
+    uint32_t _hash {0};
+    int _cnt {0};
+    uint8_t _qos {0};             // highest QoS its clients asked for
+    uint8_t _brokerQos {0};       // QoS the filter is to be subscribed with at the broker
+    uint8_t _sentQos {0};         // QoS it was subscribed with, valid while _sent
+    bool _broker {false};         // to be subscribed at the broker, otherwise covered by another filter
+    bool _sent {false};           // subscribed at the broker
+    bool _removed {false};        // no clients left, deleted after its UNSUBSCRIBE
+    bool _dirty {false};
     ClientTopicElement* _head {nullptr};
     ClientTopicElement* _tail {nullptr};
+    AggregateTopicElement* _next {nullptr};
+    AggregateTopicElement* _prev {nullptr};
+    AggregateTopicElement* _hashNext {nullptr};
+    AggregateTopicElement* _dirtyNext {nullptr};
+    AggregateTopicElement* _matchNext {nullptr};
 };
 
 /*=====================================
@@ -78,17 +82,72 @@ private:
  =====================================*/
 class ClientTopicElement
 {
-    friend class AggregateTopicTable;
-    friend class AggregateTopicElement;
+	friend class AggregateTopicTable;
+	friend class AggregateTopicElement;
 public:
-    ClientTopicElement(Client* client);
-    ~ClientTopicElement(void);
-    Client* getClient(void);
+	ClientTopicElement(Client* client);
+	~ClientTopicElement(void);
+	Client* getClient(void);
+	uint8_t getQos(void);
 
 private:
-    Client* _client {nullptr};
-    ClientTopicElement* _next {nullptr};
-    ClientTopicElement* _prev {nullptr};
+	Client* _client {nullptr};
+	uint8_t _qos {0};             // QoS the client asked for, the highest of the filters matched in a list
+	AggregateTopicElement* _owner {nullptr};
+	ClientTopicElement* _next {nullptr};
+	ClientTopicElement* _prev {nullptr};
+	ClientTopicElement* _hashNext {nullptr};
+};
+
+/*=====================================
+ Class AggregateTopicTable
+
+ Topic filters the aggregated clients subscribe to, with the clients of each.
+ Only filters that no other broker-side filter covers are subscribed at the broker,
+ a/+/c is covered by a/# for example, so thousands of clients subscribing to the same
+ filters cost one broker subscription each. A filter is unsubscribed when its
+ last client leaves, and the filters it covered are subscribed again as needed.
+ add() and remove() only change the table, getUpdate() then returns the SUBSCRIBEs
+ and UNSUBSCRIBEs to send, SUBSCRIBEs first so that no message is lost in between.
+ ======================================*/
+class AggregateTopicTable
+{
+public:
+	AggregateTopicTable();
+	~AggregateTopicTable();
+
+	AggregateTopicElement* add(const char* filter, uint8_t qos, Client* client);
+	void remove(const char* filter, Client* client);
+	void remove(Client* client);
+	bool getUpdate(string* filter, uint8_t* qos, bool* subscribe);
+	AggregateTopicElement* getClientList(const char* topicName);
+	int getCount(void);
+	int getBrokerCount(void);
+	void clear(void);
+
+	static bool covers(const char* filter, const char* topic);
+
+private:
+	AggregateTopicElement* find(const char* filter);
+	AggregateTopicElement* findCovering(AggregateTopicElement* elm);
+	ClientTopicElement* findMember(AggregateTopicElement* elm, Client* client);
+	void removeMember(ClientTopicElement* member);
+	void subscribe(AggregateTopicElement* elm, uint8_t qos);
+	void unsubscribe(AggregateTopicElement* elm);
+	void setDirty(AggregateTopicElement* elm);
+	uint8_t coveredQos(AggregateTopicElement* elm);
+	static uint32_t hash(AggregateTopicElement* elm, Client* client);
+	static uint32_t hashFilter(AggregateTopicElement* elm);
+	static uint32_t hashMember(ClientTopicElement* member);
+
+	Mutex _mutex;
+	AggregateTopicElement* _head {nullptr};
+	AggregateTopicElement* _tail {nullptr};
+	AggregateTopicElement* _dirty {nullptr};
+	HashTable<AggregateTopicElement, &AggregateTopicElement::_hashNext, &AggregateTopicTable::hashFilter> _filters {AGGREGATETOPIC_INITIAL_TABLE_SIZE};
+	HashTable<ClientTopicElement, &ClientTopicElement::_hashNext, &AggregateTopicTable::hashMember> _members {AGGREGATETOPIC_INITIAL_TABLE_SIZE};
+	int _cnt {0};
+	int _brokerCnt {0};
 };
 
 }
@@ -93,26 +93,80 @@ uint16_t Aggregater::getMsgId(Client* client, uint16_t clientMsgId)
 	return _msgIdTable.getMsgId(client, clientMsgId);
 }
 
+AggregateTopicTable* Aggregater::getTopicTable(Client* client)
+{
+	return client->isSecureNetwork() ? &_secureTopicTable : &_topicTable;
+}
+
+/*
+ *  Sends the SUBSCRIBEs and UNSUBSCRIBEs the topic table asks for.
+ *  The SUBSCRIBE of the client's own filter carries a message id that its SUBACK
+ *  is converted back with, returns true if it was sent.
+ */
+bool Aggregater::sendTopicUpdates(AggregateTopicTable* table, Client* client, const string* filter, uint16_t clientMsgId)
+{
+	string updated;
+	uint8_t qos;
+	bool subscribe;
+	bool sent = false;
+
+	while ( table->getUpdate(&updated, &qos, &subscribe) )
+	{
+		uint16_t id = 0;
+		if ( subscribe && filter && !sent && updated.compare(*filter) == 0 )
+		{
+			id = addMessageIdTable(client, clientMsgId);
+			sent = ( id != 0 );
+		}
+		if ( id == 0 )
+		{
+			id = msgId();
+		}
+
+		MQTTGWPacket* packet = new MQTTGWPacket();
+		if ( subscribe )
+		{
+			packet->setSUBSCRIBE(updated.c_str(), qos, id);
+		}
+		else
+		{
+			packet->setUNSUBSCRIBE(updated.c_str(), id);
+		}
+		Event* ev = new Event();
+		ev->setBrokerSendEvent(client, packet);
+		_gateway->getBrokerSendQue()->post(ev);
+	}
+	return sent;
+}
+
 void Aggregater::removeAggregateTopic(Topic* topic, Client* client)
 {
-      // ToDo: AggregateGW this method called when the client disconnect and erase it`s Topics. this method call */
+	AggregateTopicTable* table = getTopicTable(client);
+	table->remove(topic->getTopicName()->c_str(), client);
+	sendTopicUpdates(table, client, nullptr, 0);
 }
 
 void Aggregater::removeAggregateTopicList(Topics* topics, Client* client)
 {
-      // ToDo: AggregateGW this method called when the client disconnect and erase it`s Topics. this method call */
+	AggregateTopicTable* table = getTopicTable(client);
+	table->remove(client);
+	sendTopicUpdates(table, client, nullptr, 0);
 }
 
-int Aggregater::addAggregateTopic(Topic* topic, Client* client)
+/*
+ *  Returns 1 if the client's SUBSCRIBE went to the broker, whose SUBACK is then
+ *  returned to the client, or 0 if a filter subscribed already covers it.
+ */
+int Aggregater::addAggregateTopic(Topic* topic, Client* client, uint8_t qos, uint16_t clientMsgId)
 {
-	// ToDo: AggregateGW  */
-	return 0;
+	AggregateTopicTable* table = getTopicTable(client);
+	table->add(topic->getTopicName()->c_str(), qos, client);
+	return sendTopicUpdates(table, client, topic->getTopicName(), clientMsgId) ? 1 : 0;
 }
 
-AggregateTopicElement* Aggregater::createClientList(Topic* topic)
+AggregateTopicElement* Aggregater::createClientList(Topic* topic, Client* client)
 {
-	// ToDo: AggregateGW  */
-	return 0;
+	return getTopicTable(client)->getClientList(topic->getTopicName()->c_str());
 }
 
 bool Aggregater::testMessageIdTable(void)
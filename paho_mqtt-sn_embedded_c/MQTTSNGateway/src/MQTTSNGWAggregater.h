@@ -49,8 +49,8 @@ public:
 	uint16_t getMsgId(Client* client, uint16_t clientMsgId);
 
 
-	AggregateTopicElement* createClientList(Topic* topic);
-	int addAggregateTopic(Topic* topic, Client* client);
+	AggregateTopicElement* createClientList(Topic* topic, Client* client);
+	int addAggregateTopic(Topic* topic, Client* client, uint8_t qos, uint16_t clientMsgId);
 	void removeAggregateTopic(Topic* topic, Client* client);
 	void removeAggregateTopicList(Topics* topics, Client* client);
 	bool isActive(void);
@@ -59,9 +59,12 @@ public:
 
 private:
 	uint16_t msgId(void);
+	AggregateTopicTable* getTopicTable(Client* client);
+	bool sendTopicUpdates(AggregateTopicTable* table, Client* client, const string* filter, uint16_t clientMsgId);
     Gateway* _gateway {nullptr};
     MessageIdTable _msgIdTable;
-    AggregateTopicTable _topicTable;
+    AggregateTopicTable _topicTable;          // of the clients behind the aggregater's connection
+    AggregateTopicTable _secureTopicTable;    // and of those behind its secure connection
 
     bool _isActive {false};
     bool _isSecure {false};
@@ -0,0 +1,221 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - pool of broker connections
+ **************************************************************************************/
+
+#include "MQTTSNGWBrokerPool.h"
+#include "MQTTSNGateway.h"
+#include "Network.h"
+#include <sys/socket.h>
+#include <errno.h>
+#include <string.h>
+
+using namespace MQTTSNGW;
+
+/*=====================================
+ Class BrokerPool
+ =====================================*/
+BrokerPool::BrokerPool()
+{
+
+}
+
+BrokerPool::~BrokerPool()
+{
+    clear();
+}
+
+/*
+ *  @param size connections of each kind, 0: no pool
+ *  @param idle secs a connection is kept unused
+ */
+void BrokerPool::initialize(uint32_t size, uint32_t idle)
+{
+    _size = size;
+    _idle = idle;
+}
+
+bool BrokerPool::isActive(void)
+{
+    return _size > 0;
+}
+
+/*
+ *  Keep connections of a kind, a client of the ClientsList uses it.
+ */
+void BrokerPool::prepare(bool secure)
+{
+    _mutex.lock();
+    _wanted[secure] = true;
+    _mutex.unlock();
+}
+
+/*
+ *  Give the client's Network a pooled connection of its kind.
+ *  @return false if there is none, the client connects itself.
+ */
+bool BrokerPool::take(Client* client)
+{
+    if ( !isActive() )
+    {
+        return false;
+    }
+
+    bool secure = client->isSecureNetwork();
+    bool rc = false;
+
+    _mutex.lock();
+    _wanted[secure] = true;
+    while ( _connections[secure] && !rc )
+    {
+        PooledConnection* conn = _connections[secure];
+        _connections[secure] = conn->_next;
+        _cnt[secure]--;
+
+        if ( isAlive(conn->_network) && client->getNetwork()->takeOver(conn->_network) )
+        {
+            _counters.hits++;
+            rc = true;
+        }
+        else
+        {
+            _counters.expired++;
+        }
+        delete conn->_network;
+        delete conn;
+    }
+    if ( !rc )
+    {
+        _counters.misses++;
+    }
+    _mutex.unlock();
+    return rc;
+}
+
+/*
+ *  Replace the idle connections and open the missing ones, called by BrokerPoolTask.
+ *  @return the number of connections opened.
+ */
+int BrokerPool::refill(GatewayParams* params)
+{
+    if ( !isActive() )
+    {
+        return 0;
+    }
+    return refill(params, false) + refill(params, true);
+}
+
+int BrokerPool::refill(GatewayParams* params, bool secure)
+{
+    time_t now = time(nullptr);
+    int opened = 0;
+
+    _mutex.lock();
+    if ( !_wanted[secure] || (secure ? params->portSecure : params->port) == nullptr )
+    {
+        _mutex.unlock();
+        return 0;
+    }
+    for ( PooledConnection** p = &_connections[secure]; *p; )
+    {
+        PooledConnection* conn = *p;
+        if ( now - conn->_connected >= (time_t)_idle || !isAlive(conn->_network) )
+        {
+            *p = conn->_next;
+            _cnt[secure]--;
+            _counters.expired++;
+            delete conn->_network;
+            delete conn;
+        }
+        else
+        {
+            p = &conn->_next;
+        }
+    }
+    uint32_t missing = _size > _cnt[secure] ? _size - _cnt[secure] : 0;
+    _mutex.unlock();
+
+    /* connect without holding the pool, clients keep taking connections meanwhile */
+    for ( uint32_t i = 0; i < missing; i++ )
+    {
+        Network* network = new Network(secure);
+        bool connected;
+        if ( secure )
+        {
+            connected = network->connect(params->brokerName, params->portSecure, params->rootCApath, params->rootCAfile, params->certKey, params->privateKey);
+        }
+        else
+        {
+            connected = network->connect(params->brokerName, params->port);
+        }
+        if ( !connected )
+        {
+            WRITELOG("%s BrokerPool can't connect to the broker. errno=%d %s%s\n", ERRMSG_HEADER, errno, strerror(errno), ERRMSG_FOOTER);
+            delete network;
+            break;
+        }
+
+        PooledConnection* conn = new PooledConnection();
+        conn->_network = network;
+        conn->_connected = time(nullptr);
+        _mutex.lock();
+        conn->_next = _connections[secure];
+        _connections[secure] = conn;
+        _cnt[secure]++;
+        _counters.opened++;
+        _mutex.unlock();
+        opened++;
+    }
+    return opened;
+}
+
+void BrokerPool::clear(void)
+{
+    _mutex.lock();
+    for ( int i = 0; i < 2; i++ )
+    {
+        while ( _connections[i] )
+        {
+            PooledConnection* conn = _connections[i];
+            _connections[i] = conn->_next;
+            delete conn->_network;
+            delete conn;
+        }
+        _cnt[i] = 0;
+    }
+    _mutex.unlock();
+}
+
+void BrokerPool::getCounters(BrokerPoolCounters* counters)
+{
+    _mutex.lock();
+    *counters = _counters;
+    _mutex.unlock();
+}
+
+uint32_t BrokerPool::getCount(bool secure)
+{
+    return _cnt[secure];
+}
+
+/*
+ *  A connection the broker closed is readable with nothing to read.
+ *  TLS session tickets may be waiting on a live one.
+ */
+bool BrokerPool::isAlive(Network* network)
+{
+    uint8_t c;
+    int rc = ::recv(network->getSock(), &c, 1, MSG_PEEK | MSG_DONTWAIT);
+    return rc > 0 || (rc < 0 && (errno == EAGAIN || errno == EWOULDBLOCK));
+}
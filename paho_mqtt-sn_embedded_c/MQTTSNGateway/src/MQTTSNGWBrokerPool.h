@@ -0,0 +1,87 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - pool of broker connections
+ **************************************************************************************/
+#ifndef MQTTSNGATEWAY_SRC_MQTTSNGWBROKERPOOL_H_
+#define MQTTSNGATEWAY_SRC_MQTTSNGWBROKERPOOL_H_
+
+#include <time.h>
+#include "MQTTSNGWDefines.h"
+#include "Threading.h"
+
+class Network;
+
+namespace MQTTSNGW
+{
+class Client;
+class GatewayParams;
+
+/* Counters of the pool */
+typedef struct
+{
+    uint32_t hits;      // clients given a pooled connection
+    uint32_t misses;    // clients that had to connect themselves
+    uint32_t opened;    // connections opened for the pool
+    uint32_t expired;   // connections closed unused, idle or closed by the broker
+} BrokerPoolCounters;
+
+class PooledConnection
+{
+    friend class BrokerPool;
+private:
+    Network* _network {nullptr};
+    time_t _connected {0};
+    PooledConnection* _next {nullptr};
+};
+
+/*=====================================
+ Class BrokerPool
+
+ Broker connections, TCP and TLS, opened before the clients need them, BrokerPool=<connections>.
+ Up to that many plain and secure connections are kept for the kinds of connections the clients
+ of the ClientsList use, or have used. BrokerSendTask hands one to a client that sends a CONNECT
+ instead of connecting, and BrokerPoolTask opens new ones in the background, resuming the TLS
+ session. Connections not taken within BrokerPoolIdle secs are replaced, before the broker
+ drops them for not sending a CONNECT.
+ =====================================*/
+class BrokerPool
+{
+public:
+    BrokerPool();
+    ~BrokerPool();
+
+    void initialize(uint32_t size, uint32_t idle);
+    bool isActive(void);
+    void prepare(bool secure);
+    bool take(Client* client);
+    int refill(GatewayParams* params);
+    void clear(void);
+    void getCounters(BrokerPoolCounters* counters);
+    uint32_t getCount(bool secure);
+
+private:
+    int refill(GatewayParams* params, bool secure);
+    static bool isAlive(Network* network);
+
+    Mutex _mutex;
+    uint32_t _size {0};
+    uint32_t _idle {0};
+    bool _wanted[2] {false, false};
+    PooledConnection* _connections[2] {nullptr, nullptr};    // newest first
+    uint32_t _cnt[2] {0, 0};
+    BrokerPoolCounters _counters {0, 0, 0, 0};
+};
+
+}
+#endif /* MQTTSNGATEWAY_SRC_MQTTSNGWBROKERPOOL_H_ */
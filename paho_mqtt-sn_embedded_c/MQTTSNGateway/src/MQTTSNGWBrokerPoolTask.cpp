@@ -0,0 +1,55 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - pool of broker connections
+ **************************************************************************************/
+
+#include "MQTTSNGWBrokerPoolTask.h"
+#include "MQTTSNGWBrokerPool.h"
+#include <unistd.h>
+
+using namespace std;
+using namespace MQTTSNGW;
+
+char* currentDateTime();
+
+/*=====================================
+ Class BrokerPoolTask
+ =====================================*/
+BrokerPoolTask::BrokerPoolTask(Gateway* gateway)
+{
+	_gateway = gateway;
+	_gateway->attach((Thread*)this);
+}
+
+BrokerPoolTask::~BrokerPoolTask()
+{
+
+}
+
+void BrokerPoolTask::run()
+{
+	BrokerPool* pool = _gateway->getBrokerPool();
+
+	while (true)
+	{
+		if (CHK_SIGINT)
+		{
+			pool->clear();
+			WRITELOG("%s BrokerPoolTask   stopped.\n", currentDateTime());
+			return;
+		}
+		pool->refill(_gateway->getGWParams());
+		usleep(BROKER_POOL_INTERVAL * 1000);
+	}
+}
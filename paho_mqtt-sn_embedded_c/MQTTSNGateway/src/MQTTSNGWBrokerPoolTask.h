@@ -0,0 +1,42 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - pool of broker connections
+ **************************************************************************************/
+#ifndef MQTTSNGWBROKERPOOLTASK_H_
+#define MQTTSNGWBROKERPOOLTASK_H_
+
+#include "MQTTSNGWDefines.h"
+#include "MQTTSNGateway.h"
+
+namespace MQTTSNGW
+{
+
+/*=====================================
+     Class BrokerPoolTask
+
+     Refills the BrokerPool every BROKER_POOL_INTERVAL msecs.
+ =====================================*/
+class BrokerPoolTask : public Thread
+{
+	MAGIC_WORD_FOR_THREAD;
+public:
+	BrokerPoolTask(Gateway* gateway);
+	~BrokerPoolTask();
+	void run();
+private:
+	Gateway* _gateway;
+};
+
+}
+#endif /* MQTTSNGWBROKERPOOLTASK_H_ */
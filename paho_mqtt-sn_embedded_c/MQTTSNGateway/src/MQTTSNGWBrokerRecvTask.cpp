@@ -18,6 +18,8 @@
 #include "MQTTSNGWClient.h"
 #include "MQTTSNGWClientList.h"
 #include <unistd.h>
+#include <string.h>
+#include <errno.h>
 
 using namespace std;
 using namespace MQTTSNGW;
@@ -36,7 +38,11 @@ BrokerRecvTask::BrokerRecvTask(Gateway* gateway)
 
 BrokerRecvTask::~BrokerRecvTask()
 {
-
+	_ring.close();
+	if ( _sockets )
+	{
+		delete[] _sockets;
+	}
 }
 
 /**
@@ -53,12 +59,19 @@ void BrokerRecvTask::initialize(int argc, char** argv)
 void BrokerRecvTask::run(void)
 {
 	struct timeval timeout;
-	MQTTGWPacket* packet = nullptr;
-	int rc;
-	Event* ev = nullptr;
 	fd_set rset;
 	fd_set wset;
 
+	if ( _gateway->getGWParams()->ioUring )
+	{
+		if ( _ring.open() )
+		{
+			runRing();
+			return;
+		}
+		WRITELOG("%s BrokerRecvTask can't open an io_uring, select() is used.%s\n", ERRMSG_HEADER, ERRMSG_FOOTER);
+	}
+
 	while (true)
 	{
 		_light->blueLight(false);
@@ -110,70 +123,16 @@ void BrokerRecvTask::run(void)
 					if (client->getNetwork()->isValid())
 					{
 						int sockfd = client->getNetwork()->getSock();
-						if (FD_ISSET(sockfd, &rset))
+						if (FD_ISSET(sockfd, &rset) && !recvPacket(client))
 						{
-							packet = new MQTTGWPacket();
-							rc = 0;
-							/* read sockets */
-							_light->blueLight(true);
-							rc = packet->recv(client->getNetwork());
-							if ( rc > 0 )
-							{
-								if ( log(client, packet) == -1 )
-								{
-									delete packet;
-									goto nextClient;
-								}
-
-								/* post a BrokerRecvEvent */
-								ev = new Event();
-								ev->setBrokerRecvEvent(client, packet);
-								_gateway->getPacketEventQue()->post(ev);
-							}
-							else
+							/* disconnected, the client may have been deleted */
+							if ( client )
 							{
-								if ( rc == 0 )  // Disconnected
-								{
-									client->getNetwork()->close();
-									delete packet;
-
-									/* delete client when the client is not authorized & session is clean */
-									_gateway->getClientList()->erase(client);
-
-									if ( client )
-									{
-										client = client->getNextClient();
-									}
-									continue;
-								}
-								else if (rc == -1)
-								{
-									WRITELOG("%s BrokerRecvTask can't receive a packet from the broker errno=%d %s%s\n", ERRMSG_HEADER, errno, client->getClientId(), ERRMSG_FOOTER);
-								}
-								else if ( rc == -2 )
-								{
-									WRITELOG("%s BrokerRecvTask receive invalid length of packet from the broker.  DISCONNECT  %s %s\n", ERRMSG_HEADER, client->getClientId(),ERRMSG_FOOTER);
-								}
-								else if ( rc == -3 )
-								{
-									WRITELOG("%s BrokerRecvTask can't get memories for the packet %s%s\n", ERRMSG_HEADER, client->getClientId(), ERRMSG_FOOTER);
-								}
-
-								delete packet;
-
-								if ( (rc == -1 || rc == -2) && client->isActive() )
-								{
-									/* disconnect the client */
-									packet = new MQTTGWPacket();
-									packet->setHeader(DISCONNECT);
-									ev = new Event();
-									ev->setBrokerRecvEvent(client, packet);
-									_gateway->getPacketEventQue()->post(ev);
-								}
+								client = client->getNextClient();
 							}
+							continue;
 						}
 					}
-					nextClient:
 					client = client->getNextClient();
 				}
 			}
@@ -181,6 +140,287 @@ void BrokerRecvTask::run(void)
 	}
 }
 
+/**
+ *  Read a packet of the client from the broker and post a BrokerRecvEvent.
+ *  @return false when the broker has closed the connection, client is nullptr if it was deleted.
+ */
+bool BrokerRecvTask::recvPacket(Client*& client)
+{
+	MQTTGWPacket* packet = new MQTTGWPacket();
+	Event* ev = nullptr;
+
+	/* read sockets */
+	_light->blueLight(true);
+	int rc = packet->recv(client->getNetwork());
+	if ( rc > 0 && !client->getBrokerSession()->translate(packet) )
+	{
+		/* a malformed MQTT v5 packet */
+		rc = -2;
+	}
+	if ( rc > 0 )
+	{
+		if ( log(client, packet) == -1 || isLocalEcho(client, packet) )
+		{
+			delete packet;
+			return true;
+		}
+
+		/* post a BrokerRecvEvent */
+		ev = new Event();
+		ev->setBrokerRecvEvent(client, packet);
+		_gateway->getPacketEventQue()->post(ev);
+		return true;
+	}
+
+	if ( rc == 0 )  // Disconnected
+	{
+		client->getNetwork()->close();
+		_gateway->getLocalRouter()->disconnected(client);
+		_gateway->getDuplicateFilter()->erase(client);
+		delete packet;
+
+		/* delete client when the client is not authorized & session is clean */
+		_gateway->getClientList()->erase(client);
+		return false;
+	}
+	else if (rc == -1)
+	{
+		WRITELOG("%s BrokerRecvTask can't receive a packet from the broker errno=%d %s%s\n", ERRMSG_HEADER, errno, client->getClientId(), ERRMSG_FOOTER);
+	}
+	else if ( rc == -2 )
+	{
+		WRITELOG("%s BrokerRecvTask receive invalid length of packet from the broker.  DISCONNECT  %s %s\n", ERRMSG_HEADER, client->getClientId(),ERRMSG_FOOTER);
+	}
+	else if ( rc == -3 )
+	{
+		WRITELOG("%s BrokerRecvTask can't get memories for the packet %s%s\n", ERRMSG_HEADER, client->getClientId(), ERRMSG_FOOTER);
+	}
+
+	delete packet;
+
+	if ( (rc == -1 || rc == -2) && client->isActive() )
+	{
+		/* disconnect the client */
+		packet = new MQTTGWPacket();
+		packet->setHeader(DISCONNECT);
+		ev = new Event();
+		ev->setBrokerRecvEvent(client, packet);
+		_gateway->getPacketEventQue()->post(ev);
+	}
+	return true;
+}
+
+/**
+ *  The loop of IOUring=YES. The client list is scanned once per wakeup as select() does,
+ *  to arm the new connections, and all the completions queued are handled before waiting again.
+ */
+void BrokerRecvTask::runRing(void)
+{
+	IOUringEvent ev;
+
+	while (true)
+	{
+		_light->blueLight(false);
+		if (CHK_SIGINT)
+		{
+			_ring.close();
+			WRITELOG("%s BrokerRecvTask   stopped.\n", currentDateTime());
+			return;
+		}
+		armSockets();
+
+		int rc = _ring.wait(&ev, 500);
+		while ( rc > 0 )
+		{
+			complete(&ev);
+			rc = _ring.wait(&ev, 0);
+		}
+		if ( rc < 0 )
+		{
+			WRITELOG("%s BrokerRecvTask io_uring_enter() failed errno=%d %s%s\n", ERRMSG_HEADER, errno, strerror(errno), ERRMSG_FOOTER);
+			usleep(500 * 1000);
+		}
+	}
+}
+
+/*
+ *  Arm a multishot receive on each new plain connection and a multishot poll on each
+ *  new TLS one. The requests of the connections closed since are cancelled.
+ */
+void BrokerRecvTask::armSockets(void)
+{
+	for ( int i = 0; i < _socketCnt; i++ )
+	{
+		_sockets[i]._seen = false;
+	}
+
+	for ( Client* client = _gateway->getClientList()->getClient(0); client; client = client->getNextClient() )
+	{
+		Network* network = client->getNetwork();
+		int sock = network->getSock();
+		if ( sock <= 0 )
+		{
+			continue;
+		}
+		if ( sock >= _socketCnt )
+		{
+			int cnt = (_socketCnt > 0) ? _socketCnt : 64;
+			while ( cnt <= sock )
+			{
+				cnt *= 2;
+			}
+			BrokerRecvSocket* sockets = new BrokerRecvSocket[cnt];
+			for ( int i = 0; i < _socketCnt; i++ )
+			{
+				sockets[i] = _sockets[i];
+			}
+			delete[] _sockets;
+			_sockets = sockets;
+			_socketCnt = cnt;
+		}
+
+		BrokerRecvSocket* s = &_sockets[sock];
+		if ( s->_armed && s->_client == client && s->_closeCnt == network->getCloseCnt() )
+		{
+			s->_seen = true;
+			continue;
+		}
+		if ( !network->isValid() )
+		{
+			/* a TLS handshake in progress */
+			continue;
+		}
+		disarm(sock);
+
+		uint64_t userData = ((uint64_t)s->_gen << 32) | sock;
+		bool armed = network->isSecure() ? _ring.pollMultishot(sock, userData) : _ring.recvMultishot(sock, userData);
+		if ( armed )
+		{
+			s->_client = client;
+			s->_closeCnt = network->getCloseCnt();
+			s->_armed = true;
+			s->_seen = true;
+		}
+	}
+
+	for ( int i = 0; i < _socketCnt; i++ )
+	{
+		if ( _sockets[i]._armed && !_sockets[i]._seen )
+		{
+			disarm(i);
+		}
+	}
+}
+
+/*
+ *  Cancel the request armed on the socket, its completions are ignored from now on.
+ */
+void BrokerRecvTask::disarm(int sock)
+{
+	BrokerRecvSocket* s = &_sockets[sock];
+	if ( s->_armed )
+	{
+		_ring.cancel(((uint64_t)s->_gen << 32) | sock);
+		s->_armed = false;
+	}
+	s->_client = nullptr;
+	s->_gen = (s->_gen + 1) & 0x7fffffff;
+}
+
+/*
+ *  Handle a completion of the ring: the packets received from a plain connection,
+ *  or a TLS connection that became readable.
+ */
+void BrokerRecvTask::complete(IOUringEvent* ev)
+{
+	int sock = (int)(ev->userData & 0xffffffff);
+	uint32_t gen = (uint32_t)(ev->userData >> 32);
+	BrokerRecvSocket* s = (sock < _socketCnt) ? &_sockets[sock] : nullptr;
+
+	if ( !s || !s->_armed || s->_gen != gen )
+	{
+		/* a cancelled request */
+		_ring.release(ev);
+		return;
+	}
+	if ( !ev->more )
+	{
+		/* armed again by armSockets() unless the connection is closed */
+		s->_armed = false;
+	}
+
+	Client* client = s->_client;
+	Network* network = client->getNetwork();
+	if ( s->_closeCnt != network->getCloseCnt() )
+	{
+		_ring.release(ev);
+		disarm(sock);
+		return;
+	}
+
+	if ( network->isSecure() )
+	{
+		if ( ev->res > 0 && network->isValid() && !recvPacket(client) )
+		{
+			disarm(sock);
+		}
+		return;
+	}
+
+	if ( ev->res > 0 )
+	{
+		network->feed(ev->data, ev->length);
+		_ring.release(ev);
+		while ( network->isReceived() )
+		{
+			if ( !recvPacket(client) )
+			{
+				disarm(sock);
+				return;
+			}
+		}
+	}
+	else if ( ev->res == 0 )  // Disconnected
+	{
+		disarm(sock);
+		network->close();
+		_gateway->getLocalRouter()->disconnected(client);
+		_gateway->getDuplicateFilter()->erase(client);
+		_gateway->getClientList()->erase(client);
+	}
+	else if ( ev->res != -ENOBUFS )
+	{
+		/* the connection is broken, it is not armed again */
+		disarm(sock);
+		WRITELOG("%s BrokerRecvTask can't receive a packet from the broker errno=%d %s%s\n", ERRMSG_HEADER, -ev->res, client->getClientId(), ERRMSG_FOOTER);
+		network->close();
+		if ( client->isActive() )
+		{
+			MQTTGWPacket* packet = new MQTTGWPacket();
+			packet->setHeader(DISCONNECT);
+			Event* event = new Event();
+			event->setBrokerRecvEvent(client, packet);
+			_gateway->getPacketEventQue()->post(event);
+		}
+	}
+}
+
+/**
+ *  The broker's copy of a PUBLISH the LocalRouter already delivered is dropped.
+ *  It is a QoS 0 one, the others are not delivered locally.
+ */
+bool BrokerRecvTask::isLocalEcho(Client* client, MQTTGWPacket* packet)
+{
+	LocalRouter* router = _gateway->getLocalRouter();
+	Publish pub;
+
+	if ( !router->isActive() || packet->getType() != PUBLISH || packet->getPUBLISH(&pub) == 0 )
+	{
+		return false;
+	}
+	return router->isEcho(client, &pub);
+}
+
 /**
  *  write message content into stdout or Ringbuffer
  */
@@ -18,12 +18,29 @@
 
 #include "MQTTSNGWDefines.h"
 #include "MQTTSNGateway.h"
+#include "IOUring.h"
 
 namespace MQTTSNGW
 {
 
+/* A broker connection armed on the IOUring of BrokerRecvTask, indexed by its socket */
+class BrokerRecvSocket
+{
+	friend class BrokerRecvTask;
+private:
+	Client* _client {nullptr};
+	uint32_t _closeCnt {0};     // Network::getCloseCnt() when it was armed
+	uint32_t _gen {0};          // in the userData of the request, tells the completions of a cancelled one
+	bool _armed {false};
+	bool _seen {false};
+};
+
 /*=====================================
  Class BrokerRecvTask
+
+ With IOUring=YES the broker connections stay armed on an IOUring instead of
+ being passed to select() again for each packet: a plain connection is received
+ into the ring's buffers and its packets are read from them, a TLS one is polled.
  =====================================*/
 class BrokerRecvTask: public Thread
 {
@@ -37,9 +54,18 @@ public:
 
 private:
 	int log(Client*, MQTTGWPacket*);
+	bool isLocalEcho(Client*, MQTTGWPacket*);
+	bool recvPacket(Client*& client);
+	void runRing(void);
+	void armSockets(void);
+	void disarm(int sock);
+	void complete(IOUringEvent* ev);
 
 	Gateway* _gateway;
 	LightIndicator* _light;
+	IOUring _ring;
+	BrokerRecvSocket* _sockets {nullptr};
+	int _socketCnt {0};
 };
 
 }
@@ -21,6 +21,7 @@
 #include "MQTTSNGWClient.h"
 #include "MQTTGWPacket.h"
 #include <string.h>
+#include <errno.h>
 
 using namespace std;
 using namespace MQTTSNGW;
@@ -37,6 +38,7 @@ BrokerSendTask::BrokerSendTask(Gateway* gateway)
 	_gateway->attach((Thread*)this);
 	_gwparams = nullptr;
 	_light = nullptr;
+	_pendingCnt = 0;
 }
 
 BrokerSendTask::~BrokerSendTask()
@@ -64,12 +66,19 @@ void BrokerSendTask::run()
 	AdapterManager* adpMgr = _gateway->getAdapterManager();
 	int rc = 0;
 
+	if ( _gwparams->ioUring && !_ring.open() )
+	{
+		WRITELOG("%s BrokerSendTask can't open an io_uring, packets are written one connection at a time.%s\n", ERRMSG_HEADER, ERRMSG_FOOTER);
+	}
+
 	while (true)
 	{
 		ev = _gateway->getBrokerSendQue()->wait();
 
 		if ( ev->getEventType() == EtStop )
 		{
+			flushPending(false);
+			_ring.close();
 			WRITELOG("%s BrokerSendTask   stopped.\n", currentDateTime());
 			delete ev;
 			return;
@@ -85,9 +94,16 @@ void BrokerSendTask::run()
 
 			if ( packet->getType() == CONNECT && client->getNetwork()->isValid() )
 			{
+				client->getNetwork()->flush();
 				client->getNetwork()->close();
 			}
 
+			if ( !client->getNetwork()->isValid() && packet->getType() == CONNECT )
+			{
+				/* a connection opened in advance */
+				_gateway->getBrokerPool()->take(client);
+			}
+
 			if ( !client->getNetwork()->isValid() )
 			{
 				/* connect to the broker and send a packet */
@@ -109,38 +125,150 @@ void BrokerSendTask::run()
 							ERRMSG_HEADER, client->getClientId(), errno, strerror(errno), ERRMSG_FOOTER);
 					delete ev;
 					client->getNetwork()->close();
+					_gateway->getLocalRouter()->disconnected(client);
+					_gateway->getDuplicateFilter()->erase(client);
 					continue;
 				}
 			}
 
-			/* send a packet */
+			/* queue a packet, it is written with the packets of the following events */
 			_light->blueLight(true);
-			if ( (rc = packet->send(client->getNetwork())) > 0 )
+			if ( (rc = packet->queue(client->getNetwork(), client->getBrokerSession(), BROKER_SEND_LATENCY)) > 0 )
 			{
-				if ( packet->getType() == CONNECT )
-				{
-					client->connectSended();
-				}
 				log(client, packet);
+				addPending(client, packet->getType() == CONNECT);
 			}
 			else
 			{
-				WRITELOG("%s BrokerSendTask: %s can't send a packet to the broker. errno=%d %s %s\n",
-						ERRMSG_HEADER, client->getClientId(), rc == -1 ? errno : 0, strerror(errno), ERRMSG_FOOTER);
-				client->getNetwork()->close();
-
-				/* Disconnect the client */
-				packet = new MQTTGWPacket();
-				packet->setHeader(DISCONNECT);
-				Event* ev1 = new Event();
-				ev1->setBrokerRecvEvent(client, packet);
-				_gateway->getPacketEventQue()->post(ev1);
+				sendFailed(client, rc);
 			}
 
 			_light->blueLight(false);
 		}
+		else if ( ev->getEventType() == EtBrokerFlush )
+		{
+			/* PUBLISHes queued by ClientRecvTask, see QoSm1Proxy::publish() */
+			client = ev->getClient();
+			adpMgr->getQoSm1Proxy()->resetPingTimer(client->isSecureNetwork());
+			addPending(client, false);
+		}
 		delete ev;
+
+		/* write the queued packets when there are no more events, or when they have waited long enough */
+		flushPending(_gateway->getBrokerSendQue()->size() > 0);
+	}
+}
+
+void BrokerSendTask::addPending(Client* client, bool connect)
+{
+	for ( int i = 0; i < _pendingCnt; i++ )
+	{
+		if ( _pending[i].client == client )
+		{
+			_pending[i].connect |= connect;
+			return;
+		}
 	}
+	if ( _pendingCnt == BROKER_SEND_MAX_PENDING )
+	{
+		flushPending(false);
+	}
+	client->hold();
+	_pending[_pendingCnt].client = client;
+	_pending[_pendingCnt].connect = connect;
+	_pendingCnt++;
+}
+
+void BrokerSendTask::flushPending(bool dueOnly)
+{
+	Pending inRing[BROKER_SEND_MAX_PENDING];
+	int cnt = 0;
+	int submitted = 0;
+	for ( int i = 0; i < _pendingCnt; i++ )
+	{
+		Pending pending = _pending[i];
+		Network* network = pending.client->getNetwork();
+		if ( pending.client->isErased() )
+		{
+			/* its broker connection is closed, nothing is left to write */
+			pending.client->release();
+			continue;
+		}
+		if ( dueOnly && !network->isFlushDue() )
+		{
+			_pending[cnt++] = pending;
+			continue;
+		}
+		if ( _ring.isOpen() && network->flush(&_ring, submitted) )
+		{
+			inRing[submitted++] = pending;
+			continue;
+		}
+		flushed(&pending, network->flush());
+	}
+	_pendingCnt = cnt;
+
+	/* the writes prepared on the ring are submitted together */
+	IOUringEvent ev;
+	int completed = 0;
+	while ( completed < submitted )
+	{
+		int rc = _ring.wait(&ev, -1);
+		if ( rc < 0 )
+		{
+			WRITELOG("%s BrokerSendTask can't wait on its io_uring, packets are written one connection at a time.%s\n", ERRMSG_HEADER, ERRMSG_FOOTER);
+			_ring.close();
+			break;
+		}
+		if ( rc == 0 )
+		{
+			continue;
+		}
+		completed++;
+		Pending* pending = &inRing[ev.userData];
+		flushed(pending, pending->client->getNetwork()->flushed(ev.res));
+		pending->client = nullptr;
+	}
+
+	/* whether the writes left were made is unknown, their connections can't go on */
+	for ( int i = 0; completed < submitted && i < submitted; i++ )
+	{
+		if ( inRing[i].client )
+		{
+			flushed(&inRing[i], inRing[i].client->getNetwork()->flushed(-EIO));
+		}
+	}
+}
+
+/*
+ *  The packets of a pending client are written, or failed with rc < 0.
+ */
+void BrokerSendTask::flushed(Pending* pending, int rc)
+{
+	if ( rc < 0 )
+	{
+		sendFailed(pending->client, rc);
+	}
+	else if ( pending->connect && !pending->client->isActive() )
+	{
+		/* the CONNACK may already have been handled by BrokerRecvTask */
+		pending->client->connectSended();
+	}
+	pending->client->release();
+}
+
+void BrokerSendTask::sendFailed(Client* client, int rc)
+{
+	WRITELOG("%s BrokerSendTask: %s can't send a packet to the broker. errno=%d %s %s\n",
+			ERRMSG_HEADER, client->getClientId(), rc == -1 ? errno : 0, strerror(errno), ERRMSG_FOOTER);
+	client->getNetwork()->close();
+
+	/* Disconnect the client */
+	MQTTGWPacket* packet = new MQTTGWPacket();
+	packet->setHeader(DISCONNECT);
+	Event* ev1 = new Event();
+	ev1->setBrokerRecvEvent(client, packet);
+	_gateway->getPacketEventQue()->post(ev1);
 }
 
 
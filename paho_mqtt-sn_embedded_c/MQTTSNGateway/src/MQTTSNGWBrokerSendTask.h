@@ -19,6 +19,7 @@
 #include "MQTTSNGWDefines.h"
 #include "MQTTSNGateway.h"
 #include "MQTTSNGWClient.h"
+#include "IOUring.h"
 
 namespace MQTTSNGW
 {
@@ -38,9 +39,21 @@ public:
 	void run();
 private:
 	void log(Client*, MQTTGWPacket*);
+	struct Pending
+	{
+		Client* client;   // held until its packets are written
+		bool connect;     // a CONNECT is queued, the client is connecting once it is written
+	};
+	void addPending(Client* client, bool connect);
+	void flushPending(bool dueOnly);
+	void flushed(Pending* pending, int rc);
+	void sendFailed(Client* client, int rc);
 	Gateway* _gateway;
 	GatewayParams* _gwparams;
 	LightIndicator* _light;
+	Pending _pending[BROKER_SEND_MAX_PENDING];  // clients with packets queued on their network
+	int _pendingCnt;
+	IOUring _ring;     // writes the queued packets of all the plain connections with one syscall, IOUring=YES
 };
 
 }
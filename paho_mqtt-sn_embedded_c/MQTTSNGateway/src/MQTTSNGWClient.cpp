@@ -53,6 +53,11 @@ Client::Client(bool secure)
 	_sessionStatus = false;
 	_prevClient = nullptr;
 	_nextClient = nullptr;
+	_nextById = nullptr;
+	_nextByAddr = nullptr;
+	_nextRetired = nullptr;
+	_holdCnt = 0;
+	_erased = false;
 	_clientSleepPacketQue.setMaxSize(MAX_SAVED_PUBLISH);
 	_proxyPacketQue.setMaxSize(MAX_SAVED_PUBLISH);
 	_hasPredefTopic = false;
@@ -181,9 +186,9 @@ void Client::setWaitedPubTopicId(uint16_t msgId, uint16_t topicId, MQTTSN_topicT
 {
 	_waitedPubTopicIdMap.add(msgId, topicId, type);
 }
-void Client::setWaitedSubTopicId(uint16_t msgId, uint16_t topicId, MQTTSN_topicTypes type)
+void Client::setWaitedSubTopicId(uint16_t msgId, uint16_t topicId, MQTTSN_topicTypes type, bool acked)
 {
-	_waitedSubTopicIdMap.add(msgId, topicId, type);
+	_waitedSubTopicIdMap.add(msgId, topicId, type, acked);
 }
 
 bool Client::checkTimeover(void)
@@ -359,6 +364,11 @@ Network* Client::getNetwork(void)
 	return _network;
 }
 
+MQTTGWv5Session* Client::getBrokerSession(void)
+{
+	return &_brokerSession;
+}
+
 void Client::setClientAddress(SensorNetAddress* sensorNetAddr)
 {
 	_sensorNetAddr = *sensorNetAddr;
@@ -439,6 +449,32 @@ Client* Client::getNextClient(void)
 	return _nextClient;
 }
 
+/*
+ *  Holders are counted from any thread, an erased client is deleted once none is left.
+ */
+void Client::hold(void)
+{
+	__atomic_add_fetch(&_holdCnt, 1, __ATOMIC_RELAXED);
+}
+
+void Client::release(void)
+{
+	__atomic_sub_fetch(&_holdCnt, 1, __ATOMIC_RELEASE);
+}
+
+bool Client::isHeld(void)
+{
+	return __atomic_load_n(&_holdCnt, __ATOMIC_ACQUIRE) > 0;
+}
+
+/*
+ *  Removed from the ClientList, tasks drop what they keep for it.
+ */
+bool Client::isErased(void)
+{
+	return __atomic_load_n(&_erased, __ATOMIC_RELAXED);
+}
+
 void Client::setClientId(MQTTSNString id)
 {
 	if ( _clientId )
@@ -679,8 +715,10 @@ void WaitREGACKPacketList::erase(uint16_t REGACKMsgId)
 				p->_next->_prev = p->_prev;
 			}
 			_cnt--;
+            // Do not delete the packet. It is deleted after sending to Client.
+            p->_packet = nullptr;
+            delete p;
             break;
-            // Do not delete element. Element is deleted after sending to Client.
 		}
 		p = p->_next;
 	}
@@ -29,7 +29,6 @@
 #include "MQTTSNGWEncapsulatedPacket.h"
 #include "MQTTSNGWForwarder.h"
 #include "MQTTSNGWTopic.h"
-#include "MQTTSNGWClientList.h"
 #include "MQTTSNGWAdapter.h"
 
 namespace MQTTSNGW
@@ -194,7 +193,7 @@ public:
     int  setClientSleepPacket(MQTTGWPacket*);
     int setProxyPacket(MQTTSNPacket* packet);
     void setWaitedPubTopicId(uint16_t msgId, uint16_t topicId, MQTTSN_topicTypes type);
-    void setWaitedSubTopicId(uint16_t msgId, uint16_t topicId, MQTTSN_topicTypes type);
+    void setWaitedSubTopicId(uint16_t msgId, uint16_t topicId, MQTTSN_topicTypes type, bool acked = false);
 
     bool checkTimeover(void);
     void updateStatus(MQTTSNPacket*);
@@ -214,6 +213,7 @@ public:
 
     SensorNetAddress* getSensorNetAddress(void);
     Network* getNetwork(void);
+    MQTTGWv5Session* getBrokerSession(void);
     void setClientAddress(SensorNetAddress* sensorNetAddr);
     void setSensorNetType(bool stable);
 
@@ -256,6 +256,11 @@ public:
 
     Client* getNextClient(void);
 
+    void hold(void);        // kept by an Event or a task, see ClientList::erase()
+    void release(void);
+    bool isHeld(void);
+    bool isErased(void);
+
 private:
     PacketQue<MQTTGWPacket> _clientSleepPacketQue;
     PacketQue<MQTTSNPacket> _proxyPacketQue;
@@ -285,6 +290,7 @@ private:
     uint8_t _snMsgId;
 
     Network* _network;      // Broker
+    MQTTGWv5Session _brokerSession;
     bool  _secureNetwork;    // SSL
     bool _sensorNetype;     // false: unstable network like a G3
     SensorNetAddress _sensorNetAddr;
@@ -297,9 +303,16 @@ private:
 
     Client* _nextClient;
     Client* _prevClient;
+    Client* _nextById;      // ClientList hash chains
+    Client* _nextByAddr;
+    Client* _nextRetired;   // erased, see ClientList::erase()
+    int _holdCnt;           // Events and tasks that refer to the client
+    bool _erased;
 };
 
 
 
 }
+
+#include "MQTTSNGWClientList.h"   // after Client, whose hash chains its tables use
 #endif /* MQTTSNGWCLIENT_H_ */
@@ -17,6 +17,7 @@
 #include "MQTTSNGWClientList.h"
 #include "MQTTSNGateway.h"
 #include <string.h>
+#include <time.h>
 #include <string>
 
 using namespace MQTTSNGW;
@@ -43,9 +44,13 @@ ClientList::~ClientList()
     while (cl != nullptr)
     {
         ncl = cl->_nextClient;
-        delete cl;
+        if ( !cl->isHeld() )
+        {
+            delete cl;
+        }
         cl = ncl;
     };
+    deleteRetired(true);
     _mutex.unlock();
 }
 
@@ -63,11 +68,54 @@ void ClientList::initialize(bool aggregate)
     }
 }
 
+/*
+ *  MaxClients raises the number of clients for a large client list,
+ *  ListSnapshot=YES keeps compiled lists next to the text files, see ClientListLoader.
+ *  Read before the first list, which is loaded by the adapters before initialize().
+ */
+void ClientList::readParams(void)
+{
+	char param[MQTTSNGW_PARAM_MAX];
+
+	if ( _paramsRead )
+	{
+		return;
+	}
+	_paramsRead = true;
+
+	if (theGateway->getParam("MaxClients", param) == 0)
+	{
+		_maxClients = atoi(param);
+	}
+	if (theGateway->getParam("ListSnapshot", param) == 0)
+	{
+		_snapshot = !strcasecmp(param, "YES");
+	}
+}
+
+uint16_t ClientList::getMaxClients(void)
+{
+	readParams();
+	return _maxClients;
+}
+
+void ClientList::setMaxClients(uint16_t maxClients)
+{
+	_maxClients = maxClients;
+}
+
+void ClientList::setSnapshot(bool snapshot)
+{
+	_snapshot = snapshot;
+}
+
 void ClientList::setClientList(int type)
 {
 	char param[MQTTSNGW_PARAM_MAX];
 	string fileName;
 	GatewayParams* params = theGateway->getGWParams();
+
+	readParams();
 	if (theGateway->getParam("ClientsList", param) == 0)
 	{
 		fileName = string(param);
@@ -95,6 +143,7 @@ void ClientList::setPredefinedTopics(bool aggrecate)
 	string fileName;
 	GatewayParams* params = theGateway->getGWParams();
 
+	readParams();
 	if (theGateway->getParam("PredefinedTopicList", param) == 0)
 	{
 		fileName = string(param);
@@ -130,118 +179,116 @@ void ClientList::setPredefinedTopics(bool aggrecate)
  *     ClientID3,40000@192.168.200.50,secureConnection
  *     ClientID4,41000@192.168.200.51,unstableLine,secureConnection
  *      ClientID5,41000@192.168.200.51,unstableLine,secureConnection,QoS-1
+ *
+ * The file is read once, the calls for the other client types use the records already loaded.
  */
 
 bool ClientList::createList(const char* fileName, int type)
 {
-    FILE* fp;
-    char buf[MAX_CLIENTID_LENGTH + 256];
-    size_t pos;
-    bool secure;
-    bool stable;
-    bool qos_1;
-    bool forwarder;
-    bool rc = true;
     SensorNetAddress netAddr;
     MQTTSNString clientId = MQTTSNString_initializer;
 
-    if ((fp = fopen(fileName, "r")) != 0)
+    if ( !_clientsLoaded )
     {
-        while (fgets(buf, MAX_CLIENTID_LENGTH + 254, fp) != 0)
+        _clientsLoaded = true;
+        if ( !_clients.load(fileName, ListKind_Clients, _snapshot) )
         {
-            if (*buf == '#')
-            {
-                continue;
-            }
-            string data = string(buf);
-            while ((pos = data.find_first_of(" 　\t\n")) != string::npos)
-            {
-                data.erase(pos, 1);
-            }
-            if (data.empty())
-            {
-                continue;
-            }
-            pos = data.find_first_of(",");
-            string id = data.substr(0, pos);
-            clientId.cstring = strdup(id.c_str());
-            string addr = data.substr(pos + 1);
-
-            if (netAddr.setAddress(&addr) == 0)
-            {
-                qos_1 = (data.find("QoS-1") != string::npos);
-                forwarder = (data.find("forwarder") != string::npos);
-                secure = (data.find("secureConnection") != string::npos);
-                stable = !(data.find("unstableLine") != string::npos);
-                if ( (qos_1 && type == QOSM1PROXY_TYPE) || (!qos_1 && type == AGGREGATER_TYPE) )
-                {
-                	createClient(&netAddr, &clientId, stable, secure, type);
-                }
-                else if ( forwarder && type == FORWARDER_TYPE)
-                {
-                	theGateway->getAdapterManager()->getForwarderList()->addForwarder(&netAddr, &clientId);
-                }
-                else if (type == TRANSPEARENT_TYPE )
-                {
-                	createClient(&netAddr, &clientId, stable, secure, type);
-                }
-            }
-            else
-            {
-                WRITELOG("Invalid address     %s\n", data.c_str());
-                rc = false;
-            }
-            free(clientId.cstring);
+            return true;
         }
-        fclose(fp);
     }
-    return rc;
+
+    for ( uint32_t i = 0; i < _clients.getCount(); i++ )
+    {
+        uint32_t flags = _clients.getFlags(i);
+        bool qos_1 = flags & CLIENTLIST_QOSM1;
+        bool forwarder = flags & CLIENTLIST_FORWARDER;
+        bool secure = flags & CLIENTLIST_SECURE;
+        bool stable = !(flags & CLIENTLIST_UNSTABLE_LINE);
+
+        clientId.cstring = const_cast<char*>(_clients.getClientId(i));
+        _clients.getAddress(i, &netAddr);
+
+        if ( (qos_1 && type == QOSM1PROXY_TYPE) || (!qos_1 && type == AGGREGATER_TYPE) )
+        {
+            createClient(&netAddr, &clientId, stable, secure, type);
+        }
+        else if ( forwarder && type == FORWARDER_TYPE)
+        {
+            theGateway->getAdapterManager()->getForwarderList()->addForwarder(&netAddr, &clientId);
+        }
+        else if (type == TRANSPEARENT_TYPE )
+        {
+            createClient(&netAddr, &clientId, stable, secure, type);
+        }
+    }
+    return _clients.getInvalidCount() == 0;
 }
 
+/*
+ *  ClientId, TopicName, TopicId on each line, ClientId * for the topics of all clients.
+ */
 bool ClientList::readPredefinedList(const char* fileName, bool aggregate)
 {
-    FILE* fp;
-    char buf[MAX_CLIENTID_LENGTH + 256];
-    size_t pos0, pos1;
-    MQTTSNString clientId = MQTTSNString_initializer;;
-    bool rc = false;
+    ClientListLoader topics;
 
-    if ((fp = fopen(fileName, "r")) != 0)
+    if ( !topics.load(fileName, ListKind_PredefinedTopics, _snapshot) )
     {
-        while (fgets(buf, MAX_CLIENTID_LENGTH + 254, fp) != 0)
-        {
-            if (*buf == '#')
-            {
-                continue;
-            }
-            string data = string(buf);
-            while ((pos0 = data.find_first_of(" 　\t\n")) != string::npos)
-            {
-                data.erase(pos0, 1);
-            }
-            if (data.empty())
-            {
-                continue;
-            }
-
-            pos0 = data.find_first_of(",");
-            pos1 = data.find(",", pos0 + 1) ;
-            string id = data.substr(0, pos0);
-            clientId.cstring = strdup(id.c_str());
-            string topicName = data.substr(pos0 + 1, pos1 - pos0 -1);
-            uint16_t topicID = stoul(data.substr(pos1 + 1));
-            createPredefinedTopic( &clientId, topicName,  topicID, aggregate);
-            free(clientId.cstring);
-        }
-        fclose(fp);
-        rc = true;
+        WRITELOG("ClientList can not open the Predefined Topic List.     %s\n", fileName);
+        return false;
+    }
+
+    for ( uint32_t i = 0; i < topics.getCount(); i++ )
+    {
+        createPredefinedTopic(topics.getClientId(i), topics.getTopicName(i), topics.getTopicId(i), aggregate);
+    }
+    return true;
+}
+
+/*
+ *  Clients are kept in two hash tables, one by ClientId and one by SensorNetAddress
+ *  for the clients that have one.  Used with _mutex locked.
+ */
+uint32_t ClientList::hashId(Client* client)
+{
+    return hashBytes(client->_clientId, strlen(client->_clientId));
+}
+
+uint32_t ClientList::hashAddr(Client* client)
+{
+    return client->_sensorNetAddr.hash();
+}
+
+/* Add a client at the end of the list and into the tables. Called with _mutex locked. */
+void ClientList::linkClient(Client* client, bool indexAddress)
+{
+    if ( _firstClient == nullptr )
+    {
+        _firstClient = client;
+        _endClient = client;
     }
     else
     {
-        WRITELOG("ClientList can not open the Predefined Topic List.     %s\n", fileName);
-        return false;
+        _endClient->_nextClient = client;
+        client->_prevClient = _endClient;
+        _endClient = client;
+    }
+    _clientCnt++;
+
+    _idTable.add(client);
+    if ( indexAddress )
+    {
+        _addrTable.add(client);
     }
-    return rc;
+}
+
+/* Set the SensorNetAddress of a client that connects from a new address */
+void ClientList::setClientAddress(Client* client, SensorNetAddress* addr)
+{
+    _mutex.lock();
+    _addrTable.remove(client);
+    client->setClientAddress(addr);
+    _addrTable.add(client);
+    _mutex.unlock();
 }
 
 void ClientList::erase(Client*& client)
@@ -270,36 +317,79 @@ void ClientList::erase(Client*& client)
             _endClient = prev;
         }
         _clientCnt--;
+
+        _idTable.remove(client);
+        _addrTable.remove(client);
+
         Forwarder* fwd = client->getForwarder();
         if ( fwd )
         {
             fwd->eraseClient(client);
         }
-        delete client;
+        forget(client);
+
+        /* Events and tasks may still hold the client, e.g. the DISCONNECT sent to it when
+           the broker closes the connection at once. It is deleted by a later erase() once
+           they have all released it. */
+        __atomic_store_n(&client->_erased, true, __ATOMIC_RELAXED);
+        client->_nextRetired = _retired;
+        _retired = client;
+        deleteRetired(false);
         client = nullptr;
         _mutex.unlock();
     }
 }
 
+/*
+ *  Drop the entries of the gateway-wide tables keyed by the client.
+ */
+void ClientList::forget(Client* client)
+{
+    theGateway->getLocalRouter()->erase(client);
+    theGateway->getDuplicateFilter()->erase(client);
+    theGateway->getRetainedCache()->forget(client);
+}
+
+/*
+ *  Delete the erased clients no Event or task holds any more.
+ *  Those still held at exit are left to the process.
+ */
+void ClientList::deleteRetired(bool exiting)
+{
+    Client** pp = &_retired;
+    while ( *pp )
+    {
+        Client* cl = *pp;
+        if ( cl->isHeld() )
+        {
+            pp = &cl->_nextRetired;
+            continue;
+        }
+        *pp = cl->_nextRetired;
+        if ( !exiting )
+        {
+            /* handled since erase(), the events may have added entries again */
+            forget(cl);
+        }
+        delete cl;
+    }
+}
+
 Client* ClientList::getClient(SensorNetAddress* addr)
 {
+    Client* client = nullptr;
+
     if ( addr )
     {
         _mutex.lock();
-        Client* client = _firstClient;
-
-        while (client != nullptr)
+        client = _addrTable.first(addr->hash());
+        while ( client != nullptr && !client->getSensorNetAddress()->isMatch(addr) )
         {
-            if (client->getSensorNetAddress()->isMatch(addr) )
-            {
-                _mutex.unlock();
-                return client;
-            }
-            client = client->_nextClient;
+            client = client->_nextByAddr;
         }
         _mutex.unlock();
     }
-    return 0;
+    return client;
 }
 
 Client* ClientList::getClient(int index)
@@ -324,8 +414,6 @@ Client* ClientList::getClient(int index)
 
 Client* ClientList::getClient(MQTTSNString* clientId)
 {
-    _mutex.lock();
-    Client* client = _firstClient;
     const char* clID =clientId->cstring;
 
     if (clID == nullptr )
@@ -333,17 +421,23 @@ Client* ClientList::getClient(MQTTSNString* clientId)
         clID = clientId->lenstring.data;
     }
 
-    while (client != nullptr)
+    _mutex.lock();
+    Client* client = findClient(clID, MQTTSNstrlen(*clientId));
+    _mutex.unlock();
+    return client;
+}
+
+/* Called with _mutex locked */
+Client* ClientList::findClient(const char* clientId, uint32_t len)
+{
+    for ( Client* client = _idTable.first(hashBytes(clientId, len)); client; client = client->_nextById )
     {
-        if (strncmp((const char*)client->getClientId(), clID, MQTTSNstrlen(*clientId)) == 0 )
+        if ( strncmp(client->_clientId, clientId, len) == 0 && client->_clientId[len] == 0 )
         {
-            _mutex.unlock();
             return client;
         }
-        client = client->_nextClient;
     }
-    _mutex.unlock();
-    return 0;
+    return nullptr;
 }
 
 Client* ClientList::createClient(SensorNetAddress* addr, MQTTSNString* clientId, int type)
@@ -356,7 +450,7 @@ Client* ClientList::createClient(SensorNetAddress* addr, MQTTSNString* clientId,
     Client* client = nullptr;
 
     /*  anonimous clients */
-    if ( _clientCnt > MAX_CLIENTS )
+    if ( _clientCnt > _maxClients )
     {
         return 0;  // full of clients
     }
@@ -398,73 +492,55 @@ Client* ClientList::createClient(SensorNetAddress* addr, MQTTSNString* clientId,
     _mutex.lock();
 
     /* add the list */
-    if ( _firstClient == nullptr )
-    {
-        _firstClient = client;
-        _endClient = client;
-    }
-    else
-    {
-        _endClient->_nextClient = client;
-        client->_prevClient = _endClient;
-        _endClient = client;
-    }
-    _clientCnt++;
+    linkClient(client, addr != nullptr);
     _mutex.unlock();
     return client;
 }
 
-Client* ClientList::createPredefinedTopic( MQTTSNString* clientId, string topicName, uint16_t topicId, bool aggregate)
+Client* ClientList::createPredefinedTopic(const char* clientId, const char* topicName, uint16_t topicId, bool aggregate)
 {
-	if ( clientId->cstring == common_topic )
+	if ( strcmp(clientId, common_topic) == 0 )
 	{
-		_gateway->getTopics()->add((const char*)topicName.c_str(), topicId);
+		theGateway->getTopics()->add(topicName, topicId);
 		return 0;
 	}
 	else
 	{
-		Client* client = getClient(clientId);
+		_mutex.lock();
+		Client* client = findClient(clientId, strlen(clientId));
 
 		if ( _authorize && client == nullptr )
 		{
+			_mutex.unlock();
 			return 0;
 		}
 
-		/*  anonimous clients */
-		if ( _clientCnt > MAX_CLIENTS )
-		{
-			return nullptr;  // full of clients
-		}
-
 		if ( client == nullptr )
 		{
+			/*  anonimous clients */
+			if ( _clientCnt > _maxClients )
+			{
+				_mutex.unlock();
+				return nullptr;  // full of clients
+			}
+
 			/* creat a new client */
+			MQTTSNString id = MQTTSNString_initializer;
+			id.cstring = const_cast<char*>(clientId);
 			client = new Client();
-			client->setClientId(*clientId);
+			client->setClientId(id);
 			if ( aggregate )
 			{
 				client->setAggregated();
 			}
-			_mutex.lock();
 
 			/* add the list */
-			if ( _firstClient == nullptr )
-			{
-				_firstClient = client;
-				_endClient = client;
-			}
-			else
-			{
-				_endClient->_nextClient = client;
-				client->_prevClient = _endClient;
-				_endClient = client;
-			}
-			_clientCnt++;
-			_mutex.unlock();
+			linkClient(client, false);
 		}
+		_mutex.unlock();
 
 		// create Topic & Add it
-		client->getTopics()->add((const char*)topicName.c_str(), topicId);
+		client->getTopics()->add(topicName, topicId);
 		client->_hasPredefTopic = true;
 		return client;
 	}
@@ -479,5 +555,3 @@ bool ClientList::isAuthorized()
 {
     return _authorize;
 }
-
-
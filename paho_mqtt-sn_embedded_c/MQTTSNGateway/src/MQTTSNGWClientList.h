@@ -20,6 +20,7 @@
 
 #include "MQTTSNGWClient.h"
 #include "MQTTSNGateway.h"
+#include "MQTTSNGWClientListLoader.h"
 
 namespace MQTTSNGW
 {
@@ -28,6 +29,8 @@ namespace MQTTSNGW
 #define AGGREGATER_TYPE 2
 #define FORWARDER_TYPE  3
 
+#define CLIENTLIST_INITIAL_TABLE_SIZE  64  // Buckets of the client tables, doubled when they fill up
+
 class Client;
 
 /*=====================================
@@ -46,22 +49,41 @@ public:
     Client* createClient(SensorNetAddress* addr, MQTTSNString* clientId,int type);
     Client* createClient(SensorNetAddress* addr, MQTTSNString* clientId, bool unstableLine, bool secure, int type);
     bool createList(const char* fileName, int type);
+    bool readPredefinedList(const char* fileName, bool _aggregate);
+    void setClientAddress(Client* client, SensorNetAddress* addr);
+    void setMaxClients(uint16_t maxClients);
+    void setSnapshot(bool snapshot);
     Client* getClient(SensorNetAddress* addr);
     Client* getClient(MQTTSNString* clientId);
     Client* getClient(int index);
     uint16_t getClientCount(void);
+    uint16_t getMaxClients(void);
     Client* getClient(void);
     bool isAuthorized();
 
 private:
-    bool readPredefinedList(const char* fileName, bool _aggregate);
-    Gateway* _gateway {nullptr};
-    Client* createPredefinedTopic( MQTTSNString* clientId, string topicName, uint16_t toipcId, bool _aggregate);
+    void readParams(void);
+    Client* createPredefinedTopic(const char* clientId, const char* topicName, uint16_t toipcId, bool _aggregate);
+    Client* findClient(const char* clientId, uint32_t len);
+    void linkClient(Client* client, bool indexAddress);
+    static uint32_t hashId(Client* client);
+    static uint32_t hashAddr(Client* client);
+    void forget(Client* client);
+    void deleteRetired(bool exiting);
+
     Client* _firstClient;
     Client* _endClient;
+    Client* _retired {nullptr};      // erased clients, the latest first
+    HashTable<Client, &Client::_nextById, &ClientList::hashId> _idTable {CLIENTLIST_INITIAL_TABLE_SIZE};
+    HashTable<Client, &Client::_nextByAddr, &ClientList::hashAddr> _addrTable {CLIENTLIST_INITIAL_TABLE_SIZE};   // clients with a SensorNetAddress
     Mutex _mutex;
     uint16_t _clientCnt;
+    uint16_t _maxClients {MAX_CLIENTS};
     bool _authorize {false};
+    bool _snapshot {false};
+    bool _paramsRead {false};
+    bool _clientsLoaded {false};
+    ClientListLoader _clients;       // clients.conf, read once for all client types
 };
 
 
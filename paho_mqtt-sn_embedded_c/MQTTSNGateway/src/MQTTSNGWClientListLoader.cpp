@@ -0,0 +1,442 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - one pass loader of the clients and topics files
+ **************************************************************************************/
+
+#include "MQTTSNGWClientListLoader.h"
+#include "MQTTSNGWProcess.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+using namespace std;
+using namespace MQTTSNGW;
+
+#define CLIENTLIST_MAX_FIELDS        8
+#define CLIENTLIST_INITIAL_RECORDS 256   // doubled when they fill up
+
+/* Records are arrays of uint32_t, a client record ends with the SensorNetAddress */
+#define CLIENT_RECORD_SIZE  (8 + ((sizeof(SensorNetAddress) + 3) & ~3))
+#define TOPIC_RECORD_SIZE   12
+
+/*=====================================
+ Class ClientListLoader
+ =====================================*/
+ClientListLoader::ClientListLoader()
+{
+}
+
+ClientListLoader::~ClientListLoader()
+{
+    clear();
+}
+
+void ClientListLoader::clear(void)
+{
+    if ( _mapped )
+    {
+        munmap(_mapped, _mappedLength);
+    }
+    else
+    {
+        free(_header);
+        free(_records);
+        free(_strings);
+    }
+    _header = nullptr;
+    _records = nullptr;
+    _strings = nullptr;
+    _mapped = nullptr;
+    _mappedLength = 0;
+    _recordCapacity = 0;
+    _stringLength = 0;
+    _stringCapacity = 0;
+    _lastClientId = 0;
+}
+
+/**
+ * Load a list file.
+ * @param fileName   clients.conf or predefinedTopic.conf
+ * @param snapshot   true: map fileName.snapshot if it was compiled from the current text file, write it otherwise
+ * @return false if the file can't be read
+ */
+bool ClientListLoader::load(const char* fileName, ClientListKind kind, bool snapshot)
+{
+    struct stat st;
+
+    clear();
+    if ( stat(fileName, &st) != 0 )
+    {
+        return false;
+    }
+    _sourceSize = st.st_size;
+    _sourceMtime = (uint64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+
+    string snapshotName = string(fileName) + CLIENTLIST_SNAPSHOT_SUFFIX;
+    if ( snapshot && map(snapshotName.c_str(), kind) )
+    {
+        return true;
+    }
+
+    if ( !parse(fileName, kind) )
+    {
+        return false;
+    }
+
+    if ( snapshot && _header->invalidCnt == 0 )
+    {
+        save(snapshotName.c_str());
+    }
+    return true;
+}
+
+bool ClientListLoader::isSnapshot(void)
+{
+    return _mapped != nullptr;
+}
+
+uint32_t ClientListLoader::getCount(void)
+{
+    return _header ? _header->count : 0;
+}
+
+uint32_t ClientListLoader::getInvalidCount(void)
+{
+    return _header ? _header->invalidCnt : 0;
+}
+
+uint8_t* ClientListLoader::getRecord(uint32_t index)
+{
+    return _records + index * _header->recordSize;
+}
+
+const char* ClientListLoader::getClientId(uint32_t index)
+{
+    return _strings + ((uint32_t*)getRecord(index))[0];
+}
+
+uint32_t ClientListLoader::getFlags(uint32_t index)
+{
+    return ((uint32_t*)getRecord(index))[1];
+}
+
+void ClientListLoader::getAddress(uint32_t index, SensorNetAddress* addr)
+{
+    memcpy((void*)addr, getRecord(index) + 8, sizeof(SensorNetAddress));
+}
+
+const char* ClientListLoader::getTopicName(uint32_t index)
+{
+    return _strings + ((uint32_t*)getRecord(index))[1];
+}
+
+uint16_t ClientListLoader::getTopicId(uint32_t index)
+{
+    return (uint16_t)((uint32_t*)getRecord(index))[2];
+}
+
+/*
+ *  Read the whole file and parse it line by line.
+ *  Blanks are removed, fields are separated by commas and lines beginning with # are comments.
+ */
+bool ClientListLoader::parse(const char* fileName, ClientListKind kind)
+{
+    FILE* fp = fopen(fileName, "r");
+    if ( fp == nullptr )
+    {
+        return false;
+    }
+
+    char* buf = (char*)malloc(_sourceSize + 1);
+    size_t len = buf ? fread(buf, 1, _sourceSize, fp) : 0;
+    fclose(fp);
+    if ( buf == nullptr )
+    {
+        return false;
+    }
+    buf[len] = 0;
+
+    _header = (ClientListHeader*)calloc(1, sizeof(ClientListHeader));
+    _header->magic = CLIENTLIST_SNAPSHOT_MAGIC;
+    _header->version = CLIENTLIST_SNAPSHOT_VERSION;
+    _header->kind = kind;
+    _header->addressSize = sizeof(SensorNetAddress);
+    _header->recordSize = (kind == ListKind_Clients) ? CLIENT_RECORD_SIZE : TOPIC_RECORD_SIZE;
+    _header->sourceSize = _sourceSize;
+    _header->sourceMtime = _sourceMtime;
+
+    char* end = buf + len;
+    char* line = buf;
+    while ( line < end )
+    {
+        char* eol = (char*)memchr(line, '\n', end - line);
+        if ( eol == nullptr )
+        {
+            eol = end;
+        }
+
+        if ( *line != '#' )
+        {
+            char* fields[CLIENTLIST_MAX_FIELDS];
+            int cnt = 1;
+            char* w = line;
+            fields[0] = line;
+
+            for ( char* r = line; r < eol; r++ )
+            {
+                uint8_t c = (uint8_t)*r;
+                if ( c == ' ' || c == '\t' || c == '\r' )
+                {
+                    continue;
+                }
+                if ( c == 0xE3 && r + 2 < eol && (uint8_t)r[1] == 0x80 && (uint8_t)r[2] == 0x80 )
+                {
+                    r += 2;    // ideographic space
+                    continue;
+                }
+                if ( c == ',' )
+                {
+                    *w++ = 0;
+                    if ( cnt < CLIENTLIST_MAX_FIELDS )
+                    {
+                        fields[cnt++] = w;
+                    }
+                    continue;
+                }
+                *w++ = c;
+            }
+            *w = 0;
+
+            if ( cnt > 1 || *fields[0] )
+            {
+                uint8_t* record = addRecord();
+                bool rc = (kind == ListKind_Clients) ? parseClient(fields, cnt, record) : parseTopic(fields, cnt, record);
+                if ( rc )
+                {
+                    _header->count++;
+                }
+                else
+                {
+                    WRITELOG("Invalid line     %s,%s\n", fields[0], cnt > 1 ? fields[1] : "");
+                    _header->invalidCnt++;
+                }
+            }
+        }
+        line = eol + 1;
+    }
+    free(buf);
+    return true;
+}
+
+/* ClientId, SensorNetAddress, "unstableLine", "secureConnection", "QoS-1", "forwarder" */
+bool ClientListLoader::parseClient(char** fields, int cnt, uint8_t* record)
+{
+    SensorNetAddress netAddr;
+    uint32_t flags = 0;
+
+    if ( cnt < 2 )
+    {
+        return false;
+    }
+    string addr = string(fields[1]);
+    if ( netAddr.setAddress(&addr) != 0 )
+    {
+        return false;
+    }
+
+    for ( int i = 2; i < cnt; i++ )
+    {
+        if ( strcmp(fields[i], "unstableLine") == 0 )
+        {
+            flags |= CLIENTLIST_UNSTABLE_LINE;
+        }
+        else if ( strcmp(fields[i], "secureConnection") == 0 )
+        {
+            flags |= CLIENTLIST_SECURE;
+        }
+        else if ( strcmp(fields[i], "QoS-1") == 0 )
+        {
+            flags |= CLIENTLIST_QOSM1;
+        }
+        else if ( strcmp(fields[i], "forwarder") == 0 )
+        {
+            flags |= CLIENTLIST_FORWARDER;
+        }
+    }
+
+    uint32_t* rec = (uint32_t*)record;
+    rec[0] = addString(fields[0]);
+    rec[1] = flags;
+    memcpy(record + 8, (void*)&netAddr, sizeof(SensorNetAddress));
+    return true;
+}
+
+/* ClientId, TopicName, TopicId */
+bool ClientListLoader::parseTopic(char** fields, int cnt, uint8_t* record)
+{
+    char* endp;
+
+    if ( cnt < 3 || *fields[1] == 0 )
+    {
+        return false;
+    }
+    unsigned long topicId = strtoul(fields[2], &endp, 10);
+    if ( endp == fields[2] || *endp || topicId > 0xffff )
+    {
+        return false;
+    }
+
+    uint32_t* rec = (uint32_t*)record;
+
+    /* the topics of a client are usually on consecutive lines */
+    if ( _stringLength && strcmp(_strings + _lastClientId, fields[0]) == 0 )
+    {
+        rec[0] = _lastClientId;
+    }
+    else
+    {
+        rec[0] = _lastClientId = addString(fields[0]);
+    }
+    rec[1] = addString(fields[1]);
+    rec[2] = (uint32_t)topicId;
+    return true;
+}
+
+uint32_t ClientListLoader::addString(const char* str)
+{
+    uint32_t len = strlen(str) + 1;
+    if ( _stringLength + len > _stringCapacity )
+    {
+        _stringCapacity = (_stringCapacity ? _stringCapacity * 2 : CLIENTLIST_INITIAL_RECORDS * 16) + len;
+        _strings = (char*)realloc(_strings, _stringCapacity);
+    }
+    uint32_t offset = _stringLength;
+    memcpy(_strings + offset, str, len);
+    _stringLength += len;
+    return offset;
+}
+
+/* the slot after the last record, it becomes a record when the count is incremented */
+uint8_t* ClientListLoader::addRecord(void)
+{
+    if ( _header->count == _recordCapacity )
+    {
+        _recordCapacity = _recordCapacity ? _recordCapacity * 2 : CLIENTLIST_INITIAL_RECORDS;
+        _records = (uint8_t*)realloc(_records, _recordCapacity * _header->recordSize);
+    }
+    return getRecord(_header->count);
+}
+
+/*
+ *  Write the header, the records and the strings, to a temporary file renamed when it is complete.
+ */
+void ClientListLoader::save(const char* snapshotName)
+{
+    ClientListHeader header = *_header;
+    header.recordOffset = sizeof(ClientListHeader);
+    header.stringOffset = header.recordOffset + header.count * header.recordSize;
+    header.length = header.stringOffset + _stringLength;
+
+    string tmpName = string(snapshotName) + ".tmp";
+    FILE* fp = fopen(tmpName.c_str(), "w");
+    if ( fp == nullptr )
+    {
+        WRITELOG("ClientListLoader can't write the snapshot %s\n", snapshotName);
+        return;
+    }
+    bool rc = fwrite(&header, sizeof(header), 1, fp) == 1
+            && fwrite(_records, header.recordSize, header.count, fp) == header.count
+            && fwrite(_strings, 1, _stringLength, fp) == _stringLength;
+    rc = (fclose(fp) == 0) && rc;
+
+    if ( !rc || rename(tmpName.c_str(), snapshotName) != 0 )
+    {
+        WRITELOG("ClientListLoader can't write the snapshot %s\n", snapshotName);
+        unlink(tmpName.c_str());
+    }
+}
+
+/*
+ *  Map a snapshot, checked against the text file and this gateway's SensorNetAddress.
+ *  @return false if there is no usable snapshot
+ */
+bool ClientListLoader::map(const char* snapshotName, ClientListKind kind)
+{
+    struct stat st;
+    int fd = open(snapshotName, O_RDONLY);
+    if ( fd < 0 )
+    {
+        return false;
+    }
+    if ( fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(ClientListHeader) || st.st_size > 0xffffffff )
+    {
+        close(fd);
+        return false;
+    }
+    void* mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if ( mapped == MAP_FAILED )
+    {
+        return false;
+    }
+
+    ClientListHeader* header = (ClientListHeader*)mapped;
+    uint32_t recordSize = (kind == ListKind_Clients) ? CLIENT_RECORD_SIZE : TOPIC_RECORD_SIZE;
+    bool valid = header->magic == CLIENTLIST_SNAPSHOT_MAGIC
+            && header->version == CLIENTLIST_SNAPSHOT_VERSION
+            && header->kind == (uint32_t)kind
+            && header->addressSize == sizeof(SensorNetAddress)
+            && header->recordSize == recordSize
+            && header->length == (uint32_t)st.st_size
+            && header->invalidCnt == 0
+            && header->sourceSize == _sourceSize
+            && header->sourceMtime == _sourceMtime
+            && header->recordOffset == sizeof(ClientListHeader)
+            && header->count <= (header->length - header->recordOffset) / recordSize
+            && header->stringOffset == header->recordOffset + header->count * recordSize
+            && header->stringOffset <= header->length;
+
+    uint32_t stringLength = valid ? header->length - header->stringOffset : 0;
+    const char* strings = (const char*)mapped + header->stringOffset;
+    if ( valid && stringLength )
+    {
+        valid = strings[stringLength - 1] == 0;
+    }
+
+    /* every string offset must be inside the strings */
+    for ( uint32_t i = 0; valid && i < header->count; i++ )
+    {
+        uint32_t* rec = (uint32_t*)((uint8_t*)mapped + header->recordOffset + i * recordSize);
+        valid = rec[0] < stringLength && (kind == ListKind_Clients || rec[1] < stringLength);
+    }
+
+    if ( !valid )
+    {
+        munmap(mapped, st.st_size);
+        return false;
+    }
+
+    _mapped = mapped;
+    _mappedLength = st.st_size;
+    _header = header;
+    _records = (uint8_t*)mapped + header->recordOffset;
+    _strings = (char*)mapped + header->stringOffset;
+    _stringLength = stringLength;
+    return true;
+}
@@ -0,0 +1,111 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - one pass loader of the clients and topics files
+ **************************************************************************************/
+
+#ifndef MQTTSNGATEWAY_SRC_MQTTSNGWCLIENTLISTLOADER_H_
+#define MQTTSNGATEWAY_SRC_MQTTSNGWCLIENTLISTLOADER_H_
+
+#include "MQTTSNGWDefines.h"
+#include "SensorNetwork.h"
+
+#define CLIENTLIST_SNAPSHOT_SUFFIX   ".snapshot"
+#define CLIENTLIST_SNAPSHOT_MAGIC    0x4c4e534d  // "MSNL"
+#define CLIENTLIST_SNAPSHOT_VERSION  1
+
+/* flags of a client record */
+#define CLIENTLIST_UNSTABLE_LINE   0x01
+#define CLIENTLIST_SECURE          0x02
+#define CLIENTLIST_QOSM1           0x04
+#define CLIENTLIST_FORWARDER       0x08
+
+namespace MQTTSNGW
+{
+
+typedef enum
+{
+    ListKind_Clients = 1, ListKind_PredefinedTopics
+} ClientListKind;
+
+/* Header of a loaded list, followed by its records and its NUL terminated strings */
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t kind;
+    uint32_t addressSize;     // sizeof(SensorNetAddress) of the gateway that wrote it
+    uint32_t count;
+    uint32_t recordSize;
+    uint32_t recordOffset;
+    uint32_t stringOffset;
+    uint32_t length;
+    uint32_t invalidCnt;      // lines that could not be parsed, never saved in a snapshot
+    uint64_t sourceSize;      // size and mtime of the text file it was compiled from
+    uint64_t sourceMtime;
+} ClientListHeader;
+
+/*=====================================
+ Class ClientListLoader
+
+ Reads clients.conf or predefinedTopic.conf in one pass into one block of memory,
+ records of string offsets and parsed addresses, that ClientList builds its tables from.
+ With a snapshot the block is also written next to the text file and mapped
+ instead of parsing the text again, as long as the text file is unchanged.
+ =====================================*/
+class ClientListLoader
+{
+public:
+    ClientListLoader();
+    ~ClientListLoader();
+
+    bool load(const char* fileName, ClientListKind kind, bool snapshot);
+    bool isSnapshot(void);
+    uint32_t getCount(void);
+    uint32_t getInvalidCount(void);
+
+    /* clients.conf */
+    const char* getClientId(uint32_t index);
+    uint32_t getFlags(uint32_t index);
+    void getAddress(uint32_t index, SensorNetAddress* addr);
+
+    /* predefinedTopic.conf */
+    const char* getTopicName(uint32_t index);
+    uint16_t getTopicId(uint32_t index);
+
+private:
+    void clear(void);
+    bool parse(const char* fileName, ClientListKind kind);
+    bool map(const char* snapshotName, ClientListKind kind);
+    void save(const char* snapshotName);
+    bool parseClient(char** fields, int cnt, uint8_t* record);
+    bool parseTopic(char** fields, int cnt, uint8_t* record);
+    uint32_t addString(const char* str);
+    uint8_t* addRecord(void);
+    uint8_t* getRecord(uint32_t index);
+
+    ClientListHeader* _header {nullptr};
+    uint8_t* _records {nullptr};
+    char* _strings {nullptr};
+    uint32_t _recordCapacity {0};
+    uint32_t _stringLength {0};
+    uint32_t _stringCapacity {0};
+    uint32_t _lastClientId {0};
+    void* _mapped {nullptr};
+    uint32_t _mappedLength {0};
+    uint64_t _sourceSize {0};
+    uint64_t _sourceMtime {0};
+};
+
+}
+#endif /* MQTTSNGATEWAY_SRC_MQTTSNGWCLIENTLISTLOADER_H_ */
@@ -117,12 +117,16 @@ void ClientRecvTask::run()
 				fwdName.cstring = const_cast<char *>( fwd->getName() );
 				log(0, packet, &fwdName);
 
-				/* get the packet from the encapsulation message */
+				/* get the packet from the encapsulation message, the packet itself becomes the encapsulated one */
 				MQTTSNGWEncapsulatedPacket  encap;
-				encap.desirialize(packet->getPacketData(), packet->getPacketLength());
+				if ( encap.desirialize(packet) < 0 )
+				{
+					WRITELOG("%s Forwarder(%s) sent an invalid encapsulated message. message has been discarded.%s\n", ERRMSG_HEADER, fwd->getName(), ERRMSG_FOOTER);
+					delete packet;
+					continue;
+				}
 				nodeId.setId( encap.getWirelessNodeId() );
 				client = fwd->getClient(&nodeId);
-				packet = encap.getMQTTSNPacket();
 			}
 		}
 		else
@@ -131,10 +135,11 @@ void ClientRecvTask::run()
 
 			if ( qosm1Proxy->isActive() )
 			{
-				 const char* clientName = qosm1Proxy->getClientId(senderAddr);
+				Client* qosm1Client = qosm1Proxy->getClient(senderAddr);
 
-				if ( clientName )
+				if ( qosm1Client )
 				{
+					const char* clientName = qosm1Client->getClientId();
 					if ( !packet->isQoSMinusPUBLISH() )
 					{
 						client = qosm1Proxy->getClient();
@@ -143,12 +148,18 @@ void ClientRecvTask::run()
 						delete packet;
 						continue;
 					}
+
+					/* sent to the broker from here while the proxy is connected, counted instead of logged */
+					if ( qosm1Proxy->publish(qosm1Client, packet) != 0 )
+					{
+						delete packet;
+						continue;
+					}
 				}
 			}
+			client = _gateway->getClientList()->getClient(senderAddr);
 		}
 
-		client = _gateway->getClientList()->getClient(senderAddr);
-
 		if ( client )
 		{
 			/* write log and post Event */
@@ -189,7 +200,7 @@ void ClientRecvTask::run()
                     if ( client )
                     {
                         /* Client exists. Set SensorNet Address of it. */
-                        client->setClientAddress(senderAddr);
+                        clientList->setClientAddress(client, senderAddr);
                     }
                     else
                     {
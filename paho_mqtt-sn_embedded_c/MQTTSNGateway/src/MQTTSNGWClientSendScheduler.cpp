@@ -0,0 +1,339 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - fair scheduling of the packets sent to clients
+ **************************************************************************************/
+#include "MQTTSNGWClientSendScheduler.h"
+#include "MQTTSNGWPacket.h"
+#include "MQTTSNGWPacketBurst.h"
+
+using namespace MQTTSNGW;
+using namespace std;
+
+/*=====================================
+ Class ClientSendFlow
+ =====================================*/
+ClientSendFlow::ClientSendFlow()
+{
+    _client = nullptr;
+    _deficit = 0;
+    _turn = false;
+    _next = nullptr;
+    _nextByClient = nullptr;
+    _que.setMaxSize(CLIENTSEND_MAX_QUEUED);
+}
+
+ClientSendFlow::~ClientSendFlow()
+{
+
+}
+
+/*=====================================
+ Class ClientSendScheduler
+ =====================================*/
+ClientSendScheduler::ClientSendScheduler()
+{
+    _active = nullptr;
+    _tail = nullptr;
+    _free = nullptr;
+    _cnt = 0;
+    _dropCnt = 0;
+    _rate = 0;
+    _depth = 0;
+    _tokens = 0;
+    _lastUsec = 0;
+    _maxControl = MAX_INFLIGHTMESSAGES * MAX_CLIENTS;
+}
+
+ClientSendScheduler::~ClientSendScheduler()
+{
+    clear();
+    while (_free)
+    {
+        ClientSendFlow* next = _free->_next;
+        delete _free;
+        _free = next;
+    }
+}
+
+/*
+ *  @param bytesPerSec  0 for no limit
+ */
+void ClientSendScheduler::setRate(uint32_t bytesPerSec)
+{
+    /* one second of traffic at most, and never less than a packet */
+    _rate = bytesPerSec;
+    _depth = (int64_t)(_rate > MQTTSNGW_MAX_PACKET_SIZE ? _rate : MQTTSNGW_MAX_PACKET_SIZE) * 1000000;
+    _tokens = _depth;
+    _lastUsec = 0;
+}
+
+/*
+ *  @param maxClients  MaxClients of the gateway, the control packets are not limited
+ *                     but ClientSendTask waits for them past MAX_INFLIGHTMESSAGES per client
+ */
+void ClientSendScheduler::setMaxClients(int maxClients)
+{
+    _maxControl = MAX_INFLIGHTMESSAGES * maxClients;
+}
+
+bool ClientSendScheduler::isControlFull(void)
+{
+    return _controlQue.size() > 0 && _controlQue.size() >= _maxControl;
+}
+
+int ClientSendScheduler::getLength(Event* ev)
+{
+    if ( ev->getEventType() == EtClientSendBurst )
+    {
+        int len = 0;
+        MQTTSNPacketBurst* burst = ev->getMQTTSNPacketBurst();
+        for (int i = 0; i < burst->getCount(); i++)
+        {
+            len += burst->getPacket(i)->getPacketLength();
+        }
+        return len;
+    }
+    return ev->getMQTTSNPacket() ? ev->getMQTTSNPacket()->getPacketLength() : 0;
+}
+
+/*
+ *  PUBLISHes and REGISTERs are scheduled per client, everything else goes first.
+ *  PINGRESP and DISCONNECT stay behind the packets the client is waiting for.
+ */
+bool ClientSendScheduler::isControl(Event* ev)
+{
+    if ( ev->getEventType() == EtClientSendBurst )
+    {
+        return false;
+    }
+    if ( ev->getEventType() != EtClientSend || ev->getClient() == nullptr )
+    {
+        return true;
+    }
+
+    switch (ev->getMQTTSNPacket()->getType())
+    {
+    case MQTTSN_PUBLISH:
+    case MQTTSN_REGISTER:
+        return false;
+    case MQTTSN_PINGRESP:
+    case MQTTSN_DISCONNECT:
+        return findFlow(ev->getClient()) == nullptr;
+    default:
+        return true;
+    }
+}
+
+/*
+ *  The flows with packets are also kept in a HashTable by Client.
+ */
+uint32_t ClientSendScheduler::hashOf(ClientSendFlow* flow)
+{
+    return hashPointer(flow->_client);
+}
+
+ClientSendFlow* ClientSendScheduler::findFlow(Client* client)
+{
+    for (ClientSendFlow* flow = _flows.first(hashPointer(client)); flow; flow = flow->_nextByClient)
+    {
+        if ( flow->_client == client )
+        {
+            return flow;
+        }
+    }
+    return nullptr;
+}
+
+ClientSendFlow* ClientSendScheduler::getFlow(Client* client)
+{
+    ClientSendFlow* flow = findFlow(client);
+    if ( flow )
+    {
+        return flow;
+    }
+
+    flow = _free;
+    if ( flow )
+    {
+        _free = flow->_next;
+    }
+    else
+    {
+        flow = new ClientSendFlow();
+    }
+    flow->_client = client;
+    flow->_deficit = 0;
+    flow->_turn = false;
+    flow->_next = nullptr;
+    _flows.add(flow);
+
+    if ( _tail )
+    {
+        _tail->_next = flow;
+    }
+    else
+    {
+        _active = flow;
+    }
+    _tail = flow;
+    return flow;
+}
+
+/* a flow taken off _active goes back to the free list */
+void ClientSendScheduler::freeFlow(ClientSendFlow* flow)
+{
+    _flows.remove(flow);
+    flow->_next = _free;
+    _free = flow;
+}
+
+/*
+ *  The scheduler owns the Event until next() returns it.
+ */
+void ClientSendScheduler::post(Event* ev)
+{
+    /* the control queue has no limit, see isControlFull() */
+    int rc = isControl(ev) ? _controlQue.post(ev) : getFlow(ev->getClient())->_que.post(ev);
+    if ( rc )
+    {
+        _cnt++;
+    }
+    else
+    {
+        /* the client's queue is full, report the first drop and every hundredth after it */
+        if ( ++_dropCnt % 100 == 1 )
+        {
+            WRITELOG("%s ClientSendScheduler is full, %u packets dropped. %s\n", ERRMSG_HEADER, _dropCnt, ERRMSG_FOOTER);
+        }
+        delete ev;
+    }
+}
+
+/*
+ *  @param usec      monotonic time
+ *  @param waitUsec  set to the time until the link takes the next packet, when nullptr is returned
+ *  @return the Event to send now, nullptr if there is none or the link is busy
+ */
+Event* ClientSendScheduler::next(uint64_t usec, uint32_t* waitUsec)
+{
+    Event* ev = nullptr;
+    *waitUsec = 0;
+
+    if ( _cnt == 0 )
+    {
+        return nullptr;
+    }
+
+    if ( _rate )
+    {
+        _tokens += (int64_t)(usec - _lastUsec) * _rate;
+        _lastUsec = usec;
+        if ( _tokens > _depth )
+        {
+            _tokens = _depth;
+        }
+        if ( _tokens <= 0 )
+        {
+            *waitUsec = (uint32_t)(-_tokens / _rate + 1);
+            return nullptr;
+        }
+    }
+
+    if ( _controlQue.size() > 0 )
+    {
+        ev = _controlQue.front();
+        _controlQue.pop();
+    }
+
+    while ( ev == nullptr && _active )
+    {
+        ClientSendFlow* flow = _active;
+        if ( !flow->_turn )
+        {
+            flow->_deficit += CLIENTSEND_QUANTUM;
+            flow->_turn = true;
+        }
+
+        int len = getLength(flow->_que.front());
+        if ( len <= flow->_deficit )
+        {
+            ev = flow->_que.front();
+            flow->_que.pop();
+            flow->_deficit -= len;
+            if ( flow->_que.size() == 0 )
+            {
+                /* an idle client keeps no credit */
+                _active = flow->_next;
+                if ( _active == nullptr )
+                {
+                    _tail = nullptr;
+                }
+                freeFlow(flow);
+            }
+            break;
+        }
+
+        /* end of the turn, to the end of the round */
+        flow->_turn = false;
+        if ( flow != _tail )
+        {
+            _active = flow->_next;
+            flow->_next = nullptr;
+            _tail->_next = flow;
+            _tail = flow;
+        }
+    }
+
+    if ( ev )
+    {
+        _cnt--;
+        _tokens -= (int64_t)getLength(ev) * 1000000;
+    }
+    return ev;
+}
+
+/*
+ *  Delete the Events not sent yet, ClientSendTask stops.
+ */
+void ClientSendScheduler::clear(void)
+{
+    while ( _controlQue.size() > 0 )
+    {
+        delete _controlQue.front();
+        _controlQue.pop();
+    }
+    while ( _active )
+    {
+        ClientSendFlow* flow = _active;
+        while ( flow->_que.size() > 0 )
+        {
+            delete flow->_que.front();
+            flow->_que.pop();
+        }
+        _active = flow->_next;
+        freeFlow(flow);
+    }
+    _tail = nullptr;
+    _cnt = 0;
+}
+
+int ClientSendScheduler::size(void)
+{
+    return _cnt;
+}
+
+uint32_t ClientSendScheduler::getDropCnt(void)
+{
+    return _dropCnt;
+}
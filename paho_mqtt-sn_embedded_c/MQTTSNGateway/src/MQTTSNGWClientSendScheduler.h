@@ -0,0 +1,98 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - fair scheduling of the packets sent to clients
+ **************************************************************************************/
+#ifndef MQTTSNGWCLIENTSENDSCHEDULER_H_
+#define MQTTSNGWCLIENTSENDSCHEDULER_H_
+
+#include <stdint.h>
+#include "MQTTSNGateway.h"
+
+#define CLIENTSEND_QUANTUM   (128)  // Bytes a client may send per round of the scheduler
+#define CLIENTSEND_MAX_QUEUED  (MAX_SAVED_PUBLISH * MAX_INFLIGHTMESSAGES)  // PUBLISHes and REGISTERs waiting per client
+#define CLIENTSEND_INITIAL_TABLE_SIZE  64  // Buckets of the flow table, doubled when it fills up
+
+namespace MQTTSNGW
+{
+
+/*=====================================
+ Class ClientSendFlow
+ =====================================*/
+class ClientSendFlow
+{
+    friend class ClientSendScheduler;
+public:
+    ClientSendFlow();
+    ~ClientSendFlow();
+
+private:
+    Client* _client;
+    Que<Event> _que;
+    int _deficit;
+    bool _turn;
+    ClientSendFlow* _next;
+    ClientSendFlow* _nextByClient;
+};
+
+/*=====================================
+ Class ClientSendScheduler
+
+ Orders the packets of ClientSendTask.
+ Acknowledgements and other control packets go first,
+ the PUBLISHes and REGISTERs of each client wait in the client's own queue
+ and the queues are served by deficit round robin, CLIENTSEND_QUANTUM bytes per round.
+ With a rate set, a token bucket keeps the bytes sent within the capacity of the link.
+ A client's queue is bounded, packets posted to a full one are dropped. Control packets
+ are never dropped, isControlFull() tells ClientSendTask to stop taking Events while
+ MAX_INFLIGHTMESSAGES of them per client of MaxClients wait.
+ =====================================*/
+class ClientSendScheduler
+{
+public:
+    ClientSendScheduler();
+    ~ClientSendScheduler();
+    void setRate(uint32_t bytesPerSec);
+    void setMaxClients(int maxClients);
+    void post(Event* ev);
+    bool isControlFull(void);
+    Event* next(uint64_t usec, uint32_t* waitUsec);
+    void clear(void);
+    int size(void);
+    uint32_t getDropCnt(void);
+    static int getLength(Event* ev);
+
+private:
+    bool isControl(Event* ev);
+    ClientSendFlow* findFlow(Client* client);
+    ClientSendFlow* getFlow(Client* client);
+    void freeFlow(ClientSendFlow* flow);
+    static uint32_t hashOf(ClientSendFlow* flow);
+
+    Que<Event> _controlQue;
+    int _maxControl;
+    HashTable<ClientSendFlow, &ClientSendFlow::_nextByClient, &ClientSendScheduler::hashOf> _flows {CLIENTSEND_INITIAL_TABLE_SIZE};  // active flows by client
+    ClientSendFlow* _active;     // flows with packets, the first one is served
+    ClientSendFlow* _tail;
+    ClientSendFlow* _free;
+    int _cnt;
+    uint32_t _dropCnt;
+    uint32_t _rate;
+    int64_t _depth;
+    int64_t _tokens;             // bytes x 1000000, negative while the link is still busy with the last packet
+    uint64_t _lastUsec;
+};
+
+}
+
+#endif /* MQTTSNGWCLIENTSENDSCHEDULER_H_ */
@@ -18,6 +18,9 @@
 #include "MQTTSNGateway.h"
 #include "MQTTSNGWEncapsulatedPacket.h"
 #include "MQTTSNGWQoSm1Proxy.h"
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
 
 using namespace MQTTSNGW;
 using namespace std;
@@ -37,48 +40,112 @@ ClientSendTask::~ClientSendTask()
 
 }
 
+/*
+ *  ClientSendRate in Gateway.conf limits the bytes per second sent to the clients,
+ *  e.g. ClientSendRate=3840 for XBee at 38400 baud.
+ */
+void ClientSendTask::initialize(int argc, char** argv)
+{
+	char param[MQTTSNGW_PARAM_MAX];
+
+	if (_gateway->getParam("ClientSendRate", param) == 0)
+	{
+		_scheduler.setRate(atoi(param));
+	}
+	_scheduler.setMaxClients(_gateway->getClientList()->getMaxClients());
+}
+
 void ClientSendTask::run()
 {
-	Client* client = nullptr;
-	MQTTSNPacket* packet = nullptr;
-	AdapterManager* adpMgr = _gateway->getAdapterManager();
-	int rc = 0;
+	EventQue* que = _gateway->getClientSendQue();
+	uint32_t waitUsec = 0;
+	struct timespec now;
 
 	while (true)
 	{
-		Event* ev = _gateway->getClientSendQue()->wait();
+		Event* ev = nullptr;
 
-		if (ev->getEventType() == EtStop)
+		/*
+		 * take one Event posted and send one the scheduler picks, so that neither starves the other.
+		 * While too many control packets wait, the Events stay in the que until they are sent.
+		 */
+		bool full = _scheduler.isControlFull();
+		if ( !full && (_scheduler.size() == 0 || que->size() > 0) )
 		{
-			WRITELOG("%s ClientSendTask   stopped.\n", currentDateTime());
-			delete ev;
-			break;
+			ev = que->wait();
 		}
-		if (ev->getEventType() == EtClientSend)
+		else if ( full && waitUsec > 0 )
 		{
-			client = ev->getClient();
-			packet = ev->getMQTTSNPacket();
-			rc = adpMgr->unicastToClient(client, packet, this);
+			usleep(waitUsec < 1000000 ? waitUsec : 1000000);
 		}
-		else if (ev->getEventType() == EtBroadcast)
+		else if ( waitUsec > 0 )
 		{
-			packet = ev->getMQTTSNPacket();
-			log(client, packet);
-			rc = packet->broadcast(_sensorNetwork);
+			ev = que->timedwait(waitUsec < 60000000 ? waitUsec / 1000 + 1 : 60000);
+			if ( ev->getEventType() == EtTimeout )
+			{
+				delete ev;
+				ev = nullptr;
+			}
 		}
-		else if (ev->getEventType() == EtSensornetSend)
+
+		if ( ev )
 		{
-			packet = ev->getMQTTSNPacket();
-			log(client, packet);
-			rc = packet->unicast(_sensorNetwork, ev->getSensorNetAddress());
+			if (ev->getEventType() == EtStop)
+			{
+				_scheduler.clear();
+				WRITELOG("%s ClientSendTask   stopped.\n", currentDateTime());
+				delete ev;
+				break;
+			}
+			_scheduler.post(ev);
+			waitUsec = 0;
 		}
 
-		if ( rc < 0 )
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		ev = _scheduler.next((uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000, &waitUsec);
+		if ( ev )
 		{
-			WRITELOG("%s ClientSendTask can't send a packet to the client %s%s.\n",
-				ERRMSG_HEADER, (client ? (const char*)client->getClientId() : UNKNOWNCL ), ERRMSG_FOOTER);
+			send(ev);
+			delete ev;
 		}
-		delete ev;
+	}
+}
+
+void ClientSendTask::send(Event* ev)
+{
+	Client* client = nullptr;
+	MQTTSNPacket* packet = nullptr;
+	AdapterManager* adpMgr = _gateway->getAdapterManager();
+	int rc = 0;
+
+	if (ev->getEventType() == EtClientSend)
+	{
+		client = ev->getClient();
+		packet = ev->getMQTTSNPacket();
+		rc = adpMgr->unicastToClient(client, packet, this);
+	}
+	else if (ev->getEventType() == EtClientSendBurst)
+	{
+		client = ev->getClient();
+		rc = adpMgr->unicastToClient(client, ev->getMQTTSNPacketBurst(), this);
+	}
+	else if (ev->getEventType() == EtBroadcast)
+	{
+		packet = ev->getMQTTSNPacket();
+		log(client, packet);
+		rc = packet->broadcast(_sensorNetwork);
+	}
+	else if (ev->getEventType() == EtSensornetSend)
+	{
+		packet = ev->getMQTTSNPacket();
+		log(client, packet);
+		rc = packet->unicast(_sensorNetwork, ev->getSensorNetAddress());
+	}
+
+	if ( rc < 0 )
+	{
+		WRITELOG("%s ClientSendTask can't send a packet to the client %s%s.\n",
+			ERRMSG_HEADER, (client ? (const char*)client->getClientId() : UNKNOWNCL ), ERRMSG_FOOTER);
 	}
 }
 
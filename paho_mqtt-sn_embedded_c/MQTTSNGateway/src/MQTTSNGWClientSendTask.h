@@ -18,6 +18,7 @@
 
 #include "MQTTSNGateway.h"
 #include "SensorNetwork.h"
+#include "MQTTSNGWClientSendScheduler.h"
 
 namespace MQTTSNGW
 {
@@ -33,13 +34,16 @@ class ClientSendTask: public Thread
 public:
 	ClientSendTask(Gateway* gateway);
 	~ClientSendTask(void);
+	void initialize(int argc, char** argv);
 	void run(void);
 
 private:
+	void send(Event* ev);
 	void log(Client* client, MQTTSNPacket* packet);
 
 	Gateway* _gateway;
 	SensorNetwork* _sensorNetwork;
+	ClientSendScheduler _scheduler;
 };
 
 }
@@ -18,6 +18,7 @@
 #include "MQTTSNGateway.h"
 #include "MQTTSNGWPacket.h"
 #include "MQTTGWPacket.h"
+#include "MQTTSNGWPacketBurst.h"
 #include <string.h>
 
 using namespace std;
@@ -123,6 +124,8 @@ void MQTTSNConnectionHandler::handleConnect(Client* client, MQTTSNPacket* packet
 		{
 			topics->eraseNormal();;
 		}
+		_gateway->getLocalRouter()->erase(client);
+		_gateway->getDuplicateFilter()->erase(client);
 		client->setSessionStatus(true);
 	}
 
@@ -275,6 +278,11 @@ void MQTTSNConnectionHandler::handlePingreq(Client* client, MQTTSNPacket* packet
 	if ( ( client->isSleep() || client->isAwake() ) &&  client->getClientSleepPacket() )
 	{
 	    sendStoredPublish(client);
+	}
+
+	/* PINGRESP must follow the stored messages, hold PINGREQ until the REGISTERs are acknowledged */
+	if ( client->getWaitREGACKPacketList()->getCount() > 0 )
+	{
 		client->holdPingRequest();
 	}
 	else
@@ -289,17 +297,20 @@ void MQTTSNConnectionHandler::handlePingreq(Client* client, MQTTSNPacket* packet
 	}
 }
 
+/*
+ *  The stored messages are sent to the waking client as one burst, REGISTERs first.
+ */
 void MQTTSNConnectionHandler::sendStoredPublish(Client* client)
 {
-    MQTTGWPacket* msg = nullptr;
+    // ToDo:  This version can't re-send PUBLISH when PUBACK is not returned.
+    MQTTSNPacketBurst* burst = new MQTTSNPacketBurst();
 
-    while  ( ( msg = client->getClientSleepPacket() ) != nullptr )
+    if ( burst->setClientSleepPackets(client) == 0 )
     {
-        // ToDo:  This version can't re-send PUBLISH when PUBACK is not returned.
-        client->deleteFirstClientSleepPacket();  // pop the que to delete element.
-
-        Event* ev = new Event();
-        ev->setBrokerRecvEvent(client, msg);
-        _gateway->getPacketEventQue()->post(ev);
+        delete burst;
+        return;
     }
+    Event* ev = new Event();
+    ev->setClientSendEvent(client, burst);
+    _gateway->getClientSendQue()->post(ev);
 }
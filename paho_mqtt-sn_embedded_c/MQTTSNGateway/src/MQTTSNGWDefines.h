@@ -39,11 +39,20 @@ namespace MQTTSNGW
  ==================================*/
 #define MAX_CLIENTS                 (100)  // Number of Clients can be handled.
 #define MAX_CLIENTID_LENGTH          (64)  // Max length of clientID
+#define MAX_WIRELESS_NODEID_LENGTH   (16)  // Max length of the Wireless Node Id of a forwarded client
 #define MAX_INFLIGHTMESSAGES         (10)  // Number of inflight messages
 #define MAX_MESSAGEID_TABLE_SIZE    (500)  // Number of MessageIdTable size
-#define MAX_SAVED_PUBLISH            (20)  // Max number of PUBLISH message for Asleep state
+#define MAX_SAVED_PUBLISH           (100)  // Max number of PUBLISH message for Asleep state
+#define MAX_PACKET_BURST             (32)  // Max datagrams handed to the SensorNetwork in one unicast burst
 #define MAX_TOPIC_PAR_CLIENT     (50)    // Max Topic count for a client. it should be less than 256
 #define MQTTSNGW_MAX_PACKET_SIZE   (1024)  // Max Packet size  (5+2+TopicLen+PayloadLen + Foward Encapsulation)
+#define BROKER_SEND_LATENCY           (5)  // msecs a packet to the broker may wait to be written together with the following ones
+#define BROKER_SEND_MAX_PENDING      (32)  // Number of connections with packets waiting to be written
+#define DEFAULT_MAX_BROKER_BACKLOG (16384)  // bytes waiting to be written to a broker connection before PUBLISHes are rejected
+#define DEFAULT_RETAINED_CACHE_EXPIRY (600)  // secs a retained message is served from the gateway's cache
+#define DEFAULT_DUPLICATE_WINDOW       (30)  // secs a QoS 1 PUBLISH is remembered to absorb its retransmissions
+#define DEFAULT_BROKER_POOL_IDLE       (10)  // secs a pooled broker connection waits for a client before it is replaced
+#define BROKER_POOL_INTERVAL          (500)  // msecs between two refills of the broker connection pool
 #define SIZE_OF_LOG_PACKET          (500)  // Length of the packet log in bytes
 
 #define QOSM1_PROXY_KEEPALIVE_DURATION   900       // Secs
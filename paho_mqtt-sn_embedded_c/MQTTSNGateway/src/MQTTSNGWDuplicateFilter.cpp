@@ -0,0 +1,233 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - filter of retransmitted QoS 1 PUBLISHes
+ **************************************************************************************/
+
+#include "MQTTSNGWDuplicateFilter.h"
+#include <stdint.h>
+#include <string.h>
+
+using namespace MQTTSNGW;
+
+/*=====================================
+ Class DuplicateFilter
+ =====================================*/
+DuplicateFilter::DuplicateFilter()
+{
+
+}
+
+DuplicateFilter::~DuplicateFilter()
+{
+    for ( uint32_t i = 0; i < _table.getSize(); i++ )
+    {
+        DuplicateWindow* window = _table.getBucket(i);
+        while ( window )
+        {
+            DuplicateWindow* next = window->_next;
+            delete window;
+            window = next;
+        }
+    }
+}
+
+/*
+ *  @param window secs a PUBLISH is remembered, 0: no filtering
+ */
+void DuplicateFilter::initialize(uint32_t window)
+{
+    _window = window;
+}
+
+bool DuplicateFilter::isActive(void)
+{
+    return _window > 0;
+}
+
+/*
+ *  Look up a PUBLISH the client retransmitted, rc is set to the return code of its PUBACK when DupAcked.
+ */
+DuplicateStatus DuplicateFilter::check(Client* client, uint16_t msgId, uint16_t topicId, const uint8_t* payload, int payloadLen, uint8_t* rc)
+{
+    DuplicateStatus status = DupNew;
+    if ( !isActive() )
+    {
+        return status;
+    }
+
+    uint32_t payloadHash = hashBytes(payload, payloadLen);
+    time_t now = time(nullptr);
+
+    _mutex.lock();
+    DuplicateWindow* window = getWindow(client, false);
+    for ( int i = 0; window && i < DUPLICATE_FILTER_WINDOW_SIZE; i++ )
+    {
+        /* newest first */
+        DuplicateEntry* entry = &window->_entries[(window->_last + DUPLICATE_FILTER_WINDOW_SIZE - i) % DUPLICATE_FILTER_WINDOW_SIZE];
+        if ( entry->_time == 0 || now - entry->_time > (time_t)_window )
+        {
+            continue;
+        }
+        if ( entry->_msgId == msgId && entry->_topicId == topicId && entry->_payloadHash == payloadHash )
+        {
+            window->_counters.duplicates++;
+            if ( entry->_acked )
+            {
+                window->_counters.reacked++;
+                *rc = entry->_rc;
+                status = DupAcked;
+            }
+            else
+            {
+                status = DupInflight;
+            }
+            break;
+        }
+    }
+    _mutex.unlock();
+    return status;
+}
+
+/*
+ *  A QoS 1 PUBLISH queued to the broker, it takes the place of the client's oldest one.
+ */
+void DuplicateFilter::add(Client* client, uint16_t msgId, uint16_t topicId, const uint8_t* payload, int payloadLen)
+{
+    if ( !isActive() )
+    {
+        return;
+    }
+
+    uint32_t payloadHash = hashBytes(payload, payloadLen);
+
+    _mutex.lock();
+    DuplicateWindow* window = getWindow(client, true);
+    window->_last = (window->_last + 1) % DUPLICATE_FILTER_WINDOW_SIZE;
+    DuplicateEntry* entry = &window->_entries[window->_last];
+    entry->_msgId = msgId;
+    entry->_topicId = topicId;
+    entry->_payloadHash = payloadHash;
+    entry->_time = time(nullptr);
+    entry->_rc = 0;
+    entry->_acked = false;
+    window->_counters.published++;
+    _mutex.unlock();
+}
+
+/*
+ *  The PUBACK of a PUBLISH was sent to the client, with return code rc.
+ *  Its retransmissions are absorbed for another window from now.
+ */
+void DuplicateFilter::acked(Client* client, uint16_t msgId, uint8_t rc)
+{
+    if ( !isActive() )
+    {
+        return;
+    }
+
+    _mutex.lock();
+    DuplicateWindow* window = getWindow(client, false);
+    for ( int i = 0; window && i < DUPLICATE_FILTER_WINDOW_SIZE; i++ )
+    {
+        DuplicateEntry* entry = &window->_entries[(window->_last + DUPLICATE_FILTER_WINDOW_SIZE - i) % DUPLICATE_FILTER_WINDOW_SIZE];
+        if ( entry->_time && !entry->_acked && entry->_msgId == msgId )
+        {
+            entry->_rc = rc;
+            entry->_acked = true;
+            entry->_time = time(nullptr);
+            break;
+        }
+    }
+    _mutex.unlock();
+}
+
+/*
+ *  Forget a client, it is deleted or starts a clean session, its broker connection closed
+ *  or a PUBLISH of it could not be queued.
+ */
+void DuplicateFilter::erase(Client* client)
+{
+    if ( !isActive() )
+    {
+        return;
+    }
+
+    _mutex.lock();
+    DuplicateWindow* window = getWindow(client, false);
+    if ( window )
+    {
+        _table.remove(window);
+        delete window;
+    }
+    _mutex.unlock();
+}
+
+bool DuplicateFilter::getCounters(Client* client, DuplicateCounters* counters)
+{
+    _mutex.lock();
+    DuplicateWindow* window = getWindow(client, false);
+    if ( window )
+    {
+        *counters = window->_counters;
+    }
+    _mutex.unlock();
+    return window != nullptr;
+}
+
+void DuplicateFilter::getTotals(DuplicateCounters* counters)
+{
+    memset(counters, 0, sizeof(DuplicateCounters));
+    _mutex.lock();
+    for ( uint32_t i = 0; i < _table.getSize(); i++ )
+    {
+        for ( DuplicateWindow* window = _table.getBucket(i); window; window = window->_next )
+        {
+            counters->published += window->_counters.published;
+            counters->duplicates += window->_counters.duplicates;
+            counters->reacked += window->_counters.reacked;
+        }
+    }
+    _mutex.unlock();
+}
+
+uint32_t DuplicateFilter::getClientCount(void)
+{
+    return _table.getCount();
+}
+
+uint32_t DuplicateFilter::hashOf(DuplicateWindow* window)
+{
+    return hashPointer(window->_client);
+}
+
+DuplicateWindow* DuplicateFilter::getWindow(Client* client, bool create)
+{
+    for ( DuplicateWindow* window = _table.first(hashPointer(client)); window; window = window->_next )
+    {
+        if ( window->_client == client )
+        {
+            return window;
+        }
+    }
+
+    if ( !create )
+    {
+        return nullptr;
+    }
+
+    DuplicateWindow* window = new DuplicateWindow();
+    window->_client = client;
+    _table.add(window);
+    return window;
+}
@@ -0,0 +1,105 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - filter of retransmitted QoS 1 PUBLISHes
+ **************************************************************************************/
+#ifndef MQTTSNGATEWAY_SRC_MQTTSNGWDUPLICATEFILTER_H_
+#define MQTTSNGATEWAY_SRC_MQTTSNGWDUPLICATEFILTER_H_
+
+#include <time.h>
+#include "MQTTSNGWDefines.h"
+#include "Threading.h"
+#include "MQTTSNGWProcess.h"
+
+#define DUPLICATE_FILTER_INITIAL_TABLE_SIZE  64   // Buckets of the client table, doubled when it fills up
+#define DUPLICATE_FILTER_WINDOW_SIZE         16   // QoS 1 PUBLISHes remembered per client
+
+namespace MQTTSNGW
+{
+class Client;
+
+/* What to do with a retransmitted PUBLISH */
+typedef enum
+{
+    DupNew = 0,    // not in the window, sent to the broker
+    DupInflight,   // the broker's PUBACK is not back yet, dropped
+    DupAcked       // dropped, the PUBACK is sent again
+} DuplicateStatus;
+
+/* Counters of one client */
+typedef struct
+{
+    uint32_t published;   // QoS 1 PUBLISHes sent to the broker
+    uint32_t duplicates;  // retransmissions absorbed
+    uint32_t reacked;     // of which answered with the PUBACK again
+} DuplicateCounters;
+
+class DuplicateEntry
+{
+    friend class DuplicateFilter;
+private:
+    uint16_t _msgId {0};
+    uint16_t _topicId {0};
+    uint32_t _payloadHash {0};
+    time_t _time {0};            // sent to the broker, then acknowledged
+    uint8_t _rc {0};
+    bool _acked {false};
+};
+
+class DuplicateWindow
+{
+    friend class DuplicateFilter;
+private:
+    Client* _client {nullptr};
+    DuplicateEntry _entries[DUPLICATE_FILTER_WINDOW_SIZE];
+    uint8_t _last {0};
+    DuplicateCounters _counters {0, 0, 0};
+    DuplicateWindow* _next {nullptr};
+};
+
+/*=====================================
+ Class DuplicateFilter
+
+ The last QoS 1 PUBLISHes each client queued to the broker, by msgId, TopicId and payload,
+ for DuplicateWindow secs. They are forgotten when a PUBLISH of the client can not be queued
+ and when its broker connection closes, their retransmissions go to the broker again then. A PUBLISH retransmitted with the DUP flag because its PUBACK
+ was lost on the sensor network is not sent to the broker again: it is dropped while the
+ broker's PUBACK is awaited, and answered with the PUBACK again once it was sent.
+ =====================================*/
+class DuplicateFilter
+{
+public:
+    DuplicateFilter();
+    ~DuplicateFilter();
+
+    void initialize(uint32_t window);
+    bool isActive(void);
+    DuplicateStatus check(Client* client, uint16_t msgId, uint16_t topicId, const uint8_t* payload, int payloadLen, uint8_t* rc);
+    void add(Client* client, uint16_t msgId, uint16_t topicId, const uint8_t* payload, int payloadLen);
+    void acked(Client* client, uint16_t msgId, uint8_t rc);
+    void erase(Client* client);
+    bool getCounters(Client* client, DuplicateCounters* counters);
+    void getTotals(DuplicateCounters* counters);
+    uint32_t getClientCount(void);
+
+private:
+    DuplicateWindow* getWindow(Client* client, bool create);
+    static uint32_t hashOf(DuplicateWindow* window);
+
+    Mutex _mutex;
+    uint32_t _window {0};
+    HashTable<DuplicateWindow, &DuplicateWindow::_next, &DuplicateFilter::hashOf> _table {DUPLICATE_FILTER_INITIAL_TABLE_SIZE};   // windows by Client
+};
+
+}
+#endif /* MQTTSNGATEWAY_SRC_MQTTSNGWDUPLICATEFILTER_H_ */
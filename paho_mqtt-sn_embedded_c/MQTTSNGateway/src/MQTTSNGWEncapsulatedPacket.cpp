@@ -16,6 +16,7 @@
 #include "MQTTSNGWPacket.h"
 #include "MQTTSNGWEncapsulatedPacket.h"
 #include "MQTTSNPacket.h"
+#include "MQTTSNGWProcess.h"
 #include <string.h>
 
 using namespace MQTTSNGW;
@@ -23,36 +24,28 @@ using namespace std;
 
 WirelessNodeId::WirelessNodeId()
     :
-    _len{0},
-    _nodeId{0}
+    _len{0}
 {
 
 }
 
 WirelessNodeId::~WirelessNodeId()
 {
-    if ( _nodeId )
-    {
-        free(_nodeId);
-    }
+
 }
 
+/*
+ *  Ids longer than MAX_WIRELESS_NODEID_LENGTH are not kept, the id becomes empty.
+ */
 void WirelessNodeId::setId(uint8_t* id, uint8_t len)
 {
-    if ( _nodeId )
-     {
-         free(_nodeId);
-     }
-    uint8_t* buf = (uint8_t*)malloc(len);
-    if ( buf )
+    if ( len <= MAX_WIRELESS_NODEID_LENGTH )
     {
-        memcpy(buf, id, len);
+        memcpy(_nodeId, id, len);
         _len = len;
-        _nodeId = buf;
     }
     else
     {
-        _nodeId = nullptr;
         _len = 0;
     }
 }
@@ -74,6 +67,14 @@ bool WirelessNodeId::operator ==(WirelessNodeId& id)
     }
 }
 
+/*
+ *  Hash of the id, used by Forwarder to index its clients.
+ */
+uint32_t WirelessNodeId::hash(void)
+{
+    return hashBytes(_nodeId, _len);
+}
+
 /*
  *    Class MQTTSNGWEncapsulatedPacket
  */
@@ -118,20 +119,29 @@ int MQTTSNGWEncapsulatedPacket::serialize(uint8_t* buf)
     return  buf[0] + len;
 }
 
-int MQTTSNGWEncapsulatedPacket::desirialize(unsigned char* buf, unsigned short len)
+/*
+ *  Take the encapsulated message out of the packet.
+ *  The packet is not copied, its data is narrowed to the message behind the encapsulation header
+ *  and it becomes the MQTTSNPacket of this object.
+ *  @return the length of the header, -1 if the packet is not a valid encapsulated message.
+ */
+int MQTTSNGWEncapsulatedPacket::desirialize(MQTTSNPacket* packet)
 {
-    if ( _mqttsn )
+    unsigned char* buf = packet->getPacketData();
+    int len = packet->getPacketLength();
+
+    if ( len < 3 || buf[0] < 3 || buf[0] - 3 > MAX_WIRELESS_NODEID_LENGTH || len - buf[0] < 2 )
     {
-        delete _mqttsn;
-        _mqttsn = nullptr;
+        return -1;
     }
 
+    int hdrLen = buf[0];
     _ctrl = buf[2];
-    _id.setId(buf + 3, buf[0] - 3);
+    _id.setId(buf + 3, hdrLen - 3);
 
-    _mqttsn = new MQTTSNPacket;
-    _mqttsn->desirialize(buf + buf[0], len - buf[0]);
-    return buf[0];
+    packet->trimHead(hdrLen);
+    _mqttsn = packet;
+    return hdrLen;
 }
 
 int MQTTSNGWEncapsulatedPacket::getType(void)
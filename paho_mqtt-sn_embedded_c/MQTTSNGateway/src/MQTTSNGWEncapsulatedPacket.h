@@ -17,6 +17,8 @@
 #ifndef MQTTSNGATEWAY_SRC_MQTTSNGWENCAPSULATEDPACKET_H_
 #define MQTTSNGATEWAY_SRC_MQTTSNGWENCAPSULATEDPACKET_H_
 
+#include "MQTTSNGWDefines.h"
+
 namespace MQTTSNGW
 {
 
@@ -29,9 +31,10 @@ public:
     void setId(uint8_t* id, uint8_t len);
     void setId(WirelessNodeId* id);
     bool operator ==(WirelessNodeId& id);
+    uint32_t hash(void);
 private:
     uint8_t _len;
-    uint8_t* _nodeId;
+    uint8_t _nodeId[MAX_WIRELESS_NODEID_LENGTH];
 };
 
 class MQTTSNGWEncapsulatedPacket
@@ -42,7 +45,7 @@ public:
     ~MQTTSNGWEncapsulatedPacket();
     int unicast(SensorNetwork* network, SensorNetAddress* sendTo);
     int serialize(uint8_t* buf);
-    int desirialize(unsigned char* buf, unsigned short len);
+    int desirialize(MQTTSNPacket* packet);
     int getType(void);
     unsigned char* getPacketData(void);
     int getPacketLength(void);
@@ -27,14 +27,14 @@ using namespace std;
 
 ForwarderList::ForwarderList()
 {
-    _head = nullptr;
+    memset(_table, 0, sizeof(_table));
 }
 
 ForwarderList::~ForwarderList()
 {
-    if ( _head )
+    for ( int i = 0; i < FORWARDERLIST_TABLE_SIZE; i++ )
     {
-        Forwarder* p = _head;
+        Forwarder* p = _table[i];
         while ( p )
         {
             Forwarder* next = p->_next;
@@ -62,7 +62,7 @@ void ForwarderList::initialize(Gateway* gw)
 
 Forwarder* ForwarderList::getForwarder(SensorNetAddress* addr)
 {
-    Forwarder* p = _head;
+    Forwarder* p = _table[addr->hash() & (FORWARDERLIST_TABLE_SIZE - 1)];
     while ( p )
     {
         if ( p->_sensorNetAddr.isMatch(addr) )
@@ -77,52 +77,36 @@ Forwarder* ForwarderList::getForwarder(SensorNetAddress* addr)
 Forwarder* ForwarderList::addForwarder(SensorNetAddress* addr,  MQTTSNString* forwarderId)
 {
     Forwarder* fdr = new Forwarder(addr, forwarderId);
-    if ( _head == nullptr )
-    {
-        _head = fdr;
-    }
-    else
+    Forwarder** pp = &_table[addr->hash() & (FORWARDERLIST_TABLE_SIZE - 1)];
+
+    /* append, the first forwarder added for an address is the one found */
+    while ( *pp )
     {
-        Forwarder* p = _head;
-        while ( p )
-        {
-            if ( p->_next == nullptr )
-            {
-                p->_next = fdr;
-                break;
-            }
-            else
-            {
-                p = p->_next;
-            }
-        }
+        pp = &(*pp)->_next;
     }
+    *pp = fdr;
     return fdr;
 }
 
+/*=====================================
+     Class Forwarder
+ =====================================*/
+
 Forwarder::Forwarder()
 {
-    _headClient = nullptr;
-    _next = nullptr;
 }
 
-/*=====================================
-     Class ForwarderList
- =====================================*/
-
 Forwarder::Forwarder(SensorNetAddress* addr,  MQTTSNString* forwarderId)
 {
     _forwarderName = string(forwarderId->cstring);
     _sensorNetAddr = *addr;
-    _headClient = nullptr;
-    _next = nullptr;
 }
 
 Forwarder::~Forwarder(void)
 {
-    if ( _headClient )
+    for ( uint32_t i = 0; i < _nodeIdTable.getSize(); i++ )
     {
-        ForwarderElement* p = _headClient;
+        ForwarderElement* p = _nodeIdTable.getBucket(i);
         while ( p )
         {
             ForwarderElement* next = p->_next;
@@ -137,58 +121,60 @@ const char* Forwarder::getId(void)
     return _forwarderName.c_str();
 }
 
-void Forwarder::addClient(Client* client, WirelessNodeId* id)
+/*
+ *  Clients are kept in two HashTables sharing the elements,
+ *  one by WirelessNodeId for received packets and one by Client for packets sent to them.
+ */
+uint32_t Forwarder::hashNodeId(ForwarderElement* elm)
 {
-    ForwarderElement* p = _headClient;
-    ForwarderElement* prev = nullptr;
+    return elm->_wirelessNodeId.hash();
+}
 
+uint32_t Forwarder::hashClient(ForwarderElement* elm)
+{
+    return hashPointer(elm->_client);
+}
+
+void Forwarder::addClient(Client* client, WirelessNodeId* id)
+{
     client->setForwarder(this);
 
-    if ( p != nullptr )
+    _mutex.lock();
+    for ( ForwarderElement* p = _clientTable.first(hashPointer(client)); p; p = p->_nextByClient )
     {
-        while ( p )
+        if ( p->_client == client )
         {
-            if ( p->_client == client )
+            if ( !(p->_wirelessNodeId == *id) )
             {
-                client->setForwarder(this);
-                return;
+                /* The client reconnected from another node. Move it to the bucket of the new id. */
+                _nodeIdTable.remove(p);
+                p->setWirelessNodeId(id);
+                _nodeIdTable.add(p);
             }
-            prev = p;
-            p = p->_next;
+            _mutex.unlock();
+            return;
         }
     }
 
     ForwarderElement* fclient = new ForwarderElement();
-
     fclient->setClient(client);
     fclient->setWirelessNodeId(id);
-
-    if ( prev )
-    {
-        prev->_next = fclient;
-    }
-    else
-    {
-        _headClient = fclient;
-    }
+    _nodeIdTable.add(fclient);
+    _clientTable.add(fclient);
+    _mutex.unlock();
 }
 
 Client* Forwarder::getClient(WirelessNodeId* id)
 {
     Client* cl = nullptr;
     _mutex.lock();
-    ForwarderElement* p = _headClient;
-    while ( p )
+    for ( ForwarderElement* p = _nodeIdTable.first(id->hash()); p; p = p->_next )
     {
-        if ( *(p->_wirelessNodeId) == *id )
+        if ( p->_wirelessNodeId == *id )
         {
             cl = p->_client;
             break;
         }
-        else
-        {
-            p = p->_next;
-        }
     }
     _mutex.unlock();
     return cl;
@@ -203,18 +189,13 @@ WirelessNodeId* Forwarder::getWirelessNodeId(Client* client)
 {
     WirelessNodeId* nodeId = nullptr;
     _mutex.lock();
-    ForwarderElement* p = _headClient;
-    while ( p )
+    for ( ForwarderElement* p = _clientTable.first(hashPointer(client)); p; p = p->_nextByClient )
     {
         if ( p->_client == client )
         {
-            nodeId = p->_wirelessNodeId;
+            nodeId = &p->_wirelessNodeId;
             break;
         }
-        else
-        {
-            p = p->_next;
-        }
     }
     _mutex.unlock();
     return nodeId;
@@ -222,29 +203,16 @@ WirelessNodeId* Forwarder::getWirelessNodeId(Client* client)
 
 void Forwarder::eraseClient(Client* client)
 {
-    ForwarderElement* prev = nullptr;
     _mutex.lock();
-    ForwarderElement* p = _headClient;
-
-    while ( p )
+    for ( ForwarderElement* p = _clientTable.first(hashPointer(client)); p; p = p->_nextByClient )
     {
         if ( p->_client == client )
         {
-            if ( prev )
-            {
-                prev->_next = p->_next;
-            }
-            else
-            {
-                _headClient = p->_next;
-            }
+            _clientTable.remove(p);
+            _nodeIdTable.remove(p);
             delete p;
             break;
         }
-        else
-        {
-            p = p->_next;
-        }
     }
     _mutex.unlock();
 }
@@ -260,17 +228,13 @@ SensorNetAddress* Forwarder::getSensorNetAddr(void)
 
 ForwarderElement::ForwarderElement()
     : _client{0}
-    , _wirelessNodeId{0}
     , _next{0}
+    , _nextByClient{0}
 {
 }
 
 ForwarderElement::~ForwarderElement()
 {
-    if (_wirelessNodeId)
-    {
-        delete _wirelessNodeId;
-    }
 }
 
 void ForwarderElement::setClient(Client* client)
@@ -280,9 +244,5 @@ void ForwarderElement::setClient(Client* client)
 
 void ForwarderElement::setWirelessNodeId(WirelessNodeId* id)
 {
-    if ( _wirelessNodeId == nullptr )
-    {
-        _wirelessNodeId = new WirelessNodeId();
-    }
-    _wirelessNodeId->setId(id);
+    _wirelessNodeId.setId(id);
 }
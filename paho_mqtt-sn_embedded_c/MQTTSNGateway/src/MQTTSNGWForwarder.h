@@ -23,6 +23,9 @@
 #include "SensorNetwork.h"
 
 
+#define FORWARDER_INITIAL_TABLE_SIZE   16  // Buckets of a Forwarder's client tables, doubled when they fill up
+#define FORWARDERLIST_TABLE_SIZE       64  // Buckets of the ForwarderList, a power of 2
+
 namespace MQTTSNGW
 {
 class Gateway;
@@ -43,8 +46,9 @@ public:
     void setWirelessNodeId(WirelessNodeId* id);
 private:
     Client* _client;
-    WirelessNodeId* _wirelessNodeId;
-    ForwarderElement* _next;
+    WirelessNodeId _wirelessNodeId;
+    ForwarderElement* _next;          // next element in the bucket of the WirelessNodeId
+    ForwarderElement* _nextByClient;  // next element in the bucket of the Client
 };
 
 /*=====================================
@@ -68,9 +72,13 @@ public:
     const char* getName(void);
 
 private:
+    static uint32_t hashNodeId(ForwarderElement* elm);
+    static uint32_t hashClient(ForwarderElement* elm);
+
     string _forwarderName;
     SensorNetAddress _sensorNetAddr;
-    ForwarderElement* _headClient{nullptr};
+    HashTable<ForwarderElement, &ForwarderElement::_next, &Forwarder::hashNodeId> _nodeIdTable {FORWARDER_INITIAL_TABLE_SIZE};  // clients hashed by WirelessNodeId
+    HashTable<ForwarderElement, &ForwarderElement::_nextByClient, &Forwarder::hashClient> _clientTable {FORWARDER_INITIAL_TABLE_SIZE};  // the same elements hashed by Client
     Forwarder* _next {nullptr};
     Mutex _mutex;
 };
@@ -89,7 +97,7 @@ public:
     Forwarder* addForwarder(SensorNetAddress* addr,  MQTTSNString* forwarderId);
 
 private:
-    Forwarder* _head;
+    Forwarder* _table[FORWARDERLIST_TABLE_SIZE];  // forwarders hashed by SensorNetAddress
 };
 
 }
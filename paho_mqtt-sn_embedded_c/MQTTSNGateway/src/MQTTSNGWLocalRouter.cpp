@@ -0,0 +1,415 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - routing of PUBLISHes between local clients
+ **************************************************************************************/
+
+#include "MQTTSNGWLocalRouter.h"
+#include "MQTTSNGateway.h"
+#include <string.h>
+
+using namespace MQTTSNGW;
+
+/* msecs of the monotonic clock */
+static uint64_t nowMsec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/*=====================================
+ Class LocalRouter
+ =====================================*/
+LocalRouter::LocalRouter()
+{
+
+}
+
+LocalRouter::~LocalRouter()
+{
+    while ( _oldest )
+    {
+        LocalEcho* echo = _oldest;
+        unlink(echo);
+        delete echo;
+    }
+    while ( _pending )
+    {
+        LocalSubscription* next = _pending->_next;
+        delete _pending;
+        _pending = next;
+    }
+}
+
+void LocalRouter::initialize(bool active)
+{
+    _active = active;
+}
+
+bool LocalRouter::isActive(void)
+{
+    return _active;
+}
+
+/*
+ *  A client's SUBSCRIBE sent to the broker, its filter is used once the broker accepts it.
+ */
+void LocalRouter::subscribe(Client* client, const char* filter, uint8_t qos, uint16_t msgId)
+{
+    if ( !_active )
+    {
+        return;
+    }
+    LocalSubscription* sub = new LocalSubscription();
+    sub->_client = client;
+    sub->_msgId = msgId;
+    sub->_qos = qos;
+    sub->_filter = filter;
+    _mutex.lock();
+    sub->_next = _pending;
+    _pending = sub;
+    _mutex.unlock();
+}
+
+/*
+ *  The broker's SUBACK of a client's SUBSCRIBE.
+ */
+void LocalRouter::confirm(Client* client, uint16_t msgId, bool accepted)
+{
+    if ( !_active )
+    {
+        return;
+    }
+    _mutex.lock();
+    for ( LocalSubscription** pp = &_pending; *pp; pp = &(*pp)->_next )
+    {
+        LocalSubscription* sub = *pp;
+        if ( sub->_client == client && sub->_msgId == msgId )
+        {
+            *pp = sub->_next;
+            if ( accepted )
+            {
+                _subscriptions.add(sub->_filter.c_str(), sub->_qos, client);
+                sync();
+            }
+            delete sub;
+            break;
+        }
+    }
+    _mutex.unlock();
+}
+
+void LocalRouter::unsubscribe(Client* client, const char* filter)
+{
+    if ( !_active )
+    {
+        return;
+    }
+    _mutex.lock();
+    _subscriptions.remove(filter, client);
+    sync();
+    _mutex.unlock();
+}
+
+/*
+ *  Forget a client, it is deleted or starts a clean session.
+ */
+void LocalRouter::erase(Client* client)
+{
+    if ( !_active )
+    {
+        return;
+    }
+    _mutex.lock();
+    _subscriptions.remove(client);
+    sync();
+
+    for ( LocalSubscription** pp = &_pending; *pp; )
+    {
+        LocalSubscription* sub = *pp;
+        if ( sub->_client == client )
+        {
+            *pp = sub->_next;
+            delete sub;
+        }
+        else
+        {
+            pp = &sub->_next;
+        }
+    }
+
+    drop(client);
+    _mutex.unlock();
+}
+
+/*
+ *  The broker connection of a client is closed, the copies it would have received
+ *  or caused are not waited for any more.
+ */
+void LocalRouter::disconnected(Client* client)
+{
+    if ( !_active )
+    {
+        return;
+    }
+    _mutex.lock();
+    drop(client);
+    _mutex.unlock();
+}
+
+/*
+ *  Deliver a client's PUBLISH, once it is queued to the broker, to the clients of the gateway
+ *  subscribing to its topic, posting BrokerRecv events of QoS 0 PUBLISHes on que.
+ *  Clients the broker sends it to with QoS 1 or 2 are left to the broker.
+ *  @return the number of clients.
+ */
+int LocalRouter::route(Client* publisher, Publish* pub, EventQue* que)
+{
+    if ( !_active || pub->topic == nullptr )
+    {
+        return 0;
+    }
+
+    string topic(pub->topic, pub->topiclen);
+    AggregateTopicElement* list = _subscriptions.getClientList(topic.c_str());
+    if ( list == nullptr )
+    {
+        return 0;
+    }
+
+    Publish local = *pub;
+    local.header.byte = 0;
+    local.msgId = 0;
+    uint32_t topicHash = hashBytes(pub->topic, pub->topiclen);
+    uint32_t payloadHash = hashBytes(pub->payload, pub->payloadlen);
+    uint64_t now = nowMsec();
+    int cnt = 0;
+
+    _mutex.lock();
+    expire(now);
+    for ( ClientTopicElement* elm = list->getFirstElement(); elm; elm = list->getNextElement(elm) )
+    {
+        if ( pub->header.bits.qos > 0 && elm->getQos() > 0 )
+        {
+            continue;
+        }
+        MQTTGWPacket* packet = new MQTTGWPacket();
+        packet->setPUBLISH(&local);
+        Event* ev = new Event();
+        ev->setBrokerRecvEvent(elm->getClient(), packet);
+        que->post(ev);
+        expect(elm->getClient(), publisher, topicHash, pub->topiclen, payloadHash, pub->payloadlen, now);
+        cnt++;
+    }
+    if ( cnt )
+    {
+        _counters.routed++;
+        _counters.delivered += cnt;
+    }
+    _mutex.unlock();
+
+    delete list;
+    return cnt;
+}
+
+/*
+ *  @return true if a PUBLISH from the broker is the copy of one delivered to the client by route().
+ *          Only QoS 0 copies are, the local deliveries are QoS 0.
+ */
+bool LocalRouter::isEcho(Client* client, Publish* pub)
+{
+    if ( !_active || pub->header.bits.qos > 0 )
+    {
+        return false;
+    }
+
+    uint32_t topicHash = hashBytes(pub->topic, pub->topiclen);
+    uint32_t payloadHash = hashBytes(pub->payload, pub->payloadlen);
+    uint64_t now = nowMsec();
+    bool echo = false;
+
+    _mutex.lock();
+    expire(now);
+    LocalEcho* e = find(client, topicHash, pub->topiclen, payloadHash, pub->payloadlen);
+    if ( e )
+    {
+        uint64_t delay = now - e->_routed;
+        _delay = _counters.echoes ? (_delay * 7 + delay) / 8 : delay;
+        unlink(e);
+        delete e;
+        _counters.echoes++;
+        echo = true;
+    }
+    _mutex.unlock();
+    return echo;
+}
+
+void LocalRouter::getCounters(LocalRouterCounters* counters)
+{
+    _mutex.lock();
+    *counters = _counters;
+    _mutex.unlock();
+}
+
+/*
+ *  @return the number of topic filters.
+ */
+int LocalRouter::getCount(void)
+{
+    return _subscriptions.getCount();
+}
+
+uint32_t LocalRouter::hashEcho(Client* client, uint32_t topicHash, uint32_t payloadHash)
+{
+    uint32_t keys[2] = { topicHash, payloadHash };
+    return hashBytes(keys, sizeof(keys), hashPointer(client));
+}
+
+uint32_t LocalRouter::hashOf(LocalEcho* echo)
+{
+    return echo->_hash;
+}
+
+/*
+ *  Echoes are kept in a hash table by client, topic and payload, and in a list
+ *  by expiry, the first to expire first.
+ */
+void LocalRouter::expect(Client* client, Client* publisher, uint32_t topicHash, uint16_t topicLen, uint32_t payloadHash, uint16_t payloadLen, uint64_t now)
+{
+    uint64_t wait = _counters.echoes ? _delay * 4 : (uint64_t)LOCAL_ROUTER_ECHO_TIMEOUT * 1000;
+    if ( wait < LOCAL_ROUTER_ECHO_MIN_WAIT )
+    {
+        wait = LOCAL_ROUTER_ECHO_MIN_WAIT;
+    }
+    else if ( wait > (uint64_t)LOCAL_ROUTER_ECHO_TIMEOUT * 1000 )
+    {
+        wait = (uint64_t)LOCAL_ROUTER_ECHO_TIMEOUT * 1000;
+    }
+
+    LocalEcho* echo = new LocalEcho();
+    echo->_client = client;
+    echo->_publisher = publisher;
+    echo->_hash = hashEcho(client, topicHash, payloadHash);
+    echo->_topicHash = topicHash;
+    echo->_payloadHash = payloadHash;
+    echo->_topicLen = topicLen;
+    echo->_payloadLen = payloadLen;
+    echo->_routed = now;
+    echo->_expiry = now + wait;
+    _table.add(echo);
+
+    /* the waits change slowly, an echo goes at the end of the list or close to it */
+    LocalEcho* older = _newest;
+    while ( older && older->_expiry > echo->_expiry )
+    {
+        older = older->_older;
+    }
+    echo->_older = older;
+    echo->_newer = older ? older->_newer : _oldest;
+    if ( echo->_newer )
+    {
+        echo->_newer->_older = echo;
+    }
+    else
+    {
+        _newest = echo;
+    }
+    if ( older )
+    {
+        older->_newer = echo;
+    }
+    else
+    {
+        _oldest = echo;
+    }
+}
+
+/* the oldest echo of the client, topic and payload */
+LocalEcho* LocalRouter::find(Client* client, uint32_t topicHash, uint16_t topicLen, uint32_t payloadHash, uint16_t payloadLen)
+{
+    LocalEcho* found = nullptr;
+    for ( LocalEcho* e = _table.first(hashEcho(client, topicHash, payloadHash)); e; e = e->_next )
+    {
+        if ( e->_client == client && e->_topicHash == topicHash && e->_payloadHash == payloadHash
+                && e->_topicLen == topicLen && e->_payloadLen == payloadLen
+                && ( found == nullptr || e->_routed < found->_routed ) )
+        {
+            found = e;
+        }
+    }
+    return found;
+}
+
+void LocalRouter::unlink(LocalEcho* echo)
+{
+    _table.remove(echo);
+
+    if ( echo->_older )
+    {
+        echo->_older->_newer = echo->_newer;
+    }
+    else
+    {
+        _oldest = echo->_newer;
+    }
+    if ( echo->_newer )
+    {
+        echo->_newer->_older = echo->_older;
+    }
+    else
+    {
+        _newest = echo->_older;
+    }
+}
+
+/* drops the echoes the client expects or published */
+void LocalRouter::drop(Client* client)
+{
+    LocalEcho* echo = _oldest;
+    while ( echo )
+    {
+        LocalEcho* next = echo->_newer;
+        if ( echo->_client == client || echo->_publisher == client )
+        {
+            unlink(echo);
+            delete echo;
+        }
+        echo = next;
+    }
+}
+
+/* drops the echoes the broker did not send in time */
+void LocalRouter::expire(uint64_t now)
+{
+    while ( _oldest && _oldest->_expiry <= now )
+    {
+        LocalEcho* echo = _oldest;
+        unlink(echo);
+        delete echo;
+    }
+}
+
+/*
+ *  The table is not subscribed anywhere, its updates only free the filters removed.
+ */
+void LocalRouter::sync(void)
+{
+    string filter;
+    uint8_t qos;
+    bool subscribe;
+    while ( _subscriptions.getUpdate(&filter, &qos, &subscribe) )
+    {
+        ;
+    }
+}
@@ -0,0 +1,128 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - routing of PUBLISHes between local clients
+ **************************************************************************************/
+
+#ifndef MQTTSNGATEWAY_SRC_MQTTSNGWLOCALROUTER_H_
+#define MQTTSNGATEWAY_SRC_MQTTSNGWLOCALROUTER_H_
+
+#include <time.h>
+#include "MQTTSNGWDefines.h"
+#include "Threading.h"
+#include "MQTTSNGWAggregateTopicTable.h"
+#include "MQTTGWPacket.h"
+#include "MQTTSNGWProcess.h"
+
+#define LOCAL_ROUTER_INITIAL_TABLE_SIZE  64   // Buckets of the echo table, doubled when it fills up
+#define LOCAL_ROUTER_ECHO_TIMEOUT        30   // secs the broker's copy of a PUBLISH delivered locally is waited for at most
+#define LOCAL_ROUTER_ECHO_MIN_WAIT     1000   // msecs it is waited for at least, 4 times the usual delay of the copies otherwise
+
+namespace MQTTSNGW
+{
+class Client;
+class EventQue;
+
+/* Counters of the router */
+typedef struct
+{
+    uint32_t routed;      // PUBLISHes with subscribers behind the gateway
+    uint32_t delivered;   // copies delivered to them without the broker
+    uint32_t echoes;      // copies from the broker dropped
+} LocalRouterCounters;
+
+/* A PUBLISH delivered to a client, until the broker's copy arrives */
+class LocalEcho
+{
+    friend class LocalRouter;
+private:
+    Client* _client {nullptr};
+    Client* _publisher {nullptr};
+    uint32_t _hash {0};
+    uint32_t _topicHash {0};
+    uint32_t _payloadHash {0};
+    uint16_t _topicLen {0};
+    uint16_t _payloadLen {0};
+    uint64_t _routed {0};           // msecs
+    uint64_t _expiry {0};
+    LocalEcho* _next {nullptr};     // hash chain
+    LocalEcho* _newer {nullptr};    // the first to expire first
+    LocalEcho* _older {nullptr};
+};
+
+/* A SUBSCRIBE waiting for the broker's SUBACK */
+class LocalSubscription
+{
+    friend class LocalRouter;
+private:
+    Client* _client {nullptr};
+    uint16_t _msgId {0};
+    uint8_t _qos {0};
+    string _filter;
+    LocalSubscription* _next {nullptr};
+};
+
+/*=====================================
+ Class LocalRouter
+
+ Routes PUBLISHes between the transparent clients of the gateway, LocalRouting=YES.
+ The topic filters the broker accepted for them are kept in an AggregateTopicTable.
+ A PUBLISH of a client matching them is delivered at once as a QoS 0 PUBLISH from the broker
+ to the clients the broker would send it with QoS 0, the PUBLISH or their subscription
+ being QoS 0, and still sent to the broker. The broker's copies that follow are dropped
+ by BrokerRecvTask. The others get the broker's copy with its QoS as usual.
+ A copy is waited for until it is late by 4 times the usual delay, or until the broker
+ connection of the publisher or of the client closes, so that the same message
+ published by another client in the meantime is not taken for it.
+ =====================================*/
+class LocalRouter
+{
+public:
+    LocalRouter();
+    ~LocalRouter();
+
+    void initialize(bool active);
+    bool isActive(void);
+    void subscribe(Client* client, const char* filter, uint8_t qos, uint16_t msgId);
+    void confirm(Client* client, uint16_t msgId, bool accepted);
+    void unsubscribe(Client* client, const char* filter);
+    void erase(Client* client);
+    void disconnected(Client* client);
+    int route(Client* publisher, Publish* pub, EventQue* que);
+    bool isEcho(Client* client, Publish* pub);
+    void getCounters(LocalRouterCounters* counters);
+    int getCount(void);
+
+private:
+    void expect(Client* client, Client* publisher, uint32_t topicHash, uint16_t topicLen, uint32_t payloadHash, uint16_t payloadLen, uint64_t now);
+    LocalEcho* find(Client* client, uint32_t topicHash, uint16_t topicLen, uint32_t payloadHash, uint16_t payloadLen);
+    void unlink(LocalEcho* echo);
+    void drop(Client* client);
+    void expire(uint64_t now);
+    void sync(void);
+    static uint32_t hashEcho(Client* client, uint32_t topicHash, uint32_t payloadHash);
+    static uint32_t hashOf(LocalEcho* echo);
+
+    Mutex _mutex;
+    bool _active {false};
+    AggregateTopicTable _subscriptions;
+    LocalSubscription* _pending {nullptr};
+    HashTable<LocalEcho, &LocalEcho::_next, &LocalRouter::hashOf> _table {LOCAL_ROUTER_INITIAL_TABLE_SIZE};   // echoes by client, topic and payload
+    uint64_t _delay {0};            // msecs, average delay of the copies
+    LocalEcho* _oldest {nullptr};
+    LocalEcho* _newest {nullptr};
+    LocalRouterCounters _counters {0, 0, 0};
+};
+
+}
+#endif /* MQTTSNGATEWAY_SRC_MQTTSNGWLOCALROUTER_H_ */
@@ -29,6 +29,7 @@ void writeInt(unsigned char** pptr, int msgId);
 
 MQTTSNPacket::MQTTSNPacket(void)
 {
+	_mem = nullptr;
 	_buf = nullptr;
 	_bufLen = 0;
 }
@@ -46,13 +47,14 @@ MQTTSNPacket::MQTTSNPacket(MQTTSNPacket& packet)
 		_buf = nullptr;
 		_bufLen = 0;
 	}
+	_mem = _buf;
 }
 
 MQTTSNPacket::~MQTTSNPacket()
 {
-	if (_buf)
+	if (_mem)
 	{
-		free(_buf);
+		free(_mem);
 	}
 }
 
@@ -74,12 +76,13 @@ int MQTTSNPacket::serialize(uint8_t* buf)
 
 int MQTTSNPacket::desirialize(unsigned char* buf, unsigned short len)
 {
-	if ( _buf )
+	if ( _mem )
 	{
-		free(_buf);
+		free(_mem);
 	}
 
 	_buf = (unsigned char*)calloc(len, sizeof(unsigned char));
+	_mem = _buf;
 	if ( _buf )
 	{
 		memcpy(_buf, buf, len);
@@ -92,6 +95,22 @@ int MQTTSNPacket::desirialize(unsigned char* buf, unsigned short len)
 	return _bufLen;
 }
 
+/*
+ *  Drop the first len bytes of the packet data without copying the rest,
+ *  e.g. the header of an encapsulated message.
+ *  @return the length of the remaining data, -1 if the packet is shorter than len.
+ */
+int MQTTSNPacket::trimHead(int len)
+{
+	if ( len < 0 || len > _bufLen )
+	{
+		return -1;
+	}
+	_buf += len;
+	_bufLen -= len;
+	return _bufLen;
+}
+
 int MQTTSNPacket::recv(SensorNetwork* network)
 {
 	uint8_t buf[MQTTSNGW_MAX_PACKET_SIZE];
@@ -34,6 +34,7 @@ public:
 	int recv(SensorNetwork* network);
 	int serialize(uint8_t* buf);
 	int desirialize(unsigned char* buf, unsigned short len);
+	int trimHead(int len);
 	int getType(void);
 	unsigned char* getPacketData(void);
 	int getPacketLength(void);
@@ -90,7 +91,8 @@ public:
 	char* print(char* buf);
 
 private:
-	unsigned char* _buf;    // Ptr to a packet data
+	unsigned char* _mem;    // Ptr to the allocated buffer
+	unsigned char* _buf;    // Ptr to a packet data in _mem
 	int            _bufLen; // length of the packet data
 };
 
@@ -0,0 +1,214 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - bursts of packets sent to a client
+ **************************************************************************************/
+#include "MQTTSNGWPacketBurst.h"
+#include "MQTTSNGWPacket.h"
+#include "MQTTSNGWClient.h"
+#include "MQTTSNGWProcess.h"
+#include <stdlib.h>
+
+using namespace MQTTSNGW;
+using namespace std;
+
+/*=====================================
+ Class MQTTSNPacketBurst
+ =====================================*/
+MQTTSNPacketBurst::MQTTSNPacketBurst()
+    :
+    _packets{nullptr},
+    _cnt{0},
+    _size{0}
+{
+
+}
+
+MQTTSNPacketBurst::~MQTTSNPacketBurst()
+{
+    for (int i = 0; i < _cnt; i++)
+    {
+        delete _packets[i];
+    }
+    free(_packets);
+}
+
+/*
+ *  The burst owns the packet once it is added.
+ *  @return number of packets in the burst, 0 if the packet can't be added.
+ */
+int MQTTSNPacketBurst::add(MQTTSNPacket* packet)
+{
+    if ( _cnt == _size )
+    {
+        int size = _size ? _size * 2 : PACKETBURST_INITIAL_SIZE;
+        MQTTSNPacket** packets = (MQTTSNPacket**)realloc(_packets, size * sizeof(MQTTSNPacket*));
+        if ( packets == nullptr )
+        {
+            return 0;
+        }
+        _packets = packets;
+        _size = size;
+    }
+    _packets[_cnt++] = packet;
+    return _cnt;
+}
+
+int MQTTSNPacketBurst::getCount(void)
+{
+    return _cnt;
+}
+
+MQTTSNPacket* MQTTSNPacketBurst::getPacket(int index)
+{
+    if ( index < 0 || index >= _cnt )
+    {
+        return nullptr;
+    }
+    return _packets[index];
+}
+
+/*
+ *  Takes the PUBLISHes saved while the client was asleep out of its queue.
+ *  Topics the client doesn't know yet are registered first, with one REGISTER per topic,
+ *  and the PUBLISHes using them wait in the client's WaitREGACKPacketList.
+ *  The other PUBLISHes follow the REGISTERs in the burst in the order they were saved.
+ *  @return number of packets in the burst.
+ */
+int MQTTSNPacketBurst::setClientSleepPackets(Client* client)
+{
+    MQTTGWPacket* msgs[MAX_SAVED_PUBLISH];
+    Publish pubs[MAX_SAVED_PUBLISH];
+    MQTTSN_topicid topicIds[MAX_SAVED_PUBLISH];
+    uint16_t regAckMsgIds[MAX_SAVED_PUBLISH];   // REGACK the PUBLISH waits for, 0 if none
+    bool canceled[MAX_SAVED_PUBLISH];
+    MQTTGWPacket* msg = nullptr;
+    int cnt = 0;
+
+    while ( cnt < MAX_SAVED_PUBLISH && (msg = client->getClientSleepPacket()) != nullptr )
+    {
+        client->deleteFirstClientSleepPacket();
+        msgs[cnt++] = msg;
+    }
+
+    /* resolve the TopicIds and register new topics */
+    for (int i = 0; i < cnt; i++)
+    {
+        Publish* pub = &pubs[i];
+        MQTTSN_topicid* topicId = &topicIds[i];
+        msgs[i]->getPUBLISH(pub);
+        regAckMsgIds[i] = 0;
+        canceled[i] = false;
+
+        if ( pub->topiclen <= 2 )
+        {
+            topicId->type = MQTTSN_TOPIC_TYPE_SHORT;
+            topicId->data.short_name[0] = pub->topic[0];
+            topicId->data.short_name[1] = pub->topiclen > 1 ? pub->topic[1] : 0;
+            continue;
+        }
+
+        topicId->type = MQTTSN_TOPIC_TYPE_NORMAL;
+        topicId->data.long_.len = pub->topiclen;
+        topicId->data.long_.name = pub->topic;
+        Topic* topic = client->getTopics()->getTopicByName(topicId);
+
+        if ( topic )
+        {
+            topicId->type = topic->getType();
+            topicId->data.id = topic->getTopicId();
+
+            /* registered by this burst, wait for the same REGACK */
+            for (int j = 0; j < i; j++)
+            {
+                if ( regAckMsgIds[j] && topicIds[j].data.id == topicId->data.id )
+                {
+                    regAckMsgIds[i] = regAckMsgIds[j];
+                    break;
+                }
+            }
+            continue;
+        }
+
+        /* This message might be subscribed with wild card. */
+        if ( client->getTopics()->match(topicId) == nullptr ||
+             (topic = client->getTopics()->add(topicId)) == nullptr || topic->getTopicId() == 0 )
+        {
+            WRITELOG(" Invalid Topic. PUBLISH message is canceled.\n");
+            canceled[i] = true;
+            continue;
+        }
+
+        MQTTSNString topicName = MQTTSNString_initializer;
+        topicName.lenstring.len = pub->topiclen;
+        topicName.lenstring.data = pub->topic;
+        regAckMsgIds[i] = client->getNextSnMsgId();
+
+        MQTTSNPacket* regPacket = new MQTTSNPacket();
+        regPacket->setREGISTER(topic->getTopicId(), regAckMsgIds[i], &topicName);
+        add(regPacket);
+        topicId->data.id = topic->getTopicId();
+    }
+
+    /* the PUBLISHes */
+    for (int i = 0; i < cnt; i++)
+    {
+        Publish* pub = &pubs[i];
+        if ( !canceled[i] )
+        {
+            MQTTSNPacket* snPacket = new MQTTSNPacket();
+            snPacket->setPUBLISH((uint8_t) pub->header.bits.dup, (int) pub->header.bits.qos,
+                    (uint8_t) pub->header.bits.retain, (uint16_t) pub->msgId, topicIds[i], (uint8_t*) pub->payload,
+                    pub->payloadlen);
+            if ( regAckMsgIds[i] )
+            {
+                client->getWaitREGACKPacketList()->setPacket(snPacket, regAckMsgIds[i]);
+            }
+            else
+            {
+                add(snPacket);
+            }
+        }
+        delete msgs[i];
+    }
+    return _cnt;
+}
+
+/*
+ *  Sends the packets in order, up to MAX_PACKET_BURST datagrams per SensorNetwork call.
+ *  @return number of packets sent, -1 if the SensorNetwork fails before any of them is sent.
+ */
+int MQTTSNPacketBurst::unicast(SensorNetwork* network, SensorNetAddress* sendTo)
+{
+    const uint8_t* payloads[MAX_PACKET_BURST];
+    uint16_t payloadLengths[MAX_PACKET_BURST];
+    int sent = 0;
+
+    while ( sent < _cnt )
+    {
+        int n = 0;
+        for (; n < MAX_PACKET_BURST && sent + n < _cnt; n++)
+        {
+            payloads[n] = _packets[sent + n]->getPacketData();
+            payloadLengths[n] = _packets[sent + n]->getPacketLength();
+        }
+
+        int rc = network->unicast(payloads, payloadLengths, n, sendTo);
+        if ( rc <= 0 )
+        {
+            return sent ? sent : -1;
+        }
+        sent += rc;
+    }
+    return sent;
+}
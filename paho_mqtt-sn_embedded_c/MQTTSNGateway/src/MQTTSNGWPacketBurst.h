@@ -0,0 +1,55 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - bursts of packets sent to a client
+ **************************************************************************************/
+
+#ifndef MQTTSNGATEWAY_SRC_MQTTSNGWPACKETBURST_H_
+#define MQTTSNGATEWAY_SRC_MQTTSNGWPACKETBURST_H_
+
+#include "MQTTSNGWDefines.h"
+#include "SensorNetwork.h"
+
+#define PACKETBURST_INITIAL_SIZE   16  // Packets of a burst, doubled when it fills up
+
+namespace MQTTSNGW
+{
+class MQTTSNPacket;
+class Client;
+
+/*=====================================
+ Class MQTTSNPacketBurst
+
+ Serialized packets sent to one client back to back,
+ e.g. the messages saved while the client was asleep.
+ =====================================*/
+class MQTTSNPacketBurst
+{
+public:
+    MQTTSNPacketBurst();
+    ~MQTTSNPacketBurst();
+    int add(MQTTSNPacket* packet);
+    int getCount(void);
+    MQTTSNPacket* getPacket(int index);
+    int setClientSleepPackets(Client* client);
+    int unicast(SensorNetwork* network, SensorNetAddress* sendTo);
+
+private:
+    MQTTSNPacket** _packets;
+    int _cnt;
+    int _size;
+};
+
+}
+
+#endif /* MQTTSNGATEWAY_SRC_MQTTSNGWPACKETBURST_H_ */
@@ -20,6 +20,7 @@
 #include <exception>
 #include <string>
 #include <signal.h>
+#include <stdint.h>
 #include "MQTTSNGWDefines.h"
 #include "Threading.h"
 
@@ -159,6 +160,8 @@ public:
 		_tail = nullptr;
 		_cnt = 0;
 		_maxSize = 0;
+		_dropCnt = 0;
+		_highWater = 0;
 	}
 
 	~Que()
@@ -232,8 +235,16 @@ public:
 				_tail = elm;
 			}
 			_cnt++;
+			if ( _cnt > _highWater )
+			{
+				_highWater = _cnt;
+			}
 			return _cnt;
 		}
+		if ( t )
+		{
+			_dropCnt++;
+		}
 		return 0;
 	}
 
@@ -247,13 +258,171 @@ public:
 		_maxSize = maxSize;
 	}
 
+	/* number of elements refused because the que was full */
+	uint32_t getDropCnt(void)
+	{
+		return _dropCnt;
+	}
+
+	/* largest number of elements the que has held */
+	int getHighWater(void)
+	{
+		return _highWater;
+	}
+
 private:
 	int _cnt;
 	int _maxSize;
+	uint32_t _dropCnt;
+	int _highWater;
 	QueElement<T>* _head;
 	QueElement<T>* _tail;
 };
 
+/*=====================================
+ Hash functions
+
+ hashBytes() is FNV-1a, continued from hash when it is given.
+ hashMix() spreads an integer, hashPointer() an address, over all the bits.
+ ====================================*/
+inline uint32_t hashBytes(const void* data, int len, uint32_t hash = 2166136261u)
+{
+	const uint8_t* p = (const uint8_t*)data;
+	for ( int i = 0; i < len; i++ )
+	{
+		hash = (hash ^ p[i]) * 16777619u;
+	}
+	return hash;
+}
+
+inline uint32_t hashMix(uint32_t h)
+{
+	h = (h ^ (h >> 16)) * 0x9E3779B1;
+	return h ^ (h >> 16);
+}
+
+inline uint32_t hashPointer(const void* ptr)
+{
+	return hashMix((uint32_t)((uintptr_t)ptr >> 4));
+}
+
+/*=====================================
+ Class HashTable
+
+ A chained hash table of elements linked through their Next member and hashed by Hash.
+ The buckets are a power of 2, doubled when there are as many elements.
+ The elements belong to the caller, who also does the locking.
+ ====================================*/
+template<class T, T* T::*Next, uint32_t (*Hash)(T*)>
+class HashTable
+{
+public:
+	HashTable(uint32_t initialSize)
+	{
+		_initialSize = initialSize;
+		_table = nullptr;
+		_size = 0;
+		_cnt = 0;
+	}
+
+	~HashTable()
+	{
+		delete[] _table;
+	}
+
+	/* the chain of the bucket of hash, nullptr while the table is empty */
+	T* first(uint32_t hash)
+	{
+		return _size ? _table[hash & (_size - 1)] : nullptr;
+	}
+
+	void add(T* elm)
+	{
+		if ( _cnt == _size )
+		{
+			grow();
+		}
+		link(elm);
+		_cnt++;
+	}
+
+	bool remove(T* elm)
+	{
+		if ( _size == 0 )
+		{
+			return false;
+		}
+		for ( T** pp = &_table[Hash(elm) & (_size - 1)]; *pp; pp = &((*pp)->*Next) )
+		{
+			if ( *pp == elm )
+			{
+				*pp = elm->*Next;
+				_cnt--;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/* the buckets are walked from 0 to getSize() - 1 to visit every element */
+	T* getBucket(uint32_t i)
+	{
+		return _table[i];
+	}
+
+	uint32_t getSize(void)
+	{
+		return _size;
+	}
+
+	uint32_t getCount(void)
+	{
+		return _cnt;
+	}
+
+	/* forget all elements, which the caller deletes */
+	void clear(void)
+	{
+		delete[] _table;
+		_table = nullptr;
+		_size = 0;
+		_cnt = 0;
+	}
+
+private:
+	void link(T* elm)
+	{
+		T** bucket = &_table[Hash(elm) & (_size - 1)];
+		elm->*Next = *bucket;
+		*bucket = elm;
+	}
+
+	void grow(void)
+	{
+		T** oldTable = _table;
+		uint32_t oldSize = _size;
+
+		_size = oldSize ? oldSize * 2 : _initialSize;
+		_table = new T*[_size]();
+		for ( uint32_t i = 0; i < oldSize; i++ )
+		{
+			T* elm = oldTable[i];
+			while ( elm )
+			{
+				T* next = elm->*Next;
+				link(elm);
+				elm = next;
+			}
+		}
+		delete[] oldTable;
+	}
+
+	uint32_t _initialSize;
+	T** _table;
+	uint32_t _size;
+	uint32_t _cnt;
+};
+
 /*=====================================
  Class Tree23
  ====================================*/
@@ -21,6 +21,7 @@
 #include "MQTTSNGateway.h"
 #include "MQTTSNGWClient.h"
 #include "MQTTSNGWQoSm1Proxy.h"
+#include "MQTTSNGWPacketBurst.h"
 #include <string.h>
 using namespace std;
 using namespace MQTTSNGW;
@@ -62,6 +63,42 @@ MQTTGWPacket* MQTTSNPublishHandler::handlePublish(Client* client, MQTTSNPacket*
 	{
 		return nullptr;
 	}
+
+	/* a retransmission of a QoS 1 PUBLISH sent to the broker already, its PUBACK was lost */
+	if ( dup && qos == 1 && msgId )
+	{
+		uint8_t rc = MQTTSN_RC_ACCEPTED;
+		DuplicateStatus status = _gateway->getDuplicateFilter()->check(client, msgId, topicid.data.id, payload, payloadlen, &rc);
+		if ( status == DupAcked )
+		{
+			MQTTSNPacket* pubAck = new MQTTSNPacket();
+			pubAck->setPUBACK(topicid.data.id, msgId, rc);
+			Event* ev1 = new Event();
+			ev1->setClientSendEvent(client, pubAck);
+			_gateway->getClientSendQue()->post(ev1);
+		}
+		if ( status != DupNew )
+		{
+			return nullptr;
+		}
+	}
+
+	/* Reject the PUBLISH while the broker connection that carries it is behind, the client backs off and retries */
+	GatewayParams* params = _gateway->getGWParams();
+	Client* carrier = _gateway->getAdapterManager()->getCarrier(client);
+	if ( carrier->getNetwork()->isCongested(params->maxBrokerBacklog, carrier->getBrokerSession()->getInflightLimit(params->maxInflightMsgs)) )
+	{
+		if ( msgId && qos > 0 && qos < 3 )
+		{
+			MQTTSNPacket* pubAck = new MQTTSNPacket();
+			pubAck->setPUBACK(topicid.data.id, msgId, MQTTSN_RC_REJECTED_CONGESTED);
+			Event* ev1 = new Event();
+			ev1->setClientSendEvent(client, pubAck);
+			_gateway->getClientSendQue()->post(ev1);
+		}
+		WRITELOG("%s PUBLISH of %s is rejected, the broker connection is congested.%s\n", ERRMSG_HEADER, client->getClientId(), ERRMSG_FOOTER);
+		return nullptr;
+	}
 	pub.msgId = msgId;
 	pub.header.bits.dup = dup;
 	pub.header.bits.qos = ( qos == 3 ? 0 : qos );
@@ -115,10 +152,15 @@ MQTTGWPacket* MQTTSNPublishHandler::handlePublish(Client* client, MQTTSNPacket*
 	{
 		client->setWaitedPubTopicId(msgId, topicid.data.id, topicid.type);
 	}
-
 	pub.payload = (char*)payload;
 	pub.payloadlen = payloadlen;
 
+	/* the broker's retained message changes with it */
+	if ( retained && pub.topic )
+	{
+		_gateway->getRetainedCache()->update(nullptr, pub.topic, pub.topiclen, payload, payloadlen, true);
+	}
+
 	MQTTGWPacket* publish = new MQTTGWPacket();
 	publish->setPUBLISH(&pub);
 
@@ -128,9 +170,27 @@ MQTTGWPacket* MQTTSNPublishHandler::handlePublish(Client* client, MQTTSNPacket*
 	}
 	else
 	{
+		/* counted before the post, the PUBACK may be handled before post() returns */
+		bool inflight = msgId && qos > 0 && qos < 3;
+		if ( inflight )
+		{
+			carrier->getNetwork()->addInflight(1);
+		}
 		Event* ev1 = new Event();
 		ev1->setBrokerSendEvent(client, publish);
-		_gateway->getBrokerSendQue()->post(ev1);
+		if ( !_gateway->getBrokerSendQue()->post(ev1) )
+		{
+			if ( inflight )
+			{
+				carrier->getNetwork()->addInflight(-1);
+			}
+			filterDuplicates(client, packet, false);
+			return nullptr;
+		}
+		filterDuplicates(client, packet, true);
+
+		/* subscribers behind the gateway get it without the round trip to the broker */
+		_gateway->getLocalRouter()->route(client, &pub, _gateway->getPacketEventQue());
 		return nullptr;
 	}
 }
@@ -202,10 +262,11 @@ void MQTTSNPublishHandler::handleRegister(Client* client, MQTTSNPacket* packet)
 		topicid.data.long_.len = topicName.lenstring.len;
 		topicid.data.long_.name = topicName.lenstring.data;
 
-		id = client->getTopics()->add(&topicid)->getTopicId();
+		Topic* topic = client->getTopics()->add(&topicid);
+		id = topic ? topic->getTopicId() : 0;
 
 		MQTTSNPacket* regAck = new MQTTSNPacket();
-		regAck->setREGACK(id, msgId, MQTTSN_RC_ACCEPTED);
+		regAck->setREGACK(id, msgId, topic ? MQTTSN_RC_ACCEPTED : MQTTSN_RC_REJECTED_CONGESTED);
 		Event* ev = new Event();
 		ev->setClientSendEvent(client, regAck);
 		_gateway->getClientSendQue()->post(ev);
@@ -224,15 +285,26 @@ void MQTTSNPublishHandler::handleRegAck( Client* client, MQTTSNPacket* packet)
             return;
         }
 
-        MQTTSNPacket* regAck = client->getWaitREGACKPacketList()->getPacket(msgId);
+        /* PUBLISHes of a wake-up burst may share the REGISTER */
+        MQTTSNPacketBurst* burst = new MQTTSNPacketBurst();
+        MQTTSNPacket* regAck = nullptr;
 
-        if ( regAck != nullptr )
+        while ( (regAck = client->getWaitREGACKPacketList()->getPacket(msgId)) != nullptr )
         {
             client->getWaitREGACKPacketList()->erase(msgId);
+            burst->add(regAck);
+        }
+
+        if ( burst->getCount() > 0 )
+        {
             Event* ev = new Event();
-            ev->setClientSendEvent(client, regAck);
+            ev->setClientSendEvent(client, burst);
             _gateway->getClientSendQue()->post(ev);
         }
+        else
+        {
+            delete burst;
+        }
         if (client->isHoldPringReqest() && client->getWaitREGACKPacketList()->getCount() == 0 )
         {
             /* send PINGREQ to the broker */
@@ -268,9 +340,52 @@ void MQTTSNPublishHandler::handleAggregatePublish(Client* client, MQTTSNPacket*
 			}
 			publish->setMsgId(msgId);
 		}
+		/* counted on the aggregater's connection, which the PUBACK comes back on */
+		Network* network = _gateway->getAdapterManager()->getCarrier(client)->getNetwork();
+		bool inflight = publish->getMsgId() > 0;
+		if ( inflight )
+		{
+			network->addInflight(1);
+		}
 		Event* ev1 = new Event();
 		ev1->setBrokerSendEvent(client, publish);
-		_gateway->getBrokerSendQue()->post(ev1);
+		if ( !_gateway->getBrokerSendQue()->post(ev1) )
+		{
+			if ( inflight )
+			{
+				network->addInflight(-1);
+			}
+			filterDuplicates(client, packet, false);
+		}
+		else
+		{
+			filterDuplicates(client, packet, true);
+		}
+	}
+}
+
+/*
+ *  A QoS 1 PUBLISH is known to the DuplicateFilter once it is queued to the broker,
+ *  its PUBACK is handled by this task after it. When a PUBLISH can not be queued,
+ *  the filter forgets the client and the retransmissions go to the broker again.
+ */
+void MQTTSNPublishHandler::filterDuplicates(Client* client, MQTTSNPacket* packet, bool queued)
+{
+	uint8_t dup;
+	int qos;
+	uint8_t retained;
+	uint16_t msgId;
+	MQTTSN_topicid topicid;
+	uint8_t* payload;
+	int payloadlen;
+
+	if ( !queued )
+	{
+		_gateway->getDuplicateFilter()->erase(client);
+	}
+	else if ( packet->getPUBLISH(&dup, &qos, &retained, &msgId, &topicid, &payload, &payloadlen) && msgId && qos == 1 )
+	{
+		_gateway->getDuplicateFilter()->add(client, msgId, topicid.data.id, payload, payloadlen);
 	}
 }
 
@@ -37,6 +37,8 @@ public:
 	void handleAggregateAck(Client* client, MQTTSNPacket* packet, int type);
 
 private:
+	void filterDuplicates(Client* client, MQTTSNPacket* packet, bool queued);
+
 	Gateway* _gateway;
 };
 
@@ -0,0 +1,269 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - fast lane of QoS-1 PUBLISHes
+ **************************************************************************************/
+
+#include "MQTTSNGWQoSm1FastLane.h"
+#include "MQTTSNGWClient.h"
+#include "MQTTSNGWTopic.h"
+#include "MQTTSNGWProcess.h"
+#include "MQTTGWPacket.h"
+#include "MQTTGWv5Session.h"
+#include "Network.h"
+#include <string.h>
+
+using namespace MQTTSNGW;
+
+int MQTTPacket_encode(char* buf, int length);
+
+/*=====================================
+ Class QoSm1FastLane
+ =====================================*/
+QoSm1FastLane::QoSm1FastLane()
+{
+
+}
+
+QoSm1FastLane::~QoSm1FastLane()
+{
+    for ( uint32_t i = 0; i < _table.getSize(); i++ )
+    {
+        QoSm1Sender* sender = _table.getBucket(i);
+        while ( sender )
+        {
+            QoSm1Topic* topic = sender->_topics;
+            while ( topic )
+            {
+                QoSm1Topic* next = topic->_next;
+                delete[] topic->_data;
+                delete topic;
+                topic = next;
+            }
+            QoSm1Sender* next = sender->_next;
+            sender->_client->release();
+            delete sender;
+            sender = next;
+        }
+    }
+}
+
+/*
+ *  Topics looked up after the client's own ones, the gateway's predefined topics.
+ */
+void QoSm1FastLane::setCommonTopics(Topics* topics)
+{
+    _commonTopics = topics;
+}
+
+/*
+ *  Serialize the MQTT PUBLISH of a QoS-1 PUBLISH into buf.
+ *  @return the length, 0 if the packet is not for the lane or does not fit, -1 if its TopicId is unknown.
+ */
+int QoSm1FastLane::build(Client* client, MQTTSNPacket* packet, uint8_t* buf, int bufLen)
+{
+    return build(getSender(client, true), packet, buf, bufLen);
+}
+
+int QoSm1FastLane::build(QoSm1Sender* sender, MQTTSNPacket* packet, uint8_t* buf, int bufLen)
+{
+    uint8_t dup;
+    int qos;
+    uint8_t retained;
+    uint16_t msgId;
+    MQTTSN_topicid topicid;
+    uint8_t* payload;
+    int payloadlen;
+
+    if ( packet->getPUBLISH(&dup, &qos, &retained, &msgId, &topicid, &payload, &payloadlen) == 0 || qos != 3 )
+    {
+        return 0;
+    }
+
+    if ( topicid.type != MQTTSN_TOPIC_TYPE_PREDEFINED && topicid.type != MQTTSN_TOPIC_TYPE_SHORT )
+    {
+        return 0;
+    }
+
+    QoSm1Topic* topic = getTopic(sender, &topicid);
+    if ( topic == nullptr )
+    {
+        sender->_counters.dropped++;
+        return -1;
+    }
+
+    /* fixed header, QoS 0 without a packet identifier */
+    int remainingLength = topic->_length + payloadlen;
+    char lenBuf[4];
+    int lenLen = MQTTPacket_encode(lenBuf, remainingLength);
+    int length = 1 + lenLen + remainingLength;
+    if ( length > bufLen )
+    {
+        return 0;
+    }
+
+    uint8_t* ptr = buf;
+    *ptr++ = (PUBLISH << 4) | (retained ? 1 : 0);
+    memcpy(ptr, lenBuf, lenLen);
+    ptr += lenLen;
+    memcpy(ptr, topic->_data, topic->_length);
+    ptr += topic->_length;
+    memcpy(ptr, payload, payloadlen);
+    return length;
+}
+
+/*
+ *  Queue the MQTT PUBLISH of a QoS-1 PUBLISH on network, through the session of the broker connection.
+ *  Nothing is written here, a PUBLISH that does not fit the queue is dropped, and the bytes queued
+ *  count in the network's backlog until BrokerSendTask writes them.
+ *  @param first  set when it is the first packet in the network's queue, someone has to flush it.
+ *  @return bytes queued, 0 if the packet is not for the lane, -1 if it was dropped.
+ */
+int QoSm1FastLane::publish(Client* client, MQTTSNPacket* packet, Network* network, MQTTGWv5Session* session, bool* first)
+{
+    uint8_t buf[MQTTSNGW_MAX_PACKET_SIZE];
+    QoSm1Sender* sender = getSender(client, true);
+
+    int length = build(sender, packet, buf, MQTTSNGW_MAX_PACKET_SIZE);
+    if ( length <= 0 )
+    {
+        return length;
+    }
+
+    if ( session->queue(network, buf, length, BROKER_SEND_LATENCY, first, true) <= 0 )
+    {
+        sender->_counters.dropped++;
+        return -1;
+    }
+    sender->_counters.published++;
+    sender->_counters.bytes += length;
+    return length;
+}
+
+/*
+ *  Count a PUBLISH dropped by the caller.
+ */
+void QoSm1FastLane::drop(Client* client)
+{
+    getSender(client, true)->_counters.dropped++;
+}
+
+bool QoSm1FastLane::getCounters(Client* client, QoSm1Counters* counters)
+{
+    QoSm1Sender* sender = getSender(client, false);
+    if ( sender == nullptr )
+    {
+        return false;
+    }
+    *counters = sender->_counters;
+    return true;
+}
+
+void QoSm1FastLane::getTotals(QoSm1Counters* counters)
+{
+    memset(counters, 0, sizeof(QoSm1Counters));
+    for ( uint32_t i = 0; i < _table.getSize(); i++ )
+    {
+        for ( QoSm1Sender* sender = _table.getBucket(i); sender; sender = sender->_next )
+        {
+            counters->published += sender->_counters.published;
+            counters->dropped += sender->_counters.dropped;
+            counters->bytes += sender->_counters.bytes;
+        }
+    }
+}
+
+uint32_t QoSm1FastLane::getSenderCount(void)
+{
+    return _table.getCount();
+}
+
+uint32_t QoSm1FastLane::hashOf(QoSm1Sender* sender)
+{
+    return hashPointer(sender->_client);
+}
+
+QoSm1Sender* QoSm1FastLane::getSender(Client* client, bool create)
+{
+    for ( QoSm1Sender* sender = _table.first(hashPointer(client)); sender; sender = sender->_next )
+    {
+        if ( sender->_client == client )
+        {
+            return sender;
+        }
+    }
+
+    if ( !create )
+    {
+        return nullptr;
+    }
+
+    /* held as long as the lane keeps its topics, QoS-1 clients are not erased anyway */
+    QoSm1Sender* sender = new QoSm1Sender();
+    sender->_client = client;
+    client->hold();
+    _table.add(sender);
+    return sender;
+}
+
+/*
+ *  The serialized topic name of a TopicId, resolved from the client's topics
+ *  and then from the gateway's ones the first time it is used.
+ *  A client has a few TopicIds, they are kept in a list.
+ */
+QoSm1Topic* QoSm1FastLane::getTopic(QoSm1Sender* sender, MQTTSN_topicid* topicid)
+{
+    uint16_t id = topicid->type == MQTTSN_TOPIC_TYPE_SHORT ?
+            ((uint8_t)topicid->data.short_name[0] << 8) | (uint8_t)topicid->data.short_name[1] : topicid->data.id;
+
+    for ( QoSm1Topic* topic = sender->_topics; topic; topic = topic->_next )
+    {
+        if ( topic->_topicId == id && topic->_type == topicid->type )
+        {
+            return topic;
+        }
+    }
+
+    const char* name = topicid->data.short_name;
+    int length = 2;
+
+    if ( topicid->type == MQTTSN_TOPIC_TYPE_PREDEFINED )
+    {
+        Topic* tp = sender->_client->getTopics()->getTopicById(topicid);
+        if ( tp == nullptr && _commonTopics )
+        {
+            tp = _commonTopics->getTopicById(topicid);
+        }
+        if ( tp == nullptr )
+        {
+            /* the senders of the proxy have no client id, they are told by their address */
+            char buf[128];
+            WRITELOG("%s Invalid TopicId %u from %s.%s\n", ERRMSG_HEADER, id, sender->_client->getSensorNetAddress()->sprint(buf), ERRMSG_FOOTER);
+            return nullptr;
+        }
+        name = tp->getTopicName()->c_str();
+        length = tp->getTopicName()->length();
+    }
+
+    QoSm1Topic* topic = new QoSm1Topic();
+    topic->_topicId = id;
+    topic->_type = topicid->type;
+    topic->_length = length + 2;
+    topic->_data = new uint8_t[length + 2];
+    topic->_data[0] = (uint8_t)(length >> 8);
+    topic->_data[1] = (uint8_t)length;
+    memcpy(topic->_data + 2, name, length);
+    topic->_next = sender->_topics;
+    sender->_topics = topic;
+    return topic;
+}
@@ -0,0 +1,98 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - fast lane of QoS-1 PUBLISHes
+ **************************************************************************************/
+
+#ifndef MQTTSNGATEWAY_SRC_MQTTSNGWQOSM1FASTLANE_H_
+#define MQTTSNGATEWAY_SRC_MQTTSNGWQOSM1FASTLANE_H_
+
+#include "MQTTSNGWDefines.h"
+#include "MQTTSNGWPacket.h"
+#include "MQTTSNGWProcess.h"
+
+#define QOSM1_LANE_INITIAL_TABLE_SIZE  64   // Buckets of the sender table, doubled when it fills up
+
+class Network;
+
+namespace MQTTSNGW
+{
+class Client;
+class Topics;
+class MQTTGWv5Session;
+
+/* Counters of one QoS-1 client */
+typedef struct
+{
+    uint32_t published;   // PUBLISHes queued to the broker
+    uint32_t dropped;     // PUBLISHes with an unknown TopicId, or received while the broker connection was congested or its queue full
+    uint64_t bytes;       // bytes of the MQTT PUBLISHes queued
+} QoSm1Counters;
+
+/* MQTT topic name of a TopicId, 2 bytes of length followed by the name, as written in a PUBLISH */
+class QoSm1Topic
+{
+    friend class QoSm1FastLane;
+private:
+    uint16_t _topicId {0};
+    uint8_t _type {0};
+    uint16_t _length {0};
+    uint8_t* _data {nullptr};
+    QoSm1Topic* _next {nullptr};
+};
+
+class QoSm1Sender
+{
+    friend class QoSm1FastLane;
+private:
+    Client* _client {nullptr};
+    QoSm1Counters _counters {0, 0, 0};
+    QoSm1Topic* _topics {nullptr};
+    QoSm1Sender* _next {nullptr};
+};
+
+/*=====================================
+ Class QoSm1FastLane
+
+ Translates QoS-1 PUBLISHes with a predefined or a short TopicId into MQTT PUBLISHes
+ and queues them on the QoS-1 proxy's broker connection in the thread that received them,
+ without a PacketHandleTask or a BrokerSendTask event per message.
+ The topic names are serialized once per client and TopicId.
+ Used by ClientRecvTask only, counters may be read from any thread.
+ =====================================*/
+class QoSm1FastLane
+{
+public:
+    QoSm1FastLane();
+    ~QoSm1FastLane();
+
+    void setCommonTopics(Topics* topics);
+    int build(Client* client, MQTTSNPacket* packet, uint8_t* buf, int bufLen);
+    int publish(Client* client, MQTTSNPacket* packet, Network* network, MQTTGWv5Session* session, bool* first);
+    void drop(Client* client);
+    bool getCounters(Client* client, QoSm1Counters* counters);
+    void getTotals(QoSm1Counters* counters);
+    uint32_t getSenderCount(void);
+
+private:
+    int build(QoSm1Sender* sender, MQTTSNPacket* packet, uint8_t* buf, int bufLen);
+    QoSm1Sender* getSender(Client* client, bool create);
+    QoSm1Topic* getTopic(QoSm1Sender* sender, MQTTSN_topicid* topicid);
+    static uint32_t hashOf(QoSm1Sender* sender);
+
+    Topics* _commonTopics {nullptr};
+    HashTable<QoSm1Sender, &QoSm1Sender::_next, &QoSm1FastLane::hashOf> _table {QOSM1_LANE_INITIAL_TABLE_SIZE};   // senders by Client
+};
+
+}
+#endif /* MQTTSNGATEWAY_SRC_MQTTSNGWQOSM1FASTLANE_H_ */
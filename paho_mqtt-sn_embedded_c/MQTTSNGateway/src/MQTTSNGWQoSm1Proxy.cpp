@@ -57,6 +57,7 @@ void QoSm1Proxy::initialize(void)
             /* initialize Adapter */
 			string name = string(_gateway->getGWParams()->gatewayName) + "QoS-1";
             setup(name.c_str(), Atype_QoSm1Proxy);
+            _fastLane.setCommonTopics(_gateway->getTopics());
            _isActive = true;
         }
     }
@@ -68,3 +69,40 @@ bool QoSm1Proxy::isActive(void)
     return _isActive;
 }
 
+/*
+ *  Queue a PUBLISH of a QoS-1 client on the proxy's broker connection in the calling thread, ClientRecvTask.
+ *  BrokerSendTask is only told to write the queue when the PUBLISH is its first packet.
+ *  @return bytes queued, -1 if the PUBLISH was dropped,
+ *          0 if it has to go through PacketHandleTask, the proxy is not connected or the TopicId is not predefined nor short.
+ */
+int QoSm1Proxy::publish(Client* client, MQTTSNPacket* packet)
+{
+    Client* proxyClient = client->isSecureNetwork() ? getSecureClient() : getClient();
+
+    if ( !_isActive || proxyClient == nullptr || !proxyClient->isActive() || !proxyClient->getNetwork()->isValid() )
+    {
+        return 0;
+    }
+
+    GatewayParams* params = _gateway->getGWParams();
+    if ( proxyClient->getNetwork()->isCongested(params->maxBrokerBacklog, params->maxInflightMsgs) )
+    {
+        _fastLane.drop(client);
+        return -1;
+    }
+
+    bool first = false;
+    int rc = _fastLane.publish(client, packet, proxyClient->getNetwork(), proxyClient->getBrokerSession(), &first);
+    if ( first )
+    {
+        Event* ev = new Event();
+        ev->setBrokerFlushEvent(proxyClient);
+        _gateway->getBrokerSendQue()->post(ev);
+    }
+    return rc;
+}
+
+QoSm1FastLane* QoSm1Proxy::getFastLane(void)
+{
+    return &_fastLane;
+}
@@ -18,6 +18,7 @@
 #define MQTTSNGATEWAY_SRC_MQTTSNGWQOSM1PROXY_H_
 
 #include "MQTTSNGWAdapter.h"
+#include "MQTTSNGWQoSm1FastLane.h"
 namespace MQTTSNGW
 {
 class Gateway;
@@ -37,9 +38,12 @@ public:
 
     void initialize(void);
     bool isActive(void);
+    int publish(Client* client, MQTTSNPacket* packet);
+    QoSm1FastLane* getFastLane(void);
 
 private:
     Gateway* _gateway;
+    QoSm1FastLane _fastLane;
 
     bool _isActive {false};
     bool _isSecure {false};
@@ -0,0 +1,272 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - replay of captured datagrams
+ **************************************************************************************/
+
+
+#include "MQTTSNGWReplayer.h"
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+using namespace MQTTSNGW;
+
+/*=====================================
+ Class Replayer
+ =====================================*/
+Replayer::Replayer()
+{
+
+}
+
+Replayer::~Replayer()
+{
+    close();
+}
+
+/**
+ *  Open a capture to replay to ipAddress:portNo.
+ *  @param capturedPortNo is the gateway's port in the capture, GatewayPortNo= of the captured gateway
+ *  @return false when the file can't be read or the address is invalid
+ */
+bool Replayer::open(const char* fileName, const char* ipAddress, uint16_t portNo, uint16_t capturedPortNo)
+{
+    close();
+    memset(&_counters, 0, sizeof(_counters));
+    if ( (_ipAddress = inet_addr(ipAddress)) == INADDR_NONE || portNo == 0 || !_reader.open(fileName) )
+    {
+        return false;
+    }
+    _portNo = htons(portNo);
+    _capturedPortNo = htons(capturedPortNo);
+    if ( (_epollfd = epoll_create1(0)) < 0 )
+    {
+        _reader.close();
+        return false;
+    }
+    return true;
+}
+
+void Replayer::close(void)
+{
+    for ( uint32_t i = 0; i < _table.getSize(); i++ )
+    {
+        ReplaySender* sender = _table.getBucket(i);
+        while ( sender )
+        {
+            ReplaySender* next = sender->_next;
+            ::close(sender->_sockfd);
+            delete sender;
+            sender = next;
+        }
+    }
+    _table.clear();
+    if ( _epollfd >= 0 )
+    {
+        ::close(_epollfd);
+        _epollfd = -1;
+    }
+    _reader.close();
+}
+
+/**
+ *  Send the datagrams of the capture.
+ *  @param speed is 1 for the speed of the capture, N for N times faster, 0 for as fast as possible
+ *  @return number of datagrams sent, -1 when a socket can't be created
+ */
+int Replayer::run(double speed)
+{
+    SensorNetRecord rec;
+    uint64_t start = 0;
+    uint64_t first = 0;
+    uint64_t last = 0;
+
+    while ( _reader.next(&rec) )
+    {
+        if ( !isReplayed(&rec) )
+        {
+            continue;
+        }
+        ReplaySender* sender = getSender(&rec);
+        if ( sender == nullptr )
+        {
+            return -1;
+        }
+
+        if ( start == 0 )
+        {
+            start = now();
+            first = rec.nsecs;
+        }
+        if ( speed > 0 )
+        {
+            /* datagrams of both directions are recorded by different threads, times may go back a little */
+            uint64_t offset = (rec.nsecs > first) ? (uint64_t)((rec.nsecs - first) / speed) : 0;
+            uint64_t due = start + offset;
+            waitUntil(due);
+            uint64_t lag = now() - due;
+            if ( lag > REPLAY_LATE_NSECS )
+            {
+                _counters.late++;
+            }
+            if ( lag > _counters.maxLag )
+            {
+                _counters.maxLag = lag;
+            }
+        }
+        else if ( (_counters.sent & 63) == 0 )
+        {
+            drain(0);
+        }
+
+        if ( ::send(sender->_sockfd, rec.data, rec.length, 0) < 0 )
+        {
+            _counters.failed++;
+        }
+        else
+        {
+            _counters.sent++;
+        }
+        last = now();
+    }
+    _counters.elapsed = last - start;
+    waitUntil(now() + REPLAY_LINGER * 1000000ULL);
+    return _counters.sent;
+}
+
+void Replayer::getCounters(ReplayCounters* counters)
+{
+    *counters = _counters;
+}
+
+/*
+ *  A datagram a client sent to the gateway, to its port or to the multicast group.
+ */
+bool Replayer::isReplayed(SensorNetRecord* rec)
+{
+    if ( rec->srcPort == _capturedPortNo )
+    {
+        return false;
+    }
+    return rec->dstPort == _capturedPortNo || (ntohl(rec->dstAddress) >> 28) == 0x0e;
+}
+
+uint32_t Replayer::hash(uint32_t ipAddress, uint16_t portNo)
+{
+    return hashMix(ipAddress ^ ((uint32_t)portNo << 16) ^ portNo);
+}
+
+uint32_t Replayer::hashOf(ReplaySender* sender)
+{
+    return hash(sender->_ipAddress, sender->_portNo);
+}
+
+/*
+ *  The socket of the datagram's sender, created and connected to the gateway the first time.
+ */
+ReplaySender* Replayer::getSender(SensorNetRecord* rec)
+{
+    for ( ReplaySender* sender = _table.first(hash(rec->srcAddress, rec->srcPort)); sender; sender = sender->_next )
+    {
+        if ( sender->_ipAddress == rec->srcAddress && sender->_portNo == rec->srcPort )
+        {
+            return sender;
+        }
+    }
+
+    sockaddr_in dest;
+    memset(&dest, 0, sizeof(dest));
+    dest.sin_family = AF_INET;
+    dest.sin_port = _portNo;
+    dest.sin_addr.s_addr = _ipAddress;
+
+    int sockfd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if ( sockfd < 0 )
+    {
+        return nullptr;
+    }
+    fcntl(sockfd, F_SETFL, fcntl(sockfd, F_GETFL) | O_NONBLOCK);
+    if ( connect(sockfd, (sockaddr*)&dest, sizeof(dest)) < 0 )
+    {
+        ::close(sockfd);
+        return nullptr;
+    }
+
+    ReplaySender* sender = new ReplaySender();
+    sender->_ipAddress = rec->srcAddress;
+    sender->_portNo = rec->srcPort;
+    sender->_sockfd = sockfd;
+    _table.add(sender);
+    _counters.senders++;
+
+    epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.ptr = sender;
+    epoll_ctl(_epollfd, EPOLL_CTL_ADD, sockfd, &ev);
+    return sender;
+}
+
+/*
+ *  Read the replies until due, a monotonic time. The last msec is slept.
+ */
+void Replayer::waitUntil(uint64_t due)
+{
+    uint64_t t;
+    while ( (t = now()) < due )
+    {
+        if ( due - t > 2000000 )
+        {
+            drain((int)((due - t) / 1000000) - 1);
+        }
+        else
+        {
+            struct timespec ts;
+            ts.tv_sec = due / 1000000000ULL;
+            ts.tv_nsec = due % 1000000000ULL;
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr);
+        }
+    }
+}
+
+/*
+ *  Read the datagrams the gateway sent to the senders, waiting up to msecs for the first ones.
+ */
+void Replayer::drain(int msecs)
+{
+    epoll_event events[64];
+    uint8_t buf[MQTTSNGW_MAX_PACKET_SIZE];
+
+    int n = epoll_wait(_epollfd, events, 64, msecs);
+    for ( int i = 0; i < n; i++ )
+    {
+        ReplaySender* sender = (ReplaySender*)events[i].data.ptr;
+        while ( ::recv(sender->_sockfd, buf, sizeof(buf), 0) >= 0 )
+        {
+            _counters.replies++;
+        }
+    }
+}
+
+uint64_t Replayer::now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
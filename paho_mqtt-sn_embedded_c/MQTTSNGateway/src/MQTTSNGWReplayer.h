@@ -0,0 +1,93 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - replay of captured datagrams
+ **************************************************************************************/
+
+#ifndef MQTTSNGATEWAY_SRC_MQTTSNGWREPLAYER_H_
+#define MQTTSNGATEWAY_SRC_MQTTSNGWREPLAYER_H_
+
+#include "MQTTSNGWDefines.h"
+#include "SensorNetCapture.h"
+#include "MQTTSNGWProcess.h"
+
+#define REPLAY_INITIAL_TABLE_SIZE  64   // Buckets of the sender table, doubled when it fills up
+#define REPLAY_LATE_NSECS     1000000   // A datagram sent later than this after its time is counted as late
+#define REPLAY_LINGER            1000   // msecs the replies of the gateway are still read after the last datagram
+
+namespace MQTTSNGW
+{
+
+/* Counters of a replay */
+typedef struct
+{
+    uint32_t sent;        // datagrams sent to the gateway
+    uint32_t failed;      // datagrams the socket refused
+    uint32_t late;        // datagrams sent more than REPLAY_LATE_NSECS after their time
+    uint32_t replies;     // datagrams received from the gateway
+    uint32_t senders;     // clients of the capture, each replayed from a socket of its own
+    uint64_t maxLag;      // nanosecs the latest datagram was sent after its time
+    uint64_t elapsed;     // nanosecs from the first to the last datagram sent
+} ReplayCounters;
+
+class ReplaySender
+{
+    friend class Replayer;
+private:
+    uint32_t _ipAddress {0};
+    uint16_t _portNo {0};
+    int _sockfd {-1};
+    ReplaySender* _next {nullptr};
+};
+
+/*=====================================
+ Class Replayer
+
+ Sends the datagrams a gateway received in a capture, CaptureFile=, to a gateway's
+ UDP port, at the speed they were captured, N times faster, or as fast as possible.
+ The datagrams sent to the captured gateway port or to a multicast group are replayed,
+ each client from a socket of its own so that the gateway tells them apart, and in the
+ order of the capture, which keeps the order of each client's datagrams at any speed.
+ Replies of the gateway are read and counted.
+ =====================================*/
+class Replayer
+{
+public:
+    Replayer();
+    ~Replayer();
+
+    bool open(const char* fileName, const char* ipAddress, uint16_t portNo, uint16_t capturedPortNo);
+    int run(double speed);
+    void close(void);
+    void getCounters(ReplayCounters* counters);
+
+private:
+    bool isReplayed(SensorNetRecord* rec);
+    ReplaySender* getSender(SensorNetRecord* rec);
+    static uint32_t hash(uint32_t ipAddress, uint16_t portNo);
+    static uint32_t hashOf(ReplaySender* sender);
+    void waitUntil(uint64_t due);
+    void drain(int msecs);
+    static uint64_t now(void);
+
+    SensorNetCaptureReader _reader;
+    uint32_t _ipAddress {0};      // gateway the datagrams are sent to, network byte order
+    uint16_t _portNo {0};
+    uint16_t _capturedPortNo {0};
+    int _epollfd {-1};
+    HashTable<ReplaySender, &ReplaySender::_next, &Replayer::hashOf> _table {REPLAY_INITIAL_TABLE_SIZE};   // senders by address and port
+    ReplayCounters _counters {0, 0, 0, 0, 0, 0, 0};
+};
+
+}
+#endif /* MQTTSNGATEWAY_SRC_MQTTSNGWREPLAYER_H_ */
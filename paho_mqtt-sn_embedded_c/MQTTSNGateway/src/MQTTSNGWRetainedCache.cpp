@@ -0,0 +1,268 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - cache of retained messages
+ **************************************************************************************/
+
+#include "MQTTSNGWRetainedCache.h"
+#include <stdlib.h>
+#include <string.h>
+
+using namespace MQTTSNGW;
+
+/*=====================================
+ Class RetainedCache
+ =====================================*/
+RetainedCache::RetainedCache()
+{
+
+}
+
+RetainedCache::~RetainedCache()
+{
+    while ( _oldest )
+    {
+        erase(_oldest);
+    }
+}
+
+/*
+ *  @param maxMessages  messages kept, 0: the cache is not used.
+ *  @param expiry  secs a message is served after it was stored, 0: no limit.
+ */
+void RetainedCache::initialize(uint32_t maxMessages, uint32_t expiry)
+{
+    _maxMessages = maxMessages;
+    _expiry = expiry;
+}
+
+bool RetainedCache::isActive(void)
+{
+    return _maxMessages > 0;
+}
+
+/*
+ *  Keep the cache in step with a PUBLISH of the topic, from the broker or to it.
+ *  @param client  the client the broker sends the PUBLISH to, nullptr for a client's PUBLISH to the broker.
+ *  @return true if the client was served the same retained message from the cache and waits for no other.
+ */
+bool RetainedCache::update(Client* client, const char* topic, uint16_t topicLen, const uint8_t* payload, uint16_t payloadLen, bool retained)
+{
+    if ( !isActive() )
+    {
+        return false;
+    }
+
+    bool served = false;
+    uint32_t hash = hashBytes(topic, topicLen);
+    _mutex.lock();
+    RetainedMessage* msg = find(topic, topicLen, hash);
+    bool same = msg && msg->_payloadLen == payloadLen && memcmp(msg->_payload, payload, payloadLen) == 0;
+
+    if ( !retained || payloadLen == 0 )
+    {
+        /* a retained update the broker forwarded without the flag, or the retained message is deleted */
+        if ( msg && (!same || retained) )
+        {
+            erase(msg);
+            _counters.evictions++;
+        }
+    }
+    else if ( same )
+    {
+        for ( uint8_t i = 0; i < msg->_servedCnt; i++ )
+        {
+            if ( msg->_served[i] == client )
+            {
+                msg->_served[i] = msg->_served[--msg->_servedCnt];
+                _counters.duplicates++;
+                served = true;
+                break;
+            }
+        }
+        msg->_stored = time(nullptr);
+        unlink(msg);
+        append(msg);
+    }
+    else
+    {
+        if ( msg )
+        {
+            erase(msg);
+        }
+        else if ( _table.getCount() >= _maxMessages )
+        {
+            erase(_oldest);
+            _counters.evictions++;
+        }
+
+        msg = new RetainedMessage();
+        msg->_topic = (char*)malloc(topicLen);
+        msg->_payload = (uint8_t*)malloc(payloadLen);
+        memcpy(msg->_topic, topic, topicLen);
+        memcpy(msg->_payload, payload, payloadLen);
+        msg->_topicLen = topicLen;
+        msg->_payloadLen = payloadLen;
+        msg->_hash = hash;
+        msg->_stored = time(nullptr);
+
+        _table.add(msg);
+        append(msg);
+    }
+    _mutex.unlock();
+    return served;
+}
+
+/*
+ *  The retained message of a topic as a QoS 0 PUBLISH with topicId, for a client subscribing to it.
+ *  @return nullptr if the cache does not hold it.
+ */
+MQTTSNPacket* RetainedCache::serve(Client* client, const char* topic, uint16_t topicLen, MQTTSN_topicid* topicId)
+{
+    if ( !isActive() )
+    {
+        return nullptr;
+    }
+
+    MQTTSNPacket* packet = nullptr;
+    _mutex.lock();
+    RetainedMessage* msg = find(topic, topicLen, hashBytes(topic, topicLen));
+    if ( msg && _expiry && time(nullptr) - msg->_stored >= (time_t)_expiry )
+    {
+        erase(msg);
+        _counters.evictions++;
+        msg = nullptr;
+    }
+
+    if ( msg == nullptr )
+    {
+        _counters.misses++;
+    }
+    else
+    {
+        packet = new MQTTSNPacket();
+        packet->setPUBLISH(0, 0, 1, 0, *topicId, msg->_payload, msg->_payloadLen);
+
+        uint8_t i = 0;
+        while ( i < msg->_servedCnt && msg->_served[i] != client )
+        {
+            i++;
+        }
+        if ( i == msg->_servedCnt )
+        {
+            if ( msg->_servedCnt == RETAINED_CACHE_MAX_SERVED )
+            {
+                /* the oldest one gets the broker's copy as well */
+                memmove(msg->_served, msg->_served + 1, sizeof(Client*) * (RETAINED_CACHE_MAX_SERVED - 1));
+                msg->_servedCnt--;
+            }
+            msg->_served[msg->_servedCnt++] = client;
+        }
+        _counters.hits++;
+    }
+    _mutex.unlock();
+    return packet;
+}
+
+/*
+ *  The client waits for no broker's copy of the messages it was served.
+ */
+void RetainedCache::forget(Client* client)
+{
+    _mutex.lock();
+    for ( RetainedMessage* msg = _oldest; msg; msg = msg->_newer )
+    {
+        for ( uint8_t i = 0; i < msg->_servedCnt; i++ )
+        {
+            if ( msg->_served[i] == client )
+            {
+                msg->_served[i] = msg->_served[--msg->_servedCnt];
+                break;
+            }
+        }
+    }
+    _mutex.unlock();
+}
+
+void RetainedCache::getCounters(RetainedCacheCounters* counters)
+{
+    _mutex.lock();
+    *counters = _counters;
+    _mutex.unlock();
+}
+
+uint32_t RetainedCache::getCount(void)
+{
+    return _table.getCount();
+}
+
+uint32_t RetainedCache::hashOf(RetainedMessage* msg)
+{
+    return msg->_hash;
+}
+
+RetainedMessage* RetainedCache::find(const char* topic, uint16_t topicLen, uint32_t hash)
+{
+    for ( RetainedMessage* msg = _table.first(hash); msg; msg = msg->_next )
+    {
+        if ( msg->_hash == hash && msg->_topicLen == topicLen && memcmp(msg->_topic, topic, topicLen) == 0 )
+        {
+            return msg;
+        }
+    }
+    return nullptr;
+}
+
+void RetainedCache::erase(RetainedMessage* msg)
+{
+    _table.remove(msg);
+    unlink(msg);
+    free(msg->_topic);
+    free(msg->_payload);
+    delete msg;
+}
+
+void RetainedCache::unlink(RetainedMessage* msg)
+{
+    if ( msg->_older )
+    {
+        msg->_older->_newer = msg->_newer;
+    }
+    else
+    {
+        _oldest = msg->_newer;
+    }
+    if ( msg->_newer )
+    {
+        msg->_newer->_older = msg->_older;
+    }
+    else
+    {
+        _newest = msg->_older;
+    }
+    msg->_newer = msg->_older = nullptr;
+}
+
+void RetainedCache::append(RetainedMessage* msg)
+{
+    msg->_older = _newest;
+    if ( _newest )
+    {
+        _newest->_newer = msg;
+    }
+    else
+    {
+        _oldest = msg;
+    }
+    _newest = msg;
+}
@@ -0,0 +1,101 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - cache of retained messages
+ **************************************************************************************/
+
+#ifndef MQTTSNGATEWAY_SRC_MQTTSNGWRETAINEDCACHE_H_
+#define MQTTSNGATEWAY_SRC_MQTTSNGWRETAINEDCACHE_H_
+
+#include <time.h>
+#include "MQTTSNGWDefines.h"
+#include "MQTTSNGWPacket.h"
+#include "Threading.h"
+#include "MQTTSNGWProcess.h"
+
+#define RETAINED_CACHE_INITIAL_TABLE_SIZE  64   // Buckets of the retained message table, doubled when it fills up
+#define RETAINED_CACHE_MAX_SERVED           8   // Clients served a message who have not got the broker's copy yet
+
+namespace MQTTSNGW
+{
+class Client;
+
+/* Counters of the cache */
+typedef struct
+{
+    uint32_t hits;        // SUBSCRIBEs answered from the cache
+    uint32_t misses;      // SUBSCRIBEs to a topic the cache does not hold
+    uint32_t duplicates;  // copies from the broker of a message a client was served already
+    uint32_t evictions;   // messages dropped to make room, expired or stale
+} RetainedCacheCounters;
+
+class RetainedMessage
+{
+    friend class RetainedCache;
+private:
+    char* _topic {nullptr};
+    uint16_t _topicLen {0};
+    uint8_t* _payload {nullptr};
+    uint16_t _payloadLen {0};
+    uint32_t _hash {0};
+    time_t _stored {0};
+    Client* _served[RETAINED_CACHE_MAX_SERVED];
+    uint8_t _servedCnt {0};
+    RetainedMessage* _next {nullptr};     // hash chain
+    RetainedMessage* _newer {nullptr};    // least recently stored first
+    RetainedMessage* _older {nullptr};
+};
+
+/*=====================================
+ Class RetainedCache
+
+ The broker's retained messages seen by the gateway, by topic name, RetainedCache=<messages>.
+ They are stored from the retained PUBLISHes the broker sends and the ones the clients publish,
+ and dropped by an empty retained PUBLISH, by a PUBLISH of the topic with another payload,
+ which may be a retained update the broker forwards without the flag, and after RetainedCacheExpiry secs.
+ A SUBSCRIBE to a topic the cache holds is answered by the gateway with a SUBACK and the message,
+ the broker's copy that follows is not sent again to the client. The SUBSCRIBE still goes to the broker,
+ a client whose subscription the broker rejects is forgotten and disconnected.
+ =====================================*/
+class RetainedCache
+{
+public:
+    RetainedCache();
+    ~RetainedCache();
+
+    void initialize(uint32_t maxMessages, uint32_t expiry);
+    bool isActive(void);
+    bool update(Client* client, const char* topic, uint16_t topicLen, const uint8_t* payload, uint16_t payloadLen, bool retained);
+    MQTTSNPacket* serve(Client* client, const char* topic, uint16_t topicLen, MQTTSN_topicid* topicId);
+    void forget(Client* client);
+    void getCounters(RetainedCacheCounters* counters);
+    uint32_t getCount(void);
+
+private:
+    RetainedMessage* find(const char* topic, uint16_t topicLen, uint32_t hash);
+    void erase(RetainedMessage* msg);
+    void unlink(RetainedMessage* msg);
+    void append(RetainedMessage* msg);
+    static uint32_t hashOf(RetainedMessage* msg);
+
+    Mutex _mutex;
+    uint32_t _maxMessages {0};
+    uint32_t _expiry {0};
+    HashTable<RetainedMessage, &RetainedMessage::_next, &RetainedCache::hashOf> _table {RETAINED_CACHE_INITIAL_TABLE_SIZE};   // messages by topic name
+    RetainedMessage* _oldest {nullptr};
+    RetainedMessage* _newest {nullptr};
+    RetainedCacheCounters _counters {0, 0, 0, 0};
+};
+
+}
+#endif /* MQTTSNGATEWAY_SRC_MQTTSNGWRETAINEDCACHE_H_ */
@@ -45,6 +45,8 @@ MQTTGWPacket* MQTTSNSubscribeHandler::handleSubscribe(Client* client, MQTTSNPack
     MQTTGWPacket* subscribe;
     Event* ev1;
     Event* evsuback;
+    const char* topicName = nullptr;
+    char topicstr[3];
 
 	if ( packet->getSUBSCRIBE(&dup, &qos, &msgId, &topicFilter) == 0 )
 	{
@@ -64,8 +66,9 @@ MQTTGWPacket* MQTTSNSubscribeHandler::handleSubscribe(Client* client, MQTTSNPack
         if ( topic )
         {
             topicId = topic->getTopicId();
+            topicName = topic->getTopicName()->c_str();
             subscribe = new MQTTGWPacket();
-            subscribe->setSUBSCRIBE((char*)topic->getTopicName()->c_str(), (uint8_t)qos, (uint16_t)msgId);
+            subscribe->setSUBSCRIBE((char*)topicName, (uint8_t)qos, (uint16_t)msgId);
         }
         else
         {
@@ -93,21 +96,37 @@ MQTTGWPacket* MQTTSNSubscribeHandler::handleSubscribe(Client* client, MQTTSNPack
             }
         }
         topicId = topic->getTopicId();
+        topicName = topic->getTopicName()->c_str();
         subscribe = new MQTTGWPacket();
 
-        subscribe->setSUBSCRIBE((char*)topic->getTopicName()->c_str(), (uint8_t)qos, (uint16_t)msgId);
+        subscribe->setSUBSCRIBE((char*)topicName, (uint8_t)qos, (uint16_t)msgId);
     }
     else  //MQTTSN_TOPIC_TYPE_SHORT
     {
-        char topicstr[3];
         topicstr[0] = topicFilter.data.short_name[0];
         topicstr[1] = topicFilter.data.short_name[1];
         topicstr[2] = 0;
+        topicName = topicstr;
         topicId = 0;
         subscribe = new MQTTGWPacket();
         subscribe->setSUBSCRIBE(topicstr, (uint8_t)qos, (uint16_t)msgId);
     }
 
+    if ( !client->isAggregated() && topicName )
+    {
+        _gateway->getLocalRouter()->subscribe(client, topicName, (uint8_t)qos, msgId);
+    }
+
+    if ( !client->isAggregated() && serveRetained(client, topicName, &topicFilter, topicId, qos, msgId) )
+    {
+        /* the broker's SUBACK is still waited for, the client is told if the broker rejects it */
+        client->setWaitedSubTopicId(msgId, topicId, topicFilter.type, true);
+        ev1 = new Event();
+        ev1->setBrokerSendEvent(client, subscribe);
+        _gateway->getBrokerSendQue()->post(ev1);
+        return nullptr;
+    }
+
     client->setWaitedSubTopicId(msgId, topicId, topicFilter.type);
 
     if ( !client->isAggregated() )
@@ -132,6 +151,49 @@ RespExit:
      return nullptr;
 }
 
+/*
+ *  Answer a SUBSCRIBE to a topic whose retained message the gateway holds, without waiting for the broker.
+ *  The client gets a SUBACK and the message as a retained QoS 0 PUBLISH, see RetainedCache.
+ *  Topic filters with wildcards go to the broker.
+ *  @return true if it was answered.
+ */
+bool MQTTSNSubscribeHandler::serveRetained(Client* client, const char* topicName, MQTTSN_topicid* topicFilter, uint16_t topicId, int qos, uint16_t msgId)
+{
+    RetainedCache* cache = _gateway->getRetainedCache();
+    if ( !cache->isActive() || topicName == nullptr )
+    {
+        return false;
+    }
+
+    uint16_t len = (uint16_t)strlen(topicName);
+    if ( memchr(topicName, '#', len) || memchr(topicName, '+', len) )
+    {
+        return false;
+    }
+
+    MQTTSN_topicid pubTopic = *topicFilter;
+    if ( pubTopic.type != MQTTSN_TOPIC_TYPE_SHORT )
+    {
+        pubTopic.data.id = topicId;
+    }
+    MQTTSNPacket* publish = cache->serve(client, topicName, len, &pubTopic);
+    if ( publish == nullptr )
+    {
+        return false;
+    }
+
+    MQTTSNPacket* suback = new MQTTSNPacket();
+    suback->setSUBACK(qos, topicId, msgId, MQTTSN_RC_ACCEPTED);
+    Event* ev = new Event();
+    ev->setClientSendEvent(client, suback);
+    _gateway->getClientSendQue()->post(ev);
+
+    ev = new Event();
+    ev->setClientSendEvent(client, publish);
+    _gateway->getClientSendQue()->post(ev);
+    return true;
+}
+
 MQTTGWPacket* MQTTSNSubscribeHandler::handleUnsubscribe(Client* client, MQTTSNPacket* packet)
 {
 	uint16_t msgId;
@@ -158,6 +220,10 @@ MQTTGWPacket* MQTTSNSubscribeHandler::handleUnsubscribe(Client* client, MQTTSNPa
         shortTopic[2] = 0;
         unsubscribe = new MQTTGWPacket();
         unsubscribe->setUNSUBSCRIBE(shortTopic, msgId);
+        if ( !client->isAggregated() )
+        {
+            _gateway->getLocalRouter()->unsubscribe(client, shortTopic);
+        }
 	}
 	else
 	{
@@ -174,6 +240,10 @@ MQTTGWPacket* MQTTSNSubscribeHandler::handleUnsubscribe(Client* client, MQTTSNPa
         {
             unsubscribe = new MQTTGWPacket();
             unsubscribe->setUNSUBSCRIBE(topic->getTopicName()->c_str(), msgId);
+            if ( !client->isAggregated() )
+            {
+                _gateway->getLocalRouter()->unsubscribe(client, topic->getTopicName()->c_str());
+            }
         }
 	}
 
@@ -196,31 +266,28 @@ void MQTTSNSubscribeHandler::handleAggregateSubscribe(Client* client, MQTTSNPack
 
 	if ( subscribe != nullptr )
 	{
+		uint8_t dup;
+		int qos;
+		uint16_t msgId;
+		MQTTSN_topicid topicFilter;
+		packet->getSUBSCRIBE(&dup, &qos, &msgId, &topicFilter);
+
 		UTF8String str = subscribe->getTopic();
 		string* topicName = new string(str.data, str.len);
 		Topic topic = Topic(topicName, MQTTSN_TOPIC_TYPE_NORMAL);
-		 _gateway->getAdapterManager()->addAggregateTopic(&topic, client);
+		delete subscribe;
 
-		int msgId = 0;
-		if ( packet->isDuplicate() )
-		{
-			msgId = _gateway->getAdapterManager()->getAggregater()->getMsgId(client, packet->getMsgId());
-		}
-		else
+		/* The broker's SUBACK is returned when the filter was subscribed, otherwise the gateway answers */
+		if ( _gateway->getAdapterManager()->addAggregateTopic(&topic, client, (uint8_t)qos, msgId) == 0 )
 		{
-			msgId = _gateway->getAdapterManager()->getAggregater()->addMessageIdTable(client, packet->getMsgId());
+			TopicIdMapElement* topicId = client->getWaitedSubTopicId(msgId);
+			MQTTSNPacket* sSuback = new MQTTSNPacket();
+			sSuback->setSUBACK(qos, topicId ? topicId->getTopicId() : 0, msgId, MQTTSN_RC_ACCEPTED);
+			client->eraseWaitedSubTopicId(msgId);
+			Event* evsuback = new Event();
+			evsuback->setClientSendEvent(client, sSuback);
+			_gateway->getClientSendQue()->post(evsuback);
 		}
-
-		if ( msgId == 0 )
-		{
-			WRITELOG("%s MQTTSNSubscribeHandler can't create MessageIdTableElement  %s%s\n", ERRMSG_HEADER, client->getClientId(), ERRMSG_FOOTER);
-			return;
-		}
-WRITELOG("msgId=%d\n",msgId);
-		subscribe->setMsgId(msgId);
-		Event* ev = new Event();
-		ev->setBrokerSendEvent(client, subscribe);
-		_gateway->getBrokerSendQue()->post(ev);
 	}
 }
 
@@ -232,26 +299,15 @@ void MQTTSNSubscribeHandler::handleAggregateUnsubscribe(Client* client, MQTTSNPa
 		UTF8String str = unsubscribe->getTopic();
 		string* topicName = new string(str.data, str.len);
 		Topic topic = Topic(topicName, MQTTSN_TOPIC_TYPE_NORMAL);
-		_gateway->getAdapterManager()->removeAggregateTopic(&topic, client);
+		delete unsubscribe;
 
-		int msgId = 0;
-		if ( packet->isDuplicate() )
-		{
-			msgId = _gateway->getAdapterManager()->getAggregater()->getMsgId(client, packet->getMsgId());
-		}
-		else
-		{
-			msgId = _gateway->getAdapterManager()->getAggregater()->addMessageIdTable(client, packet->getMsgId());
-		}
+		/* the broker is unsubscribed with the filter's last client, the client gets its UNSUBACK now */
+		_gateway->getAdapterManager()->removeAggregateTopic(&topic, client);
 
-		if ( msgId == 0 )
-		{
-			WRITELOG("%s MQTTSNUnsubscribeHandler can't create MessageIdTableElement  %s%s\n", ERRMSG_HEADER, client->getClientId(), ERRMSG_FOOTER);
-			return;
-		}
-		unsubscribe->setMsgId(msgId);
-		Event* ev = new Event();
-		ev->setBrokerSendEvent(client, unsubscribe);
-		_gateway->getBrokerSendQue()->post(ev);
+		MQTTSNPacket* sUnsuback = new MQTTSNPacket();
+		sUnsuback->setUNSUBACK(packet->getMsgId());
+		Event* evunsuback = new Event();
+		evunsuback->setClientSendEvent(client, sUnsuback);
+		_gateway->getClientSendQue()->post(evunsuback);
 	}
 }
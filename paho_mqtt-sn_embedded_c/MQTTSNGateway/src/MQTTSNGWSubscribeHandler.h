@@ -37,6 +37,8 @@ public:
 	void handleAggregateUnsubscribe(Client* client, MQTTSNPacket* packet);
 
 private:
+	bool serveRetained(Client* client, const char* topicName, MQTTSN_topicid* topicFilter, uint16_t topicId, int qos, uint16_t msgId);
+
 	Gateway* _gateway;
 };
 
@@ -21,6 +21,139 @@
 
 using namespace MQTTSNGW;
 
+/*=====================================
+ Class TopicNameTable
+ ======================================*/
+TopicNameTable::TopicNameTable()
+{
+    _namesSize = TOPICNAME_INITIAL_TABLE_SIZE;
+    _names = new TopicName*[_namesSize]();
+    _used = 1;
+    _free = nullptr;
+}
+
+TopicNameTable::~TopicNameTable()
+{
+    for ( uint32_t i = 1; i < _used; i++ )
+    {
+        delete _names[i];
+    }
+    delete[] _names;
+}
+
+/* The table of the gateway, shared by all Topics. Never deleted, Topics may outlive any owner. */
+TopicNameTable* TopicNameTable::getTable(void)
+{
+    static TopicNameTable* table = new TopicNameTable();
+    return table;
+}
+
+uint32_t TopicNameTable::hashOf(TopicName* tn)
+{
+    return tn->hash;
+}
+
+/* Called with _mutex locked */
+TopicNameTable::TopicName* TopicNameTable::lookup(const char* name, uint32_t len, uint32_t h)
+{
+    for ( TopicName* tn = _table.first(h); tn; tn = tn->next )
+    {
+        if ( tn->hash == h && tn->name.size() == len && tn->name.compare(0, len, name, len) == 0 )
+        {
+            return tn;
+        }
+    }
+    return nullptr;
+}
+
+/* Returns the handle of the name with a reference added, the name is added if it is new. */
+uint32_t TopicNameTable::intern(const char* name, uint32_t len)
+{
+    uint32_t h = hashBytes(name, len);
+
+    _mutex.lock();
+    TopicName* tn = lookup(name, len, h);
+    if ( tn )
+    {
+        tn->refCnt++;
+        _mutex.unlock();
+        return tn->handle;
+    }
+
+    if ( _free )
+    {
+        tn = _free;
+        _free = tn->next;
+    }
+    else
+    {
+        if ( _used == _namesSize )
+        {
+            TopicName** names = new TopicName*[_namesSize * 2]();
+            memcpy(names, _names, sizeof(TopicName*) * _namesSize);
+            delete[] _names;
+            _names = names;
+            _namesSize *= 2;
+        }
+        tn = new TopicName;
+        tn->handle = _used++;
+        _names[tn->handle] = tn;
+    }
+    tn->name.assign(name, len);
+    tn->hash = h;
+    tn->refCnt = 1;
+    _table.add(tn);
+    _mutex.unlock();
+    return tn->handle;
+}
+
+/* Returns the handle of the name without a reference, 0 if no client has it. */
+uint32_t TopicNameTable::find(const char* name, uint32_t len)
+{
+    uint32_t h = hashBytes(name, len);
+
+    _mutex.lock();
+    TopicName* tn = lookup(name, len, h);
+    _mutex.unlock();
+    return tn ? tn->handle : 0;
+}
+
+void TopicNameTable::addRef(uint32_t handle)
+{
+    _mutex.lock();
+    _names[handle]->refCnt++;
+    _mutex.unlock();
+}
+
+/* The last release frees the name and its handle. */
+void TopicNameTable::release(uint32_t handle)
+{
+    _mutex.lock();
+    TopicName* tn = _names[handle];
+    if ( --tn->refCnt == 0 )
+    {
+        _table.remove(tn);
+        string().swap(tn->name);
+        tn->next = _free;
+        _free = tn;
+    }
+    _mutex.unlock();
+}
+
+/* The string stays where it is until the last reference is released. */
+string* TopicNameTable::getName(uint32_t handle)
+{
+    _mutex.lock();
+    string* name = &_names[handle]->name;
+    _mutex.unlock();
+    return name;
+}
+
+uint32_t TopicNameTable::getCount(void)
+{
+    return _table.getCount();
+}
+
 /*=====================================
  Class Topic
  ======================================*/
@@ -28,21 +161,42 @@ Topic::Topic()
 {
     _type = MQTTSN_TOPIC_TYPE_NORMAL;
 	_topicName = nullptr;
+	_handle = 0;
 	_topicId = 0;
-	_next = nullptr;
 }
 
+/* A Topic that is not in Topics, it owns the name */
 Topic::Topic(string* topic, MQTTSN_topicTypes type)
 {
     _type = type;
 	_topicName = topic;
+	_handle = 0;
 	_topicId = 0;
-	_next = nullptr;
+}
+
+Topic::Topic(const Topic& topic)
+{
+    _type = topic._type;
+    _topicId = topic._topicId;
+    _handle = topic._handle;
+    if ( _handle )
+    {
+        TopicNameTable::getTable()->addRef(_handle);
+        _topicName = topic._topicName;
+    }
+    else
+    {
+        _topicName = topic._topicName ? new string(*topic._topicName) : nullptr;
+    }
 }
 
 Topic::~Topic()
 {
-	if ( _topicName )
+	if ( _handle )
+	{
+		TopicNameTable::getTable()->release(_handle);
+	}
+	else if ( _topicName )
 	{
 		delete _topicName;
 	}
@@ -60,7 +214,7 @@ uint16_t Topic::getTopicId(void)
 
 MQTTSN_topicTypes Topic::getType(void)
 {
-    return _type;
+    return (MQTTSN_topicTypes)_type;
 }
 
 bool Topic::isMatch(string* topicName)
@@ -165,50 +319,50 @@ void Topic::print(void)
  ======================================*/
 Topics::Topics()
 {
-    _first = nullptr;
+    _topics = nullptr;
     _nextTopicId = 0;
+    _end = 0;
     _cnt = 0;
 }
 
 Topics::~Topics()
 {
-    Topic* p = _first;
-    while (p)
-    {
-        Topic* q = p->_next;
-        delete p;
-        p = q;
-    }
+    delete[] _topics;
 }
 
 Topic* Topics::getTopicByName(const MQTTSN_topicid* topicid)
 {
-    Topic* p = _first;
-    char* ch = topicid->data.long_.name;
+    if ( _cnt == 0 )
+    {
+        return 0;
+    }
+
+    /* a name that is not interned is not a topic of any client */
+    uint32_t handle = TopicNameTable::getTable()->find(topicid->data.long_.name, topicid->data.long_.len);
+    if ( handle == 0 )
+    {
+        return 0;
+    }
 
-    string sname = string(ch, ch + topicid->data.long_.len);
-    while (p)
+    for ( int i = 0; i < _end; i++ )
     {
-         if (  p->_topicName->compare(sname) == 0 )
-         {
-             return p;
-         }
-         p = p->_next;
+        if ( _topics[i]._handle == handle )
+        {
+            return &_topics[i];
+        }
     }
     return 0;
 }
 
 Topic* Topics::getTopicById(const MQTTSN_topicid* topicid)
 {
-    Topic* p = _first;
-
-    while (p)
+    for ( int i = 0; i < _end; i++ )
     {
-        if ( p->_type == topicid->type && p->_topicId == topicid->data.id )
+        Topic* p = &_topics[i];
+        if ( p->_handle && p->_type == topicid->type && p->_topicId == topicid->data.id )
         {
             return p;
         }
-        p = p->_next;
     }
     return 0;
 }
@@ -251,15 +405,26 @@ Topic* Topics::add(const char* topicName, uint16_t id)
         return topic;
     }
 
-    topic = new Topic();
+    if ( _topics == nullptr )
+    {
+        _topics = new Topic[MAX_TOPIC_PAR_CLIENT];
+    }
 
-    if (topic == nullptr)
+    /* the first free slot */
+    int i = 0;
+    while ( i < _end && _topics[i]._handle )
+    {
+        i++;
+    }
+    if ( i == _end )
     {
-        return nullptr;
+        _end++;
     }
+    topic = &_topics[i];
 
-    string* name = new string(topicName);
-    topic->_topicName = name;
+    TopicNameTable* names = TopicNameTable::getTable();
+    topic->_handle = names->intern(topicName, topicId.data.long_.len);
+    topic->_topicName = names->getName(topic->_handle);
 
     if ( id == 0 )
     {
@@ -273,27 +438,6 @@ Topic* Topics::add(const char* topicName, uint16_t id)
     }
 
     _cnt++;
-
-    if ( _first == nullptr)
-    {
-        _first = topic;
-    }
-    else
-    {
-        Topic* tp = _first;
-        while (tp)
-        {
-            if (tp->_next == nullptr)
-            {
-                tp->_next = topic;
-                break;
-            }
-            else
-            {
-                tp = tp->_next;
-            }
-        }
-    }
     return topic;
 }
 
@@ -310,14 +454,13 @@ Topic* Topics::match(const MQTTSN_topicid* topicid)
     }
     string topicName(topicid->data.long_.name, topicid->data.long_.len);
 
-    Topic* topic = _first;
-    while (topic)
+    for ( int i = 0; i < _end; i++ )
     {
-        if (topic->isMatch(&topicName))
+        Topic* topic = &_topics[i];
+        if ( topic->_handle && topic->isMatch(&topicName) )
         {
             return topic;
         }
-        topic = topic->_next;
     }
     return 0;
 }
@@ -325,48 +468,38 @@ Topic* Topics::match(const MQTTSN_topicid* topicid)
 
 void Topics::eraseNormal(void)
 {
-    Topic* topic = _first;
-    Topic* next = nullptr;
-    Topic* prev = nullptr;
-
-    while (topic)
+    for ( int i = 0; i < _end; i++ )
     {
-        if ( topic->_type == MQTTSN_TOPIC_TYPE_NORMAL )
+        Topic* topic = &_topics[i];
+        if ( topic->_handle && topic->_type == MQTTSN_TOPIC_TYPE_NORMAL )
         {
-            next = topic->_next;
-            if ( _first == topic )
-            {
-                _first = next;
-            }
-            if ( prev  )
-            {
-                prev->_next = next;
-            }
-            delete topic;
+            TopicNameTable::getTable()->release(topic->_handle);
+            topic->_handle = 0;
+            topic->_topicName = nullptr;
+            topic->_topicId = 0;
             _cnt--;
-            topic = next;
-        }
-        else
-        {
-            prev = topic;
-            topic = topic->_next;
         }
     }
+    while ( _end > 0 && _topics[_end - 1]._handle == 0 )
+    {
+        _end--;
+    }
 }
 
 void Topics::print(void)
 {
-    Topic* topic = _first;
-    if (topic == nullptr )
+    if ( _cnt == 0 )
     {
         WRITELOG("No Topic.\n");
     }
     else
     {
-        while (topic)
+        for ( int i = 0; i < _end; i++ )
         {
-            topic->print();
-            topic = topic->_next;
+            if ( _topics[i]._handle )
+            {
+                _topics[i].print();
+            }
         }
     }
 }
@@ -384,6 +517,7 @@ TopicIdMapElement::TopicIdMapElement(uint16_t msgId, uint16_t topicId, MQTTSN_to
     _msgId = msgId;
     _topicId = topicId;
     _type = type;
+    _acked = false;
     _next = nullptr;
     _prev = nullptr;
 }
@@ -403,6 +537,11 @@ uint16_t TopicIdMapElement::getTopicId(void)
     return  _topicId;
 }
 
+bool TopicIdMapElement::isAcked(void)
+{
+    return _acked;
+}
+
 TopicIdMap::TopicIdMap()
 {
     _maxInflight = MAX_INFLIGHTMESSAGES;
@@ -437,7 +576,7 @@ TopicIdMapElement* TopicIdMap::getElement(uint16_t msgId)
     return 0;
 }
 
-TopicIdMapElement* TopicIdMap::add(uint16_t msgId, uint16_t topicId, MQTTSN_topicTypes type)
+TopicIdMapElement* TopicIdMap::add(uint16_t msgId, uint16_t topicId, MQTTSN_topicTypes type, bool acked)
 {
     if ( _cnt > _maxInflight * 2 || ( topicId == 0 && type != MQTTSN_TOPIC_TYPE_SHORT ) )
     {
@@ -453,6 +592,7 @@ TopicIdMapElement* TopicIdMap::add(uint16_t msgId, uint16_t topicId, MQTTSN_topi
     {
         return 0;
     }
+    elm->_acked = acked;
     if ( _first == nullptr )
     {
         _first = elm;
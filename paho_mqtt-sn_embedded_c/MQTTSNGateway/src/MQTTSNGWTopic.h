@@ -20,11 +20,57 @@
 
 #include "MQTTSNGWPacket.h"
 #include "MQTTSNPacket.h"
+#include "Threading.h"
+#include "MQTTSNGWProcess.h"
 
 namespace MQTTSNGW
 {
 
 
+#define TOPICNAME_INITIAL_TABLE_SIZE  64   // Buckets and handles of the TopicNameTable, doubled when they fill up
+
+/*=====================================
+ Class TopicNameTable
+
+ Gateway-wide table of the topic names of all clients.
+ Each name is kept once, immutable and reference counted, and is known by a handle.
+ Handles are indexes of the names, 0 is no name.
+ ======================================*/
+class TopicNameTable
+{
+public:
+    TopicNameTable();
+    ~TopicNameTable();
+    static TopicNameTable* getTable(void);
+
+    uint32_t intern(const char* name, uint32_t len);
+    uint32_t find(const char* name, uint32_t len);
+    void addRef(uint32_t handle);
+    void release(uint32_t handle);
+    string* getName(uint32_t handle);
+    uint32_t getCount(void);
+
+private:
+    struct TopicName
+    {
+        string name;
+        uint32_t hash;
+        uint32_t refCnt;
+        uint32_t handle;
+        TopicName* next;    // next name in the bucket, or in the free list
+    };
+
+    static uint32_t hashOf(TopicName* tn);
+    TopicName* lookup(const char* name, uint32_t len, uint32_t h);
+
+    TopicName** _names;     // by handle
+    uint32_t _namesSize;
+    uint32_t _used;         // handles given out so far, including freed ones
+    TopicName* _free;       // freed names
+    HashTable<TopicName, &TopicName::next, &TopicNameTable::hashOf> _table {TOPICNAME_INITIAL_TABLE_SIZE};
+    Mutex _mutex;
+};
+
 /*=====================================
  Class Topic
  ======================================*/
@@ -34,21 +80,26 @@ class Topic
 public:
     Topic();
     Topic(string* topic, MQTTSN_topicTypes type);
+    Topic(const Topic& topic);
     ~Topic();
+    Topic& operator =(const Topic&) = delete;
     string* getTopicName(void);
     uint16_t getTopicId(void);
     MQTTSN_topicTypes getType(void);
     bool isMatch(string* topicName);
     void print(void);
 private:
-    MQTTSN_topicTypes _type;
+    string*  _topicName;   // the interned name, or owned when _handle is 0
+    uint32_t _handle;
     uint16_t _topicId;
-    string*  _topicName;
-    Topic* _next;
+    uint8_t _type;
 };
 
 /*=====================================
  Class Topics
+
+ Topics of a client in a flat array of MAX_TOPIC_PAR_CLIENT, allocated by the first add.
+ Erased slots are reused, so a Topic does not move while it is registered.
  ======================================*/
 class Topics
 {
@@ -66,7 +117,8 @@ public:
     uint8_t getCount(void);
 private:
     uint16_t _nextTopicId;
-    Topic* _first;
+    Topic* _topics;
+    uint8_t  _end;        // slots in use are below it
     uint8_t  _cnt;
 };
 
@@ -81,11 +133,13 @@ public:
     ~TopicIdMapElement();
     MQTTSN_topicTypes getTopicType(void);
     uint16_t getTopicId(void);
+    bool isAcked(void);
 
 private:
     uint16_t _msgId;
     uint16_t _topicId;
     MQTTSN_topicTypes _type;
+    bool _acked;    // the client got its SUBACK from the gateway, see MQTTSNSubscribeHandler::serveRetained()
     TopicIdMapElement* _next;
     TopicIdMapElement* _prev;
 };
@@ -96,7 +150,7 @@ public:
     TopicIdMap();
     ~TopicIdMap();
     TopicIdMapElement* getElement(uint16_t msgId);
-    TopicIdMapElement* add(uint16_t msgId, uint16_t topicId, MQTTSN_topicTypes type);
+    TopicIdMapElement* add(uint16_t msgId, uint16_t topicId, MQTTSN_topicTypes type, bool acked = false);
     void erase(uint16_t msgId);
     void clear(void);
 private:
@@ -20,6 +20,7 @@
 #include "MQTTSNGWVersion.h"
 #include "MQTTSNGWQoSm1Proxy.h"
 #include "MQTTSNGWClient.h"
+#include "MQTTSNGWPacketBurst.h"
 #include <string.h>
 using namespace MQTTSNGW;
 
@@ -185,12 +186,64 @@ void Gateway::initialize(int argc, char** argv)
 		_params.mqttVersion = atoi(param);
 	}
 
-	_params.maxInflightMsgs = DEFAULT_MQTT_VERSION;
+	_params.maxInflightMsgs = MAX_INFLIGHTMESSAGES;
 	if (getParam("MaxInflightMsgs", param) == 0)
 	{
 		_params.maxInflightMsgs = atoi(param);
 	}
 
+	_params.maxBrokerBacklog = DEFAULT_MAX_BROKER_BACKLOG;
+	if (getParam("MaxBrokerBacklog", param) == 0)
+	{
+		_params.maxBrokerBacklog = atoi(param);
+	}
+
+	if (getParam("RetainedCache", param) == 0)
+	{
+		_params.retainedCacheSize = atoi(param);
+	}
+	_params.retainedCacheExpiry = DEFAULT_RETAINED_CACHE_EXPIRY;
+	if (getParam("RetainedCacheExpiry", param) == 0)
+	{
+		_params.retainedCacheExpiry = atoi(param);
+	}
+	_retainedCache.initialize(_params.retainedCacheSize, _params.retainedCacheExpiry);
+
+	if (getParam("LocalRouting", param) == 0)
+	{
+		if (!strcasecmp(param, "YES"))
+		{
+			_params.localRouting = true;
+		}
+	}
+	_localRouter.initialize(_params.localRouting);
+
+	_params.duplicateWindow = DEFAULT_DUPLICATE_WINDOW;
+	if (getParam("DuplicateWindow", param) == 0)
+	{
+		_params.duplicateWindow = atoi(param);
+	}
+	_duplicateFilter.initialize(_params.duplicateWindow);
+
+	if (getParam("BrokerPool", param) == 0)
+	{
+		_params.brokerPoolSize = atoi(param);
+	}
+	_params.brokerPoolIdle = DEFAULT_BROKER_POOL_IDLE;
+	if (getParam("BrokerPoolIdle", param) == 0)
+	{
+		_params.brokerPoolIdle = atoi(param);
+	}
+	_brokerPool.initialize(_params.brokerPoolSize, _params.brokerPoolIdle);
+
+	if (getParam("IOUring", param) == 0)
+	{
+		if (!strcasecmp(param, "YES"))
+		{
+			_params.ioUring = true;
+		}
+	}
+
 	_params.keepAlive = DEFAULT_KEEP_ALIVE_TIME;
 	if (getParam("KeepAlive", param) == 0)
 	{
@@ -223,6 +276,12 @@ void Gateway::initialize(int argc, char** argv)
 
 	/*  Setup predefined topics  */
 	_clientList->setPredefinedTopics(aggregate);
+
+	/*  Broker connections for the clients in the list are opened in advance  */
+	for (Client* client = _clientList->getClient(0); client && _brokerPool.isActive(); client = client->getNextClient())
+	{
+		_brokerPool.prepare(client->isSecureNetwork());
+	}
 }
 
 void Gateway::run(void)
@@ -323,6 +382,26 @@ Topics* Gateway::getTopics(void)
     return _topics;
 }
 
+RetainedCache* Gateway::getRetainedCache(void)
+{
+    return &_retainedCache;
+}
+
+LocalRouter* Gateway::getLocalRouter(void)
+{
+    return &_localRouter;
+}
+
+DuplicateFilter* Gateway::getDuplicateFilter(void)
+{
+    return &_duplicateFilter;
+}
+
+BrokerPool* Gateway::getBrokerPool(void)
+{
+    return &_brokerPool;
+}
+
 bool Gateway::hasSecureConnection(void)
 {
 	return (  _params.certKey
@@ -395,21 +474,34 @@ Event* EventQue::timedwait(uint16_t millsec)
 	return ev;
 }
 
-void EventQue::post(Event* ev)
+/*
+ *  @return false if the que is full and ev was deleted.
+ */
+bool EventQue::post(Event* ev)
 {
+	bool posted = false;
 	if ( ev )
 	{
 		_mutex.lock();
 		if ( _que.post(ev) )
 		{
 			_sem.post();
+			posted = true;
 		}
-		else
+		else if ( _que.getDropCnt() % 100 == 1 )
 		{
-			delete ev;
+			/* the que is full, report the first drop and every hundredth after it */
+			WRITELOG("%s EventQue is full, %u events dropped. %s\n", ERRMSG_HEADER, _que.getDropCnt(), ERRMSG_FOOTER);
 		}
 		_mutex.unlock();
+
+		if ( !posted )
+		{
+			/* deleted unlocked, ~Event() takes the flow lock of its network */
+			delete ev;
+		}
 	}
+	return posted;
 }
 
 int EventQue::size()
@@ -420,6 +512,22 @@ int EventQue::size()
 	return sz;
 }
 
+uint32_t EventQue::getDropCnt(void)
+{
+	_mutex.lock();
+	uint32_t cnt = _que.getDropCnt();
+	_mutex.unlock();
+	return cnt;
+}
+
+int EventQue::getHighWater(void)
+{
+	_mutex.lock();
+	int cnt = _que.getHighWater();
+	_mutex.unlock();
+	return cnt;
+}
+
 
 /*=====================================
  Class Event
@@ -431,6 +539,16 @@ Event::Event()
 
 Event::~Event()
 {
+	if (_backlog)
+	{
+		_client->getNetwork()->addBacklog(-_backlog);
+	}
+
+	if (_client)
+	{
+		_client->release();
+	}
+
 	if (_sensorNetAddr)
 	{
 		delete _sensorNetAddr;
@@ -441,6 +559,11 @@ Event::~Event()
 		delete _mqttSNPacket;
 	}
 
+	if (_mqttSNPacketBurst)
+	{
+		delete _mqttSNPacketBurst;
+	}
+
 	if (_mqttGWPacket)
 	{
 		delete _mqttGWPacket;
@@ -452,30 +575,60 @@ EventType Event::getEventType()
 	return _eventType;
 }
 
-void Event::setClientSendEvent(Client* client, MQTTSNPacket* packet)
+/* the client is held until the event is deleted, see ClientList::erase() */
+void Event::setClient(Client* client)
 {
 	_client = client;
+	if (client)
+	{
+		client->hold();
+	}
+}
+
+void Event::setClientSendEvent(Client* client, MQTTSNPacket* packet)
+{
+	setClient(client);
 	_eventType = EtClientSend;
 	_mqttSNPacket = packet;
 }
 
+void Event::setClientSendEvent(Client* client, MQTTSNPacketBurst* burst)
+{
+	setClient(client);
+	_eventType = EtClientSendBurst;
+	_mqttSNPacketBurst = burst;
+}
+
 void Event::setBrokerSendEvent(Client* client, MQTTGWPacket* packet)
 {
-	_client = client;
+	setClient(client);
 	_eventType = EtBrokerSend;
 	_mqttGWPacket = packet;
+
+	/* counted until the event is deleted, after BrokerSendTask has handed the packet to the Network */
+	if (client && packet)
+	{
+		_backlog = packet->getPacketLength();
+		client->getNetwork()->addBacklog(_backlog);
+	}
+}
+
+void Event::setBrokerFlushEvent(Client* client)
+{
+	setClient(client);
+	_eventType = EtBrokerFlush;
 }
 
 void Event::setClientRecvEvent(Client* client, MQTTSNPacket* packet)
 {
-	_client = client;
+	setClient(client);
 	_eventType = EtClientRecv;
 	_mqttSNPacket = packet;
 }
 
 void Event::setBrokerRecvEvent(Client* client, MQTTGWPacket* packet)
 {
-	_client = client;
+	setClient(client);
 	_eventType = EtBrokerRecv;
 	_mqttGWPacket = packet;
 }
@@ -518,6 +671,11 @@ MQTTSNPacket* Event::getMQTTSNPacket()
 	return _mqttSNPacket;
 }
 
+MQTTSNPacketBurst* Event::getMQTTSNPacketBurst(void)
+{
+	return _mqttSNPacketBurst;
+}
+
 MQTTGWPacket* Event::getMQTTGWPacket(void)
 {
 	return _mqttGWPacket;
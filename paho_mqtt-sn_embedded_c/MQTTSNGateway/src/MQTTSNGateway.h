@@ -20,6 +20,10 @@
 #include "MQTTSNGWProcess.h"
 #include "MQTTSNPacket.h"
 #include "MQTTSNGWClient.h"
+#include "MQTTSNGWRetainedCache.h"
+#include "MQTTSNGWLocalRouter.h"
+#include "MQTTSNGWDuplicateFilter.h"
+#include "MQTTSNGWBrokerPool.h"
 
 namespace MQTTSNGW
 {
@@ -75,6 +79,7 @@ namespace MQTTSNGW
          Class Event
   ====================================*/
 class Client;
+class MQTTSNPacketBurst;
 
 enum EventType{
 	Et_NA = 0,
@@ -82,8 +87,10 @@ enum EventType{
 	EtTimeout,
 	EtBrokerRecv,
 	EtBrokerSend,
+	EtBrokerFlush,
 	EtClientRecv,
 	EtClientSend,
+	EtClientSendBurst,
 	EtBroadcast,
 	EtSensornetSend
 };
@@ -96,8 +103,10 @@ public:
 	EventType getEventType(void);
 	void setClientRecvEvent(Client*, MQTTSNPacket*);
 	void setClientSendEvent(Client*, MQTTSNPacket*);
+	void setClientSendEvent(Client*, MQTTSNPacketBurst*);
 	void setBrokerRecvEvent(Client*, MQTTGWPacket*);
 	void setBrokerSendEvent(Client*, MQTTGWPacket*);
+	void setBrokerFlushEvent(Client*);     // write the packets queued on the client's Network
 	void setBrodcastEvent(MQTTSNPacket*);  // ADVERTISE and GWINFO
 	void setTimeout(void);                 // Required by EventQue<Event>.timedwait()
 	void setStop(void);
@@ -105,14 +114,18 @@ public:
 	Client* getClient(void);
 	SensorNetAddress* getSensorNetAddress(void);
 	MQTTSNPacket* getMQTTSNPacket(void);
+	MQTTSNPacketBurst* getMQTTSNPacketBurst(void);
 	MQTTGWPacket* getMQTTGWPacket(void);
 
 private:
+	void setClient(Client*);
 	EventType   _eventType {Et_NA};
 	Client*     _client {nullptr};
 	SensorNetAddress* _sensorNetAddr {nullptr};
 	MQTTSNPacket* _mqttSNPacket {nullptr};
+	MQTTSNPacketBurst* _mqttSNPacketBurst {nullptr};
 	MQTTGWPacket* _mqttGWPacket {nullptr};
+	int _backlog {0};      // bytes added to the backlog of the client's Network
 };
 
 
@@ -127,8 +140,10 @@ public:
 	Event* wait(void);
 	Event* timedwait(uint16_t millsec);
 	void setMaxSize(uint16_t maxSize);
-	void post(Event*);
+	bool post(Event*);
 	int  size();
+	uint32_t getDropCnt(void);
+	int  getHighWater(void);
 
 private:
 	Que<Event> _que;
@@ -153,6 +168,14 @@ public:
 	uint8_t  gatewayId {0};
 	uint8_t  mqttVersion {0};
 	uint16_t maxInflightMsgs {0};
+	uint32_t maxBrokerBacklog {0};
+	uint32_t retainedCacheSize {0};
+	uint32_t retainedCacheExpiry {0};
+	bool  localRouting {false};
+	uint32_t duplicateWindow {0};
+	uint32_t brokerPoolSize {0};
+	uint32_t brokerPoolIdle {0};
+	bool  ioUring {false};
 	char* gatewayName {nullptr};
 	char* brokerName {nullptr};
 	char* port {nullptr};
@@ -192,6 +215,10 @@ public:
 	int getParam(const char* parameter, char* value);
 	bool hasSecureConnection(void);
 	Topics* getTopics(void);
+	RetainedCache* getRetainedCache(void);
+	LocalRouter* getLocalRouter(void);
+	DuplicateFilter* getDuplicateFilter(void);
+	BrokerPool* getBrokerPool(void);
 
 private:
 	GatewayParams  _params;
@@ -203,6 +230,10 @@ private:
 	SensorNetwork  _sensorNetwork;
 	AdapterManager* _adapterManager {nullptr};
 	Topics* _topics;
+	RetainedCache _retainedCache;
+	LocalRouter _localRouter;
+	DuplicateFilter _duplicateFilter;
+	BrokerPool _brokerPool;
 };
 
 }
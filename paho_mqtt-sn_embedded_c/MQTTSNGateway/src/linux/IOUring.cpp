@@ -0,0 +1,584 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - io_uring network I/O
+ **************************************************************************************/
+
+#include "IOUring.h"
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <netinet/in.h>
+
+#if defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#endif
+#endif
+
+#if defined(IORING_RECV_MULTISHOT) && defined(__NR_io_uring_setup)
+#define IOURING_SUPPORTED
+#endif
+
+using namespace MQTTSNGW;
+
+#define IOURING_BUFFER_GROUP   0
+#define IOURING_RECVMSG        (1ULL << 63)   // set in the userData of a recvmsgMultishot()
+#define IOURING_INTERNAL       (~0ULL)        // userData of a cancel, its completion is not returned
+
+/*=====================================
+ Class IOUring
+ =====================================*/
+IOUring::IOUring()
+{
+	_fd = -1;
+	_sqRing = MAP_FAILED;
+	_sqRingSize = 0;
+	_cqRing = MAP_FAILED;
+	_cqRingSize = 0;
+	_sqes = MAP_FAILED;
+	_sqesSize = 0;
+	_sqHead = nullptr;
+	_sqTail = nullptr;
+	_sqMask = 0;
+	_sqEntries = 0;
+	_sqArray = nullptr;
+	_sqPending = 0;
+	_cqHead = nullptr;
+	_cqTail = nullptr;
+	_cqMask = 0;
+	_cqes = nullptr;
+	_bufRing = MAP_FAILED;
+	_bufRingSize = 0;
+	_buffers = nullptr;
+	memset(&_msghdr, 0, sizeof(_msghdr));
+	_enterCnt = 0;
+}
+
+IOUring::~IOUring()
+{
+	close();
+}
+
+#ifdef IOURING_SUPPORTED
+/**
+ *  Set up the ring and register the receive buffers.
+ *  @return false when the kernel does not provide what is needed, nothing is left open.
+ */
+bool IOUring::open(void)
+{
+	io_uring_params params;
+
+	if (isOpen())
+	{
+		return true;
+	}
+	memset(&params, 0, sizeof(params));
+	_fd = syscall(__NR_io_uring_setup, IOURING_ENTRIES, &params);
+	if (_fd < 0)
+	{
+		_fd = -1;
+		return false;
+	}
+	if (!(params.features & IORING_FEAT_EXT_ARG))
+	{
+		close();
+		return false;
+	}
+
+	_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+	_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+	if (params.features & IORING_FEAT_SINGLE_MMAP)
+	{
+		_sqRingSize = _cqRingSize = (_sqRingSize > _cqRingSize) ? _sqRingSize : _cqRingSize;
+	}
+	_sqRing = mmap(0, _sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQ_RING);
+	if (_sqRing == MAP_FAILED)
+	{
+		close();
+		return false;
+	}
+	if (params.features & IORING_FEAT_SINGLE_MMAP)
+	{
+		_cqRing = _sqRing;
+	}
+	else
+	{
+		_cqRing = mmap(0, _cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_CQ_RING);
+	}
+	_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+	_sqes = mmap(0, _sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQES);
+	if (_cqRing == MAP_FAILED || _sqes == MAP_FAILED)
+	{
+		close();
+		return false;
+	}
+
+	uint8_t* sq = (uint8_t*)_sqRing;
+	uint8_t* cq = (uint8_t*)_cqRing;
+	_sqHead = (uint32_t*)(sq + params.sq_off.head);
+	_sqTail = (uint32_t*)(sq + params.sq_off.tail);
+	_sqMask = *(uint32_t*)(sq + params.sq_off.ring_mask);
+	_sqEntries = params.sq_entries;
+	_sqArray = (uint32_t*)(sq + params.sq_off.array);
+	_cqHead = (uint32_t*)(cq + params.cq_off.head);
+	_cqTail = (uint32_t*)(cq + params.cq_off.tail);
+	_cqMask = *(uint32_t*)(cq + params.cq_off.ring_mask);
+	_cqes = cq + params.cq_off.cqes;
+
+	/*
+	 *  The buffers the kernel picks one from for each packet received. The ring is an
+	 *  array of io_uring_buf whose first resv is the tail, io_uring_buf_ring is not used
+	 *  as its flexible array is placed after the tail in C++.
+	 */
+	_bufRingSize = IOURING_BUFFER_COUNT * sizeof(io_uring_buf);
+	_bufRing = mmap(0, _bufRingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	_buffers = (uint8_t*)malloc(IOURING_BUFFER_COUNT * IOURING_BUFFER_SIZE);
+	if (_bufRing == MAP_FAILED || _buffers == nullptr)
+	{
+		close();
+		return false;
+	}
+
+	io_uring_buf_reg reg;
+	memset(&reg, 0, sizeof(reg));
+	reg.ring_addr = (uintptr_t)_bufRing;
+	reg.ring_entries = IOURING_BUFFER_COUNT;
+	reg.bgid = IOURING_BUFFER_GROUP;
+	if (syscall(__NR_io_uring_register, _fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0)
+	{
+		munmap(_bufRing, _bufRingSize);
+		_bufRing = MAP_FAILED;
+		close();
+		return false;
+	}
+
+	io_uring_buf* bufs = (io_uring_buf*)_bufRing;
+	for (int i = 0; i < IOURING_BUFFER_COUNT; i++)
+	{
+		bufs[i].addr = (uintptr_t)(_buffers + i * IOURING_BUFFER_SIZE);
+		bufs[i].len = IOURING_BUFFER_SIZE;
+		bufs[i].bid = i;
+	}
+	__atomic_store_n(&bufs[0].resv, (uint16_t)IOURING_BUFFER_COUNT, __ATOMIC_RELEASE);
+
+	_msghdr.msg_namelen = sizeof(sockaddr_in);
+	return true;
+}
+
+/**
+ *  Closing the ring cancels the requests still armed. The buffers are unregistered
+ *  first, so that no packet is received into them once they are freed.
+ */
+void IOUring::close(void)
+{
+	if (_fd >= 0 && _bufRing != MAP_FAILED)
+	{
+		io_uring_buf_reg reg;
+		memset(&reg, 0, sizeof(reg));
+		reg.bgid = IOURING_BUFFER_GROUP;
+		syscall(__NR_io_uring_register, _fd, IORING_UNREGISTER_PBUF_RING, &reg, 1);
+	}
+	if (_fd >= 0)
+	{
+		::close(_fd);
+		_fd = -1;
+	}
+	if (_sqes != MAP_FAILED)
+	{
+		munmap(_sqes, _sqesSize);
+		_sqes = MAP_FAILED;
+	}
+	if (_cqRing != MAP_FAILED && _cqRing != _sqRing)
+	{
+		munmap(_cqRing, _cqRingSize);
+	}
+	_cqRing = MAP_FAILED;
+	if (_sqRing != MAP_FAILED)
+	{
+		munmap(_sqRing, _sqRingSize);
+		_sqRing = MAP_FAILED;
+	}
+	if (_bufRing != MAP_FAILED)
+	{
+		munmap(_bufRing, _bufRingSize);
+		_bufRing = MAP_FAILED;
+	}
+	if (_buffers)
+	{
+		free(_buffers);
+		_buffers = nullptr;
+	}
+	_sqPending = 0;
+}
+
+/*
+ *  Next free submission queue entry, cleared. nullptr when the queue is full.
+ */
+void* IOUring::getSqe(void)
+{
+	if (!isOpen())
+	{
+		return nullptr;
+	}
+	uint32_t head = __atomic_load_n(_sqHead, __ATOMIC_ACQUIRE);
+	uint32_t tail = *_sqTail + _sqPending;
+	if (tail - head >= _sqEntries)
+	{
+		return nullptr;
+	}
+	uint32_t index = tail & _sqMask;
+	io_uring_sqe* sqe = (io_uring_sqe*)_sqes + index;
+	memset(sqe, 0, sizeof(io_uring_sqe));
+	_sqArray[index] = index;
+	_sqPending++;
+	return sqe;
+}
+
+/**
+ *  Receive the bytes of a TCP connection into the registered buffers as they arrive.
+ *  @return false when the submission queue is full.
+ */
+bool IOUring::recvMultishot(int sockfd, uint64_t userData)
+{
+	io_uring_sqe* sqe = (io_uring_sqe*)getSqe();
+	if (!sqe)
+	{
+		return false;
+	}
+	sqe->opcode = IORING_OP_RECV;
+	sqe->fd = sockfd;
+	sqe->flags = IOSQE_BUFFER_SELECT;
+	sqe->buf_group = IOURING_BUFFER_GROUP;
+	sqe->ioprio = IORING_RECV_MULTISHOT;
+	sqe->user_data = userData;
+	return true;
+}
+
+/**
+ *  Receive the datagrams of a UDP socket with their sender, one completion each.
+ */
+bool IOUring::recvmsgMultishot(int sockfd, uint64_t userData)
+{
+	io_uring_sqe* sqe = (io_uring_sqe*)getSqe();
+	if (!sqe)
+	{
+		return false;
+	}
+	sqe->opcode = IORING_OP_RECVMSG;
+	sqe->fd = sockfd;
+	sqe->addr = (uintptr_t)&_msghdr;
+	sqe->len = 1;
+	sqe->flags = IOSQE_BUFFER_SELECT;
+	sqe->buf_group = IOURING_BUFFER_GROUP;
+	sqe->ioprio = IORING_RECV_MULTISHOT;
+	sqe->user_data = userData | IOURING_RECVMSG;
+	return true;
+}
+
+/**
+ *  Tell each time the socket becomes readable, for the TLS connections read by OpenSSL.
+ */
+bool IOUring::pollMultishot(int sockfd, uint64_t userData)
+{
+	io_uring_sqe* sqe = (io_uring_sqe*)getSqe();
+	if (!sqe)
+	{
+		return false;
+	}
+	sqe->opcode = IORING_OP_POLL_ADD;
+	sqe->fd = sockfd;
+	sqe->poll32_events = POLLIN;
+	sqe->len = IORING_POLL_ADD_MULTI;
+	sqe->user_data = userData;
+	return true;
+}
+
+/**
+ *  Write buf to a TCP connection. buf is read by the kernel until the completion is returned.
+ */
+bool IOUring::send(int sockfd, const uint8_t* buf, int length, uint64_t userData)
+{
+	io_uring_sqe* sqe = (io_uring_sqe*)getSqe();
+	if (!sqe)
+	{
+		return false;
+	}
+	sqe->opcode = IORING_OP_SEND;
+	sqe->fd = sockfd;
+	sqe->addr = (uintptr_t)buf;
+	sqe->len = length;
+	sqe->msg_flags = MSG_NOSIGNAL;
+	sqe->user_data = userData;
+	return true;
+}
+
+/**
+ *  Cancel an armed request, it completes with -ECANCELED.
+ */
+bool IOUring::cancel(uint64_t userData)
+{
+	io_uring_sqe* sqe = (io_uring_sqe*)getSqe();
+	if (!sqe)
+	{
+		return false;
+	}
+	sqe->opcode = IORING_OP_ASYNC_CANCEL;
+	sqe->fd = -1;
+	sqe->addr = userData;
+	sqe->user_data = IOURING_INTERNAL;
+	return true;
+}
+
+/*
+ *  Take the next completion out of the queue, without a syscall.
+ */
+bool IOUring::readCqe(IOUringEvent* ev)
+{
+	while (true)
+	{
+		uint32_t head = *_cqHead;
+		if (head == __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE))
+		{
+			return false;
+		}
+		io_uring_cqe* cqe = (io_uring_cqe*)_cqes + (head & _cqMask);
+		uint64_t userData = cqe->user_data;
+		int32_t res = cqe->res;
+		uint32_t flags = cqe->flags;
+		__atomic_store_n(_cqHead, head + 1, __ATOMIC_RELEASE);
+
+		if (userData == IOURING_INTERNAL)
+		{
+			continue;
+		}
+		ev->userData = userData & ~IOURING_RECVMSG;
+		ev->res = res;
+		ev->more = (flags & IORING_CQE_F_MORE) != 0;
+		ev->data = nullptr;
+		ev->length = 0;
+		ev->ipAddress = 0;
+		ev->portNo = 0;
+		ev->bufferId = -1;
+
+		if (flags & IORING_CQE_F_BUFFER)
+		{
+			ev->bufferId = flags >> IORING_CQE_BUFFER_SHIFT;
+			ev->data = _buffers + ev->bufferId * IOURING_BUFFER_SIZE;
+			ev->length = res;
+			if (res <= 0)
+			{
+				/* nothing was received into it */
+				release(ev);
+				ev->length = 0;
+			}
+		}
+		if ((userData & IOURING_RECVMSG) && ev->data && res > 0)
+		{
+			/* io_uring_recvmsg_out, the sender's address and the datagram */
+			io_uring_recvmsg_out* out = (io_uring_recvmsg_out*)ev->data;
+			uint8_t* name = ev->data + sizeof(io_uring_recvmsg_out);
+			uint8_t* payload = name + _msghdr.msg_namelen + _msghdr.msg_controllen;
+			if (out->namelen >= sizeof(sockaddr_in))
+			{
+				sockaddr_in* sender = (sockaddr_in*)name;
+				ev->ipAddress = sender->sin_addr.s_addr;
+				ev->portNo = sender->sin_port;
+			}
+			int length = res - (payload - ev->data);
+			ev->length = ((int)out->payloadlen < length) ? out->payloadlen : length;
+			ev->data = payload;
+		}
+		return true;
+	}
+}
+
+int IOUring::enter(uint32_t toSubmit, uint32_t minComplete, int msecs)
+{
+	__kernel_timespec ts;
+	io_uring_getevents_arg arg;
+	unsigned flags = minComplete ? IORING_ENTER_GETEVENTS : 0;
+	int rc;
+
+	_enterCnt++;
+	if (minComplete && msecs >= 0)
+	{
+		ts.tv_sec = msecs / 1000;
+		ts.tv_nsec = (msecs % 1000) * 1000000L;
+		memset(&arg, 0, sizeof(arg));
+		arg.ts = (uintptr_t)&ts;
+		rc = syscall(__NR_io_uring_enter, _fd, toSubmit, minComplete, flags | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+	}
+	else
+	{
+		rc = syscall(__NR_io_uring_enter, _fd, toSubmit, minComplete, flags, 0, 0);
+	}
+	if (rc < 0 && (errno == ETIME || errno == EINTR))
+	{
+		rc = 0;
+	}
+	return rc;
+}
+
+/**
+ *  Submit the prepared requests.
+ *  @return the number of requests submitted, -1 on error.
+ */
+int IOUring::submit(void)
+{
+	if (_sqPending == 0)
+	{
+		return 0;
+	}
+	uint32_t pending = _sqPending;
+	__atomic_store_n(_sqTail, *_sqTail + pending, __ATOMIC_RELEASE);
+	_sqPending = 0;
+	return enter(pending, 0, 0);
+}
+
+/**
+ *  Submit the prepared requests and return the next completion.
+ *  The ones already queued are returned without a syscall.
+ *  @param msecs  0 does not wait, -1 waits without a timeout.
+ *  @return 1 with a completion, 0 on timeout, -1 on error.
+ */
+int IOUring::wait(IOUringEvent* ev, int msecs)
+{
+	if (!isOpen())
+	{
+		return -1;
+	}
+	if (readCqe(ev))
+	{
+		return (submit() < 0) ? -1 : 1;
+	}
+	uint32_t pending = _sqPending;
+	__atomic_store_n(_sqTail, *_sqTail + pending, __ATOMIC_RELEASE);
+	_sqPending = 0;
+
+	if (msecs == 0)
+	{
+		if (pending > 0 && enter(pending, 0, 0) < 0)
+		{
+			return -1;
+		}
+	}
+	else if (enter(pending, 1, msecs) < 0)
+	{
+		return -1;
+	}
+	return readCqe(ev) ? 1 : 0;
+}
+
+/**
+ *  Give the buffer of a completion back to the kernel, ev->data is no longer valid.
+ */
+void IOUring::release(IOUringEvent* ev)
+{
+	if (ev->bufferId < 0 || !isOpen())
+	{
+		return;
+	}
+	io_uring_buf* bufs = (io_uring_buf*)_bufRing;
+	uint16_t tail = bufs[0].resv;
+	io_uring_buf* buf = &bufs[tail & (IOURING_BUFFER_COUNT - 1)];
+	buf->addr = (uintptr_t)(_buffers + ev->bufferId * IOURING_BUFFER_SIZE);
+	buf->len = IOURING_BUFFER_SIZE;
+	buf->bid = ev->bufferId;
+	__atomic_store_n(&bufs[0].resv, (uint16_t)(tail + 1), __ATOMIC_RELEASE);
+	ev->bufferId = -1;
+	ev->data = nullptr;
+}
+
+#else   /* without <linux/io_uring.h>, the callers keep using select() */
+
+bool IOUring::open(void)
+{
+	return false;
+}
+
+void IOUring::close(void)
+{
+}
+
+void* IOUring::getSqe(void)
+{
+	return nullptr;
+}
+
+bool IOUring::recvMultishot(int sockfd, uint64_t userData)
+{
+	return false;
+}
+
+bool IOUring::recvmsgMultishot(int sockfd, uint64_t userData)
+{
+	return false;
+}
+
+bool IOUring::pollMultishot(int sockfd, uint64_t userData)
+{
+	return false;
+}
+
+bool IOUring::send(int sockfd, const uint8_t* buf, int length, uint64_t userData)
+{
+	return false;
+}
+
+bool IOUring::cancel(uint64_t userData)
+{
+	return false;
+}
+
+bool IOUring::readCqe(IOUringEvent* ev)
+{
+	return false;
+}
+
+int IOUring::enter(uint32_t toSubmit, uint32_t minComplete, int msecs)
+{
+	return -1;
+}
+
+int IOUring::submit(void)
+{
+	return -1;
+}
+
+int IOUring::wait(IOUringEvent* ev, int msecs)
+{
+	return -1;
+}
+
+void IOUring::release(IOUringEvent* ev)
+{
+}
+#endif
+
+bool IOUring::isOpen(void)
+{
+	return _fd >= 0;
+}
+
+/**
+ *  Number of io_uring_enter() syscalls made
+ */
+uint32_t IOUring::getEnterCnt(void)
+{
+	return _enterCnt;
+}
@@ -0,0 +1,105 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - io_uring network I/O
+ **************************************************************************************/
+
+#ifndef MQTTSNGATEWAY_SRC_LINUX_IOURING_H_
+#define MQTTSNGATEWAY_SRC_LINUX_IOURING_H_
+
+#include <stdint.h>
+#include <sys/socket.h>
+
+namespace MQTTSNGW
+{
+
+#define IOURING_ENTRIES        64   // Submission queue entries, the completion queue has twice as many
+#define IOURING_BUFFER_COUNT  256   // Buffers the kernel receives into, a power of 2
+#define IOURING_BUFFER_SIZE  2048   // Bytes of a receive buffer, a longer datagram is truncated
+
+/* A completion returned by IOUring::wait() */
+typedef struct
+{
+	uint64_t userData;     // given when the request was prepared
+	int32_t  res;          // bytes received or sent, -errno on failure
+	bool     more;         // the multishot request stays armed, otherwise it has to be prepared again
+	uint8_t* data;         // received bytes, in a buffer of the ring until release()
+	int      length;
+	uint32_t ipAddress;    // sender of a datagram received by recvmsgMultishot(), network byte order
+	uint16_t portNo;
+	int      bufferId;     // -1 when no buffer was used
+} IOUringEvent;
+
+/*=====================================
+ Class IOUring
+
+ A Linux io_uring, used instead of select() and one recv() or send() per packet
+ when IOUring=YES.  Multishot requests stay armed on a socket and receive into
+ a ring of buffers registered once, prepared requests are submitted together with
+ the next wait(), and completions already in the queue are read without a syscall.
+ A ring is used by one thread. open() fails on kernels without io_uring or
+ without provided buffer rings (5.19), the caller then keeps using select().
+ =====================================*/
+class IOUring
+{
+public:
+	IOUring();
+	~IOUring();
+
+	bool open(void);
+	void close(void);
+	bool isOpen(void);
+
+	bool recvMultishot(int sockfd, uint64_t userData);
+	bool recvmsgMultishot(int sockfd, uint64_t userData);
+	bool pollMultishot(int sockfd, uint64_t userData);
+	bool send(int sockfd, const uint8_t* buf, int length, uint64_t userData);
+	bool cancel(uint64_t userData);
+
+	int submit(void);
+	int wait(IOUringEvent* ev, int msecs);
+	void release(IOUringEvent* ev);
+	uint32_t getEnterCnt(void);
+
+private:
+	void* getSqe(void);
+	bool readCqe(IOUringEvent* ev);
+	int enter(uint32_t toSubmit, uint32_t minComplete, int msecs);
+
+	int _fd;
+	void* _sqRing;
+	size_t _sqRingSize;
+	void* _cqRing;
+	size_t _cqRingSize;
+	void* _sqes;
+	size_t _sqesSize;
+	uint32_t* _sqHead;
+	uint32_t* _sqTail;
+	uint32_t _sqMask;
+	uint32_t _sqEntries;
+	uint32_t* _sqArray;
+	uint32_t _sqPending;
+	uint32_t* _cqHead;
+	uint32_t* _cqTail;
+	uint32_t _cqMask;
+	void* _cqes;
+	void* _bufRing;
+	size_t _bufRingSize;
+	uint8_t* _buffers;
+	struct msghdr _msghdr;    // read by the kernel for each datagram of a recvmsgMultishot()
+	uint32_t _enterCnt;
+};
+
+}
+
+#endif /* MQTTSNGATEWAY_SRC_LINUX_IOURING_H_ */
@@ -15,6 +15,7 @@
  **************************************************************************************/
 
 #include <string.h>
+#include <stdlib.h>
 #include <openssl/ssl.h>
 #include <openssl/err.h>
 #include <openssl/rand.h>
@@ -24,6 +25,7 @@
 #include <regex>
 
 #include "Network.h"
+#include "IOUring.h"
 #include "MQTTSNGWDefines.h"
 #include "MQTTSNGWProcess.h"
 
@@ -36,6 +38,8 @@ char* currentDateTime();
 /*========================================
  Class TCPStack
  =======================================*/
+TCPLoopback* TCPStack::_loopback = nullptr;
+
 TCPStack::TCPStack()
 {
 	_addrinfo = 0;
@@ -60,6 +64,8 @@ void TCPStack::close()
 	_mutex.lock();
 	if (_sockfd > 0)
 	{
+		/* a request of an IOUring armed on the socket keeps it open until it is shut down */
+		::shutdown(_sockfd, SHUT_RDWR);
 		::close(_sockfd);
 		_sockfd = 0;
 		if (_addrinfo)
@@ -159,6 +165,16 @@ bool TCPStack::connect(const char* host, const char* service)
 	{
 		return true;
 	}
+	if (_loopback)
+	{
+		int sockfd = _loopback->connect(host, service);
+		if (sockfd < 0)
+		{
+			return false;
+		}
+		_sockfd = sockfd;
+		return true;
+	}
 	addrinfo hints;
 	memset(&hints, 0, sizeof(addrinfo));
 	hints.ai_family = AF_INET;
@@ -200,6 +216,34 @@ bool TCPStack::connect(const char* host, const char* service)
 	return true;
 }
 
+/*
+ *  Connect every TCPStack to loopback instead of the host, e.g. an in-process broker
+ *  for benchmarks. Set before the connections are made, nullptr goes back to TCP.
+ */
+void TCPStack::setLoopback(TCPLoopback* loopback)
+{
+	_loopback = loopback;
+}
+
+/*
+ *  Move the socket of a connected TCPStack into this one, which must be closed.
+ */
+void TCPStack::takeOver(TCPStack& other)
+{
+	_mutex.lock();
+	other._mutex.lock();
+	if (_addrinfo)
+	{
+		freeaddrinfo(_addrinfo);
+	}
+	_sockfd = other._sockfd;
+	_addrinfo = other._addrinfo;
+	other._sockfd = 0;
+	other._addrinfo = 0;
+	other._mutex.unlock();
+	_mutex.unlock();
+}
+
 void TCPStack::setNonBlocking(const bool b)
 {
 	int opts;
@@ -228,12 +272,203 @@ int TCPStack::getSock()
 }
 
 /*========================================
- Class Network
+ Class TLSSessionCache
+
+ SSL_CTX and the latest TLS session of each broker endpoint ("host:port"),
+ shared by all secure clients so that their reconnections resume the session
+ instead of making a full handshake.
+ Sessions are stored from the new session callback, which is where TLS 1.3 tickets arrive.
+ When the cache is full the least recently used endpoint is dropped.
+ Contexts are handed out with a reference of their own, so dropping one
+ does not free it under a thread that is still connecting with it.
  =======================================*/
-int Network::_numOfInstance = 0;
-SSL_CTX* Network::_ctx = 0;
-SSL_SESSION* Network::_session = 0;
+TLSSessionCache::TLSSessionCache()
+{
+	for ( int i = 0; i < TLS_SESSION_CACHE_SIZE; i++ )
+	{
+		_entries[i].ctx = 0;
+		_entries[i].session = 0;
+		_entries[i].lastUse = 0;
+	}
+	_useCnt = 0;
+	_fullHandshakes = 0;
+	_resumedHandshakes = 0;
+}
+
+TLSSessionCache::~TLSSessionCache()
+{
+	clear();
+}
+
+TLSSessionCache::Entry* TLSSessionCache::find(const char* endpoint)
+{
+	for ( int i = 0; i < TLS_SESSION_CACHE_SIZE; i++ )
+	{
+		if ( _entries[i].ctx && _entries[i].endpoint == endpoint )
+		{
+			_entries[i].lastUse = ++_useCnt;
+			return &_entries[i];
+		}
+	}
+	return 0;
+}
+
+/*
+ *  @return a reference to the SSL_CTX of the endpoint to be freed by the caller, or 0.
+ */
+SSL_CTX* TLSSessionCache::getContext(const char* endpoint)
+{
+	_mutex.lock();
+	Entry* entry = find(endpoint);
+	SSL_CTX* ctx = entry ? entry->ctx : 0;
+	if ( ctx )
+	{
+		SSL_CTX_up_ref(ctx);
+	}
+	_mutex.unlock();
+	return ctx;
+}
+
+/*
+ *  Keep ctx for the endpoint. The cache takes over the reference.
+ *  @return a reference to the SSL_CTX to use, another thread's one if it was put first,
+ *          to be freed by the caller.
+ */
+SSL_CTX* TLSSessionCache::putContext(const char* endpoint, SSL_CTX* ctx)
+{
+	_mutex.lock();
+	Entry* entry = find(endpoint);
+	if ( entry )
+	{
+		SSL_CTX_free(ctx);
+		ctx = entry->ctx;
+	}
+	else
+	{
+		entry = &_entries[0];
+		for ( int i = 1; i < TLS_SESSION_CACHE_SIZE && entry->ctx; i++ )
+		{
+			if ( _entries[i].ctx == 0 || _entries[i].lastUse < entry->lastUse )
+			{
+				entry = &_entries[i];
+			}
+		}
+		if ( entry->ctx )
+		{
+			/* SSL objects and callers of getContext() hold their own references */
+			SSL_CTX_free(entry->ctx);
+		}
+		if ( entry->session )
+		{
+			SSL_SESSION_free(entry->session);
+			entry->session = 0;
+		}
+		entry->endpoint = endpoint;
+		entry->ctx = ctx;
+		entry->lastUse = ++_useCnt;
+	}
+	SSL_CTX_up_ref(ctx);
+	_mutex.unlock();
+	return ctx;
+}
+
+/*
+ *  @return a reference to the session of the endpoint to be freed by the caller, or 0.
+ */
+SSL_SESSION* TLSSessionCache::getSession(const char* endpoint)
+{
+	SSL_SESSION* session = 0;
+	_mutex.lock();
+	Entry* entry = find(endpoint);
+	if ( entry && entry->session )
+	{
+		session = entry->session;
+		SSL_SESSION_up_ref(session);
+	}
+	_mutex.unlock();
+	return session;
+}
+
+/*
+ *  Replace the session of the endpoint. The cache takes over the reference.
+ */
+void TLSSessionCache::putSession(const char* endpoint, SSL_SESSION* session)
+{
+	_mutex.lock();
+	Entry* entry = find(endpoint);
+	if ( entry )
+	{
+		if ( entry->session )
+		{
+			SSL_SESSION_free(entry->session);
+		}
+		entry->session = session;
+	}
+	else
+	{
+		SSL_SESSION_free(session);
+	}
+	_mutex.unlock();
+}
+
+void TLSSessionCache::removeSession(const char* endpoint)
+{
+	_mutex.lock();
+	Entry* entry = find(endpoint);
+	if ( entry && entry->session )
+	{
+		SSL_SESSION_free(entry->session);
+		entry->session = 0;
+	}
+	_mutex.unlock();
+}
+
+void TLSSessionCache::clear(void)
+{
+	_mutex.lock();
+	for ( int i = 0; i < TLS_SESSION_CACHE_SIZE; i++ )
+	{
+		if ( _entries[i].session )
+		{
+			SSL_SESSION_free(_entries[i].session);
+			_entries[i].session = 0;
+		}
+		if ( _entries[i].ctx )
+		{
+			SSL_CTX_free(_entries[i].ctx);
+			_entries[i].ctx = 0;
+		}
+	}
+	_mutex.unlock();
+}
 
+void TLSSessionCache::countHandshake(bool resumed)
+{
+	_mutex.lock();
+	if ( resumed )
+	{
+		_resumedHandshakes++;
+	}
+	else
+	{
+		_fullHandshakes++;
+	}
+	_mutex.unlock();
+}
+
+uint32_t TLSSessionCache::getFullHandshakes(void)
+{
+	return _fullHandshakes;
+}
+
+uint32_t TLSSessionCache::getResumedHandshakes(void)
+{
+	return _resumedHandshakes;
+}
+
+/*========================================
+ Class Network
+ =======================================*/
 Network::Network(bool secure) :
 		TCPStack()
 {
@@ -241,11 +476,117 @@ Network::Network(bool secure) :
 	_secureFlg = secure;
 	_busy = false;
 	_sslValid = false;
+	_sendBuf = 0;
+	_sendLen = 0;
+	_ringBuf = 0;
+	_ringLen = 0;
+	_ringCloseCnt = 0;
+	_writeCnt = 0;
+	_closeCnt = 0;
+	_recvBuf = 0;
+	_recvSize = 0;
+	_recvLen = 0;
+	_recvPos = 0;
+	_recvCloseCnt = 0;
+	_backlog = 0;
+	_sendBacklog = 0;
+	_inflight = 0;
 }
 
 Network::~Network()
 {
 	close();
+	if (_sendBuf)
+	{
+		free(_sendBuf);
+	}
+	if (_ringBuf)
+	{
+		free(_ringBuf);
+	}
+	if (_recvBuf)
+	{
+		free(_recvBuf);
+	}
+}
+
+/*
+ *  The cache lives as long as the process. It is not a static object because
+ *  OpenSSL may already be cleaned up when static objects are destroyed.
+ */
+TLSSessionCache* Network::getSessionCache(void)
+{
+	static TLSSessionCache* cache = new TLSSessionCache();
+	return cache;
+}
+
+int Network::newSession(SSL* ssl, SSL_SESSION* session)
+{
+	Network* network = (Network*)SSL_get_app_data(ssl);
+	if ( network == 0 )
+	{
+		return 0;
+	}
+	getSessionCache()->putSession(network->_endpoint.c_str(), session);
+	return 1;
+}
+
+SSL_CTX* Network::createContext(const char* caPath, const char* caFile, const char* certkey, const char* prvkey)
+{
+	char errmsg[256];
+	SSL_CTX* ctx;
+
+	SSL_load_error_strings();
+	SSL_library_init();
+
+#if ( OPENSSL_VERSION_NUMBER >= 0x10100000L )
+	ctx = SSL_CTX_new(TLS_client_method());
+#elif ( OPENSSL_VERSION_NUMBER >= 0x10001000L )
+	ctx = SSL_CTX_new(TLSv1_client_method());
+#else
+	ctx = SSL_CTX_new(SSLv23_client_method());
+#endif
+
+	if (ctx == 0)
+	{
+		ERR_error_string_n(ERR_get_error(), errmsg, sizeof(errmsg));
+		WRITELOG("SSL_CTX_new() %s\n", errmsg);
+		return 0;
+	}
+
+	if (!SSL_CTX_load_verify_locations(ctx, caFile, caPath))
+	{
+		ERR_error_string_n(ERR_get_error(), errmsg, sizeof(errmsg));
+		WRITELOG("SSL_CTX_load_verify_locations() %s\n", errmsg);
+		SSL_CTX_free(ctx);
+		return 0;
+	}
+
+	if ( certkey )
+	{
+		if ( SSL_CTX_use_certificate_file(ctx, certkey, SSL_FILETYPE_PEM) != 1 )
+		{
+			ERR_error_string_n(ERR_get_error(), errmsg, sizeof(errmsg));
+			WRITELOG("SSL_CTX_use_certificate_file() %s %s\n", certkey, errmsg);
+			SSL_CTX_free(ctx);
+			return 0;
+		}
+	}
+	if ( prvkey )
+	{
+		if ( SSL_CTX_use_PrivateKey_file(ctx, prvkey, SSL_FILETYPE_PEM) != 1 )
+		{
+			ERR_error_string_n(ERR_get_error(), errmsg, sizeof(errmsg));
+			WRITELOG("SSL_use_PrivateKey_file() %s %s\n", prvkey, errmsg);
+			SSL_CTX_free(ctx);
+			return 0;
+		}
+	}
+
+	/* sessions are kept by TLSSessionCache, from the ticket or session id the broker sends */
+	SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+	SSL_CTX_sess_set_new_cb(ctx, newSession);
+	return ctx;
 }
 
 bool Network::connect(const char* host, const char* port)
@@ -275,6 +616,7 @@ bool Network::connect(const char* host, const char* port, const char* caPath, co
 	char errmsg[256];
 	char peer_CN[256];
 	bool rc;
+	TLSSessionCache* cache = getSessionCache();
 
 	_mutex.lock();
 	try
@@ -285,69 +627,36 @@ bool Network::connect(const char* host, const char* port, const char* caPath, co
 			throw false;
 		}
 
-		if (_ctx == 0)
+		_endpoint = string(host) + ":" + port;
+		SSL_CTX* ctx = cache->getContext(_endpoint.c_str());
+		if (ctx == 0)
 		{
-			SSL_load_error_strings();
-			SSL_library_init();
-
-#if ( OPENSSL_VERSION_NUMBER >= 0x10100000L )
-			_ctx = SSL_CTX_new(TLS_client_method());
-#elif ( OPENSSL_VERSION_NUMBER >= 0x10001000L )
-			_ctx = SSL_CTX_new(TLSv1_client_method());
-#else
-			_ctx = SSL_CTX_new(SSLv23_client_method());
-#endif
-
-			if (_ctx == 0)
+			if ((ctx = createContext(caPath, caFile, certkey, prvkey)) == 0)
 			{
-				ERR_error_string_n(ERR_get_error(), errmsg, sizeof(errmsg));
-				WRITELOG("SSL_CTX_new() %s\n", errmsg);
 				throw false;
 			}
-
-
-			if (!SSL_CTX_load_verify_locations(_ctx, caFile, caPath))
-			{
-				ERR_error_string_n(ERR_get_error(), errmsg, sizeof(errmsg));
-				WRITELOG("SSL_CTX_load_verify_locations() %s\n", errmsg);
-				throw false;
-			}
-
-			if ( certkey )
-			{
-				if ( SSL_CTX_use_certificate_file(_ctx, certkey, SSL_FILETYPE_PEM) != 1 )
-				{
-					ERR_error_string_n(ERR_get_error(), errmsg, sizeof(errmsg));
-					WRITELOG("SSL_CTX_use_certificate_file() %s %s\n", certkey, errmsg);
-					throw false;
-				}
-			}
-			if ( prvkey )
-			{
-				if ( SSL_CTX_use_PrivateKey_file(_ctx, prvkey, SSL_FILETYPE_PEM) != 1 )
-				{
-					ERR_error_string_n(ERR_get_error(), errmsg, sizeof(errmsg));
-					WRITELOG("SSL_use_PrivateKey_file() %s %s\n", prvkey, errmsg);
-					throw false;
-				}
-			}
+			ctx = cache->putContext(_endpoint.c_str(), ctx);
 		}
 
 		if (! TCPStack::isValid())
 		{
 			if ( !TCPStack::connect(host, port) )
 			{
+				SSL_CTX_free(ctx);
 				throw false;
 			}
 		}
 
-		_ssl = SSL_new(_ctx);
+		/* the SSL keeps its own reference to the SSL_CTX */
+		_ssl = SSL_new(ctx);
+		SSL_CTX_free(ctx);
 		if (_ssl == 0)
 		{
 			ERR_error_string_n(ERR_get_error(), errmsg, sizeof(errmsg));
 			WRITELOG("SSL_new()  %s\n", errmsg);
 			throw false;
 		}
+		SSL_set_app_data(_ssl, this);
 
 		if (!SSL_set_fd(_ssl, TCPStack::getSock()))
 		{
@@ -358,9 +667,11 @@ bool Network::connect(const char* host, const char* port, const char* caPath, co
 			throw false;
 		}
 
-		if (_session)
+		SSL_SESSION* session = cache->getSession(_endpoint.c_str());
+		if (session)
 		{
-			SSL_set_session(_ssl, _session);
+			SSL_set_session(_ssl, session);
+			SSL_SESSION_free(session);
 		}
 
 		if (SSL_connect(_ssl) != 1)
@@ -369,6 +680,10 @@ bool Network::connect(const char* host, const char* port, const char* caPath, co
 			WRITELOG("SSL_connect() %s\n", errmsg);
 			SSL_free(_ssl);
 			_ssl = 0;
+			if (session)
+			{
+				cache->removeSession(_endpoint.c_str());
+			}
 			throw false;
 		}
 
@@ -383,6 +698,7 @@ bool Network::connect(const char* host, const char* port, const char* caPath, co
 
 		X509* peer = SSL_get_peer_certificate(_ssl);
 		X509_NAME_get_text_by_NID(X509_get_subject_name(peer), NID_commonName, peer_CN, 256);
+		X509_free(peer);
 		char* pos = peer_CN;
 		if ( *pos == '*')
 		{
@@ -397,11 +713,7 @@ bool Network::connect(const char* host, const char* port, const char* caPath, co
 			throw false;
 		}
 
-		if (_session == 0)
-		{
-			_session = SSL_get1_session(_ssl);
-		}
-		_numOfInstance++;
+		cache->countHandshake(SSL_session_reused(_ssl));
 		_sslValid = true;
 		rc = true;
 	}
@@ -413,7 +725,380 @@ bool Network::connect(const char* host, const char* port, const char* caPath, co
 	return rc;
 }
 
+/*
+ *  Take the connection, TCP and TLS, of another Network to the same broker, see BrokerPool.
+ *  This one is closed first, the other one is left closed.
+ */
+bool Network::takeOver(Network* other)
+{
+	if (other->_secureFlg != _secureFlg || !other->isValid())
+	{
+		return false;
+	}
+	close();
+
+	_mutex.lock();
+	other->_mutex.lock();
+	TCPStack::takeOver(*other);
+	_ssl = other->_ssl;
+	_sslValid = other->_sslValid;
+	_endpoint = other->_endpoint;
+	if (_ssl)
+	{
+		/* session tickets arriving later are stored by newSession() */
+		SSL_set_app_data(_ssl, this);
+	}
+	other->_ssl = 0;
+	other->_sslValid = false;
+	other->_mutex.unlock();
+	_mutex.unlock();
+	return true;
+}
+
+/*
+ *  Write the queued packets and then buf.
+ */
 int Network::send(const uint8_t* buf, uint16_t length)
+{
+	int rc = 0;
+	_mutex.lock();
+	if (_sendLen > 0)
+	{
+		rc = write(_sendBuf, _sendLen);
+		emptied();
+	}
+	if (rc >= 0)
+	{
+		rc = write(buf, length);
+	}
+	_mutex.unlock();
+	return rc;
+}
+
+/*
+ *  Add a packet to the ones written together by flush(), so that a burst of packets
+ *  becomes one TLS record or one TCP segment instead of one per packet.
+ *  The queue is written first when the packet does not fit.
+ *  @param latency  msecs after which isFlushDue() tells the first queued packet has waited long enough
+ *  @param first    set when the packet was queued into an empty queue, a flush() is due for it.
+ *  @param nowait   nothing is written, the packet is refused when it does not fit.
+ *                  Its bytes count in the backlog until the queue is written.
+ *  @return length, 0 if the packet was refused, -1 if the queued packets could not be written.
+ */
+int Network::queue(const uint8_t* buf, uint16_t length, uint32_t latency, bool* first, bool nowait)
+{
+	int rc = length;
+	_mutex.lock();
+	if (first)
+	{
+		*first = false;
+	}
+	if (nowait && (_sendLen + length > NETWORK_SEND_BUFFER_SIZE || (_sendBuf == 0 && (_sendBuf = (uint8_t*)malloc(NETWORK_SEND_BUFFER_SIZE)) == 0)))
+	{
+		_mutex.unlock();
+		return 0;
+	}
+	if (_ringLen > 0 && (_sendLen + length > NETWORK_SEND_BUFFER_SIZE || length > NETWORK_SEND_BUFFER_SIZE))
+	{
+		/* written now, the packet would overtake the write in flight on the ring */
+		_mutex.unlock();
+		return -1;
+	}
+	if (_sendLen + length > NETWORK_SEND_BUFFER_SIZE && _sendLen > 0)
+	{
+		rc = write(_sendBuf, _sendLen);
+		emptied();
+	}
+	if (rc >= 0)
+	{
+		if (_sendBuf == 0)
+		{
+			_sendBuf = (uint8_t*)malloc(NETWORK_SEND_BUFFER_SIZE);
+		}
+
+		if (length > NETWORK_SEND_BUFFER_SIZE || _sendBuf == 0)
+		{
+			rc = write(buf, length);
+		}
+		else
+		{
+			if (_sendLen == 0)
+			{
+				_sendTimer.start(latency);
+				if (first)
+				{
+					*first = true;
+				}
+			}
+			memcpy(_sendBuf + _sendLen, buf, length);
+			_sendLen += length;
+			if (nowait)
+			{
+				_sendBacklog += length;
+				addBacklog(length);
+			}
+		}
+	}
+	_mutex.unlock();
+	return rc;
+}
+
+/*
+ *  Whether a packet of length fits the queue without a write.
+ *  Only queue() takes room, the answer holds until the caller queues, see MQTTGWv5Session::queue().
+ */
+bool Network::hasRoom(int length)
+{
+	_mutex.lock();
+	bool room = _sendLen + length <= NETWORK_SEND_BUFFER_SIZE;
+	_mutex.unlock();
+	return room;
+}
+
+/*
+ *  The queue is written or dropped.  Called with _mutex locked.
+ */
+void Network::emptied(void)
+{
+	_sendLen = 0;
+	_sendTimer.stop();
+	if (_sendBacklog)
+	{
+		addBacklog(-(int)_sendBacklog);
+		_sendBacklog = 0;
+	}
+}
+
+/*
+ *  Write the queued packets.
+ *  @return the number of bytes written, -1 on error.
+ */
+int Network::flush(void)
+{
+	int rc = 0;
+	_mutex.lock();
+	if (_sendLen > 0)
+	{
+		rc = write(_sendBuf, _sendLen);
+		emptied();
+	}
+	_mutex.unlock();
+	return rc;
+}
+
+/*
+ *  Locked as packets are also queued by ClientRecvTask, see QoSm1Proxy::publish().
+ */
+bool Network::isQueued(void)
+{
+	_mutex.lock();
+	bool queued = _sendLen > 0;
+	_mutex.unlock();
+	return queued;
+}
+
+bool Network::isFlushDue(void)
+{
+	_mutex.lock();
+	bool due = _sendLen > 0 && _sendTimer.isTimeup();
+	_mutex.unlock();
+	return due;
+}
+
+/*
+ *  Write the queued packets through the ring, so that BrokerSendTask submits the writes
+ *  of all its connections with one syscall. The packets are moved to a buffer of their own
+ *  and the connection is unlocked, packets queued meanwhile are written after flushed().
+ *  @return true when the write is prepared, false when flush() has to be used.
+ */
+bool Network::flush(IOUring* ring, uint64_t userData)
+{
+	bool prepared = false;
+	if (_secureFlg)
+	{
+		return false;
+	}
+	_mutex.lock();
+	if (_ringBuf == 0)
+	{
+		_ringBuf = (uint8_t*)malloc(NETWORK_SEND_BUFFER_SIZE);
+	}
+	if (_sendLen > 0 && _ringLen == 0 && _ringBuf)
+	{
+		memcpy(_ringBuf, _sendBuf, _sendLen);
+		if (ring->send(getSock(), _ringBuf, _sendLen, userData))
+		{
+			_ringLen = _sendLen;
+			_ringCloseCnt = _closeCnt;
+			emptied();
+			_writeCnt++;
+			prepared = true;
+		}
+	}
+	_mutex.unlock();
+	return prepared;
+}
+
+/*
+ *  Complete a write prepared by flush(IOUring*), the rest of a short one is written here.
+ *  @return the number of bytes written, -1 on error.
+ */
+int Network::flushed(int res)
+{
+	int rc = res;
+	_mutex.lock();
+	if (_ringCloseCnt != _closeCnt)
+	{
+		/* the connection was closed while the write was in flight */
+		rc = -1;
+	}
+	else if (res < 0)
+	{
+		errno = -res;
+		rc = -1;
+	}
+	else if (res < _ringLen)
+	{
+		rc = (write(_ringBuf + res, _ringLen - res) < 0) ? -1 : _ringLen;
+	}
+	_ringLen = 0;
+	_mutex.unlock();
+	return rc;
+}
+
+/*
+ *  Bytes of the connection received by BrokerRecvTask's IOUring.
+ *  Once fed, recv() reads them instead of the socket until the connection is closed.
+ */
+void Network::feed(const uint8_t* data, int length)
+{
+	if (_recvCloseCnt != _closeCnt)
+	{
+		/* the bytes left belong to a connection closed since */
+		_recvLen = 0;
+		_recvPos = 0;
+		_recvCloseCnt = _closeCnt;
+	}
+	if (_recvPos > 0)
+	{
+		memmove(_recvBuf, _recvBuf + _recvPos, _recvLen - _recvPos);
+		_recvLen -= _recvPos;
+		_recvPos = 0;
+	}
+	if (_recvLen + length > _recvSize)
+	{
+		int size = (_recvSize > 0) ? _recvSize : MQTTSNGW_MAX_PACKET_SIZE;
+		while (size < _recvLen + length)
+		{
+			size *= 2;
+		}
+		uint8_t* buf = (uint8_t*)realloc(_recvBuf, size);
+		if (buf == 0)
+		{
+			return;
+		}
+		_recvBuf = buf;
+		_recvSize = size;
+	}
+	memcpy(_recvBuf + _recvLen, data, length);
+	_recvLen += length;
+}
+
+/*
+ *  Whether the fed bytes hold a whole MQTT packet, or a malformed Remaining Length recv() fails on.
+ */
+bool Network::isReceived(void)
+{
+	int len = 0;
+	uint32_t remainingLength = 0;
+	uint32_t multiplier = 1;
+	uint8_t c;
+
+	if (_recvCloseCnt != _closeCnt)
+	{
+		return false;
+	}
+	do
+	{
+		if (++len > 3)     // the most MQTTGWPacket::recv() reads
+		{
+			return true;
+		}
+		if (_recvPos + len >= _recvLen)
+		{
+			return false;
+		}
+		c = _recvBuf[_recvPos + len];
+		remainingLength += (c & 127) * multiplier;
+		multiplier *= 128;
+	} while ((c & 128) != 0);
+
+	return _recvPos + 1 + len + (int)remainingLength <= _recvLen;
+}
+
+uint32_t Network::getWriteCnt(void)
+{
+	return _writeCnt;
+}
+
+uint32_t Network::getCloseCnt(void)
+{
+	return _closeCnt;
+}
+
+/*
+ *  Flow control toward the broker.  The backlog counts the bytes of the packets waiting
+ *  for BrokerSendTask, which grows while the broker reads slower than the clients publish.
+ *  These are kept under their own mutex, _mutex is held while a write blocks.
+ */
+void Network::addBacklog(int length)
+{
+	_flowMutex.lock();
+	_backlog = ((int)_backlog + length > 0) ? _backlog + length : 0;
+	_flowMutex.unlock();
+}
+
+uint32_t Network::getBacklog(void)
+{
+	_flowMutex.lock();
+	uint32_t backlog = _backlog;
+	_flowMutex.unlock();
+	return backlog;
+}
+
+void Network::addInflight(int cnt)
+{
+	_flowMutex.lock();
+	_inflight = ((int)_inflight + cnt > 0) ? _inflight + cnt : 0;
+	_flowMutex.unlock();
+}
+
+uint16_t Network::getInflight(void)
+{
+	_flowMutex.lock();
+	uint16_t inflight = _inflight;
+	_flowMutex.unlock();
+	return inflight;
+}
+
+/*
+ *  @param maxBacklog   bytes, 0: no limit
+ *  @param maxInflight  PUBLISHes, 0: no limit
+ *  @return true when no more PUBLISHes should be accepted for this connection
+ */
+bool Network::isCongested(uint32_t maxBacklog, uint16_t maxInflight)
+{
+	_flowMutex.lock();
+	bool congested = (maxBacklog && _backlog >= maxBacklog) || (maxInflight && _inflight >= maxInflight);
+	_flowMutex.unlock();
+	return congested;
+}
+
+/*
+ *  Write the whole buffer, one SSL_write or send() per call unless the socket takes less.
+ *  Called with _mutex locked.
+ */
+int Network::write(const uint8_t* buf, int length)
 {
 	char errmsg[256];
 	fd_set rset;
@@ -423,59 +1108,63 @@ int Network::send(const uint8_t* buf, uint16_t length)
 
 	if (!_secureFlg)
 	{
-		return TCPStack::send(buf, length);
+		while (bpos < length)
+		{
+			_writeCnt++;
+			int r = TCPStack::send(buf + bpos, length - bpos);
+			if (r <= 0)
+			{
+				return -1;
+			}
+			bpos += r;
+		}
+		return bpos;
 	}
-	else
+
+	if ( !_ssl )
 	{
-		_mutex.lock();
+		return -1;
+	}
+	_busy = true;
 
-		if ( !_ssl )
-		{
-			_mutex.unlock();
-			return -1;
-		}
-		_busy = true;
+	while (true)
+	{
+		FD_ZERO(&rset);
+		FD_ZERO(&wset);
+		FD_SET(getSock(), &rset);
+		FD_SET(getSock(), &wset);
 
-		while (true)
+		int activity = select(getSock() + 1, &rset, &wset, 0, 0);
+		if (activity > 0)
 		{
-			FD_ZERO(&rset);
-			FD_ZERO(&wset);
-			FD_SET(getSock(), &rset);
-			FD_SET(getSock(), &wset);
-
-			int activity = select(getSock() + 1, &rset, &wset, 0, 0);
-			if (activity > 0)
+			if (FD_ISSET(getSock(), &wset) || (writeBlockedOnRead  && FD_ISSET(getSock(), &rset)))
 			{
-				if (FD_ISSET(getSock(), &wset) || (writeBlockedOnRead  && FD_ISSET(getSock(), &rset)))
-				{
 
-					writeBlockedOnRead = false;
-					int r = SSL_write(_ssl, buf + bpos, length);
+				writeBlockedOnRead = false;
+				_writeCnt++;
+				int r = SSL_write(_ssl, buf + bpos, length);
 
-					switch (SSL_get_error(_ssl, r))
+				switch (SSL_get_error(_ssl, r))
+				{
+				case SSL_ERROR_NONE:
+					length -= r;
+					bpos += r;
+					if (length == 0)
 					{
-					case SSL_ERROR_NONE:
-						length -= r;
-						bpos += r;
-						if (length == 0)
-						{
-							_busy = false;
-							_mutex.unlock();
-							return bpos;
-						}
-						break;
-					case SSL_ERROR_WANT_WRITE:
-						break;
-					case SSL_ERROR_WANT_READ:
-						writeBlockedOnRead = true;
-						break;
-					default:
-						ERR_error_string_n(ERR_get_error(), errmsg, sizeof(errmsg));
-						WRITELOG("TLSStack::send() default %s\n", errmsg);
 						_busy = false;
-						_mutex.unlock();
-						return -1;
+						return bpos;
 					}
+					break;
+				case SSL_ERROR_WANT_WRITE:
+					break;
+				case SSL_ERROR_WANT_READ:
+					writeBlockedOnRead = true;
+					break;
+				default:
+					ERR_error_string_n(ERR_get_error(), errmsg, sizeof(errmsg));
+					WRITELOG("TLSStack::send() default %s\n", errmsg);
+					_busy = false;
+					return -1;
 				}
 			}
 		}
@@ -495,6 +1184,13 @@ int Network::recv(uint8_t* buf, uint16_t len)
 
 	if (!_secureFlg)
 	{
+		if (_recvBuf && _recvCloseCnt == _closeCnt)
+		{
+			int rlen = (_recvLen - _recvPos < len) ? _recvLen - _recvPos : len;
+			memcpy(buf, _recvBuf + _recvPos, rlen);
+			_recvPos += rlen;
+			return rlen;
+		}
 		return TCPStack::recv(buf, len);
 	}
 
@@ -528,8 +1224,8 @@ loop:
 			break;
 		case SSL_ERROR_ZERO_RETURN:
 			SSL_shutdown(_ssl);
+			SSL_free(_ssl);
 			_ssl = 0;
-			_numOfInstance--;
 			//TCPStack::close();
 			_busy = false;
 			_mutex.unlock();
@@ -581,28 +1277,21 @@ loop:
 void Network::close(void)
 {
 	_mutex.lock();
+	emptied();
+	_closeCnt++;
+	_flowMutex.lock();
+	_inflight = 0;     // the connection is gone, no acknowledgement will come
+	_flowMutex.unlock();
 	if (_secureFlg)
 	{
 		if (_ssl)
 		{
 			SSL_shutdown(_ssl);
 			SSL_free(_ssl);
-			_numOfInstance--;
 			_ssl = 0;
 			_sslValid = false;
 			_busy = false;
 		}
-		if (_session && _numOfInstance == 0)
-		{
-			SSL_SESSION_free(_session);
-			_session = 0;
-		}
-		if (_ctx && _numOfInstance == 0)
-		{
-			SSL_CTX_free(_ctx);
-			_ctx = 0;
-			ERR_free_strings();
-		}
 	}
 	TCPStack::close();
 	_mutex.unlock();
@@ -23,13 +23,33 @@
 #include <netdb.h>
 #include <openssl/ssl.h>
 #include <openssl/err.h>
+#include <string>
 
 #include "Threading.h"
+#include "Timer.h"
 #include "MQTTSNGWDefines.h"
 
 using namespace std;
 using namespace MQTTSNGW;
 
+namespace MQTTSNGW
+{
+class IOUring;
+}
+
+/*========================================
+ Class TCPLoopback
+
+ Stands in for the broker of every TCPStack::connect() once set,
+ see TCPStack::setLoopback() and LoopbackBroker.
+ =======================================*/
+class TCPLoopback
+{
+public:
+	virtual ~TCPLoopback() {}
+	virtual int connect(const char* host, const char* service) = 0;   // the socket of a new connection, -1 on error
+};
+
 /*========================================
  Class TCPStack
  =======================================*/
@@ -46,6 +66,7 @@ public:
 
 	// Client initialization
 	bool connect(const char* host, const char* service);
+	void takeOver(TCPStack& other);
 
 	int send(const uint8_t* buf, int length);
 	int recv(uint8_t* buf, int len);
@@ -56,15 +77,59 @@ public:
 	bool isValid();
 	int getSock();
 
+	static void setLoopback(TCPLoopback* loopback);
+
 private:
+	static TCPLoopback* _loopback;
 	int _sockfd;
 	addrinfo* _addrinfo;
 	Mutex _mutex;
 };
 
+/*========================================
+ Class TLSSessionCache
+ =======================================*/
+#define TLS_SESSION_CACHE_SIZE   8   // Number of broker endpoints whose SSL_CTX and session are kept
+
+class TLSSessionCache
+{
+public:
+	TLSSessionCache();
+	~TLSSessionCache();
+
+	SSL_CTX* getContext(const char* endpoint);
+	SSL_CTX* putContext(const char* endpoint, SSL_CTX* ctx);
+	SSL_SESSION* getSession(const char* endpoint);
+	void putSession(const char* endpoint, SSL_SESSION* session);
+	void removeSession(const char* endpoint);
+	void clear(void);
+
+	void countHandshake(bool resumed);
+	uint32_t getFullHandshakes(void);
+	uint32_t getResumedHandshakes(void);
+
+private:
+	struct Entry
+	{
+		string endpoint;
+		SSL_CTX* ctx;
+		SSL_SESSION* session;
+		uint32_t lastUse;
+	};
+	Entry* find(const char* endpoint);
+
+	Entry _entries[TLS_SESSION_CACHE_SIZE];
+	uint32_t _useCnt;
+	uint32_t _fullHandshakes;
+	uint32_t _resumedHandshakes;
+	Mutex _mutex;
+};
+
 /*========================================
  Class Network
  =======================================*/
+#define NETWORK_SEND_BUFFER_SIZE  4096   // Queued packets are written together up to this size
+
 class Network: public TCPStack
 {
 public:
@@ -73,23 +138,63 @@ public:
 
 	bool connect(const char* host, const char* port, const char* caPath, const char* caFile, const char* cert, const char* prvkey);
 	bool connect(const char* host, const char* port);
+	bool takeOver(Network* other);
 	void close(void);
 	int  send(const uint8_t* buf, uint16_t length);
+	int  queue(const uint8_t* buf, uint16_t length, uint32_t latency, bool* first = nullptr, bool nowait = false);
+	bool hasRoom(int length);
+	int  flush(void);
+	bool flush(IOUring* ring, uint64_t userData);
+	int  flushed(int res);
+	bool isQueued(void);
+	bool isFlushDue(void);
 	int  recv(uint8_t* buf, uint16_t len);
+	void feed(const uint8_t* data, int length);
+	bool isReceived(void);
+	uint32_t getWriteCnt(void);
+	uint32_t getCloseCnt(void);
+
+	void addBacklog(int length);
+	uint32_t getBacklog(void);
+	void addInflight(int cnt);
+	uint16_t getInflight(void);
+	bool isCongested(uint32_t maxBacklog, uint16_t maxInflight);
 
 	bool isValid(void);
 	bool isSecure(void);
 	int  getSock(void);
 
+	static TLSSessionCache* getSessionCache(void);
+
 private:
-	static SSL_CTX* _ctx;
-	static SSL_SESSION* _session;
-	static int _numOfInstance;
+	static SSL_CTX* createContext(const char* caPath, const char* caFile, const char* cert, const char* prvkey);
+	static int newSession(SSL* ssl, SSL_SESSION* session);
+	int  write(const uint8_t* buf, int length);
+	void emptied(void);
+
+	string _endpoint;
 	SSL* _ssl;
 	bool _secureFlg;
 	Mutex _mutex;
 	bool _busy;
 	bool _sslValid;
+	uint8_t* _sendBuf;
+	int _sendLen;
+	Timer _sendTimer;
+	uint8_t* _ringBuf;     // bytes of the write in flight on BrokerSendTask's IOUring
+	int _ringLen;
+	uint32_t _ringCloseCnt;  // _closeCnt of the connection the write was prepared for
+	uint32_t _writeCnt;
+	uint32_t _closeCnt;    // tells a new connection from a closed one that had the same socket number
+	uint8_t* _recvBuf;     // bytes received through an IOUring, read by recv()
+	int _recvSize;
+	int _recvLen;
+	int _recvPos;
+	uint32_t _recvCloseCnt;  // _closeCnt of the connection the bytes were received from
+	Mutex _flowMutex;
+	uint32_t _backlog;     // bytes of the packets posted to this connection and not yet written
+	uint32_t _sendBacklog; // bytes of the send buffer counted in _backlog, see queue()
+	uint16_t _inflight;    // QoS 1 and 2 PUBLISHes not yet acknowledged by the broker
 };
 
 #endif /* NETWORK_H_ */
@@ -0,0 +1,423 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - pcap capture of the sensor network
+ **************************************************************************************/
+
+
+#include "SensorNetCapture.h"
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include <netinet/in.h>
+
+using namespace MQTTSNGW;
+
+#define PCAP_MAGIC_USECS       0xa1b2c3d4
+#define PCAP_MAGIC_NSECS       0xa1b23c4d
+#define PCAP_LINKTYPE_ETHERNET   1
+#define PCAP_LINKTYPE_RAW      101
+#define PCAP_LINKTYPE_IPV4     228
+#define PCAP_MAX_RECORD     262144   // a longer record is taken for a broken file
+#define CAPTURE_HEADER_SIZE     28   // IPv4 and UDP headers written before each datagram
+
+/*=====================================
+ Class SensorNetCapture
+ =====================================*/
+SensorNetCapture::SensorNetCapture()
+{
+	_fp = nullptr;
+	_slots = nullptr;
+	_head = 0;
+	_tail = 0;
+	_recordCnt = 0;
+	_dropCnt = 0;
+	_ipId = 0;
+	_open = false;
+	_stop = false;
+}
+
+SensorNetCapture::~SensorNetCapture()
+{
+	close();
+	if (_slots)
+	{
+		free(_slots);
+	}
+}
+
+/**
+ *  Create the file and start the thread writing it.
+ *  @return false when the file can't be created
+ */
+bool SensorNetCapture::open(const char* fileName)
+{
+	if (_open)
+	{
+		return false;
+	}
+	if (_slots == nullptr && (_slots = (SensorNetCaptureSlot*)malloc(sizeof(SensorNetCaptureSlot) * CAPTURE_RING_SIZE)) == nullptr)
+	{
+		return false;
+	}
+	if ((_fp = fopen(fileName, "wb")) == nullptr)
+	{
+		return false;
+	}
+	setvbuf(_fp, nullptr, _IOFBF, CAPTURE_FILE_BUFFER);
+
+	/* pcap file header, in the byte order of this host */
+	uint32_t header[6] = { PCAP_MAGIC_NSECS, 0x00040002, 0, 0, CAPTURE_SNAPLEN + CAPTURE_HEADER_SIZE, PCAP_LINKTYPE_IPV4 };
+	fwrite(header, sizeof(header), 1, _fp);
+
+	for (uint32_t i = 0; i < CAPTURE_RING_SIZE; i++)
+	{
+		_slots[i].seq = i;
+	}
+	_head = 0;
+	_tail = 0;
+	_stop = false;
+	__atomic_store_n(&_open, true, __ATOMIC_RELEASE);
+	if (start() != 0)
+	{
+		_open = false;
+		fclose(_fp);
+		_fp = nullptr;
+		return false;
+	}
+	return true;
+}
+
+/**
+ *  Write the datagrams left in the ring and close the file.
+ *  record() may still be called, the datagrams are not written.
+ */
+void SensorNetCapture::close(void)
+{
+	if (!_open)
+	{
+		return;
+	}
+	__atomic_store_n(&_open, false, __ATOMIC_RELEASE);
+	__atomic_store_n(&_stop, true, __ATOMIC_RELEASE);
+	stop();
+	write();
+	fclose(_fp);
+	_fp = nullptr;
+}
+
+bool SensorNetCapture::isOpen(void)
+{
+	return __atomic_load_n(&_open, __ATOMIC_ACQUIRE);
+}
+
+/**
+ *  Copy a datagram into the ring, called by any thread.
+ *  A slot is taken with a compare-and-swap on _head and handed to the writer
+ *  by its sequence number, as in a bounded multi-producer queue.
+ *  @return false when the ring is full and the datagram is dropped
+ */
+bool SensorNetCapture::record(uint32_t srcAddress, uint16_t srcPort, uint32_t dstAddress, uint16_t dstPort, const uint8_t* data, int length)
+{
+	if (!__atomic_load_n(&_open, __ATOMIC_ACQUIRE) || length < 0)
+	{
+		return false;
+	}
+
+	SensorNetCaptureSlot* slot;
+	uint32_t pos = __atomic_load_n(&_head, __ATOMIC_RELAXED);
+	while (true)
+	{
+		slot = &_slots[pos & (CAPTURE_RING_SIZE - 1)];
+		int32_t dif = (int32_t)(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) - pos);
+		if (dif == 0)
+		{
+			if (__atomic_compare_exchange_n(&_head, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+			{
+				break;
+			}
+		}
+		else if (dif < 0)
+		{
+			__atomic_add_fetch(&_dropCnt, 1, __ATOMIC_RELAXED);
+			return false;
+		}
+		else
+		{
+			pos = __atomic_load_n(&_head, __ATOMIC_RELAXED);
+		}
+	}
+
+	struct timespec ts;
+	clock_gettime(CLOCK_REALTIME, &ts);
+	int len = (length > CAPTURE_SNAPLEN) ? CAPTURE_SNAPLEN : length;
+	slot->rec.nsecs = (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+	slot->rec.srcAddress = srcAddress;
+	slot->rec.srcPort = srcPort;
+	slot->rec.dstAddress = dstAddress;
+	slot->rec.dstPort = dstPort;
+	slot->rec.length = len;
+	slot->rec.origLength = length;
+	slot->rec.data = slot->data;
+	memcpy(slot->data, data, len);
+	__atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+	return true;
+}
+
+/**
+ *  Datagrams written to the file.
+ */
+uint32_t SensorNetCapture::getRecordCnt(void)
+{
+	return __atomic_load_n(&_recordCnt, __ATOMIC_RELAXED);
+}
+
+/**
+ *  Datagrams dropped because the ring was full.
+ */
+uint32_t SensorNetCapture::getDropCnt(void)
+{
+	return __atomic_load_n(&_dropCnt, __ATOMIC_RELAXED);
+}
+
+/*
+ *  The writer thread. The file is flushed whenever the ring is empty.
+ */
+void SensorNetCapture::EXECRUN(void)
+{
+	while (!__atomic_load_n(&_stop, __ATOMIC_ACQUIRE))
+	{
+		if (write() == 0)
+		{
+			fflush(_fp);
+			usleep(CAPTURE_WRITE_INTERVAL * 1000);
+		}
+	}
+}
+
+/*
+ *  Write the datagrams recorded so far.
+ *  @return number of datagrams written
+ */
+int SensorNetCapture::write(void)
+{
+	uint8_t hdr[16 + CAPTURE_HEADER_SIZE];
+	int cnt = 0;
+
+	while (true)
+	{
+		SensorNetCaptureSlot* slot = &_slots[_tail & (CAPTURE_RING_SIZE - 1)];
+		if ((int32_t)(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) - (_tail + 1)) < 0)
+		{
+			break;
+		}
+		SensorNetRecord* rec = &slot->rec;
+
+		/* pcap record header */
+		uint32_t* recHdr = (uint32_t*)hdr;
+		recHdr[0] = (uint32_t)(rec->nsecs / 1000000000ULL);
+		recHdr[1] = (uint32_t)(rec->nsecs % 1000000000ULL);
+		recHdr[2] = CAPTURE_HEADER_SIZE + rec->length;
+		recHdr[3] = CAPTURE_HEADER_SIZE + rec->origLength;
+
+		/* IPv4 header */
+		uint8_t* ip = hdr + 16;
+		uint16_t ipLength = CAPTURE_HEADER_SIZE + rec->origLength;
+		memset(ip, 0, 20);
+		ip[0] = 0x45;
+		ip[2] = ipLength >> 8;
+		ip[3] = ipLength & 0xff;
+		ip[4] = _ipId >> 8;
+		ip[5] = _ipId & 0xff;
+		ip[8] = 64;
+		ip[9] = IPPROTO_UDP;
+		memcpy(ip + 12, &rec->srcAddress, 4);
+		memcpy(ip + 16, &rec->dstAddress, 4);
+		uint32_t sum = 0;
+		for (int i = 0; i < 20; i += 2)
+		{
+			sum += (ip[i] << 8) | ip[i + 1];
+		}
+		sum = (sum & 0xffff) + (sum >> 16);
+		sum = ~(sum + (sum >> 16)) & 0xffff;
+		ip[10] = sum >> 8;
+		ip[11] = sum & 0xff;
+		_ipId++;
+
+		/* UDP header, without a checksum */
+		uint8_t* udp = ip + 20;
+		uint16_t udpLength = 8 + rec->origLength;
+		memcpy(udp, &rec->srcPort, 2);
+		memcpy(udp + 2, &rec->dstPort, 2);
+		udp[4] = udpLength >> 8;
+		udp[5] = udpLength & 0xff;
+		udp[6] = 0;
+		udp[7] = 0;
+
+		fwrite(hdr, sizeof(hdr), 1, _fp);
+		fwrite(slot->data, rec->length, 1, _fp);
+		__atomic_store_n(&slot->seq, _tail + CAPTURE_RING_SIZE, __ATOMIC_RELEASE);
+		_tail++;
+		cnt++;
+	}
+	if (cnt)
+	{
+		__atomic_add_fetch(&_recordCnt, cnt, __ATOMIC_RELAXED);
+	}
+	return cnt;
+}
+
+/*=====================================
+ Class SensorNetCaptureReader
+ =====================================*/
+SensorNetCaptureReader::SensorNetCaptureReader()
+{
+	_fp = nullptr;
+	_swapped = false;
+	_nsecs = false;
+	_linkType = 0;
+	_buf = nullptr;
+	_bufSize = 0;
+}
+
+SensorNetCaptureReader::~SensorNetCaptureReader()
+{
+	close();
+	if (_buf)
+	{
+		free(_buf);
+	}
+}
+
+/**
+ *  @return false when the file is not a pcap file of a link type it can read
+ */
+bool SensorNetCaptureReader::open(const char* fileName)
+{
+	uint8_t header[24];
+
+	close();
+	if ((_fp = fopen(fileName, "rb")) == nullptr)
+	{
+		return false;
+	}
+	if (fread(header, sizeof(header), 1, _fp) == 1)
+	{
+		uint32_t magic;
+		memcpy(&magic, header, 4);
+		_swapped = (magic == __builtin_bswap32(PCAP_MAGIC_USECS) || magic == __builtin_bswap32(PCAP_MAGIC_NSECS));
+		magic = get32(header);
+		_nsecs = (magic == PCAP_MAGIC_NSECS);
+		_linkType = get32(header + 20) & 0xffff;
+		if ((magic == PCAP_MAGIC_USECS || magic == PCAP_MAGIC_NSECS)
+				&& (_linkType == PCAP_LINKTYPE_ETHERNET || _linkType == PCAP_LINKTYPE_RAW || _linkType == PCAP_LINKTYPE_IPV4))
+		{
+			return true;
+		}
+	}
+	close();
+	return false;
+}
+
+void SensorNetCaptureReader::close(void)
+{
+	if (_fp)
+	{
+		fclose(_fp);
+		_fp = nullptr;
+	}
+}
+
+/**
+ *  Read the next UDP datagram. rec->data stays valid until the next call.
+ *  @return false at the end of the file
+ */
+bool SensorNetCaptureReader::next(SensorNetRecord* rec)
+{
+	uint8_t hdr[16];
+
+	while (_fp && fread(hdr, sizeof(hdr), 1, _fp) == 1)
+	{
+		uint32_t recLength = get32(hdr + 8);
+		if (recLength > PCAP_MAX_RECORD)
+		{
+			return false;
+		}
+		if (recLength > _bufSize)
+		{
+			uint8_t* buf = (uint8_t*)realloc(_buf, recLength);
+			if (buf == nullptr)
+			{
+				return false;
+			}
+			_buf = buf;
+			_bufSize = recLength;
+		}
+		if (recLength && fread(_buf, recLength, 1, _fp) != 1)
+		{
+			return false;
+		}
+
+		uint8_t* ip = _buf;
+		int len = recLength;
+		if (_linkType == PCAP_LINKTYPE_ETHERNET)
+		{
+			int offset = 14;
+			if (len >= 18 && ip[12] == 0x81 && ip[13] == 0x00)
+			{
+				offset = 18;     // 802.1Q tag
+			}
+			if (len < offset || ip[offset - 2] != 0x08 || ip[offset - 1] != 0x00)
+			{
+				continue;
+			}
+			ip += offset;
+			len -= offset;
+		}
+		if (len < 20 || (ip[0] >> 4) != 4 || ip[9] != IPPROTO_UDP || (((ip[6] & 0x3f) << 8) | ip[7]) != 0)
+		{
+			continue;
+		}
+		int ihl = (ip[0] & 0x0f) * 4;
+		if (ihl < 20 || len < ihl + 8)
+		{
+			continue;
+		}
+		uint8_t* udp = ip + ihl;
+		int udpLength = (udp[4] << 8) | udp[5];
+		if (udpLength < 8)
+		{
+			continue;
+		}
+
+		uint64_t frac = get32(hdr + 4);
+		rec->nsecs = (uint64_t)get32(hdr) * 1000000000ULL + (_nsecs ? frac : frac * 1000);
+		memcpy(&rec->srcAddress, ip + 12, 4);
+		memcpy(&rec->dstAddress, ip + 16, 4);
+		memcpy(&rec->srcPort, udp, 2);
+		memcpy(&rec->dstPort, udp + 2, 2);
+		rec->origLength = udpLength - 8;
+		rec->length = (len - ihl - 8 < rec->origLength) ? len - ihl - 8 : rec->origLength;
+		rec->data = udp + 8;
+		return true;
+	}
+	return false;
+}
+
+uint32_t SensorNetCaptureReader::get32(const uint8_t* pos)
+{
+	uint32_t val;
+	memcpy(&val, pos, 4);
+	return _swapped ? __builtin_bswap32(val) : val;
+}
@@ -0,0 +1,120 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - pcap capture of the sensor network
+ **************************************************************************************/
+
+#ifndef MQTTSNGATEWAY_SRC_LINUX_SENSORNETCAPTURE_H_
+#define MQTTSNGATEWAY_SRC_LINUX_SENSORNETCAPTURE_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include "Threading.h"
+
+namespace MQTTSNGW
+{
+
+#define CAPTURE_RING_SIZE       4096   // Datagrams waiting to be written, a power of 2. More are dropped, not waited for
+#define CAPTURE_SNAPLEN         MQTTSNGW_MAX_PACKET_SIZE   // Bytes of a datagram kept, a longer one is truncated
+#define CAPTURE_WRITE_INTERVAL     2   // msecs the writer sleeps when there is nothing to write
+#define CAPTURE_FILE_BUFFER    65536   // bytes written to the file at once
+
+/* A datagram, as recorded by SensorNetCapture or read by SensorNetCaptureReader */
+typedef struct
+{
+	uint64_t nsecs;         // time it was received or sent, nanosecs since the epoch
+	uint32_t srcAddress;    // addresses and ports in network byte order, 0.0.0.0 for the gateway's own unicast address
+	uint16_t srcPort;
+	uint32_t dstAddress;
+	uint16_t dstPort;
+	uint16_t length;        // bytes in data, may be less than origLength
+	uint16_t origLength;
+	const uint8_t* data;
+} SensorNetRecord;
+
+/* A slot of the ring, filled by record() and emptied by the writer */
+typedef struct
+{
+	uint32_t seq;
+	SensorNetRecord rec;
+	uint8_t data[CAPTURE_SNAPLEN];
+} SensorNetCaptureSlot;
+
+/*=====================================
+ Class SensorNetCapture
+
+ Records the datagrams a SensorNetwork receives and sends into a pcap file, CaptureFile=.
+ record() copies a datagram into a ring without a lock or a syscall, so that it can be
+ called from ClientRecvTask and ClientSendTask at once, and a thread of its own writes
+ the ring to the file with an IPv4 and a UDP header for each datagram (LINKTYPE_IPV4,
+ nanosec timestamps). A datagram finding the ring full is dropped and counted.
+ =====================================*/
+class SensorNetCapture : public Thread
+{
+public:
+	SensorNetCapture();
+	~SensorNetCapture();
+
+	bool open(const char* fileName);
+	void close(void);
+	bool isOpen(void);
+	bool record(uint32_t srcAddress, uint16_t srcPort, uint32_t dstAddress, uint16_t dstPort, const uint8_t* data, int length);
+	uint32_t getRecordCnt(void);
+	uint32_t getDropCnt(void);
+	void EXECRUN(void);
+
+private:
+	int write(void);
+
+	FILE* _fp;
+	SensorNetCaptureSlot* _slots;
+	uint32_t _head;          // next slot record() takes
+	uint32_t _tail;          // next slot the writer reads
+	uint32_t _recordCnt;
+	uint32_t _dropCnt;
+	uint16_t _ipId;
+	bool _open;
+	bool _stop;
+};
+
+/*=====================================
+ Class SensorNetCaptureReader
+
+ Reads the UDP datagrams over IPv4 of a pcap file, written by SensorNetCapture or
+ by tcpdump (LINKTYPE_ETHERNET, RAW or IPV4, microsec or nanosec timestamps).
+ Other packets and fragments are skipped.
+ =====================================*/
+class SensorNetCaptureReader
+{
+public:
+	SensorNetCaptureReader();
+	~SensorNetCaptureReader();
+
+	bool open(const char* fileName);
+	void close(void);
+	bool next(SensorNetRecord* rec);
+
+private:
+	uint32_t get32(const uint8_t* pos);
+
+	FILE* _fp;
+	bool _swapped;
+	bool _nsecs;
+	uint32_t _linkType;
+	uint8_t* _buf;
+	uint32_t _bufSize;
+};
+
+}
+
+#endif /* MQTTSNGATEWAY_SRC_LINUX_SENSORNETCAPTURE_H_ */
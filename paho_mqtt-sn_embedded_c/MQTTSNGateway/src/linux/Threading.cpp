@@ -233,7 +233,12 @@ void Semaphore::timedwait(uint16_t millsec)
 	struct timespec ts;
 	clock_gettime(CLOCK_REALTIME, &ts);
 	ts.tv_sec += millsec / 1000;
-	ts.tv_nsec = (millsec % 1000) * 1000000;
+	ts.tv_nsec += (millsec % 1000) * 1000000;
+	if (ts.tv_nsec >= 1000000000)
+	{
+		ts.tv_sec++;
+		ts.tv_nsec -= 1000000000;
+	}
 	if (_psem)
 	{
 		sem_timedwait(_psem, &ts);
@@ -0,0 +1,615 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - in-process broker for the benchmark
+ **************************************************************************************/
+
+#include "LoopbackBroker.h"
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+
+using namespace MQTTSNGW;
+
+/* MQTT 3.1.1 packet types, the high nibble of the first byte */
+#define MQTT_CONNECT      1
+#define MQTT_PUBLISH      3
+#define MQTT_PUBREL       6
+#define MQTT_SUBSCRIBE    8
+#define MQTT_UNSUBSCRIBE 10
+#define MQTT_PINGREQ     12
+#define MQTT_DISCONNECT  14
+
+/*=====================================
+ Class LoopbackBroker
+ =====================================*/
+LoopbackBroker::LoopbackBroker()
+{
+	memset(_conns, 0, sizeof(_conns));
+	for (int i = 0; i < LOOPBACK_BROKER_MAX_CONNECTIONS; i++)
+	{
+		_conns[i].sock = -1;
+	}
+	_wakeup[0] = -1;
+	_wakeup[1] = -1;
+	_connectionCnt = 0;
+	_publishedCnt = 0;
+	_deliveredCnt = 0;
+	_open = false;
+	_stop = false;
+}
+
+LoopbackBroker::~LoopbackBroker()
+{
+	close();
+	for (int i = 0; i < LOOPBACK_BROKER_MAX_CONNECTIONS; i++)
+	{
+		free(_conns[i].in);
+		free(_conns[i].out);
+	}
+}
+
+/**
+ *  Start the thread serving the connections.
+ *  @return false when it can't be started
+ */
+bool LoopbackBroker::open(void)
+{
+	if (_open)
+	{
+		return false;
+	}
+	if (pipe(_wakeup) < 0)
+	{
+		return false;
+	}
+	fcntl(_wakeup[0], F_SETFL, O_NONBLOCK);
+	fcntl(_wakeup[1], F_SETFL, O_NONBLOCK);
+	_stop = false;
+	if (start() != 0)
+	{
+		::close(_wakeup[0]);
+		::close(_wakeup[1]);
+		return false;
+	}
+	_open = true;
+	return true;
+}
+
+/**
+ *  Stop the thread and close the connections left.
+ */
+void LoopbackBroker::close(void)
+{
+	if (!_open)
+	{
+		return;
+	}
+	__atomic_store_n(&_stop, true, __ATOMIC_RELEASE);
+	char c = 0;
+	if (::write(_wakeup[1], &c, 1) < 0)
+	{
+		// the pipe is full, the thread is awake anyway
+	}
+	stop();
+	for (int i = 0; i < LOOPBACK_BROKER_MAX_CONNECTIONS; i++)
+	{
+		release(&_conns[i]);
+	}
+	::close(_wakeup[0]);
+	::close(_wakeup[1]);
+	_open = false;
+}
+
+/**
+ *  TCPLoopback, called by TCPStack::connect() in the gateway's threads.
+ *  @return the gateway's end of a new connection, -1 when there are too many of them
+ */
+int LoopbackBroker::connect(const char* host, const char* service)
+{
+	int socks[2];
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, socks) < 0)
+	{
+		return -1;
+	}
+	fcntl(socks[1], F_SETFL, O_NONBLOCK);
+
+	int rc = -1;
+	_mutex.lock();
+	for (int i = 0; i < LOOPBACK_BROKER_MAX_CONNECTIONS; i++)
+	{
+		if (_conns[i].sock < 0)
+		{
+			_conns[i].sock = socks[1];
+			_conns[i].inLen = 0;
+			_conns[i].outLen = 0;
+			rc = socks[0];
+			break;
+		}
+	}
+	_mutex.unlock();
+
+	if (rc < 0)
+	{
+		::close(socks[0]);
+		::close(socks[1]);
+		return -1;
+	}
+	__atomic_add_fetch(&_connectionCnt, 1, __ATOMIC_RELAXED);
+	char c = 0;
+	if (::write(_wakeup[1], &c, 1) < 0)
+	{
+		// the pipe is full, the thread will poll the new connection anyway
+	}
+	return rc;
+}
+
+uint32_t LoopbackBroker::getConnectionCnt(void)
+{
+	return __atomic_load_n(&_connectionCnt, __ATOMIC_RELAXED);
+}
+
+uint32_t LoopbackBroker::getPublishedCnt(void)
+{
+	return __atomic_load_n(&_publishedCnt, __ATOMIC_RELAXED);
+}
+
+uint32_t LoopbackBroker::getDeliveredCnt(void)
+{
+	return __atomic_load_n(&_deliveredCnt, __ATOMIC_RELAXED);
+}
+
+/*
+ *  The thread. Reads every connection and writes what is left to write,
+ *  the connections made meanwhile wake it through the pipe.
+ */
+void LoopbackBroker::EXECRUN(void)
+{
+	struct pollfd fds[LOOPBACK_BROKER_MAX_CONNECTIONS + 1];
+	int index[LOOPBACK_BROKER_MAX_CONNECTIONS + 1];
+
+	while (!__atomic_load_n(&_stop, __ATOMIC_ACQUIRE))
+	{
+		int nfds = 0;
+		fds[nfds].fd = _wakeup[0];
+		fds[nfds].events = POLLIN;
+		index[nfds++] = -1;
+
+		_mutex.lock();
+		for (int i = 0; i < LOOPBACK_BROKER_MAX_CONNECTIONS; i++)
+		{
+			if (_conns[i].sock >= 0)
+			{
+				fds[nfds].fd = _conns[i].sock;
+				fds[nfds].events = POLLIN | (_conns[i].outLen ? POLLOUT : 0);
+				index[nfds++] = i;
+			}
+		}
+		_mutex.unlock();
+
+		if (poll(fds, nfds, LOOPBACK_BROKER_POLL_INTERVAL) <= 0)
+		{
+			continue;
+		}
+
+		if (fds[0].revents & POLLIN)
+		{
+			char buf[64];
+			while (read(_wakeup[0], buf, sizeof(buf)) > 0)
+			{
+				;
+			}
+		}
+
+		for (int i = 1; i < nfds; i++)
+		{
+			LoopbackConnection* conn = &_conns[index[i]];
+			if (fds[i].revents & POLLOUT)
+			{
+				flush(conn);
+			}
+			if (conn->sock >= 0 && (fds[i].revents & (POLLIN | POLLHUP | POLLERR)))
+			{
+				if (readPackets(conn) < 0)
+				{
+					release(conn);
+				}
+			}
+		}
+
+		/* the deliveries to the connections polled before the publisher */
+		for (int i = 1; i < nfds; i++)
+		{
+			LoopbackConnection* conn = &_conns[index[i]];
+			if (conn->sock >= 0 && conn->outLen)
+			{
+				flush(conn);
+			}
+		}
+	}
+}
+
+/*
+ *  Read what a connection has sent and handle the complete packets.
+ *  @return -1 when the connection is closed
+ */
+int LoopbackBroker::readPackets(LoopbackConnection* conn)
+{
+	while (true)
+	{
+		if (conn->inSize - conn->inLen < LOOPBACK_BROKER_BUFFER_SIZE)
+		{
+			uint32_t size = conn->inSize ? conn->inSize * 2 : LOOPBACK_BROKER_BUFFER_SIZE * 2;
+			uint8_t* in = (uint8_t*)realloc(conn->in, size);
+			if (in == nullptr)
+			{
+				return -1;
+			}
+			conn->in = in;
+			conn->inSize = size;
+		}
+
+		ssize_t len = recv(conn->sock, conn->in + conn->inLen, conn->inSize - conn->inLen, 0);
+		if (len == 0)
+		{
+			return -1;
+		}
+		if (len < 0)
+		{
+			return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? 0 : -1;
+		}
+		conn->inLen += len;
+
+		uint32_t pos = 0;
+		while (pos < conn->inLen)
+		{
+			/* fixed header, the remaining length takes 1 to 4 bytes */
+			uint32_t remainingLength = 0;
+			uint32_t multiplier = 1;
+			uint32_t headerLength = 1;
+			bool complete = false;
+			while (pos + headerLength < conn->inLen && headerLength <= 4)
+			{
+				uint8_t c = conn->in[pos + headerLength++];
+				remainingLength += (c & 0x7f) * multiplier;
+				multiplier *= 128;
+				if ((c & 0x80) == 0)
+				{
+					complete = true;
+					break;
+				}
+			}
+			if (!complete)
+			{
+				if (headerLength > 4)
+				{
+					return -1;
+				}
+				break;
+			}
+			if (headerLength + remainingLength > LOOPBACK_BROKER_MAX_PACKET)
+			{
+				return -1;
+			}
+			if (pos + headerLength + remainingLength > conn->inLen)
+			{
+				break;
+			}
+			if (handle(conn, conn->in + pos, headerLength + remainingLength, headerLength) < 0)
+			{
+				return -1;
+			}
+			pos += headerLength + remainingLength;
+		}
+		if (pos)
+		{
+			memmove(conn->in, conn->in + pos, conn->inLen - pos);
+			conn->inLen -= pos;
+		}
+	}
+}
+
+/*
+ *  Answer a packet.
+ *  @return -1 to close the connection
+ */
+int LoopbackBroker::handle(LoopbackConnection* conn, uint8_t* packet, uint32_t length, uint32_t headerLength)
+{
+	uint8_t* ptr = packet + headerLength;
+	uint8_t* end = packet + length;
+	uint8_t ack[5];
+
+	switch (packet[0] >> 4)
+	{
+	case MQTT_CONNECT:
+	{
+		ack[0] = 0x20;
+		ack[1] = 2;
+		ack[2] = 0;
+		ack[3] = 0;
+		return write(conn, ack, 4) ? 0 : -1;
+	}
+	case MQTT_PUBLISH:
+	{
+		uint8_t qos = (packet[0] >> 1) & 0x03;
+		if (end - ptr < 2)
+		{
+			return -1;
+		}
+		uint16_t topicLength = (ptr[0] << 8) + ptr[1];
+		uint8_t* payload = ptr + 2 + topicLength + (qos ? 2 : 0);
+		if (payload > end)
+		{
+			return -1;
+		}
+		received(ptr + 2, topicLength, payload, end - payload);
+		__atomic_add_fetch(&_publishedCnt, 1, __ATOMIC_RELAXED);
+		if (qos)
+		{
+			ack[0] = (qos == 1) ? 0x40 : 0x50;    // PUBACK, PUBREC
+			ack[1] = 2;
+			ack[2] = payload[-2];
+			ack[3] = payload[-1];
+			if (!write(conn, ack, 4))
+			{
+				return -1;
+			}
+		}
+		publish(packet, length, headerLength);
+		return 0;
+	}
+	case MQTT_PUBREL:
+	{
+		if (end - ptr < 2)
+		{
+			return -1;
+		}
+		ack[0] = 0x70;   // PUBCOMP
+		ack[1] = 2;
+		ack[2] = ptr[0];
+		ack[3] = ptr[1];
+		return write(conn, ack, 4) ? 0 : -1;
+	}
+	case MQTT_SUBSCRIBE:
+	case MQTT_UNSUBSCRIBE:
+	{
+		bool sub = ((packet[0] >> 4) == MQTT_SUBSCRIBE);
+		if (end - ptr < 2)
+		{
+			return -1;
+		}
+		uint8_t* packetId = ptr;
+		uint8_t rcs[64];
+		uint32_t cnt = 0;
+		for (ptr += 2; ptr + 2 <= end && cnt < sizeof(rcs);)
+		{
+			uint16_t filterLength = (ptr[0] << 8) + ptr[1];
+			if (ptr + 2 + filterLength + (sub ? 1 : 0) > end)
+			{
+				return -1;
+			}
+			if (sub)
+			{
+				rcs[cnt++] = subscribe(conn, ptr + 2, filterLength) ? 0 : 0x80;    // granted QoS 0
+				ptr += 3 + filterLength;
+			}
+			else
+			{
+				unsubscribe(conn, ptr + 2, filterLength);
+				ptr += 2 + filterLength;
+			}
+		}
+		ack[0] = sub ? 0x90 : 0xB0;   // SUBACK, UNSUBACK
+		ack[1] = 2 + cnt;
+		ack[2] = packetId[0];
+		ack[3] = packetId[1];
+		return (write(conn, ack, 4) && write(conn, rcs, cnt)) ? 0 : -1;
+	}
+	case MQTT_PINGREQ:
+	{
+		ack[0] = 0xD0;   // PINGRESP
+		ack[1] = 0;
+		return write(conn, ack, 2) ? 0 : -1;
+	}
+	case MQTT_DISCONNECT:
+		return -1;
+	default:
+		return 0;       // PUBACK, PUBREC, PUBCOMP of nothing this broker has sent
+	}
+}
+
+/*
+ *  Deliver a PUBLISH with QoS 0 to the matching subscriptions, once per connection.
+ */
+void LoopbackBroker::publish(uint8_t* packet, uint32_t length, uint32_t headerLength)
+{
+	uint8_t* ptr = packet + headerLength;
+	uint8_t qos = (packet[0] >> 1) & 0x03;
+	uint16_t topicLength = (ptr[0] << 8) + ptr[1];
+	uint8_t* topic = ptr + 2;
+	uint8_t* payload = topic + topicLength + (qos ? 2 : 0);
+	uint32_t remainingLength = 2 + topicLength + (packet + length - payload);
+
+	uint8_t header[5];
+	uint32_t hlen = 1;
+	header[0] = 0x30 | (packet[0] & 0x01);   // keep RETAIN
+	do
+	{
+		uint8_t c = remainingLength % 128;
+		remainingLength /= 128;
+		header[hlen++] = c | (remainingLength ? 0x80 : 0);
+	} while (remainingLength);
+
+	for (int i = 0; i < LOOPBACK_BROKER_MAX_CONNECTIONS; i++)
+	{
+		LoopbackConnection* conn = &_conns[i];
+		if (conn->sock < 0)
+		{
+			continue;
+		}
+		for (LoopbackSubscription* sub = conn->subscriptions; sub; sub = sub->next)
+		{
+			if (isMatch(sub->filter, topic, topicLength))
+			{
+				if (write(conn, header, hlen) && write(conn, ptr, topicLength + 2) && write(conn, payload, packet + length - payload))
+				{
+					__atomic_add_fetch(&_deliveredCnt, 1, __ATOMIC_RELAXED);
+				}
+				break;
+			}
+		}
+	}
+}
+
+/**
+ *  Match a topic against an MQTT topic filter with + and # wildcards.
+ */
+bool LoopbackBroker::isMatch(const char* filter, const uint8_t* topic, uint16_t topicLength)
+{
+	const uint8_t* end = topic + topicLength;
+	while (*filter)
+	{
+		if (*filter == '#')
+		{
+			return true;
+		}
+		if (*filter == '+')
+		{
+			while (topic < end && *topic != '/')
+			{
+				topic++;
+			}
+			filter++;
+		}
+		else
+		{
+			if (topic == end || *filter != *topic)
+			{
+				/* "a/#" matches "a" too */
+				return (topic == end && filter[0] == '/' && filter[1] == '#' && filter[2] == 0);
+			}
+			filter++;
+			topic++;
+		}
+	}
+	return (topic == end);
+}
+
+bool LoopbackBroker::subscribe(LoopbackConnection* conn, const uint8_t* filter, uint16_t length)
+{
+	for (LoopbackSubscription* sub = conn->subscriptions; sub; sub = sub->next)
+	{
+		if (strlen(sub->filter) == length && memcmp(sub->filter, filter, length) == 0)
+		{
+			return true;
+		}
+	}
+	LoopbackSubscription* sub = (LoopbackSubscription*)malloc(sizeof(LoopbackSubscription));
+	if (sub == nullptr || (sub->filter = (char*)malloc(length + 1)) == nullptr)
+	{
+		free(sub);
+		return false;
+	}
+	memcpy(sub->filter, filter, length);
+	sub->filter[length] = 0;
+	sub->next = conn->subscriptions;
+	conn->subscriptions = sub;
+	return true;
+}
+
+void LoopbackBroker::unsubscribe(LoopbackConnection* conn, const uint8_t* filter, uint16_t length)
+{
+	for (LoopbackSubscription** pp = &conn->subscriptions; *pp; pp = &(*pp)->next)
+	{
+		LoopbackSubscription* sub = *pp;
+		if (strlen(sub->filter) == length && memcmp(sub->filter, filter, length) == 0)
+		{
+			*pp = sub->next;
+			free(sub->filter);
+			free(sub);
+			return;
+		}
+	}
+}
+
+/*
+ *  Append to the bytes a connection has to write, they are written by flush().
+ *  @return false when the buffer can't grow
+ */
+bool LoopbackBroker::write(LoopbackConnection* conn, const uint8_t* data, uint32_t length)
+{
+	if (conn->outSize - conn->outLen < length)
+	{
+		uint32_t size = conn->outSize ? conn->outSize : LOOPBACK_BROKER_BUFFER_SIZE;
+		while (size - conn->outLen < length)
+		{
+			size *= 2;
+		}
+		uint8_t* out = (uint8_t*)realloc(conn->out, size);
+		if (out == nullptr)
+		{
+			return false;
+		}
+		conn->out = out;
+		conn->outSize = size;
+	}
+	memcpy(conn->out + conn->outLen, data, length);
+	conn->outLen += length;
+	return true;
+}
+
+void LoopbackBroker::flush(LoopbackConnection* conn)
+{
+	if (conn->sock < 0 || conn->outLen == 0)
+	{
+		return;
+	}
+	ssize_t len = send(conn->sock, conn->out, conn->outLen, MSG_NOSIGNAL);
+	if (len > 0)
+	{
+		memmove(conn->out, conn->out + len, conn->outLen - len);
+		conn->outLen -= len;
+	}
+	else if (len < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+	{
+		release(conn);
+	}
+}
+
+/*
+ *  Close a connection and free its slot, the buffers are kept for the next one.
+ */
+void LoopbackBroker::release(LoopbackConnection* conn)
+{
+	if (conn->sock < 0)
+	{
+		return;
+	}
+	while (conn->subscriptions)
+	{
+		LoopbackSubscription* sub = conn->subscriptions;
+		conn->subscriptions = sub->next;
+		free(sub->filter);
+		free(sub);
+	}
+	::close(conn->sock);
+	conn->inLen = 0;
+	conn->outLen = 0;
+	_mutex.lock();
+	conn->sock = -1;
+	_mutex.unlock();
+}
@@ -0,0 +1,104 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - in-process broker for the benchmark
+ **************************************************************************************/
+
+#ifndef MQTTSNGATEWAY_SRC_LINUX_LOOPBACK_LOOPBACKBROKER_H_
+#define MQTTSNGATEWAY_SRC_LINUX_LOOPBACK_LOOPBACKBROKER_H_
+
+#include <stdint.h>
+#include "Threading.h"
+#include "Network.h"
+
+namespace MQTTSNGW
+{
+
+#define LOOPBACK_BROKER_MAX_CONNECTIONS   256
+#define LOOPBACK_BROKER_BUFFER_SIZE      4096      // initial bytes of a connection's buffers, they grow as needed
+#define LOOPBACK_BROKER_MAX_PACKET    1048576      // a longer packet closes the connection
+#define LOOPBACK_BROKER_POLL_INTERVAL     100      // msecs
+
+/* A topic filter of a connection */
+typedef struct LoopbackSubscription
+{
+	char* filter;
+	LoopbackSubscription* next;
+} LoopbackSubscription;
+
+/* A connection, the socket is -1 when the slot is free */
+typedef struct
+{
+	int sock;
+	uint8_t* in;
+	uint32_t inLen;
+	uint32_t inSize;
+	uint8_t* out;
+	uint32_t outLen;
+	uint32_t outSize;
+	LoopbackSubscription* subscriptions;
+} LoopbackConnection;
+
+/*=====================================
+ Class LoopbackBroker
+
+ In-process stand-in for an MQTT 3.1.1 broker, make bench. Once set by
+ TCPStack::setLoopback(), every connection the gateway makes to the broker is
+ one end of a socketpair, so that Network, select() and io_uring work as with TCP.
+ A thread of its own serves all the connections: CONNECT, PUBLISH with any QoS,
+ SUBSCRIBE, UNSUBSCRIBE, PINGREQ and DISCONNECT are answered and the PUBLISHes
+ are delivered with QoS 0 to the connections whose filters match their topics.
+ No TLS, no MQTT v5, no retained messages, no sessions.
+ =====================================*/
+class LoopbackBroker : public Thread, public TCPLoopback
+{
+public:
+	LoopbackBroker();
+	virtual ~LoopbackBroker();
+
+	bool open(void);
+	void close(void);
+	int connect(const char* host, const char* service);
+	uint32_t getConnectionCnt(void);
+	uint32_t getPublishedCnt(void);
+	uint32_t getDeliveredCnt(void);
+	void EXECRUN(void);
+
+	static bool isMatch(const char* filter, const uint8_t* topic, uint16_t topicLength);
+
+protected:
+	/* Called for each PUBLISH before it is delivered, the payload may be changed in place */
+	virtual void received(const uint8_t* topic, uint16_t topicLength, uint8_t* payload, uint32_t payloadLength) {}
+
+private:
+	int handle(LoopbackConnection* conn, uint8_t* packet, uint32_t length, uint32_t headerLength);
+	void publish(uint8_t* packet, uint32_t length, uint32_t headerLength);
+	bool subscribe(LoopbackConnection* conn, const uint8_t* filter, uint16_t length);
+	void unsubscribe(LoopbackConnection* conn, const uint8_t* filter, uint16_t length);
+	bool write(LoopbackConnection* conn, const uint8_t* data, uint32_t length);
+	int readPackets(LoopbackConnection* conn);
+	void flush(LoopbackConnection* conn);
+	void release(LoopbackConnection* conn);
+
+	Mutex _mutex;
+	LoopbackConnection _conns[LOOPBACK_BROKER_MAX_CONNECTIONS];
+	int _wakeup[2];
+	uint32_t _connectionCnt;
+	uint32_t _publishedCnt;
+	uint32_t _deliveredCnt;
+	bool _open;
+	bool _stop;
+};
+
+}
+#endif /* MQTTSNGATEWAY_SRC_LINUX_LOOPBACK_LOOPBACKBROKER_H_ */
@@ -0,0 +1,271 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ * based on UDP implementation (Copyright (c) 2016 Tomoaki Yamaguchi)
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - in-process sensor network for the benchmark
+ *    Tomoaki Yamaguchi - initial API and implementation and/or initial documentation
+ **************************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "SensorNetwork.h"
+#include "MQTTSNGWProcess.h"
+
+using namespace std;
+using namespace MQTTSNGW;
+
+/*===========================================
+  Class  SensorNetAddreess
+ ============================================*/
+SensorNetAddress::SensorNetAddress()
+{
+	_id = 0;
+}
+
+SensorNetAddress::~SensorNetAddress()
+{
+
+}
+
+void SensorNetAddress::setAddress(uint32_t id)
+{
+	_id = id;
+}
+
+/**
+ *  Set Address data to SensorNetAddress
+ *
+ *  @param  *data is the number of the client, e.g. "12" in a ClientList file
+ *  @return success = 0,  Invalid format = -1
+ */
+int SensorNetAddress::setAddress(string* data)
+{
+	char* end;
+	unsigned long id = strtoul(data->c_str(), &end, 10);
+	if (data->empty() || *end != 0 || id == 0)
+	{
+		_id = 0;
+		return -1;
+	}
+	_id = id;
+	return 0;
+}
+
+uint32_t SensorNetAddress::getId(void)
+{
+	return _id;
+}
+
+bool SensorNetAddress::isMatch(SensorNetAddress* addr)
+{
+	return (_id == addr->_id);
+}
+
+uint32_t SensorNetAddress::hash(void)
+{
+	return hashMix(_id);
+}
+
+SensorNetAddress& SensorNetAddress::operator =(SensorNetAddress& addr)
+{
+	_id = addr._id;
+	return *this;
+}
+
+char* SensorNetAddress::sprint(char* buf)
+{
+	sprintf(buf, "%u", _id);
+	return buf;
+}
+
+/*===========================================
+  Class  LoopbackQue
+ ============================================*/
+LoopbackQue::LoopbackQue()
+{
+	_datagrams = (LoopbackDatagram*)malloc(sizeof(LoopbackDatagram) * LOOPBACK_QUE_SIZE);
+	if (_datagrams == nullptr)
+	{
+		throw Exception("LoopbackQue can't allocate memories.");
+	}
+	_head = 0;
+	_tail = 0;
+	_postCnt = 0;
+	_dropCnt = 0;
+}
+
+LoopbackQue::~LoopbackQue()
+{
+	free(_datagrams);
+}
+
+/**
+ *  @return false when the que is full and the datagram is dropped
+ */
+bool LoopbackQue::post(const uint8_t* buf, uint16_t length, SensorNetAddress* addr)
+{
+	bool rc = false;
+	if (length > MQTTSNGW_MAX_PACKET_SIZE)
+	{
+		length = MQTTSNGW_MAX_PACKET_SIZE;
+	}
+	_mutex.lock();
+	if (_head - _tail < LOOPBACK_QUE_SIZE)
+	{
+		LoopbackDatagram* datagram = &_datagrams[_head % LOOPBACK_QUE_SIZE];
+		datagram->addr = *addr;
+		datagram->length = length;
+		memcpy(datagram->data, buf, length);
+		_head++;
+		_postCnt++;
+		rc = true;
+	}
+	else
+	{
+		_dropCnt++;
+	}
+	_mutex.unlock();
+	if (rc)
+	{
+		_sem.post();
+	}
+	return rc;
+}
+
+/**
+ *  Take the oldest datagram, waiting up to millsec for one.
+ *  @return length of the datagram, 0 when there is none
+ */
+int LoopbackQue::timedwait(uint8_t* buf, uint16_t len, SensorNetAddress* addr, uint16_t millsec)
+{
+	int rc = 0;
+
+	_mutex.lock();
+	bool empty = (_head == _tail);
+	_mutex.unlock();
+	if (empty)
+	{
+		_sem.timedwait(millsec);
+	}
+
+	_mutex.lock();
+	if (_head != _tail)
+	{
+		LoopbackDatagram* datagram = &_datagrams[_tail % LOOPBACK_QUE_SIZE];
+		rc = (datagram->length < len) ? datagram->length : len;
+		memcpy(buf, datagram->data, rc);
+		*addr = datagram->addr;
+		_tail++;
+	}
+	_mutex.unlock();
+	return rc;
+}
+
+uint32_t LoopbackQue::getPostCnt(void)
+{
+	_mutex.lock();
+	uint32_t cnt = _postCnt;
+	_mutex.unlock();
+	return cnt;
+}
+
+uint32_t LoopbackQue::getDropCnt(void)
+{
+	_mutex.lock();
+	uint32_t cnt = _dropCnt;
+	_mutex.unlock();
+	return cnt;
+}
+
+/*================================================================
+   Class  SensorNetwork
+ ================================================================*/
+SensorNetwork::SensorNetwork()
+{
+}
+
+SensorNetwork::~SensorNetwork()
+{
+}
+
+int SensorNetwork::unicast(const uint8_t* payload, uint16_t payloadLength, SensorNetAddress* sendToAddr)
+{
+	return _toClients.post(payload, payloadLength, sendToAddr) ? payloadLength : -1;
+}
+
+/**
+ *  @return number of datagrams sent, -1 when the first one is dropped
+ */
+int SensorNetwork::unicast(const uint8_t** payloads, const uint16_t* payloadLengths, int count, SensorNetAddress* sendToAddr)
+{
+	int cnt = 0;
+	while (cnt < count && _toClients.post(payloads[cnt], payloadLengths[cnt], sendToAddr))
+	{
+		cnt++;
+	}
+	return (cnt == 0 && count > 0) ? -1 : cnt;
+}
+
+int SensorNetwork::broadcast(const uint8_t* payload, uint16_t payloadLength)
+{
+	SensorNetAddress broadcastAddr;
+	return unicast(payload, payloadLength, &broadcastAddr);
+}
+
+int SensorNetwork::read(uint8_t* buf, uint16_t bufLen)
+{
+	return _toGateway.timedwait(buf, bufLen, &_clientAddr, 1000);
+}
+
+int SensorNetwork::initialize(void)
+{
+	_description = "Loopback";
+	return 0;
+}
+
+const char* SensorNetwork::getDescription(void)
+{
+	return _description.c_str();
+}
+
+SensorNetAddress* SensorNetwork::getSenderAddress(void)
+{
+	return &_clientAddr;
+}
+
+/**
+ *  A client sends a datagram to the gateway.
+ *  @return false when it is dropped
+ */
+bool SensorNetwork::inject(const uint8_t* payload, uint16_t payloadLength, SensorNetAddress* from)
+{
+	return _toGateway.post(payload, payloadLength, from);
+}
+
+/**
+ *  Receive a datagram the gateway sent, to the client of *to, waiting up to millsec.
+ *  @return length of the datagram, 0 when there is none
+ */
+int SensorNetwork::collect(uint8_t* buf, uint16_t bufLen, SensorNetAddress* to, uint16_t millsec)
+{
+	return _toClients.timedwait(buf, bufLen, to, millsec);
+}
+
+/**
+ *  Datagrams dropped in both directions.
+ */
+uint32_t SensorNetwork::getDropCnt(void)
+{
+	return _toGateway.getDropCnt() + _toClients.getDropCnt();
+}
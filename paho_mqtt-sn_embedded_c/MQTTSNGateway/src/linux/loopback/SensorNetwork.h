@@ -0,0 +1,128 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ * based on UDP implementation (Copyright (c) 2016 Tomoaki Yamaguchi)
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - in-process sensor network for the benchmark
+ *    Tomoaki Yamaguchi - initial API and implementation and/or initial documentation
+ **************************************************************************************/
+
+#ifndef SENSORNETWORK_H_
+#define SENSORNETWORK_H_
+
+#include "MQTTSNGWDefines.h"
+#include "Threading.h"
+#include <string>
+
+using namespace std;
+
+namespace MQTTSNGW
+{
+
+#ifdef  DEBUG_NWSTACK
+  #define D_NWSTACK(...) printf(__VA_ARGS__)
+#else
+  #define D_NWSTACK(...)
+#endif
+
+#define LOOPBACK_QUE_SIZE  1024   // Datagrams waiting in each direction, more are dropped as by a full socket buffer
+
+/*===========================================
+ Class  SensorNetAddreess
+
+ The number of a client, 0 is the broadcast address.
+ ============================================*/
+class SensorNetAddress
+{
+public:
+	SensorNetAddress();
+	~SensorNetAddress();
+	void setAddress(uint32_t id);
+	int  setAddress(string* data);
+	uint32_t getId(void);
+	bool isMatch(SensorNetAddress* addr);
+	uint32_t hash(void);
+	SensorNetAddress& operator =(SensorNetAddress& addr);
+	char* sprint(char* buf);
+private:
+	uint32_t _id;
+};
+
+/* A datagram in a LoopbackQue */
+typedef struct
+{
+	SensorNetAddress addr;
+	uint16_t length;
+	uint8_t data[MQTTSNGW_MAX_PACKET_SIZE];
+} LoopbackDatagram;
+
+/*========================================
+ Class LoopbackQue
+
+ Datagrams in one direction, written by any thread and read by one.
+ =======================================*/
+class LoopbackQue
+{
+public:
+	LoopbackQue();
+	~LoopbackQue();
+
+	bool post(const uint8_t* buf, uint16_t length, SensorNetAddress* addr);
+	int timedwait(uint8_t* buf, uint16_t len, SensorNetAddress* addr, uint16_t millsec);
+	uint32_t getPostCnt(void);
+	uint32_t getDropCnt(void);
+
+private:
+	Mutex _mutex;
+	Semaphore _sem;
+	LoopbackDatagram* _datagrams;
+	uint32_t _head;
+	uint32_t _tail;
+	uint32_t _postCnt;
+	uint32_t _dropCnt;
+};
+
+/*===========================================
+ Class  SensorNetwork
+
+ A sensor network in memory, make bench. The gateway reads the datagrams
+ the clients inject() and the clients collect() the ones it sends, so that
+ a test drives a whole Gateway without a socket or a radio.
+ ============================================*/
+class SensorNetwork
+{
+public:
+	SensorNetwork();
+	~SensorNetwork();
+
+	int unicast(const uint8_t* payload, uint16_t payloadLength, SensorNetAddress* sendto);
+	int unicast(const uint8_t** payloads, const uint16_t* payloadLengths, int count, SensorNetAddress* sendto);
+	int broadcast(const uint8_t* payload, uint16_t payloadLength);
+	int read(uint8_t* buf, uint16_t bufLen);
+	int initialize(void);
+	const char* getDescription(void);
+	SensorNetAddress* getSenderAddress(void);
+
+	/* the clients' side */
+	bool inject(const uint8_t* payload, uint16_t payloadLength, SensorNetAddress* from);
+	int collect(uint8_t* buf, uint16_t bufLen, SensorNetAddress* to, uint16_t millsec);
+	uint32_t getDropCnt(void);
+
+private:
+	LoopbackQue _toGateway;
+	LoopbackQue _toClients;
+	SensorNetAddress _clientAddr;   // Sender's address. not gateway's one.
+	string _description;
+};
+
+}
+#endif /* SENSORNETWORK_H_ */
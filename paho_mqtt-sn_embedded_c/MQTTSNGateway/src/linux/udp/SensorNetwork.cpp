@@ -24,6 +24,7 @@
 #include <regex>
 #include <string>
 #include <stdlib.h>
+#include <errno.h>
 #include "SensorNetwork.h"
 #include "MQTTSNGWProcess.h"
 
@@ -35,6 +36,7 @@ using namespace MQTTSNGW;
 
   These 4 methods are minimum requirements for the SensorNetAddress class.
    isMatch(SensorNetAddress* )
+   hash(void)
    operator =(SensorNetAddress& )
    setAddress(string* )
    sprint(char* )
@@ -118,6 +120,15 @@ bool SensorNetAddress::isMatch(SensorNetAddress* addr)
 	return ((this->_portNo == addr->_portNo) && (this->_IpAddr == addr->_IpAddr));
 }
 
+/*
+ *  Hash of the address, equal for addresses that match.
+ *  Used by ForwarderList to index the forwarders.
+ */
+uint32_t SensorNetAddress::hash(void)
+{
+	return hashMix(_IpAddr ^ ((uint32_t)_portNo << 16) ^ _portNo);
+}
+
 SensorNetAddress& SensorNetAddress::operator =(SensorNetAddress& addr)
 {
 	this->_portNo = addr._portNo;
@@ -145,7 +156,7 @@ char* SensorNetAddress::sprint(char* buf)
    initialize( )       is used by ClientSendTask::initialize( )
    getSenderAddress( ) is used by ClientRecvTask::run( )
    broadcast( )        is used by MQTTSNPacket::broadcast( )
-   unicast( )          is used by MQTTSNPacket::unicast( )
+   unicast( )          is used by MQTTSNPacket::unicast( ) and MQTTSNPacketBurst::unicast( )
    read( )             is used by MQTTSNPacket::recv( )
 
  ================================================================*/
@@ -163,6 +174,15 @@ int SensorNetwork::unicast(const uint8_t* payload, uint16_t payloadLength, Senso
 	return UDPPort::unicast(payload, payloadLength, sendToAddr);
 }
 
+/**
+ *  Sends up to MAX_PACKET_BURST datagrams to the same address.
+ *  @return number of datagrams sent, -1 on error
+ */
+int SensorNetwork::unicast(const uint8_t** payloads, const uint16_t* payloadLengths, int count, SensorNetAddress* sendToAddr)
+{
+	return UDPPort::unicast(payloads, payloadLengths, count, sendToAddr);
+}
+
 int SensorNetwork::broadcast(const uint8_t* payload, uint16_t payloadLength)
 {
 	return UDPPort::broadcast(payload, payloadLength);
@@ -218,7 +238,31 @@ int SensorNetwork::initialize(void)
 	}
 
 	/*  Prepare UDP sockets */
-	return UDPPort::open(ip.c_str(), multicastPortNo, unicastPortNo);
+	if (UDPPort::open(ip.c_str(), multicastPortNo, unicastPortNo) < 0)
+	{
+		return -1;
+	}
+
+	/*  Receive through an io_uring, select() is kept when the kernel has none */
+	if (theProcess->getParam("IOUring", param) == 0 && !strcasecmp(param, "YES") && UDPPort::openRing())
+	{
+		_description += " io_uring";
+	}
+
+	/*  Record the datagrams into a pcap file */
+	if (theProcess->getParam("CaptureFile", param) == 0)
+	{
+		if (UDPPort::openCapture(param))
+		{
+			_description += " Capture ";
+			_description += param;
+		}
+		else
+		{
+			D_NWSTACK("error can't create %s in SensorNetwork::initialize\n", param);
+		}
+	}
+	return 0;
 }
 
 const char* SensorNetwork::getDescription(void)
@@ -249,6 +293,8 @@ UDPPort::~UDPPort()
 
 void UDPPort::close(void)
 {
+	_capture.close();
+	_ring.close();
 	if (_sockfdUnicast > 0)
 	{
 		::close(_sockfdUnicast);
@@ -274,6 +320,7 @@ int UDPPort::open(const char* ipAddress, uint16_t multiPortNo, uint16_t uniPortN
 
 	uint32_t ip = inet_addr(ipAddress);
 	_grpAddr.setAddress(ip, htons(multiPortNo));
+	_mcastAddr = _grpAddr;
 	_clientAddr.setAddress(ip, htons(uniPortNo));
 
 	/*------ Create unicast socket --------*/
@@ -351,6 +398,40 @@ int UDPPort::open(const char* ipAddress, uint16_t multiPortNo, uint16_t uniPortN
 	return 0;
 }
 
+/**
+ *  Arm a multishot recvmsg on both sockets, recv() then takes the datagrams from the ring.
+ *  @return false when the kernel has no io_uring, recv() keeps using select().
+ */
+bool UDPPort::openRing(void)
+{
+	if (!_ring.open())
+	{
+		D_NWSTACK("error can't open an io_uring in UDPPort::openRing\n");
+		return false;
+	}
+	if (!_ring.recvmsgMultishot(_sockfdUnicast, _sockfdUnicast) || !_ring.recvmsgMultishot(_sockfdMulticast, _sockfdMulticast)
+			|| _ring.submit() < 0)
+	{
+		_ring.close();
+		return false;
+	}
+	return true;
+}
+
+/**
+ *  Record the datagrams received and sent into fileName, a pcap file.
+ *  @return false when the file can't be created
+ */
+bool UDPPort::openCapture(const char* fileName)
+{
+	return _capture.open(fileName);
+}
+
+SensorNetCapture* UDPPort::getCapture(void)
+{
+	return &_capture;
+}
+
 int UDPPort::unicast(const uint8_t* buf, uint32_t length, SensorNetAddress* addr)
 {
 	sockaddr_in dest;
@@ -363,10 +444,54 @@ int UDPPort::unicast(const uint8_t* buf, uint32_t length, SensorNetAddress* addr
 	{
 		D_NWSTACK("errno == %d in UDPPort::sendto\n", errno);
 	}
+	else if (_capture.isOpen())
+	{
+		_capture.record(INADDR_ANY, _clientAddr.getPortNo(), dest.sin_addr.s_addr, dest.sin_port, buf, status);
+	}
 	D_NWSTACK("sendto %s:%u length = %d\n", inet_ntoa(dest.sin_addr), ntohs(dest.sin_port), status);
 	return status;
 }
 
+int UDPPort::unicast(const uint8_t** bufs, const uint16_t* lengths, int count, SensorNetAddress* addr)
+{
+	mmsghdr msgs[MAX_PACKET_BURST];
+	iovec iovs[MAX_PACKET_BURST];
+	sockaddr_in dest;
+	dest.sin_family = AF_INET;
+	dest.sin_port = addr->getPortNo();
+	dest.sin_addr.s_addr = addr->getIpAddress();
+
+	if (count > MAX_PACKET_BURST)
+	{
+		count = MAX_PACKET_BURST;
+	}
+	memset(msgs, 0, sizeof(mmsghdr) * count);
+	for (int i = 0; i < count; i++)
+	{
+		iovs[i].iov_base = (void*) bufs[i];
+		iovs[i].iov_len = lengths[i];
+		msgs[i].msg_hdr.msg_name = &dest;
+		msgs[i].msg_hdr.msg_namelen = sizeof(dest);
+		msgs[i].msg_hdr.msg_iov = &iovs[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	int status = ::sendmmsg(_sockfdUnicast, msgs, count, 0);
+	if (status < 0)
+	{
+		D_NWSTACK("errno == %d in UDPPort::sendmmsg\n", errno);
+	}
+	else if (_capture.isOpen())
+	{
+		for (int i = 0; i < status; i++)
+		{
+			_capture.record(INADDR_ANY, _clientAddr.getPortNo(), dest.sin_addr.s_addr, dest.sin_port, bufs[i], lengths[i]);
+		}
+	}
+	D_NWSTACK("sendmmsg %s:%u datagrams = %d\n", inet_ntoa(dest.sin_addr), ntohs(dest.sin_port), status);
+	return status;
+}
+
 int UDPPort::broadcast(const uint8_t* buf, uint32_t length)
 {
 	return unicast(buf, length, &_grpAddr);
@@ -378,6 +503,11 @@ int UDPPort::recv(uint8_t* buf, uint16_t len, SensorNetAddress* addr)
 	fd_set recvfds;
 	int maxSock = 0;
 
+	if (_ring.isOpen())
+	{
+		return recvRing(buf, len, addr);
+	}
+
 	timeout.tv_sec = 0;
 	timeout.tv_usec = 1000000;    // 1 sec
 	FD_ZERO(&recvfds);
@@ -408,6 +538,72 @@ int UDPPort::recv(uint8_t* buf, uint16_t len, SensorNetAddress* addr)
 	return rc;
 }
 
+/*
+ *  A datagram received by the ring, copied out of its buffer. The ones already
+ *  received are returned without a syscall, otherwise it waits for 1 sec as select() does.
+ */
+int UDPPort::recvRing(uint8_t* buf, uint16_t len, SensorNetAddress* addr)
+{
+	IOUringEvent ev;
+
+	if (_ring.wait(&ev, 1000) <= 0)
+	{
+		return 0;
+	}
+	int sockfd = (int)ev.userData;
+	if (!ev.more)
+	{
+		/* the buffers ran out, or an error ended the request */
+		_ring.recvmsgMultishot(sockfd, sockfd);
+	}
+	if (ev.res < 0)
+	{
+		D_NWSTACK("errno == %d in UDPPort::recvRing\n", -ev.res);
+		return (ev.res == -ENOBUFS) ? 0 : -1;
+	}
+
+	int rc = (ev.length < len) ? ev.length : len;
+	memcpy(buf, ev.data, rc);
+	if (_capture.isOpen())
+	{
+		captureRecv(sockfd, ev.ipAddress, ev.portNo, ev.data, ev.length);
+	}
+	if (sockfd == _sockfdUnicast)
+	{
+		addr->setAddress(ev.ipAddress, ev.portNo);
+	}
+	else
+	{
+		_grpAddr.setAddress(ev.ipAddress, ev.portNo);
+	}
+	_ring.release(&ev);
+	D_NWSTACK("recved from %08x:%d length = %d\n", ntohl(ev.ipAddress), ntohs(ev.portNo), rc);
+	return rc;
+}
+
+/**
+ *  Number of io_uring_enter() made by recv(), 0 with select().
+ */
+uint32_t UDPPort::getEnterCnt(void)
+{
+	return _ring.getEnterCnt();
+}
+
+/*
+ *  Record a received datagram, to the gateway's unicast port or to the multicast group.
+ */
+void UDPPort::captureRecv(int sockfd, uint32_t ipAddress, uint16_t portNo, const uint8_t* buf, int length)
+{
+	if (sockfd == _sockfdUnicast)
+	{
+		_capture.record(ipAddress, portNo, INADDR_ANY, _clientAddr.getPortNo(), buf, length);
+	}
+	else
+	{
+		_capture.record(ipAddress, portNo, _mcastAddr.getIpAddress(), _mcastAddr.getPortNo(), buf, length);
+	}
+}
+
 int UDPPort::recvfrom(int sockfd, uint8_t* buf, uint16_t len, uint8_t flags, SensorNetAddress* addr)
 {
 	sockaddr_in sender;
@@ -422,6 +618,10 @@ int UDPPort::recvfrom(int sockfd, uint8_t* buf, uint16_t len, uint8_t flags, Sen
 		return -1;
 	}
 	addr->setAddress(sender.sin_addr.s_addr, sender.sin_port);
+	if (status > 0 && _capture.isOpen())
+	{
+		captureRecv(sockfd, sender.sin_addr.s_addr, sender.sin_port, buf, status);
+	}
 	D_NWSTACK("recved from %s:%d length = %d\n", inet_ntoa(sender.sin_addr),ntohs(sender.sin_port), status);
 	return status;
 }
@@ -18,6 +18,8 @@
 #define SENSORNETWORK_H_
 
 #include "MQTTSNGWDefines.h"
+#include "IOUring.h"
+#include "SensorNetCapture.h"
 #include <string>
 
 using namespace std;
@@ -44,6 +46,7 @@ public:
 	uint16_t getPortNo(void);
 	uint32_t getIpAddress(void);
 	bool isMatch(SensorNetAddress* addr);
+	uint32_t hash(void);
 	SensorNetAddress& operator =(SensorNetAddress& addr);
 	char* sprint(char* buf);
 private:
@@ -61,21 +64,31 @@ public:
 	virtual ~UDPPort();
 
 	int open(const char* ipAddress, uint16_t multiPortNo,	uint16_t uniPortNo);
+	bool openRing(void);
+	bool openCapture(const char* fileName);
 	void close(void);
 	int unicast(const uint8_t* buf, uint32_t length, SensorNetAddress* sendToAddr);
+	int unicast(const uint8_t** bufs, const uint16_t* lengths, int count, SensorNetAddress* sendToAddr);
 	int broadcast(const uint8_t* buf, uint32_t length);
 	int recv(uint8_t* buf, uint16_t len, SensorNetAddress* addr);
+	uint32_t getEnterCnt(void);
+	SensorNetCapture* getCapture(void);
 
 private:
 	void setNonBlocking(const bool);
 	int recvfrom(int sockfd, uint8_t* buf, uint16_t len, uint8_t flags,	SensorNetAddress* addr);
+	int recvRing(uint8_t* buf, uint16_t len, SensorNetAddress* addr);
+	void captureRecv(int sockfd, uint32_t ipAddress, uint16_t portNo, const uint8_t* buf, int length);
 
 	int _sockfdUnicast;
 	int _sockfdMulticast;
 
 	SensorNetAddress _grpAddr;
+	SensorNetAddress _mcastAddr;    // the multicast group, _grpAddr is replaced by the sender of a multicast datagram
 	SensorNetAddress _clientAddr;
 	bool _disconReq;
+	IOUring _ring;    // receives the datagrams of both sockets instead of select() and recvfrom(), IOUring=YES
+	SensorNetCapture _capture;    // records the datagrams received and sent, CaptureFile=
 
 };
 
@@ -89,6 +102,7 @@ public:
 	~SensorNetwork();
 
 	int unicast(const uint8_t* payload, uint16_t payloadLength, SensorNetAddress* sendto);
+	int unicast(const uint8_t** payloads, const uint16_t* payloadLengths, int count, SensorNetAddress* sendto);
 	int broadcast(const uint8_t* payload, uint16_t payloadLength);
 	int read(uint8_t* buf, uint16_t bufLen);
 	int initialize(void);
@@ -101,6 +101,15 @@ bool SensorNetAddress::isMatch(SensorNetAddress* addr)
 	(this->_IpAddr.sin6_addr.s6_addr32[3] == addr->_IpAddr.sin6_addr.s6_addr32[3]));
 }
 
+/*
+ *  Hash of the address, equal for addresses that match.
+ *  Used by ForwarderList to index the forwarders.
+ */
+uint32_t SensorNetAddress::hash(void)
+{
+	return hashBytes(_IpAddr.sin6_addr.s6_addr, 16, hashMix(_portNo));
+}
+
 SensorNetAddress& SensorNetAddress::operator =(SensorNetAddress& addr)
 {
 	this->_portNo = addr._portNo;
@@ -134,6 +143,15 @@ int SensorNetwork::unicast(const uint8_t* payload, uint16_t payloadLength, Senso
 	return UDPPort6::unicast(payload, payloadLength, sendToAddr);
 }
 
+/**
+ *  Sends up to MAX_PACKET_BURST datagrams to the same address.
+ *  @return number of datagrams sent, -1 on error
+ */
+int SensorNetwork::unicast(const uint8_t** payloads, const uint16_t* payloadLengths, int count, SensorNetAddress* sendToAddr)
+{
+	return UDPPort6::unicast(payloads, payloadLengths, count, sendToAddr);
+}
+
 int SensorNetwork::broadcast(const uint8_t* payload, uint16_t payloadLength)
 {
 	return UDPPort6::broadcast(payload, payloadLength);
@@ -319,11 +337,13 @@ int UDPPort6::open(const char* ipAddress, uint16_t uniPortNo, const char* broadc
 	return 0;
 }
 
-//TODO: test if unicast is working too....
-int UDPPort6::unicast(const uint8_t* buf, uint32_t length, SensorNetAddress* addr)
+/*
+ *  Resolves the destination of a unicast, the caller frees *res.
+ *  @return port number
+ */
+int UDPPort6::getAddrInfo(SensorNetAddress* addr, struct addrinfo** res, char* destStr)
 {
-	char destStr[INET6_ADDRSTRLEN+10];
-	struct addrinfo hints, *res;
+	struct addrinfo hints;
 	memset(&hints, 0, sizeof hints);
 	hints.ai_family = AF_INET6;  // use IPv6
 	hints.ai_socktype = SOCK_DGRAM;
@@ -346,18 +366,34 @@ int UDPPort6::unicast(const uint8_t* buf, uint32_t length, SensorNetAddress* add
 		strcat(destStr,_interfaceName);
 		if(IN6_IS_ADDR_LINKLOCAL(addr->getAddress()))
 		{
-			getaddrinfo(destStr, portStr.c_str(), &hints, &res);
+			getaddrinfo(destStr, portStr.c_str(), &hints, res);
 		}
 		else
 		{
-			getaddrinfo(addr->getAddress(), portStr.c_str(), &hints, &res);
+			getaddrinfo(addr->getAddress(), portStr.c_str(), &hints, res);
 		}
 	} else {
 		strcpy(destStr, addr->getAddress());
-		getaddrinfo(addr->getAddress(), portStr.c_str(), &hints, &res);
+		getaddrinfo(addr->getAddress(), portStr.c_str(), &hints, res);
+	}
+	return port;
+}
+
+//TODO: test if unicast is working too....
+int UDPPort6::unicast(const uint8_t* buf, uint32_t length, SensorNetAddress* addr)
+{
+	char destStr[INET6_ADDRSTRLEN+10];
+	struct addrinfo *res = 0;
+	int port = getAddrInfo(addr, &res, destStr);
+
+	if (res == 0)
+	{
+		WRITELOG("UDPPort6::unicast can't resolve %s\n", destStr);
+		return -1;
 	}
 
 	int status = ::sendto(_sockfdUnicast, buf, length, 0, res->ai_addr, res->ai_addrlen);
+	freeaddrinfo(res);
 
 	if (status < 0)
 	{
@@ -369,6 +405,48 @@ int UDPPort6::unicast(const uint8_t* buf, uint32_t length, SensorNetAddress* add
 	return status;
 }
 
+int UDPPort6::unicast(const uint8_t** bufs, const uint16_t* lengths, int count, SensorNetAddress* addr)
+{
+	char destStr[INET6_ADDRSTRLEN+10];
+	struct addrinfo *res = 0;
+	struct mmsghdr msgs[MAX_PACKET_BURST];
+	struct iovec iovs[MAX_PACKET_BURST];
+	int port = getAddrInfo(addr, &res, destStr);
+
+	if (res == 0)
+	{
+		WRITELOG("UDPPort6::unicast can't resolve %s\n", destStr);
+		return -1;
+	}
+
+	if (count > MAX_PACKET_BURST)
+	{
+		count = MAX_PACKET_BURST;
+	}
+	memset(msgs, 0, sizeof(struct mmsghdr) * count);
+	for (int i = 0; i < count; i++)
+	{
+		iovs[i].iov_base = (void*) bufs[i];
+		iovs[i].iov_len = lengths[i];
+		msgs[i].msg_hdr.msg_name = res->ai_addr;
+		msgs[i].msg_hdr.msg_namelen = res->ai_addrlen;
+		msgs[i].msg_hdr.msg_iov = &iovs[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	int status = ::sendmmsg(_sockfdUnicast, msgs, count, 0);
+	freeaddrinfo(res);
+
+	if (status < 0)
+	{
+		WRITELOG("errno in UDPPort::unicast(sendmmsg): %d, %s\n",errno,strerror(errno));
+	}
+
+	WRITELOG("unicast sendmmsg %s, port: %d datagrams = %d\n", destStr,port,status);
+
+	return status;
+}
+
 int UDPPort6::broadcast(const uint8_t* buf, uint32_t length)
 {
 	struct addrinfo hint,*info;
@@ -21,6 +21,7 @@
 
 #include "MQTTSNGWDefines.h"
 #include <arpa/inet.h>
+#include <netdb.h>
 #include <string>
 
 using namespace std;
@@ -49,6 +50,7 @@ public:
 	struct sockaddr_in6 *getIpAddress(void);
 	char* getAddress(void);
 	bool isMatch(SensorNetAddress* addr);
+	uint32_t hash(void);
 	SensorNetAddress& operator =(SensorNetAddress& addr);
 	char* sprint(char* buf);
 private:
@@ -69,11 +71,13 @@ public:
 	int open(const char* ipAddress, uint16_t uniPortNo, const char* broadcastAddr, const char* interfaceName);
 	void close(void);
 	int unicast(const uint8_t* buf, uint32_t length, SensorNetAddress* sendToAddr);
+	int unicast(const uint8_t** bufs, const uint16_t* lengths, int count, SensorNetAddress* sendToAddr);
 	int broadcast(const uint8_t* buf, uint32_t length);
 	int recv(uint8_t* buf, uint16_t len, SensorNetAddress* addr);
 
 private:
 	void setNonBlocking(const bool);
+	int getAddrInfo(SensorNetAddress* addr, struct addrinfo** res, char* destStr);
 	int recvfrom(int sockfd, uint8_t* buf, uint16_t len, uint8_t flags,	SensorNetAddress* addr);
 
 	int _sockfdUnicast;
@@ -97,6 +101,7 @@ public:
 	~SensorNetwork();
 
 	int unicast(const uint8_t* payload, uint16_t payloadLength, SensorNetAddress* sendto);
+	int unicast(const uint8_t** payloads, const uint16_t* payloadLengths, int count, SensorNetAddress* sendto);
 	int broadcast(const uint8_t* payload, uint16_t payloadLength);
 	int read(uint8_t* buf, uint16_t bufLen);
 	int initialize(void);
@@ -18,6 +18,7 @@
 #include <unistd.h>
 #include <termios.h>
 #include <fcntl.h>
+#include <errno.h>
 #include <string.h>
 #include <stdlib.h>
 #include <sys/time.h>
@@ -72,6 +73,15 @@ bool SensorNetAddress::isMatch(SensorNetAddress* addr)
 	return (memcmp(this->_address64, addr->_address64, 8 ) == 0 &&  memcmp(this->_address16, addr->_address16, 2) == 0);
 }
 
+/*
+ *  Hash of the address, equal for addresses that match.
+ *  Used by ForwarderList to index the forwarders.
+ */
+uint32_t SensorNetAddress::hash(void)
+{
+	return hashBytes(_address16, 2, hashBytes(_address64, 8));
+}
+
 SensorNetAddress& SensorNetAddress::operator =(SensorNetAddress& addr)
 {
 	memcpy(_address64, addr._address64, 8);
@@ -108,6 +118,11 @@ int SensorNetwork::unicast(const uint8_t* payload, uint16_t payloadLength, Senso
 	return XBee::unicast(payload, payloadLength, sendToAddr);
 }
 
+int SensorNetwork::unicast(const uint8_t** payloads, const uint16_t* payloadLengths, int count, SensorNetAddress* sendToAddr)
+{
+	return XBee::unicast(payloads, payloadLengths, count, sendToAddr);
+}
+
 int SensorNetwork::broadcast(const uint8_t* payload, uint16_t payloadLength)
 {
 	return XBee::broadcast(payload, payloadLength);
@@ -168,6 +183,13 @@ XBee::XBee(){
     _dataLen = 0;
     _frameId = 0;
     _apiMode = 2;
+    _frameState = FRAME_START;
+    _escaped = false;
+    _frameLen = 0;
+    _framePos = 0;
+    _frameChecksum = 0;
+    _frames = 0;
+    _checksumErrors = 0;
 }
 
 XBee::~XBee(){
@@ -215,29 +237,44 @@ int XBee:: unicast(const uint8_t* payload, uint16_t payloadLen, SensorNetAddress
 	return send(payload, (uint8_t) payloadLen, addr);
 }
 
+/*
+ *  Each frame waits for its transmit status, so a burst is sent frame by frame.
+ *  @return number of frames sent, -1 if the first one fails
+ */
+int XBee::unicast(const uint8_t** payloads, const uint16_t* payloadLens, int count, SensorNetAddress* addr){
+	int i = 0;
+	for (; i < count; i++)
+	{
+		if ( send(payloads[i], (uint8_t) payloadLens[i], addr) < 0 )
+		{
+			break;
+		}
+	}
+	return i ? i : -1;
+}
+
 int XBee::recv(uint8_t* buf, uint16_t bufLen, SensorNetAddress* clientAddr)
 {
-	uint8_t data[128];
 	int len;
 
 	while ( true )
 	{
 
-		if ( (len = readApiFrame(data)) > 0 )
+		if ( (len = readApiFrame()) > 0 )
 		{
 
-			if ( data[0] == API_RESPONSE )
+			if ( _frame[0] == API_RESPONSE && len >= 12 && len - 12 <= bufLen )
 			{
-				memcpy(clientAddr->_address64, data + 1, 8);
-				memcpy(clientAddr->_address16, data + 9, 2);
+				memcpy(clientAddr->_address64, _frame + 1, 8);
+				memcpy(clientAddr->_address16, _frame + 9, 2);
 				len -= 12;
-				memcpy( buf, data + 12, len);
+				memcpy( buf, _frame + 12, len);
 				return len;
 			}
-			else if ( data[0] == API_XMITSTATUS )
+			else if ( _frame[0] == API_XMITSTATUS && len >= 6 )
 			{
-				_respCd = data[5];
-				_respId = data[1];
+				_respCd = _frame[5];
+				_respId = _frame[1];
 				_sem.post();
 			}
 		}
@@ -248,148 +285,164 @@ int XBee::recv(uint8_t* buf, uint16_t bufLen, SensorNetAddress* clientAddr)
 	}
 }
 
-int XBee::readApiFrame(uint8_t* recvData){
-	uint8_t buf;
-	uint8_t pos = 0;
-	uint8_t checksum = 0;
-	uint8_t len = 0;
-
-	 while ( _serialPort->recv(&buf) )
-	 {
-		 if ( buf == START_BYTE)
-		 {
-			pos = 1;
-			 D_NWSTACK("\r\n===> Recv:    ");
-			 break;
-		 }
-	 }
-
-	if ( pos == 0 )
-	{
-		goto errexit;
-	}
-
-    if ( recv(&buf) < 0 ) // MSB length
-    {
-    	goto errexit;
-    }
+/*
+ *  Feeds buffered serial bytes to the frame state machine until a frame with a valid checksum is complete.
+ *  A frame split by the receive timeout is continued by the next call.  In API mode 2 an unescaped
+ *  START_BYTE always begins a new frame, so the parser resynchronizes on corrupted or truncated frames.
+ */
+int XBee::readApiFrame(void)
+{
+	uint8_t c;
 
-    if ( recv(&buf) < 0 ) // LSB length
-	{
-    	goto errexit;
-	}
-	else
+	while ( _serialPort->recv(&c) )
 	{
-		len = buf;
-	}
-
-    pos = 0;
-    while ( len-- )
-    {
-    	if ( recv(&buf) < 0 )
-    	{
-    		goto errexit;
-    	}
-    	recvData[pos++] = buf;
-    	checksum += buf;
-    }
+		if ( _apiMode == 2 )
+		{
+			if ( c == START_BYTE )
+			{
+				D_NWSTACK("\r\n===> Recv:    ");
+				_frameState = FRAME_LENGTH_MSB;
+				_escaped = false;
+				continue;
+			}
+			if ( _frameState == FRAME_START )
+			{
+				continue;
+			}
+			if ( c == ESCAPE )
+			{
+				_escaped = true;
+				continue;
+			}
+			if ( _escaped )
+			{
+				c ^= 0x20;
+				_escaped = false;
+			}
+		}
+		else if ( _frameState == FRAME_START )
+		{
+			if ( c == START_BYTE )
+			{
+				D_NWSTACK("\r\n===> Recv:    ");
+				_frameState = FRAME_LENGTH_MSB;
+			}
+			continue;
+		}
 
-    recv(&buf);        // checksum
-    if ( (0xff - checksum ) == buf ){
-    	D_NWSTACK("    checksum ok\r\n");
-    	return pos;
-    }
-    else
-    {
-    	D_NWSTACK("    checksum error  %02x\r\n", 0xff - checksum);
-    	goto errexit;
-    }
-errexit:
-	_serialPort->flush();
+		switch ( _frameState )
+		{
+		case FRAME_LENGTH_MSB:
+			_frameLen = c << 8;
+			_frameState = FRAME_LENGTH_LSB;
+			break;
+		case FRAME_LENGTH_LSB:
+			_frameLen |= c;
+			_framePos = 0;
+			_frameChecksum = 0;
+			_frameState = ( _frameLen > 0 && _frameLen <= XBEE_MAX_FRAME ) ? FRAME_DATA : FRAME_START;
+			break;
+		case FRAME_DATA:
+			_frame[_framePos++] = c;
+			_frameChecksum += c;
+			if ( _framePos == _frameLen )
+			{
+				_frameState = FRAME_CHECKSUM;
+			}
+			break;
+		case FRAME_CHECKSUM:
+			_frameState = FRAME_START;
+			if ( (uint8_t)(0xff - _frameChecksum) == c )
+			{
+				D_NWSTACK("    checksum ok\r\n");
+				_frames++;
+				return _frameLen;
+			}
+			D_NWSTACK("    checksum error  %02x\r\n", 0xff - _frameChecksum);
+			_checksumErrors++;
+			break;
+		default:
+			_frameState = FRAME_START;
+			break;
+		}
+	}
 	return -1;
 }
 
+/*
+ *  The whole frame is escaped into one buffer and written with a single write().
+ */
 int XBee::send(const uint8_t* payload, uint8_t pLen, SensorNetAddress* addr){
 	D_NWSTACK("\r\n===> Send:    ");
-    uint8_t checksum = 0;
-    _respCd = -1;
+	uint8_t frame[1 + 2 * (2 + 14 + 255 + 1)];
+	uint8_t* pos = frame;
+	uint8_t checksum = 0;
+	uint16_t len = 14 + pLen;
+	_respCd = -1;
 
-    _serialPort->send(START_BYTE);
-    send(0x00);              // Message Length
-    send(14 + pLen);         // Message Length
+	*pos++ = START_BYTE;
+	pos += escape(pos, len >> 8);    // Message Length
+	pos += escape(pos, len & 0xff);  // Message Length
 
-    _serialPort->send(API_XMITREQUEST); // Transmit Request API
-    checksum += API_XMITREQUEST;
+	pos += escape(pos, API_XMITREQUEST); // Transmit Request API
+	checksum += API_XMITREQUEST;
 
-    if (_frameId++ == 0x00 ) // Frame ID
+	if (_frameId++ == 0x00 ) // Frame ID
 	{
-    	_frameId = 1;
+		_frameId = 1;
 	}
-    send(_frameId);
-    checksum += _frameId;
+	pos += escape(pos, _frameId);
+	checksum += _frameId;
 
 	for ( int i = 0; i < 8; i++)    // Address64
 	{
-		send(addr->_address64[i]);
+		pos += escape(pos, addr->_address64[i]);
 		checksum += addr->_address64[i];
 	}
 	for ( int i = 0; i < 2; i++)    // Address16
 	{
-		send(addr->_address16[i]);
+		pos += escape(pos, addr->_address16[i]);
 		checksum += addr->_address16[i];
 	}
 
-    send(0x00);   // Broadcast Radius
-    checksum += 0x00;
+	*pos++ = 0x00;   // Broadcast Radius
+	*pos++ = 0x00;   // Option: Use the extended transmission timeout 0x40
 
-    send(0x00);   // Option: Use the extended transmission timeout 0x40
-    checksum += 0x00;
-
-    D_NWSTACK("\r\n     Payload: ");
-
-    for ( uint8_t i = 0; i < pLen; i++ ){
-        send(payload[i]);     // Payload
-        checksum += payload[i];
-    }
+	for ( uint8_t i = 0; i < pLen; i++ ){
+		pos += escape(pos, payload[i]);     // Payload
+		checksum += payload[i];
+	}
 
-    checksum = 0xff - checksum;
-    D_NWSTACK("   checksum  ");
-    send(checksum);
-    D_NWSTACK("\r\n");
+	checksum = 0xff - checksum;
+	pos += escape(pos, checksum);
 
-    /* wait Txim Status 0x8B */
-    _sem.timedwait(XMIT_STATUS_TIME_OVER);
+	if ( !_serialPort->send(frame, pos - frame) )
+	{
+		return -1;
+	}
+	D_NWSTACK("\r\n");
 
-    if ( _respCd || _frameId != _respId )
-    {
-    	 D_NWSTACK(" frameId = %02x  Not Acknowleged\r\n", _frameId);
-    	return -1;
-    }
-    return (int)pLen;
-}
+	/* wait Txim Status 0x8B */
+	_sem.timedwait(XMIT_STATUS_TIME_OVER);
 
-void XBee::send(uint8_t c)
-{
-  if(_apiMode == 2 && (c == START_BYTE || c == ESCAPE || c == XON || c == XOFF)){
-	  _serialPort->send(ESCAPE);
-	  _serialPort->send(c ^ 0x20);
-  }else{
-	  _serialPort->send(c);
-  }
+	if ( _respCd || _frameId != _respId )
+	{
+		D_NWSTACK(" frameId = %02x  Not Acknowleged\r\n", _frameId);
+		return -1;
+	}
+	return (int)pLen;
 }
 
-int XBee::recv(uint8_t* buf)
+int XBee::escape(uint8_t* pos, uint8_t c)
 {
-	if (_serialPort->recv(buf) )
+	if (_apiMode == 2 && (c == START_BYTE || c == ESCAPE || c == XON || c == XOFF))
 	{
-		if ( *buf == ESCAPE && _apiMode == 2 )
-		{
-			_serialPort->recv(buf);
-			*buf = 0x20 ^ *buf;
-		}
-		return 0;
+		pos[0] = ESCAPE;
+		pos[1] = c ^ 0x20;
+		return 2;
 	}
-	return -1;
+	pos[0] = c;
+	return 1;
 }
 
 void XBee::setApiMode(uint8_t mode)
@@ -397,17 +450,37 @@ void XBee::setApiMode(uint8_t mode)
 	_apiMode = mode;
 }
 
+SerialPort* XBee::getSerialPort(void)
+{
+	return _serialPort;
+}
+
+uint32_t XBee::getFrameCount(void)
+{
+	return _frames;
+}
+
+uint32_t XBee::getChecksumErrorCount(void)
+{
+	return _checksumErrors;
+}
+
 /*=========================================
  Class SerialPort
  =========================================*/
 SerialPort::SerialPort()
 {
+	memset(&_tio, 0, sizeof(_tio));  // raw: no echo, canonical input or output processing
 	_tio.c_iflag = IGNBRK | IGNPAR;
 	_tio.c_cflag = CS8 | CLOCAL | CRTSCTS | CREAD;
 	_tio.c_cc[VINTR] = 0;
 	_tio.c_cc[VTIME] = 10;   // 1 sec.
 	_tio.c_cc[VMIN] = 1;
 	_fd = 0;
+	_rxPos = 0;
+	_rxLen = 0;
+	_reads = 0;
+	_writes = 0;
 }
 
 SerialPort::~SerialPort()
@@ -443,20 +516,46 @@ int SerialPort::open(char* devName, unsigned int baudrate, bool parity,
 	return tcsetattr(_fd, TCSANOW, &_tio);
 }
 
-bool SerialPort::send(unsigned char b)
+bool SerialPort::send(const uint8_t* buf, int len)
 {
-	if (write(_fd, &b, 1) < 0)
+	while (len > 0)
 	{
-		return false;
+		int rc = write(_fd, buf, len);
+		if (rc < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			return false;
+		}
+		_writes++;
+#ifdef  DEBUG_NWSTACK
+		for (int i = 0; i < rc; i++)
+		{
+			D_NWSTACK( " %02x", buf[i]);
+		}
+#endif
+		buf += rc;
+		len -= rc;
 	}
-	else
+	return true;
+}
+
+bool SerialPort::recv(unsigned char* buf)
+{
+	if (_rxPos == _rxLen && !fill())
 	{
-		D_NWSTACK( " %02x", b);
-		return true;
+		return false;
 	}
+	*buf = _rxBuf[_rxPos++];
+	return true;
 }
 
-bool SerialPort::recv(unsigned char* buf)
+/*
+ *  Waits up to 500ms for the port to become readable, then reads everything available into the buffer.
+ */
+bool SerialPort::fill(void)
 {
     struct timeval timeout;
     fd_set rfds;
@@ -464,11 +563,20 @@ bool SerialPort::recv(unsigned char* buf)
     FD_SET(_fd, &rfds);
     timeout.tv_sec = 0;
     timeout.tv_usec = 500000;    // 500ms
+    _rxPos = _rxLen = 0;
     if ( select(_fd + 1, &rfds, 0, 0, &timeout) > 0 )
     {
-        if (read(_fd, buf, 1) > 0)
+        int len = read(_fd, _rxBuf, sizeof(_rxBuf));
+        if (len > 0)
         {
-            D_NWSTACK( " %02x",buf[0] );
+            _reads++;
+#ifdef  DEBUG_NWSTACK
+            for (int i = 0; i < len; i++)
+            {
+                D_NWSTACK( " %02x", _rxBuf[i]);
+            }
+#endif
+            _rxLen = len;
             return true;
         }
     }
@@ -477,6 +585,16 @@ bool SerialPort::recv(unsigned char* buf)
 
 void SerialPort::flush(void)
 {
+	_rxPos = _rxLen = 0;
 	tcsetattr(_fd, TCSAFLUSH, &_tio);
 }
 
+uint32_t SerialPort::getReadCount(void)
+{
+	return _reads;
+}
+
+uint32_t SerialPort::getWriteCount(void)
+{
+	return _writes;
+}
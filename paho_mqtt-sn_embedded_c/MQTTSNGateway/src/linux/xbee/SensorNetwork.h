@@ -40,6 +40,9 @@ namespace MQTTSNGW
 
 #define XMIT_STATUS_TIME_OVER    5000
 
+#define XBEE_MAX_FRAME           256     // longest API frame data accepted
+#define SERIAL_RX_BUFFER_SIZE    1024
+
 #define START_BYTE               0x7e
 #define ESCAPE                   0x7d
 #define XON                      0x11
@@ -53,13 +56,22 @@ public:
 	SerialPort();
 	~SerialPort();
 	int open(char* devName, unsigned int baudrate,  bool parity, unsigned int stopbit, unsigned int flg);
-	bool send(unsigned char b);
+	bool send(const uint8_t* buf, int len);
 	bool recv(unsigned char* b);
 	void flush();
+	uint32_t getReadCount(void);
+	uint32_t getWriteCount(void);
 
 private:
+	bool fill(void);
+
 	int _fd;  // file descriptor
 	struct termios _tio;
+	uint8_t _rxBuf[SERIAL_RX_BUFFER_SIZE];  // bytes read ahead of the frame parser
+	int _rxPos;
+	int _rxLen;
+	uint32_t _reads;
+	uint32_t _writes;
 };
 
 /*===========================================
@@ -75,6 +87,7 @@ public:
 	int  setAddress(string* data);
 	void setBroadcastAddress(void);
 	bool isMatch(SensorNetAddress* addr);
+	uint32_t hash(void);
 	SensorNetAddress& operator =(SensorNetAddress& addr);
 	char* sprint(char*);
 private:
@@ -94,15 +107,23 @@ public:
 	int open(char* device, int boudrate);
 	void close(void);
 	int unicast(const uint8_t* buf, uint16_t length, SensorNetAddress* sendToAddr);
+	int unicast(const uint8_t** bufs, const uint16_t* lengths, int count, SensorNetAddress* sendToAddr);
 	int broadcast(const uint8_t* buf, uint16_t length);
 	int recv(uint8_t* buf, uint16_t len, SensorNetAddress* addr);
 	void setApiMode(uint8_t mode);
+	SerialPort* getSerialPort(void);
+	uint32_t getFrameCount(void);
+	uint32_t getChecksumErrorCount(void);
 
 private:
-	int readApiFrame(uint8_t* recvData);
-	int recv(uint8_t* buf);
+	enum FrameState
+	{
+		FRAME_START, FRAME_LENGTH_MSB, FRAME_LENGTH_LSB, FRAME_DATA, FRAME_CHECKSUM
+	};
+
+	int readApiFrame(void);
 	int send(const uint8_t* payload, uint8_t pLen, SensorNetAddress* addr);
-	void send(uint8_t b);
+	int escape(uint8_t* pos, uint8_t b);
 
 	Semaphore _sem;
 	Mutex _meutex;
@@ -112,6 +133,16 @@ private:
 	uint8_t _respId;
 	uint8_t _dataLen;
 	uint8_t _apiMode;
+
+	/* receive frame state, kept between calls so that a frame may arrive in pieces */
+	FrameState _frameState;
+	bool _escaped;
+	uint16_t _frameLen;
+	uint16_t _framePos;
+	uint8_t _frameChecksum;
+	uint8_t _frame[XBEE_MAX_FRAME];
+	uint32_t _frames;
+	uint32_t _checksumErrors;
 };
 
 /*===========================================
@@ -124,6 +155,7 @@ public:
 	~SensorNetwork();
 
 	int unicast(const uint8_t* payload, uint16_t payloadLength, SensorNetAddress* sendto);
+	int unicast(const uint8_t** payloads, const uint16_t* payloadLengths, int count, SensorNetAddress* sendto);
 	int broadcast(const uint8_t* payload, uint16_t payloadLength);
 	int read(uint8_t* buf, uint16_t bufLen);
 	int initialize(void);
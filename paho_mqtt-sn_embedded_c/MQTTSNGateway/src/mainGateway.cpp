@@ -19,6 +19,7 @@
 #include "MQTTSNGWClientRecvTask.h"
 #include "MQTTSNGWClientSendTask.h"
 #include "MQTTSNGWPacketHandleTask.h"
+#include "MQTTSNGWBrokerPoolTask.h"
 
 using namespace MQTTSNGW;
 
@@ -31,6 +32,7 @@ ClientRecvTask    task2(&gateway);
 ClientSendTask    task3(&gateway);
 BrokerRecvTask    task4(&gateway);
 BrokerSendTask    task5(&gateway);
+BrokerPoolTask    task6(&gateway);
 
 int main(int argc, char** argv)
 {
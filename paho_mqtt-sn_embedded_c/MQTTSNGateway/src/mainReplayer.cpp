@@ -0,0 +1,90 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - replay of captured datagrams
+ **************************************************************************************/
+
+#include "MQTTSNGWReplayer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <getopt.h>
+
+using namespace MQTTSNGW;
+
+/*
+ *   Replayer process
+ *
+ *   MQTT-SNReplayer [-a gatewayIP] [-p gatewayPortNo] [-c capturedPortNo] [-s speed] capture.pcap
+ *
+ *   -s 1 replays at the speed of the capture, -s 10 ten times faster, -s 0 as fast as possible.
+ *   -c is the GatewayPortNo of the captured gateway, -p by default.
+ */
+int main(int argc, char** argv)
+{
+	const char* ipAddress = "127.0.0.1";
+	int portNo = 10000;
+	int capturedPortNo = 0;
+	double speed = 1;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "a:p:c:s:")) != -1)
+	{
+		switch (opt)
+		{
+		case 'a':
+			ipAddress = optarg;
+			break;
+		case 'p':
+			portNo = atoi(optarg);
+			break;
+		case 'c':
+			capturedPortNo = atoi(optarg);
+			break;
+		case 's':
+			speed = atof(optarg);
+			break;
+		default:
+			optind = argc;
+			break;
+		}
+	}
+	if (optind != argc - 1 || speed < 0)
+	{
+		fprintf(stderr, "Usage: %s [-a gatewayIP] [-p gatewayPortNo] [-c capturedPortNo] [-s speed, 0: max] capture.pcap\n", argv[0]);
+		return 1;
+	}
+
+	Replayer replayer;
+	if (!replayer.open(argv[optind], ipAddress, portNo, capturedPortNo ? capturedPortNo : portNo))
+	{
+		fprintf(stderr, "Can't replay %s to %s:%d\n", argv[optind], ipAddress, portNo);
+		return 1;
+	}
+	if (replayer.run(speed) < 0)
+	{
+		fprintf(stderr, "Can't create a socket for a sender\n");
+		return 1;
+	}
+
+	ReplayCounters counters;
+	replayer.getCounters(&counters);
+	double secs = counters.elapsed / 1e9;
+	printf("%u datagrams of %u clients replayed in %.3f secs, %.0f/sec, %u failed\n", counters.sent, counters.senders, secs,
+			secs > 0 ? counters.sent / secs : 0, counters.failed);
+	if (speed > 0)
+	{
+		printf("%u sent more than 1 msec late, max lag %.3f msecs\n", counters.late, counters.maxLag / 1e6);
+	}
+	printf("%u replies from the gateway\n", counters.replies);
+	return 0;
+}
@@ -0,0 +1,215 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - AggregateTopicTable tests
+ **************************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <string>
+#include <cassert>
+#include "TestAggregateTopicTable.h"
+#include "MQTTSNGWClient.h"
+
+using namespace std;
+using namespace MQTTSNGW;
+
+static double elapsedUsec(struct timespec* start)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start->tv_sec) * 1e6 + (now.tv_nsec - start->tv_nsec) / 1e3;
+}
+
+TestAggregateTopicTable::TestAggregateTopicTable()
+{
+
+}
+
+TestAggregateTopicTable::~TestAggregateTopicTable()
+{
+
+}
+
+/* 10 sites, each with one filter that covers the other four of the site */
+void TestAggregateTopicTable::setFilter(char* buf, int filter)
+{
+	int site = filter / 5;
+	switch ( filter % 5 )
+	{
+	case 0:
+		sprintf(buf, "site/%d/dev/+/cmd", site);
+		break;
+	case 1:
+		sprintf(buf, "site/%d/dev/%d/status", site, site);
+		break;
+	case 2:
+		sprintf(buf, "site/%d/#", site);
+		break;
+	case 3:
+		sprintf(buf, "site/%d/+/+/cmd", site);
+		break;
+	default:
+		sprintf(buf, "site/%d/dev", site);
+		break;
+	}
+}
+
+/* sends nothing, counts what would be sent, returns the number of updates */
+int TestAggregateTopicTable::drain(AggregateTopicTable* table, int* subscribes, int* unsubscribes)
+{
+	string filter;
+	uint8_t qos;
+	bool subscribe;
+	int cnt = 0;
+	bool unsubscribed = false;
+
+	while ( table->getUpdate(&filter, &qos, &subscribe) )
+	{
+		assert(!(subscribe && unsubscribed));   // SUBSCRIBEs go first
+		unsubscribed = !subscribe;
+		(subscribe ? *subscribes : *unsubscribes) += 1;
+		cnt++;
+	}
+	return cnt;
+}
+
+void TestAggregateTopicTable::test(void)
+{
+	char buf[64];
+	int subscribes = 0;
+	int unsubscribes = 0;
+	string filter;
+	uint8_t qos;
+	bool subscribe;
+
+	/* covering filters */
+	assert(AggregateTopicTable::covers("a/#", "a/+/c"));
+	assert(AggregateTopicTable::covers("a/#", "a"));
+	assert(AggregateTopicTable::covers("a/+/c", "a/b/c"));
+	assert(AggregateTopicTable::covers("+/+", "a/+"));
+	assert(AggregateTopicTable::covers("#", "a/b/c"));
+	assert(!AggregateTopicTable::covers("a/+/c", "a/#"));
+	assert(!AggregateTopicTable::covers("a/+", "a"));
+	assert(!AggregateTopicTable::covers("a/+", "a/b/c"));
+	assert(!AggregateTopicTable::covers("a/b", "a/c"));
+	assert(!AggregateTopicTable::covers("#", "$SYS/broker"));
+
+	/* a wider filter takes over, the narrower one is unsubscribed after it */
+	AggregateTopicTable* table = new AggregateTopicTable();
+	Client* c1 = new Client();
+	Client* c2 = new Client();
+	table->add("a/+/c", 1, c1);
+	assert(table->getUpdate(&filter, &qos, &subscribe) && subscribe && filter == "a/+/c" && qos == 1);
+	assert(!table->getUpdate(&filter, &qos, &subscribe));
+	table->add("a/#", 0, c2);
+	assert(table->getUpdate(&filter, &qos, &subscribe) && subscribe && filter == "a/#" && qos == 1);
+	assert(table->getUpdate(&filter, &qos, &subscribe) && !subscribe && filter == "a/+/c");
+	assert(!table->getUpdate(&filter, &qos, &subscribe));
+	assert(table->getBrokerCount() == 1);
+
+	/* a covered filter asking for a higher QoS subscribes the covering one again */
+	table->add("a/b", 2, c1);
+	assert(table->getUpdate(&filter, &qos, &subscribe) && subscribe && filter == "a/#" && qos == 2);
+	assert(!table->getUpdate(&filter, &qos, &subscribe));
+
+	/* a PUBLISH reaches a client once */
+	AggregateTopicElement* list = table->getClientList("a/b/c");
+	assert(list && list->getCount() == 2);
+	delete list;
+	assert(table->getClientList("b") == nullptr);
+
+	/* the covered filters are subscribed again before the last client of a/# leaves */
+	table->remove("a/#", c2);
+	assert(table->getUpdate(&filter, &qos, &subscribe) && subscribe);
+	assert(table->getUpdate(&filter, &qos, &subscribe) && subscribe);
+	assert(table->getUpdate(&filter, &qos, &subscribe) && !subscribe && filter == "a/#");
+	assert(!table->getUpdate(&filter, &qos, &subscribe));
+	assert(table->getBrokerCount() == 2 && table->getCount() == 2);
+	table->remove(c1);
+	assert(drain(table, &subscribes, &unsubscribes) == 2 && unsubscribes == 2);
+	assert(table->getCount() == 0 && table->getBrokerCount() == 0);
+	delete table;
+	delete c1;
+	delete c2;
+
+	/* 10k clients sharing 50 filters */
+	Client** clients = new Client*[TEST_AGGREGATE_CLIENTS];
+	for ( int i = 0; i < TEST_AGGREGATE_CLIENTS; i++ )
+	{
+		clients[i] = new Client();
+	}
+	table = new AggregateTopicTable();
+	subscribes = unsubscribes = 0;
+	int answered = 0;
+	double answeredUsec = 0;
+	double maxUsec = 0;
+	struct timespec start;
+
+	for ( int i = 0; i < TEST_AGGREGATE_CLIENTS; i++ )
+	{
+		for ( int j = 0; j < TEST_AGGREGATE_SUBSCRIPTIONS; j++ )
+		{
+			int before = subscribes;
+			clock_gettime(CLOCK_MONOTONIC, &start);
+			setFilter(buf, (i * 7 + j * 11) % TEST_AGGREGATE_FILTERS);
+			table->add(buf, i % 3, clients[i]);
+			drain(table, &subscribes, &unsubscribes);
+			double usec = elapsedUsec(&start);
+			if ( subscribes == before )
+			{
+				/* covered, SUBACK from the gateway */
+				answered++;
+				answeredUsec += usec;
+				maxUsec = usec > maxUsec ? usec : maxUsec;
+			}
+		}
+	}
+	int subscriptions = TEST_AGGREGATE_CLIENTS * TEST_AGGREGATE_SUBSCRIPTIONS;
+	assert(table->getCount() == TEST_AGGREGATE_FILTERS);
+	assert(table->getBrokerCount() == TEST_AGGREGATE_FILTERS / 5);
+	int brokerSubscribes = subscribes;
+	int brokerUnsubscribes = unsubscribes;
+
+	/* every client of a site gets a site's PUBLISH once */
+	list = table->getClientList("site/3/dev/3/cmd");
+	assert(list != nullptr);
+	int received = list->getCount();
+	delete list;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	subscribes = unsubscribes = 0;
+	for ( int i = 0; i < TEST_AGGREGATE_CLIENTS; i++ )
+	{
+		table->remove(clients[i]);
+		drain(table, &subscribes, &unsubscribes);
+	}
+	double removeUsec = elapsedUsec(&start);
+	assert(table->getCount() == 0 && table->getBrokerCount() == 0);
+
+	delete table;
+	for ( int i = 0; i < TEST_AGGREGATE_CLIENTS; i++ )
+	{
+		delete clients[i];
+	}
+	delete[] clients;
+
+	printf("[ OK ]\n");
+	printf("      %d clients x %d of %d filters: %d broker SUBSCRIBEs and %d UNSUBSCRIBEs instead of %d, %d filters subscribed\n",
+			TEST_AGGREGATE_CLIENTS, TEST_AGGREGATE_SUBSCRIPTIONS, TEST_AGGREGATE_FILTERS,
+			brokerSubscribes, brokerUnsubscribes, subscriptions, TEST_AGGREGATE_FILTERS / 5);
+	printf("      SUBACK from the gateway for %d SUBSCRIBEs: %.2f usecs on average, %.1f usecs max\n",
+			answered, answeredUsec / answered, maxUsec);
+	printf("      PUBLISH to site/3/dev/3/cmd delivered to %d clients, all clients unsubscribed in %.1f msecs\n",
+			received, removeUsec / 1000);
+}
@@ -0,0 +1,44 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - AggregateTopicTable tests
+ **************************************************************************************/
+#ifndef MQTTSNGATEWAY_SRC_TESTS_TESTAGGREGATETOPICTABLE_H_
+#define MQTTSNGATEWAY_SRC_TESTS_TESTAGGREGATETOPICTABLE_H_
+
+#include "MQTTSNGWAggregateTopicTable.h"
+
+#define TEST_AGGREGATE_CLIENTS        10000
+#define TEST_AGGREGATE_FILTERS           50
+#define TEST_AGGREGATE_SUBSCRIPTIONS      5   // filters each client subscribes to
+
+using namespace MQTTSNGW;
+
+/*
+ *  TEST_AGGREGATE_CLIENTS aggregated clients subscribe to TEST_AGGREGATE_FILTERS filters
+ *  that cover each other, and the SUBSCRIBEs the broker receives are counted against
+ *  forwarding every SUBSCRIBE of every client.
+ */
+class TestAggregateTopicTable
+{
+public:
+	TestAggregateTopicTable();
+	~TestAggregateTopicTable();
+	void test(void);
+
+private:
+	void setFilter(char* buf, int filter);
+	int drain(AggregateTopicTable* table, int* subscribes, int* unsubscribes);
+};
+
+#endif /* MQTTSNGATEWAY_SRC_TESTS_TESTAGGREGATETOPICTABLE_H_ */
@@ -0,0 +1,204 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - BackPressure tests
+ **************************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <cassert>
+#include "TestBackPressure.h"
+#include "MQTTGWPacket.h"
+
+using namespace std;
+using namespace MQTTSNGW;
+
+#define TEST_PAYLOAD_LENGTH   180
+#define TEST_SOCKET_BUFFER   4096
+
+TestBackPressure::TestBackPressure()
+{
+	_listener = -1;
+	_port[0] = 0;
+	_brokerThread = 0;
+	_received = 0;
+	_client = nullptr;
+	_que = nullptr;
+}
+
+TestBackPressure::~TestBackPressure()
+{
+}
+
+/*
+ *  Accepts one connection and reads it 1 KB every 5 msecs, about 200 KB/s.
+ *  The small receive buffer keeps the kernel from absorbing the backlog.
+ */
+bool TestBackPressure::startBroker(void)
+{
+	struct sockaddr_in addr;
+	socklen_t len = sizeof(addr);
+	int size = TEST_SOCKET_BUFFER;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	_listener = socket(AF_INET, SOCK_STREAM, 0);
+	if ( _listener < 0 || setsockopt(_listener, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size)) != 0
+			|| bind(_listener, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(_listener, 1) != 0
+			|| getsockname(_listener, (struct sockaddr*)&addr, &len) != 0 )
+	{
+		return false;
+	}
+	sprintf(_port, "%d", ntohs(addr.sin_port));
+	_received = 0;
+	return pthread_create(&_brokerThread, 0, runBroker, this) == 0;
+}
+
+void* TestBackPressure::runBroker(void* arg)
+{
+	TestBackPressure* test = (TestBackPressure*)arg;
+	uint8_t buf[1024];
+	int sock = accept(test->_listener, 0, 0);
+	int r;
+
+	while ( sock >= 0 && (r = recv(sock, buf, sizeof(buf), 0)) > 0 )
+	{
+		test->_received += r;
+		usleep(5000);
+	}
+	if ( sock >= 0 )
+	{
+		close(sock);
+	}
+	close(test->_listener);
+	return 0;
+}
+
+/* writes the packets to the broker the way BrokerSendTask does, one event at a time */
+void* TestBackPressure::runSender(void* arg)
+{
+	TestBackPressure* test = (TestBackPressure*)arg;
+
+	while ( true )
+	{
+		Event* ev = test->_que->wait();
+		if ( ev->getEventType() == EtStop )
+		{
+			delete ev;
+			return 0;
+		}
+		assert(ev->getMQTTGWPacket()->send(ev->getClient()->getNetwork()) > 0);
+		delete ev;
+	}
+}
+
+/*
+ *  Publishes as fast as the gateway accepts, a refused PUBLISH is retried after a msec.
+ *  @return the number of refused PUBLISHes
+ */
+uint32_t TestBackPressure::publish(uint32_t maxBacklog, uint32_t* peakBacklog, int* highWater)
+{
+	char payload[TEST_PAYLOAD_LENGTH];
+	pthread_t sender;
+	uint32_t rejected = 0;
+	uint32_t bytes = 0;
+
+	memset(payload, 'x', sizeof(payload));
+	assert(startBroker());
+	_client = new Client();
+	_que = new EventQue();
+	Network* network = _client->getNetwork();
+	assert(network->connect("127.0.0.1", _port));
+	int size = TEST_SOCKET_BUFFER;
+	setsockopt(network->getSock(), SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+	assert(pthread_create(&sender, 0, runSender, this) == 0);
+
+	*peakBacklog = 0;
+	for ( int i = 0; i < TEST_BACKPRESSURE_PUBLISHES; )
+	{
+		if ( network->isCongested(maxBacklog, 0) )
+		{
+			rejected++;
+			usleep(1000);
+			continue;
+		}
+		Publish pub = MQTTPacket_Publish_Initializer;
+		pub.header.bits.type = PUBLISH;
+		pub.header.bits.qos = 1;
+		pub.topic = const_cast<char*>("backpressure/test");
+		pub.topiclen = strlen(pub.topic);
+		pub.msgId = ++i;
+		pub.payload = payload;
+		pub.payloadlen = sizeof(payload);
+
+		MQTTGWPacket* packet = new MQTTGWPacket();
+		packet->setPUBLISH(&pub);
+		bytes += packet->getPacketLength();
+		Event* ev = new Event();
+		ev->setBrokerSendEvent(_client, packet);
+		_que->post(ev);
+		if ( network->getBacklog() > *peakBacklog )
+		{
+			*peakBacklog = network->getBacklog();
+		}
+	}
+
+	Event* stop = new Event();
+	stop->setStop();
+	_que->post(stop);
+	pthread_join(sender, 0);
+	assert(network->getBacklog() == 0);
+	*highWater = _que->getHighWater();
+	assert(_que->getDropCnt() == 0);
+
+	network->close();
+	pthread_join(_brokerThread, 0);
+	assert(_received == bytes);
+	delete _que;
+	delete _client;
+	return rejected;
+}
+
+void TestBackPressure::test(void)
+{
+	uint32_t peak[2];
+	int highWater[2];
+
+	assert(publish(0, &peak[0], &highWater[0]) == 0);
+	uint32_t rejected = publish(TEST_BACKPRESSURE_BACKLOG, &peak[1], &highWater[1]);
+
+	assert(rejected > 0);
+	assert(peak[1] < TEST_BACKPRESSURE_BACKLOG + MQTTSNGW_MAX_PACKET_SIZE);
+	assert(peak[0] > peak[1] * 4);
+
+	/* in-flight PUBLISHes */
+	Network network(false);
+	for ( int i = 0; i < MAX_INFLIGHTMESSAGES; i++ )
+	{
+		assert(!network.isCongested(0, MAX_INFLIGHTMESSAGES));
+		network.addInflight(1);
+	}
+	assert(network.isCongested(0, MAX_INFLIGHTMESSAGES));
+	network.addInflight(-1);
+	assert(!network.isCongested(0, MAX_INFLIGHTMESSAGES));
+	network.close();
+	assert(network.getInflight() == 0);
+
+	printf("[ OK ]\n");
+	printf("      %d PUBLISHes to a slow broker: backlog %u bytes/%d events unlimited, %u bytes/%d events limited, %u retries\n",
+			TEST_BACKPRESSURE_PUBLISHES, peak[0], highWater[0], peak[1], highWater[1], rejected);
+}
@@ -0,0 +1,56 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - BackPressure tests
+ **************************************************************************************/
+#ifndef MQTTSNGATEWAY_SRC_TESTS_TESTBACKPRESSURE_H_
+#define MQTTSNGATEWAY_SRC_TESTS_TESTBACKPRESSURE_H_
+
+#include <pthread.h>
+#include "MQTTSNGateway.h"
+#include "MQTTSNGWClient.h"
+
+#define TEST_BACKPRESSURE_PUBLISHES  1000
+#define TEST_BACKPRESSURE_BACKLOG    4096
+
+using namespace MQTTSNGW;
+
+/*
+ *  Publishes to a broker stand-in that reads slower than the client publishes,
+ *  through an EventQue and a thread standing in for BrokerSendTask.
+ *  Without a backlog limit the packets pile up in the que, with it the client is
+ *  refused and retries, and the backlog stays at the limit.
+ */
+class TestBackPressure
+{
+public:
+	TestBackPressure();
+	~TestBackPressure();
+	void test(void);
+
+	static void* runBroker(void* arg);
+	static void* runSender(void* arg);
+
+private:
+	bool startBroker(void);
+	uint32_t publish(uint32_t maxBacklog, uint32_t* peakBacklog, int* highWater);
+
+	int _listener;
+	char _port[8];
+	pthread_t _brokerThread;
+	uint32_t _received;
+	Client* _client;
+	EventQue* _que;
+};
+
+#endif /* MQTTSNGATEWAY_SRC_TESTS_TESTBACKPRESSURE_H_ */
@@ -0,0 +1,143 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - BrokerPool tests
+ **************************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <cassert>
+#include "TestBrokerPool.h"
+#include "MQTTSNGWClient.h"
+#include "MQTTGWPacket.h"
+
+using namespace std;
+using namespace MQTTSNGW;
+
+static double elapsedSec(struct timespec* start)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+TestBrokerPool::TestBrokerPool()
+{
+	_client = new Client(true);
+}
+
+TestBrokerPool::~TestBrokerPool()
+{
+	delete _client;
+}
+
+/*
+ *  Connections not taken are replaced after the idle secs.
+ */
+void TestBrokerPool::testIdle(void)
+{
+	BrokerPool pool;
+	BrokerPoolCounters counters;
+
+	assert(pool.refill(&_params) == 0);
+	assert(!pool.take(_client));
+
+	pool.initialize(2, 1);
+	assert(pool.refill(&_params) == 0);
+
+	/* the kind of connection of a client taking none is kept from then on */
+	assert(!pool.take(_client));
+	assert(pool.refill(&_params) == 2);
+	assert(pool.getCount(true) == 2 && pool.getCount(false) == 0);
+	assert(pool.refill(&_params) == 0);
+
+	usleep(1100000);
+	assert(pool.refill(&_params) == 2);
+	assert(pool.getCount(true) == 2);
+
+	pool.getCounters(&counters);
+	assert(counters.hits == 0 && counters.misses == 1 && counters.opened == 4 && counters.expired == 2);
+	pool.clear();
+	assert(pool.getCount(true) == 0);
+}
+
+/*
+ *  CONNECT and wait for the CONNACK, TEST_POOL_CONNECTS times, the pool being refilled in between.
+ *  @return the average secs.
+ */
+double TestBrokerPool::connect(BrokerPool* pool)
+{
+	/* CONNECT, MQTT 3.1.1, clean session, keep alive 60 secs, empty ClientId */
+	const uint8_t frame[] = { CONNECT << 4, 12, 0, 4, 'M', 'Q', 'T', 'T', 4, 2, 0, 60, 0, 0 };
+	struct timespec start;
+	double secs = 0;
+
+	for (int i = 0; i < TEST_POOL_CONNECTS; i++)
+	{
+		pool->refill(&_params);
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		Network* network = _client->getNetwork();
+		if (!pool->take(_client))
+		{
+			assert(network->connect(_params.brokerName, _params.portSecure, 0, _params.rootCAfile, 0, 0));
+		}
+		assert(network->send(frame, sizeof(frame)) == sizeof(frame));
+		MQTTGWPacket connack;
+		assert(connack.recv(network) > 0 && connack.getType() == CONNACK);
+		secs += elapsedSec(&start);
+
+		network->close();
+	}
+	return secs / TEST_POOL_CONNECTS;
+}
+
+void TestBrokerPool::test(void)
+{
+	TLSSessionCache* cache = Network::getSessionCache();
+	BrokerPoolCounters counters;
+
+	/* testIdle, then the clients connecting themselves, then through the pool */
+	assert(_server.startBroker(4 + TEST_POOL_CONNECTS + TEST_POOL_CONNECTS + TEST_POOL_SIZE - 1, true));
+	_params.brokerName = (char*)"127.0.0.1";
+	_params.portSecure = (char*)_server.getPort();
+	_params.rootCAfile = (char*)_server.getCAFile();
+
+	testIdle();
+
+	BrokerPool off;
+	double offSecs = connect(&off);
+
+	BrokerPool pool;
+	pool.initialize(TEST_POOL_SIZE, DEFAULT_BROKER_POOL_IDLE);
+	pool.prepare(true);
+	uint32_t resumed = cache->getResumedHandshakes();
+	double poolSecs = connect(&pool);
+	pool.getCounters(&counters);
+	assert(counters.hits == TEST_POOL_CONNECTS && counters.misses == 0);
+	assert(counters.opened == TEST_POOL_CONNECTS + TEST_POOL_SIZE - 1);
+	/* the first ones are opened at once, before a session ticket of TLS 1.3 is read */
+	assert(cache->getResumedHandshakes() - resumed >= counters.opened - TEST_POOL_SIZE);
+	pool.clear();
+	_server.stop();
+
+	_params.brokerName = nullptr;
+	_params.portSecure = nullptr;
+	_params.rootCAfile = nullptr;
+	assert(poolSecs < offSecs);
+
+	printf("[ OK ]\n");
+	printf("      CONNECT to CONNACK through TLS: %.2f msecs connecting with a resumed session, %.2f msecs with a pooled connection\n",
+			offSecs * 1e3, poolSecs * 1e3);
+}
@@ -0,0 +1,50 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - BrokerPool tests
+ **************************************************************************************/
+#ifndef MQTTSNGATEWAY_SRC_TESTS_TESTBROKERPOOL_H_
+#define MQTTSNGATEWAY_SRC_TESTS_TESTBROKERPOOL_H_
+
+#include "TestTLSServer.h"
+#include "MQTTSNGateway.h"
+
+#define TEST_POOL_SIZE        4
+#define TEST_POOL_CONNECTS   50
+
+namespace MQTTSNGW
+{
+
+/*
+ *  BrokerPool, and the time from a client's CONNECT to the CONNACK of a TLS broker stand-in
+ *  when the client connects itself, resuming the TLS session, and when it takes a pooled connection.
+ */
+class TestBrokerPool
+{
+public:
+	TestBrokerPool();
+	~TestBrokerPool();
+	void test(void);
+
+private:
+	void testIdle(void);
+	double connect(BrokerPool* pool);
+
+	TestTLSServer _server;
+	GatewayParams _params;
+	Client* _client;
+};
+
+}
+
+#endif /* MQTTSNGATEWAY_SRC_TESTS_TESTBROKERPOOL_H_ */
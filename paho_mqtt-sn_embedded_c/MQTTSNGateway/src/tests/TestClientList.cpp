@@ -0,0 +1,176 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - ClientList tests
+ **************************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <string>
+#include <cassert>
+#include "TestClientList.h"
+
+using namespace std;
+using namespace MQTTSNGW;
+
+#define LINEAR_SAMPLES   1000
+
+static double elapsedSec(struct timespec* start)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static void setAddress(SensorNetAddress* addr, int i)
+{
+	char buf[32];
+	sprintf(buf, "10.%d.%d.%d:%d", i >> 16, (i >> 8) & 0xff, i & 0xff, 10000 + i % 50000);
+	string str = string(buf);
+	addr->setAddress(&str);
+}
+
+TestClientList::TestClientList()
+{
+
+}
+
+TestClientList::~TestClientList()
+{
+	unlink(TEST_LIST_CLIENTS_FILE);
+	unlink(TEST_LIST_TOPICS_FILE);
+	unlink(TEST_LIST_CLIENTS_FILE CLIENTLIST_SNAPSHOT_SUFFIX);
+	unlink(TEST_LIST_TOPICS_FILE CLIENTLIST_SNAPSHOT_SUFFIX);
+}
+
+void TestClientList::setClientId(MQTTSNString* id, char* buf, int i)
+{
+	sprintf(buf, "Client%05d", i);
+	id->cstring = buf;
+}
+
+void TestClientList::writeLists(void)
+{
+	FILE* fp = fopen(TEST_LIST_CLIENTS_FILE, "w");
+	assert(fp);
+	fprintf(fp, "#Client List\n");
+	for ( int i = 0; i < TEST_LIST_CLIENTS; i++ )
+	{
+		fprintf(fp, "Client%05d,10.%d.%d.%d:%d%s\n", i, i >> 16, (i >> 8) & 0xff, i & 0xff, 10000 + i % 50000,
+				(i % 3) ? "" : ",unstableLine");
+	}
+	fclose(fp);
+
+	fp = fopen(TEST_LIST_TOPICS_FILE, "w");
+	assert(fp);
+	fprintf(fp, "#Predefined Topic List\n");
+	for ( int i = 0; i < TEST_LIST_CLIENTS; i++ )
+	{
+		for ( int j = 1; j <= TEST_LIST_TOPICS; j++ )
+		{
+			fprintf(fp, "Client%05d, sensors/%05d/%d, %d\n", i, i, j, j);
+		}
+	}
+	fclose(fp);
+
+	unlink(TEST_LIST_CLIENTS_FILE CLIENTLIST_SNAPSHOT_SUFFIX);
+	unlink(TEST_LIST_TOPICS_FILE CLIENTLIST_SNAPSHOT_SUFFIX);
+}
+
+double TestClientList::load(ClientList* list)
+{
+	struct timespec start;
+
+	list->setMaxClients(TEST_LIST_CLIENTS);
+	list->setSnapshot(true);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	assert(list->createList(TEST_LIST_CLIENTS_FILE, TRANSPEARENT_TYPE));
+	assert(list->readPredefinedList(TEST_LIST_TOPICS_FILE, false));
+	return elapsedSec(&start);
+}
+
+void TestClientList::check(ClientList* list)
+{
+	char buf[16];
+	MQTTSNString id = MQTTSNString_initializer;
+	SensorNetAddress addr;
+
+	assert(list->getClientCount() == TEST_LIST_CLIENTS);
+	for ( int i = 0; i < TEST_LIST_CLIENTS; i++ )
+	{
+		setClientId(&id, buf, i);
+		Client* client = list->getClient(&id);
+		assert(client != nullptr);
+		assert(strcmp(client->getClientId(), buf) == 0);
+		assert(client->getTopics()->getCount() == TEST_LIST_TOPICS);
+		assert(client->isSensorNetStable() == ((i % 3) != 0));
+		setAddress(&addr, i);
+		assert(list->getClient(&addr) == client);
+	}
+
+	/* a prefix or an extension of a ClientId is another client */
+	id.cstring = (char*)"Client0000";
+	assert(list->getClient(&id) == nullptr);
+	id.cstring = (char*)"Client000000";
+	assert(list->getClient(&id) == nullptr);
+}
+
+void TestClientList::test(void)
+{
+	writeLists();
+
+	ClientList* list = new ClientList();
+	double text = load(list);
+	check(list);
+	assert(access(TEST_LIST_CLIENTS_FILE CLIENTLIST_SNAPSHOT_SUFFIX, R_OK) == 0);
+	assert(access(TEST_LIST_TOPICS_FILE CLIENTLIST_SNAPSHOT_SUFFIX, R_OK) == 0);
+
+	/* a client that connects from a new address is found by it */
+	char buf[16];
+	MQTTSNString id = MQTTSNString_initializer;
+	SensorNetAddress addr;
+	setClientId(&id, buf, 7);
+	Client* client = list->getClient(&id);
+	setAddress(&addr, TEST_LIST_CLIENTS + 7);
+	list->setClientAddress(client, &addr);
+	assert(list->getClient(&addr) == client);
+	setAddress(&addr, 7);
+	assert(list->getClient(&addr) == nullptr);
+
+	/* each predefined topic used to look its client up by walking the list */
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for ( int i = 0; i < LINEAR_SAMPLES; i++ )
+	{
+		int n = (int)((uint64_t)i * TEST_LIST_CLIENTS / LINEAR_SAMPLES);
+		setClientId(&id, buf, n);
+		Client* p = list->getClient(0);
+		while ( p && strcmp(p->getClientId(), buf) != 0 )
+		{
+			p = p->getNextClient();
+		}
+		assert(p != nullptr);
+	}
+	double linear = elapsedSec(&start) * TEST_LIST_CLIENTS * TEST_LIST_TOPICS / LINEAR_SAMPLES;
+	delete list;
+
+	list = new ClientList();
+	double snapshot = load(list);
+	check(list);
+	delete list;
+
+	printf("[ OK ]\n");
+	printf("      %d clients, %d predefined topics: %.3f sec from text, %.3f sec from snapshot, %.1f sec estimated with linear lookups\n",
+			TEST_LIST_CLIENTS, TEST_LIST_CLIENTS * TEST_LIST_TOPICS, text, snapshot, linear);
+}
@@ -0,0 +1,46 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - ClientList tests
+ **************************************************************************************/
+#ifndef MQTTSNGATEWAY_SRC_TESTS_TESTCLIENTLIST_H_
+#define MQTTSNGATEWAY_SRC_TESTS_TESTCLIENTLIST_H_
+
+#include "MQTTSNGWClientList.h"
+
+#define TEST_LIST_CLIENTS      20000
+#define TEST_LIST_TOPICS           5   // per client
+#define TEST_LIST_CLIENTS_FILE    "/tmp/testClients.conf"
+#define TEST_LIST_TOPICS_FILE     "/tmp/testPredefinedTopic.conf"
+
+using namespace MQTTSNGW;
+
+/*
+ *  Loads a large clients.conf and predefinedTopic.conf from text, then from their snapshots,
+ *  and compares with the linear lookups that loading the topics used to need.
+ */
+class TestClientList
+{
+public:
+	TestClientList();
+	~TestClientList();
+	void test(void);
+
+private:
+	void writeLists(void);
+	double load(ClientList* list);
+	void check(ClientList* list);
+	void setClientId(MQTTSNString* id, char* buf, int i);
+};
+
+#endif /* MQTTSNGATEWAY_SRC_TESTS_TESTCLIENTLIST_H_ */
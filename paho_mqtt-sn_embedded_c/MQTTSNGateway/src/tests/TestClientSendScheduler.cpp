@@ -0,0 +1,188 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - ClientSendScheduler tests
+ **************************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <cassert>
+#include "TestClientSendScheduler.h"
+#include "MQTTSNGWPacket.h"
+
+using namespace std;
+using namespace MQTTSNGW;
+
+TestClientSendScheduler::TestClientSendScheduler()
+{
+	for ( int i = 0; i < TEST_SCHED_CLIENTS; i++ )
+	{
+		_clients[i] = new Client();
+	}
+	_cnt = 0;
+}
+
+TestClientSendScheduler::~TestClientSendScheduler()
+{
+	for ( int i = 0; i < TEST_SCHED_CLIENTS; i++ )
+	{
+		delete _clients[i];
+	}
+}
+
+/* the load, in the order it arrives */
+void TestClientSendScheduler::arrive(int client, uint64_t usec, bool ack)
+{
+	assert(_cnt < TEST_SCHED_EVENTS);
+	_client[_cnt] = client;
+	_usec[_cnt] = usec;
+	_ack[_cnt] = ack;
+	_cnt++;
+}
+
+/*
+ *  Client 0 gets 1,000 PUBLISHes from a broker subscription at once,
+ *  the others get one PUBLISH every 100 msecs and a PUBACK on the way.
+ *  The link is simulated by the token bucket of the scheduler and the clock is virtual.
+ */
+void TestClientSendScheduler::test(void)
+{
+	uint8_t payload[20];
+	MQTTSN_topicid topicId;
+	topicId.type = MQTTSN_TOPIC_TYPE_NORMAL;
+	topicId.data.id = 1;
+	memset(payload, 0, sizeof(payload));
+
+	for ( int i = 0; i < TEST_SCHED_QUIET_MSGS * 100; i++ )
+	{
+		arrive(0, 0, false);
+	}
+	for ( int i = 0; i < TEST_SCHED_QUIET_MSGS; i++ )
+	{
+		for ( int j = 1; j < TEST_SCHED_CLIENTS; j++ )
+		{
+			arrive(j, 50000 + i * 100000 + j * 1000, false);
+			if ( i == TEST_SCHED_QUIET_MSGS / 2 )
+			{
+				arrive(j, 50000 + i * 100000 + j * 1000 + 500, true);
+			}
+		}
+	}
+	assert(_cnt == TEST_SCHED_EVENTS);
+
+	/* FIFO, as ClientSendTask sent before */
+	uint64_t fifoMax = 0;
+	uint64_t linkFree = 0;
+	for ( int i = 0; i < _cnt; i++ )
+	{
+		uint64_t start = _usec[i] > linkFree ? _usec[i] : linkFree;
+		linkFree = start + (_ack[i] ? 7 : 7 + sizeof(payload)) * 1000000 / TEST_SCHED_RATE;
+		if ( _client[i] != 0 && start - _usec[i] > fifoMax )
+		{
+			fifoMax = start - _usec[i];
+		}
+	}
+
+	/* scheduled */
+	ClientSendScheduler scheduler;
+	scheduler.setRate(TEST_SCHED_RATE);
+	uint64_t now = 0;
+	uint64_t quietMax = 0;
+	uint64_t ackMax = 0;
+	int posted = 0;
+	int sent = 0;
+
+	while ( sent < _cnt )
+	{
+		for ( ; posted < _cnt && _usec[posted] <= now; posted++ )
+		{
+			MQTTSNPacket* packet = new MQTTSNPacket();
+			if ( _ack[posted] )
+			{
+				packet->setPUBACK(1, posted, MQTTSN_RC_ACCEPTED);
+			}
+			else
+			{
+				packet->setPUBLISH(0, 1, 0, posted, topicId, payload, sizeof(payload));
+			}
+			Event* ev = new Event();
+			ev->setClientSendEvent(_clients[_client[posted]], packet);
+			scheduler.post(ev);
+		}
+
+		uint32_t waitUsec = 0;
+		Event* ev = scheduler.next(now, &waitUsec);
+		if ( ev )
+		{
+			int i = ev->getMQTTSNPacket()->getMsgId();
+			assert(ev->getClient() == _clients[_client[i]]);
+			if ( _ack[i] && now - _usec[i] > ackMax )
+			{
+				ackMax = now - _usec[i];
+			}
+			else if ( !_ack[i] && _client[i] != 0 && now - _usec[i] > quietMax )
+			{
+				quietMax = now - _usec[i];
+			}
+			sent++;
+			delete ev;
+			continue;
+		}
+
+		uint64_t next = posted < _cnt ? _usec[posted] : UINT64_MAX;
+		assert(waitUsec > 0 || next != UINT64_MAX);
+		now = ( waitUsec > 0 && now + waitUsec < next ) ? now + waitUsec : next;
+	}
+	assert(scheduler.size() == 0);
+
+	/* a quiet client waits for a round of the scheduler at most, acks for the packet on the link */
+	assert(quietMax < 250000);
+	assert(ackMax < 50000);
+	assert(fifoMax > 2000000);
+
+	/* a client's queue is bounded, and what is left is deleted when the task stops */
+	for ( int i = 0; i <= CLIENTSEND_MAX_QUEUED; i++ )
+	{
+		MQTTSNPacket* packet = new MQTTSNPacket();
+		packet->setPUBLISH(0, 1, 0, i, topicId, payload, sizeof(payload));
+		Event* ev = new Event();
+		ev->setClientSendEvent(_clients[0], packet);
+		scheduler.post(ev);
+	}
+	assert(scheduler.size() == CLIENTSEND_MAX_QUEUED);
+	assert(scheduler.getDropCnt() == 1);
+	scheduler.clear();
+	assert(scheduler.size() == 0);
+
+	/* control packets are never dropped, past their limit ClientSendTask stops taking Events */
+	scheduler.setMaxClients(1);
+	for ( int i = 0; i <= MAX_INFLIGHTMESSAGES; i++ )
+	{
+		MQTTSNPacket* packet = new MQTTSNPacket();
+		packet->setPUBACK(1, i, MQTTSN_RC_ACCEPTED);
+		Event* ev = new Event();
+		ev->setClientSendEvent(_clients[i % TEST_SCHED_CLIENTS], packet);
+		scheduler.post(ev);
+	}
+	assert(scheduler.size() == MAX_INFLIGHTMESSAGES + 1);
+	assert(scheduler.getDropCnt() == 1);
+	assert(scheduler.isControlFull());
+	scheduler.clear();
+	assert(!scheduler.isControlFull());
+	assert(scheduler.size() == 0);
+	uint32_t waitUsec = 0;
+	assert(scheduler.next(UINT64_MAX / 2, &waitUsec) == nullptr);
+
+	printf("[ OK ]\n");
+	printf("      100:1 load at %d bytes/sec, other clients wait: %lu msecs FIFO, %lu msecs scheduled, acks %lu msecs\n",
+			TEST_SCHED_RATE, (unsigned long)(fifoMax / 1000), (unsigned long)(quietMax / 1000), (unsigned long)(ackMax / 1000));
+}
@@ -0,0 +1,45 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - ClientSendScheduler tests
+ **************************************************************************************/
+#ifndef MQTTSNGATEWAY_SRC_TESTS_TESTCLIENTSENDSCHEDULER_H_
+#define MQTTSNGATEWAY_SRC_TESTS_TESTCLIENTSENDSCHEDULER_H_
+
+#include "MQTTSNGWClientSendScheduler.h"
+
+#define TEST_SCHED_CLIENTS       10   // client 0 gets 100 times the PUBLISHes of each other one
+#define TEST_SCHED_QUIET_MSGS    10
+#define TEST_SCHED_EVENTS       (TEST_SCHED_QUIET_MSGS * 100 + (TEST_SCHED_CLIENTS - 1) * (TEST_SCHED_QUIET_MSGS + 1))
+#define TEST_SCHED_RATE        3840   // bytes/sec, XBee at 38400 baud
+
+using namespace MQTTSNGW;
+
+class TestClientSendScheduler
+{
+public:
+	TestClientSendScheduler();
+	~TestClientSendScheduler();
+	void test(void);
+
+private:
+	void arrive(int client, uint64_t usec, bool ack);
+
+	Client* _clients[TEST_SCHED_CLIENTS];
+	int _cnt;
+	int _client[TEST_SCHED_EVENTS];
+	uint64_t _usec[TEST_SCHED_EVENTS];
+	bool _ack[TEST_SCHED_EVENTS];
+};
+
+#endif /* MQTTSNGATEWAY_SRC_TESTS_TESTCLIENTSENDSCHEDULER_H_ */
@@ -0,0 +1,203 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - DuplicateFilter tests
+ **************************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <cassert>
+#include "TestDuplicateFilter.h"
+#include "MQTTSNGWClient.h"
+
+using namespace std;
+using namespace MQTTSNGW;
+
+#define TEST_DUPLICATE_TOPICID  0x0102
+
+TestDuplicateFilter::TestDuplicateFilter()
+{
+	_client = new Client();
+	_seed = 1;
+}
+
+TestDuplicateFilter::~TestDuplicateFilter()
+{
+	delete _client;
+}
+
+bool TestDuplicateFilter::lost(int percent)
+{
+	return (int)(rand_r(&_seed) % 100) < percent;
+}
+
+/*
+ *  Retransmissions are absorbed while the PUBACK is awaited and answered with it afterwards,
+ *  other PUBLISHes are not.
+ */
+void TestDuplicateFilter::testCheck(void)
+{
+	DuplicateFilter filter;
+	DuplicateCounters counters;
+	Client other;
+	uint8_t rc = 0;
+	const uint8_t* payload = (const uint8_t*)"21.5";
+
+	filter.add(_client, 1, TEST_DUPLICATE_TOPICID, payload, 4);
+	assert(filter.check(_client, 1, TEST_DUPLICATE_TOPICID, payload, 4, &rc) == DupNew);
+	assert(filter.getClientCount() == 0);
+
+	filter.initialize(DEFAULT_DUPLICATE_WINDOW);
+	assert(filter.check(_client, 1, TEST_DUPLICATE_TOPICID, payload, 4, &rc) == DupNew);
+	filter.add(_client, 1, TEST_DUPLICATE_TOPICID, payload, 4);
+	assert(filter.check(_client, 1, TEST_DUPLICATE_TOPICID, payload, 4, &rc) == DupInflight);
+
+	/* msgId, TopicId, payload and client must match */
+	assert(filter.check(_client, 2, TEST_DUPLICATE_TOPICID, payload, 4, &rc) == DupNew);
+	assert(filter.check(_client, 1, TEST_DUPLICATE_TOPICID + 1, payload, 4, &rc) == DupNew);
+	assert(filter.check(_client, 1, TEST_DUPLICATE_TOPICID, (const uint8_t*)"21.6", 4, &rc) == DupNew);
+	assert(filter.check(_client, 1, TEST_DUPLICATE_TOPICID, payload, 3, &rc) == DupNew);
+	assert(filter.check(&other, 1, TEST_DUPLICATE_TOPICID, payload, 4, &rc) == DupNew);
+
+	filter.acked(_client, 1, MQTTSN_RC_REJECTED_CONGESTED);
+	assert(filter.check(_client, 1, TEST_DUPLICATE_TOPICID, payload, 4, &rc) == DupAcked);
+	assert(rc == MQTTSN_RC_REJECTED_CONGESTED);
+
+	/* the msgId used again for another message */
+	filter.add(_client, 1, TEST_DUPLICATE_TOPICID, (const uint8_t*)"22.0", 4);
+	filter.acked(_client, 1, MQTTSN_RC_ACCEPTED);
+	assert(filter.check(_client, 1, TEST_DUPLICATE_TOPICID, (const uint8_t*)"22.0", 4, &rc) == DupAcked);
+	assert(rc == MQTTSN_RC_ACCEPTED);
+	assert(filter.check(_client, 1, TEST_DUPLICATE_TOPICID, payload, 4, &rc) == DupAcked);
+	assert(rc == MQTTSN_RC_REJECTED_CONGESTED);
+
+	assert(filter.getCounters(_client, &counters));
+	assert(counters.published == 2 && counters.duplicates == 4 && counters.reacked == 3);
+	assert(!filter.getCounters(&other, &counters));
+
+	filter.erase(_client);
+	assert(filter.getClientCount() == 0);
+	assert(filter.check(_client, 1, TEST_DUPLICATE_TOPICID, payload, 4, &rc) == DupNew);
+}
+
+/*
+ *  A client's newest DUPLICATE_FILTER_WINDOW_SIZE PUBLISHes are remembered, for the window's secs.
+ */
+void TestDuplicateFilter::testWindow(void)
+{
+	DuplicateFilter filter;
+	uint8_t rc;
+	const uint8_t* payload = (const uint8_t*)"on";
+
+	filter.initialize(1);
+	for (int i = 0; i <= DUPLICATE_FILTER_WINDOW_SIZE; i++)
+	{
+		filter.add(_client, i + 1, TEST_DUPLICATE_TOPICID, payload, 2);
+		filter.acked(_client, i + 1, MQTTSN_RC_ACCEPTED);
+	}
+	assert(filter.check(_client, 1, TEST_DUPLICATE_TOPICID, payload, 2, &rc) == DupNew);
+	for (int i = 1; i <= DUPLICATE_FILTER_WINDOW_SIZE; i++)
+	{
+		assert(filter.check(_client, i + 1, TEST_DUPLICATE_TOPICID, payload, 2, &rc) == DupAcked);
+	}
+
+	usleep(2100000);
+	assert(filter.check(_client, 2, TEST_DUPLICATE_TOPICID, payload, 2, &rc) == DupNew);
+}
+
+/*
+ *  The client sends each PUBLISH until it gets the PUBACK, with the DUP flag after the first time.
+ *  The gateway does what MQTTSNPublishHandler and MQTTGWPublishHandler do, the broker's PUBACKs
+ *  come back between two retransmissions or later.
+ *  @return the PUBLISHes sent to the broker, arrived is set to the ones that reached the gateway.
+ */
+uint32_t TestDuplicateFilter::publish(DuplicateFilter* filter, uint32_t* arrived)
+{
+	uint32_t toBroker = 0;
+	uint8_t payload[16];
+	uint8_t rc;
+
+	*arrived = 0;
+	_seed = 1;
+	for (int i = 0; i < TEST_DUPLICATE_PUBLISHES; i++)
+	{
+		uint16_t msgId = i % 0xFFFF + 1;
+		int payloadLen = snprintf((char*)payload, sizeof(payload), "%d", i);
+		int brokerPending = 0;
+		bool acked = false;
+
+		for (int retry = 0; !acked; retry++)
+		{
+			assert(retry < TEST_DUPLICATE_MAX_RETRY);
+			if (!lost(TEST_DUPLICATE_UPLINK_LOSS))
+			{
+				(*arrived)++;
+				DuplicateStatus status = DupNew;
+				if (retry > 0)
+				{
+					status = filter->check(_client, msgId, TEST_DUPLICATE_TOPICID, payload, payloadLen, &rc);
+				}
+				if (status == DupNew)
+				{
+					filter->add(_client, msgId, TEST_DUPLICATE_TOPICID, payload, payloadLen);
+					toBroker++;
+					brokerPending++;
+				}
+				else if (status == DupAcked && !lost(TEST_DUPLICATE_DOWNLINK_LOSS))
+				{
+					acked = true;
+				}
+			}
+
+			while (brokerPending && !lost(50))
+			{
+				brokerPending--;
+				filter->acked(_client, msgId, MQTTSN_RC_ACCEPTED);
+				if (!lost(TEST_DUPLICATE_DOWNLINK_LOSS))
+				{
+					acked = true;
+				}
+			}
+		}
+	}
+	return toBroker;
+}
+
+void TestDuplicateFilter::test(void)
+{
+	testCheck();
+	testWindow();
+
+	DuplicateFilter off;
+	DuplicateFilter filter;
+	DuplicateCounters counters;
+	uint32_t arrivedOff;
+	uint32_t arrived;
+
+	filter.initialize(DEFAULT_DUPLICATE_WINDOW);
+	uint32_t brokerOff = publish(&off, &arrivedOff);
+	uint32_t broker = publish(&filter, &arrived);
+
+	/* every PUBLISH reaching the gateway goes to the broker without the filter */
+	assert(brokerOff == arrivedOff && brokerOff > TEST_DUPLICATE_PUBLISHES);
+	assert(broker == TEST_DUPLICATE_PUBLISHES);
+	filter.getTotals(&counters);
+	assert(counters.published == TEST_DUPLICATE_PUBLISHES);
+	assert(counters.duplicates == arrived - TEST_DUPLICATE_PUBLISHES);
+	assert(counters.reacked > 0 && counters.reacked < counters.duplicates);
+
+	printf("[ OK ]\n");
+	printf("      %d QoS 1 PUBLISHes, %d%% of PUBLISHes and %d%% of PUBACKs lost: %u PUBLISHes to the broker without the filter, %u with it, %u retransmissions absorbed, %u PUBACKs sent again\n",
+			TEST_DUPLICATE_PUBLISHES, TEST_DUPLICATE_UPLINK_LOSS, TEST_DUPLICATE_DOWNLINK_LOSS, brokerOff, broker, counters.duplicates, counters.reacked);
+}
@@ -0,0 +1,52 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - DuplicateFilter tests
+ **************************************************************************************/
+#ifndef MQTTSNGATEWAY_SRC_TESTS_TESTDUPLICATEFILTER_H_
+#define MQTTSNGATEWAY_SRC_TESTS_TESTDUPLICATEFILTER_H_
+
+#include "MQTTSNGWDuplicateFilter.h"
+
+#define TEST_DUPLICATE_PUBLISHES     1000
+#define TEST_DUPLICATE_UPLINK_LOSS     20   // % of the PUBLISHes lost on the sensor network
+#define TEST_DUPLICATE_DOWNLINK_LOSS   30   // % of the PUBACKs lost
+#define TEST_DUPLICATE_MAX_RETRY       50
+
+namespace MQTTSNGW
+{
+
+/*
+ *  DuplicateFilter, and the PUBLISHes the broker gets from a client retransmitting
+ *  QoS 1 PUBLISHes over a lossy sensor network, with and without the filter.
+ */
+class TestDuplicateFilter
+{
+public:
+	TestDuplicateFilter();
+	~TestDuplicateFilter();
+	void test(void);
+
+private:
+	void testCheck(void);
+	void testWindow(void);
+	uint32_t publish(DuplicateFilter* filter, uint32_t* arrived);
+	bool lost(int percent);
+
+	Client* _client;
+	unsigned int _seed;
+};
+
+}
+
+#endif /* MQTTSNGATEWAY_SRC_TESTS_TESTDUPLICATEFILTER_H_ */
@@ -0,0 +1,187 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - Forwarder tests
+ **************************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <cassert>
+#include "TestForwarder.h"
+#include "MQTTSNGWPacket.h"
+
+using namespace std;
+using namespace MQTTSNGW;
+
+#define LOOKUP_ROUNDS      20
+
+static double elapsedSec(struct timespec* start)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+TestForwarder::TestForwarder()
+{
+	_list = new ForwarderList();
+}
+
+TestForwarder::~TestForwarder()
+{
+	delete _list;
+	for ( int i = 0; i < TEST_FORWARDERS; i++ )
+	{
+		for ( int j = 0; j < TEST_NODES; j++ )
+		{
+			delete _clients[i][j];
+		}
+	}
+}
+
+/* ZigBee style node id, 64 bit + 16 bit address */
+void TestForwarder::setNodeId(WirelessNodeId* id, int fwd, int node)
+{
+	uint8_t buf[10] = { 0x00, 0x13, 0xA2, 0x00, 0x40, (uint8_t)fwd, (uint8_t)(node >> 8), (uint8_t)node, (uint8_t)(node >> 8), (uint8_t)node };
+	id->setId(buf, sizeof(buf));
+}
+
+/* the lookup Forwarder did before its clients were hashed, a walk of the client list */
+Client* TestForwarder::linearLookup(int fwd, WirelessNodeId* id)
+{
+	for ( int j = 0; j < TEST_NODES; j++ )
+	{
+		if ( _nodeIds[fwd][j] == *id )
+		{
+			return _clients[fwd][j];
+		}
+	}
+	return nullptr;
+}
+
+void TestForwarder::test(void)
+{
+	char name[16];
+	MQTTSNString fwdId = MQTTSNString_initializer;
+	fwdId.cstring = name;
+	Forwarder* fwd[TEST_FORWARDERS];
+
+	for ( int i = 0; i < TEST_FORWARDERS; i++ )
+	{
+		string addr = "10.0.0." + to_string(i + 1) + ":" + to_string(10000 + i);
+		_addr[i].setAddress(&addr);
+		sprintf(name, "Forwarder%02d", i);
+		fwd[i] = _list->addForwarder(&_addr[i], &fwdId);
+
+		for ( int j = 0; j < TEST_NODES; j++ )
+		{
+			_clients[i][j] = new Client();
+			setNodeId(&_nodeIds[i][j], i, j);
+			fwd[i]->addClient(_clients[i][j], &_nodeIds[i][j]);
+		}
+	}
+
+	/* every node is found on its forwarder and maps back to its node id */
+	for ( int i = 0; i < TEST_FORWARDERS; i++ )
+	{
+		Forwarder* f = _list->getForwarder(&_addr[i]);
+		assert(f != nullptr);
+		assert(f->getSensorNetAddr()->isMatch(&_addr[i]));
+		for ( int j = 0; j < TEST_NODES; j++ )
+		{
+			assert(fwd[i]->getClient(&_nodeIds[i][j]) == _clients[i][j]);
+			assert(*fwd[i]->getWirelessNodeId(_clients[i][j]) == _nodeIds[i][j]);
+			assert(_clients[i][j]->getForwarder() == fwd[i]);
+		}
+	}
+
+	/* adding a client again keeps one entry, from its latest node */
+	WirelessNodeId moved;
+	setNodeId(&moved, 0xFF, 0);
+	fwd[0]->addClient(_clients[0][1], &moved);
+	assert(fwd[0]->getClient(&moved) == _clients[0][1]);
+	assert(fwd[0]->getClient(&_nodeIds[0][1]) == nullptr);
+	fwd[0]->addClient(_clients[0][1], &_nodeIds[0][1]);
+	assert(fwd[0]->getClient(&moved) == nullptr);
+
+	/* erased clients are gone from both tables */
+	fwd[0]->eraseClient(_clients[0][0]);
+	assert(fwd[0]->getClient(&_nodeIds[0][0]) == nullptr);
+	assert(fwd[0]->getWirelessNodeId(_clients[0][0]) == nullptr);
+	assert(fwd[0]->getClient(&_nodeIds[0][1]) == _clients[0][1]);
+	fwd[0]->addClient(_clients[0][0], &_nodeIds[0][0]);
+
+	/* node ids longer than MAX_WIRELESS_NODEID_LENGTH are not accepted */
+	uint8_t encap[MAX_WIRELESS_NODEID_LENGTH + 8] = { 0 };
+	encap[0] = MAX_WIRELESS_NODEID_LENGTH + 4;
+	encap[1] = MQTTSN_ENCAPSULATED;
+	encap[encap[0]] = 2;
+	encap[encap[0] + 1] = MQTTSN_PINGREQ;
+	MQTTSNPacket* packet = new MQTTSNPacket();
+	packet->desirialize(encap, encap[0] + 2);
+	MQTTSNGWEncapsulatedPacket tooLong;
+	assert(tooLong.desirialize(packet) < 0);
+
+	/* the encapsulated message is taken out of the packet without a copy */
+	encap[0] = 3 + 10;
+	uint8_t nodeId[10] = { 0x00, 0x13, 0xA2, 0x00, 0x40, 3, 0, 7, 0, 7 };
+	memcpy(encap + 3, nodeId, sizeof(nodeId));
+	encap[13] = 2;
+	encap[14] = MQTTSN_PINGREQ;
+	packet->desirialize(encap, 15);
+	unsigned char* data = packet->getPacketData();
+	MQTTSNGWEncapsulatedPacket encapsulated;
+	assert(encapsulated.desirialize(packet) == 13);
+	assert(encapsulated.getMQTTSNPacket() == packet);
+	assert(packet->getPacketData() == data + 13);
+	assert(packet->getType() == MQTTSN_PINGREQ);
+	assert(fwd[3]->getClient(encapsulated.getWirelessNodeId()) == _clients[3][7]);
+	delete packet;
+
+	/* lookups of a received packet: the forwarder by address, then the client by node id */
+	struct timespec start;
+	int lookups = 0;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for ( int r = 0; r < LOOKUP_ROUNDS; r++ )
+	{
+		for ( int j = 0; j < TEST_NODES; j++ )
+		{
+			for ( int i = 0; i < TEST_FORWARDERS; i++ )
+			{
+				Forwarder* f = _list->getForwarder(&_addr[i]);
+				Client* client = f->getClient(&_nodeIds[i][j]);
+				/* the test addresses are only distinct on sensor networks that parse "IP:port" */
+				assert(f != fwd[i] || client == _clients[i][j]);
+				lookups++;
+			}
+		}
+	}
+	double hashed = elapsedSec(&start);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for ( int r = 0; r < LOOKUP_ROUNDS; r++ )
+	{
+		for ( int j = 0; j < TEST_NODES; j++ )
+		{
+			for ( int i = 0; i < TEST_FORWARDERS; i++ )
+			{
+				assert(linearLookup(i, &_nodeIds[i][j]) == _clients[i][j]);
+			}
+		}
+	}
+	double linear = elapsedSec(&start);
+
+	printf("[ OK ]\n");
+	printf("      %d forwarders x %d nodes: %.0f lookups/sec hashed, %.0f lookups/sec linear scan\n",
+			TEST_FORWARDERS, TEST_NODES, lookups / hashed, lookups / linear);
+}
@@ -0,0 +1,43 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - Forwarder tests
+ **************************************************************************************/
+#ifndef MQTTSNGATEWAY_SRC_TESTS_TESTFORWARDER_H_
+#define MQTTSNGATEWAY_SRC_TESTS_TESTFORWARDER_H_
+
+#include "MQTTSNGWForwarder.h"
+
+#define TEST_FORWARDERS      10
+#define TEST_NODES         1000   // per forwarder
+
+using namespace MQTTSNGW;
+
+class TestForwarder
+{
+public:
+	TestForwarder();
+	~TestForwarder();
+	void test(void);
+
+private:
+	void setNodeId(WirelessNodeId* id, int fwd, int node);
+	Client* linearLookup(int fwd, WirelessNodeId* id);
+
+	ForwarderList* _list;
+	SensorNetAddress _addr[TEST_FORWARDERS];
+	Client* _clients[TEST_FORWARDERS][TEST_NODES];
+	WirelessNodeId _nodeIds[TEST_FORWARDERS][TEST_NODES];
+};
+
+#endif /* MQTTSNGATEWAY_SRC_TESTS_TESTFORWARDER_H_ */
@@ -0,0 +1,462 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - gateway benchmark
+ **************************************************************************************/
+#include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include "TestGatewayBench.h"
+#include "MQTTSNPacket.h"
+
+using namespace std;
+using namespace MQTTSNGW;
+
+static uint64_t nowNsecs(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int compareSamples(const void* a, const void* b)
+{
+	uint32_t x = *(const uint32_t*)a;
+	uint32_t y = *(const uint32_t*)b;
+	return (x > y) - (x < y);
+}
+
+static void addSample(BenchLatency* latency, uint64_t nsecs)
+{
+	if (latency->cnt < BENCH_MESSAGES)
+	{
+		latency->samples[latency->cnt++] = (nsecs > 0xffffffff) ? 0xffffffff : (uint32_t)nsecs;
+	}
+}
+
+/*=====================================
+ Class BenchBroker
+ =====================================*/
+void BenchBroker::received(const uint8_t* topic, uint16_t topicLength, uint8_t* payload, uint32_t payloadLength)
+{
+	if (payloadLength == BENCH_PAYLOAD_SIZE)
+	{
+		uint64_t nsecs = nowNsecs();
+		memcpy(payload + 16, &nsecs, sizeof(nsecs));
+	}
+}
+
+/*=====================================
+ Class TestGatewayBench
+ =====================================*/
+TestGatewayBench::TestGatewayBench(Gateway* gateway, BenchBroker* broker)
+{
+	_gateway = gateway;
+	_gateway->attach((Thread*)this);
+	_broker = broker;
+	_sensorNetwork = _gateway->getSensorNetwork();
+	_clientCnt = 0;
+	_nextId = 1;
+	_messages = 0;
+	_toBroker.samples = (uint32_t*)malloc(sizeof(uint32_t) * BENCH_MESSAGES);
+	_toClient.samples = (uint32_t*)malloc(sizeof(uint32_t) * BENCH_MESSAGES);
+	_puback.samples = (uint32_t*)malloc(sizeof(uint32_t) * BENCH_MESSAGES);
+	_passed = false;
+}
+
+TestGatewayBench::~TestGatewayBench()
+{
+	free(_toBroker.samples);
+	free(_toClient.samples);
+	free(_puback.samples);
+}
+
+bool TestGatewayBench::isPassed(void)
+{
+	return _passed;
+}
+
+void TestGatewayBench::run(void)
+{
+	int clients[] = { 1, 8, BENCH_MAX_CLIENTS };
+
+	_passed = true;
+	for (unsigned int i = 0; i < sizeof(clients) / sizeof(int) && _passed; i++)
+	{
+		fprintf(stderr, "Test  Gateway bench %2d clients  ", clients[i]);
+		fflush(stderr);
+		_passed = bench(clients[i]);
+	}
+	raise(SIGINT);
+}
+
+/*
+ *  A run with new clients.
+ *  @return false when a message is lost or the gateway stops answering
+ */
+bool TestGatewayBench::bench(int clients)
+{
+	_clientCnt = clients;
+	_messages = BENCH_MESSAGES / clients;
+	memset(_clients, 0, sizeof(_clients));
+	for (int i = 0; i < _clientCnt; i++)
+	{
+		BenchClient* client = &_clients[i];
+		client->id = _nextId++;
+		sprintf(client->clientId, "bench%03u", client->id);
+		client->topic[0] = 'a' + client->id / 26;
+		client->topic[1] = 'a' + client->id % 26;
+	}
+	_toBroker.cnt = 0;
+	_toClient.cnt = 0;
+	_puback.cnt = 0;
+	uint32_t connections = _broker->getConnectionCnt();
+	uint32_t published = _broker->getPublishedCnt();
+	uint32_t delivered = _broker->getDeliveredCnt();
+
+	if (!connect() || !subscribe())
+	{
+		fprintf(stderr, "[ NG ]\n      no CONNACK or SUBACK from the gateway\n");
+		return false;
+	}
+
+	uint64_t start = nowNsecs();
+	bool rc = publish();
+	double secs = (nowNsecs() - start) / 1e9;
+
+	uint32_t total = _messages * _clientCnt;
+	uint32_t sent = 0;
+	uint32_t acked = 0;
+	uint32_t received = 0;
+	for (int i = 0; i < _clientCnt; i++)
+	{
+		sent += _clients[i].sent;
+		acked += _clients[i].acked;
+		received += _clients[i].received;
+	}
+	published = _broker->getPublishedCnt() - published;
+	delivered = _broker->getDeliveredCnt() - delivered;
+
+	if (!rc || sent != total || acked != total || received != total || published != total
+			|| delivered != total || _sensorNetwork->getDropCnt() != 0)
+	{
+		fprintf(stderr, "[ NG ]\n      sent %u, PUBACKs %u, broker received %u and delivered %u, clients received %u, %u datagrams dropped\n",
+				sent, acked, published, delivered, received, _sensorNetwork->getDropCnt());
+		return false;
+	}
+	if (!disconnect())
+	{
+		fprintf(stderr, "[ NG ]\n      no DISCONNECT from the gateway\n");
+		return false;
+	}
+
+	fprintf(stderr, "[ OK ]\n");
+	fprintf(stderr, "      %u PUBLISHes QoS 1 in %.3f secs, %.0f msgs/sec, %u broker connections\n",
+			total, secs, total / secs, _broker->getConnectionCnt() - connections);
+	report("client->broker", &_toBroker);
+	report("broker->client", &_toClient);
+	report("PUBACK", &_puback);
+	return true;
+}
+
+bool TestGatewayBench::connect(void)
+{
+	MQTTSNPacket_connectData options = MQTTSNPacket_connectData_initializer;
+	uint8_t buf[64];
+	int cnt = 0;
+
+	for (int i = 0; i < _clientCnt; i++)
+	{
+		options.clientID.cstring = _clients[i].clientId;
+		options.duration = 900;
+		options.cleansession = 1;
+		if (!send(&_clients[i], buf, MQTTSNSerialize_connect(buf, sizeof(buf), &options)))
+		{
+			return false;
+		}
+	}
+	while (cnt < _clientCnt)
+	{
+		if (collect() < 0)
+		{
+			return false;
+		}
+		for (cnt = 0; cnt < _clientCnt && _clients[cnt].connected; cnt++)
+		{
+			;
+		}
+	}
+	return true;
+}
+
+bool TestGatewayBench::subscribe(void)
+{
+	MQTTSN_topicid topic;
+	uint8_t buf[64];
+	int cnt = 0;
+
+	for (int i = 0; i < _clientCnt; i++)
+	{
+		topic.type = MQTTSN_TOPIC_TYPE_SHORT;
+		topic.data.short_name[0] = _clients[i].topic[0];
+		topic.data.short_name[1] = _clients[i].topic[1];
+		if (!send(&_clients[i], buf, MQTTSNSerialize_subscribe(buf, sizeof(buf), 0, 0, ++_clients[i].msgId, &topic)))
+		{
+			return false;
+		}
+	}
+	while (cnt < _clientCnt)
+	{
+		if (collect() < 0)
+		{
+			return false;
+		}
+		for (cnt = 0; cnt < _clientCnt && _clients[cnt].subscribed; cnt++)
+		{
+			;
+		}
+	}
+	return true;
+}
+
+/*
+ *  Keep BENCH_WINDOW PUBLISHes of every client in flight until all are sent,
+ *  acknowledged and received back.
+ */
+bool TestGatewayBench::publish(void)
+{
+	while (true)
+	{
+		bool done = true;
+		for (int i = 0; i < _clientCnt; i++)
+		{
+			BenchClient* client = &_clients[i];
+			while (client->inflightCnt < BENCH_WINDOW && client->sent < _messages)
+			{
+				publish(client);
+			}
+			if (client->acked < _messages || client->received < _messages)
+			{
+				done = false;
+			}
+		}
+		if (done)
+		{
+			return true;
+		}
+		if (collect() < 0)
+		{
+			return false;
+		}
+	}
+}
+
+void TestGatewayBench::publish(BenchClient* client)
+{
+	MQTTSN_topicid topic;
+	uint8_t payload[BENCH_PAYLOAD_SIZE];
+	uint8_t buf[64];
+
+	topic.type = MQTTSN_TOPIC_TYPE_SHORT;
+	topic.data.short_name[0] = client->topic[0];
+	topic.data.short_name[1] = client->topic[1];
+	if (++client->msgId == 0)
+	{
+		client->msgId = 1;
+	}
+
+	uint64_t nsecs = nowNsecs();
+	memset(payload, 0, sizeof(payload));
+	memcpy(payload, &client->id, 4);
+	memcpy(payload + 4, &client->sent, 4);
+	memcpy(payload + 8, &nsecs, 8);
+	int len = MQTTSNSerialize_publish(buf, sizeof(buf), 0, 1, 0, client->msgId, topic, payload, sizeof(payload));
+
+	client->inflight[client->inflightCnt].msgId = client->msgId;
+	client->inflight[client->inflightCnt].nsecs = nsecs;
+	client->inflightCnt++;
+	client->sent++;
+	send(client, buf, len);
+}
+
+bool TestGatewayBench::disconnect(void)
+{
+	uint8_t buf[8];
+	int cnt = 0;
+
+	for (int i = 0; i < _clientCnt; i++)
+	{
+		if (!send(&_clients[i], buf, MQTTSNSerialize_disconnect(buf, sizeof(buf), 0)))
+		{
+			return false;
+		}
+	}
+	while (cnt < _clientCnt)
+	{
+		if (collect() < 0)
+		{
+			return false;
+		}
+		for (cnt = 0; cnt < _clientCnt && !_clients[cnt].connected; cnt++)
+		{
+			;
+		}
+	}
+	return true;
+}
+
+bool TestGatewayBench::send(BenchClient* client, uint8_t* buf, int length)
+{
+	SensorNetAddress addr;
+	addr.setAddress(client->id);
+	return length > 0 && _sensorNetwork->inject(buf, length, &addr);
+}
+
+/*
+ *  Wait for a datagram from the gateway and handle it.
+ *  @return -1 when there is none for BENCH_TIMEOUT msecs
+ */
+int TestGatewayBench::collect(void)
+{
+	for (int waited = 0; waited < BENCH_TIMEOUT; waited += BENCH_WAIT)
+	{
+		int len = _sensorNetwork->collect(_buf, sizeof(_buf), &_addr, BENCH_WAIT);
+		if (len > 0)
+		{
+			dispatch(len);
+			return len;
+		}
+	}
+	return -1;
+}
+
+void TestGatewayBench::dispatch(int length)
+{
+	BenchClient* client = getClient(&_addr);
+	if (client == nullptr)
+	{
+		return;
+	}
+
+	uint64_t nsecs = nowNsecs();
+	uint8_t type = (_buf[0] == 0x01) ? _buf[3] : _buf[1];
+	switch (type)
+	{
+	case MQTTSN_CONNACK:
+	{
+		int rc;
+		if (MQTTSNDeserialize_connack(&rc, _buf, length) == 1 && rc == MQTTSN_RC_ACCEPTED)
+		{
+			client->connected = true;
+		}
+		break;
+	}
+	case MQTTSN_SUBACK:
+	{
+		int qos;
+		uint16_t topicId;
+		uint16_t msgId;
+		uint8_t rc;
+		if (MQTTSNDeserialize_suback(&qos, &topicId, &msgId, &rc, _buf, length) == 1 && rc == MQTTSN_RC_ACCEPTED)
+		{
+			client->subscribed = true;
+		}
+		break;
+	}
+	case MQTTSN_PUBACK:
+	{
+		uint16_t topicId;
+		uint16_t msgId;
+		uint8_t rc;
+		if (MQTTSNDeserialize_puback(&topicId, &msgId, &rc, _buf, length) != 1 || rc != MQTTSN_RC_ACCEPTED)
+		{
+			break;
+		}
+		for (int i = 0; i < client->inflightCnt; i++)
+		{
+			if (client->inflight[i].msgId == msgId)
+			{
+				addSample(&_puback, nsecs - client->inflight[i].nsecs);
+				client->inflight[i] = client->inflight[--client->inflightCnt];
+				client->acked++;
+				break;
+			}
+		}
+		break;
+	}
+	case MQTTSN_PUBLISH:
+	{
+		uint8_t dup;
+		int qos;
+		uint8_t retained;
+		uint16_t msgId;
+		MQTTSN_topicid topic;
+		uint8_t* payload;
+		int payloadLength;
+		uint32_t id;
+		uint64_t injected;
+		uint64_t brokered;
+		if (MQTTSNDeserialize_publish(&dup, &qos, &retained, &msgId, &topic, &payload, &payloadLength, _buf, length) != 1
+				|| payloadLength != BENCH_PAYLOAD_SIZE)
+		{
+			break;
+		}
+		memcpy(&id, payload, 4);
+		memcpy(&injected, payload + 8, 8);
+		memcpy(&brokered, payload + 16, 8);
+		if (id == client->id)
+		{
+			addSample(&_toBroker, brokered - injected);
+			addSample(&_toClient, nsecs - brokered);
+			client->received++;
+		}
+		break;
+	}
+	case MQTTSN_DISCONNECT:
+		client->connected = false;
+		break;
+	default:
+		break;
+	}
+}
+
+BenchClient* TestGatewayBench::getClient(SensorNetAddress* addr)
+{
+	for (int i = 0; i < _clientCnt; i++)
+	{
+		if (_clients[i].id == addr->getId())
+		{
+			return &_clients[i];
+		}
+	}
+	return nullptr;
+}
+
+void TestGatewayBench::report(const char* stage, BenchLatency* latency)
+{
+	if (latency->cnt == 0)
+	{
+		return;
+	}
+	qsort(latency->samples, latency->cnt, sizeof(uint32_t), compareSamples);
+	double sum = 0;
+	for (uint32_t i = 0; i < latency->cnt; i++)
+	{
+		sum += latency->samples[i];
+	}
+	fprintf(stderr, "      %-14s avg %7.1f  p50 %7.1f  p99 %7.1f  max %8.1f usecs\n", stage,
+			sum / latency->cnt / 1000, latency->samples[latency->cnt / 2] / 1000.0,
+			latency->samples[latency->cnt * 99 / 100] / 1000.0, latency->samples[latency->cnt - 1] / 1000.0);
+}
@@ -0,0 +1,120 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - gateway benchmark
+ **************************************************************************************/
+#ifndef MQTTSNGATEWAY_SRC_TESTS_TESTGATEWAYBENCH_H_
+#define MQTTSNGATEWAY_SRC_TESTS_TESTGATEWAYBENCH_H_
+
+#include "MQTTSNGateway.h"
+#include "SensorNetwork.h"
+#include "LoopbackBroker.h"
+
+#define BENCH_MESSAGES      20000   // PUBLISHes of a run, shared by its clients
+#define BENCH_WINDOW            4   // PUBLISHes of a client waiting for their PUBACK
+#define BENCH_TIMEOUT        5000   // msecs without a datagram from the gateway, a run fails
+#define BENCH_WAIT            100   // msecs collect() waits
+#define BENCH_PAYLOAD_SIZE     24   // client id, sequence number, injected and broker's timestamps
+#define BENCH_MAX_CLIENTS      64
+
+namespace MQTTSNGW
+{
+
+/*
+ *  LoopbackBroker writing the time it receives a PUBLISH of the bench into its payload.
+ */
+class BenchBroker : public LoopbackBroker
+{
+protected:
+	void received(const uint8_t* topic, uint16_t topicLength, uint8_t* payload, uint32_t payloadLength);
+};
+
+/* A PUBLISH waiting for its PUBACK */
+typedef struct
+{
+	uint16_t msgId;
+	uint64_t nsecs;
+} BenchInflight;
+
+/* A client of a run */
+typedef struct
+{
+	uint32_t id;
+	char clientId[16];
+	char topic[2];
+	bool connected;
+	bool subscribed;
+	uint32_t sent;
+	uint32_t acked;
+	uint32_t received;
+	uint16_t msgId;
+	int inflightCnt;
+	BenchInflight inflight[BENCH_WINDOW];
+} BenchClient;
+
+/* Latency samples of a stage, nanosecs */
+typedef struct
+{
+	uint32_t* samples;
+	uint32_t cnt;
+} BenchLatency;
+
+/*
+ *  Drives a whole Gateway, all its tasks included, through the loopback SensorNetwork
+ *  and BenchBroker, make bench. For each number of clients they CONNECT, SUBSCRIBE to
+ *  a short topic of their own, PUBLISH BENCH_MESSAGES with QoS 1 between them with
+ *  BENCH_WINDOW PUBLISHes in flight each, receive them back and DISCONNECT.
+ *  Every message must be acknowledged, seen by the broker and delivered once.
+ *  Reports messages per second and the latencies of the client to broker and
+ *  broker to client legs and of the PUBACKs. Stops the gateway when it has finished.
+ */
+class TestGatewayBench : public Thread
+{
+	MAGIC_WORD_FOR_THREAD;
+public:
+	TestGatewayBench(Gateway* gateway, BenchBroker* broker);
+	~TestGatewayBench();
+	void run(void);
+	bool isPassed(void);
+
+private:
+	bool bench(int clients);
+	bool connect(void);
+	bool subscribe(void);
+	bool publish(void);
+	bool disconnect(void);
+	bool send(BenchClient* client, uint8_t* buf, int length);
+	void publish(BenchClient* client);
+	int collect(void);
+	void dispatch(int length);
+	BenchClient* getClient(SensorNetAddress* addr);
+	void report(const char* stage, BenchLatency* latency);
+
+	Gateway* _gateway;
+	BenchBroker* _broker;
+	SensorNetwork* _sensorNetwork;
+	BenchClient _clients[BENCH_MAX_CLIENTS];
+	int _clientCnt;
+	uint32_t _nextId;
+	uint32_t _messages;        // PUBLISHes of each client
+	BenchLatency _toBroker;
+	BenchLatency _toClient;
+	BenchLatency _puback;
+	uint8_t _buf[MQTTSNGW_MAX_PACKET_SIZE];
+	SensorNetAddress _addr;
+	bool _passed;
+};
+
+}
+
+#endif /* MQTTSNGATEWAY_SRC_TESTS_TESTGATEWAYBENCH_H_ */
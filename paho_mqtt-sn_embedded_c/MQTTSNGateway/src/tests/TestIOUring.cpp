@@ -0,0 +1,428 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - IOUring tests
+ **************************************************************************************/
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <cassert>
+#include "TestIOUring.h"
+#include "MQTTGWPacket.h"
+#include "MQTTSNPacket.h"
+
+using namespace std;
+using namespace MQTTSNGW;
+
+/* MQTT PUBLISH, QoS 0, topic "ab", 4 bytes of sequence number */
+#define TEST_URING_FRAME_SIZE  10
+
+static double elapsedSec(struct timespec* start)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static void setFrame(uint8_t* frame, uint32_t seq)
+{
+	frame[0] = PUBLISH << 4;
+	frame[1] = TEST_URING_FRAME_SIZE - 2;
+	frame[2] = 0;
+	frame[3] = 2;
+	frame[4] = 'a';
+	frame[5] = 'b';
+	memcpy(frame + 6, &seq, sizeof(seq));
+}
+
+TestIOUring::TestIOUring()
+{
+	_received = 0;
+	_sunk = 0;
+}
+
+TestIOUring::~TestIOUring()
+{
+}
+
+bool TestIOUring::listen(TCPStack* server, char* port)
+{
+	sockaddr_in addr;
+	socklen_t len = sizeof(addr);
+
+	if (!server->bind("0") || !server->listen() || getsockname(server->getSock(), (sockaddr*)&addr, &len) < 0)
+	{
+		return false;
+	}
+	sprintf(port, "%d", ntohs(addr.sin_port));
+	return true;
+}
+
+/*
+ *  Sends MQTT-SN PUBLISHes to the UDPPort in bursts, keeping TEST_URING_WINDOW of them at most in flight.
+ */
+void* TestIOUring::runSender(void* arg)
+{
+	TestIOUring* test = (TestIOUring*)arg;
+	mmsghdr msgs[MAX_PACKET_BURST];
+	iovec iovs[MAX_PACKET_BURST];
+	uint8_t datagrams[MAX_PACKET_BURST][11];
+	sockaddr_in dest;
+
+	int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	assert(sock >= 0);
+	dest.sin_family = AF_INET;
+	dest.sin_port = htons(TEST_URING_PORT);
+	dest.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	uint32_t sent = 0;
+	while (sent < TEST_URING_DATAGRAMS)
+	{
+		while (sent - __atomic_load_n(&test->_received, __ATOMIC_ACQUIRE) > TEST_URING_WINDOW - MAX_PACKET_BURST)
+		{
+			sched_yield();
+		}
+		int cnt = (TEST_URING_DATAGRAMS - sent < MAX_PACKET_BURST) ? TEST_URING_DATAGRAMS - sent : MAX_PACKET_BURST;
+		memset(msgs, 0, sizeof(msgs));
+		for (int i = 0; i < cnt; i++)
+		{
+			/* PUBLISH, QoS 0, TopicId 1 */
+			uint32_t seq = sent + i;
+			uint8_t header[] = { 11, MQTTSN_PUBLISH, 0, 0, 1, 0, 0 };
+			memcpy(datagrams[i], header, sizeof(header));
+			memcpy(datagrams[i] + 7, &seq, sizeof(seq));
+			iovs[i].iov_base = datagrams[i];
+			iovs[i].iov_len = sizeof(datagrams[i]);
+			msgs[i].msg_hdr.msg_name = &dest;
+			msgs[i].msg_hdr.msg_namelen = sizeof(dest);
+			msgs[i].msg_hdr.msg_iov = &iovs[i];
+			msgs[i].msg_hdr.msg_iovlen = 1;
+		}
+		int rc = sendmmsg(sock, msgs, cnt, 0);
+		assert(rc > 0);
+		sent += rc;
+	}
+	close(sock);
+	return 0;
+}
+
+/*
+ *  @return the secs to receive TEST_URING_DATAGRAMS datagrams, in order and without a loss.
+ */
+double TestIOUring::recvDatagrams(bool ring, uint32_t* syscalls)
+{
+	UDPPort port;
+	SensorNetAddress addr;
+	uint8_t buf[MQTTSNGW_MAX_PACKET_SIZE];
+	struct timespec start;
+	pthread_t sender;
+
+	assert(port.open("225.1.1.1", TEST_URING_PORT + 1, TEST_URING_PORT) == 0);
+	if (ring)
+	{
+		assert(port.openRing());
+	}
+	_received = 0;
+	assert(pthread_create(&sender, 0, runSender, this) == 0);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (uint32_t i = 0; i < TEST_URING_DATAGRAMS; i++)
+	{
+		uint32_t seq;
+		assert(port.recv(buf, sizeof(buf), &addr) == 11);
+		memcpy(&seq, buf + 7, sizeof(seq));
+		assert(buf[1] == MQTTSN_PUBLISH && seq == i);
+		assert(addr.getIpAddress() == htonl(INADDR_LOOPBACK));
+		__atomic_store_n(&_received, i + 1, __ATOMIC_RELEASE);
+	}
+	double secs = elapsedSec(&start);
+
+	/* a select() and a recvfrom() each */
+	*syscalls = ring ? port.getEnterCnt() : 2 * TEST_URING_DATAGRAMS;
+
+	pthread_join(sender, 0);
+	port.close();
+	return secs;
+}
+
+/*
+ *  Writes the PUBLISHes as a broker does, many in a segment. No more than two segments are
+ *  in flight, a full socket buffer would split a PUBLISH, that MQTTGWPacket::recv() reads
+ *  from the socket with one recv() for the rest of the packet.
+ */
+void* TestIOUring::runWriter(void* arg)
+{
+	TestIOUring* test = (TestIOUring*)arg;
+	uint8_t buf[400 * TEST_URING_FRAME_SIZE];
+
+	for (uint32_t seq = 0; seq < TEST_URING_PACKETS; )
+	{
+		while (seq - __atomic_load_n(&test->_received, __ATOMIC_ACQUIRE) >= 800)
+		{
+			sched_yield();
+		}
+		int len = 0;
+		for (int i = 0; i < 400 && seq < TEST_URING_PACKETS; i++, seq++)
+		{
+			setFrame(buf + len, seq);
+			len += TEST_URING_FRAME_SIZE;
+		}
+		for (int pos = 0; pos < len; )
+		{
+			int rc = test->_peers[0].send(buf + pos, len - pos);
+			assert(rc > 0);
+			pos += rc;
+		}
+	}
+	return 0;
+}
+
+/*
+ *  Reads TEST_URING_PACKETS PUBLISHes of a broker connection as BrokerRecvTask does,
+ *  one packet per select(), or the packets of all the bytes received by the ring.
+ *  @return secs
+ */
+double TestIOUring::recvPackets(bool ring, uint32_t* syscalls)
+{
+	TCPStack server;
+	Network network(false);
+	IOUring uring;
+	IOUringEvent ev;
+	struct timespec start;
+	pthread_t writer;
+	char port[8];
+
+	assert(listen(&server, port));
+	assert(network.connect("127.0.0.1", port));
+	assert(server.accept(_peers[0]));
+	int sock = network.getSock();
+	if (ring)
+	{
+		assert(uring.open() && uring.recvMultishot(sock, 1));
+	}
+	_received = 0;
+	assert(pthread_create(&writer, 0, runWriter, this) == 0);
+
+	*syscalls = 0;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	uint32_t seq = 0;
+	while (seq < TEST_URING_PACKETS)
+	{
+		if (ring)
+		{
+			assert(uring.wait(&ev, 1000) == 1 && ev.userData == 1 && ev.res > 0);
+			if (!ev.more)
+			{
+				assert(uring.recvMultishot(sock, 1));
+			}
+			network.feed(ev.data, ev.length);
+			uring.release(&ev);
+		}
+		else
+		{
+			fd_set rset;
+			struct timeval timeout = { 1, 0 };
+			FD_ZERO(&rset);
+			FD_SET(sock, &rset);
+			assert(select(sock + 1, &rset, 0, 0, &timeout) == 1);
+			(*syscalls)++;
+		}
+
+		do
+		{
+			MQTTGWPacket packet;
+			Publish pub;
+			uint32_t value;
+			assert(packet.recv(&network) == TEST_URING_FRAME_SIZE && packet.getType() == PUBLISH);
+			assert(packet.getPUBLISH(&pub) && pub.payloadlen == sizeof(value));
+			memcpy(&value, pub.payload, sizeof(value));
+			assert(value == seq);
+			seq++;
+			__atomic_store_n(&_received, seq, __ATOMIC_RELEASE);
+			if (!ring)
+			{
+				/* the fixed header, the remaining length and the rest */
+				*syscalls += 3;
+			}
+		} while (ring && network.isReceived());
+	}
+	double secs = elapsedSec(&start);
+	if (ring)
+	{
+		*syscalls = uring.getEnterCnt();
+	}
+
+	pthread_join(writer, 0);
+	uring.close();
+	network.close();
+	_peers[0].close();
+	server.close();
+	return secs;
+}
+
+/*
+ *  Reads what the broker connections write until all of it has arrived.
+ */
+void* TestIOUring::runSink(void* arg)
+{
+	TestIOUring* test = (TestIOUring*)arg;
+	uint8_t buf[4096];
+	uint32_t total = TEST_URING_CONNECTIONS * TEST_URING_ROUNDS * TEST_URING_FRAME_SIZE;
+
+	while (test->_sunk < total)
+	{
+		fd_set rset;
+		struct timeval timeout = { 1, 0 };
+		int maxSock = 0;
+		FD_ZERO(&rset);
+		for (int i = 0; i < TEST_URING_CONNECTIONS; i++)
+		{
+			FD_SET(test->_peers[i].getSock(), &rset);
+			maxSock = (test->_peers[i].getSock() > maxSock) ? test->_peers[i].getSock() : maxSock;
+		}
+		assert(select(maxSock + 1, &rset, 0, 0, &timeout) > 0);
+		for (int i = 0; i < TEST_URING_CONNECTIONS; i++)
+		{
+			if (FD_ISSET(test->_peers[i].getSock(), &rset))
+			{
+				int rc = test->_peers[i].recv(buf, sizeof(buf));
+				assert(rc > 0);
+				test->_sunk += rc;
+			}
+		}
+	}
+	return 0;
+}
+
+/*
+ *  TEST_URING_ROUNDS times, a PUBLISH is queued on each connection and the connections
+ *  are flushed, one write each or all the writes submitted to the ring together.
+ *  @return secs
+ */
+double TestIOUring::flushConnections(bool ring, uint32_t* syscalls)
+{
+	TCPStack server;
+	Network* networks[TEST_URING_CONNECTIONS];
+	IOUring uring;
+	IOUringEvent ev;
+	uint8_t frame[TEST_URING_FRAME_SIZE];
+	struct timespec start;
+	pthread_t sink;
+	char port[8];
+
+	assert(listen(&server, port));
+	for (int i = 0; i < TEST_URING_CONNECTIONS; i++)
+	{
+		networks[i] = new Network(false);
+		assert(networks[i]->connect("127.0.0.1", port));
+		assert(server.accept(_peers[i]));
+	}
+	if (ring)
+	{
+		assert(uring.open());
+	}
+	_sunk = 0;
+	assert(pthread_create(&sink, 0, runSink, this) == 0);
+
+	uint32_t writes = 0;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (uint32_t seq = 0; seq < TEST_URING_ROUNDS; seq++)
+	{
+		setFrame(frame, seq);
+		for (int i = 0; i < TEST_URING_CONNECTIONS; i++)
+		{
+			assert(networks[i]->queue(frame, sizeof(frame), BROKER_SEND_LATENCY) == sizeof(frame));
+		}
+		if (ring)
+		{
+			int submitted = 0;
+			for (int i = 0; i < TEST_URING_CONNECTIONS; i++)
+			{
+				assert(networks[i]->flush(&uring, i));
+				submitted++;
+			}
+			while (submitted > 0)
+			{
+				if (uring.wait(&ev, -1) == 1)
+				{
+					assert(networks[ev.userData]->flushed(ev.res) == sizeof(frame));
+					submitted--;
+				}
+			}
+		}
+		else
+		{
+			for (int i = 0; i < TEST_URING_CONNECTIONS; i++)
+			{
+				uint32_t cnt = networks[i]->getWriteCnt();
+				assert(networks[i]->flush() == sizeof(frame));
+				writes += networks[i]->getWriteCnt() - cnt;
+			}
+		}
+	}
+	pthread_join(sink, 0);
+	double secs = elapsedSec(&start);
+	*syscalls = ring ? uring.getEnterCnt() : writes;
+
+	uring.close();
+	for (int i = 0; i < TEST_URING_CONNECTIONS; i++)
+	{
+		delete networks[i];
+		_peers[i].close();
+	}
+	server.close();
+	return secs;
+}
+
+void TestIOUring::test(void)
+{
+	IOUring probe;
+	bool available = probe.open();
+	probe.close();
+
+	uint32_t recvs[2];
+	uint32_t reads[2];
+	uint32_t writes[2];
+	double udpSecs[2];
+	double readSecs[2];
+	double flushSecs[2];
+
+	for (int ring = 0; ring < (available ? 2 : 1); ring++)
+	{
+		udpSecs[ring] = recvDatagrams(ring, &recvs[ring]);
+		readSecs[ring] = recvPackets(ring, &reads[ring]);
+		flushSecs[ring] = flushConnections(ring, &writes[ring]);
+	}
+
+	printf("[ OK ]\n");
+	if (!available)
+	{
+		printf("      io_uring is not available, select() is used: %d datagrams in %.0f msecs, %d broker packets in %.0f msecs\n",
+				TEST_URING_DATAGRAMS, udpSecs[0] * 1e3, TEST_URING_PACKETS, readSecs[0] * 1e3);
+		return;
+	}
+	assert(recvs[1] < recvs[0]);
+	assert(reads[1] < reads[0]);
+	assert(writes[1] < writes[0]);
+
+	printf("      %d datagrams to a UDPPort: select() %.0f/sec %u syscalls, io_uring %.0f/sec %u syscalls\n",
+			TEST_URING_DATAGRAMS, TEST_URING_DATAGRAMS / udpSecs[0], recvs[0], TEST_URING_DATAGRAMS / udpSecs[1], recvs[1]);
+	printf("      %d broker packets read: select() %.0f/sec %u syscalls, io_uring %.0f/sec %u syscalls\n",
+			TEST_URING_PACKETS, TEST_URING_PACKETS / readSecs[0], reads[0], TEST_URING_PACKETS / readSecs[1], reads[1]);
+	printf("      %d flushes of %d broker connections: one write each %.0f/sec %u syscalls, io_uring %.0f/sec %u syscalls\n",
+			TEST_URING_ROUNDS, TEST_URING_CONNECTIONS, TEST_URING_ROUNDS / flushSecs[0], writes[0], TEST_URING_ROUNDS / flushSecs[1], writes[1]);
+}
@@ -0,0 +1,62 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - IOUring tests
+ **************************************************************************************/
+#ifndef MQTTSNGATEWAY_SRC_TESTS_TESTIOURING_H_
+#define MQTTSNGATEWAY_SRC_TESTS_TESTIOURING_H_
+
+#include <pthread.h>
+#include "SensorNetwork.h"
+#include "Network.h"
+#include "IOUring.h"
+
+#define TEST_URING_DATAGRAMS     20000
+#define TEST_URING_WINDOW           64   // datagrams sent and not yet received, below what the socket buffers
+#define TEST_URING_PACKETS       20000
+#define TEST_URING_CONNECTIONS       8
+#define TEST_URING_ROUNDS         2000
+#define TEST_URING_PORT          21883   // Gateway port of the UDPPort, the multicast port is the next one
+
+namespace MQTTSNGW
+{
+
+/*
+ *  IOUring against select() on the loopback: the datagrams received by a UDPPort,
+ *  the MQTT packets of a broker connection read by MQTTGWPacket::recv(), and the writes
+ *  of the packets queued on several broker connections as BrokerSendTask flushes them.
+ */
+class TestIOUring
+{
+public:
+	TestIOUring();
+	~TestIOUring();
+	void test(void);
+
+private:
+	double recvDatagrams(bool ring, uint32_t* syscalls);
+	double recvPackets(bool ring, uint32_t* syscalls);
+	double flushConnections(bool ring, uint32_t* syscalls);
+	bool listen(TCPStack* server, char* port);
+	static void* runSender(void* arg);
+	static void* runWriter(void* arg);
+	static void* runSink(void* arg);
+
+	uint32_t _received;
+	TCPStack _peers[TEST_URING_CONNECTIONS];
+	uint32_t _sunk;
+};
+
+}
+
+#endif /* MQTTSNGATEWAY_SRC_TESTS_TESTIOURING_H_ */
@@ -0,0 +1,345 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - LocalRouter tests
+ **************************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <cassert>
+#include "TestLocalRouter.h"
+#include "MQTTSNGateway.h"
+
+using namespace std;
+using namespace MQTTSNGW;
+
+#define TEST_LOCAL_TOPIC    "plant/2/line/7/temperature"
+#define TEST_LOCAL_PAYLOAD  "{\"celsius\":21.5}"
+
+static double elapsedSec(struct timespec* start)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static void setPublish(Publish* pub, const char* topic, const char* payload, int qos)
+{
+	memset(pub, 0, sizeof(Publish));
+	pub->header.bits.type = PUBLISH;
+	pub->header.bits.qos = qos;
+	pub->topic = (char*)topic;
+	pub->topiclen = strlen(topic);
+	pub->msgId = qos ? 1 : 0;
+	pub->payload = (char*)payload;
+	pub->payloadlen = strlen(payload);
+}
+
+TestLocalRouter::TestLocalRouter()
+{
+	struct sockaddr_in addr;
+	socklen_t addrLen = sizeof(addr);
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+	_listener = socket(AF_INET, SOCK_STREAM, 0);
+	assert(_listener >= 0);
+	assert(bind(_listener, (struct sockaddr*)&addr, sizeof(addr)) == 0);
+	assert(listen(_listener, 1) == 0);
+	assert(getsockname(_listener, (struct sockaddr*)&addr, &addrLen) == 0);
+	snprintf(_port, sizeof(_port), "%d", ntohs(addr.sin_port));
+	_publisher = new Client();
+	_subscriber = new Client();
+}
+
+TestLocalRouter::~TestLocalRouter()
+{
+	close(_listener);
+	delete _publisher;
+	delete _subscriber;
+}
+
+/*
+ *  The broker stand-in, sends each PUBLISH back after TEST_LOCAL_BROKER_DELAY msecs
+ *  as it would to a subscriber.
+ */
+void* TestLocalRouter::runBroker(void* arg)
+{
+	TestLocalRouter* test = (TestLocalRouter*)arg;
+	uint8_t buf[MQTTSNGW_MAX_PACKET_SIZE];
+	int sock = accept(test->_listener, 0, 0);
+	assert(sock >= 0);
+
+	while (recv(sock, buf, 2, MSG_WAITALL) == 2)
+	{
+		/* short packets only, one byte of remaining length */
+		assert(recv(sock, buf + 2, buf[1], MSG_WAITALL) == buf[1]);
+		if ((buf[0] >> 4) != PUBLISH)
+		{
+			continue;
+		}
+		usleep(TEST_LOCAL_BROKER_DELAY * 1000);
+		assert(write(sock, buf, buf[1] + 2) == buf[1] + 2);
+	}
+	close(sock);
+	return 0;
+}
+
+/*
+ *  Filters are used once the broker accepts them, and dropped with their clients.
+ */
+void TestLocalRouter::testSubscribe(void)
+{
+	LocalRouter router;
+
+	router.subscribe(_subscriber, "plant/+/line/#", 1, 1);
+	assert(router.getCount() == 0);
+
+	router.initialize(true);
+	router.subscribe(_subscriber, "plant/+/line/#", 1, 1);
+	router.subscribe(_publisher, "plant/2/line/7/temperature", 0, 1);
+	router.subscribe(_publisher, "plant/2/#", 0, 2);
+	assert(router.getCount() == 0);
+
+	/* msgIds are per client */
+	router.confirm(_subscriber, 2, true);
+	assert(router.getCount() == 0);
+	router.confirm(_subscriber, 1, true);
+	router.confirm(_publisher, 1, true);
+	router.confirm(_publisher, 2, false);
+	assert(router.getCount() == 2);
+
+	/* a SUBACK comes once */
+	router.confirm(_subscriber, 1, true);
+	assert(router.getCount() == 2);
+
+	router.unsubscribe(_publisher, "plant/2/line/7/temperature");
+	assert(router.getCount() == 1);
+	router.unsubscribe(_publisher, "plant/+/line/#");
+	assert(router.getCount() == 1);
+
+	router.subscribe(_subscriber, "plant/3/#", 0, 3);
+	router.erase(_subscriber);
+	router.confirm(_subscriber, 3, true);
+	assert(router.getCount() == 0);
+}
+
+/*
+ *  Each client subscribing gets one QoS 0 PUBLISH from the broker, the publisher too,
+ *  unless the broker sends it to the client with QoS 1 or 2.
+ */
+void TestLocalRouter::testRoute(void)
+{
+	LocalRouter router;
+	LocalRouterCounters counters;
+	EventQue que;
+	Publish pub;
+	Publish local;
+
+	router.initialize(true);
+	router.subscribe(_subscriber, "plant/+/line/#", 1, 1);
+	router.subscribe(_subscriber, "plant/2/line/7/temperature", 1, 2);
+	router.subscribe(_publisher, "plant/2/#", 0, 1);
+	router.confirm(_subscriber, 1, true);
+	router.confirm(_subscriber, 2, true);
+	router.confirm(_publisher, 1, true);
+
+	setPublish(&pub, TEST_LOCAL_TOPIC, TEST_LOCAL_PAYLOAD, 0);
+	pub.header.bits.retain = 1;
+	assert(router.route(_publisher, &pub, &que) == 2);
+	assert(que.size() == 2);
+
+	int subscriberCnt = 0;
+	int publisherCnt = 0;
+	for (int i = 0; i < 2; i++)
+	{
+		Event* ev = que.wait();
+		assert(ev->getEventType() == EtBrokerRecv);
+		subscriberCnt += ev->getClient() == _subscriber;
+		publisherCnt += ev->getClient() == _publisher;
+		assert(ev->getMQTTGWPacket()->getPUBLISH(&local));
+		assert(local.header.bits.qos == 0 && local.header.bits.retain == 0 && local.msgId == 0);
+		assert(local.topiclen == pub.topiclen && memcmp(local.topic, pub.topic, pub.topiclen) == 0);
+		assert(local.payloadlen == pub.payloadlen && memcmp(local.payload, pub.payload, pub.payloadlen) == 0);
+		delete ev;
+	}
+	assert(subscriberCnt == 1 && publisherCnt == 1);
+
+	/* the QoS 1 subscriber gets a QoS 1 PUBLISH from the broker */
+	setPublish(&pub, TEST_LOCAL_TOPIC, TEST_LOCAL_PAYLOAD, 1);
+	assert(router.route(_publisher, &pub, &que) == 1);
+	Event* ev = que.wait();
+	assert(ev->getClient() == _publisher);
+	delete ev;
+	setPublish(&pub, "plant/3/line/7/temperature", TEST_LOCAL_PAYLOAD, 2);
+	assert(router.route(_publisher, &pub, &que) == 0);
+
+	setPublish(&pub, "plant/3/line/7/temperature", TEST_LOCAL_PAYLOAD, 0);
+	assert(router.route(_publisher, &pub, &que) == 1);
+	delete que.wait();
+	setPublish(&pub, "plant/3/hall", TEST_LOCAL_PAYLOAD, 0);
+	assert(router.route(_publisher, &pub, &que) == 0);
+	assert(que.size() == 0);
+
+	router.getCounters(&counters);
+	assert(counters.routed == 3 && counters.delivered == 4);
+}
+
+/*
+ *  The broker's QoS 0 copy of each local delivery is recognized once, by client, topic and payload,
+ *  while the publisher's broker connection is open and until it is late.
+ */
+void TestLocalRouter::testEcho(void)
+{
+	LocalRouter router;
+	LocalRouterCounters counters;
+	EventQue que;
+	Publish pub;
+	Publish echo;
+
+	router.initialize(true);
+	router.subscribe(_subscriber, "plant/#", 0, 1);
+	router.confirm(_subscriber, 1, true);
+
+	setPublish(&pub, TEST_LOCAL_TOPIC, TEST_LOCAL_PAYLOAD, 1);
+	assert(router.route(_publisher, &pub, &que) == 1);
+	assert(router.route(_publisher, &pub, &que) == 1);
+	delete que.wait();
+	delete que.wait();
+
+	setPublish(&echo, TEST_LOCAL_TOPIC, TEST_LOCAL_PAYLOAD, 0);
+	assert(!router.isEcho(_publisher, &echo));
+	setPublish(&echo, TEST_LOCAL_TOPIC, "{\"celsius\":21.6}", 0);
+	assert(!router.isEcho(_subscriber, &echo));
+	setPublish(&echo, "plant/2/line/7/temperaturE", TEST_LOCAL_PAYLOAD, 0);
+	assert(!router.isEcho(_subscriber, &echo));
+	setPublish(&echo, TEST_LOCAL_TOPIC, TEST_LOCAL_PAYLOAD, 1);
+	assert(!router.isEcho(_subscriber, &echo));
+	setPublish(&echo, TEST_LOCAL_TOPIC, TEST_LOCAL_PAYLOAD, 0);
+	assert(router.isEcho(_subscriber, &echo));
+	assert(router.isEcho(_subscriber, &echo));
+	assert(!router.isEcho(_subscriber, &echo));
+
+	/* many deliveries in flight */
+	char payload[16];
+	for (int i = 0; i < 1000; i++)
+	{
+		snprintf(payload, sizeof(payload), "%d", i);
+		setPublish(&pub, TEST_LOCAL_TOPIC, payload, 0);
+		router.route(_publisher, &pub, &que);
+		delete que.wait();
+	}
+	for (int i = 999; i >= 0; i--)
+	{
+		snprintf(payload, sizeof(payload), "%d", i);
+		setPublish(&echo, TEST_LOCAL_TOPIC, payload, 0);
+		assert(router.isEcho(_subscriber, &echo));
+	}
+
+	/* the broker does not send it when the publisher's connection closes */
+	setPublish(&pub, TEST_LOCAL_TOPIC, TEST_LOCAL_PAYLOAD, 0);
+	router.route(_publisher, &pub, &que);
+	delete que.wait();
+	router.disconnected(_publisher);
+	assert(!router.isEcho(_subscriber, &pub));
+
+	/* the copies came at once, one from another client later on is not taken for them */
+	router.route(_publisher, &pub, &que);
+	delete que.wait();
+	usleep((LOCAL_ROUTER_ECHO_MIN_WAIT + 100) * 1000);
+	assert(!router.isEcho(_subscriber, &pub));
+
+	/* a client leaving drops what it was expecting */
+	router.route(_publisher, &pub, &que);
+	delete que.wait();
+	router.erase(_subscriber);
+	assert(!router.isEcho(_subscriber, &pub));
+
+	router.getCounters(&counters);
+	assert(counters.echoes == 1002);
+}
+
+/*
+ *  PUBLISH to the broker stand-in until it is read back.
+ *  @return the average secs.
+ */
+double TestLocalRouter::publishBroker(void)
+{
+	Network network(false);
+	struct timespec start;
+	Publish pub;
+	Publish echo;
+	assert(pthread_create(&_thread, 0, runBroker, this) == 0);
+	assert(network.connect("127.0.0.1", _port));
+
+	setPublish(&pub, TEST_LOCAL_TOPIC, TEST_LOCAL_PAYLOAD, 0);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int i = 0; i < TEST_LOCAL_PUBLISHES; i++)
+	{
+		MQTTGWPacket publish;
+		publish.setPUBLISH(&pub);
+		assert(publish.send(&network) > 0);
+
+		MQTTGWPacket packet;
+		assert(packet.recv(&network) > 0 && packet.getPUBLISH(&echo));
+		assert(echo.payloadlen == pub.payloadlen);
+	}
+	double secs = elapsedSec(&start);
+	network.close();
+	pthread_join(_thread, 0);
+	return secs / TEST_LOCAL_PUBLISHES;
+}
+
+/*
+ *  The same PUBLISHes delivered by the router.
+ */
+double TestLocalRouter::publishLocal(LocalRouter* router)
+{
+	struct timespec start;
+	EventQue que;
+	Publish pub;
+
+	setPublish(&pub, TEST_LOCAL_TOPIC, TEST_LOCAL_PAYLOAD, 0);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int i = 0; i < TEST_LOCAL_PUBLISHES; i++)
+	{
+		assert(router->route(_publisher, &pub, &que) == 1);
+		Event* ev = que.wait();
+		assert(ev->getClient() == _subscriber);
+		delete ev;
+	}
+	return elapsedSec(&start) / TEST_LOCAL_PUBLISHES;
+}
+
+void TestLocalRouter::test(void)
+{
+	testSubscribe();
+	testRoute();
+	testEcho();
+
+	LocalRouter router;
+	router.initialize(true);
+	router.subscribe(_subscriber, "plant/+/line/+/temperature", 0, 1);
+	router.confirm(_subscriber, 1, true);
+	double brokerSecs = publishBroker();
+	double localSecs = publishLocal(&router);
+	assert(localSecs < brokerSecs);
+
+	printf("[ OK ]\n");
+	printf("      PUBLISH to a subscriber of the gateway, broker answering in %d msecs: %.2f msecs through the broker, %.2f usecs routed locally\n",
+			TEST_LOCAL_BROKER_DELAY, brokerSecs * 1e3, localSecs * 1e6);
+}
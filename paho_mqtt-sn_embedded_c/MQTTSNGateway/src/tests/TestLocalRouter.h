@@ -0,0 +1,57 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - LocalRouter tests
+ **************************************************************************************/
+#ifndef MQTTSNGATEWAY_SRC_TESTS_TESTLOCALROUTER_H_
+#define MQTTSNGATEWAY_SRC_TESTS_TESTLOCALROUTER_H_
+
+#include <pthread.h>
+#include "MQTTSNGWLocalRouter.h"
+
+#define TEST_LOCAL_BROKER_DELAY   20   // msecs the broker stand-in takes to send a PUBLISH back
+#define TEST_LOCAL_PUBLISHES      10
+
+namespace MQTTSNGW
+{
+
+/*
+ *  LocalRouter, and the time from a client's PUBLISH to its delivery to a subscriber of the gateway
+ *  when the broker stand-in sends it back after TEST_LOCAL_BROKER_DELAY msecs and when the router does.
+ */
+class TestLocalRouter
+{
+public:
+	TestLocalRouter();
+	~TestLocalRouter();
+	void test(void);
+
+	static void* runBroker(void* arg);
+
+private:
+	void testSubscribe(void);
+	void testRoute(void);
+	void testEcho(void);
+	double publishBroker(void);
+	double publishLocal(LocalRouter* router);
+
+	int _listener;
+	char _port[8];
+	pthread_t _thread;
+	Client* _publisher;
+	Client* _subscriber;
+};
+
+}
+
+#endif /* MQTTSNGATEWAY_SRC_TESTS_TESTLOCALROUTER_H_ */
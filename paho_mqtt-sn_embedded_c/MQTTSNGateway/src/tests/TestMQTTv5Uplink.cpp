@@ -0,0 +1,384 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - MQTTv5Uplink tests
+ **************************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <cassert>
+#include "TestMQTTv5Uplink.h"
+
+using namespace std;
+using namespace MQTTSNGW;
+
+TestMQTTv5Uplink::TestMQTTv5Uplink()
+{
+	/* a socket the packets of the broker are written to */
+	struct sockaddr_in addr;
+	socklen_t addrLen = sizeof(addr);
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+	_listener = socket(AF_INET, SOCK_STREAM, 0);
+	assert(_listener >= 0);
+	assert(bind(_listener, (struct sockaddr*)&addr, sizeof(addr)) == 0);
+	assert(listen(_listener, 1) == 0);
+	assert(getsockname(_listener, (struct sockaddr*)&addr, &addrLen) == 0);
+	snprintf(_port, sizeof(_port), "%d", ntohs(addr.sin_port));
+
+	_network = new Network(false);
+	assert(_network->connect("127.0.0.1", _port));
+	_peer = accept(_listener, 0, 0);
+	assert(_peer >= 0);
+
+	/* topic names of 60 to 100 bytes */
+	for (int i = 0; i < TEST_V5_TOPICS; i++)
+	{
+		int len = 60 + i * 40 / (TEST_V5_TOPICS - 1);
+		int n = snprintf(_topics[i], sizeof(_topics[i]), "plant/hall-%02d/line-%02d/station/%04d/sensor", i % 7, i % 13, i);
+		memset(_topics[i] + n, 'x', len - n);
+		_topics[i][len] = 0;
+	}
+}
+
+TestMQTTv5Uplink::~TestMQTTv5Uplink()
+{
+	_network->close();
+	delete _network;
+	close(_peer);
+	close(_listener);
+}
+
+/*
+ *  The packet BrokerRecvTask reads when the broker writes frame.
+ */
+MQTTGWPacket* TestMQTTv5Uplink::receive(const uint8_t* frame, int length)
+{
+	assert(write(_peer, frame, length) == length);
+	MQTTGWPacket* packet = new MQTTGWPacket();
+	assert(packet->recv(_network) == length);
+	return packet;
+}
+
+int TestMQTTv5Uplink::encode(MQTTGWv5Session* session, MQTTGWPacket* packet, uint8_t* buf)
+{
+	uint8_t frame[MQTTSNGW_MAX_PACKET_SIZE];
+	int len = packet->getPacketData(frame);
+	return session->encode(frame, len, buf, MQTTSNGW_MAX_PACKET_SIZE);
+}
+
+/*
+ *  An MQTT v5 CONNECT and the broker's CONNACK with a Receive Maximum of 5.
+ */
+void TestMQTTv5Uplink::connect(MQTTGWv5Session* session, uint16_t topicAliasMaximum)
+{
+	uint8_t buf[MQTTSNGW_MAX_PACKET_SIZE];
+	Connect connect = MQTTPacket_Connect_Initializer;
+	connect.header.bits.type = CONNECT;
+	connect.flags.bits.cleanstart = 1;
+	connect.clientID = (char*)"meter-0001";
+	connect.keepAliveTimer = 60;
+	connect.version = 5;
+	MQTTGWPacket packet;
+	assert(packet.setCONNECT(&connect, 0, 0));
+	assert(encode(session, &packet, buf) > 0);
+	assert(session->isV5());
+
+	uint8_t connack[] = { 0x20, 0x09, 0x00, 0x00, 0x06, 0x21, 0x00, 0x05, 0x22,
+			(uint8_t)(topicAliasMaximum >> 8), (uint8_t)topicAliasMaximum };
+	MQTTGWPacket* ack = receive(connack, sizeof(connack));
+	assert(session->translate(ack));
+	delete ack;
+}
+
+/*
+ *  A v5 CONNECT has properties, a Session Expiry Interval that keeps the session when it is not clean.
+ */
+void TestMQTTv5Uplink::testConnect(void)
+{
+	uint8_t buf[MQTTSNGW_MAX_PACKET_SIZE];
+	uint8_t out[MQTTSNGW_MAX_PACKET_SIZE];
+	MQTTGWv5Session session;
+	MQTTGWPacket packet;
+	Connect connect = MQTTPacket_Connect_Initializer;
+	connect.header.bits.type = CONNECT;
+	connect.clientID = (char*)"meter-0001";
+	connect.keepAliveTimer = 60;
+	connect.version = 5;
+
+	assert(packet.setCONNECT(&connect, 0, 0));
+	uint8_t expected[] = { 0x10, 28, 0, 4, 'M', 'Q', 'T', 'T', 5, 0x00, 0, 60,
+			5, MQTTV5_PROPERTY_SESSION_EXPIRY_INTERVAL, 0xFF, 0xFF, 0xFF, 0xFF,
+			0, 10, 'm', 'e', 't', 'e', 'r', '-', '0', '0', '0', '1' };
+	int len = packet.getPacketData(buf);
+	assert(len == sizeof(expected));
+	assert(memcmp(buf, expected, len) == 0);
+
+	/* the CONNECT goes as it is and turns the session to v5 */
+	assert(session.encode(buf, len, out, sizeof(out)) == len);
+	assert(memcmp(out, expected, len) == 0);
+	assert(session.isV5());
+
+	/* clean session, empty properties */
+	connect.flags.bits.cleanstart = 1;
+	assert(packet.setCONNECT(&connect, 0, 0));
+	len = packet.getPacketData(buf);
+	assert(len == sizeof(expected) - 5);
+	assert(buf[1] == 23 && buf[9] == 0x02 && buf[12] == 0 && buf[13] == 0);
+
+	/* an MQTT 3.1.1 CONNECT turns it off */
+	connect.version = 4;
+	assert(packet.setCONNECT(&connect, 0, 0));
+	assert(encode(&session, &packet, out) == packet.getPacketLength());
+	assert(!session.isV5());
+}
+
+/*
+ *  The broker's Receive Maximum is the in-flight limit, the reason codes of a refused connection
+ *  become 3.1.1 return codes.
+ */
+void TestMQTTv5Uplink::testConnack(void)
+{
+	MQTTGWv5Session session;
+	Connack connack;
+
+	assert(session.getInflightLimit(10) == 10);
+	connect(&session, 10);
+	assert(session.getTopicAliasMaximum() == 10);
+	assert(session.getInflightLimit(10) == 5);
+	assert(session.getInflightLimit(3) == 3);
+	assert(session.getInflightLimit(0) == 5);
+
+	uint8_t frame[] = { 0x20, 0x09, 0x00, 0x00, 0x06, 0x21, 0x00, 0x05, 0x22, 0x00, 0x0A };
+	MQTTGWPacket* packet = receive(frame, sizeof(frame));
+	assert(session.translate(packet));
+	assert(packet->getPacketLength() == 4);
+	assert(packet->getCONNACK(&connack) && connack.rc == MQTT_CONNECTION_ACCEPTED);
+	delete packet;
+
+	uint8_t refused[] = { 0x20, 0x03, 0x00, MQTTV5_RC_BAD_USER_NAME_OR_PASSWORD, 0x00 };
+	packet = receive(refused, sizeof(refused));
+	assert(session.translate(packet));
+	assert(packet->getCONNACK(&connack) && connack.rc == MQTT_BAD_USERNAME_OR_PASSWORD);
+	assert(session.getTopicAliasMaximum() == 0);
+	assert(session.getInflightLimit(10) == 10);
+	delete packet;
+}
+
+/*
+ *  A topic name goes to the broker once with its alias, then the alias alone.
+ *  Topics beyond the broker's Topic Alias Maximum go by name.
+ */
+void TestMQTTv5Uplink::testPublish(void)
+{
+	uint8_t buf[MQTTSNGW_MAX_PACKET_SIZE];
+	MQTTGWv5Session session;
+	MQTTGWPacket packet;
+	Publish pub = MQTTPacket_Publish_Initializer;
+	pub.header.bits.qos = 1;
+	pub.payload = (char*)"xy";
+	pub.payloadlen = 2;
+
+	connect(&session, 2);
+
+	pub.topic = (char*)"a/b";
+	pub.topiclen = 3;
+	pub.msgId = 1;
+	packet.setPUBLISH(&pub);
+	uint8_t first[] = { 0x32, 13, 0, 3, 'a', '/', 'b', 0, 1, 3, MQTTV5_PROPERTY_TOPIC_ALIAS, 0, 1, 'x', 'y' };
+	assert(encode(&session, &packet, buf) == sizeof(first));
+	assert(memcmp(buf, first, sizeof(first)) == 0);
+
+	pub.msgId = 2;
+	packet.setPUBLISH(&pub);
+	uint8_t next[] = { 0x32, 10, 0, 0, 0, 2, 3, MQTTV5_PROPERTY_TOPIC_ALIAS, 0, 1, 'x', 'y' };
+	assert(encode(&session, &packet, buf) == sizeof(next));
+	assert(memcmp(buf, next, sizeof(next)) == 0);
+
+	pub.topic = (char*)"a/c";
+	packet.setPUBLISH(&pub);
+	assert(encode(&session, &packet, buf) == sizeof(first));
+	assert(buf[6] == 'c' && buf[12] == 2);
+
+	/* no alias left */
+	pub.topic = (char*)"a/d";
+	packet.setPUBLISH(&pub);
+	uint8_t byName[] = { 0x32, 10, 0, 3, 'a', '/', 'd', 0, 2, 0, 'x', 'y' };
+	assert(encode(&session, &packet, buf) == sizeof(byName));
+	assert(memcmp(buf, byName, sizeof(byName)) == 0);
+	assert(session.getAliasCount() == 2);
+
+	/* a new connection starts without aliases */
+	connect(&session, 2);
+	assert(session.getAliasCount() == 0);
+	pub.topic = (char*)"a/b";
+	packet.setPUBLISH(&pub);
+	assert(encode(&session, &packet, buf) == sizeof(first));
+}
+
+/*
+ *  SUBSCRIBE and UNSUBSCRIBE have empty properties after the packet identifier.
+ */
+void TestMQTTv5Uplink::testSubscribe(void)
+{
+	uint8_t buf[MQTTSNGW_MAX_PACKET_SIZE];
+	MQTTGWv5Session session;
+	MQTTGWPacket packet;
+
+	connect(&session, 0);
+
+	packet.setSUBSCRIBE("a/#", 1, 7);
+	uint8_t subscribe[] = { 0x82, 9, 0, 7, 0, 0, 3, 'a', '/', '#', 1 };
+	assert(encode(&session, &packet, buf) == sizeof(subscribe));
+	assert(memcmp(buf, subscribe, sizeof(subscribe)) == 0);
+
+	packet.setUNSUBSCRIBE("a/#", 8);
+	uint8_t unsubscribe[] = { 0xA2, 8, 0, 8, 0, 0, 3, 'a', '/', '#' };
+	assert(encode(&session, &packet, buf) == sizeof(unsubscribe));
+	assert(memcmp(buf, unsubscribe, sizeof(unsubscribe)) == 0);
+
+	/* the acks are the same in both versions */
+	packet.setAck(PUBACK, 9);
+	assert(encode(&session, &packet, buf) == 4);
+}
+
+/*
+ *  Packets from a v5 broker are read in the 3.1.1 form, keeping the reason codes of the acks.
+ */
+void TestMQTTv5Uplink::testTranslate(void)
+{
+	MQTTGWv5Session session;
+	Publish pub;
+	Ack ack;
+	unsigned short msgId;
+	unsigned char rc;
+
+	connect(&session, 0);
+
+	uint8_t publishProps[] = { 0x32, 12, 0, 3, 'a', '/', 'b', 0, 5, 2, 0x01, 0x01, 'h', 'i' };
+	MQTTGWPacket* packet = receive(publishProps, sizeof(publishProps));
+	assert(session.translate(packet));
+	assert(packet->getPUBLISH(&pub));
+	assert(pub.topiclen == 3 && memcmp(pub.topic, "a/b", 3) == 0);
+	assert(pub.msgId == 5 && pub.payloadlen == 2 && memcmp(pub.payload, "hi", 2) == 0);
+	delete packet;
+
+	uint8_t puback[] = { 0x40, 4, 0, 5, MQTTV5_RC_QUOTA_EXCEEDED, 0 };
+	packet = receive(puback, sizeof(puback));
+	assert(session.translate(packet));
+	assert(packet->getAck(&ack) && ack.msgId == 5);
+	assert(packet->getReasonCode() == MQTTV5_RC_QUOTA_EXCEEDED);
+	delete packet;
+
+	uint8_t pubackShort[] = { 0x40, 2, 0, 6 };
+	packet = receive(pubackShort, sizeof(pubackShort));
+	assert(session.translate(packet));
+	assert(packet->getReasonCode() == 0);
+	delete packet;
+
+	uint8_t suback[] = { 0x90, 7, 0, 7, 3, 0x1F, 0, 0, MQTTV5_RC_NOT_AUTHORIZED };
+	packet = receive(suback, sizeof(suback));
+	assert(session.translate(packet));
+	assert(packet->getSUBACK(&msgId, &rc) && msgId == 7 && rc == MQTTV5_RC_NOT_AUTHORIZED);
+	delete packet;
+
+	uint8_t unsuback[] = { 0xB0, 4, 0, 8, 0, 0 };
+	packet = receive(unsuback, sizeof(unsuback));
+	assert(session.translate(packet));
+	assert(packet->getPacketLength() == 4);
+	delete packet;
+
+	uint8_t disconnect[] = { 0xE0, 2, 0, 0 };
+	packet = receive(disconnect, sizeof(disconnect));
+	assert(session.translate(packet));
+	assert(packet->getPacketLength() == 2);
+	delete packet;
+
+	/* properties longer than the packet, and AUTH */
+	uint8_t malformed[] = { 0x30, 6, 0, 1, 'a', 5, 0x01, 0x01 };
+	packet = receive(malformed, sizeof(malformed));
+	assert(!session.translate(packet));
+	delete packet;
+
+	uint8_t auth[] = { 0xF0, 0 };
+	packet = receive(auth, sizeof(auth));
+	assert(!session.translate(packet));
+	delete packet;
+}
+
+/*
+ *  TEST_V5_PUBLISHES QoS 1 PUBLISHes written to the broker stand-in.
+ */
+void TestMQTTv5Uplink::sendPublishes(int version)
+{
+	uint8_t buf[MQTTSNGW_MAX_PACKET_SIZE];
+	uint8_t payload[TEST_V5_PAYLOAD];
+	MQTTGWv5Session session;
+	MQTTGWPacket packet;
+	Publish pub = MQTTPacket_Publish_Initializer;
+
+	if (version == 5)
+	{
+		connect(&session, 0xFFFF);
+	}
+
+	Network* network = new Network(false);
+	assert(network->connect("127.0.0.1", _server.getPort()));
+	assert(network->recv(buf, 1) == 1);
+
+	memset(payload, 0x55, sizeof(payload));
+	pub.header.bits.qos = 1;
+	pub.payload = (char*)payload;
+	pub.payloadlen = sizeof(payload);
+	for (int i = 0; i < TEST_V5_PUBLISHES; i++)
+	{
+		pub.topic = _topics[i % TEST_V5_TOPICS];
+		pub.topiclen = strlen(pub.topic);
+		pub.msgId = i + 1;
+		packet.setPUBLISH(&pub);
+		assert(packet.queue(network, &session, BROKER_SEND_LATENCY) > 0);
+	}
+	assert(network->flush() >= 0);
+	network->close();
+	delete network;
+
+	if (version == 5)
+	{
+		assert(session.getAliasCount() == TEST_V5_TOPICS);
+	}
+}
+
+void TestMQTTv5Uplink::test(void)
+{
+	testConnect();
+	testConnack();
+	testPublish();
+	testSubscribe();
+	testTranslate();
+
+	assert(_server.start(2, false));
+	sendPublishes(4);
+	sendPublishes(5);
+	_server.stop();
+	uint32_t v4Bytes = _server.getBytes(0);
+	uint32_t v5Bytes = _server.getBytes(1);
+	assert(v5Bytes < v4Bytes);
+
+	printf("[ OK ]\n");
+	printf("      %d QoS 1 PUBLISHes, %d topics of 60-100 bytes: MQTT 3.1.1 %.1f bytes/PUBLISH, MQTT v5 %.1f bytes/PUBLISH\n",
+			TEST_V5_PUBLISHES, TEST_V5_TOPICS, (double)v4Bytes / TEST_V5_PUBLISHES, (double)v5Bytes / TEST_V5_PUBLISHES);
+}
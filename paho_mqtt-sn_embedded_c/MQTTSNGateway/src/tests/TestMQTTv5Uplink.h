@@ -0,0 +1,63 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - MQTTv5Uplink tests
+ **************************************************************************************/
+#ifndef MQTTSNGATEWAY_SRC_TESTS_TESTMQTTV5UPLINK_H_
+#define MQTTSNGATEWAY_SRC_TESTS_TESTMQTTV5UPLINK_H_
+
+#include "TestTLSServer.h"
+#include "MQTTGWPacket.h"
+
+#define TEST_V5_TOPICS        50
+#define TEST_V5_PUBLISHES   1000
+#define TEST_V5_PAYLOAD       24
+
+namespace MQTTSNGW
+{
+
+/*
+ *  MQTTGWv5Session, the packets written to an MQTT v5 broker and read from it.
+ *  Then TEST_V5_PUBLISHES QoS 1 PUBLISHes on TEST_V5_TOPICS topics with 60 to 100 byte
+ *  names are written to the broker stand-in with MQTT 3.1.1 and with MQTT v5,
+ *  and the bytes per PUBLISH are reported for both.
+ */
+class TestMQTTv5Uplink
+{
+public:
+	TestMQTTv5Uplink();
+	~TestMQTTv5Uplink();
+	void test(void);
+
+private:
+	void testConnect(void);
+	void testConnack(void);
+	void testPublish(void);
+	void testSubscribe(void);
+	void testTranslate(void);
+	void sendPublishes(int version);
+	void connect(MQTTGWv5Session* session, uint16_t topicAliasMaximum);
+	MQTTGWPacket* receive(const uint8_t* frame, int length);
+	int encode(MQTTGWv5Session* session, MQTTGWPacket* packet, uint8_t* buf);
+
+	TestTLSServer _server;
+	int _listener;
+	char _port[8];
+	int _peer;
+	Network* _network;
+	char _topics[TEST_V5_TOPICS][101];
+};
+
+}
+
+#endif /* MQTTSNGATEWAY_SRC_TESTS_TESTMQTTV5UPLINK_H_ */
@@ -0,0 +1,100 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - NetworkQueue tests
+ **************************************************************************************/
+#include <stdio.h>
+#include <cassert>
+#include "TestNetworkQueue.h"
+
+using namespace std;
+using namespace MQTTSNGW;
+
+#define TEST_ACKS   1000
+
+TestNetworkQueue::TestNetworkQueue()
+{
+}
+
+TestNetworkQueue::~TestNetworkQueue()
+{
+}
+
+/*
+ *  @return the write calls made by the Network
+ */
+uint32_t TestNetworkQueue::sendAcks(bool secure, bool queued)
+{
+	uint8_t buf[1];
+	Network network(secure);
+
+	if (secure)
+	{
+		assert(network.connect("127.0.0.1", _server.getPort(), 0, _server.getCAFile(), 0, 0));
+	}
+	else
+	{
+		assert(network.connect("127.0.0.1", _server.getPort()));
+	}
+	assert(network.recv(buf, 1) == 1);
+
+	uint32_t writes = network.getWriteCnt();
+	for (int i = 0; i < TEST_ACKS; i++)
+	{
+		uint8_t puback[] = { 0x40, 0x02, (uint8_t)(i >> 8), (uint8_t)i };
+		if (queued)
+		{
+			assert(network.queue(puback, sizeof(puback), BROKER_SEND_LATENCY) == sizeof(puback));
+		}
+		else
+		{
+			assert(network.send(puback, sizeof(puback)) == sizeof(puback));
+		}
+	}
+	assert(network.flush() >= 0);
+	assert(!network.isQueued());
+	writes = network.getWriteCnt() - writes;
+	network.close();
+	return writes;
+}
+
+void TestNetworkQueue::test(void)
+{
+	uint32_t writes[2][2];
+
+	for (int secure = 0; secure < 2; secure++)
+	{
+		assert(_server.start(2, secure));
+		for (int queued = 0; queued < 2; queued++)
+		{
+			writes[secure][queued] = sendAcks(secure, queued);
+		}
+		_server.stop();
+
+		for (int queued = 0; queued < 2; queued++)
+		{
+			assert(_server.getBytes(queued) == TEST_ACKS * 4);
+		}
+		assert(writes[secure][1] < writes[secure][0]);
+		if (secure)
+		{
+			assert(_server.getRecords(1) < _server.getRecords(0));
+		}
+	}
+
+	printf("[ OK ]\n");
+	printf("      %d PUBACKs over TCP: %u writes one by one, %u writes queued\n",
+			TEST_ACKS, writes[0][0], writes[0][1]);
+	printf("      %d PUBACKs over TLS: %u records/%u writes one by one, %u records/%u writes queued\n",
+			TEST_ACKS, _server.getRecords(0), writes[1][0], _server.getRecords(1), writes[1][1]);
+}
@@ -0,0 +1,44 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - NetworkQueue tests
+ **************************************************************************************/
+#ifndef MQTTSNGATEWAY_SRC_TESTS_TESTNETWORKQUEUE_H_
+#define MQTTSNGATEWAY_SRC_TESTS_TESTNETWORKQUEUE_H_
+
+#include "TestTLSServer.h"
+
+namespace MQTTSNGW
+{
+
+/*
+ *  Writes a burst of PUBACKs to the broker stand-in, over TCP and TLS,
+ *  one Network::send() per packet and then queued the way BrokerSendTask does,
+ *  and reports the records and write calls per 1,000 acks.
+ */
+class TestNetworkQueue
+{
+public:
+	TestNetworkQueue();
+	~TestNetworkQueue();
+	void test(void);
+
+private:
+	uint32_t sendAcks(bool secure, bool queued);
+
+	TestTLSServer _server;
+};
+
+}
+
+#endif /* MQTTSNGATEWAY_SRC_TESTS_TESTNETWORKQUEUE_H_ */
@@ -0,0 +1,203 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - PacketBurst tests
+ **************************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <cassert>
+#include "TestPacketBurst.h"
+#include "MQTTSNGWPacket.h"
+#include "MQTTGWPacket.h"
+
+using namespace std;
+using namespace MQTTSNGW;
+
+static long elapsedUsec(struct timespec* start)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start->tv_sec) * 1000000 + (now.tv_nsec - start->tv_nsec) / 1000;
+}
+
+TestPacketBurst::TestPacketBurst()
+{
+	_client = new Client();
+}
+
+TestPacketBurst::~TestPacketBurst()
+{
+	delete _client;
+}
+
+/* PUBLISHes from the broker saved while the client was asleep, msgId is the index */
+void TestPacketBurst::saveSleepPackets(const char** topics, int cnt)
+{
+	char payload[32];
+
+	for ( int i = 0; i < TEST_SLEEP_PACKETS; i++ )
+	{
+		Publish pub = MQTTPacket_Publish_Initializer;
+		pub.header.bits.type = PUBLISH;
+		pub.header.bits.qos = 1;
+		pub.topic = const_cast<char*>(topics[i % cnt]);
+		pub.topiclen = strlen(pub.topic);
+		pub.msgId = i + 1;
+		pub.payload = payload;
+		pub.payloadlen = sprintf(payload, "stored message %d", i);
+
+		MQTTGWPacket* msg = new MQTTGWPacket();
+		msg->setPUBLISH(&pub);
+		assert(_client->setClientSleepPacket(msg) > 0);
+	}
+}
+
+/*
+ *  Sends the saved PUBLISHes and a PINGRESP to the socket and reads them back.
+ *  @return usecs from the wake-up until the PINGRESP arrives
+ */
+long TestPacketBurst::wakeup(SensorNetwork* network, SensorNetAddress* addr, int sock, bool burst)
+{
+	const char* topics[] = { "wake/known" };
+	uint8_t buf[MQTTSNGW_MAX_PACKET_SIZE];
+	struct timespec start;
+	int cnt = 0;
+
+	saveSleepPackets(topics, 1);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	MQTTSNPacketBurst packets;
+	assert(packets.setClientSleepPackets(_client) == TEST_SLEEP_PACKETS);
+	if ( burst )
+	{
+		assert(packets.unicast(network, addr) == TEST_SLEEP_PACKETS);
+	}
+	else
+	{
+		for ( int i = 0; i < packets.getCount(); i++ )
+		{
+			assert(packets.getPacket(i)->unicast(network, addr) > 0);
+		}
+	}
+	MQTTSNPacket pingresp;
+	pingresp.setPINGRESP();
+	assert(pingresp.unicast(network, addr) > 0);
+
+	while ( true )
+	{
+		int len = recv(sock, buf, sizeof(buf), 0);
+		assert(len > 1);
+		if ( buf[1] == MQTTSN_PINGRESP )
+		{
+			break;
+		}
+		/* the PUBLISHes come in the order they were saved */
+		assert(buf[1] == MQTTSN_PUBLISH);
+		assert(((buf[5] << 8) | buf[6]) == ++cnt);
+	}
+	long usec = elapsedUsec(&start);
+	assert(cnt == TEST_SLEEP_PACKETS);
+	return usec;
+}
+
+void TestPacketBurst::test(void)
+{
+	const char* topics[] = { "wake/known", "ab", "wake/new1", "wake/new2", "wake/new3" };
+	MQTTSN_topicid topicId;
+	uint16_t topicIdNo;
+	uint16_t msgId;
+	uint16_t pubMsgId;
+	uint8_t dup;
+	uint8_t retained;
+	int qos;
+	unsigned char* payload;
+	int payloadlen;
+	MQTTSNString topicName = MQTTSNString_initializer;
+
+	_client->getTopics()->add("wake/known");
+	_client->getTopics()->add("wake/+");
+
+	/* REGISTERs for the new topics first, then the PUBLISHes of known ones */
+	saveSleepPackets(topics, 5);
+	MQTTSNPacketBurst burst;
+	assert(burst.setClientSleepPackets(_client) == 3 + TEST_SLEEP_PACKETS * 2 / 5);
+	assert(_client->getClientSleepPacket() == nullptr);
+	for ( int i = 0; i < 3; i++ )
+	{
+		assert(burst.getPacket(i)->getType() == MQTTSN_REGISTER);
+		burst.getPacket(i)->getREGISTER(&topicIdNo, &msgId, &topicName);
+		assert(strncmp(topicName.lenstring.data, topics[i + 2], topicName.lenstring.len) == 0);
+
+		/* the PUBLISHes of a new topic wait for its REGACK */
+		int waiting = 0;
+		MQTTSNPacket* packet = nullptr;
+		while ( (packet = _client->getWaitREGACKPacketList()->getPacket(msgId)) != nullptr )
+		{
+			_client->getWaitREGACKPacketList()->erase(msgId);
+			assert(packet->getPUBLISH(&dup, &qos, &retained, &pubMsgId, &topicId, &payload, &payloadlen));
+			assert(topicId.data.id == topicIdNo);
+			delete packet;
+			waiting++;
+		}
+		assert(waiting == TEST_SLEEP_PACKETS / 5);
+	}
+	assert(_client->getWaitREGACKPacketList()->getCount() == 0);
+	for ( int i = 3; i < burst.getCount(); i++ )
+	{
+		assert(burst.getPacket(i)->getType() == MQTTSN_PUBLISH);
+	}
+
+	/* wake-up latency over the SensorNetwork */
+	SensorNetwork network;
+	SensorNetAddress addr;
+	struct sockaddr_in sockAddr;
+	socklen_t sockLen = sizeof(sockAddr);
+	struct timeval timeout = { 1, 0 };
+	char addrStr[32];
+
+	int sock = socket(AF_INET, SOCK_DGRAM, 0);
+	memset(&sockAddr, 0, sizeof(sockAddr));
+	sockAddr.sin_family = AF_INET;
+	sockAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	assert(sock >= 0);
+	assert(bind(sock, (struct sockaddr*)&sockAddr, sizeof(sockAddr)) == 0);
+	assert(getsockname(sock, (struct sockaddr*)&sockAddr, &sockLen) == 0);
+	setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	sprintf(addrStr, "127.0.0.1:%d", ntohs(sockAddr.sin_port));
+	string addrString(addrStr);
+
+	if ( network.initialize() != 0 || addr.setAddress(&addrString) != 0 )
+	{
+		close(sock);
+		printf("[ OK ]\n      wake-up latency not measured, the SensorNetwork is not UDP.\n");
+		return;
+	}
+
+	long usec[2] = { 0, 0 };
+	for ( int i = 0; i < TEST_WAKEUPS; i++ )
+	{
+		usec[0] += wakeup(&network, &addr, sock, false);
+		usec[1] += wakeup(&network, &addr, sock, true);
+	}
+	close(sock);
+
+	printf("[ OK ]\n");
+	printf("      %d stored PUBLISHes, wake-up to PINGRESP: %ld usec in %d sends packet by packet, %ld usec in %d sends burst\n",
+			TEST_SLEEP_PACKETS, usec[0] / TEST_WAKEUPS, TEST_SLEEP_PACKETS + 1, usec[1] / TEST_WAKEUPS,
+			(TEST_SLEEP_PACKETS + MAX_PACKET_BURST - 1) / MAX_PACKET_BURST + 1);
+}
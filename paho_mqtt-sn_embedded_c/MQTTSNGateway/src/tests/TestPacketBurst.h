@@ -0,0 +1,41 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - PacketBurst tests
+ **************************************************************************************/
+#ifndef MQTTSNGATEWAY_SRC_TESTS_TESTPACKETBURST_H_
+#define MQTTSNGATEWAY_SRC_TESTS_TESTPACKETBURST_H_
+
+#include "MQTTSNGWClient.h"
+#include "MQTTSNGWPacketBurst.h"
+
+#define TEST_SLEEP_PACKETS   100
+#define TEST_WAKEUPS          20
+
+using namespace MQTTSNGW;
+
+class TestPacketBurst
+{
+public:
+	TestPacketBurst();
+	~TestPacketBurst();
+	void test(void);
+
+private:
+	void saveSleepPackets(const char** topics, int cnt);
+	long wakeup(SensorNetwork* network, SensorNetAddress* addr, int sock, bool burst);
+
+	Client* _client;
+};
+
+#endif /* MQTTSNGATEWAY_SRC_TESTS_TESTPACKETBURST_H_ */
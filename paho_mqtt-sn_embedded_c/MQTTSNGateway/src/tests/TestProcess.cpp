@@ -21,6 +21,23 @@
 #include "TestQue.h"
 #include "TestTree23.h"
 #include "TestTopicIdMap.h"
+#include "TestForwarder.h"
+#include "TestPacketBurst.h"
+#include "TestClientSendScheduler.h"
+#include "TestTLSSessionCache.h"
+#include "TestNetworkQueue.h"
+#include "TestBackPressure.h"
+#include "TestClientList.h"
+#include "TestTopicNames.h"
+#include "TestAggregateTopicTable.h"
+#include "TestQoSm1FastLane.h"
+#include "TestMQTTv5Uplink.h"
+#include "TestRetainedCache.h"
+#include "TestLocalRouter.h"
+#include "TestDuplicateFilter.h"
+#include "TestBrokerPool.h"
+#include "TestIOUring.h"
+#include "TestSensorNetCapture.h"
 #include "MQTTSNGWProcess.h"
 #include "MQTTSNGWClient.h"
 #include "MQTTSNGWPacket.h"
@@ -104,12 +121,113 @@ void TestProcess::run(void)
 	testTopic->test();
 	delete testTopic;
 
+	/* Test TopicNameTable */
+    printf("Test  TopicNames     ");
+	TestTopicNames* testNames = new TestTopicNames();
+	testNames->test();
+	delete testNames;
+
 	/* Test TopicIdMap */
     printf("Test  TopicIdMap     ");
 	TestTopicIdMap* testMap = new TestTopicIdMap();
 	testMap->test();
 	delete testMap;
 
+	/* Test Forwarder */
+    printf("Test  Forwarder      ");
+	TestForwarder* testFwd = new TestForwarder();
+	testFwd->test();
+	delete testFwd;
+
+	/* Test PacketBurst */
+    printf("Test  PacketBurst    ");
+	TestPacketBurst* testBurst = new TestPacketBurst();
+	testBurst->test();
+	delete testBurst;
+
+	/* Test ClientSendScheduler */
+    printf("Test  ClientSendScheduler ");
+	TestClientSendScheduler* testSched = new TestClientSendScheduler();
+	testSched->test();
+	delete testSched;
+
+	/* Test TLSSessionCache */
+    printf("Test  TLSSessionCache ");
+	TestTLSSessionCache* testTLS = new TestTLSSessionCache();
+	testTLS->test();
+	delete testTLS;
+
+	/* Test Network queue */
+    printf("Test  NetworkQueue   ");
+	TestNetworkQueue* testQueue = new TestNetworkQueue();
+	testQueue->test();
+	delete testQueue;
+
+	/* Test back-pressure toward the broker */
+    printf("Test  BackPressure   ");
+	TestBackPressure* testBackPressure = new TestBackPressure();
+	testBackPressure->test();
+	delete testBackPressure;
+
+    printf("Test  ClientList     ");
+	TestClientList* testClientList = new TestClientList();
+	testClientList->test();
+	delete testClientList;
+
+	/* Test subscription coalescing of the Aggregater */
+    printf("Test  AggregateTopicTable ");
+	TestAggregateTopicTable* testAggregate = new TestAggregateTopicTable();
+	testAggregate->test();
+	delete testAggregate;
+
+	/* Test QoS-1 PUBLISHes sent from the receiving thread */
+    printf("Test  QoSm1FastLane  ");
+	TestQoSm1FastLane* testFastLane = new TestQoSm1FastLane();
+	testFastLane->test();
+	delete testFastLane;
+
+	/* Test the MQTT v5 broker connection */
+    printf("Test  MQTTv5Uplink   ");
+	TestMQTTv5Uplink* testV5 = new TestMQTTv5Uplink();
+	testV5->test();
+	delete testV5;
+
+	/* Test the retained message cache */
+    printf("Test  RetainedCache  ");
+	TestRetainedCache* testRetained = new TestRetainedCache();
+	testRetained->test();
+	delete testRetained;
+
+	/* Test the local routing between clients */
+    printf("Test  LocalRouter    ");
+	TestLocalRouter* testLocal = new TestLocalRouter();
+	testLocal->test();
+	delete testLocal;
+
+	/* Test the duplicate PUBLISH filter */
+    printf("Test  DuplicateFilter ");
+	TestDuplicateFilter* testDuplicate = new TestDuplicateFilter();
+	testDuplicate->test();
+	delete testDuplicate;
+
+	/* Test the broker connection pool */
+    printf("Test  BrokerPool     ");
+	TestBrokerPool* testPool = new TestBrokerPool();
+	testPool->test();
+	delete testPool;
+
+	/* Test the io_uring engine against select() */
+    printf("Test  IOUring        ");
+	TestIOUring* testUring = new TestIOUring();
+	testUring->test();
+	delete testUring;
+
+	/* Test the capture and the replay of the sensor network */
+    printf("Test  SensorNetCapture ");
+	TestSensorNetCapture* testCapture = new TestSensorNetCapture();
+	testCapture->test();
+	delete testCapture;
+
 	/* Test EventQue */
 	/*
 	printf("Test  EventQue       ");
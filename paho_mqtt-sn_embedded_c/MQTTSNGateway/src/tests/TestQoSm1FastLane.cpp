@@ -0,0 +1,347 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - QoSm1FastLane tests
+ **************************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <cassert>
+#include "TestQoSm1FastLane.h"
+#include "MQTTSNGWClient.h"
+#include "MQTTGWPacket.h"
+
+using namespace std;
+using namespace MQTTSNGW;
+
+#define TEST_QOSM1_TOTAL   (TEST_QOSM1_METERS * TEST_QOSM1_DATAGRAMS)
+
+static double elapsedSec(struct timespec* start)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+TestQoSm1FastLane::TestQoSm1FastLane()
+{
+	char name[32];
+	uint8_t payload[TEST_QOSM1_PAYLOAD];
+	MQTTSN_topicid topicid;
+
+	memset(payload, 0x55, sizeof(payload));
+	topicid.type = MQTTSN_TOPIC_TYPE_PREDEFINED;
+
+	for (int i = 0; i < TEST_QOSM1_METERS; i++)
+	{
+		_meters[i] = new Client();
+		snprintf(name, sizeof(name), "meters/%04d/power", i);
+		_meters[i]->getTopics()->add(name, i + 1);
+
+		MQTTSNPacket packet;
+		topicid.data.id = i + 1;
+		packet.setPUBLISH(0, 3, 0, 0, topicid, payload, sizeof(payload));
+		_datagramLen[i] = packet.getPacketLength();
+		memcpy(_datagrams[i], packet.getPacketData(), _datagramLen[i]);
+	}
+	_network = nullptr;
+	_writes = 0;
+}
+
+TestQoSm1FastLane::~TestQoSm1FastLane()
+{
+	for (int i = 0; i < TEST_QOSM1_METERS; i++)
+	{
+		delete _meters[i];
+	}
+}
+
+/*
+ *  The datagram ClientRecvTask receives from a meter.
+ */
+MQTTSNPacket* TestQoSm1FastLane::recv(int datagram)
+{
+	MQTTSNPacket* packet = new MQTTSNPacket();
+	int meter = datagram % TEST_QOSM1_METERS;
+	assert(packet->desirialize(_datagrams[meter], _datagramLen[meter]) > 0);
+	return packet;
+}
+
+Network* TestQoSm1FastLane::connect(void)
+{
+	uint8_t buf[1];
+	Network* network = new Network(false);
+	assert(network->connect("127.0.0.1", _server.getPort()));
+	assert(network->recv(buf, 1) == 1);
+	return network;
+}
+
+/*
+ *  PacketHandleTask, translates the PUBLISHes into MQTT ones for BrokerSendTask.
+ */
+void* TestQoSm1FastLane::runPacketHandle(void* arg)
+{
+	TestQoSm1FastLane* test = (TestQoSm1FastLane*)arg;
+	uint8_t dup;
+	int qos;
+	uint8_t retained;
+	uint16_t msgId;
+	MQTTSN_topicid topicid;
+	uint8_t* payload;
+	int payloadlen;
+
+	while (true)
+	{
+		Event* ev = test->_packetEventQue.wait();
+		if (ev->getEventType() == EtStop)
+		{
+			test->_brokerSendQue.post(ev);
+			return 0;
+		}
+
+		Client* client = ev->getClient();
+		assert(ev->getMQTTSNPacket()->getPUBLISH(&dup, &qos, &retained, &msgId, &topicid, &payload, &payloadlen));
+		Topic* topic = client->getTopics()->getTopicById(&topicid);
+		assert(topic);
+
+		Publish pub = MQTTPacket_Publish_Initializer;
+		pub.header.bits.qos = (qos == 3 ? 0 : qos);
+		pub.header.bits.retain = retained;
+		pub.topic = (char*)topic->getTopicName()->data();
+		pub.topiclen = topic->getTopicName()->length();
+		pub.payload = (char*)payload;
+		pub.payloadlen = payloadlen;
+
+		MQTTGWPacket* publish = new MQTTGWPacket();
+		publish->setPUBLISH(&pub);
+		Event* ev1 = new Event();
+		ev1->setBrokerSendEvent(client, publish);
+		test->_brokerSendQue.post(ev1);
+		delete ev;
+	}
+}
+
+/*
+ *  BrokerSendTask, queues the packets and writes them when there are no more events.
+ */
+void* TestQoSm1FastLane::runBrokerSend(void* arg)
+{
+	TestQoSm1FastLane* test = (TestQoSm1FastLane*)arg;
+
+	while (true)
+	{
+		Event* ev = test->_brokerSendQue.wait();
+		if (ev->getEventType() == EtStop)
+		{
+			assert(test->_network->flush() >= 0);
+			delete ev;
+			return 0;
+		}
+
+		if (ev->getEventType() == EtBrokerSend)
+		{
+			assert(ev->getMQTTGWPacket()->queue(test->_network, &test->_session, BROKER_SEND_LATENCY) > 0);
+		}
+		delete ev;
+
+		if (test->_brokerSendQue.size() == 0 || test->_network->isFlushDue())
+		{
+			assert(test->_network->flush() >= 0);
+		}
+	}
+}
+
+/*
+ *  @return secs from the first datagram received until the last PUBLISH is written
+ */
+double TestQoSm1FastLane::sendEvents(void)
+{
+	pthread_t packetHandle;
+	pthread_t brokerSend;
+	struct timespec start;
+
+	_network = connect();
+	uint32_t writes = _network->getWriteCnt();
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	pthread_create(&packetHandle, 0, runPacketHandle, this);
+	pthread_create(&brokerSend, 0, runBrokerSend, this);
+
+	for (int i = 0; i < TEST_QOSM1_TOTAL; i++)
+	{
+		Event* ev = new Event();
+		ev->setClientRecvEvent(_meters[i % TEST_QOSM1_METERS], recv(i));
+		_packetEventQue.post(ev);
+	}
+	Event* ev = new Event();
+	ev->setStop();
+	_packetEventQue.post(ev);
+	pthread_join(packetHandle, 0);
+	pthread_join(brokerSend, 0);
+
+	double secs = elapsedSec(&start);
+	_writes = _network->getWriteCnt() - writes;
+	_network->close();
+	delete _network;
+	return secs;
+}
+
+/*
+ *  @return secs from the first datagram received until the last PUBLISH is written
+ */
+double TestQoSm1FastLane::sendFastLane(void)
+{
+	pthread_t brokerSend;
+	struct timespec start;
+	QoSm1FastLane lane;
+	QoSm1Counters totals;
+	uint32_t refused = 0;
+
+	_network = connect();
+	uint32_t writes = _network->getWriteCnt();
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	pthread_create(&brokerSend, 0, runBrokerSend, this);
+
+	for (int i = 0; i < TEST_QOSM1_TOTAL; i++)
+	{
+		bool first = false;
+		MQTTSNPacket* packet = recv(i);
+		/* the lane never writes, a full queue waits for BrokerSendTask here */
+		while (lane.publish(_meters[i % TEST_QOSM1_METERS], packet, _network, &_session, &first) < 0)
+		{
+			refused++;
+			sched_yield();
+		}
+		delete packet;
+		if (first)
+		{
+			Event* ev = new Event();
+			ev->setBrokerFlushEvent(_meters[0]);
+			_brokerSendQue.post(ev);
+		}
+	}
+	Event* ev = new Event();
+	ev->setStop();
+	_brokerSendQue.post(ev);
+	pthread_join(brokerSend, 0);
+
+	double secs = elapsedSec(&start);
+	assert(_network->getBacklog() == 0);
+	_writes = _network->getWriteCnt() - writes;
+	_network->close();
+	delete _network;
+
+	lane.getTotals(&totals);
+	assert(lane.getSenderCount() == TEST_QOSM1_METERS);
+	assert(totals.published == TEST_QOSM1_TOTAL);
+	assert(totals.dropped == refused);
+	assert(totals.bytes == (uint64_t)TEST_QOSM1_TOTAL * (1 + 1 + 2 + 17 + TEST_QOSM1_PAYLOAD));
+	return secs;
+}
+
+/*
+ *  The lane writes the same PUBLISH as PacketHandleTask does, for predefined and short TopicIds,
+ *  and leaves other PUBLISHes to it.
+ */
+void TestQoSm1FastLane::testFrames(void)
+{
+	uint8_t lane[MQTTSNGW_MAX_PACKET_SIZE];
+	uint8_t event[MQTTSNGW_MAX_PACKET_SIZE];
+	uint8_t payload[] = { 1, 2, 3 };
+	QoSm1FastLane fastLane;
+	QoSm1Counters counters;
+	Topics commonTopics;
+	MQTTSN_topicid topicid;
+	MQTTSNPacket packet;
+	Client* client = _meters[7];
+
+	/* predefined topic of the client */
+	MQTTSNPacket* datagram = recv(7);
+	MQTTGWPacket publish;
+	Publish pub = MQTTPacket_Publish_Initializer;
+	pub.topic = (char*)"meters/0007/power";
+	pub.topiclen = strlen(pub.topic);
+	pub.payload = (char*)_datagrams[7] + _datagramLen[7] - TEST_QOSM1_PAYLOAD;
+	pub.payloadlen = TEST_QOSM1_PAYLOAD;
+	publish.setPUBLISH(&pub);
+	int len = fastLane.build(client, datagram, lane, sizeof(lane));
+	assert(len == publish.getPacketData(event));
+	assert(memcmp(lane, event, len) == 0);
+	assert(fastLane.build(client, datagram, lane, len - 1) == 0);
+	delete datagram;
+
+	/* retained short topic */
+	topicid.type = MQTTSN_TOPIC_TYPE_SHORT;
+	topicid.data.short_name[0] = 'a';
+	topicid.data.short_name[1] = 'b';
+	packet.setPUBLISH(0, 3, 1, 0, topicid, payload, sizeof(payload));
+	pub.header.bits.retain = 1;
+	pub.topic = (char*)"ab";
+	pub.topiclen = 2;
+	pub.payload = (char*)payload;
+	pub.payloadlen = sizeof(payload);
+	publish.setPUBLISH(&pub);
+	len = fastLane.build(client, &packet, lane, sizeof(lane));
+	assert(len == publish.getPacketData(event));
+	assert(memcmp(lane, event, len) == 0);
+
+	/* predefined topic of the gateway */
+	commonTopics.add("meters/all", 5000);
+	fastLane.setCommonTopics(&commonTopics);
+	topicid.type = MQTTSN_TOPIC_TYPE_PREDEFINED;
+	topicid.data.id = 5000;
+	packet.setPUBLISH(0, 3, 0, 0, topicid, payload, sizeof(payload));
+	len = fastLane.build(client, &packet, lane, sizeof(lane));
+	assert(len == 1 + 1 + 2 + 10 + (int)sizeof(payload));
+	assert(memcmp(lane + 4, "meters/all", 10) == 0);
+
+	/* unknown TopicId, dropped */
+	topicid.data.id = 5001;
+	packet.setPUBLISH(0, 3, 0, 0, topicid, payload, sizeof(payload));
+	assert(fastLane.build(client, &packet, lane, sizeof(lane)) == -1);
+
+	/* QoS 0 and normal TopicIds go through PacketHandleTask */
+	topicid.data.id = 8;
+	packet.setPUBLISH(0, 0, 0, 0, topicid, payload, sizeof(payload));
+	assert(fastLane.build(client, &packet, lane, sizeof(lane)) == 0);
+	topicid.type = MQTTSN_TOPIC_TYPE_NORMAL;
+	topicid.data.long_.name = (char*)"meters/0008/power";
+	topicid.data.long_.len = 17;
+	packet.setPUBLISH(0, 3, 0, 0, topicid, payload, sizeof(payload));
+	assert(fastLane.build(client, &packet, lane, sizeof(lane)) == 0);
+
+	assert(fastLane.getCounters(client, &counters));
+	assert(counters.dropped == 1);
+	assert(!fastLane.getCounters(_meters[8], &counters));
+}
+
+void TestQoSm1FastLane::test(void)
+{
+	testFrames();
+
+	assert(_server.start(2, false));
+	double eventSecs = sendEvents();
+	uint32_t eventWrites = _writes;
+	double laneSecs = sendFastLane();
+	uint32_t laneWrites = _writes;
+	_server.stop();
+
+	uint32_t bytes = _server.getBytes(1);
+	assert(_server.getBytes(0) == bytes);
+
+	printf("[ OK ]\n");
+	printf("      %d QoS-1 datagrams through PacketHandleTask: %.0f datagrams/sec, %.1f MB/sec to the broker in %u writes\n",
+			TEST_QOSM1_TOTAL, TEST_QOSM1_TOTAL / eventSecs, bytes / eventSecs / 1e6, eventWrites);
+	printf("      %d QoS-1 datagrams through the fast lane:  %.0f datagrams/sec, %.1f MB/sec to the broker in %u writes\n",
+			TEST_QOSM1_TOTAL, TEST_QOSM1_TOTAL / laneSecs, bytes / laneSecs / 1e6, laneWrites);
+}
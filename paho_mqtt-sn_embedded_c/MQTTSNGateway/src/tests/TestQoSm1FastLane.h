@@ -0,0 +1,66 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - QoSm1FastLane tests
+ **************************************************************************************/
+#ifndef MQTTSNGATEWAY_SRC_TESTS_TESTQOSM1FASTLANE_H_
+#define MQTTSNGATEWAY_SRC_TESTS_TESTQOSM1FASTLANE_H_
+
+#include "TestTLSServer.h"
+#include "MQTTSNGateway.h"
+#include "MQTTSNGWQoSm1FastLane.h"
+
+#define TEST_QOSM1_METERS        1000
+#define TEST_QOSM1_DATAGRAMS      100   // PUBLISHes of each meter
+#define TEST_QOSM1_PAYLOAD         24
+
+namespace MQTTSNGW
+{
+
+/*
+ *  TEST_QOSM1_METERS QoS-1 clients publish to their predefined topics. The datagrams go
+ *  to the broker stand-in through PacketHandleTask and BrokerSendTask threads the way
+ *  the events do, and then through the QoSm1FastLane from the receiving thread, and the
+ *  datagrams per second and the bytes written to the broker are reported for both.
+ */
+class TestQoSm1FastLane
+{
+public:
+	TestQoSm1FastLane();
+	~TestQoSm1FastLane();
+	void test(void);
+
+	static void* runPacketHandle(void* arg);
+	static void* runBrokerSend(void* arg);
+
+private:
+	void testFrames(void);
+	double sendEvents(void);
+	double sendFastLane(void);
+	Network* connect(void);
+	MQTTSNPacket* recv(int datagram);
+
+	TestTLSServer _server;
+	Client* _meters[TEST_QOSM1_METERS];
+	unsigned char _datagrams[TEST_QOSM1_METERS][TEST_QOSM1_PAYLOAD + 16];
+	int _datagramLen[TEST_QOSM1_METERS];
+	EventQue _packetEventQue;
+	EventQue _brokerSendQue;
+	Network* _network;
+	MQTTGWv5Session _session;
+	uint32_t _writes;
+};
+
+}
+
+#endif /* MQTTSNGATEWAY_SRC_TESTS_TESTQOSM1FASTLANE_H_ */
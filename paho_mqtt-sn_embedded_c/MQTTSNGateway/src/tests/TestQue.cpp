@@ -63,6 +63,8 @@ void TestQue::test(void)
 		this->post(v);
 		assert( 5 >= this->size());
 	}
+	assert( 5 == _que.getDropCnt());
+	assert( 10 == _que.getHighWater());
 	for ( i = 0; i < 10; i++ )
 	{
 		int* p = this->front();
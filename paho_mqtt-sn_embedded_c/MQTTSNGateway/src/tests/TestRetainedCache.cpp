@@ -0,0 +1,289 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - RetainedCache tests
+ **************************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <cassert>
+#include "TestRetainedCache.h"
+#include "MQTTSNGWClient.h"
+#include "MQTTGWPacket.h"
+
+using namespace std;
+using namespace MQTTSNGW;
+
+#define TEST_RETAINED_TOPIC    "site/3/meter/0042/config"
+#define TEST_RETAINED_PAYLOAD  "{\"interval\":300,\"unit\":\"kWh\"}"
+
+static double elapsedSec(struct timespec* start)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+TestRetainedCache::TestRetainedCache()
+{
+	struct sockaddr_in addr;
+	socklen_t addrLen = sizeof(addr);
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+	_listener = socket(AF_INET, SOCK_STREAM, 0);
+	assert(_listener >= 0);
+	assert(bind(_listener, (struct sockaddr*)&addr, sizeof(addr)) == 0);
+	assert(listen(_listener, 1) == 0);
+	assert(getsockname(_listener, (struct sockaddr*)&addr, &addrLen) == 0);
+	snprintf(_port, sizeof(_port), "%d", ntohs(addr.sin_port));
+	_client = new Client();
+}
+
+TestRetainedCache::~TestRetainedCache()
+{
+	close(_listener);
+	delete _client;
+}
+
+/*
+ *  The broker stand-in, answers each SUBSCRIBE with a SUBACK and the retained message
+ *  of the topic after TEST_RETAINED_BROKER_DELAY msecs.
+ */
+void* TestRetainedCache::runBroker(void* arg)
+{
+	TestRetainedCache* test = (TestRetainedCache*)arg;
+	uint8_t buf[MQTTSNGW_MAX_PACKET_SIZE];
+	int sock = accept(test->_listener, 0, 0);
+	assert(sock >= 0);
+
+	while (recv(sock, buf, 2, MSG_WAITALL) == 2)
+	{
+		/* short packets only, one byte of remaining length */
+		assert(recv(sock, buf + 2, buf[1], MSG_WAITALL) == buf[1]);
+		if ((buf[0] >> 4) != SUBSCRIBE)
+		{
+			continue;
+		}
+		usleep(TEST_RETAINED_BROKER_DELAY * 1000);
+
+		uint16_t topicLen = (buf[4] << 8) | buf[5];
+		uint8_t resp[MQTTSNGW_MAX_PACKET_SIZE];
+		uint8_t* ptr = resp;
+		*ptr++ = 0x90;
+		*ptr++ = 3;
+		*ptr++ = buf[2];
+		*ptr++ = buf[3];
+		*ptr++ = 1;
+		*ptr++ = (PUBLISH << 4) | 1;
+		*ptr++ = 2 + topicLen + strlen(TEST_RETAINED_PAYLOAD);
+		memcpy(ptr, buf + 4, 2 + topicLen);
+		ptr += 2 + topicLen;
+		memcpy(ptr, TEST_RETAINED_PAYLOAD, strlen(TEST_RETAINED_PAYLOAD));
+		ptr += strlen(TEST_RETAINED_PAYLOAD);
+		assert(write(sock, resp, ptr - resp) == ptr - resp);
+	}
+	close(sock);
+	return 0;
+}
+
+/*
+ *  Stored by retained PUBLISHes, dropped by empty ones and by other payloads without the flag.
+ */
+void TestRetainedCache::testUpdate(void)
+{
+	RetainedCache cache;
+	const char* topic = TEST_RETAINED_TOPIC;
+	uint16_t len = strlen(topic);
+
+	assert(!cache.update(_client, topic, len, (uint8_t*)"abc", 3, true));
+	assert(cache.getCount() == 0);
+
+	cache.initialize(10, 0);
+	assert(!cache.update(_client, topic, len, (uint8_t*)"abc", 3, true));
+	assert(cache.getCount() == 1);
+
+	/* the same payload without the flag keeps it, another one drops it */
+	assert(!cache.update(_client, topic, len, (uint8_t*)"abc", 3, false));
+	assert(cache.getCount() == 1);
+	assert(!cache.update(_client, topic, len, (uint8_t*)"abd", 3, false));
+	assert(cache.getCount() == 0);
+
+	/* a client's retained PUBLISH replaces it, an empty one deletes it */
+	assert(!cache.update(nullptr, topic, len, (uint8_t*)"abc", 3, true));
+	assert(!cache.update(nullptr, topic, len, (uint8_t*)"xyz", 3, true));
+	assert(cache.getCount() == 1);
+	assert(!cache.update(nullptr, topic, len, (uint8_t*)"", 0, true));
+	assert(cache.getCount() == 0);
+
+	/* the topic names are compared in full */
+	assert(!cache.update(nullptr, topic, len - 1, (uint8_t*)"abc", 3, true));
+	assert(!cache.update(nullptr, topic, len, (uint8_t*)"", 0, true));
+	assert(cache.getCount() == 1);
+}
+
+/*
+ *  A client served the message does not get the broker's copy, other clients do.
+ */
+void TestRetainedCache::testServe(void)
+{
+	RetainedCache cache;
+	RetainedCacheCounters counters;
+	Client other;
+	const char* topic = TEST_RETAINED_TOPIC;
+	uint16_t len = strlen(topic);
+	MQTTSN_topicid topicid;
+	uint8_t dup;
+	int qos;
+	uint8_t retained;
+	uint16_t msgId;
+	MQTTSN_topicid pubTopic;
+	uint8_t* payload;
+	int payloadlen;
+
+	cache.initialize(10, 0);
+	topicid.type = MQTTSN_TOPIC_TYPE_NORMAL;
+	topicid.data.id = 7;
+	assert(cache.serve(_client, topic, len, &topicid) == nullptr);
+
+	assert(!cache.update(_client, topic, len, (uint8_t*)"abc", 3, true));
+	MQTTSNPacket* packet = cache.serve(_client, topic, len, &topicid);
+	assert(packet);
+	assert(packet->getPUBLISH(&dup, &qos, &retained, &msgId, &pubTopic, &payload, &payloadlen));
+	assert(qos == 0 && retained == 1 && msgId == 0);
+	assert(pubTopic.type == MQTTSN_TOPIC_TYPE_NORMAL && pubTopic.data.id == 7);
+	assert(payloadlen == 3 && memcmp(payload, "abc", 3) == 0);
+	delete packet;
+
+	assert(cache.update(_client, topic, len, (uint8_t*)"abc", 3, true));
+	assert(!cache.update(_client, topic, len, (uint8_t*)"abc", 3, true));
+	assert(!cache.update(&other, topic, len, (uint8_t*)"abc", 3, true));
+
+	/* a newer message from the broker goes to the client */
+	delete cache.serve(_client, topic, len, &topicid);
+	assert(!cache.update(_client, topic, len, (uint8_t*)"abd", 3, true));
+
+	/* a client whose subscription the broker rejected gets a later copy */
+	delete cache.serve(_client, topic, len, &topicid);
+	cache.forget(_client);
+	assert(!cache.update(_client, topic, len, (uint8_t*)"abd", 3, true));
+
+	cache.getCounters(&counters);
+	assert(counters.hits == 3 && counters.misses == 1 && counters.duplicates == 1);
+}
+
+/*
+ *  The least recently stored messages make room, and messages expire.
+ */
+void TestRetainedCache::testBounds(void)
+{
+	RetainedCache cache;
+	RetainedCacheCounters counters;
+	MQTTSN_topicid topicid;
+	char topic[32];
+
+	cache.initialize(500, 1);
+	topicid.type = MQTTSN_TOPIC_TYPE_NORMAL;
+	topicid.data.id = 1;
+	for (int i = 0; i < 1000; i++)
+	{
+		snprintf(topic, sizeof(topic), "meters/%04d/config", i);
+		cache.update(nullptr, topic, strlen(topic), (uint8_t*)topic, 6, true);
+	}
+	assert(cache.getCount() == 500);
+	cache.getCounters(&counters);
+	assert(counters.evictions == 500);
+
+	assert(cache.serve(_client, "meters/0499/config", 18, &topicid) == nullptr);
+	MQTTSNPacket* packet = cache.serve(_client, "meters/0500/config", 18, &topicid);
+	assert(packet);
+	delete packet;
+
+	usleep(1100000);
+	assert(cache.serve(_client, "meters/0501/config", 18, &topicid) == nullptr);
+	assert(cache.getCount() == 499);
+}
+
+/*
+ *  SUBSCRIBE to the broker stand-in until the retained PUBLISH is read.
+ *  @return the average secs.
+ */
+double TestRetainedCache::subscribeBroker(RetainedCache* cache)
+{
+	Network network(false);
+	struct timespec start;
+	Publish pub;
+	assert(pthread_create(&_thread, 0, runBroker, this) == 0);
+	assert(network.connect("127.0.0.1", _port));
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int i = 0; i < TEST_RETAINED_SUBSCRIBES; i++)
+	{
+		MQTTGWPacket subscribe;
+		subscribe.setSUBSCRIBE(TEST_RETAINED_TOPIC, 1, i + 1);
+		assert(subscribe.send(&network) > 0);
+
+		MQTTGWPacket suback;
+		assert(suback.recv(&network) > 0 && suback.getType() == SUBACK);
+		MQTTGWPacket publish;
+		assert(publish.recv(&network) > 0 && publish.getPUBLISH(&pub));
+		assert(pub.header.bits.retain);
+		cache->update(_client, pub.topic, pub.topiclen, (uint8_t*)pub.payload, pub.payloadlen, true);
+	}
+	double secs = elapsedSec(&start);
+	network.close();
+	pthread_join(_thread, 0);
+	return secs / TEST_RETAINED_SUBSCRIBES;
+}
+
+/*
+ *  The same SUBSCRIBEs answered by the cache.
+ */
+double TestRetainedCache::subscribeCache(RetainedCache* cache)
+{
+	struct timespec start;
+	MQTTSN_topicid topicid;
+	topicid.type = MQTTSN_TOPIC_TYPE_NORMAL;
+	topicid.data.id = 1;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int i = 0; i < TEST_RETAINED_SUBSCRIBES; i++)
+	{
+		MQTTSNPacket* packet = cache->serve(_client, TEST_RETAINED_TOPIC, strlen(TEST_RETAINED_TOPIC), &topicid);
+		assert(packet);
+		delete packet;
+	}
+	return elapsedSec(&start) / TEST_RETAINED_SUBSCRIBES;
+}
+
+void TestRetainedCache::test(void)
+{
+	testUpdate();
+	testServe();
+	testBounds();
+
+	RetainedCache cache;
+	cache.initialize(100, DEFAULT_RETAINED_CACHE_EXPIRY);
+	double brokerSecs = subscribeBroker(&cache);
+	double cacheSecs = subscribeCache(&cache);
+	assert(cache.getCount() == 1);
+	assert(cacheSecs < brokerSecs);
+
+	printf("[ OK ]\n");
+	printf("      SUBSCRIBE to the retained message, broker answering in %d msecs: %.2f msecs through the broker, %.2f usecs from the cache\n",
+			TEST_RETAINED_BROKER_DELAY, brokerSecs * 1e3, cacheSecs * 1e6);
+}
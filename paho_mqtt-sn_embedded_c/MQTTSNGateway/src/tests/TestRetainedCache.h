@@ -0,0 +1,56 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - RetainedCache tests
+ **************************************************************************************/
+#ifndef MQTTSNGATEWAY_SRC_TESTS_TESTRETAINEDCACHE_H_
+#define MQTTSNGATEWAY_SRC_TESTS_TESTRETAINEDCACHE_H_
+
+#include <pthread.h>
+#include "MQTTSNGWRetainedCache.h"
+
+#define TEST_RETAINED_BROKER_DELAY   20   // msecs the broker stand-in takes to answer a SUBSCRIBE
+#define TEST_RETAINED_SUBSCRIBES     10
+
+namespace MQTTSNGW
+{
+
+/*
+ *  RetainedCache, and the time from a SUBSCRIBE to the retained message when the broker
+ *  stand-in answers it after TEST_RETAINED_BROKER_DELAY msecs and when the cache does.
+ */
+class TestRetainedCache
+{
+public:
+	TestRetainedCache();
+	~TestRetainedCache();
+	void test(void);
+
+	static void* runBroker(void* arg);
+
+private:
+	void testUpdate(void);
+	void testServe(void);
+	void testBounds(void);
+	double subscribeBroker(RetainedCache* cache);
+	double subscribeCache(RetainedCache* cache);
+
+	int _listener;
+	char _port[8];
+	pthread_t _thread;
+	Client* _client;
+};
+
+}
+
+#endif /* MQTTSNGATEWAY_SRC_TESTS_TESTRETAINEDCACHE_H_ */
@@ -0,0 +1,342 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - SensorNetCapture tests
+ **************************************************************************************/
+#include <time.h>
+#include <math.h>
+#include <poll.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <cassert>
+#include "TestSensorNetCapture.h"
+#include "MQTTSNGWReplayer.h"
+#include "MQTTSNPacket.h"
+
+using namespace std;
+using namespace MQTTSNGW;
+
+/* PUBLISH, QoS 0, TopicId 1, the client's number and 4 bytes of sequence number */
+#define TEST_CAPTURE_DATAGRAM_SIZE  12
+
+static void setDatagram(uint8_t* datagram, uint8_t client, uint32_t seq)
+{
+	uint8_t header[] = { TEST_CAPTURE_DATAGRAM_SIZE, MQTTSN_PUBLISH, 0, 0, 1, 0, 0, client };
+	memcpy(datagram, header, sizeof(header));
+	memcpy(datagram + 8, &seq, sizeof(seq));
+}
+
+static uint64_t nowNsecs(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int bindLoopback(uint16_t portNo)
+{
+	sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(portNo);
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	int sockfd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	assert(sockfd >= 0);
+	assert(bind(sockfd, (sockaddr*)&addr, sizeof(addr)) == 0);
+	return sockfd;
+}
+
+TestSensorNetCapture::TestSensorNetCapture()
+{
+	_sockfd = -1;
+	_received = 0;
+}
+
+TestSensorNetCapture::~TestSensorNetCapture()
+{
+}
+
+/*
+ *  The clients send their datagrams in turn, one every TEST_CAPTURE_INTERVAL nanosecs.
+ */
+void* TestSensorNetCapture::runClients(void* arg)
+{
+	int socks[TEST_CAPTURE_CLIENTS];
+	uint8_t datagram[TEST_CAPTURE_DATAGRAM_SIZE];
+	sockaddr_in dest;
+	dest.sin_family = AF_INET;
+	dest.sin_port = htons(TEST_CAPTURE_PORT);
+	dest.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	for (int i = 0; i < TEST_CAPTURE_CLIENTS; i++)
+	{
+		socks[i] = bindLoopback(0);
+	}
+	uint64_t due = nowNsecs();
+	for (uint32_t seq = 0; seq < TEST_CAPTURE_DATAGRAMS; seq++)
+	{
+		for (int i = 0; i < TEST_CAPTURE_CLIENTS; i++)
+		{
+			struct timespec ts;
+			due += TEST_CAPTURE_INTERVAL;
+			ts.tv_sec = due / 1000000000ULL;
+			ts.tv_nsec = due % 1000000000ULL;
+			clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, 0);
+			setDatagram(datagram, i, seq);
+			assert(sendto(socks[i], datagram, sizeof(datagram), 0, (sockaddr*)&dest, sizeof(dest)) == sizeof(datagram));
+		}
+	}
+	for (int i = 0; i < TEST_CAPTURE_CLIENTS; i++)
+	{
+		close(socks[i]);
+	}
+	return 0;
+}
+
+/*
+ *  Sends PUBACKs from the UDPPort while it receives, one at a time and in bursts.
+ */
+void* TestSensorNetCapture::runReplier(void* arg)
+{
+	TestSensorNetCapture* test = (TestSensorNetCapture*)arg;
+	uint8_t puback[] = { 7, MQTTSN_PUBACK, 0, 1, 0, 0, MQTTSN_RC_ACCEPTED };
+	const uint8_t* bufs[8];
+	uint16_t lengths[8];
+	sockaddr_in addr;
+	socklen_t len = sizeof(addr);
+	SensorNetAddress sink;
+
+	assert(getsockname(test->_sockfd, (sockaddr*)&addr, &len) == 0);
+	sink.setAddress(addr.sin_addr.s_addr, addr.sin_port);
+	for (int i = 0; i < 8; i++)
+	{
+		bufs[i] = puback;
+		lengths[i] = sizeof(puback);
+	}
+	for (int round = 0, sent = 0; sent < TEST_CAPTURE_REPLIES; round++)
+	{
+		if (round % 2 && TEST_CAPTURE_REPLIES - sent >= 8)
+		{
+			assert(test->_port.unicast(bufs, lengths, 8, &sink) == 8);
+			sent += 8;
+		}
+		else
+		{
+			assert(test->_port.unicast(puback, sizeof(puback), &sink) == sizeof(puback));
+			sent++;
+		}
+		usleep(100);
+	}
+	return 0;
+}
+
+/*
+ *  Records the datagrams of the clients received by the UDPPort and the PUBACKs it sends at the same time.
+ */
+void TestSensorNetCapture::capture(const char* fileName)
+{
+	uint8_t buf[MQTTSNGW_MAX_PACKET_SIZE];
+	SensorNetAddress addr;
+	pthread_t clients;
+	pthread_t replier;
+
+	assert(_port.open("225.1.1.1", TEST_CAPTURE_PORT + 1, TEST_CAPTURE_PORT) == 0);
+	assert(_port.openCapture(fileName));
+	_sockfd = bindLoopback(0);
+	assert(pthread_create(&clients, 0, runClients, this) == 0);
+	assert(pthread_create(&replier, 0, runReplier, this) == 0);
+
+	for (int i = 0; i < TEST_CAPTURE_CLIENTS * TEST_CAPTURE_DATAGRAMS; i++)
+	{
+		assert(_port.recv(buf, sizeof(buf), &addr) == TEST_CAPTURE_DATAGRAM_SIZE);
+	}
+	pthread_join(clients, 0);
+	pthread_join(replier, 0);
+	_port.close();
+	close(_sockfd);
+
+	SensorNetCapture* capture = _port.getCapture();
+	assert(capture->getDropCnt() == 0);
+	assert(capture->getRecordCnt() == TEST_CAPTURE_CLIENTS * TEST_CAPTURE_DATAGRAMS + TEST_CAPTURE_REPLIES);
+}
+
+/*
+ *  Reads the capture, each client's datagrams in order and the PUBACKs.
+ *  @return secs from the first to the last datagram of the clients
+ */
+double TestSensorNetCapture::readBack(const char* fileName)
+{
+	SensorNetCaptureReader reader;
+	SensorNetRecord rec;
+	uint32_t next[TEST_CAPTURE_CLIENTS] = { 0 };
+	uint16_t portNos[TEST_CAPTURE_CLIENTS] = { 0 };
+	uint64_t first = 0;
+	uint64_t last = 0;
+	int replies = 0;
+
+	assert(reader.open(fileName));
+	while (reader.next(&rec))
+	{
+		if (rec.srcPort == htons(TEST_CAPTURE_PORT))
+		{
+			assert(rec.length == 7 && rec.data[1] == MQTTSN_PUBACK && rec.dstAddress == htonl(INADDR_LOOPBACK));
+			replies++;
+			continue;
+		}
+		uint8_t client = rec.data[7];
+		uint32_t seq;
+		memcpy(&seq, rec.data + 8, sizeof(seq));
+		assert(rec.length == TEST_CAPTURE_DATAGRAM_SIZE && rec.origLength == rec.length && client < TEST_CAPTURE_CLIENTS);
+		assert(rec.dstPort == htons(TEST_CAPTURE_PORT) && rec.srcAddress == htonl(INADDR_LOOPBACK));
+		assert(seq == next[client]++);
+		assert(portNos[client] == 0 || portNos[client] == rec.srcPort);
+		portNos[client] = rec.srcPort;
+		first = first ? first : rec.nsecs;
+		last = rec.nsecs;
+	}
+	for (int i = 0; i < TEST_CAPTURE_CLIENTS; i++)
+	{
+		assert(next[i] == TEST_CAPTURE_DATAGRAMS);
+	}
+	assert(replies == TEST_CAPTURE_REPLIES);
+	return (last - first) / 1e9;
+}
+
+/*
+ *  Receives the replayed datagrams, each client's in order and from an address of its own.
+ */
+void* TestSensorNetCapture::runReceiver(void* arg)
+{
+	TestSensorNetCapture* test = (TestSensorNetCapture*)arg;
+	uint8_t buf[MQTTSNGW_MAX_PACKET_SIZE];
+	uint32_t next[TEST_CAPTURE_CLIENTS] = { 0 };
+	uint16_t portNos[TEST_CAPTURE_CLIENTS] = { 0 };
+	pollfd pfd = { test->_sockfd, POLLIN, 0 };
+
+	while (test->_received < TEST_CAPTURE_CLIENTS * TEST_CAPTURE_DATAGRAMS && poll(&pfd, 1, 2000) > 0)
+	{
+		sockaddr_in sender;
+		socklen_t len = sizeof(sender);
+		assert(recvfrom(test->_sockfd, buf, sizeof(buf), 0, (sockaddr*)&sender, &len) == TEST_CAPTURE_DATAGRAM_SIZE);
+		uint8_t client = buf[7];
+		uint32_t seq;
+		memcpy(&seq, buf + 8, sizeof(seq));
+		assert(client < TEST_CAPTURE_CLIENTS && seq >= next[client]);
+		next[client] = seq + 1;
+		if (portNos[client] == 0)
+		{
+			for (int i = 0; i < TEST_CAPTURE_CLIENTS; i++)
+			{
+				assert(portNos[i] != sender.sin_port);
+			}
+			portNos[client] = sender.sin_port;
+		}
+		assert(portNos[client] == sender.sin_port);
+		test->_received++;
+	}
+	return 0;
+}
+
+/*
+ *  Replays the capture to a socket.
+ *  @param speed 0 for as fast as possible
+ */
+void TestSensorNetCapture::replay(const char* fileName, double speed, double* secs, double* maxLag)
+{
+	Replayer replayer;
+	ReplayCounters counters;
+	pthread_t receiver;
+	int bufSize = 8 * 1024 * 1024;
+	socklen_t len = sizeof(bufSize);
+
+	_sockfd = bindLoopback(TEST_CAPTURE_REPLAY_PORT);
+	if (setsockopt(_sockfd, SOL_SOCKET, SO_RCVBUFFORCE, &bufSize, len) < 0)
+	{
+		setsockopt(_sockfd, SOL_SOCKET, SO_RCVBUF, &bufSize, len);
+	}
+	getsockopt(_sockfd, SOL_SOCKET, SO_RCVBUF, &bufSize, &len);
+	_received = 0;
+	assert(pthread_create(&receiver, 0, runReceiver, this) == 0);
+
+	assert(replayer.open(fileName, "127.0.0.1", TEST_CAPTURE_REPLAY_PORT, TEST_CAPTURE_PORT));
+	assert(replayer.run(speed) == TEST_CAPTURE_CLIENTS * TEST_CAPTURE_DATAGRAMS);
+	replayer.getCounters(&counters);
+	pthread_join(receiver, 0);
+	close(_sockfd);
+
+	assert(counters.senders == TEST_CAPTURE_CLIENTS && counters.failed == 0);
+	/* the datagrams sent as fast as possible all fit in a large enough socket buffer */
+	assert(_received == counters.sent || (speed == 0 && bufSize < 4 * 1024 * 1024));
+	*secs = counters.elapsed / 1e9;
+	*maxLag = counters.maxLag / 1e6;
+}
+
+/*
+ *  @return nanosecs of a record(), batches smaller than the ring are written between the measures
+ */
+double TestSensorNetCapture::recordNsecs(const char* fileName)
+{
+	SensorNetCapture capture;
+	uint8_t datagram[TEST_CAPTURE_DATAGRAM_SIZE];
+	uint64_t nsecs = 0;
+	uint32_t cnt = 0;
+
+	assert(capture.open(fileName));
+	for (int batch = 0; batch < 25; batch++)
+	{
+		uint64_t start = nowNsecs();
+		for (int i = 0; i < CAPTURE_RING_SIZE / 2; i++, cnt++)
+		{
+			setDatagram(datagram, 0, cnt);
+			capture.record(htonl(INADDR_LOOPBACK), htons(10001), INADDR_ANY, htons(10000), datagram, sizeof(datagram));
+		}
+		nsecs += nowNsecs() - start;
+		usleep(20000);
+	}
+	capture.close();
+	assert(capture.getDropCnt() == 0 && capture.getRecordCnt() == cnt);
+	return (double)nsecs / cnt;
+}
+
+void TestSensorNetCapture::test(void)
+{
+	char fileName[] = "/tmp/testCaptureXXXXXX";
+	double maxSecs;
+	double speedSecs;
+	double lag;
+
+	int fd = mkstemp(fileName);
+	assert(fd >= 0);
+	close(fd);
+
+	capture(fileName);
+	double span = readBack(fileName);
+	replay(fileName, 0, &maxSecs, &lag);
+	replay(fileName, TEST_CAPTURE_SPEED, &speedSecs, &lag);
+	double expected = span / TEST_CAPTURE_SPEED;
+	assert(fabs(speedSecs - expected) < expected * 0.1 + 0.005);
+	double nsecs = recordNsecs(fileName);
+	unlink(fileName);
+
+	printf("[ OK ]\n");
+	printf("      %d datagrams received and %d sent captured, record() %.0f nsecs\n",
+			TEST_CAPTURE_CLIENTS * TEST_CAPTURE_DATAGRAMS, TEST_CAPTURE_REPLIES, nsecs);
+	printf("      replayed as fast as possible in %.3f secs, %.0f/sec, %d clients in order\n",
+			maxSecs, TEST_CAPTURE_CLIENTS * TEST_CAPTURE_DATAGRAMS / maxSecs, TEST_CAPTURE_CLIENTS);
+	printf("      replayed %dx faster in %.3f secs for %.3f secs captured, max lag %.3f msecs\n",
+			TEST_CAPTURE_SPEED, speedSecs, span, lag);
+}
@@ -0,0 +1,62 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - SensorNetCapture tests
+ **************************************************************************************/
+#ifndef MQTTSNGATEWAY_SRC_TESTS_TESTSENSORNETCAPTURE_H_
+#define MQTTSNGATEWAY_SRC_TESTS_TESTSENSORNETCAPTURE_H_
+
+#include <pthread.h>
+#include "SensorNetwork.h"
+#include "SensorNetCapture.h"
+
+#define TEST_CAPTURE_CLIENTS          4
+#define TEST_CAPTURE_DATAGRAMS     2000   // sent by each client
+#define TEST_CAPTURE_INTERVAL     50000   // nanosecs between two datagrams of the clients
+#define TEST_CAPTURE_REPLIES       2000   // sent by the UDPPort while it receives
+#define TEST_CAPTURE_SPEED            2
+#define TEST_CAPTURE_PORT         21885   // Gateway port of the UDPPort, the multicast port is the next one
+#define TEST_CAPTURE_REPLAY_PORT  21887   // the replayed datagrams are sent to
+
+namespace MQTTSNGW
+{
+
+/*
+ *  SensorNetCapture records what a UDPPort receives from several clients while another
+ *  thread sends, the file is read back, and Replayer sends it to a socket as fast as
+ *  possible and then TEST_CAPTURE_SPEED times faster than captured.
+ */
+class TestSensorNetCapture
+{
+public:
+	TestSensorNetCapture();
+	~TestSensorNetCapture();
+	void test(void);
+
+private:
+	void capture(const char* fileName);
+	double readBack(const char* fileName);
+	void replay(const char* fileName, double speed, double* secs, double* maxLag);
+	double recordNsecs(const char* fileName);
+	static void* runClients(void* arg);
+	static void* runReplier(void* arg);
+	static void* runReceiver(void* arg);
+
+	UDPPort _port;
+	int _sockfd;
+	uint32_t _received;
+};
+
+}
+
+#endif /* MQTTSNGATEWAY_SRC_TESTS_TESTSENSORNETCAPTURE_H_ */
@@ -0,0 +1,295 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - TLSServer tests
+ **************************************************************************************/
+#include <stdio.h>
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+#include <netinet/tcp.h>
+#include <openssl/pem.h>
+#include <openssl/x509.h>
+#include "TestTLSServer.h"
+#include "MQTTGWPacket.h"
+
+using namespace std;
+using namespace MQTTSNGW;
+
+TestTLSServer::TestTLSServer()
+{
+	strcpy(_caFile, "/tmp/testTLSServerXXXXXX");
+	_port[0] = 0;
+	_serverCtx = 0;
+	_connections = 0;
+	_secure = false;
+	_broker = false;
+	memset(_records, 0, sizeof(_records));
+	memset(_bytes, 0, sizeof(_bytes));
+}
+
+TestTLSServer::~TestTLSServer()
+{
+	if (_serverCtx)
+	{
+		SSL_CTX_free(_serverCtx);
+		unlink(_caFile);
+	}
+	_listener.close();
+}
+
+/*
+ *  Self-signed P-256 certificate for 127.0.0.1, written to _caFile for the clients to trust.
+ */
+bool TestTLSServer::createCertificate(void)
+{
+	EVP_PKEY* pkey = 0;
+	EVP_PKEY_CTX* kctx = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, 0);
+	if (kctx == 0 || EVP_PKEY_keygen_init(kctx) <= 0 ||
+		EVP_PKEY_CTX_set_ec_paramgen_curve_nid(kctx, NID_X9_62_prime256v1) <= 0 || EVP_PKEY_keygen(kctx, &pkey) <= 0)
+	{
+		EVP_PKEY_CTX_free(kctx);
+		return false;
+	}
+	EVP_PKEY_CTX_free(kctx);
+
+	X509* cert = X509_new();
+	ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+	X509_gmtime_adj(X509_getm_notBefore(cert), -60);
+	X509_gmtime_adj(X509_getm_notAfter(cert), 3600);
+	X509_set_pubkey(cert, pkey);
+	X509_NAME* name = X509_get_subject_name(cert);
+	X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char*)"127.0.0.1", -1, -1, 0);
+	X509_set_issuer_name(cert, name);
+	X509_sign(cert, pkey, EVP_sha256());
+
+	/* TLS 1.3, whose records tell their inner content type to the message callback */
+	_serverCtx = SSL_CTX_new(TLS_server_method());
+	SSL_CTX_set_min_proto_version(_serverCtx, TLS1_3_VERSION);
+	SSL_CTX_use_certificate(_serverCtx, cert);
+	SSL_CTX_use_PrivateKey(_serverCtx, pkey);
+
+	int fd = mkstemp(_caFile);
+	FILE* fp = fd < 0 ? 0 : fdopen(fd, "w");
+	bool rc = fp && PEM_write_X509(fp, cert);
+	if (fp)
+	{
+		fclose(fp);
+	}
+	X509_free(cert);
+	EVP_PKEY_free(pkey);
+	return rc;
+}
+
+bool TestTLSServer::prepare(int connections, bool secure)
+{
+	if (connections > TEST_SERVER_MAX_CONNECTIONS || (secure && _serverCtx == 0 && !createCertificate()))
+	{
+		return false;
+	}
+	if (!_listener.isValid())
+	{
+		if (!_listener.bind("0") || !_listener.listen())
+		{
+			return false;
+		}
+		struct sockaddr_in addr;
+		socklen_t len = sizeof(addr);
+		getsockname(_listener.getSock(), (struct sockaddr*)&addr, &len);
+		sprintf(_port, "%d", ntohs(addr.sin_port));
+	}
+	/* a client closing its connection while the handshake is written must not stop the tests */
+	signal(SIGPIPE, SIG_IGN);
+	_connections = connections;
+	_secure = secure;
+	memset(_records, 0, sizeof(_records));
+	memset(_bytes, 0, sizeof(_bytes));
+	return true;
+}
+
+bool TestTLSServer::start(int connections, bool secure)
+{
+	if (!prepare(connections, secure))
+	{
+		return false;
+	}
+	_broker = false;
+	return pthread_create(&_thread, 0, run, this) == 0;
+}
+
+bool TestTLSServer::startBroker(int connections, bool secure)
+{
+	if (!prepare(connections, secure))
+	{
+		return false;
+	}
+	_broker = true;
+	return pthread_create(&_thread, 0, run, this) == 0;
+}
+
+/*
+ *  Wait until all the connections have been closed by the clients.
+ */
+void TestTLSServer::stop(void)
+{
+	pthread_join(_thread, 0);
+}
+
+const char* TestTLSServer::getPort(void)
+{
+	return _port;
+}
+
+const char* TestTLSServer::getCAFile(void)
+{
+	return _caFile;
+}
+
+uint32_t TestTLSServer::getRecords(int connection)
+{
+	return _records[connection];
+}
+
+uint32_t TestTLSServer::getBytes(int connection)
+{
+	return _bytes[connection];
+}
+
+void TestTLSServer::countRecord(int writeP, int version, int contentType, const void* buf, size_t len, SSL* ssl, void* arg)
+{
+	if (!writeP && contentType == SSL3_RT_INNER_CONTENT_TYPE && len == 1 && *(const uint8_t*)buf == SSL3_RT_APPLICATION_DATA)
+	{
+		(*(uint32_t*)arg)++;
+	}
+}
+
+void* TestTLSServer::run(void* arg)
+{
+	TestTLSServer* server = (TestTLSServer*)arg;
+	uint8_t buf[512];
+
+	for (int i = 0; i < server->_connections; i++)
+	{
+		TCPStack sock;
+		if (!server->_listener.accept(sock))
+		{
+			break;
+		}
+		/* tickets and data are separate writes, do not let Nagle hold them back */
+		int on = 1;
+		setsockopt(sock.getSock(), IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+		if (server->_broker)
+		{
+			server->_socks[i].takeOver(sock);
+			server->_brokerConnections[i].server = server;
+			server->_brokerConnections[i].index = i;
+			pthread_create(&server->_workers[i], 0, serveBroker, &server->_brokerConnections[i]);
+			continue;
+		}
+
+		if (!server->_secure)
+		{
+			sock.send((const uint8_t*)"\x20", 1);
+			int r;
+			while ((r = sock.recv(buf, sizeof(buf))) > 0)
+			{
+				server->_bytes[i] += r;
+			}
+			sock.close();
+			continue;
+		}
+
+		SSL* ssl = SSL_new(server->_serverCtx);
+		SSL_set_fd(ssl, sock.getSock());
+		if (SSL_accept(ssl) == 1)
+		{
+			SSL_set_msg_callback(ssl, countRecord);
+			SSL_set_msg_callback_arg(ssl, &server->_records[i]);
+			SSL_write(ssl, "\x20", 1);
+			int r;
+			while ((r = SSL_read(ssl, buf, sizeof(buf))) > 0)
+			{
+				server->_bytes[i] += r;
+			}
+		}
+		SSL_free(ssl);
+		sock.close();
+	}
+
+	for (int i = 0; server->_broker && i < server->_connections; i++)
+	{
+		pthread_join(server->_workers[i], 0);
+	}
+	return 0;
+}
+
+/*
+ *  One connection of startBroker(), until the client closes it.
+ */
+void* TestTLSServer::serveBroker(void* arg)
+{
+	TestBrokerConnection* conn = (TestBrokerConnection*)arg;
+	TestTLSServer* server = conn->server;
+	TCPStack* sock = &server->_socks[conn->index];
+	SSL* ssl = 0;
+	uint8_t buf[512];
+	int len = 0;
+	int r;
+
+	int on = 1;
+	setsockopt(sock->getSock(), IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+	if (server->_secure)
+	{
+		ssl = SSL_new(server->_serverCtx);
+		SSL_set_fd(ssl, sock->getSock());
+		if (SSL_accept(ssl) != 1)
+		{
+			SSL_free(ssl);
+			sock->close();
+			return 0;
+		}
+	}
+
+	while ((r = ssl ? SSL_read(ssl, buf + len, sizeof(buf) - len) : sock->recv(buf + len, sizeof(buf) - len)) > 0)
+	{
+		server->_bytes[conn->index] += r;
+		len += r;
+
+		/* short packets only, one byte of remaining length */
+		while (len >= 2 && len >= buf[1] + 2)
+		{
+			if ((buf[0] >> 4) == CONNECT)
+			{
+				const uint8_t connack[] = { CONNACK << 4, 2, 0, 0 };
+				if (ssl)
+				{
+					SSL_write(ssl, connack, sizeof(connack));
+				}
+				else
+				{
+					sock->send(connack, sizeof(connack));
+				}
+			}
+			int size = buf[1] + 2;
+			memmove(buf, buf + size, len - size);
+			len -= size;
+		}
+	}
+	if (ssl)
+	{
+		SSL_free(ssl);
+	}
+	sock->close();
+	return 0;
+}
@@ -0,0 +1,81 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - TLSServer tests
+ **************************************************************************************/
+#ifndef MQTTSNGATEWAY_SRC_TESTS_TESTTLSSERVER_H_
+#define MQTTSNGATEWAY_SRC_TESTS_TESTTLSSERVER_H_
+
+#include <pthread.h>
+#include "Network.h"
+
+#define TEST_SERVER_MAX_CONNECTIONS  256
+
+namespace MQTTSNGW
+{
+class TestTLSServer;
+
+/* A connection served by its own thread, see startBroker() */
+typedef struct
+{
+	TestTLSServer* server;
+	int index;
+} TestBrokerConnection;
+
+/*
+ *  In-process stand-in for the broker, with a self-signed certificate for 127.0.0.1.
+ *  For each of a given number of connections it completes the TLS handshake, which sends
+ *  the session tickets, writes one byte and reads until the client closes, counting
+ *  the bytes and the application data records it receives.
+ *  Started with startBroker(), it serves the connections at the same time instead and
+ *  answers each MQTT CONNECT with a CONNACK.
+ */
+class TestTLSServer
+{
+public:
+	TestTLSServer();
+	~TestTLSServer();
+	bool start(int connections, bool secure);
+	bool startBroker(int connections, bool secure);
+	void stop(void);
+	const char* getPort(void);
+	const char* getCAFile(void);
+	uint32_t getRecords(int connection);
+	uint32_t getBytes(int connection);
+
+	static void* run(void* arg);
+	static void* serveBroker(void* arg);
+	static void countRecord(int writeP, int version, int contentType, const void* buf, size_t len, SSL* ssl, void* arg);
+
+private:
+	bool createCertificate(void);
+	bool prepare(int connections, bool secure);
+
+	char _caFile[64];
+	char _port[8];
+	SSL_CTX* _serverCtx;
+	TCPStack _listener;
+	pthread_t _thread;
+	int _connections;
+	bool _secure;
+	bool _broker;
+	TCPStack _socks[TEST_SERVER_MAX_CONNECTIONS];
+	TestBrokerConnection _brokerConnections[TEST_SERVER_MAX_CONNECTIONS];
+	pthread_t _workers[TEST_SERVER_MAX_CONNECTIONS];
+	uint32_t _records[TEST_SERVER_MAX_CONNECTIONS];
+	uint32_t _bytes[TEST_SERVER_MAX_CONNECTIONS];
+};
+
+}
+
+#endif /* MQTTSNGATEWAY_SRC_TESTS_TESTTLSSERVER_H_ */
@@ -0,0 +1,100 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - TLSSessionCache tests
+ **************************************************************************************/
+#include <stdio.h>
+#include <time.h>
+#include <cassert>
+#include "TestTLSSessionCache.h"
+
+using namespace std;
+using namespace MQTTSNGW;
+
+#define TLS_TEST_CONNECTIONS  100
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+TestTLSSessionCache::TestTLSSessionCache()
+{
+}
+
+TestTLSSessionCache::~TestTLSSessionCache()
+{
+}
+
+/*
+ *  @return handshakes/sec
+ */
+double TestTLSSessionCache::connectClients(int count, bool resume)
+{
+	TLSSessionCache* cache = Network::getSessionCache();
+	string endpoint = string("127.0.0.1:") + _server.getPort();
+	uint8_t buf[1];
+
+	double start = now();
+	for (int i = 0; i < count; i++)
+	{
+		if (!resume)
+		{
+			cache->removeSession(endpoint.c_str());
+		}
+		Network network(true);
+		assert(network.connect("127.0.0.1", _server.getPort(), 0, _server.getCAFile(), 0, 0));
+		assert(network.recv(buf, 1) == 1);
+		network.close();
+	}
+	return count / (now() - start);
+}
+
+void TestTLSSessionCache::test(void)
+{
+	TLSSessionCache* cache = Network::getSessionCache();
+
+	assert(_server.start(TLS_TEST_CONNECTIONS * 2, true));
+
+	uint32_t full = cache->getFullHandshakes();
+	uint32_t resumed = cache->getResumedHandshakes();
+	double fullRate = connectClients(TLS_TEST_CONNECTIONS, false);
+	assert(cache->getFullHandshakes() - full == TLS_TEST_CONNECTIONS);
+	assert(cache->getResumedHandshakes() == resumed);
+
+	double resumedRate = connectClients(TLS_TEST_CONNECTIONS, true);
+	assert(cache->getResumedHandshakes() - resumed == TLS_TEST_CONNECTIONS);
+
+	_server.stop();
+	cache->removeSession((string("127.0.0.1:") + _server.getPort()).c_str());
+
+	/* a context dropped from the full cache stays valid for a thread that got it */
+	SSL_CTX* ctx = cache->putContext("evicted:8883", SSL_CTX_new(TLS_client_method()));
+	for (int i = 0; i < TLS_SESSION_CACHE_SIZE; i++)
+	{
+		char endpoint[32];
+		snprintf(endpoint, sizeof(endpoint), "filler:%d", i);
+		SSL_CTX_free(cache->putContext(endpoint, SSL_CTX_new(TLS_client_method())));
+	}
+	assert(cache->getContext("evicted:8883") == 0);
+	SSL* ssl = SSL_new(ctx);
+	assert(ssl);
+	SSL_free(ssl);
+	SSL_CTX_free(ctx);
+
+	printf("[ OK ]\n");
+	printf("      %d connections: %.0f handshakes/sec full, %.0f handshakes/sec resumed\n",
+			TLS_TEST_CONNECTIONS, fullRate, resumedRate);
+}
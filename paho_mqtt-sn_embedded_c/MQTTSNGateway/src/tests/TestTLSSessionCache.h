@@ -0,0 +1,44 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - TLSSessionCache tests
+ **************************************************************************************/
+#ifndef MQTTSNGATEWAY_SRC_TESTS_TESTTLSSESSIONCACHE_H_
+#define MQTTSNGATEWAY_SRC_TESTS_TESTTLSSESSIONCACHE_H_
+
+#include "TestTLSServer.h"
+
+namespace MQTTSNGW
+{
+
+/*
+ *  Connects secure Networks to an in-process TLS server standing in for the broker,
+ *  first making a full handshake every time, then resuming the cached session,
+ *  and reports the handshakes/sec of both.
+ */
+class TestTLSSessionCache
+{
+public:
+	TestTLSSessionCache();
+	~TestTLSSessionCache();
+	void test(void);
+
+private:
+	double connectClients(int count, bool resume);
+
+	TestTLSServer _server;
+};
+
+}
+
+#endif /* MQTTSNGATEWAY_SRC_TESTS_TESTTLSSESSIONCACHE_H_ */
@@ -0,0 +1,199 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - TopicNames tests
+ **************************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <malloc.h>
+#include <string>
+#include <cassert>
+#include "TestTopicNames.h"
+
+using namespace std;
+using namespace MQTTSNGW;
+
+#define LOOKUP_CLIENTS   1000
+
+static double elapsedSec(struct timespec* start)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/* The Topic list as it was before the names were interned */
+typedef struct LegacyTopic
+{
+	MQTTSN_topicTypes type;
+	uint16_t topicId;
+	string* topicName;
+	struct LegacyTopic* next;
+} LegacyTopic;
+
+TestTopicNames::TestTopicNames()
+{
+
+}
+
+TestTopicNames::~TestTopicNames()
+{
+
+}
+
+void TestTopicNames::setTopicName(char* buf, int client, int topic)
+{
+	int group = client % TEST_TOPICNAME_GROUPS;
+	sprintf(buf, "building/%d/floor/%d/sensor/%02d/temperature", group / 10, group % 10, topic);
+}
+
+size_t TestTopicNames::heapUsed(void)
+{
+	return mallinfo2().uordblks;
+}
+
+void TestTopicNames::test(void)
+{
+	char buf[64];
+	MQTTSN_topicid topicid;
+	TopicNameTable* names = TopicNameTable::getTable();
+	uint32_t namesBefore = names->getCount();
+
+	/* one name, one handle, released with its last reference */
+	Topics* a = new Topics();
+	Topics* b = new Topics();
+	Topic* ta = a->add("interned/name");
+	Topic* tb = b->add("interned/name", 7);
+	assert(ta->getTopicName() == tb->getTopicName());
+	assert(names->getCount() == namesBefore + 1);
+	assert(tb->getType() == MQTTSN_TOPIC_TYPE_PREDEFINED && tb->getTopicId() == 7);
+	a->eraseNormal();
+	assert(a->getCount() == 0);
+	topicid.data.long_.name = (char*)"interned/name";
+	topicid.data.long_.len = strlen(topicid.data.long_.name);
+	assert(a->getTopicByName(&topicid) == nullptr);
+	assert(b->getTopicByName(&topicid) == tb);
+	b->eraseNormal();
+	assert(b->getTopicByName(&topicid) == tb);
+	delete b;
+	assert(names->getCount() == namesBefore);
+	assert(names->find(topicid.data.long_.name, topicid.data.long_.len) == 0);
+
+	/* an erased slot is reused, the other Topics stay where they are */
+	ta = a->add("slot/0", 1);
+	tb = a->add("slot/1");
+	Topic* tc = a->add("slot/2", 2);
+	a->eraseNormal();
+	assert(a->getCount() == 2);
+	assert(a->add("slot/3") == tb);
+	topicid.data.long_.name = (char*)"slot/2";
+	topicid.data.long_.len = strlen(topicid.data.long_.name);
+	assert(a->getTopicByName(&topicid) == tc);
+	delete a;
+
+	/* before */
+	size_t heap = heapUsed();
+	LegacyTopic** legacy = new LegacyTopic*[TEST_TOPICNAME_CLIENTS]();
+	for ( int i = 0; i < TEST_TOPICNAME_CLIENTS; i++ )
+	{
+		LegacyTopic** tail = &legacy[i];
+		for ( int j = 0; j < MAX_TOPIC_PAR_CLIENT; j++ )
+		{
+			setTopicName(buf, i, j);
+			LegacyTopic* t = new LegacyTopic;
+			t->type = MQTTSN_TOPIC_TYPE_NORMAL;
+			t->topicId = j + 1;
+			t->topicName = new string(buf);
+			t->next = nullptr;
+			*tail = t;
+			tail = &t->next;
+		}
+	}
+	size_t before = heapUsed() - heap;
+
+	struct timespec start;
+	int lookups = 0;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for ( int i = 0; i < LOOKUP_CLIENTS; i++ )
+	{
+		for ( int j = 0; j < MAX_TOPIC_PAR_CLIENT; j++ )
+		{
+			setTopicName(buf, i, j);
+			string sname = string(buf);
+			LegacyTopic* t = legacy[i];
+			while ( t && t->topicName->compare(sname) != 0 )
+			{
+				t = t->next;
+			}
+			assert(t && t->topicId == j + 1);
+			lookups++;
+		}
+	}
+	double legacyLookup = elapsedSec(&start);
+
+	for ( int i = 0; i < TEST_TOPICNAME_CLIENTS; i++ )
+	{
+		for ( LegacyTopic* t = legacy[i]; t; )
+		{
+			LegacyTopic* next = t->next;
+			delete t->topicName;
+			delete t;
+			t = next;
+		}
+	}
+	delete[] legacy;
+
+	/* after */
+	heap = heapUsed();
+	Topics** topics = new Topics*[TEST_TOPICNAME_CLIENTS];
+	for ( int i = 0; i < TEST_TOPICNAME_CLIENTS; i++ )
+	{
+		topics[i] = new Topics();
+		for ( int j = 0; j < MAX_TOPIC_PAR_CLIENT; j++ )
+		{
+			setTopicName(buf, i, j);
+			assert(topics[i]->add(buf)->getTopicId() == j + 1);
+		}
+	}
+	size_t after = heapUsed() - heap;
+	assert(names->getCount() == namesBefore + TEST_TOPICNAME_GROUPS * MAX_TOPIC_PAR_CLIENT);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for ( int i = 0; i < LOOKUP_CLIENTS; i++ )
+	{
+		for ( int j = 0; j < MAX_TOPIC_PAR_CLIENT; j++ )
+		{
+			setTopicName(buf, i, j);
+			topicid.data.long_.name = buf;
+			topicid.data.long_.len = strlen(buf);
+			Topic* t = topics[i]->getTopicByName(&topicid);
+			assert(t && t->getTopicId() == j + 1);
+		}
+	}
+	double internedLookup = elapsedSec(&start);
+
+	for ( int i = 0; i < TEST_TOPICNAME_CLIENTS; i++ )
+	{
+		delete topics[i];
+	}
+	delete[] topics;
+	assert(names->getCount() == namesBefore);
+
+	printf("[ OK ]\n");
+	printf("      %d clients x %d topics: %zu bytes before, %zu bytes interned (%zu/%zu bytes per client)\n",
+			TEST_TOPICNAME_CLIENTS, MAX_TOPIC_PAR_CLIENT, before, after,
+			before / TEST_TOPICNAME_CLIENTS, after / TEST_TOPICNAME_CLIENTS);
+	printf("      getTopicByName: %.0f lookups/sec before, %.0f lookups/sec interned\n",
+			lookups / legacyLookup, lookups / internedLookup);
+}
@@ -0,0 +1,43 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - TopicNames tests
+ **************************************************************************************/
+#ifndef MQTTSNGATEWAY_SRC_TESTS_TESTTOPICNAMES_H_
+#define MQTTSNGATEWAY_SRC_TESTS_TESTTOPICNAMES_H_
+
+#include "MQTTSNGWTopic.h"
+
+#define TEST_TOPICNAME_CLIENTS   10000
+#define TEST_TOPICNAME_GROUPS      100   // clients of a group subscribe to the same names
+
+using namespace MQTTSNGW;
+
+/*
+ *  Registers MAX_TOPIC_PAR_CLIENT topics for each of TEST_TOPICNAME_CLIENTS clients
+ *  and compares the heap used with the Topic list the gateway used to keep,
+ *  a Topic and a string of its own for each topic of each client.
+ */
+class TestTopicNames
+{
+public:
+	TestTopicNames();
+	~TestTopicNames();
+	void test(void);
+
+private:
+	void setTopicName(char* buf, int client, int topic);
+	size_t heapUsed(void);
+};
+
+#endif /* MQTTSNGATEWAY_SRC_TESTS_TESTTOPICNAMES_H_ */
@@ -0,0 +1,341 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - XBee tests
+ **************************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/resource.h>
+#include <cassert>
+#include "TestXBee.h"
+
+using namespace std;
+using namespace MQTTSNGW;
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double threadCpu(void)
+{
+	struct rusage usage;
+	getrusage(RUSAGE_THREAD, &usage);
+	return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+TestXBee::TestXBee()
+{
+	_master = -1;
+	_slaveName[0] = 0;
+	_stop = false;
+	_corrupted = 0;
+}
+
+TestXBee::~TestXBee()
+{
+	if ( _master >= 0 )
+	{
+		close(_master);
+	}
+}
+
+int TestXBee::open(void)
+{
+	if ( (_master = posix_openpt(O_RDWR | O_NOCTTY)) < 0 || grantpt(_master) != 0 || unlockpt(_master) != 0 )
+	{
+		return -1;
+	}
+	strncpy(_slaveName, ptsname(_master), sizeof(_slaveName) - 1);
+	_network.setApiMode(2);
+	return _network.XBee::open(_slaveName, 115200);
+}
+
+void TestXBee::appendFrame(const uint8_t* data, int len, bool corrupt)
+{
+	uint8_t checksum = 0;
+	uint8_t header[2] = { (uint8_t)(len >> 8), (uint8_t)len };
+
+	_stream.push_back(START_BYTE);
+	for ( int i = 0; i < len + 3; i++ )
+	{
+		uint8_t c;
+		if ( i < 2 )
+		{
+			c = header[i];
+		}
+		else if ( i < len + 2 )
+		{
+			c = data[i - 2];
+			checksum += c;
+		}
+		else
+		{
+			c = 0xff - checksum + (corrupt ? 1 : 0);
+		}
+		if ( c == START_BYTE || c == ESCAPE || c == XON || c == XOFF )
+		{
+			_stream.push_back(ESCAPE);
+			c ^= 0x20;
+		}
+		_stream.push_back(c);
+	}
+}
+
+/*
+ *  API_RESPONSE frames with random payloads from a few radios, one in 50 frames with a bad checksum
+ *  and a few bytes of line noise between some frames.
+ */
+void TestXBee::generate(int frames, const char* recordFile)
+{
+	uint8_t data[12 + 80];
+
+	srand(1);
+	for ( int i = 0; i < frames; i++ )
+	{
+		int payloadLen = 8 + rand() % 72;
+		data[0] = API_RESPONSE;
+		for ( int j = 1; j < 9; j++ )
+		{
+			data[j] = (j < 7) ? 0x13 : (uint8_t)(i % 24);  // address64, some bytes need escaping
+		}
+		data[9] = 0x7e;
+		data[10] = (uint8_t)(i % 24);
+		data[11] = 0x01;
+		for ( int j = 0; j < payloadLen; j++ )
+		{
+			data[12 + j] = (uint8_t)rand();
+		}
+		bool corrupt = (i % 50 == 25 && i < frames - 1);
+		appendFrame(data, 12 + payloadLen, corrupt);
+		if ( corrupt )
+		{
+			_corrupted++;
+		}
+		else
+		{
+			_expected.push_back(vector<uint8_t>(data + 12, data + 12 + payloadLen));
+		}
+		if ( i % 97 == 0 )
+		{
+			_stream.push_back(0x55);
+			_stream.push_back(0x00);
+		}
+	}
+
+	if ( recordFile )
+	{
+		FILE* fp = fopen(recordFile, "wb");
+		if ( fp )
+		{
+			fwrite(&_stream[0], 1, _stream.size(), fp);
+			fclose(fp);
+		}
+	}
+}
+
+int TestXBee::load(const char* replayFile)
+{
+	FILE* fp = fopen(replayFile, "rb");
+	uint8_t buf[4096];
+	size_t len;
+
+	if ( fp == 0 )
+	{
+		return -1;
+	}
+	while ( (len = fread(buf, 1, sizeof(buf), fp)) > 0 )
+	{
+		_stream.insert(_stream.end(), buf, buf + len);
+	}
+	fclose(fp);
+	return 0;
+}
+
+/*
+ *  Writes the stream to the radio side in pieces of different sizes, as bytes arrive from a serial line.
+ */
+void* TestXBee::writer(void* arg)
+{
+	TestXBee* test = (TestXBee*)arg;
+	size_t pos = 0;
+	int chunk = 0;
+
+	while ( pos < test->_stream.size() )
+	{
+		size_t len = 16 + (chunk++ * 37) % 500;
+		if ( len > test->_stream.size() - pos )
+		{
+			len = test->_stream.size() - pos;
+		}
+		int rc = write(test->_master, &test->_stream[pos], len);
+		if ( rc <= 0 )
+		{
+			break;
+		}
+		pos += rc;
+	}
+	return 0;
+}
+
+void TestXBee::testRecv(void)
+{
+	pthread_t thread;
+	uint8_t buf[XBEE_MAX_FRAME];
+	size_t frames = 0;
+	uint32_t reads = _network.getSerialPort()->getReadCount();
+
+	double start = now();
+	double last = start;
+	double cpu = threadCpu();
+	pthread_create(&thread, 0, writer, this);
+	while ( _expected.size() == 0 || frames < _expected.size() )
+	{
+		int len = _network.read(buf, sizeof(buf));
+		if ( len == 0 )
+		{
+			break;  // nothing for 500ms, the stream is over
+		}
+		if ( _expected.size() )
+		{
+			assert(len == (int)_expected[frames].size());
+			assert(memcmp(buf, &_expected[frames][0], len) == 0);
+		}
+		frames++;
+		last = now();
+	}
+	double elapsed = last - start;
+	cpu = threadCpu() - cpu;
+	pthread_join(thread, 0);
+	reads = _network.getSerialPort()->getReadCount() - reads;
+
+	if ( _expected.size() )
+	{
+		assert(frames == _expected.size());
+		assert(_network.getChecksumErrorCount() == _corrupted);
+	}
+	printf("\n    %zu frames, %zu bytes, %u checksum errors\n", frames, _stream.size(), _network.getChecksumErrorCount());
+	printf("    %.0f frames/sec, receive CPU %.1f ms (%.2f us/frame), %u reads of %.1f bytes\n",
+			elapsed > 0 ? frames / elapsed : 0.0, cpu * 1000, frames ? cpu * 1e6 / frames : 0.0, reads, reads ? (double)_stream.size() / reads : 0.0);
+}
+
+/*
+ *  Answers every transmit request with a successful transmit status, checking that each frame
+ *  arrives whole and correctly escaped.
+ */
+void* TestXBee::radio(void* arg)
+{
+	TestXBee* test = (TestXBee*)arg;
+	uint8_t buf[1024];
+	vector<uint8_t> line;
+
+	while ( !test->_stop )
+	{
+		int len = read(test->_master, buf, sizeof(buf));
+		if ( len <= 0 )
+		{
+			break;
+		}
+		line.insert(line.end(), buf, buf + len);
+
+		/* unescape one complete frame at a time */
+		while ( line.size() > 0 )
+		{
+			assert(line[0] == START_BYTE);
+			vector<uint8_t> frame;
+			size_t pos = 1;
+			bool escaped = false;
+			for ( ; pos < line.size() && line[pos] != START_BYTE; pos++ )
+			{
+				if ( line[pos] == ESCAPE )
+				{
+					escaped = true;
+					continue;
+				}
+				frame.push_back(escaped ? line[pos] ^ 0x20 : line[pos]);
+				escaped = false;
+			}
+			if ( frame.size() < 3 || frame.size() < (size_t)((frame[0] << 8) + frame[1] + 3) )
+			{
+				break;  // incomplete
+			}
+			int dataLen = (frame[0] << 8) + frame[1];
+			uint8_t checksum = 0;
+			for ( int i = 0; i < dataLen + 1; i++ )
+			{
+				checksum += frame[2 + i];
+			}
+			assert(checksum == 0xff);
+			assert(frame[2] == API_XMITREQUEST);
+			line.erase(line.begin(), line.begin() + pos);
+
+			uint8_t status[] = { API_XMITSTATUS, frame[3], 0xff, 0xfe, 0x00, 0x00, 0x00 };
+			test->_stream.clear();
+			test->appendFrame(status, sizeof(status), false);
+			assert(write(test->_master, &test->_stream[0], test->_stream.size()) == (int)test->_stream.size());
+		}
+	}
+	return 0;
+}
+
+void* TestXBee::receiver(void* arg)
+{
+	TestXBee* test = (TestXBee*)arg;
+	uint8_t buf[XBEE_MAX_FRAME];
+
+	while ( !test->_stop )
+	{
+		test->_network.read(buf, sizeof(buf));
+	}
+	return 0;
+}
+
+void TestXBee::testSend(int frames)
+{
+	pthread_t radioThread, recvThread;
+	uint8_t payload[100];
+	SensorNetAddress addr;
+	uint8_t addr64[8] = { 0x00, 0x13, 0xa2, 0x00, 0x7d, 0x11, 0x7e, 0x13 };
+	uint8_t addr16[2] = { 0xff, 0xfe };
+	uint32_t writes = _network.getSerialPort()->getWriteCount();
+
+	addr.setAddress(addr64, addr16);
+	for ( size_t i = 0; i < sizeof(payload); i++ )
+	{
+		payload[i] = (uint8_t)(0x7d + i % 4);  // every byte around the escaped values
+	}
+
+	_stop = false;
+	pthread_create(&radioThread, 0, radio, this);
+	pthread_create(&recvThread, 0, receiver, this);
+	double start = now();
+	for ( int i = 0; i < frames; i++ )
+	{
+		assert(_network.unicast(payload, 1 + i % sizeof(payload), &addr) == 1 + i % (int)sizeof(payload));
+	}
+	double elapsed = now() - start;
+	_stop = true;
+	writes = _network.getSerialPort()->getWriteCount() - writes;
+	assert(writes == (uint32_t)frames);
+	printf("    %d frames sent in %u writes, %.0f frames/sec acknowledged\n", frames, writes, frames / elapsed);
+	pthread_cancel(radioThread);
+	pthread_join(radioThread, 0);
+	pthread_join(recvThread, 0);
+}
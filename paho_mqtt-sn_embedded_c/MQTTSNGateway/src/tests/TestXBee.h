@@ -0,0 +1,59 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - XBee tests
+ **************************************************************************************/
+#ifndef MQTTSNGATEWAY_SRC_TESTS_TESTXBEE_H_
+#define MQTTSNGATEWAY_SRC_TESTS_TESTXBEE_H_
+
+#include <vector>
+#include "SensorNetwork.h"
+
+namespace MQTTSNGW
+{
+
+/*
+ *  Drives the XBee SensorNetwork through a pseudo terminal standing in for the radio.
+ *  A stream of API frames, generated or recorded, is written to the master side while
+ *  the SensorNetwork reads the slave side, reporting frames/sec and CPU time.
+ */
+class TestXBee
+{
+public:
+	TestXBee();
+	~TestXBee();
+	int open(void);
+	void generate(int frames, const char* recordFile);
+	int load(const char* replayFile);
+	void testRecv(void);
+	void testSend(int frames);
+
+	static void* writer(void* arg);
+	static void* radio(void* arg);
+	static void* receiver(void* arg);
+
+private:
+	void appendFrame(const uint8_t* data, int len, bool corrupt);
+
+	int _master;
+	char _slaveName[64];
+	SensorNetwork _network;
+	std::vector<uint8_t> _stream;
+	std::vector<std::vector<uint8_t> > _expected;  // payloads of the valid frames in _stream, empty for a replay
+	uint32_t _corrupted;
+	volatile bool _stop;
+};
+
+}
+
+#endif /* MQTTSNGATEWAY_SRC_TESTS_TESTXBEE_H_ */
@@ -0,0 +1,63 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - gateway benchmark
+ **************************************************************************************/
+#include <stdio.h>
+#include "MQTTSNGateway.h"
+#include "MQTTSNGWBrokerRecvTask.h"
+#include "MQTTSNGWBrokerSendTask.h"
+#include "MQTTSNGWClientRecvTask.h"
+#include "MQTTSNGWClientSendTask.h"
+#include "MQTTSNGWPacketHandleTask.h"
+#include "MQTTSNGWBrokerPoolTask.h"
+#include "TestGatewayBench.h"
+
+using namespace MQTTSNGW;
+
+/*
+ *  testGatewayBench -f gateway.conf
+ *    The whole gateway with the loopback SensorNetwork, the broker's connections
+ *    are made to a BenchBroker in this process. The results are written to stderr,
+ *    the gateway's log to stdout as usual.
+ */
+Gateway gateway;
+PacketHandleTask  task1(&gateway);
+ClientRecvTask    task2(&gateway);
+ClientSendTask    task3(&gateway);
+BrokerRecvTask    task4(&gateway);
+BrokerSendTask    task5(&gateway);
+BrokerPoolTask    task6(&gateway);
+BenchBroker broker;
+TestGatewayBench bench(&gateway, &broker);
+
+int main(int argc, char** argv)
+{
+	if (!broker.open())
+	{
+		fprintf(stderr, "Can't start the broker.\n");
+		return 1;
+	}
+	TCPStack::setLoopback(&broker);
+
+	gateway.initialize(argc, argv);
+	gateway.run();
+	broker.close();
+
+	if (!bench.isPassed())
+	{
+		return 1;
+	}
+	fprintf(stderr, "\nPass all tests. \n");
+	return 0;
+}
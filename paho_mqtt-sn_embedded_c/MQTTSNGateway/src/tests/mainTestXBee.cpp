@@ -0,0 +1,81 @@
+/**************************************************************************************
+ * Copyright (c) 2026, agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - XBee tests
+ **************************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "TestXBee.h"
+
+using namespace MQTTSNGW;
+
+/*
+ *  testXBee [-n frames] [-r replayFile] [-w recordFile]
+ *    -n  number of API frames to generate, default 20000
+ *    -r  replay a recorded serial stream instead of generated frames
+ *    -w  record the generated stream to a file
+ */
+int main(int argc, char** argv)
+{
+	int frames = 20000;
+	const char* replayFile = 0;
+	const char* recordFile = 0;
+
+	for ( int i = 1; i + 1 < argc; i += 2 )
+	{
+		if ( strcmp(argv[i], "-n") == 0 )
+		{
+			frames = atoi(argv[i + 1]);
+		}
+		else if ( strcmp(argv[i], "-r") == 0 )
+		{
+			replayFile = argv[i + 1];
+		}
+		else if ( strcmp(argv[i], "-w") == 0 )
+		{
+			recordFile = argv[i + 1];
+		}
+	}
+
+	TestXBee* test = new TestXBee();
+	if ( test->open() != 0 )
+	{
+		printf("Can't open a pseudo terminal.\n");
+		return 1;
+	}
+
+	printf("Test  XBee recv      ");
+	if ( replayFile )
+	{
+		if ( test->load(replayFile) != 0 )
+		{
+			printf("Can't read %s\n", replayFile);
+			return 1;
+		}
+	}
+	else
+	{
+		test->generate(frames, recordFile);
+	}
+	test->testRecv();
+	printf("                     [ OK ]\n");
+
+	printf("Test  XBee send      \n");
+	test->testSend(1000);
+	printf("                     [ OK ]\n");
+
+	delete test;
+	printf("\nPass all tests. \n");
+	return 0;
+}
@@ -142,12 +142,38 @@ void FreeRTOS_disconnect(Network* n)
 }
 
 
+#if defined(MQTT_ASYNC)
+/* wait until the socket is readable, the timeout expires or FreeRTOS_wake is called.  Returns 1 if readable */
+int FreeRTOS_wait(Network* n, int timeout_ms)
+{
+	BaseType_t rc;
+
+	FreeRTOS_FD_SET(n->my_socket, n->socket_set, eSELECT_READ | eSELECT_INTR);
+	rc = FreeRTOS_select(n->socket_set, timeout_ms / portTICK_PERIOD_MS);
+	if (rc <= 0)
+		return rc;
+	return (FreeRTOS_FD_ISSET(n->my_socket, n->socket_set) & eSELECT_READ) ? 1 : 0;
+}
+
+
+void FreeRTOS_wake(Network* n)
+{
+	FreeRTOS_SignalSocket(n->my_socket);
+}
+#endif
+
+
 void NetworkInit(Network* n)
 {
 	n->my_socket = 0;
 	n->mqttread = FreeRTOS_read;
 	n->mqttwrite = FreeRTOS_write;
 	n->disconnect = FreeRTOS_disconnect;
+#if defined(MQTT_ASYNC)
+	n->mqttwait = FreeRTOS_wait;
+	n->mqttwake = FreeRTOS_wake;
+	n->socket_set = FreeRTOS_CreateSocketSet();
+#endif
 }
 
 
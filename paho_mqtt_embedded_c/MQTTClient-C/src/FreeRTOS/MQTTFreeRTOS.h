@@ -37,6 +37,11 @@ struct Network
 	int (*mqttread) (Network*, unsigned char*, int, int);
 	int (*mqttwrite) (Network*, unsigned char*, int, int);
 	void (*disconnect) (Network*);
+#if defined(MQTT_ASYNC)
+	int (*mqttwait) (Network*, int);
+	void (*mqttwake) (Network*);
+	SocketSet_t socket_set;
+#endif
 };
 
 void TimerInit(Timer*);
@@ -64,6 +69,11 @@ int ThreadStart(Thread*, void (*fn)(void*), void* arg);
 int FreeRTOS_read(Network*, unsigned char*, int, int);
 int FreeRTOS_write(Network*, unsigned char*, int, int);
 void FreeRTOS_disconnect(Network*);
+#if defined(MQTT_ASYNC)
+/* needs ipconfigSUPPORT_SELECT_FUNCTION and ipconfigSUPPORT_SIGNALS */
+int FreeRTOS_wait(Network*, int);
+void FreeRTOS_wake(Network*);
+#endif
 
 void NetworkInit(Network*);
 int NetworkConnect(Network*, char*, int);
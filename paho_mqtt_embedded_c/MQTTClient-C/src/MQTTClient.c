@@ -77,6 +77,12 @@ void MQTTClientInit(MQTTClient* c, Network* network, unsigned int command_timeou
 #if defined(MQTT_TASK)
 	  MutexInit(&c->mutex);
 #endif
+#if defined(MQTT_ASYNC)
+    for (i = 0; i < MQTT_COMMAND_QUEUE_SIZE; ++i)
+        c->commands[i].sequence = i;
+    c->command_head = c->command_tail = 0;
+    c->task_waiting = 0;
+#endif
 }
 
 
@@ -363,6 +369,11 @@ int MQTTIsConnected(MQTTClient* client)
   return client->isconnected;
 }
 
+#if defined(MQTT_ASYNC)
+static int commandWaiting(MQTTClient* c);
+static void runCommands(MQTTClient* c);
+#endif
+
 void MQTTRun(void* parm)
 {
 	Timer timer;
@@ -372,6 +383,22 @@ void MQTTRun(void* parm)
 
 	while (1)
 	{
+#if defined(MQTT_ASYNC)
+		/* only this task touches the network, application threads just queue commands and wake it */
+		int readable = 0;
+
+		runCommands(c);
+		__atomic_store_n(&c->task_waiting, 1, __ATOMIC_SEQ_CST);
+		readable = c->ipstack->mqttwait(c->ipstack, commandWaiting(c) ? 0 : 500);
+		__atomic_store_n(&c->task_waiting, 0, __ATOMIC_SEQ_CST);
+		if (readable > 0)
+		{
+			TimerCountdownMS(&timer, 500);
+			cycle(c, &timer);
+		}
+		else if (c->isconnected && keepalive(c) != SUCCESS)
+			MQTTCloseSession(c);
+#else
 #if defined(MQTT_TASK)
 		MutexLock(&c->mutex);
 #endif
@@ -379,6 +406,7 @@ void MQTTRun(void* parm)
 		cycle(c, &timer);
 #if defined(MQTT_TASK)
 		MutexUnlock(&c->mutex);
+#endif
 #endif
 	}
 }
@@ -514,7 +542,7 @@ int MQTTSetMessageHandler(MQTTClient* c, const char* topicFilter, messageHandler
 }
 
 
-int MQTTSubscribeWithResults(MQTTClient* c, const char* topicFilter, enum QoS qos,
+static int subscribe(MQTTClient* c, const char* topicFilter, enum QoS qos,
        messageHandler messageHandler, MQTTSubackData* data)
 {
     int rc = FAILURE;
@@ -523,9 +551,6 @@ int MQTTSubscribeWithResults(MQTTClient* c, const char* topicFilter, enum QoS qo
     MQTTString topic = MQTTString_initializer;
     topic.cstring = (char *)topicFilter;
 
-#if defined(MQTT_TASK)
-	  MutexLock(&c->mutex);
-#endif
 	  if (!c->isconnected)
 		    goto exit;
 
@@ -555,6 +580,19 @@ int MQTTSubscribeWithResults(MQTTClient* c, const char* topicFilter, enum QoS qo
 exit:
     if (rc == FAILURE)
         MQTTCloseSession(c);
+    return rc;
+}
+
+
+int MQTTSubscribeWithResults(MQTTClient* c, const char* topicFilter, enum QoS qos,
+       messageHandler messageHandler, MQTTSubackData* data)
+{
+    int rc = FAILURE;
+
+#if defined(MQTT_TASK)
+	  MutexLock(&c->mutex);
+#endif
+    rc = subscribe(c, topicFilter, qos, messageHandler, data);
 #if defined(MQTT_TASK)
 	  MutexUnlock(&c->mutex);
 #endif
@@ -570,7 +608,7 @@ int MQTTSubscribe(MQTTClient* c, const char* topicFilter, enum QoS qos,
 }
 
 
-int MQTTUnsubscribe(MQTTClient* c, const char* topicFilter)
+static int unsubscribe(MQTTClient* c, const char* topicFilter)
 {
     int rc = FAILURE;
     Timer timer;
@@ -578,9 +616,6 @@ int MQTTUnsubscribe(MQTTClient* c, const char* topicFilter)
     topic.cstring = (char *)topicFilter;
     int len = 0;
 
-#if defined(MQTT_TASK)
-	  MutexLock(&c->mutex);
-#endif
 	  if (!c->isconnected)
 		  goto exit;
 
@@ -607,6 +642,18 @@ int MQTTUnsubscribe(MQTTClient* c, const char* topicFilter)
 exit:
     if (rc == FAILURE)
         MQTTCloseSession(c);
+    return rc;
+}
+
+
+int MQTTUnsubscribe(MQTTClient* c, const char* topicFilter)
+{
+    int rc = FAILURE;
+
+#if defined(MQTT_TASK)
+	  MutexLock(&c->mutex);
+#endif
+    rc = unsubscribe(c, topicFilter);
 #if defined(MQTT_TASK)
 	  MutexUnlock(&c->mutex);
 #endif
@@ -614,7 +661,7 @@ exit:
 }
 
 
-int MQTTPublish(MQTTClient* c, const char* topicName, MQTTMessage* message)
+static int publish(MQTTClient* c, const char* topicName, MQTTMessage* message)
 {
     int rc = FAILURE;
     Timer timer;
@@ -622,9 +669,6 @@ int MQTTPublish(MQTTClient* c, const char* topicName, MQTTMessage* message)
     topic.cstring = (char *)topicName;
     int len = 0;
 
-#if defined(MQTT_TASK)
-	  MutexLock(&c->mutex);
-#endif
 	  if (!c->isconnected)
 		    goto exit;
 
@@ -669,6 +713,18 @@ int MQTTPublish(MQTTClient* c, const char* topicName, MQTTMessage* message)
 exit:
     if (rc == FAILURE)
         MQTTCloseSession(c);
+    return rc;
+}
+
+
+int MQTTPublish(MQTTClient* c, const char* topicName, MQTTMessage* message)
+{
+    int rc = FAILURE;
+
+#if defined(MQTT_TASK)
+	  MutexLock(&c->mutex);
+#endif
+    rc = publish(c, topicName, message);
 #if defined(MQTT_TASK)
 	  MutexUnlock(&c->mutex);
 #endif
@@ -698,3 +754,134 @@ int MQTTDisconnect(MQTTClient* c)
 #endif
     return rc;
 }
+
+
+#if defined(MQTT_ASYNC)
+#if (MQTT_COMMAND_QUEUE_SIZE & (MQTT_COMMAND_QUEUE_SIZE - 1)) != 0
+#error MQTT_COMMAND_QUEUE_SIZE must be a power of 2
+#endif
+
+/* Bounded queue after D. Vyukov: a producer claims a slot by advancing command_head with compare and swap,
+ * fills it in and publishes it by setting its sequence.  Only the client task advances command_tail.
+ */
+static int enqueueCommand(MQTTClient* c, MQTTCommand* command)
+{
+    unsigned int pos = __atomic_load_n(&c->command_head, __ATOMIC_RELAXED);
+    MQTTCommand* slot;
+
+    while (1)
+    {
+        int diff;
+
+        slot = &c->commands[pos & (MQTT_COMMAND_QUEUE_SIZE - 1)];
+        diff = (int)(__atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) - pos);
+        if (diff == 0)
+        {
+            if (__atomic_compare_exchange_n(&c->command_head, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                break;
+        }
+        else if (diff < 0)
+            return BUFFER_OVERFLOW; /* the client task has not taken the slot from the previous lap yet */
+        else
+            pos = __atomic_load_n(&c->command_head, __ATOMIC_RELAXED);
+    }
+
+    slot->type = command->type;
+    slot->topic = command->topic;
+    slot->message = command->message;
+    slot->qos = command->qos;
+    slot->handler = command->handler;
+    slot->onComplete = command->onComplete;
+    slot->context = command->context;
+    __atomic_store_n(&slot->sequence, pos + 1, __ATOMIC_SEQ_CST);
+    if (__atomic_exchange_n(&c->task_waiting, 0, __ATOMIC_SEQ_CST))
+        c->ipstack->mqttwake(c->ipstack);
+    return SUCCESS;
+}
+
+
+static int commandWaiting(MQTTClient* c)
+{
+    MQTTCommand* slot = &c->commands[c->command_tail & (MQTT_COMMAND_QUEUE_SIZE - 1)];
+    return __atomic_load_n(&slot->sequence, __ATOMIC_SEQ_CST) == c->command_tail + 1;
+}
+
+
+static void runCommands(MQTTClient* c)
+{
+    while (1)
+    {
+        MQTTCommand* slot = &c->commands[c->command_tail & (MQTT_COMMAND_QUEUE_SIZE - 1)];
+        MQTTCommand command;
+        MQTTSubackData data;
+        int rc = FAILURE;
+
+        if (!commandWaiting(c))
+            break; /* empty, or the next producer is still filling in its slot */
+        command = *slot;
+        __atomic_store_n(&slot->sequence, c->command_tail + MQTT_COMMAND_QUEUE_SIZE, __ATOMIC_RELEASE);
+        c->command_tail++;
+
+        switch (command.type)
+        {
+            case PUBLISH:
+                rc = publish(c, command.topic, &command.message);
+                break;
+            case SUBSCRIBE:
+                if ((rc = subscribe(c, command.topic, command.qos, command.handler, &data)) == SUCCESS)
+                    rc = data.grantedQoS;
+                break;
+            case UNSUBSCRIBE:
+                rc = unsubscribe(c, command.topic);
+                break;
+        }
+        if (command.onComplete != NULL)
+            command.onComplete(command.context, rc);
+    }
+}
+
+
+int MQTTPublishAsync(MQTTClient* c, const char* topicName, MQTTMessage* message,
+    commandCompleteHandler onComplete, void* context)
+{
+    MQTTCommand command;
+
+    memset(&command, 0, sizeof(command));
+    command.type = PUBLISH;
+    command.topic = topicName;
+    command.message = *message;
+    command.onComplete = onComplete;
+    command.context = context;
+    return enqueueCommand(c, &command);
+}
+
+
+int MQTTSubscribeAsync(MQTTClient* c, const char* topicFilter, enum QoS qos, messageHandler messageHandler,
+    commandCompleteHandler onComplete, void* context)
+{
+    MQTTCommand command;
+
+    memset(&command, 0, sizeof(command));
+    command.type = SUBSCRIBE;
+    command.topic = topicFilter;
+    command.qos = qos;
+    command.handler = messageHandler;
+    command.onComplete = onComplete;
+    command.context = context;
+    return enqueueCommand(c, &command);
+}
+
+
+int MQTTUnsubscribeAsync(MQTTClient* c, const char* topicFilter,
+    commandCompleteHandler onComplete, void* context)
+{
+    MQTTCommand command;
+
+    memset(&command, 0, sizeof(command));
+    command.type = UNSUBSCRIBE;
+    command.topic = topicFilter;
+    command.onComplete = onComplete;
+    command.context = context;
+    return enqueueCommand(c, &command);
+}
+#endif
@@ -36,6 +36,10 @@
 
 #include "MQTTPacket.h"
 
+#if defined(MQTT_ASYNC) && !defined(MQTT_TASK)
+#define MQTT_TASK 1 /* commands are run by the client task */
+#endif
+
 #if defined(MQTTCLIENT_PLATFORM_HEADER)
 /* The following sequence of macros converts the MQTTCLIENT_PLATFORM_HEADER value
  * into a string constant suitable for use with include.
@@ -51,18 +55,27 @@
 #define MAX_MESSAGE_HANDLERS 5 /* redefinable - how many subscriptions do you want? */
 #endif
 
+#if defined(MQTT_ASYNC)
+#if !defined(MQTT_COMMAND_QUEUE_SIZE)
+#define MQTT_COMMAND_QUEUE_SIZE 16 /* redefinable - commands waiting for the client task, a power of 2 */
+#endif
+#endif
+
 enum QoS { QOS0, QOS1, QOS2, SUBFAIL=0x80 };
 
 /* all failure return codes must be negative */
 enum returnCode { BUFFER_OVERFLOW = -2, FAILURE = -1, SUCCESS = 0 };
 
 /* The Platform specific header must define the Network and Timer structures and functions
- * which operate on them.
+ * which operate on them.  With MQTT_ASYNC, mqttwait waits until data can be read, the timeout
+ * expires or mqttwake is called from another thread, and returns 1 if data can be read.
  *
 typedef struct Network
 {
 	int (*mqttread)(Network*, unsigned char* read_buffer, int, int);
 	int (*mqttwrite)(Network*, unsigned char* send_buffer, int, int);
+	int (*mqttwait)(Network*, int);
+	void (*mqttwake)(Network*);
 } Network;*/
 
 /* The Timer structure must be defined in the platform specific header,
@@ -102,6 +115,23 @@ typedef struct MQTTSubackData
 
 typedef void (*messageHandler)(MessageData*);
 
+#if defined(MQTT_ASYNC)
+/* Called by the client task when a queued command has completed, with its success code */
+typedef void (*commandCompleteHandler)(void* context, int rc);
+
+typedef struct MQTTCommand
+{
+    unsigned int sequence; /* position in the queue this slot is ready for */
+    int type;
+    const char* topic;
+    MQTTMessage message;
+    enum QoS qos;
+    messageHandler handler;
+    commandCompleteHandler onComplete;
+    void* context;
+} MQTTCommand;
+#endif
+
 typedef struct MQTTClient
 {
     unsigned int next_packetid,
@@ -129,6 +159,11 @@ typedef struct MQTTClient
     Mutex mutex;
     Thread thread;
 #endif
+#if defined(MQTT_ASYNC)
+    MQTTCommand commands[MQTT_COMMAND_QUEUE_SIZE]; /* lock-free ring, many producers, the client task consumes */
+    unsigned int command_head, command_tail;
+    int task_waiting; /* the client task is waiting for the network, producers wake it */
+#endif
 } MQTTClient;
 
 #define DefaultClient {0, 0, 0, 0, NULL, NULL, 0, 0, 0}
@@ -226,6 +261,46 @@ DLLExport int MQTTIsConnected(MQTTClient* client);
 DLLExport int MQTTStartTask(MQTTClient* client);
 #endif
 
+#if defined(MQTT_ASYNC)
+/* With MQTT_ASYNC the calls below queue a command for the client task started by MQTTStartTask and return
+ * at once, without waiting for the network or for other threads.  The command is run in queue order and
+ * onComplete, which may be NULL, is called from the client task with its success code, so it must not block.
+ * Strings and payloads passed in must stay valid until then.  Once the task is started, only these calls
+ * and MQTTIsConnected can be used from other threads.
+ */
+
+/** MQTT Publish - queue an MQTT publish
+ *  @param client - the client object to use
+ *  @param topic - the topic to publish to
+ *  @param message - the message to send, copied into the queue
+ *  @param onComplete - called with the success code once all acks for the QoS are received
+ *  @param context - passed to onComplete
+ *  @return success code - BUFFER_OVERFLOW if the command queue is full
+ */
+DLLExport int MQTTPublishAsync(MQTTClient* client, const char* topic, MQTTMessage* message,
+    commandCompleteHandler onComplete, void* context);
+
+/** MQTT Subscribe - queue an MQTT subscribe
+ *  @param client - the client object to use
+ *  @param topicFilter - the topic filter to subscribe to
+ *  @param onComplete - called with the granted QoS, SUBFAIL if refused, or a failure code
+ *  @param context - passed to onComplete
+ *  @return success code - BUFFER_OVERFLOW if the command queue is full
+ */
+DLLExport int MQTTSubscribeAsync(MQTTClient* client, const char* topicFilter, enum QoS, messageHandler,
+    commandCompleteHandler onComplete, void* context);
+
+/** MQTT Unsubscribe - queue an MQTT unsubscribe
+ *  @param client - the client object to use
+ *  @param topicFilter - the topic filter to unsubscribe from
+ *  @param onComplete - called with the success code once the unsuback is received
+ *  @param context - passed to onComplete
+ *  @return success code - BUFFER_OVERFLOW if the command queue is full
+ */
+DLLExport int MQTTUnsubscribeAsync(MQTTClient* client, const char* topicFilter,
+    commandCompleteHandler onComplete, void* context);
+#endif
+
 #if defined(__cplusplus)
      }
 #endif
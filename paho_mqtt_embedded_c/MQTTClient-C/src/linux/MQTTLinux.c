@@ -59,6 +59,39 @@ int TimerLeftMS(Timer* timer)
 }
 
 
+#if defined(MQTT_TASK) || defined(MQTT_ASYNC)
+void MutexInit(Mutex* mutex)
+{
+	pthread_mutex_init(&mutex->mutex, NULL);
+}
+
+int MutexLock(Mutex* mutex)
+{
+	return pthread_mutex_lock(&mutex->mutex);
+}
+
+int MutexUnlock(Mutex* mutex)
+{
+	return pthread_mutex_unlock(&mutex->mutex);
+}
+
+
+static void* ThreadRun(void* arg)
+{
+	Thread* thread = (Thread*)arg;
+	thread->fn(thread->arg);
+	return NULL;
+}
+
+int ThreadStart(Thread* thread, void (*fn)(void*), void* arg)
+{
+	thread->fn = fn;
+	thread->arg = arg;
+	return pthread_create(&thread->thread, NULL, ThreadRun, thread);
+}
+#endif
+
+
 int linux_read(Network* n, unsigned char* buffer, int len, int timeout_ms)
 {
 	struct timeval interval = {timeout_ms / 1000, (timeout_ms % 1000) * 1000};
@@ -105,11 +138,73 @@ int linux_write(Network* n, unsigned char* buffer, int len, int timeout_ms)
 }
 
 
+#if defined(MQTT_ASYNC)
+/* wait until the socket is readable, the timeout expires or linux_wake is called.  Returns 1 if readable */
+int linux_wait(Network* n, int timeout_ms)
+{
+	struct timeval interval = {timeout_ms / 1000, (timeout_ms % 1000) * 1000};
+	fd_set readfds;
+	int rc;
+
+	FD_ZERO(&readfds);
+	FD_SET(n->my_socket, &readfds);
+	if (n->wake_pipe[0] != -1)
+		FD_SET(n->wake_pipe[0], &readfds);
+	rc = select(MAX(n->my_socket, n->wake_pipe[0]) + 1, &readfds, NULL, NULL, &interval);
+	if (rc > 0 && n->wake_pipe[0] != -1 && FD_ISSET(n->wake_pipe[0], &readfds))
+	{
+		char drain[16];
+		while (read(n->wake_pipe[0], drain, sizeof(drain)) > 0)
+			;
+	}
+	if (rc > 0)
+		rc = FD_ISSET(n->my_socket, &readfds) ? 1 : 0;
+	return rc;
+}
+
+
+void linux_wake(Network* n)
+{
+	char c = 0;
+	if (n->wake_pipe[1] != -1 && write(n->wake_pipe[1], &c, 1) < 0)
+		; /* the pipe is full, so a wake up is pending anyway */
+}
+
+
+/* without the pipe, linux_wait falls back to waking on the socket or the timeout only */
+static void linux_open_wake_pipe(Network* n)
+{
+	if (pipe(n->wake_pipe) == 0)
+	{
+		fcntl(n->wake_pipe[0], F_SETFL, O_NONBLOCK);
+		fcntl(n->wake_pipe[1], F_SETFL, O_NONBLOCK);
+	}
+	else
+		n->wake_pipe[0] = n->wake_pipe[1] = -1;
+}
+
+
+static void linux_close_wake_pipe(Network* n)
+{
+	if (n->wake_pipe[0] != -1)
+		close(n->wake_pipe[0]);
+	if (n->wake_pipe[1] != -1)
+		close(n->wake_pipe[1]);
+	n->wake_pipe[0] = n->wake_pipe[1] = -1;
+}
+#endif
+
+
 void NetworkInit(Network* n)
 {
 	n->my_socket = 0;
 	n->mqttread = linux_read;
 	n->mqttwrite = linux_write;
+#if defined(MQTT_ASYNC)
+	n->mqttwait = linux_wait;
+	n->mqttwake = linux_wake;
+	linux_open_wake_pipe(n);
+#endif
 }
 
 
@@ -149,6 +244,10 @@ int NetworkConnect(Network* n, char* addr, int port)
 		freeaddrinfo(result);
 	}
 
+#if defined(MQTT_ASYNC)
+	if (n->wake_pipe[0] == -1)
+		linux_open_wake_pipe(n); /* closed by an earlier NetworkDisconnect */
+#endif
 	if (rc == 0)
 	{
 		n->my_socket = socket(family, type, 0);
@@ -165,4 +264,7 @@ int NetworkConnect(Network* n, char* addr, int port)
 void NetworkDisconnect(Network* n)
 {
 	close(n->my_socket);
+#if defined(MQTT_ASYNC)
+	linux_close_wake_pipe(n);
+#endif
 }
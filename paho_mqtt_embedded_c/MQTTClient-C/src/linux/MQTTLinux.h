@@ -57,15 +57,46 @@ void TimerCountdownMS(Timer*, unsigned int);
 void TimerCountdown(Timer*, unsigned int);
 int TimerLeftMS(Timer*);
 
+#if defined(MQTT_TASK) || defined(MQTT_ASYNC)
+#include <pthread.h>
+
+typedef struct Mutex
+{
+	pthread_mutex_t mutex;
+} Mutex;
+
+void MutexInit(Mutex*);
+int MutexLock(Mutex*);
+int MutexUnlock(Mutex*);
+
+typedef struct Thread
+{
+	pthread_t thread;
+	void (*fn)(void*);
+	void* arg;
+} Thread;
+
+int ThreadStart(Thread*, void (*fn)(void*), void* arg);
+#endif
+
 typedef struct Network
 {
 	int my_socket;
 	int (*mqttread) (struct Network*, unsigned char*, int, int);
 	int (*mqttwrite) (struct Network*, unsigned char*, int, int);
+#if defined(MQTT_ASYNC)
+	int (*mqttwait) (struct Network*, int);
+	void (*mqttwake) (struct Network*);
+	int wake_pipe[2];
+#endif
 } Network;
 
 int linux_read(Network*, unsigned char*, int, int);
 int linux_write(Network*, unsigned char*, int, int);
+#if defined(MQTT_ASYNC)
+int linux_wait(Network*, int);
+void linux_wake(Network*);
+#endif
 
 DLLExport void NetworkInit(Network*);
 DLLExport int NetworkConnect(Network*, char*, int);
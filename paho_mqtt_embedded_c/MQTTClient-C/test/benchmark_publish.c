@@ -0,0 +1,266 @@
+/*******************************************************************************
+ * Copyright (c) 2026 agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - publish benchmark of MQTT_TASK and MQTT_ASYNC
+ *******************************************************************************/
+
+/*
+ * Several producer threads publish QoS 1 messages through one client whose task was started by MQTTStartTask.
+ * Built with MQTT_TASK the producers call MQTTPublish and share the client mutex with the task, built with
+ * MQTT_ASYNC they call MQTTPublishAsync.  A loopback broker thread acknowledges every publish, so no broker
+ * needs to be running.  Reports the throughput and the time producers spend inside the publish call.
+ */
+
+#include "MQTTClient.h"
+#include <string.h>
+#include <stdlib.h>
+#include <sched.h>
+#include <time.h>
+
+struct Options
+{
+	int producers;
+	int messages;
+	int payloadlen;
+} options =
+{
+	4,
+	2000,
+	32,
+};
+
+void usage(void)
+{
+	printf("options:\n  --producers <threads>\n  --messages <per producer>\n  --payload <bytes>\n");
+	exit(EXIT_FAILURE);
+}
+
+void getopts(int argc, char** argv)
+{
+	int count = 1;
+
+	while (count < argc)
+	{
+		if (strcmp(argv[count], "--producers") == 0 && ++count < argc)
+			options.producers = atoi(argv[count]);
+		else if (strcmp(argv[count], "--messages") == 0 && ++count < argc)
+			options.messages = atoi(argv[count]);
+		else if (strcmp(argv[count], "--payload") == 0 && ++count < argc)
+			options.payloadlen = atoi(argv[count]);
+		else
+			usage();
+		count++;
+	}
+}
+
+static long long now_us(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (long long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+
+/* loopback broker: acknowledges connect, QoS 1 publishes and pings */
+
+static int listen_socket = -1;
+
+static int recv_all(int sock, unsigned char* buf, int len)
+{
+	int got = 0;
+
+	while (got < len)
+	{
+		int rc = recv(sock, buf + got, len - got, 0);
+		if (rc <= 0)
+			return -1;
+		got += rc;
+	}
+	return got;
+}
+
+static void* broker(void* arg)
+{
+	unsigned char buf[1024];
+	int sock = accept(listen_socket, NULL, NULL);
+
+	while (sock >= 0)
+	{
+		MQTTHeader header = {0};
+		int rem_len = 0, multiplier = 1;
+		unsigned char c;
+
+		if (recv_all(sock, &header.byte, 1) != 1)
+			break;
+		do
+		{
+			if (recv_all(sock, &c, 1) != 1)
+				goto exit;
+			rem_len += (c & 127) * multiplier;
+			multiplier *= 128;
+		} while (c & 128);
+		if (rem_len > (int)sizeof(buf) || (rem_len > 0 && recv_all(sock, buf, rem_len) != rem_len))
+			break;
+
+		if (header.bits.type == CONNECT)
+		{
+			unsigned char connack[] = {0x20, 0x02, 0x00, 0x00};
+			send(sock, connack, sizeof(connack), 0);
+		}
+		else if (header.bits.type == PUBLISH && header.bits.qos == 1)
+		{
+			int topiclen = (buf[0] << 8) + buf[1];
+			unsigned char puback[] = {0x40, 0x02, buf[2 + topiclen], buf[3 + topiclen]};
+			send(sock, puback, sizeof(puback), 0);
+		}
+		else if (header.bits.type == PINGREQ)
+		{
+			unsigned char pingresp[] = {0xD0, 0x00};
+			send(sock, pingresp, sizeof(pingresp), 0);
+		}
+		else if (header.bits.type == DISCONNECT)
+			break;
+	}
+exit:
+	if (sock >= 0)
+		close(sock);
+	return NULL;
+}
+
+static int start_broker(void)
+{
+	struct sockaddr_in address;
+	socklen_t len = sizeof(address);
+	pthread_t thread;
+
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	listen_socket = socket(AF_INET, SOCK_STREAM, 0);
+	if (listen_socket < 0 || bind(listen_socket, (struct sockaddr*)&address, sizeof(address)) != 0 ||
+		listen(listen_socket, 1) != 0 || getsockname(listen_socket, (struct sockaddr*)&address, &len) != 0)
+		return -1;
+	pthread_create(&thread, NULL, broker, NULL);
+	return ntohs(address.sin_port);
+}
+
+
+/* producers */
+
+static MQTTClient client;
+static int completed, failed;
+static long long call_us_total, call_us_max;
+static pthread_mutex_t stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+#if defined(MQTT_ASYNC)
+static void on_published(void* context, int rc)
+{
+	__atomic_add_fetch(rc == SUCCESS ? &completed : &failed, 1, __ATOMIC_RELAXED);
+}
+#endif
+
+static void* producer(void* arg)
+{
+	MQTTMessage message;
+	long long in_call = 0, longest = 0;
+	int i;
+
+	memset(&message, 0, sizeof(message));
+	message.qos = QOS1;
+	message.payload = arg;
+	message.payloadlen = options.payloadlen;
+
+	for (i = 0; i < options.messages; ++i)
+	{
+		long long start = now_us(), took;
+#if defined(MQTT_ASYNC)
+		while (MQTTPublishAsync(&client, "benchmark/publish", &message, on_published, NULL) == BUFFER_OVERFLOW)
+			sched_yield(); /* queue full, the client task is behind */
+#else
+		if (MQTTPublish(&client, "benchmark/publish", &message) == SUCCESS)
+			__atomic_add_fetch(&completed, 1, __ATOMIC_RELAXED);
+		else
+			__atomic_add_fetch(&failed, 1, __ATOMIC_RELAXED);
+#endif
+		took = now_us() - start;
+		in_call += took;
+		if (took > longest)
+			longest = took;
+	}
+
+	pthread_mutex_lock(&stats_mutex);
+	call_us_total += in_call;
+	if (longest > call_us_max)
+		call_us_max = longest;
+	pthread_mutex_unlock(&stats_mutex);
+	return NULL;
+}
+
+
+int main(int argc, char** argv)
+{
+	Network network;
+	unsigned char sendbuf[1024], readbuf[1024];
+	MQTTPacket_connectData data = MQTTPacket_connectData_initializer;
+	pthread_t* threads;
+	char* payload;
+	int total, i, port;
+	long long start, elapsed;
+
+	getopts(argc, argv);
+	total = options.producers * options.messages;
+	if ((port = start_broker()) < 0)
+	{
+		printf("cannot start the loopback broker\n");
+		return EXIT_FAILURE;
+	}
+
+	NetworkInit(&network);
+	if (NetworkConnect(&network, "127.0.0.1", port) != 0)
+	{
+		printf("cannot connect to the loopback broker\n");
+		return EXIT_FAILURE;
+	}
+	MQTTClientInit(&client, &network, 30000, sendbuf, sizeof(sendbuf), readbuf, sizeof(readbuf));
+	data.clientID.cstring = "benchmark_publish";
+	if (MQTTConnect(&client, &data) != SUCCESS || MQTTStartTask(&client) != 0)
+	{
+		printf("cannot connect the client\n");
+		return EXIT_FAILURE;
+	}
+
+	payload = calloc(1, options.payloadlen + 1);
+	threads = calloc(options.producers, sizeof(pthread_t));
+	start = now_us();
+	for (i = 0; i < options.producers; ++i)
+		pthread_create(&threads[i], NULL, producer, payload);
+	for (i = 0; i < options.producers; ++i)
+		pthread_join(threads[i], NULL);
+	while (__atomic_load_n(&completed, __ATOMIC_RELAXED) + __atomic_load_n(&failed, __ATOMIC_RELAXED) < total)
+		usleep(100);
+	elapsed = now_us() - start;
+
+#if defined(MQTT_ASYNC)
+	printf("mode: MQTT_ASYNC, command queue %d\n", MQTT_COMMAND_QUEUE_SIZE);
+#else
+	printf("mode: MQTT_TASK, client mutex\n");
+#endif
+	printf("producers %d, QoS 1 messages %d, payload %d bytes\n", options.producers, total, options.payloadlen);
+	printf("completed %d, failed %d in %lld ms, %lld messages/s\n", completed, failed, elapsed / 1000,
+		elapsed > 0 ? (long long)completed * 1000000 / elapsed : 0);
+	printf("time in publish call: average %lld us, longest %lld us\n", call_us_total / total, call_us_max);
+
+	free(threads);
+	free(payload);
+	return (completed == total) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -36,6 +36,30 @@
 #if !defined(MQTTCLIENT_QOS2)
     #define MQTTCLIENT_QOS2 0
 #endif
+#if !defined(MQTTCLIENT_SHARED_BUFFERS)
+    #define MQTTCLIENT_SHARED_BUFFERS 0
+#endif
+#if !defined(MQTTCLIENT_MAX_FILTERS_PER_PACKET)
+    #define MQTTCLIENT_MAX_FILTERS_PER_PACKET 16
+#endif
+#if !defined(MQTTCLIENT_SPOOL)
+    #define MQTTCLIENT_SPOOL 0
+#endif
+#if MQTTCLIENT_SPOOL
+    #include "MQTTSpool.h"
+    #if !defined(MQTTCLIENT_SPOOL_BURST)
+        #define MQTTCLIENT_SPOOL_BURST 16
+    #endif
+#endif
+#if MQTTCLIENT_SHARED_BUFFERS
+    #include <stdlib.h>
+    #if !defined(MQTTCLIENT_MALLOC)
+        #define MQTTCLIENT_MALLOC malloc
+    #endif
+    #if !defined(MQTTCLIENT_FREE)
+        #define MQTTCLIENT_FREE free
+    #endif
+#endif
 
 namespace MQTT
 {
@@ -44,7 +68,7 @@ namespace MQTT
 enum QoS { QOS0, QOS1, QOS2 };
 
 // all failure return codes must be negative
-enum returnCode { BUFFER_OVERFLOW = -2, FAILURE = -1, SUCCESS = 0 };
+enum returnCode { BUFFER_OVERFLOW = -2, FAILURE = -1, SUCCESS = 0, SPOOLED = 1 };
 
 
 struct Message
@@ -106,6 +130,10 @@ private:
  *
  * This version of the API blocks on all method calls, until they are complete.  This means that only one
  * MQTT request can be in process at any one time.
+ *
+ * With MQTTCLIENT_SHARED_BUFFERS the send and read buffers are supplied by the caller, so clients which
+ * are never used concurrently can share them, and the copy of an inflight publish kept for resending
+ * on reconnect is allocated with MQTTCLIENT_MALLOC to the length of the packet.
  * @param Network a network class which supports send, receive
  * @param Timer a timer class with the methods:
  */
@@ -122,7 +150,19 @@ public:
      *      before calling MQTT connect
      *  @param limits an instance of the Limit class - to alter limits as required
      */
+#if MQTTCLIENT_SHARED_BUFFERS
+    /** Construct the client on caller supplied buffers
+     *  @param network - pointer to an instance of the Network class - must be connected to the endpoint
+     *      before calling MQTT connect
+     *  @param sendbuf - MAX_MQTT_PACKET_SIZE bytes, can be shared with clients which are not used concurrently
+     *  @param readbuf - MAX_MQTT_PACKET_SIZE bytes, can be shared with clients which are not used concurrently
+     */
+    Client(Network& network, unsigned char* sendbuf, unsigned char* readbuf, unsigned int command_timeout_ms = 30000);
+
+    ~Client();
+#else
     Client(Network& network, unsigned int command_timeout_ms = 30000);
+#endif
 
     /** Set the default message handling callback - used for any message which does not match a subscription message handler
      *  @param mh - pointer to the callback function.  Set to 0 to remove.
@@ -214,6 +254,26 @@ public:
      */
     int unsubscribe(const char* topicFilter);
 
+    /** MQTT Subscribe - subscribe to several topic filters in as few subscribe packets as possible
+     *  Each packet carries as many topic filters as fit into MAX_MQTT_PACKET_SIZE, up to
+     *  MQTTCLIENT_MAX_FILTERS_PER_PACKET, and waits for its suback before the next one is sent.
+     *  @param count - the number of topic filters
+     *  @param topicFilters - topic patterns which can include wildcards
+     *  @param qos - the MQTT QoS to subscribe at, one per topic filter
+     *  @param mh - the callback functions, one per topic filter, registered for the granted subscriptions.
+     *      If 0, no callbacks are registered
+     *  @param grantedQoSs - returned granted QoS, one per topic filter, 0x80 if the subscription was refused
+     *  @return success code - BUFFER_OVERFLOW if there are not enough free message handlers, nothing is sent then
+     */
+    int subscribe(int count, const char* topicFilters[], enum QoS qos[], messageHandler mh[], int grantedQoSs[]);
+
+    /** MQTT Unsubscribe - unsubscribe from several topic filters in as few unsubscribe packets as possible
+     *  @param count - the number of topic filters
+     *  @param topicFilters - topic patterns which can include wildcards
+     *  @return success code -
+     */
+    int unsubscribe(int count, const char* topicFilters[]);
+
     /** MQTT Disconnect - send an MQTT disconnect packet, and clean up any state
      *  @return success code -
      */
@@ -235,6 +295,30 @@ public:
         return isconnected;
     }
 
+#if MQTTCLIENT_SPOOL
+    /** Spool outgoing publishes, so that they are kept while the client is disconnected
+     *  With a spool every publish is added at the end of it, then the oldest spooled messages are sent,
+     *  one at a time and each only removed from the spool once it is acknowledged.  publish returns
+     *  SPOOLED when messages remain to be sent, also when the connection was lost sending them, which
+     *  isConnected shows, and BUFFER_OVERFLOW when the spool is full.  connect
+     *  and yield send up to MQTTCLIENT_SPOOL_BURST spooled messages, so the spool drains as the
+     *  application runs.  Packet ids are assigned as messages are first sent, so publish does not return
+     *  one, and are kept in the spool, so a message resent after a lost acknowledgement is a duplicate the
+     *  broker recognises.  A QoS 2 message is then delivered once if the session is kept (cleansession false).
+     *  @param spool - the spool, or 0 to publish directly again
+     */
+    void setSpool(Spool* spool)
+    {
+        this->spool = spool;
+    }
+
+    /** Send spooled messages
+     *  @param max - the most messages to send
+     *  @return SUCCESS if the spool is now empty, SPOOLED if not, FAILURE if the client has disconnected
+     */
+    int replaySpool(int max = MQTTCLIENT_SPOOL_BURST);
+#endif
+
 private:
 
     void closeSession();
@@ -249,12 +333,19 @@ private:
     int sendPacket(int length, Timer& timer);
     int deliverMessage(MQTTString& topicName, Message& message);
     bool isTopicMatched(char* topicFilter, MQTTString& topicName);
+    int batchTopics(int count, const char* topicFilters[], MQTTString topics[], int extra);
+    bool haveHandlerSlots(int count, const char* topicFilters[], messageHandler mh[]);
 
     Network& ipstack;
     unsigned long command_timeout_ms;
 
+#if MQTTCLIENT_SHARED_BUFFERS
+    unsigned char* sendbuf;
+    unsigned char* readbuf;
+#else
     unsigned char sendbuf[MAX_MQTT_PACKET_SIZE];
     unsigned char readbuf[MAX_MQTT_PACKET_SIZE];
+#endif
 
     Timer last_sent, last_received;
     unsigned int keepAliveInterval;
@@ -273,8 +364,20 @@ private:
 
     bool isconnected;
 
+#if MQTTCLIENT_SPOOL
+    Spool* spool;
+    bool replaying;  // a message handler publishing during replay only adds to the spool
+    unsigned short replayid;  // packet id of the spooled message being sent
+#endif
+
 #if MQTTCLIENT_QOS1 || MQTTCLIENT_QOS2
+    bool storeInflight(int len);
+    void clearInflight();
+#if MQTTCLIENT_SHARED_BUFFERS
+    unsigned char* pubbuf;  // store the last publish for sending on reconnect, inflightLen bytes
+#else
     unsigned char pubbuf[MAX_MQTT_PACKET_SIZE];  // store the last publish for sending on reconnect
+#endif
     int inflightLen;
     unsigned short inflightMsgid;
     enum QoS inflightQoS;
@@ -303,7 +406,7 @@ void MQTT::Client<Network, Timer, a, MAX_MESSAGE_HANDLERS>::cleanSession()
         messageHandlers[i].topicFilter = 0;
 
 #if MQTTCLIENT_QOS1 || MQTTCLIENT_QOS2
-    inflightMsgid = 0;
+    clearInflight();
     inflightQoS = QOS0;
 #endif
 
@@ -325,13 +428,73 @@ void MQTT::Client<Network, Timer, a, MAX_MESSAGE_HANDLERS>::closeSession()
 }
 
 
+#if MQTTCLIENT_SHARED_BUFFERS
+template<class Network, class Timer, int a, int MAX_MESSAGE_HANDLERS>
+MQTT::Client<Network, Timer, a, MAX_MESSAGE_HANDLERS>::Client(Network& network, unsigned char* sendbuf, unsigned char* readbuf,
+     unsigned int command_timeout_ms)  : ipstack(network), sendbuf(sendbuf), readbuf(readbuf), packetid()
+{
+    this->command_timeout_ms = command_timeout_ms;
+#if MQTTCLIENT_QOS1 || MQTTCLIENT_QOS2
+    pubbuf = 0;
+#endif
+#if MQTTCLIENT_SPOOL
+    spool = 0;
+    replaying = false;
+    replayid = 0;
+#endif
+    cleansession = true;
+    closeSession();
+}
+
+
+template<class Network, class Timer, int a, int MAX_MESSAGE_HANDLERS>
+MQTT::Client<Network, Timer, a, MAX_MESSAGE_HANDLERS>::~Client()
+{
+#if MQTTCLIENT_QOS1 || MQTTCLIENT_QOS2
+    clearInflight();
+#endif
+}
+#else
 template<class Network, class Timer, int a, int MAX_MESSAGE_HANDLERS>
 MQTT::Client<Network, Timer, a, MAX_MESSAGE_HANDLERS>::Client(Network& network, unsigned int command_timeout_ms)  : ipstack(network), packetid()
 {
     this->command_timeout_ms = command_timeout_ms;
+#if MQTTCLIENT_SPOOL
+    spool = 0;
+    replaying = false;
+    replayid = 0;
+#endif
     cleansession = true;
 	  closeSession();
 }
+#endif
+
+
+#if MQTTCLIENT_QOS1 || MQTTCLIENT_QOS2
+template<class Network, class Timer, int a, int b>
+bool MQTT::Client<Network, Timer, a, b>::storeInflight(int len)
+{
+#if MQTTCLIENT_SHARED_BUFFERS
+    clearInflight();
+    if ((pubbuf = (unsigned char*)MQTTCLIENT_MALLOC(len)) == 0)
+        return false;
+#endif
+    memcpy(pubbuf, sendbuf, len);
+    inflightLen = len;
+    return true;
+}
+
+
+template<class Network, class Timer, int a, int b>
+void MQTT::Client<Network, Timer, a, b>::clearInflight()
+{
+    inflightMsgid = 0;
+#if MQTTCLIENT_SHARED_BUFFERS
+    MQTTCLIENT_FREE(pubbuf);
+    pubbuf = 0;
+#endif
+}
+#endif
 
 
 #if MQTTCLIENT_QOS2
@@ -580,6 +743,10 @@ int MQTT::Client<Network, Timer, a, b>::yield(unsigned long timeout_ms)
     Timer timer;
 
     timer.countdown_ms(timeout_ms);
+#if MQTTCLIENT_SPOOL
+    if (spool && isconnected && replaySpool() < 0)
+        return FAILURE;
+#endif
     while (!timer.expired())
     {
         if (cycle(timer) < 0)
@@ -673,6 +840,14 @@ int MQTT::Client<Network, Timer, MAX_MQTT_PACKET_SIZE, b>::cycle(Timer& timer)
                 goto exit; // there was a problem
             if (packet_type == PUBREL)
                 freeQoS2msgid(mypacketid);
+#if MQTTCLIENT_SPOOL
+            else if (replaying && mypacketid == replayid)
+            {
+                // the broker has the message, after a reconnect only the PUBREL is to be sent again
+                unsigned char released = PUBREL << 4 | 0x02;
+                spool->update(0, &released, 1);
+            }
+#endif
             break;
 
         case PUBCOMP:
@@ -795,7 +970,7 @@ int MQTT::Client<Network, Timer, MAX_MQTT_PACKET_SIZE, b>::connect(MQTTPacket_co
 #if MQTTCLIENT_QOS1 || MQTTCLIENT_QOS2
     if (inflightMsgid > 0)
     {
-        memcpy(sendbuf, pubbuf, MAX_MQTT_PACKET_SIZE);
+        memcpy(sendbuf, pubbuf, inflightLen);
         rc = publish(inflightLen, connect_timer, inflightQoS);
     }
 #endif
@@ -805,6 +980,10 @@ exit:
     {
         isconnected = true;
         ping_outstanding = false;
+#if MQTTCLIENT_SPOOL
+        if (spool && replaySpool() < 0)
+            rc = FAILURE;
+#endif
     }
     return rc;
 }
@@ -951,6 +1130,152 @@ exit:
 }
 
 
+// fill topics with the leading topic filters which fit into one packet, each taking extra bytes after its name
+template<class Network, class Timer, int MAX_MQTT_PACKET_SIZE, int b>
+int MQTT::Client<Network, Timer, MAX_MQTT_PACKET_SIZE, b>::batchTopics(int count, const char* topicFilters[],
+     MQTTString topics[], int extra)
+{
+    int rem_len = 2; // packetid
+    int n = 0;
+
+    for (n = 0; n < count && n < MQTTCLIENT_MAX_FILTERS_PER_PACKET; ++n)
+    {
+        int topic_len = 2 + strlen(topicFilters[n]) + extra;
+        if (MQTTPacket_len(rem_len + topic_len) > MAX_MQTT_PACKET_SIZE)
+            break;
+        rem_len += topic_len;
+        topics[n].cstring = (char*)topicFilters[n];
+        topics[n].lenstring.len = 0;
+        topics[n].lenstring.data = 0;
+    }
+    return n;
+}
+
+
+// check that the message handlers for all the topic filters can be set before subscribing to any of them,
+// counting only the filters neither registered already nor listed earlier in the same call
+template<class Network, class Timer, int a, int MAX_MESSAGE_HANDLERS>
+bool MQTT::Client<Network, Timer, a, MAX_MESSAGE_HANDLERS>::haveHandlerSlots(int count, const char* topicFilters[],
+     messageHandler mh[])
+{
+    int free_slots = 0;
+
+    for (int i = 0; i < MAX_MESSAGE_HANDLERS; ++i)
+    {
+        if (messageHandlers[i].topicFilter == 0)
+            ++free_slots;
+    }
+    for (int i = 0; mh != 0 && i < count; ++i)
+    {
+        bool found = (mh[i] == 0);
+        for (int j = 0; j < MAX_MESSAGE_HANDLERS && !found; ++j)
+            found = messageHandlers[j].topicFilter != 0 && strcmp(messageHandlers[j].topicFilter, topicFilters[i]) == 0;
+        for (int j = 0; j < i && !found; ++j)
+            found = mh[j] != 0 && strcmp(topicFilters[j], topicFilters[i]) == 0;
+        if (!found && --free_slots < 0)
+            return false;
+    }
+    return true;
+}
+
+
+template<class Network, class Timer, int MAX_MQTT_PACKET_SIZE, int MAX_MESSAGE_HANDLERS>
+int MQTT::Client<Network, Timer, MAX_MQTT_PACKET_SIZE, MAX_MESSAGE_HANDLERS>::subscribe(int count, const char* topicFilters[],
+     enum QoS qos[], messageHandler mh[], int grantedQoSs[])
+{
+    int rc = FAILURE;
+    MQTTString topics[MQTTCLIENT_MAX_FILTERS_PER_PACKET];
+    int requestedQoSs[MQTTCLIENT_MAX_FILTERS_PER_PACKET];
+    int i = 0;
+
+    if (!isconnected)
+        goto exit;
+    if (!haveHandlerSlots(count, topicFilters, mh))
+    {
+        rc = BUFFER_OVERFLOW;
+        goto exit;
+    }
+
+    rc = SUCCESS;
+    while (i < count)
+    {
+        Timer timer(command_timeout_ms);
+        int n = batchTopics(count - i, &topicFilters[i], topics, 1);
+        int len = 0;
+        int granted = 0;
+        unsigned short mypacketid;
+
+        for (int j = 0; j < n; ++j)
+            requestedQoSs[j] = qos[i + j];
+        rc = FAILURE;
+        if (n == 0 || (len = MQTTSerialize_subscribe(sendbuf, MAX_MQTT_PACKET_SIZE, 0, packetid.getNext(), n, topics, requestedQoSs)) <= 0)
+            goto exit;
+        if ((rc = sendPacket(len, timer)) != SUCCESS) // send the subscribe packet
+            goto exit;             // there was a problem
+
+        if (waitfor(SUBACK, timer) != SUBACK ||
+                MQTTDeserialize_suback(&mypacketid, n, &granted, &grantedQoSs[i], readbuf, MAX_MQTT_PACKET_SIZE) != 1 || granted != n)
+        {
+            rc = FAILURE;
+            goto exit;
+        }
+        for (int j = i; mh != 0 && j < i + n; ++j)
+        {
+            if (grantedQoSs[j] != 0x80)
+                setMessageHandler(topicFilters[j], mh[j]);
+        }
+        i += n;
+    }
+
+exit:
+    if (rc == FAILURE)
+        closeSession();
+    return rc;
+}
+
+
+template<class Network, class Timer, int MAX_MQTT_PACKET_SIZE, int MAX_MESSAGE_HANDLERS>
+int MQTT::Client<Network, Timer, MAX_MQTT_PACKET_SIZE, MAX_MESSAGE_HANDLERS>::unsubscribe(int count, const char* topicFilters[])
+{
+    int rc = FAILURE;
+    MQTTString topics[MQTTCLIENT_MAX_FILTERS_PER_PACKET];
+    int i = 0;
+
+    if (!isconnected)
+        goto exit;
+
+    rc = SUCCESS;
+    while (i < count)
+    {
+        Timer timer(command_timeout_ms);
+        int n = batchTopics(count - i, &topicFilters[i], topics, 0);
+        int len = 0;
+        unsigned short mypacketid;
+
+        rc = FAILURE;
+        if (n == 0 || (len = MQTTSerialize_unsubscribe(sendbuf, MAX_MQTT_PACKET_SIZE, 0, packetid.getNext(), n, topics)) <= 0)
+            goto exit;
+        if ((rc = sendPacket(len, timer)) != SUCCESS) // send the unsubscribe packet
+            goto exit; // there was a problem
+
+        if (waitfor(UNSUBACK, timer) != UNSUBACK || MQTTDeserialize_unsuback(&mypacketid, readbuf, MAX_MQTT_PACKET_SIZE) != 1)
+        {
+            rc = FAILURE;
+            goto exit;
+        }
+        // remove the subscription message handlers associated with these topics, if there are any
+        for (int j = i; j < i + n; ++j)
+            setMessageHandler(topicFilters[j], 0);
+        i += n;
+    }
+
+exit:
+    if (rc != SUCCESS)
+        closeSession();
+    return rc;
+}
+
+
 template<class Network, class Timer, int MAX_MQTT_PACKET_SIZE, int b>
 int MQTT::Client<Network, Timer, MAX_MQTT_PACKET_SIZE, b>::publish(int len, Timer& timer, enum QoS qos)
 {
@@ -969,7 +1294,7 @@ int MQTT::Client<Network, Timer, MAX_MQTT_PACKET_SIZE, b>::publish(int len, Time
             if (MQTTDeserialize_ack(&type, &dup, &mypacketid, readbuf, MAX_MQTT_PACKET_SIZE) != 1)
                 rc = FAILURE;
             else if (inflightMsgid == mypacketid)
-                inflightMsgid = 0;
+                clearInflight();
         }
         else
             rc = FAILURE;
@@ -985,7 +1310,7 @@ int MQTT::Client<Network, Timer, MAX_MQTT_PACKET_SIZE, b>::publish(int len, Time
             if (MQTTDeserialize_ack(&type, &dup, &mypacketid, readbuf, MAX_MQTT_PACKET_SIZE) != 1)
                 rc = FAILURE;
             else if (inflightMsgid == mypacketid)
-                inflightMsgid = 0;
+                clearInflight();
         }
         else
             rc = FAILURE;
@@ -1000,6 +1325,83 @@ exit:
 
 
 
+#if MQTTCLIENT_SPOOL
+template<class Network, class Timer, int MAX_MQTT_PACKET_SIZE, int b>
+int MQTT::Client<Network, Timer, MAX_MQTT_PACKET_SIZE, b>::replaySpool(int max)
+{
+    int rc = SUCCESS;
+
+    if (spool == 0 || replaying)
+        return SUCCESS;
+    replaying = true;
+    for (int sent = 0; !spool->empty(); ++sent)
+    {
+        Timer timer(command_timeout_ms);
+        MQTTHeader header = {0};
+        int len, remlen = 0;
+
+        if (!isconnected)
+        {
+            rc = FAILURE;
+            break;
+        }
+        if (sent == max)
+        {
+            rc = SPOOLED;
+            break;
+        }
+        if ((len = spool->peek(sendbuf, MAX_MQTT_PACKET_SIZE)) <= 0)
+        {
+            spool->pop(); // cannot be sent by this client, drop it rather than block the spool
+            continue;
+        }
+
+        header.byte = sendbuf[0];
+        enum QoS qos = (enum QoS)header.bits.qos;
+        if (qos != QOS0)
+        {
+            // the packet id follows the fixed header and the topic name
+            int pos = 1 + MQTTPacket_decodeBuf(&sendbuf[1], &remlen);
+            pos += 2 + (sendbuf[pos] << 8) + sendbuf[pos + 1];
+            if (pos + 2 > len)
+            {
+                spool->pop();
+                continue;
+            }
+            replayid = (sendbuf[pos] << 8) + sendbuf[pos + 1];
+            if (replayid == 0)
+            {
+                // first send: keep the id, and the DUP flag for any resend, in the spool.  If that cannot be
+                // written a resend gets a new id, so the message is only delivered at least once
+                replayid = packetid.getNext();
+                sendbuf[pos] = (unsigned char)(replayid >> 8);
+                sendbuf[pos + 1] = (unsigned char)replayid;
+                unsigned char resend = sendbuf[0] | 0x08;
+                if (spool->update(pos, &sendbuf[pos], 2))
+                    spool->update(0, &resend, 1);
+            }
+#if MQTTCLIENT_QOS2
+            if (header.bits.type == PUBREL)
+            {
+                qos = QOS2;
+                if ((len = MQTTSerialize_ack(sendbuf, MAX_MQTT_PACKET_SIZE, PUBREL, 0, replayid)) <= 0)
+                {
+                    spool->pop();
+                    continue;
+                }
+            }
+#endif
+        }
+        if ((rc = publish(len, timer, qos)) != SUCCESS)
+            break; // the message stays spooled for the next connection
+        spool->pop();
+    }
+    replaying = false;
+    return rc;
+}
+#endif
+
+
 template<class Network, class Timer, int MAX_MQTT_PACKET_SIZE, int b>
 int MQTT::Client<Network, Timer, MAX_MQTT_PACKET_SIZE, b>::publish(const char* topicName, void* payload, size_t payloadlen, unsigned short& id, enum QoS qos, bool retained)
 {
@@ -1008,10 +1410,27 @@ int MQTT::Client<Network, Timer, MAX_MQTT_PACKET_SIZE, b>::publish(const char* t
     MQTTString topicString = MQTTString_initializer;
     int len = 0;
 
-    if (!isconnected)
+    topicString.cstring = (char*)topicName;
+
+#if MQTTCLIENT_SPOOL
+    if (spool)
+    {
+        // the packet id is set when the message is sent
+        if ((len = MQTTSerialize_publish(sendbuf, MAX_MQTT_PACKET_SIZE, 0, qos, retained, 0,
+                topicString, (unsigned char*)payload, payloadlen)) <= 0)
+            goto exit;
+        if (!spool->push(sendbuf, len))
+            rc = BUFFER_OVERFLOW;
+        else if (!isconnected || replaying || replaySpool() != SUCCESS)
+            rc = SPOOLED;  // kept until it is replayed, whatever stopped the replay
+        else
+            rc = SUCCESS;
         goto exit;
+    }
+#endif
 
-    topicString.cstring = (char*)topicName;
+    if (!isconnected)
+        goto exit;
 
 #if MQTTCLIENT_QOS1 || MQTTCLIENT_QOS2
     if (qos == QOS1 || qos == QOS2)
@@ -1024,11 +1443,11 @@ int MQTT::Client<Network, Timer, MAX_MQTT_PACKET_SIZE, b>::publish(const char* t
         goto exit;
 
 #if MQTTCLIENT_QOS1 || MQTTCLIENT_QOS2
-    if (!cleansession)
+    if (!cleansession && qos != QOS0)
     {
-        memcpy(pubbuf, sendbuf, len);
+        if (!storeInflight(len))
+            goto exit;
         inflightMsgid = id;
-        inflightLen = len;
         inflightQoS = qos;
 #if MQTTCLIENT_QOS2
         pubrel = false;
@@ -0,0 +1,365 @@
+/*******************************************************************************
+ * Copyright (c) 2026 agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - offline publish spool
+ *******************************************************************************/
+
+#if !defined(MQTT_SPOOL_H)
+#define MQTT_SPOOL_H
+
+#include <string.h>
+
+namespace MQTT
+{
+
+/**
+ * @class SpoolStorage
+ * @brief bytes a Spool keeps its messages in
+ *
+ * Reads and writes are at byte offsets below size().  Implementations are provided for RAM,
+ * for a file on Linux (linux/MQTTSpoolFile.h) and for an Mbed OS BlockDevice (MQTTSpoolBlockDevice.h).
+ */
+class SpoolStorage
+{
+public:
+    virtual ~SpoolStorage()
+    {
+    }
+
+    /** @return the number of bytes available */
+    virtual unsigned int size() = 0;
+
+    /** @return 0 on success */
+    virtual int read(unsigned int addr, void* buffer, unsigned int len) = 0;
+
+    /** @return 0 on success */
+    virtual int write(unsigned int addr, const void* buffer, unsigned int len) = 0;
+};
+
+
+template<int SIZE>
+class SpoolRAMStorage : public SpoolStorage
+{
+public:
+    unsigned int size()
+    {
+        return SIZE;
+    }
+
+    int read(unsigned int addr, void* buffer, unsigned int len)
+    {
+        memcpy(buffer, &data[addr], len);
+        return 0;
+    }
+
+    int write(unsigned int addr, const void* buffer, unsigned int len)
+    {
+        memcpy(&data[addr], buffer, len);
+        return 0;
+    }
+
+private:
+    unsigned char data[SIZE];
+};
+
+
+/**
+ * @class SpoolRing
+ * @brief first in, first out records of up to 65535 bytes in a byte ring on a SpoolStorage
+ *
+ * A persistent ring keeps its positions in a header at the start of the storage, written after
+ * every push and pop, so that the records survive a restart.  Positions are kept below the capacity,
+ * so any storage size works.
+ */
+class SpoolRing
+{
+public:
+    SpoolRing() : storage(0), persistent(false), capacity(0), head(0), bytes(0), records(0)
+    {
+    }
+
+    void init(SpoolStorage* storage, bool persistent)
+    {
+        this->storage = storage;
+        this->persistent = persistent;
+        capacity = 0;
+        head = bytes = records = 0;
+        if (storage == 0 || storage->size() <= (persistent ? HEADER_SIZE : 0))
+            return;
+        capacity = storage->size() - (persistent ? HEADER_SIZE : 0);
+        if (persistent)
+        {
+            unsigned int header[4];
+            if (storage->read(0, header, sizeof(header)) == 0 && header[0] == MAGIC &&
+                    header[1] < capacity && header[2] <= capacity)
+            {
+                head = header[1];
+                bytes = header[2];
+                records = header[3];
+            }
+            else
+                save();
+        }
+    }
+
+    bool empty()
+    {
+        return records == 0;
+    }
+
+    unsigned int count()
+    {
+        return records;
+    }
+
+    unsigned int used()
+    {
+        return bytes;
+    }
+
+    bool fits(int len)
+    {
+        return capacity > 0 && (unsigned int)(RECORD_HEADER + len) <= capacity - used();
+    }
+
+    bool push(const unsigned char* data, int len)
+    {
+        if (!fits(len) || !pushLength(len) || copyIn(tail(), RECORD_HEADER, data, len) != 0)
+            return false;
+        return commitPush(len);
+    }
+
+    /** overwrite len bytes of the oldest record from offset on, keeping its length */
+    bool update(int offset, const unsigned char* data, int len)
+    {
+        int recordlen = peekLength();
+        if (recordlen <= 0 || offset < 0 || offset + len > recordlen)
+            return false;
+        return copyIn(head, RECORD_HEADER + offset, data, len) == 0;
+    }
+
+    /** @return the length of the oldest record copied into buffer, 0 if there is none, -1 if it does not fit */
+    int peek(unsigned char* buffer, int buflen)
+    {
+        int len = peekLength();
+        if (len <= 0)
+            return len;
+        if (len > buflen || copyOut(head, RECORD_HEADER, buffer, len) != 0)
+            return -1;
+        return len;
+    }
+
+    void pop()
+    {
+        int len = peekLength();
+        if (len < 0)
+            head = bytes = records = 0; // unreadable, drop everything rather than replay garbage
+        else if (len > 0)
+        {
+            head = advance(head, RECORD_HEADER + len);
+            bytes -= RECORD_HEADER + len;
+            records--;
+        }
+        save();
+    }
+
+    /** move the oldest record to the end of another ring, in chunks */
+    bool moveOldestTo(SpoolRing& to)
+    {
+        unsigned char chunk[32];
+        int len = peekLength();
+
+        if (len <= 0 || !to.fits(len) || !to.pushLength(len))
+            return false;
+        for (int done = 0; done < len; done += sizeof(chunk))
+        {
+            int n = (len - done < (int)sizeof(chunk)) ? len - done : (int)sizeof(chunk);
+            if (copyOut(head, RECORD_HEADER + done, chunk, n) != 0 ||
+                    to.copyIn(to.tail(), RECORD_HEADER + done, chunk, n) != 0)
+                return false;
+        }
+        if (!to.commitPush(len))
+            return false;
+        pop();
+        return true;
+    }
+
+private:
+    static const unsigned int MAGIC = 0x4d515350; // "MQSP"
+    static const unsigned int HEADER_SIZE = 16;
+    static const int RECORD_HEADER = 2;
+
+    bool pushLength(int len)
+    {
+        unsigned char prefix[RECORD_HEADER] = {(unsigned char)(len >> 8), (unsigned char)len};
+        return copyIn(tail(), 0, prefix, RECORD_HEADER) == 0;
+    }
+
+    bool commitPush(int len)
+    {
+        bytes += RECORD_HEADER + len;
+        records++;
+        return save() == 0;
+    }
+
+    int peekLength()
+    {
+        unsigned char prefix[RECORD_HEADER];
+        if (records == 0)
+            return 0;
+        if (copyOut(head, 0, prefix, RECORD_HEADER) != 0)
+            return -1;
+        return (prefix[0] << 8) + prefix[1];
+    }
+
+    // the position count bytes after pos, which is below the capacity, without overflowing
+    unsigned int advance(unsigned int pos, unsigned int count)
+    {
+        count %= capacity;
+        return (pos >= capacity - count) ? pos - (capacity - count) : pos + count;
+    }
+
+    unsigned int tail()
+    {
+        return advance(head, bytes);
+    }
+
+    int copyIn(unsigned int pos, unsigned int skip, const unsigned char* data, int len)
+    {
+        unsigned int offset = advance(pos, skip);
+        unsigned int first = (len < (int)(capacity - offset)) ? len : capacity - offset;
+        int rc = storage->write(base() + offset, data, first);
+        if (rc == 0 && first < (unsigned int)len)
+            rc = storage->write(base(), data + first, len - first);
+        return rc;
+    }
+
+    int copyOut(unsigned int pos, unsigned int skip, unsigned char* data, int len)
+    {
+        unsigned int offset = advance(pos, skip);
+        unsigned int first = (len < (int)(capacity - offset)) ? len : capacity - offset;
+        int rc = storage->read(base() + offset, data, first);
+        if (rc == 0 && first < (unsigned int)len)
+            rc = storage->read(base(), data + first, len - first);
+        return rc;
+    }
+
+    unsigned int base()
+    {
+        return persistent ? HEADER_SIZE : 0;
+    }
+
+    int save()
+    {
+        if (!persistent)
+            return 0;
+        unsigned int header[4] = {MAGIC, head, bytes, records};
+        return storage->write(0, header, sizeof(header));
+    }
+
+    SpoolStorage* storage;
+    bool persistent;
+    unsigned int capacity;
+    unsigned int head;  // byte position of the oldest record, below capacity
+    unsigned int bytes; // bytes used from head on, wrapping at capacity
+    unsigned int records;
+};
+
+
+/**
+ * @class Spool
+ * @brief bounded outbound message spool for Client, a RAM ring in front of optional persistent storage
+ *
+ * New messages go to the RAM ring.  When it is full its oldest messages move to the backing storage,
+ * so the backing storage only ever holds messages older than those in RAM and the oldest message is
+ * always the first one replayed.  When both are full, new messages are refused.
+ */
+class Spool
+{
+public:
+    /** Construct the spool
+     *  @param ram - storage for the RAM ring
+     *  @param backing - persistent storage that RAM overflows into, or 0.  Its messages are kept across restarts
+     */
+    Spool(SpoolStorage& ram, SpoolStorage* backing = 0)
+    {
+        this->ram.init(&ram, false);
+        this->backing.init(backing, true);
+    }
+
+    /** Add a message at the end
+     *  @return false if there is no room for it
+     */
+    bool push(const unsigned char* data, int len)
+    {
+        if (len <= 0 || len > 0xFFFF)
+            return false;
+        while (!ram.fits(len))
+        {
+            if (ram.empty())
+                return backing.push(data, len); // larger than the RAM ring, it is the newest message either way
+            if (!ram.moveOldestTo(backing))
+                return false;
+        }
+        return ram.push(data, len);
+    }
+
+    /** Copy the oldest message
+     *  @return its length, 0 if the spool is empty, -1 if it does not fit into buffer
+     */
+    int peek(unsigned char* buffer, int buflen)
+    {
+        return backing.empty() ? ram.peek(buffer, buflen) : backing.peek(buffer, buflen);
+    }
+
+    /** Overwrite part of the oldest message, for instance to keep the packet id it was sent with
+     *  @return false if the range is not within the message or it could not be written
+     */
+    bool update(int offset, const unsigned char* data, int len)
+    {
+        return backing.empty() ? ram.update(offset, data, len) : backing.update(offset, data, len);
+    }
+
+    /** Remove the oldest message */
+    void pop()
+    {
+        if (backing.empty())
+            ram.pop();
+        else
+            backing.pop();
+    }
+
+    bool empty()
+    {
+        return ram.empty() && backing.empty();
+    }
+
+    /** @return the number of messages spooled */
+    unsigned int count()
+    {
+        return ram.count() + backing.count();
+    }
+
+    /** @return the bytes used in the RAM ring */
+    unsigned int ramUsed()
+    {
+        return ram.used();
+    }
+
+private:
+    SpoolRing ram, backing;
+};
+
+}
+
+#endif
@@ -0,0 +1,69 @@
+/*******************************************************************************
+ * Copyright (c) 2026 agent
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    agent - file storage for the offline publish spool
+ *******************************************************************************/
+
+#if !defined(MQTT_SPOOL_FILE_H)
+#define MQTT_SPOOL_FILE_H
+
+#include <stdio.h>
+#include "MQTTSpool.h"
+
+/**
+ * Spool backing storage in a file of a fixed size, which keeps spooled messages across restarts.
+ * Each write is flushed to the operating system.
+ */
+class SpoolFileStorage : public MQTT::SpoolStorage
+{
+public:
+    SpoolFileStorage(const char* path, unsigned int size) : region(size)
+    {
+        if ((file = fopen(path, "r+b")) == NULL)
+            file = fopen(path, "w+b");
+    }
+
+    ~SpoolFileStorage()
+    {
+        if (file)
+            fclose(file);
+    }
+
+    unsigned int size()
+    {
+        return file ? region : 0;
+    }
+
+    int read(unsigned int addr, void* buffer, unsigned int len)
+    {
+        if (fseek(file, addr, SEEK_SET) != 0)
+            return -1;
+        size_t got = fread(buffer, 1, len, file);
+        if (got < len) // beyond the end of a new file
+            memset((char*)buffer + got, 0, len - got);
+        return 0;
+    }
+
+    int write(unsigned int addr, const void* buffer, unsigned int len)
+    {
+        if (fseek(file, addr, SEEK_SET) != 0 || fwrite(buffer, 1, len, file) != len)
+            return -1;
+        return fflush(file) == 0 ? 0 : -1;
+    }
+
+private:
+    FILE* file;
+    unsigned int region;
+};
+
+#endif
@@ -120,12 +120,12 @@ int MQTTDeserialize_suback(unsigned short* packetid, int maxcount, int* count, i
 	*count = 0;
 	while (curdata < enddata)
 	{
-		if (*count > maxcount)
+		if (*count >= maxcount)
 		{
 			rc = -1;
 			goto exit;
 		}
-		grantedQoSs[(*count)++] = readChar(&curdata);
+		grantedQoSs[(*count)++] = (unsigned char)readChar(&curdata);
 	}
 
 	rc = 1;
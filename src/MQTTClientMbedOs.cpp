@@ -16,11 +16,13 @@
  */
 
 #include "MQTTClientMbedOs.h"
-#include "MQTTNetworkUtil.h"
 
 int MQTTNetworkMbedOs::read(unsigned char *buffer, int len, int timeout)
 {
-    return accumulate_mqtt_read(socket, buffer, len, timeout);
+    if (datagram) {
+        return datagram_mqtt_read(socket, buffer, len, timeout);
+    }
+    return buffered_mqtt_read<Countdown>(socket, rx, buffer, len, timeout);
 }
 
 int MQTTNetworkMbedOs::write(unsigned char *buffer, int len, int timeout)
@@ -31,6 +33,7 @@ int MQTTNetworkMbedOs::write(unsigned char *buffer, int len, int timeout)
 int MQTTNetworkMbedOs::connect(const char *hostname, int port)
 {
     SocketAddress sockAddr(hostname, port);
+    rx.reset();
     return socket->connect(sockAddr);
 }
 
@@ -39,35 +42,45 @@ int MQTTNetworkMbedOs::disconnect()
     return socket->close();
 }
 
-MQTTClient::MQTTClient(TCPSocket *_socket)
+template<class ClientType>
+ClientType *MQTTClient::create_client()
+{
+#if MQTTCLIENT_SHARED_BUFFERS
+    return new ClientType(*mqttNet, buffers->sendbuf, buffers->readbuf);
+#else
+    return new ClientType(*mqttNet);
+#endif
+}
+
+MQTTClient::MQTTClient(TCPSocket *_socket, MQTTClientBuffers *buffers)
 {
-    init(_socket);
+    init(_socket, buffers);
     mqttNet = new MQTTNetworkMbedOs(socket);
-    client = new MQTT::Client<MQTTNetworkMbedOs, Countdown, MBED_CONF_MBED_MQTT_MAX_PACKET_SIZE, MBED_CONF_MBED_MQTT_MAX_CONNECTIONS>(*mqttNet);
+    client = create_client<MQTT::Client<MQTTNetworkMbedOs, Countdown, MBED_CONF_MBED_MQTT_MAX_PACKET_SIZE, MBED_CONF_MBED_MQTT_MAX_CONNECTIONS> >();
 };
 
 #if defined(MBEDTLS_SSL_CLI_C) || defined(DOXYGEN_ONLY)
-MQTTClient::MQTTClient(TLSSocket *_socket)
+MQTTClient::MQTTClient(TLSSocket *_socket, MQTTClientBuffers *buffers)
 {
-    init(_socket);
+    init(_socket, buffers);
     mqttNet = new MQTTNetworkMbedOs(socket);
-    client = new MQTT::Client<MQTTNetworkMbedOs, Countdown, MBED_CONF_MBED_MQTT_MAX_PACKET_SIZE, MBED_CONF_MBED_MQTT_MAX_CONNECTIONS>(*mqttNet);
+    client = create_client<MQTT::Client<MQTTNetworkMbedOs, Countdown, MBED_CONF_MBED_MQTT_MAX_PACKET_SIZE, MBED_CONF_MBED_MQTT_MAX_CONNECTIONS> >();
 };
 #endif
 
-MQTTClient::MQTTClient(UDPSocket *_socket)
+MQTTClient::MQTTClient(UDPSocket *_socket, MQTTClientBuffers *buffers)
 {
-    init(_socket);
-    mqttNet = new MQTTNetworkMbedOs(socket);
-    clientSN = new MQTTSN::Client<MQTTNetworkMbedOs, Countdown, MBED_CONF_MBED_MQTT_MAX_PACKET_SIZE, MBED_CONF_MBED_MQTT_MAX_CONNECTIONS>(*mqttNet);
+    init(_socket, buffers);
+    mqttNet = new MQTTNetworkMbedOs(socket, true);
+    clientSN = create_client<MQTTSN::Client<MQTTNetworkMbedOs, Countdown, MBED_CONF_MBED_MQTT_MAX_PACKET_SIZE, MBED_CONF_MBED_MQTT_MAX_CONNECTIONS> >();
 };
 
 #if defined(MBEDTLS_SSL_CLI_C) || defined(DOXYGEN_ONLY)
-MQTTClient::MQTTClient(DTLSSocket *_socket)
+MQTTClient::MQTTClient(DTLSSocket *_socket, MQTTClientBuffers *buffers)
 {
-    init(_socket);
-    mqttNet = new MQTTNetworkMbedOs(socket);
-    clientSN = new MQTTSN::Client<MQTTNetworkMbedOs, Countdown, MBED_CONF_MBED_MQTT_MAX_PACKET_SIZE, MBED_CONF_MBED_MQTT_MAX_CONNECTIONS>(*mqttNet);
+    init(_socket, buffers);
+    mqttNet = new MQTTNetworkMbedOs(socket, true);
+    clientSN = create_client<MQTTSN::Client<MQTTNetworkMbedOs, Countdown, MBED_CONF_MBED_MQTT_MAX_PACKET_SIZE, MBED_CONF_MBED_MQTT_MAX_CONNECTIONS> >();
 };
 #endif
 
@@ -76,6 +89,7 @@ MQTTClient::~MQTTClient()
     delete mqttNet;
     if (client != NULL) delete client;
     if (clientSN != NULL) delete clientSN;
+    if (ownBuffers) delete buffers;
 }
 
 nsapi_error_t MQTTClient::connect(MQTTPacket_connectData &options)
@@ -102,6 +116,12 @@ nsapi_error_t MQTTClient::publish(const char *topicName, MQTT::Message &message)
         return NSAPI_ERROR_NO_CONNECTION;
     }
     nsapi_error_t ret = client->publish(topicName, message);
+    if (ret == MQTT::BUFFER_OVERFLOW) {
+        return NSAPI_ERROR_NO_MEMORY;
+    }
+    if (ret == MQTT::SPOOLED) {
+        return NSAPI_ERROR_OK;
+    }
     return ret < 0 ? NSAPI_ERROR_NO_CONNECTION : ret;
 }
 
@@ -132,6 +152,18 @@ nsapi_error_t MQTTClient::subscribe(MQTTSN_topicid &topicFilter, enum MQTTSN::Qo
     return ret < 0 ? NSAPI_ERROR_NO_CONNECTION : ret;
 }
 
+nsapi_error_t MQTTClient::subscribe(int count, const char *topicFilters[], enum MQTT::QoS qos[], messageHandler mh[], int grantedQoSs[])
+{
+    if (client == NULL) {
+        return NSAPI_ERROR_NO_CONNECTION;
+    }
+    nsapi_error_t ret = client->subscribe(count, topicFilters, qos, mh, grantedQoSs);
+    if (ret == MQTT::BUFFER_OVERFLOW) {
+        return NSAPI_ERROR_NO_MEMORY;
+    }
+    return ret < 0 ? NSAPI_ERROR_NO_CONNECTION : ret;
+}
+
 nsapi_error_t MQTTClient::unsubscribe(const char *topicFilter)
 {
     if (client == NULL) {
@@ -150,6 +182,15 @@ nsapi_error_t MQTTClient::unsubscribe(MQTTSN_topicid &topicFilter)
     return ret < 0 ? NSAPI_ERROR_NO_CONNECTION : ret;
 }
 
+nsapi_error_t MQTTClient::unsubscribe(int count, const char *topicFilters[])
+{
+    if (client == NULL) {
+        return NSAPI_ERROR_NO_CONNECTION;
+    }
+    nsapi_error_t ret = client->unsubscribe(count, topicFilters);
+    return ret < 0 ? NSAPI_ERROR_NO_CONNECTION : ret;
+}
+
 nsapi_error_t MQTTClient::yield(unsigned long timeout_ms)
 {
     nsapi_error_t ret = NSAPI_ERROR_OK;
@@ -208,9 +249,30 @@ nsapi_error_t MQTTClient::setMessageHandler(const char *topicFilter, messageHand
     }
 }
 
-void MQTTClient::init(Socket *sock)
+#if MQTTCLIENT_SPOOL
+nsapi_error_t MQTTClient::setSpool(MQTT::Spool *spool)
+{
+    if (clientSN != NULL) {
+        return NSAPI_ERROR_UNSUPPORTED;
+    } else if (client == NULL) {
+        return NSAPI_ERROR_NO_CONNECTION;
+    }
+    client->setSpool(spool);
+    return NSAPI_ERROR_OK;
+}
+#endif
+
+void MQTTClient::init(Socket *sock, MQTTClientBuffers *buffers)
 {
     socket = sock;
     client = NULL;
     clientSN = NULL;
+    this->buffers = buffers;
+    ownBuffers = false;
+#if MQTTCLIENT_SHARED_BUFFERS
+    if (buffers == NULL) {
+        this->buffers = new MQTTClientBuffers;
+        ownBuffers = true;
+    }
+#endif
 }
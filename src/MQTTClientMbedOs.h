@@ -30,6 +30,7 @@
 #include <MQTTSNPacket.h>
 #include <MQTTSNClient.h>
 #include <MQTTmbed.h> // Countdown
+#include "MQTTNetworkUtil.h"
 
 /**
  * @brief Implementation of the Network class template parameter of MQTTClient.
@@ -43,12 +44,17 @@ public:
      * If UDPSocket or DTLSSocket are provided, the MQTT-SN protocol will be used.
      *
      * @param _socket socket to be used for MQTT communication.
+     * @param _datagram true if the socket is a UDPSocket or DTLSSocket.
      */
-    MQTTNetworkMbedOs(Socket *_socket) : socket(_socket) {}
+    MQTTNetworkMbedOs(Socket *_socket, bool _datagram = false) : socket(_socket), datagram(_datagram) {}
 
     /**
      * @brief Read data from the socket.
      *
+     * Stream sockets are read through a receive buffer, so that one recv
+     * usually serves a whole MQTT packet. The timeout applies to the whole
+     * operation, not to each recv.
+     *
      * @param buffer buffer to store the data
      * @param len expected amount of bytes
      * @param timeout timeout for the operation
@@ -84,6 +90,19 @@ public:
 
 private:
     Socket *socket;
+    bool datagram;
+    MQTTReadBuffer<MBED_CONF_MBED_MQTT_READ_BUFFER_SIZE> rx;
+};
+
+/**
+ * @brief Packet buffers shared by MQTTClient instances.
+ *
+ * Only used when mbed-mqtt.shared-buffers is enabled. MQTT and MQTT-SN clients
+ * can share one instance as long as they are never used concurrently.
+ */
+struct MQTTClientBuffers {
+    unsigned char sendbuf[MBED_CONF_MBED_MQTT_MAX_PACKET_SIZE];
+    unsigned char readbuf[MBED_CONF_MBED_MQTT_MAX_PACKET_SIZE];
 };
 
 /**
@@ -105,32 +124,40 @@ public:
      * MQTT protocol will be used.
      *
      * @param _socket socket to be used for communication
+     * @param buffers buffers to share with other clients if mbed-mqtt.shared-buffers is enabled,
+     * NULL to allocate buffers used by this client only
      */
-    MQTTClient(TCPSocket *_socket);
+    MQTTClient(TCPSocket *_socket, MQTTClientBuffers *buffers = NULL);
 #if defined(MBEDTLS_SSL_CLI_C) || defined(DOXYGEN_ONLY)
     /**
      * @brief Constructor for the TLSSocket-based communication.
      * MQTT protocol will be used over a secure socket.
      *
      * @param _socket socket to be used for communication
+     * @param buffers buffers to share with other clients if mbed-mqtt.shared-buffers is enabled,
+     * NULL to allocate buffers used by this client only
      */
-    MQTTClient(TLSSocket *_socket);
+    MQTTClient(TLSSocket *_socket, MQTTClientBuffers *buffers = NULL);
 #endif
     /**
      * @brief Constructor for the UDPSocket-based communication.
      * MQTT-SN protocol will be used.
      *
      * @param _socket socket to be used for communication
+     * @param buffers buffers to share with other clients if mbed-mqtt.shared-buffers is enabled,
+     * NULL to allocate buffers used by this client only
      */
-    MQTTClient(UDPSocket *_socket);
+    MQTTClient(UDPSocket *_socket, MQTTClientBuffers *buffers = NULL);
 #if defined(MBEDTLS_SSL_CLI_C) || defined(DOXYGEN_ONLY)
     /**
      * @brief Constructor for the DTLSSocket-based communication.
      * MQTT-SN protocol will be used over a secure socket.
      *
      * @param _socket socket to be used for communication
+     * @param buffers buffers to share with other clients if mbed-mqtt.shared-buffers is enabled,
+     * NULL to allocate buffers used by this client only
      */
-    MQTTClient(DTLSSocket *_socket);
+    MQTTClient(DTLSSocket *_socket, MQTTClientBuffers *buffers = NULL);
 #endif
 
     /**
@@ -163,7 +190,8 @@ public:
      * @brief Publish message to a topic.
      * @param topicName string with a topic name
      * @param message message to be published
-     * @retval NSAPI_ERROR_OK on success, error code on failure
+     * @retval NSAPI_ERROR_OK on success, or if the message was spooled while disconnected,
+     *         NSAPI_ERROR_NO_MEMORY if the spool is full, other error code on failure
      */
     nsapi_error_t publish(const char *topicName, MQTT::Message &message);
     /**
@@ -190,6 +218,17 @@ public:
      * @retval NSAPI_ERROR_OK on success, error code on failure
      */
     nsapi_error_t subscribe(MQTTSN_topicid &topicFilter, enum MQTTSN::QoS qos, messageHandlerSN mh);
+    /**
+     * @brief Subscribe to several topics, packing as many topic filters into each packet as fit.
+     * @param count number of topic filters
+     * @param topicFilters strings with topic filters
+     * @param qos levels of qos to be received, one per topic filter
+     * @param mh message handlers to be called upon message reception, one per topic filter, or NULL
+     * @param grantedQoSs returned granted qos levels, one per topic filter, 0x80 if refused by the broker
+     * @retval NSAPI_ERROR_OK on success, NSAPI_ERROR_NO_MEMORY if there are not enough free message handlers,
+     *         other error code on failure
+     */
+    nsapi_error_t subscribe(int count, const char *topicFilters[], enum MQTT::QoS qos[], messageHandler mh[], int grantedQoSs[]);
 
     /**
      * @brief Unsubscribe from a topic.
@@ -203,6 +242,13 @@ public:
      * @retval NSAPI_ERROR_OK on success, error code on failure
      */
     nsapi_error_t unsubscribe(MQTTSN_topicid &topicFilter);
+    /**
+     * @brief Unsubscribe from several topics, packing as many topic filters into each packet as fit.
+     * @param count number of topic filters
+     * @param topicFilters strings with topic filters
+     * @retval NSAPI_ERROR_OK on success, error code on failure
+     */
+    nsapi_error_t unsubscribe(int count, const char *topicFilters[]);
 
     /**
      * @brief Yield current thread execution and handle other events
@@ -234,15 +280,33 @@ public:
      */
     nsapi_error_t setMessageHandler(const char *topicFilter, messageHandler mh);
 
+#if MQTTCLIENT_SPOOL
+    /**
+     * @brief Keep MQTT publishes in a spool until they are acknowledged, so that they survive disconnects.
+     * @param spool spool with RAM storage and, for instance, MQTTSpoolBlockDeviceStorage as backing storage,
+     *        or NULL to publish directly again
+     * @retval NSAPI_ERROR_OK on success, NSAPI_ERROR_UNSUPPORTED for an MQTT-SN client
+     */
+    nsapi_error_t setSpool(MQTT::Spool *spool);
+#endif
+
 private:
     /**
      * @brief Helper function to initialize member variables.
      */
-    void init(Socket *sock);
+    void init(Socket *sock, MQTTClientBuffers *buffers);
+
+    /**
+     * @brief Helper function to create the MQTT or MQTT-SN client.
+     */
+    template<class ClientType>
+    ClientType *create_client();
 
     Socket *socket;
     MQTTNetworkMbedOs *mqttNet;
     NetworkInterface *net;
+    MQTTClientBuffers *buffers;
+    bool ownBuffers;
 
     MQTT::Client<MQTTNetworkMbedOs, Countdown, MBED_CONF_MBED_MQTT_MAX_PACKET_SIZE, MBED_CONF_MBED_MQTT_MAX_CONNECTIONS> *client;
     MQTTSN::Client<MQTTNetworkMbedOs, Countdown, MBED_CONF_MBED_MQTT_MAX_PACKET_SIZE, MBED_CONF_MBED_MQTT_MAX_CONNECTIONS> *clientSN;
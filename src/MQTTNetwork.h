@@ -21,6 +21,7 @@
 #include "NetworkInterface.h"
 #include "TCPSocket.h"
 #include "MQTTNetworkUtil.h"
+#include "MQTTmbed.h" // Countdown
 
 class MQTTNetwork {
 public:
@@ -36,7 +37,7 @@ public:
 
     int read(unsigned char *buffer, int len, int timeout)
     {
-        return accumulate_mqtt_read(socket, buffer, len, timeout);
+        return accumulate_mqtt_read<Countdown>(socket, buffer, len, timeout);
     }
 
     int write(unsigned char *buffer, int len, int timeout)
@@ -21,6 +21,7 @@
 #include "NetworkInterface.h"
 #include "TLSSocket.h"
 #include "MQTTNetworkUtil.h"
+#include "MQTTmbed.h" // Countdown
 
 #if defined(MBEDTLS_SSL_CLI_C) || defined(DOXYGEN_ONLY)
 
@@ -38,7 +39,7 @@ public:
 
     int read(unsigned char *buffer, int len, int timeout)
     {
-        return accumulate_mqtt_read(socket, buffer, len, timeout);
+        return accumulate_mqtt_read<Countdown>(socket, buffer, len, timeout);
     }
 
     int write(unsigned char *buffer, int len, int timeout)
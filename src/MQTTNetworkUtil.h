@@ -18,6 +18,9 @@
 #ifndef _MQTTNETWORK_UTIL_H_
 #define _MQTTNETWORK_UTIL_H_
 
+#include <string.h>
+#include "nsapi_types.h"
+
 /* MQTT doesn't expect nsapi error values so we translate them */
 static int convert_nsapi_error_to_mqtt_error(int nsapi_error)
 {
@@ -31,9 +34,56 @@ static int convert_nsapi_error_to_mqtt_error(int nsapi_error)
     return nsapi_error;
 }
 
+/** Receive buffer kept per connection by buffered_mqtt_read().
+ *
+ * @tparam SIZE Size of the buffer in bytes.
+ */
+template<int SIZE>
+struct MQTTReadBuffer {
+    MQTTReadBuffer() : head(0), tail(0), timeout(-1) {}
+
+    /** Drop any buffered data, for example after the socket was reconnected. */
+    void reset()
+    {
+        head = 0;
+        tail = 0;
+        timeout = -1;
+    }
+
+    unsigned char data[SIZE];
+    int head;    /* first byte not yet handed to MQTT */
+    int tail;    /* one past the last byte received */
+    int timeout; /* timeout currently set on the socket, -1 if unknown */
+};
+
+/** Receives once with the socket timeout set to what is left of the deadline.
+ *
+ * @param socket Socket to read data from.
+ * @param applied_timeout Timeout last set on the socket, updated when it changes.
+ * @param buffer Buffer to store data.
+ * @param len Size of the buffer.
+ * @param timer Deadline of the whole read operation.
+ * @return Result of the socket recv call.
+ */
+template<typename SocketType, typename TimerType>
+static int mqtt_recv_until(SocketType socket, int &applied_timeout, unsigned char *buffer, int len, TimerType &timer)
+{
+    int left = timer.left_ms();
+    if (left < 0) {
+        /* Deadline passed, still poll once so already arrived data is not missed */
+        left = 0;
+    }
+    if (left != applied_timeout) {
+        socket->set_timeout(left);
+        applied_timeout = left;
+    }
+    return socket->recv(buffer, len);
+}
+
 /** Reads data and returns number of bytes read or a translated error that MQTT expects. This will call
  * read on the socket multiple times until all data is retrieved.
  *
+ * @tparam TimerType Timer type like Countdown, used for the deadline of the whole operation.
  * @tparam SocketType Socket type like TCPSocket.
  * @param socket Socket to read data from.
  * @param buffer Buffer to store data.
@@ -41,16 +91,16 @@ static int convert_nsapi_error_to_mqtt_error(int nsapi_error)
  * @param timeout Timeout for the operation.
  * @return Always returns the full length if successful or an error.
  */
-template<typename SocketType>
+template<typename TimerType, typename SocketType>
 static int accumulate_mqtt_read(SocketType socket, unsigned char *buffer, int len, int timeout)
 {
-    /* TODO: Timout should be applied to whole operation not partial recv */
-    socket->set_timeout(timeout);
+    TimerType timer(timeout);
+    int applied_timeout = -1;
 
     /* MQTT Client expects the full packet so we accumulate until we get all bytes */
     int remaining = len;
     while (remaining) {
-        int ret = socket->recv(buffer, remaining);
+        int ret = mqtt_recv_until(socket, applied_timeout, buffer, remaining, timer);
         if (ret > 0) {
             remaining -= ret;
             buffer += ret;
@@ -61,6 +111,91 @@ static int accumulate_mqtt_read(SocketType socket, unsigned char *buffer, int le
     return len;
 }
 
+/** Reads data through a per-connection receive buffer and returns number of bytes read or a
+ * translated error that MQTT expects.
+ *
+ * Every socket read asks for as much data as fits into the receive buffer, so the header byte,
+ * the remaining length and the body of a packet are usually served by a single recv. Requests
+ * that fit into the buffer are only handed out once complete, so data received before a timeout
+ * stays buffered for the next call instead of being lost. A request larger than the buffer is
+ * received in place; if it times out part way, the bytes received so far are returned.
+ *
+ * @tparam TimerType Timer type like Countdown, used for the deadline of the whole operation.
+ * @tparam SocketType Socket type like TCPSocket.
+ * @param socket Socket to read data from.
+ * @param rx Receive buffer of the connection.
+ * @param buffer Buffer to store data.
+ * @param len Length of expected data.
+ * @param timeout Timeout for the operation.
+ * @return The full length if successful, the length received so far if a request larger than
+ *         the buffer timed out part way, or an error.
+ */
+template<typename TimerType, typename SocketType, int SIZE>
+static int buffered_mqtt_read(SocketType socket, MQTTReadBuffer<SIZE> &rx, unsigned char *buffer, int len, int timeout)
+{
+    TimerType timer(timeout);
+    int ret;
+
+    if (len > SIZE) {
+        /* Too big for the buffer: hand out what is buffered and receive the rest in place */
+        int copied = rx.tail - rx.head;
+        memcpy(buffer, rx.data + rx.head, copied);
+        rx.head = rx.tail = 0;
+        while (copied < len) {
+            ret = mqtt_recv_until(socket, rx.timeout, buffer + copied, len - copied, timer);
+            if (ret <= 0) {
+                /* The bytes copied are out of the buffer already, the caller must not lose them */
+                return copied > 0 ? copied : convert_nsapi_error_to_mqtt_error(ret);
+            }
+            copied += ret;
+        }
+        return len;
+    }
+
+    if (SIZE - rx.head < len) {
+        memmove(rx.data, rx.data + rx.head, rx.tail - rx.head);
+        rx.tail -= rx.head;
+        rx.head = 0;
+    }
+    while (rx.tail - rx.head < len) {
+        ret = mqtt_recv_until(socket, rx.timeout, rx.data + rx.tail, SIZE - rx.tail, timer);
+        if (ret <= 0) {
+            return convert_nsapi_error_to_mqtt_error(ret);
+        }
+        rx.tail += ret;
+    }
+    memcpy(buffer, rx.data + rx.head, len);
+    rx.head += len;
+    if (rx.head == rx.tail) {
+        rx.head = rx.tail = 0;
+    }
+    return len;
+}
+
+/** Reads a single datagram and returns number of bytes read or a translated error that MQTT expects.
+ *
+ * MQTT-SN reads a whole packet at once and datagrams cannot be accumulated, so only one
+ * recv is issued.
+ *
+ * @tparam SocketType Socket type like UDPSocket.
+ * @param socket Socket to read data from.
+ * @param buffer Buffer to store data.
+ * @param len Size of the buffer.
+ * @param timeout Timeout for the operation.
+ * @return Length of the datagram if successful or an error.
+ */
+template<typename SocketType>
+static int datagram_mqtt_read(SocketType socket, unsigned char *buffer, int len, int timeout)
+{
+    socket->set_timeout(timeout < 0 ? 0 : timeout);
+    int ret = socket->recv(buffer, len);
+    if (ret > 0) {
+        return ret;
+    } else {
+        return convert_nsapi_error_to_mqtt_error(ret);
+    }
+}
+
 /** Sends data and returns number of bytes sent or a translated error that MQTT expects.
  *
  * @tparam SocketType Socket type like TCPSocket.
@@ -36,7 +36,7 @@ public:
 
     int read(unsigned char *buffer, int len, int timeout)
     {
-        return accumulate_mqtt_read(socket, buffer, len, timeout);
+        return datagram_mqtt_read(socket, buffer, len, timeout);
     }
 
     int write(unsigned char *buffer, int len, int timeout)
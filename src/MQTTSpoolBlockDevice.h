@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2026, agent
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MQTT_SPOOL_BLOCK_DEVICE_H
+#define MQTT_SPOOL_BLOCK_DEVICE_H
+
+#include <string.h>
+#include "BlockDevice.h"
+#include <MQTTSpool.h>
+
+/**
+ * @brief MQTT::Spool backing storage on a region of a BlockDevice.
+ *
+ * The spool writes any number of bytes at any offset.  Writes are padded to the program size with the
+ * bytes already stored, and an erase unit is erased, after reading back what it holds, before any of its
+ * programmed bytes are written again, so flash devices can be used directly.  The region must start and
+ * end on erase unit boundaries.  The spool rewrites its header at the start of the region on every push
+ * and pop, so on flash with large erase units a BufferedBlockDevice in front, synced before power is
+ * removed, saves erase cycles.
+ */
+class MQTTSpoolBlockDeviceStorage : public MQTT::SpoolStorage {
+public:
+    /**
+     * @brief Constructor
+     * @param bd initialized block device
+     * @param offset start of the region used for the spool
+     * @param size size of the region in bytes
+     */
+    MQTTSpoolBlockDeviceStorage(BlockDevice *bd, bd_addr_t offset, unsigned int size) : bd(bd), offset(offset), region(size)
+    {
+        unit = bd->get_erase_size();
+        buffer = new uint8_t[unit];
+    }
+
+    ~MQTTSpoolBlockDeviceStorage()
+    {
+        delete[] buffer;
+    }
+
+    unsigned int size()
+    {
+        return region;
+    }
+
+    int read(unsigned int addr, void *data, unsigned int len)
+    {
+        bd_size_t align = bd->get_read_size();
+        uint8_t *out = static_cast<uint8_t *>(data);
+
+        while (len > 0) {
+            bd_addr_t start = offset + addr;
+            bd_size_t n = chunk(start, len);
+            bd_addr_t first = start - start % align;
+            if (int ret = bd->read(buffer, first, round_up(start + n, align) - first)) {
+                return ret;
+            }
+            memcpy(out, buffer + (start - first), n);
+            out += n;
+            addr += n;
+            len -= n;
+        }
+        return 0;
+    }
+
+    int write(unsigned int addr, const void *data, unsigned int len)
+    {
+        const uint8_t *in = static_cast<const uint8_t *>(data);
+
+        while (len > 0) {
+            bd_addr_t start = offset + addr;
+            bd_size_t n = chunk(start, len);
+            if (int ret = write_in_unit(start, in, n)) {
+                return ret;
+            }
+            in += n;
+            addr += n;
+            len -= n;
+        }
+        return 0;
+    }
+
+private:
+    // the bytes of len from start that are in the erase unit of start
+    bd_size_t chunk(bd_addr_t start, unsigned int len)
+    {
+        bd_size_t left = unit - start % unit;
+        return len < left ? len : left;
+    }
+
+    static bd_addr_t round_up(bd_addr_t addr, bd_size_t align)
+    {
+        return (addr + align - 1) / align * align;
+    }
+
+    int write_in_unit(bd_addr_t start, const uint8_t *in, bd_size_t n)
+    {
+        bd_size_t align = bd->get_program_size();
+        bd_addr_t base = start - start % unit;
+        bd_addr_t first = start - start % align;
+        bd_size_t padded = round_up(start + n, align) - first;
+        int erased = bd->get_erase_value();
+
+        if (int ret = bd->read(buffer, first, padded)) {
+            return ret;
+        }
+        bool blank = true;
+        for (bd_size_t i = 0; erased >= 0 && blank && i < padded; ++i) {
+            blank = buffer[i] == (uint8_t)erased;
+        }
+        if (blank) {
+            // nothing programmed in these program units since the last erase
+            memcpy(buffer + (start - first), in, n);
+            return bd->program(buffer, first, padded);
+        }
+
+        // keep the rest of the erase unit across its erase
+        if (int ret = bd->read(buffer, base, unit)) {
+            return ret;
+        }
+        memcpy(buffer + (start - base), in, n);
+        if (int ret = bd->erase(base, unit)) {
+            return ret;
+        }
+        return bd->program(buffer, base, unit);
+    }
+
+    BlockDevice *bd;
+    bd_addr_t offset;
+    unsigned int region;
+    bd_size_t unit;   // erase size
+    uint8_t *buffer;  // one erase unit
+};
+
+#endif // MQTT_SPOOL_BLOCK_DEVICE_H